@@ -18,6 +18,7 @@
 #include <linux/string.h>
 #include <linux/slab.h>
 #include <linux/if_vlan.h>
+#include <linux/math64.h>
 
 #include <asm/cacheflush.h>
 #include <asm/hwcap.h>
@@ -71,6 +72,8 @@
 			 1 << ARM_R7 | 1 << ARM_R8 | 1 << ARM_R9 | \
 			 1 << ARM_FP)
 #define CALLEE_PUSH_MASK (CALLEE_MASK | 1 << ARM_LR)
+#define CALLER_MASK	(1 << ARM_R0 | 1 << ARM_R1 | 1 << ARM_R2 | \
+			 1 << ARM_R3)
 #define CALLEE_POP_MASK  (CALLEE_MASK | 1 << ARM_PC)
 
 enum {
@@ -219,6 +222,19 @@ static u32 jit_mod32(u32 dividend, u32 divisor)
 	return dividend % divisor;
 }
 
+static u64 jit_udiv64(u64 dividend, u64 divisor)
+{
+	return div64_u64(dividend, divisor);
+}
+
+static u64 jit_mod64(u64 dividend, u64 divisor)
+{
+	u64 rem;
+
+	div64_u64_rem(dividend, divisor, &rem);
+	return rem;
+}
+
 static inline void _emit(int cond, u32 inst, struct jit_ctx *ctx)
 {
 	inst |= (cond << 28);
@@ -514,6 +530,45 @@ static inline void emit_udivmod(u8 rd, u8 rm, u8 rn, struct jit_ctx *ctx, u8 op)
 		emit(ARM_MOV_R(ARM_R0, tmp[1]), ctx);
 }
 
+static inline void emit_udivmod64(const s8 *rd, const s8 *rm, const s8 *rn,
+				  struct jit_ctx *ctx, u8 op)
+{
+	u16 keep = 0;
+	int reg;
+
+	/*
+	 * The helper takes the dividend in r1:r0 and the divisor in r3:r2,
+	 * either of which may currently be holding a BPF register, so save
+	 * all four and marshal the arguments through the stack. Pushing
+	 * single registers lets us pick the order the final pop sees them in.
+	 */
+	emit(ARM_PUSH(CALLER_MASK), ctx);
+	emit(ARM_PUSH(1 << rn[0]), ctx);
+	emit(ARM_PUSH(1 << rn[1]), ctx);
+	emit(ARM_PUSH(1 << rm[0]), ctx);
+	emit(ARM_PUSH(1 << rm[1]), ctx);
+	emit(ARM_POP(CALLER_MASK), ctx);
+
+	/* Call appropriate function */
+	emit_mov_i(ARM_IP, op == BPF_DIV ?
+		   (u32)jit_udiv64 : (u32)jit_mod64, ctx);
+	emit_blx_r(ARM_IP, ctx);
+
+	/* Save return value */
+	if (rd[1] != ARM_R0) {
+		emit(ARM_MOV_R(rd[1], ARM_R0), ctx);
+		emit(ARM_MOV_R(rd[0], ARM_R1), ctx);
+	}
+
+	/* Restore everything the result did not land in */
+	if (rd[1] >= ARM_R0 && rd[1] <= ARM_R3)
+		keep = 1 << rd[0] | 1 << rd[1];
+	for (reg = ARM_R0; reg <= ARM_R3; reg++)
+		if (!(keep & 1 << reg))
+			emit(ARM_LDR_I(reg, ARM_SP, reg * 4), ctx);
+	emit(ARM_ADD_I(ARM_SP, ARM_SP, 16), ctx);
+}
+
 /* Is the translated BPF register on stack? */
 static bool is_stacked(s8 reg)
 {
@@ -1056,6 +1111,56 @@ static inline void emit_str_r(const s8 dst, const s8 src[],
 	}
 }
 
+/*
+ * Emit an LDREX/STREX retry loop for BPF_XADD. Returns -EOPNOTSUPP when the
+ * CPU has no suitable exclusive access, or when the kernel's own atomics
+ * would not interoperate with it (GENERIC_ATOMIC64 takes a spinlock).
+ */
+static int emit_xadd(const s8 dst, const s8 src[], s16 off,
+		     struct jit_ctx *ctx, const u8 sz)
+{
+	const s8 *tmp = bpf2a32[TMP_REG_1];
+	const s8 *tmp2 = bpf2a32[TMP_REG_2];
+	const s8 *rs;
+	s8 rd, rt;
+	int loop;
+
+	if (__LINUX_ARM_ARCH__ < 6)
+		return -EOPNOTSUPP;
+#ifdef CONFIG_GENERIC_ATOMIC64
+	if (sz == BPF_DW)
+		return -EOPNOTSUPP;
+#endif
+
+	/* Exclusive accesses take no offset, compute the address in IP */
+	rd = arm_bpf_get_reg32(dst, ARM_IP, ctx);
+	if (off) {
+		emit_mov_i(ARM_LR, off, ctx);
+		emit(ARM_ADD_R(ARM_IP, rd, ARM_LR), ctx);
+	} else if (rd != ARM_IP) {
+		emit(ARM_MOV_R(ARM_IP, rd), ctx);
+	}
+
+	if (sz == BPF_DW) {
+		rs = arm_bpf_get_reg64(src, tmp2, ctx);
+		loop = ctx->idx;
+		/* tmp[1]:tmp[0] is the even/odd pair LDREXD requires */
+		emit(ARM_LDREXD(tmp[1], ARM_IP), ctx);
+		emit(ARM_ADDS_R(tmp[1], tmp[1], rs[1]), ctx);
+		emit(ARM_ADC_R(tmp[0], tmp[0], rs[0]), ctx);
+		emit(ARM_STREXD(ARM_LR, tmp[1], ARM_IP), ctx);
+	} else {
+		rt = arm_bpf_get_reg32(src[1], tmp2[1], ctx);
+		loop = ctx->idx;
+		emit(ARM_LDREX(tmp[1], ARM_IP), ctx);
+		emit(ARM_ADD_R(tmp[1], tmp[1], rt), ctx);
+		emit(ARM_STREX(ARM_LR, tmp[1], ARM_IP), ctx);
+	}
+	emit(ARM_CMP_I(ARM_LR, 0), ctx);
+	_emit(ARM_COND_NE, ARM_B(loop - (ctx->idx + 2)), ctx);
+	return 0;
+}
+
 /* dst = *(size*)(src + off) */
 static inline void emit_ldx_r(const s8 dst[], const s8 src,
 			      s16 off, struct jit_ctx *ctx, const u8 sz){
@@ -1448,7 +1553,16 @@ static int build_insn(const struct bpf_insn *insn, struct jit_ctx *ctx)
 	case BPF_ALU64 | BPF_DIV | BPF_X:
 	case BPF_ALU64 | BPF_MOD | BPF_K:
 	case BPF_ALU64 | BPF_MOD | BPF_X:
-		goto notyet;
+		rd = arm_bpf_get_reg64(dst, tmp2, ctx);
+		if (BPF_SRC(code) == BPF_X) {
+			rs = arm_bpf_get_reg64(src, tmp, ctx);
+		} else {
+			rs = tmp;
+			emit_a32_mov_se_i64(is64, rs, imm, ctx);
+		}
+		emit_udivmod64(rd, rd, rs, ctx, BPF_OP(code));
+		arm_bpf_put_reg64(dst, rd, ctx);
+		break;
 	/* dst = dst >> imm */
 	/* dst = dst << imm */
 	case BPF_ALU | BPF_RSH | BPF_K:
@@ -1600,7 +1714,9 @@ static int build_insn(const struct bpf_insn *insn, struct jit_ctx *ctx)
 	case BPF_STX | BPF_XADD | BPF_W:
 	/* STX XADD: lock *(u64 *)(dst + off) += src */
 	case BPF_STX | BPF_XADD | BPF_DW:
-		goto notyet;
+		if (emit_xadd(dst_lo, src, off, ctx, BPF_SIZE(code)))
+			goto notyet;
+		break;
 	/* STX: *(size *)(dst + off) = src */
 	case BPF_STX | BPF_MEM | BPF_W:
 	case BPF_STX | BPF_MEM | BPF_H:
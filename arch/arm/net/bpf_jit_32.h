@@ -90,6 +90,11 @@
 #define ARM_INST_LDM		0x08900000
 #define ARM_INST_LDM_IA		0x08b00000
 
+#define ARM_INST_LDREX		0x01900f9f
+#define ARM_INST_LDREXD		0x01b00f9f
+#define ARM_INST_STREX		0x01800f90
+#define ARM_INST_STREXD		0x01a00f90
+
 #define ARM_INST_LSL_I		0x01a00000
 #define ARM_INST_LSL_R		0x01a00010
 
@@ -204,6 +209,13 @@
 #define ARM_LDM(rn, regs)	(ARM_INST_LDM | (rn) << 16 | (regs))
 #define ARM_LDM_IA(rn, regs)	(ARM_INST_LDM_IA | (rn) << 16 | (regs))
 
+#define ARM_LDREX(rt, rn)	(ARM_INST_LDREX | (rn) << 16 | (rt) << 12)
+#define ARM_LDREXD(rt, rn)	(ARM_INST_LDREXD | (rn) << 16 | (rt) << 12)
+#define ARM_STREX(rd, rt, rn)	(ARM_INST_STREX | (rn) << 16 | (rd) << 12 \
+				 | (rt))
+#define ARM_STREXD(rd, rt, rn)	(ARM_INST_STREXD | (rn) << 16 | (rd) << 12 \
+				 | (rt))
+
 #define ARM_LSL_R(rd, rn, rm)	(_AL3_R(ARM_INST_LSL, rd, 0, rn) | (rm) << 8)
 #define ARM_LSL_I(rd, rn, imm)	(_AL3_I(ARM_INST_LSL, rd, 0, rn) | (imm) << 7)
 
@@ -2650,7 +2650,7 @@ blk_status_t blk_insert_cloned_request(struct request_queue *q, struct request *
 		 * bypass a potential scheduler on the bottom device for
 		 * insert.
 		 */
-		return blk_mq_request_issue_directly(rq);
+		return blk_mq_request_issue_directly(rq, true);
 	}
 
 	spin_lock_irqsave(q->queue_lock, flags);
@@ -14,6 +14,12 @@
  *   scaling step of 0 if reads show up or the heavy writers finish. Unlike
  *   positive scaling steps where we shrink the monitoring window, a negative
  *   scaling step retains the default step==0 window size.
+ * - Devices with a write cache in front of slow flash (SD cards, eMMC) stall
+ *   for hundreds of msecs while they garbage collect, regardless of what we
+ *   queue. A window containing such a stall steps down once when the stall
+ *   starts instead of every window it lasts, and a decaying memory of recent
+ *   stalls holds off scaling up again, so we don't refill the cache only to
+ *   hit the next stall at full depth.
  *
  * Copyright (C) 2016 Jens Axboe
  *
@@ -72,6 +78,32 @@ enum {
 	 * information to scale up or down, scale up.
 	 */
 	RWB_UNKNOWN_BUMP	= 5,
+
+	/*
+	 * A request taking this long, or this long going by without any
+	 * completions while writes are in flight, is a device stall.
+	 */
+	RWB_STALL_NSEC		= 250 * 1000 * 1000ULL,
+
+	/*
+	 * Each stall adds RWB_STALL_BUMP to the stall score, which loses
+	 * 1/8th every RWB_WINDOW_NSEC. Scaling up resumes once it drops
+	 * below RWB_STALL_CALM, about a second after a single stall and
+	 * up to 3 seconds after a burst of them.
+	 */
+	RWB_STALL_BUMP		= 1024,
+	RWB_STALL_MAX		= 8 * RWB_STALL_BUMP,
+	RWB_STALL_CALM		= 256,
+
+	/*
+	 * Completion latency histogram. Bucket 0 holds latencies under 1us,
+	 * bucket n holds [2^(n-1), 2^n) us and the last everything above.
+	 */
+	RWB_LAT_BUCKETS		= 24,
+};
+
+struct wbt_lat_hist {
+	u64 buckets[2][RWB_LAT_BUCKETS];
 };
 
 static inline bool rwb_enabled(struct rq_wb *rwb)
@@ -177,6 +209,24 @@ static void __wbt_done(struct rq_qos *rqos, enum wbt_flags wb_acct)
 	wbt_rqw_done(rwb, rqw, wb_acct);
 }
 
+static void wbt_account_lat(struct rq_wb *rwb, struct request *rq, int dir)
+{
+	u64 now, us;
+
+	/* never issued, e.g. merged into another request */
+	if (!rq->io_start_time_ns)
+		return;
+
+	now = ktime_get_ns();
+	if (now < rq->io_start_time_ns)
+		return;
+
+	us = div_u64(now - rq->io_start_time_ns, NSEC_PER_USEC);
+	this_cpu_inc(rwb->hist->buckets[dir]
+		     [us ? min_t(unsigned int, ilog2(us) + 1,
+				 RWB_LAT_BUCKETS - 1) : 0]);
+}
+
 /*
  * Called on completion of a request. Note that it's also called when
  * a request is merged, when the request gets freed.
@@ -191,10 +241,13 @@ static void wbt_done(struct rq_qos *rqos, struct request *rq)
 			rwb->sync_cookie = NULL;
 		}
 
-		if (wbt_is_read(rq))
+		if (wbt_is_read(rq)) {
 			wb_timestamp(rwb, &rwb->last_comp);
+			wbt_account_lat(rwb, rq, READ);
+		}
 	} else {
 		WARN_ON_ONCE(rq == rwb->sync_cookie);
+		wbt_account_lat(rwb, rq, WRITE);
 		__wbt_done(rqos, wbt_flags(rq));
 	}
 	wbt_clear_state(rq);
@@ -228,8 +281,59 @@ enum {
 	LAT_UNKNOWN,
 	LAT_UNKNOWN_WRITES,
 	LAT_EXCEEDED,
+	LAT_STALLED,
 };
 
+/*
+ * Check whether the device stalled in the last window: a completion or
+ * the oldest pending sync IO took longer than RWB_STALL_NSEC, or nothing
+ * completed for that long with writes in flight.
+ */
+static bool wbt_stalled(struct rq_wb *rwb, struct blk_rq_stat *stat,
+			unsigned int inflight)
+{
+	int i;
+
+	if (inflight && !stat[READ].nr_samples && !stat[WRITE].nr_samples)
+		rwb->no_comp_nsec += rwb->cur_win_nsec;
+	else
+		rwb->no_comp_nsec = 0;
+
+	if (rwb->no_comp_nsec >= RWB_STALL_NSEC ||
+	    rwb_sync_issue_lat(rwb) >= RWB_STALL_NSEC)
+		return true;
+
+	for (i = READ; i <= WRITE; i++) {
+		if (stat[i].nr_samples && stat[i].max >= RWB_STALL_NSEC)
+			return true;
+	}
+
+	return false;
+}
+
+static void wbt_update_stall(struct rq_wb *rwb, bool stalled)
+{
+	u64 now = ktime_get_ns();
+	u64 periods = div64_u64(now - rwb->stall_decay_ns, RWB_WINDOW_NSEC);
+
+	rwb->stall_decay_ns += periods * RWB_WINDOW_NSEC;
+	while (periods-- && rwb->stall_score)
+		rwb->stall_score -= DIV_ROUND_UP(rwb->stall_score, 8);
+
+	if (stalled && !rwb->stalled) {
+		rwb->nr_stalls++;
+		rwb->stall_score = min_t(unsigned int,
+					 rwb->stall_score + RWB_STALL_BUMP,
+					 RWB_STALL_MAX);
+	}
+	rwb->stalled = stalled;
+}
+
+static bool wbt_stall_recent(struct rq_wb *rwb)
+{
+	return rwb->stall_score >= RWB_STALL_CALM;
+}
+
 static int latency_exceeded(struct rq_wb *rwb, struct blk_rq_stat *stat)
 {
 	struct backing_dev_info *bdi = rwb->rqos.q->backing_dev_info;
@@ -353,24 +457,43 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 	struct rq_wb *rwb = cb->data;
 	struct rq_depth *rqd = &rwb->rq_depth;
 	unsigned int inflight = wbt_inflight(rwb);
+	bool stalled, new_stall;
 	int status;
 
-	status = latency_exceeded(rwb, cb->stat);
+	stalled = wbt_stalled(rwb, cb->stat, inflight);
+	new_stall = stalled && !rwb->stalled;
+	wbt_update_stall(rwb, stalled);
+
+	if (stalled)
+		status = LAT_STALLED;
+	else
+		status = latency_exceeded(rwb, cb->stat);
 
 	trace_wbt_timer(rwb->rqos.q->backing_dev_info, status, rqd->scale_step,
 			inflight);
 
 	/*
 	 * If we exceeded the latency target, step down. If we did not,
-	 * step one level up. If we don't know enough to say either exceeded
-	 * or ok, then don't do anything.
+	 * step one level up, unless the device stalled recently. If we
+	 * don't know enough to say either exceeded or ok, then don't do
+	 * anything.
 	 */
 	switch (status) {
+	case LAT_STALLED:
+		/*
+		 * The device is busy with itself, stepping down further
+		 * while the stall lasts only leaves us too far down once
+		 * it recovers.
+		 */
+		if (new_stall)
+			scale_down(rwb, true);
+		break;
 	case LAT_EXCEEDED:
 		scale_down(rwb, true);
 		break;
 	case LAT_OK:
-		scale_up(rwb);
+		if (!wbt_stall_recent(rwb))
+			scale_up(rwb);
 		break;
 	case LAT_UNKNOWN_WRITES:
 		/*
@@ -378,7 +501,8 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 		 * read/write sample, but we do have writes going on.
 		 * Allow step to go negative, to increase write perf.
 		 */
-		scale_up(rwb);
+		if (!wbt_stall_recent(rwb))
+			scale_up(rwb);
 		break;
 	case LAT_UNKNOWN:
 		if (++rwb->unknown_cnt < RWB_UNKNOWN_BUMP)
@@ -388,9 +512,10 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 		 * currently don't have a valid read/write sample. For that
 		 * case, slowly return to center state (step == 0).
 		 */
-		if (rqd->scale_step > 0)
-			scale_up(rwb);
-		else if (rqd->scale_step < 0)
+		if (rqd->scale_step > 0) {
+			if (!wbt_stall_recent(rwb))
+				scale_up(rwb);
+		} else if (rqd->scale_step < 0)
 			scale_down(rwb, false);
 		break;
 	default:
@@ -404,6 +529,60 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 		rwb_arm_timer(rwb);
 }
 
+/* Upper bound in usec of the bucket holding the pct percentile. */
+static u64 wbt_percentile(const u64 *buckets, u64 total, unsigned int pct)
+{
+	u64 want = div_u64(total * pct + 99, 100);
+	u64 seen = 0;
+	int i;
+
+	for (i = 0; i < RWB_LAT_BUCKETS - 1; i++) {
+		seen += buckets[i];
+		if (seen >= want)
+			break;
+	}
+	return 1ULL << i;
+}
+
+ssize_t wbt_stat_show(struct request_queue *q, char *page)
+{
+	static const char * const names[2] = { "read", "write" };
+	struct rq_wb *rwb = RQWB(wbt_rq_qos(q));
+	struct wbt_lat_hist sum = { };
+	ssize_t len = 0;
+	int cpu, i, j;
+
+	for_each_possible_cpu(cpu) {
+		struct wbt_lat_hist *hist = per_cpu_ptr(rwb->hist, cpu);
+
+		for (i = 0; i < 2; i++)
+			for (j = 0; j < RWB_LAT_BUCKETS; j++)
+				sum.buckets[i][j] += hist->buckets[i][j];
+	}
+
+	for (i = 0; i < 2; i++) {
+		const u64 *b = sum.buckets[i];
+		u64 total = 0;
+
+		for (j = 0; j < RWB_LAT_BUCKETS; j++)
+			total += b[j];
+
+		len += sprintf(page + len, "%s_ios %llu\n", names[i], total);
+		if (!total)
+			continue;
+		len += sprintf(page + len,
+			       "%s_p50_usec %llu\n%s_p90_usec %llu\n%s_p99_usec %llu\n",
+			       names[i], wbt_percentile(b, total, 50),
+			       names[i], wbt_percentile(b, total, 90),
+			       names[i], wbt_percentile(b, total, 99));
+	}
+
+	len += sprintf(page + len, "stalls %u\nstall_score %u\nscale_step %d\n",
+		       rwb->nr_stalls, rwb->stall_score,
+		       rwb->rq_depth.scale_step);
+	return len;
+}
+
 static void __wbt_update_limits(struct rq_wb *rwb)
 {
 	struct rq_depth *rqd = &rwb->rq_depth;
@@ -749,6 +928,7 @@ static void wbt_exit(struct rq_qos *rqos)
 
 	blk_stat_remove_callback(q, rwb->cb);
 	blk_stat_free_callback(rwb->cb);
+	free_percpu(rwb->hist);
 	kfree(rwb);
 }
 
@@ -789,8 +969,15 @@ int wbt_init(struct request_queue *q)
 	if (!rwb)
 		return -ENOMEM;
 
+	rwb->hist = alloc_percpu(struct wbt_lat_hist);
+	if (!rwb->hist) {
+		kfree(rwb);
+		return -ENOMEM;
+	}
+
 	rwb->cb = blk_stat_alloc_callback(wb_timer_fn, wbt_data_dir, 2, rwb);
 	if (!rwb->cb) {
+		free_percpu(rwb->hist);
 		kfree(rwb);
 		return -ENOMEM;
 	}
@@ -803,6 +990,7 @@ int wbt_init(struct request_queue *q)
 	rwb->rqos.q = q;
 	rwb->last_comp = rwb->last_issue = jiffies;
 	rwb->win_nsec = RWB_WINDOW_NSEC;
+	rwb->stall_decay_ns = ktime_get_ns();
 	rwb->enable_state = WBT_STATE_ON_DEFAULT;
 	rwb->wc = 1;
 	rwb->rq_depth.default_depth = RWB_DEF_DEPTH;
@@ -64,6 +64,18 @@ struct rq_wb {
 	unsigned long last_issue;		/* last non-throttled issue */
 	unsigned long last_comp;		/* last non-throttled comp */
 	unsigned long min_lat_nsec;
+
+	/*
+	 * Device stall tracking. stall_score is bumped when a stall starts
+	 * and decays over time, scaling up is held off while it's high.
+	 */
+	bool stalled;				/* last window was a stall */
+	unsigned int stall_score;
+	unsigned int nr_stalls;			/* stalls seen in total */
+	u64 stall_decay_ns;			/* last stall_score decay */
+	u64 no_comp_nsec;			/* time without completions */
+
+	struct wbt_lat_hist __percpu *hist;
 	struct rq_qos rqos;
 	struct rq_wait rq_wait[WBT_NUM_RWQ];
 	struct rq_depth rq_depth;
@@ -100,6 +112,8 @@ void wbt_set_write_cache(struct request_queue *, bool);
 
 u64 wbt_default_latency_nsec(struct request_queue *);
 
+ssize_t wbt_stat_show(struct request_queue *q, char *page);
+
 #else
 
 static inline void wbt_track(struct request *rq, enum wbt_flags flags)
@@ -135,6 +149,10 @@ static inline u64 wbt_default_latency_nsec(struct request_queue *q)
 {
 	return 0;
 }
+static inline ssize_t wbt_stat_show(struct request_queue *q, char *page)
+{
+	return -EINVAL;
+}
 
 #endif /* CONFIG_BLK_WBT */
 
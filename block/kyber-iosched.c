@@ -19,6 +19,7 @@
 
 #include <linux/kernel.h>
 #include <linux/blkdev.h>
+#include <linux/blk-cgroup.h>
 #include <linux/blk-mq.h>
 #include <linux/elevator.h>
 #include <linux/module.h>
@@ -143,6 +144,441 @@ enum {
 #define IS_GOOD(status) ((status) > 0)
 #define IS_BAD(status) ((status) < 0)
 
+#ifdef CONFIG_BLK_CGROUP
+/*
+ * Per-cgroup latency targets. Reads and synchronous writes of a cgroup may
+ * be given their own target, tighter than the device-wide one. A cgroup
+ * missing its target makes its scheduling domain count as doing badly, so
+ * the usual depth heuristics throttle the other domains in its favor.
+ *
+ * Bucket 0 of the completion histograms holds latencies under 1us, bucket n
+ * holds [2^(n-1), 2^n) us and the last bucket everything from about 4s up.
+ */
+#define KYBER_GROUP_DOMAINS	KYBER_OTHER	/* reads and sync writes */
+#define KYBER_LAT_BUCKETS	24
+
+static struct blkcg_policy blkcg_policy_kyber;
+
+struct kyber_group_hist {
+	u64 buckets[KYBER_GROUP_DOMAINS][KYBER_LAT_BUCKETS];
+};
+
+struct kyber_group {
+	struct blkg_policy_data pd;
+
+	/* Target latencies in nanoseconds, 0 if none. */
+	u64 target_nsec[KYBER_GROUP_DOMAINS];
+
+	/*
+	 * Completions, and those over target and twice the target, since the
+	 * last run of kyber_stat_timer_fn().
+	 */
+	atomic_t nr[KYBER_GROUP_DOMAINS];
+	atomic_t nr_missed[KYBER_GROUP_DOMAINS];
+	atomic_t nr_awful[KYBER_GROUP_DOMAINS];
+
+	struct kyber_group_hist __percpu *hist;
+};
+
+static struct kyber_group *pd_to_kg(struct blkg_policy_data *pd)
+{
+	return pd ? container_of(pd, struct kyber_group, pd) : NULL;
+}
+
+static struct kyber_group *blkg_to_kg(struct blkcg_gq *blkg)
+{
+	return pd_to_kg(blkg_to_pd(blkg, &blkcg_policy_kyber));
+}
+
+/*
+ * elv.priv is only ours once prepare_request ran. Flush requests bypass it
+ * and reuse that space for rq->flush, so don't read a blkg out of them.
+ */
+static struct blkcg_gq *rq_get_blkg(struct request *rq)
+{
+	if (!(rq->rq_flags & RQF_ELVPRIV))
+		return NULL;
+	return rq->elv.priv[1];
+}
+
+/*
+ * Remember the cgroup of a request until it is freed. The root cgroup can't
+ * have a target, leave it out so that cgroup-less setups don't pay for this.
+ */
+static void kyber_group_attach(struct request *rq, struct bio *bio)
+{
+	struct blkcg_gq *blkg;
+
+	rq->elv.priv[1] = NULL;
+	if (!bio)
+		return;
+
+	rcu_read_lock();
+	blkg = blkg_lookup(bio_blkcg(bio), rq->q);
+	if (blkg && blkg != rq->q->root_blkg && blkg_to_kg(blkg)) {
+		blkg_get(blkg);
+		rq->elv.priv[1] = blkg;
+	}
+	rcu_read_unlock();
+}
+
+static void kyber_group_detach(struct request *rq)
+{
+	struct blkcg_gq *blkg = rq_get_blkg(rq);
+
+	if (blkg) {
+		rq->elv.priv[1] = NULL;
+		blkg_put(blkg);
+	}
+}
+
+/*
+ * Account a completed request to its cgroup. Returns true if it took longer
+ * than the cgroup's target.
+ */
+static bool kyber_group_completed(struct request *rq,
+				  unsigned int sched_domain, u64 latency)
+{
+	struct kyber_group *kg = blkg_to_kg(rq_get_blkg(rq));
+	u64 us = div_u64(latency, NSEC_PER_USEC);
+	u64 target;
+
+	if (!kg)
+		return false;
+
+	this_cpu_inc(kg->hist->buckets[sched_domain]
+		     [us ? min_t(unsigned int, ilog2(us) + 1,
+				 KYBER_LAT_BUCKETS - 1) : 0]);
+
+	target = READ_ONCE(kg->target_nsec[sched_domain]);
+	if (!target)
+		return false;
+
+	atomic_inc(&kg->nr[sched_domain]);
+	if (latency <= target)
+		return false;
+
+	atomic_inc(&kg->nr_missed[sched_domain]);
+	if (latency >= 2 * target)
+		atomic_inc(&kg->nr_awful[sched_domain]);
+	return true;
+}
+
+/*
+ * The status of the worst cgroup. A cgroup is doing badly if more than 10% of
+ * its requests missed the target, i.e. its p90 is over target. As the window
+ * counters keep running while latency monitoring is off, the first window
+ * after a pause may be diluted by older completions.
+ */
+static void kyber_group_status(struct kyber_queue_data *kqd, int *status)
+{
+	struct request_queue *q = kqd->q;
+	struct blkcg_gq *blkg;
+	unsigned long flags;
+	int i;
+
+	for (i = 0; i < KYBER_GROUP_DOMAINS; i++)
+		status[i] = NONE;
+
+	spin_lock_irqsave(q->queue_lock, flags);
+	list_for_each_entry(blkg, &q->blkg_list, q_node) {
+		struct kyber_group *kg = blkg_to_kg(blkg);
+
+		if (!kg)
+			continue;
+
+		for (i = 0; i < KYBER_GROUP_DOMAINS; i++) {
+			unsigned int nr = atomic_xchg(&kg->nr[i], 0);
+			unsigned int missed = atomic_xchg(&kg->nr_missed[i], 0);
+			unsigned int awful = atomic_xchg(&kg->nr_awful[i], 0);
+
+			if (!nr)
+				continue;
+			if (awful * 10 > nr)
+				status[i] = AWFUL;
+			else if (missed * 10 > nr)
+				status[i] = min(status[i], BAD);
+		}
+	}
+	spin_unlock_irqrestore(q->queue_lock, flags);
+}
+
+/* Upper bound in usec of the bucket holding the pct percentile. */
+static u64 kyber_percentile(const u64 *buckets, u64 total,
+			    unsigned int pct)
+{
+	u64 want = div_u64(total * pct + 99, 100);
+	u64 seen = 0;
+	int i;
+
+	for (i = 0; i < KYBER_LAT_BUCKETS - 1; i++) {
+		seen += buckets[i];
+		if (seen >= want)
+			break;
+	}
+	return 1ULL << i;
+}
+
+static size_t kyber_group_format_stat(struct kyber_group *kg, char *buf,
+				      size_t size)
+{
+	static const char * const names[KYBER_GROUP_DOMAINS] = {
+		[KYBER_READ] = "read",
+		[KYBER_SYNC_WRITE] = "write",
+	};
+	struct kyber_group_hist sum = { };
+	size_t len = 0;
+	int cpu, i, j;
+
+	for_each_possible_cpu(cpu) {
+		struct kyber_group_hist *hist = per_cpu_ptr(kg->hist, cpu);
+
+		for (i = 0; i < KYBER_GROUP_DOMAINS; i++)
+			for (j = 0; j < KYBER_LAT_BUCKETS; j++)
+				sum.buckets[i][j] += hist->buckets[i][j];
+	}
+
+	for (i = 0; i < KYBER_GROUP_DOMAINS; i++) {
+		const u64 *b = sum.buckets[i];
+		u64 total = 0;
+
+		for (j = 0; j < KYBER_LAT_BUCKETS; j++)
+			total += b[j];
+		if (!total)
+			continue;
+
+		len += scnprintf(buf + len, size - len,
+				 " kyber.%s_p50=%llu kyber.%s_p90=%llu kyber.%s_p99=%llu",
+				 names[i], kyber_percentile(b, total, 50),
+				 names[i], kyber_percentile(b, total, 90),
+				 names[i], kyber_percentile(b, total, 99));
+	}
+
+	return len;
+}
+
+/* achieved latency percentiles in usec, appended to io.stat */
+static size_t kyber_pd_stat(struct blkg_policy_data *pd, char *buf,
+			    size_t size)
+{
+	return kyber_group_format_stat(pd_to_kg(pd), buf, size);
+}
+
+static struct blkg_policy_data *kyber_pd_alloc(gfp_t gfp, int node)
+{
+	struct kyber_group *kg;
+
+	kg = kzalloc_node(sizeof(*kg), gfp, node);
+	if (!kg)
+		return NULL;
+
+	kg->hist = alloc_percpu_gfp(struct kyber_group_hist, gfp);
+	if (!kg->hist) {
+		kfree(kg);
+		return NULL;
+	}
+
+	return &kg->pd;
+}
+
+static void kyber_pd_free(struct blkg_policy_data *pd)
+{
+	struct kyber_group *kg = pd_to_kg(pd);
+
+	free_percpu(kg->hist);
+	kfree(kg);
+}
+
+static u64 kyber_prfill_latency(struct seq_file *sf,
+				struct blkg_policy_data *pd, int off)
+{
+	struct kyber_group *kg = pd_to_kg(pd);
+	const char *dname = blkg_dev_name(pd->blkg);
+	int i;
+
+	if (!dname || (!kg->target_nsec[KYBER_READ] &&
+		       !kg->target_nsec[KYBER_SYNC_WRITE]))
+		return 0;
+
+	seq_printf(sf, "%s", dname);
+	for (i = 0; i < KYBER_GROUP_DOMAINS; i++) {
+		seq_printf(sf, " %s=", i == KYBER_READ ? "read" : "write");
+		if (kg->target_nsec[i])
+			seq_printf(sf, "%llu",
+				   div_u64(kg->target_nsec[i], NSEC_PER_USEC));
+		else
+			seq_puts(sf, "max");
+	}
+	seq_putc(sf, '\n');
+	return 0;
+}
+
+static int kyber_print_latency(struct seq_file *sf, void *v)
+{
+	blkcg_print_blkgs(sf, css_to_blkcg(seq_css(sf)), kyber_prfill_latency,
+			  &blkcg_policy_kyber, seq_cft(sf)->private, false);
+	return 0;
+}
+
+/* "MAJ:MIN read=USEC write=USEC", "max" or 0 removes a target */
+static ssize_t kyber_set_latency(struct kernfs_open_file *of, char *buf,
+				 size_t nbytes, loff_t off)
+{
+	struct blkcg *blkcg = css_to_blkcg(of_css(of));
+	struct blkg_conf_ctx ctx;
+	struct kyber_group *kg;
+	u64 target[KYBER_GROUP_DOMAINS];
+	char *p, *tok;
+	int ret, i;
+
+	ret = blkg_conf_prep(blkcg, &blkcg_policy_kyber, buf, &ctx);
+	if (ret)
+		return ret;
+
+	kg = blkg_to_kg(ctx.blkg);
+	for (i = 0; i < KYBER_GROUP_DOMAINS; i++)
+		target[i] = kg->target_nsec[i];
+
+	ret = -EINVAL;
+	p = ctx.body;
+	while ((tok = strsep(&p, " "))) {
+		char key[16];
+		char val[21];	/* 18446744073709551616 */
+		u64 v;
+
+		if (!*tok)
+			continue;
+		if (sscanf(tok, "%15[^=]=%20s", key, val) != 2)
+			goto out;
+
+		if (!strcmp(key, "read"))
+			i = KYBER_READ;
+		else if (!strcmp(key, "write"))
+			i = KYBER_SYNC_WRITE;
+		else
+			goto out;
+
+		if (!strcmp(val, "max"))
+			v = 0;
+		else if (kstrtou64(val, 10, &v) || v > U64_MAX / NSEC_PER_USEC)
+			goto out;
+		target[i] = v * NSEC_PER_USEC;
+	}
+
+	for (i = 0; i < KYBER_GROUP_DOMAINS; i++)
+		WRITE_ONCE(kg->target_nsec[i], target[i]);
+	ret = 0;
+out:
+	blkg_conf_finish(&ctx);
+	return ret ?: nbytes;
+}
+
+static u64 kyber_prfill_latency_stat(struct seq_file *sf,
+				     struct blkg_policy_data *pd, int off)
+{
+	const char *dname = blkg_dev_name(pd->blkg);
+	char buf[256];
+
+	if (!dname || !kyber_group_format_stat(pd_to_kg(pd), buf, sizeof(buf)))
+		return 0;
+
+	seq_printf(sf, "%s%s\n", dname, buf);
+	return 0;
+}
+
+static int kyber_print_latency_stat(struct seq_file *sf, void *v)
+{
+	blkcg_print_blkgs(sf, css_to_blkcg(seq_css(sf)),
+			  kyber_prfill_latency_stat, &blkcg_policy_kyber,
+			  seq_cft(sf)->private, false);
+	return 0;
+}
+
+static struct cftype kyber_dfl_files[] = {
+	{
+		.name = "kyber.latency",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = kyber_print_latency,
+		.write = kyber_set_latency,
+	},
+	{}
+};
+
+/* cgroup v1 has no io.stat, give it the percentiles in a file of their own */
+static struct cftype kyber_legacy_files[] = {
+	{
+		.name = "kyber.latency",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = kyber_print_latency,
+		.write = kyber_set_latency,
+	},
+	{
+		.name = "kyber.latency_stat",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = kyber_print_latency_stat,
+	},
+	{}
+};
+
+static struct blkcg_policy blkcg_policy_kyber = {
+	.dfl_cftypes	= kyber_dfl_files,
+	.legacy_cftypes	= kyber_legacy_files,
+	.pd_alloc_fn	= kyber_pd_alloc,
+	.pd_free_fn	= kyber_pd_free,
+	.pd_stat_fn	= kyber_pd_stat,
+};
+
+static int kyber_group_activate(struct request_queue *q)
+{
+	return blkcg_activate_policy(q, &blkcg_policy_kyber);
+}
+
+static void kyber_group_deactivate(struct request_queue *q)
+{
+	blkcg_deactivate_policy(q, &blkcg_policy_kyber);
+}
+
+static int kyber_group_register(void)
+{
+	return blkcg_policy_register(&blkcg_policy_kyber);
+}
+
+static void kyber_group_unregister(void)
+{
+	blkcg_policy_unregister(&blkcg_policy_kyber);
+}
+#else
+static inline struct blkcg_gq *rq_get_blkg(struct request *rq)
+{
+	return NULL;
+}
+static inline void kyber_group_attach(struct request *rq, struct bio *bio) { }
+static inline void kyber_group_detach(struct request *rq) { }
+static inline bool kyber_group_completed(struct request *rq,
+					 unsigned int sched_domain,
+					 u64 latency)
+{
+	return false;
+}
+static inline void kyber_group_status(struct kyber_queue_data *kqd,
+				      int *status)
+{
+	status[KYBER_READ] = status[KYBER_SYNC_WRITE] = NONE;
+}
+static inline int kyber_group_activate(struct request_queue *q) { return 0; }
+static inline void kyber_group_deactivate(struct request_queue *q) { }
+static inline int kyber_group_register(void) { return 0; }
+static inline void kyber_group_unregister(void) { }
+#endif
+
+/* A cgroup missing its target can only make a domain's status worse. */
+static int kyber_worst_status(int status, int group_status)
+{
+	if (!IS_BAD(group_status))
+		return status;
+	return status == NONE ? group_status : min(status, group_status);
+}
+
 static int kyber_lat_status(struct blk_stat_callback *cb,
 			    unsigned int sched_domain, u64 target)
 {
@@ -269,10 +705,16 @@ static void kyber_stat_timer_fn(struct blk_stat_callback *cb)
 {
 	struct kyber_queue_data *kqd = cb->data;
 	int read_status, write_status;
+	int group_status[KYBER_OTHER];
 
 	read_status = kyber_lat_status(cb, KYBER_READ, kqd->read_lat_nsec);
 	write_status = kyber_lat_status(cb, KYBER_SYNC_WRITE, kqd->write_lat_nsec);
 
+	kyber_group_status(kqd, group_status);
+	read_status = kyber_worst_status(read_status, group_status[KYBER_READ]);
+	write_status = kyber_worst_status(write_status,
+					  group_status[KYBER_SYNC_WRITE]);
+
 	kyber_adjust_rw_depth(kqd, KYBER_READ, read_status, write_status);
 	kyber_adjust_rw_depth(kqd, KYBER_SYNC_WRITE, write_status, read_status);
 	kyber_adjust_other_depth(kqd, read_status, write_status,
@@ -357,10 +799,21 @@ static struct kyber_queue_data *kyber_queue_data_alloc(struct request_queue *q)
 	return ERR_PTR(ret);
 }
 
+static void kyber_queue_data_free(struct kyber_queue_data *kqd)
+{
+	int i;
+
+	for (i = 0; i < KYBER_NUM_DOMAINS; i++)
+		sbitmap_queue_free(&kqd->domain_tokens[i]);
+	blk_stat_free_callback(kqd->cb);
+	kfree(kqd);
+}
+
 static int kyber_init_sched(struct request_queue *q, struct elevator_type *e)
 {
 	struct kyber_queue_data *kqd;
 	struct elevator_queue *eq;
+	int ret;
 
 	eq = elevator_alloc(q, e);
 	if (!eq)
@@ -372,6 +825,13 @@ static int kyber_init_sched(struct request_queue *q, struct elevator_type *e)
 		return PTR_ERR(kqd);
 	}
 
+	ret = kyber_group_activate(q);
+	if (ret) {
+		kyber_queue_data_free(kqd);
+		kobject_put(&eq->kobj);
+		return ret;
+	}
+
 	eq->elevator_data = kqd;
 	q->elevator = eq;
 
@@ -384,14 +844,10 @@ static void kyber_exit_sched(struct elevator_queue *e)
 {
 	struct kyber_queue_data *kqd = e->elevator_data;
 	struct request_queue *q = kqd->q;
-	int i;
 
 	blk_stat_remove_callback(q, kqd->cb);
-
-	for (i = 0; i < KYBER_NUM_DOMAINS; i++)
-		sbitmap_queue_free(&kqd->domain_tokens[i]);
-	blk_stat_free_callback(kqd->cb);
-	kfree(kqd);
+	kyber_group_deactivate(q);
+	kyber_queue_data_free(kqd);
 }
 
 static void kyber_ctx_queue_init(struct kyber_ctx_queue *kcq)
@@ -526,6 +982,7 @@ static bool kyber_bio_merge(struct blk_mq_hw_ctx *hctx, struct bio *bio)
 static void kyber_prepare_request(struct request *rq, struct bio *bio)
 {
 	rq_set_domain_token(rq, -1);
+	kyber_group_attach(rq, bio);
 }
 
 static void kyber_insert_requests(struct blk_mq_hw_ctx *hctx,
@@ -551,23 +1008,30 @@ static void kyber_insert_requests(struct blk_mq_hw_ctx *hctx,
 	}
 }
 
-static void kyber_finish_request(struct request *rq)
+static void kyber_requeue_request(struct request *rq)
 {
 	struct kyber_queue_data *kqd = rq->q->elevator->elevator_data;
 
 	rq_clear_domain_token(kqd, rq);
 }
 
+static void kyber_finish_request(struct request *rq)
+{
+	kyber_requeue_request(rq);
+	kyber_group_detach(rq);
+}
+
 static void kyber_completed_request(struct request *rq)
 {
 	struct request_queue *q = rq->q;
 	struct kyber_queue_data *kqd = q->elevator->elevator_data;
 	unsigned int sched_domain;
 	u64 now, latency, target;
+	bool missed;
 
 	/*
-	 * Check if this request met our latency goal. If not, quickly gather
-	 * some statistics and start throttling.
+	 * Check if this request met our latency goal, and that of its cgroup.
+	 * If not, quickly gather some statistics and start throttling.
 	 */
 	sched_domain = kyber_sched_domain(rq->cmd_flags);
 	switch (sched_domain) {
@@ -581,8 +1045,11 @@ static void kyber_completed_request(struct request *rq)
 		return;
 	}
 
-	/* If we are already monitoring latencies, don't check again. */
-	if (blk_stat_is_active(kqd->cb))
+	/*
+	 * If we are already monitoring latencies, don't check again. Requests
+	 * of a cgroup are always accounted to it.
+	 */
+	if (blk_stat_is_active(kqd->cb) && !rq_get_blkg(rq))
 		return;
 
 	now = ktime_get_ns();
@@ -590,8 +1057,9 @@ static void kyber_completed_request(struct request *rq)
 		return;
 
 	latency = now - rq->io_start_time_ns;
+	missed = kyber_group_completed(rq, sched_domain, latency);
 
-	if (latency > target)
+	if ((missed || latency > target) && !blk_stat_is_active(kqd->cb))
 		blk_stat_activate_msecs(kqd->cb, 10);
 }
 
@@ -962,7 +1430,7 @@ static struct elevator_type kyber_sched = {
 		.prepare_request = kyber_prepare_request,
 		.insert_requests = kyber_insert_requests,
 		.finish_request = kyber_finish_request,
-		.requeue_request = kyber_finish_request,
+		.requeue_request = kyber_requeue_request,
 		.completed_request = kyber_completed_request,
 		.dispatch_request = kyber_dispatch_request,
 		.has_work = kyber_has_work,
@@ -979,12 +1447,22 @@ static struct elevator_type kyber_sched = {
 
 static int __init kyber_init(void)
 {
-	return elv_register(&kyber_sched);
+	int ret;
+
+	ret = kyber_group_register();
+	if (ret)
+		return ret;
+
+	ret = elv_register(&kyber_sched);
+	if (ret)
+		kyber_group_unregister();
+	return ret;
 }
 
 static void __exit kyber_exit(void)
 {
 	elv_unregister(&kyber_sched);
+	kyber_group_unregister();
 }
 
 module_init(kyber_init);
@@ -326,7 +326,7 @@ void crypto_alg_tested(const char *name, int err)
 			continue;
 
 		if (strcmp(alg->cra_driver_name, q->cra_driver_name) &&
-		    q->cra_priority > alg->cra_priority)
+		    crypto_alg_preferred(q, alg))
 			continue;
 
 		crypto_remove_spawns(q, &list, alg);
@@ -61,7 +61,6 @@ static struct crypto_alg *__crypto_alg_lookup(const char *name, u32 type,
 					      u32 mask)
 {
 	struct crypto_alg *q, *alg = NULL;
-	int best = -2;
 
 	list_for_each_entry(q, &crypto_alg_list, cra_list) {
 		int exact, fuzzy;
@@ -79,13 +78,13 @@ static struct crypto_alg *__crypto_alg_lookup(const char *name, u32 type,
 
 		exact = !strcmp(q->cra_driver_name, name);
 		fuzzy = !strcmp(q->cra_name, name);
-		if (!exact && !(fuzzy && q->cra_priority > best))
+		if (!exact &&
+		    !(fuzzy && (!alg || crypto_alg_preferred(q, alg))))
 			continue;
 
 		if (unlikely(!crypto_mod_get(q)))
 			continue;
 
-		best = q->cra_priority;
 		if (alg)
 			crypto_mod_put(alg);
 		alg = q;
@@ -42,6 +42,30 @@ struct crypto_larval {
 	u32 mask;
 };
 
+/*
+ * Bytes processed per timed operation when the self-test manager
+ * benchmarks an algorithm, see crypto_alg::cra_bench_ns.
+ */
+#define CRYPTO_BENCH_BYTES	4096
+
+/*
+ * Is @q a better match for a name lookup than @alg?  Priority decides.
+ * Among implementations of equal priority, a timed one beats an untimed one
+ * and the faster of two timed ones wins.  Lookups and crypto_alg_tested()
+ * must both use this so that they agree on which implementation is best.
+ */
+static inline bool crypto_alg_preferred(const struct crypto_alg *q,
+					const struct crypto_alg *alg)
+{
+	u32 q_ns = READ_ONCE(q->cra_bench_ns) ?: U32_MAX;
+	u32 alg_ns = READ_ONCE(alg->cra_bench_ns) ?: U32_MAX;
+
+	if (q->cra_priority != alg->cra_priority)
+		return q->cra_priority > alg->cra_priority;
+
+	return q_ns < alg_ns;
+}
+
 extern struct list_head crypto_alg_list;
 extern struct rw_semaphore crypto_alg_sem;
 extern struct blocking_notifier_head crypto_chain;
@@ -53,6 +53,9 @@ static int c_show(struct seq_file *m, void *p)
 	seq_printf(m, "internal     : %s\n",
 		   (alg->cra_flags & CRYPTO_ALG_INTERNAL) ?
 		   "yes" : "no");
+	if (alg->cra_bench_ns)
+		seq_printf(m, "speed        : %u MB/s\n",
+			   CRYPTO_BENCH_BYTES * 1000 / alg->cra_bench_ns);
 
 	if (alg->cra_flags & CRYPTO_ALG_LARVAL) {
 		seq_printf(m, "type         : larval\n");
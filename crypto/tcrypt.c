@@ -2290,6 +2290,27 @@ static int do_test(const char *alg, u32 type, u32 mask, int m, u32 num_mb)
 				   num_mb);
 		break;
 
+	case 218:
+		test_cipher_speed("xts(aes)", ENCRYPT, sec, NULL, 0,
+				  speed_template_32_64);
+		test_cipher_speed("xts(aes)", DECRYPT, sec, NULL, 0,
+				  speed_template_32_64);
+		test_cipher_speed("adiantum(xchacha12,aes)", ENCRYPT, sec,
+				  NULL, 0, speed_template_32);
+		test_cipher_speed("adiantum(xchacha12,aes)", DECRYPT, sec,
+				  NULL, 0, speed_template_32);
+		test_cipher_speed("adiantum(xchacha20,aes)", ENCRYPT, sec,
+				  NULL, 0, speed_template_32);
+		test_cipher_speed("adiantum(xchacha20,aes)", DECRYPT, sec,
+				  NULL, 0, speed_template_32);
+		test_cipher_speed("xchacha12", ENCRYPT, sec, NULL, 0,
+				  speed_template_32);
+		test_cipher_speed("xchacha20", ENCRYPT, sec, NULL, 0,
+				  speed_template_32);
+		test_cipher_speed("chacha20", ENCRYPT, sec, NULL, 0,
+				  speed_template_32);
+		break;
+
 	case 300:
 		if (alg) {
 			test_hash_speed(alg, sec, generic_hash_speed_template);
@@ -25,6 +25,7 @@
 #include <crypto/skcipher.h>
 #include <linux/err.h>
 #include <linux/fips.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/scatterlist.h>
 #include <linux/slab.h>
@@ -125,6 +126,7 @@ struct alg_test_desc {
 	int (*test)(const struct alg_test_desc *desc, const char *driver,
 		    u32 type, u32 mask);
 	int fips_allowed;	/* set if alg is allowed in fips mode */
+	int bench;		/* time implementations to pick the fastest */
 
 	union {
 		struct aead_test_suite aead;
@@ -2410,6 +2412,18 @@ static int alg_test_null(const struct alg_test_desc *desc,
 /* Please keep this list sorted by algorithm name. */
 static const struct alg_test_desc alg_test_descs[] = {
 	{
+		.alg = "adiantum(xchacha12,aes)",
+		.test = alg_test_skcipher,
+		.suite = {
+			.cipher = __VECS(adiantum_xchacha12_aes_tv_template)
+		},
+	}, {
+		.alg = "adiantum(xchacha20,aes)",
+		.test = alg_test_skcipher,
+		.suite = {
+			.cipher = __VECS(adiantum_xchacha20_aes_tv_template)
+		},
+	}, {
 		.alg = "aegis128",
 		.test = alg_test_aead,
 		.suite = {
@@ -2700,6 +2714,7 @@ static const struct alg_test_desc alg_test_descs[] = {
 	}, {
 		.alg = "chacha20",
 		.test = alg_test_skcipher,
+		.bench = 1,
 		.suite = {
 			.cipher = __VECS(chacha20_tv_template)
 		},
@@ -2723,12 +2738,14 @@ static const struct alg_test_desc alg_test_descs[] = {
 	}, {
 		.alg = "crc32",
 		.test = alg_test_hash,
+		.bench = 1,
 		.suite = {
 			.hash = __VECS(crc32_tv_template)
 		}
 	}, {
 		.alg = "crc32c",
 		.test = alg_test_crc32c,
+		.bench = 1,
 		.fips_allowed = 1,
 		.suite = {
 			.hash = __VECS(crc32c_tv_template)
@@ -3292,6 +3309,12 @@ static const struct alg_test_desc alg_test_descs[] = {
 				.dec = __VECS(morus640_dec_tv_template),
 			}
 		}
+	}, {
+		.alg = "nhpoly1305",
+		.test = alg_test_hash,
+		.suite = {
+			.hash = __VECS(nhpoly1305_tv_template)
+		}
 	}, {
 		.alg = "ofb(aes)",
 		.test = alg_test_skcipher,
@@ -3334,6 +3357,7 @@ static const struct alg_test_desc alg_test_descs[] = {
 	}, {
 		.alg = "poly1305",
 		.test = alg_test_hash,
+		.bench = 1,
 		.suite = {
 			.hash = __VECS(poly1305_tv_template)
 		}
@@ -3545,6 +3569,18 @@ static const struct alg_test_desc alg_test_descs[] = {
 		.suite = {
 			.hash = __VECS(aes_xcbc128_tv_template)
 		}
+	}, {
+		.alg = "xchacha12",
+		.test = alg_test_skcipher,
+		.suite = {
+			.cipher = __VECS(xchacha12_tv_template)
+		},
+	}, {
+		.alg = "xchacha20",
+		.test = alg_test_skcipher,
+		.suite = {
+			.cipher = __VECS(xchacha20_tv_template)
+		},
 	}, {
 		.alg = "xts(aes)",
 		.test = alg_test_skcipher,
@@ -3668,6 +3704,111 @@ static int alg_find_test(const char *alg)
 	return -1;
 }
 
+#define ALG_BENCH_ITERS	64
+
+static void alg_bench_record(struct crypto_tfm *tfm, const char *driver,
+			     u64 ns)
+{
+	ns = max_t(u64, div_u64(ns, ALG_BENCH_ITERS), 1);
+	WRITE_ONCE(tfm->__crt_alg->cra_bench_ns, ns);
+
+	pr_info("alg: %s: %llu ns per %u bytes\n", driver, ns,
+		CRYPTO_BENCH_BYTES);
+}
+
+static void alg_bench_shash(const char *driver, u32 type, u32 mask)
+{
+	struct crypto_shash *tfm;
+	u64 start;
+	u8 *buf;
+	int i;
+
+	tfm = crypto_alloc_shash(driver, type, mask);
+	if (IS_ERR(tfm))
+		return;
+
+	buf = kzalloc(CRYPTO_BENCH_BYTES + crypto_shash_digestsize(tfm),
+		      GFP_KERNEL);
+	if (buf) {
+		SHASH_DESC_ON_STACK(desc, tfm);
+
+		desc->tfm = tfm;
+		desc->flags = 0;
+
+		start = ktime_get_ns();
+		for (i = 0; i < ALG_BENCH_ITERS; i++)
+			if (crypto_shash_digest(desc, buf, CRYPTO_BENCH_BYTES,
+						buf + CRYPTO_BENCH_BYTES))
+				break;
+		if (i == ALG_BENCH_ITERS)
+			alg_bench_record(crypto_shash_tfm(tfm), driver,
+					 ktime_get_ns() - start);
+		kfree(buf);
+	}
+
+	crypto_free_shash(tfm);
+}
+
+static void alg_bench_skcipher(const char *driver, u32 type, u32 mask)
+{
+	struct crypto_skcipher *tfm;
+	struct skcipher_request *req = NULL;
+	struct scatterlist sg;
+	u8 key[64] = { 0 };
+	u8 iv[32] = { 0 };
+	unsigned int keylen;
+	u8 *buf = NULL;
+	u64 start;
+	int i;
+
+	/* only synchronous ciphers, we don't want to time the scheduler */
+	tfm = crypto_alloc_skcipher(driver, type & ~CRYPTO_ALG_ASYNC,
+				    mask | CRYPTO_ALG_ASYNC);
+	if (IS_ERR(tfm))
+		return;
+
+	keylen = crypto_skcipher_default_keysize(tfm);
+	if (keylen > sizeof(key) || crypto_skcipher_ivsize(tfm) > sizeof(iv) ||
+	    crypto_skcipher_setkey(tfm, key, keylen))
+		goto out;
+
+	buf = kzalloc(CRYPTO_BENCH_BYTES, GFP_KERNEL);
+	req = skcipher_request_alloc(tfm, GFP_KERNEL);
+	if (!buf || !req)
+		goto out;
+
+	sg_init_one(&sg, buf, CRYPTO_BENCH_BYTES);
+	skcipher_request_set_callback(req, 0, NULL, NULL);
+	skcipher_request_set_crypt(req, &sg, &sg, CRYPTO_BENCH_BYTES, iv);
+
+	start = ktime_get_ns();
+	for (i = 0; i < ALG_BENCH_ITERS; i++)
+		if (crypto_skcipher_encrypt(req))
+			goto out;
+	alg_bench_record(crypto_skcipher_tfm(tfm), driver,
+			 ktime_get_ns() - start);
+
+out:
+	skcipher_request_free(req);
+	kfree(buf);
+	crypto_free_skcipher(tfm);
+}
+
+/*
+ * Time an implementation that just passed its self-tests, in the spirit of
+ * the raid6 and xor boot-time selection. The lookup code then prefers the
+ * fastest of the timed implementations of an algorithm over the one with
+ * the highest priority, and /proc/crypto reports the measured speed.
+ */
+static void alg_bench(const struct alg_test_desc *desc, const char *driver,
+		      u32 type, u32 mask)
+{
+	if (desc->test == alg_test_skcipher)
+		alg_bench_skcipher(driver, type, mask);
+	else
+		alg_bench_shash(driver, type, mask);
+}
+
 int alg_test(const char *driver, const char *alg, u32 type, u32 mask)
 {
 	int i;
@@ -3716,6 +3857,9 @@ int alg_test(const char *driver, const char *alg, u32 type, u32 mask)
 		rc |= alg_test_descs[j].test(alg_test_descs + j, driver,
 					     type, mask);
 
+	if (!rc && i >= 0 && alg_test_descs[i].bench)
+		alg_bench(alg_test_descs + i, driver, type, mask);
+
 test_done:
 	if (fips_enabled && rc)
 		panic("%s: %s alg self test failed in fips mode!\n", driver, alg);
@@ -29,7 +29,7 @@
 #define MAX_DIGEST_SIZE		64
 #define MAX_TAP			8
 
-#define MAX_KEYLEN		160
+#define MAX_KEYLEN		1088
 #define MAX_IVLEN		32
 
 struct hash_testvec {
@@ -40,7 +40,7 @@ struct hash_testvec {
 	unsigned char tap[MAX_TAP];
 	unsigned short psize;
 	unsigned char np;
-	unsigned char ksize;
+	unsigned short ksize;
 };
 
 /*
@@ -5637,6 +5637,1045 @@ static const struct hash_testvec poly1305_tv_template[] = {
 	}
 };
 
+static const struct hash_testvec nhpoly1305_tv_template[] = {
+	{
+		.key		= "\xd3\xd1\xa7\x41\x7c\xb5\xa5\x61"
+				  "\x80\xeb\xee\x6d\x84\x6c\xb3\x69"
+				  "\x13\x2c\x7a\xb3\x30\xad\x3e\x29"
+				  "\x5f\x7c\x1c\xfc\x0e\x1b\x25\x6e"
+				  "\x10\xee\xc2\xeb\x66\xec\x15\xfe"
+				  "\x5b\x35\x0a\xde\x04\x2d\x54\x6c"
+				  "\x04\xba\x20\x9a\x10\xbe\xc3\xaf"
+				  "\x08\x97\x8d\xbb\xdf\xc2\x05\xc5"
+				  "\x44\x63\x62\xe8\x3c\x19\xcc\x56"
+				  "\x10\x60\xdc\x9e\x79\x62\x6b\x27"
+				  "\x0b\x72\x67\x0d\xca\x0f\xf4\x07"
+				  "\x52\x6e\xf1\x3d\xc8\x6c\xb8\xd4"
+				  "\x67\xcd\x98\xab\xb5\xbd\x14\x1b"
+				  "\xbb\x47\xe0\xf4\xe0\x02\x31\xa7"
+				  "\x5d\x3c\x2a\x3a\x46\x2d\x83\x40"
+				  "\xde\x67\x0a\xec\x59\xbc\x71\x8a"
+				  "\x12\xf3\xc0\xc2\xbe\x0c\x7a\x47"
+				  "\xf4\xea\xa7\x1c\x1e\x13\x10\xaa"
+				  "\xca\xc0\xca\x18\x5c\x92\xb2\x4f"
+				  "\x67\x8f\xc2\xc1\xa3\xf7\x73\xd5"
+				  "\x33\x13\xbe\x0a\xbc\xdc\x73\xf7"
+				  "\x5d\x1f\x42\xc8\xff\x8a\x82\x15"
+				  "\xba\x44\x6e\x91\xf7\x67\xf0\x7b"
+				  "\xbb\xe9\x1f\x94\x62\x3b\xef\x46"
+				  "\xbe\xce\x4d\xee\xd6\x01\xc6\xa1"
+				  "\xcb\x13\x1a\x31\x87\x6d\x85\x76"
+				  "\x39\x1e\x55\x64\x22\x0c\x4f\xc3"
+				  "\xc2\x40\x20\xa2\xfb\x26\x18\x49"
+				  "\x6b\xe1\xaf\x90\x49\x4d\xd2\xe7"
+				  "\xf1\x12\x1e\xe5\x5a\xe4\xec\x80"
+				  "\xf5\x22\xad\x15\x8a\xe5\xc8\x00"
+				  "\xf0\xfa\x40\x04\xca\x04\xe5\xb1"
+				  "\x37\x54\xba\x9a\x74\xca\x90\xb1"
+				  "\x6b\xe3\x89\x4a\x0e\xea\x27\x31"
+				  "\x97\xca\xe4\xac\x4a\x5d\x54\x9b"
+				  "\x5a\xb9\xf7\xb3\x6a\xa2\x9d\x60"
+				  "\x6c\x98\xff\x90\x0e\xa2\xfe\x13"
+				  "\xce\xbe\xb3\xdb\xe1\x6e\x3c\xd3"
+				  "\x39\xe1\xdc\xaf\xa2\xf5\x2b\xc2"
+				  "\x1a\x89\xc7\x54\x23\xd4\x74\x1d"
+				  "\xe6\x07\xe7\xc9\x31\x96\x03\x17"
+				  "\x0a\x67\x82\x98\xd8\x61\x55\x2e"
+				  "\x99\xc0\x72\xb9\x5d\x46\x8d\xcf"
+				  "\x28\x99\x3f\x23\xd5\xbd\xdc\xe4"
+				  "\x09\x1c\xba\xf6\x17\xc1\x0c\x03"
+				  "\x4e\xb5\x00\x50\xc2\xc7\xca\xc5"
+				  "\x10\x04\xb7\xc5\xf7\x92\xf7\x8b"
+				  "\x29\x22\x4e\x43\x27\x82\xd2\xa4"
+				  "\x01\xa8\x0f\x2d\x11\x9f\x7b\x7d"
+				  "\x69\x8b\x25\xb5\x07\x80\x80\xa6"
+				  "\x04\x38\xb6\x4e\x4e\x76\x4d\xde"
+				  "\xdd\x81\xef\x70\xdc\x77\x5d\x1b"
+				  "\xb0\x70\xa4\x64\xf3\x53\xd7\x64"
+				  "\x85\x4e\x1c\x6a\x44\x24\x44\x96"
+				  "\xc8\xa1\xcc\xba\x99\x72\x9a\x22"
+				  "\xa2\x92\xee\x76\xc0\x75\x8b\x6f"
+				  "\x62\x23\x5c\xc2\x93\x8a\xef\x29"
+				  "\x67\xd9\xb1\x6e\xef\x04\x90\x8f"
+				  "\xa4\x36\xc8\xae\x24\x15\x29\xfc"
+				  "\x48\xee\xdc\x9b\x77\xe1\xf9\x2e"
+				  "\x64\xd4\x1b\xb3\x22\xdb\x1d\x8a"
+				  "\x69\x20\x8b\x7d\x18\xed\xea\x70"
+				  "\x82\x98\x08\x54\x35\x51\xb4\x03"
+				  "\x19\xce\x9b\x49\xac\xc8\xe5\x8a"
+				  "\x68\xb2\xd5\x89\xc8\x15\xee\x84"
+				  "\xd2\x8d\x11\x6a\x3c\x70\xb3\xb7"
+				  "\xf5\x64\xe6\x8f\x64\xb0\x2f\x97"
+				  "\x3f\x62\x6a\x51\x70\xdd\x54\xb8"
+				  "\x10\xdb\x5e\xc0\x53\x6b\x0f\x68"
+				  "\x91\x1e\xdb\xad\xc9\x31\xab\x32"
+				  "\xc9\xc8\x15\x44\x43\x53\x21\x07"
+				  "\x6c\x80\x2c\xe4\x87\x7d\x3d\xc5"
+				  "\x76\x48\x67\x35\x40\x47\x4b\x12"
+				  "\xeb\xd6\x0e\xa3\x37\xff\x8d\x67"
+				  "\x87\x37\x1f\x18\x66\xfb\x3e\xb2"
+				  "\x89\x85\x77\x81\xa8\xdb\x9f\x2c"
+				  "\x30\xdc\x4a\x98\xb4\x26\x2f\x4d"
+				  "\xad\x3f\x0b\x05\xee\xdf\x86\x0e"
+				  "\x51\x76\xb2\x38\x5b\xba\x0c\x76"
+				  "\x82\xee\x80\xc2\xd5\xbc\xf2\x73"
+				  "\xb5\xa3\x09\x4c\x83\x8e\x6c\x9f"
+				  "\x47\x55\xd8\xc5\xb8\xe8\x0d\x21"
+				  "\x23\x4c\xb1\xc2\x57\x82\xa6\x0b"
+				  "\xb7\x71\xc1\x19\xda\xf9\xb2\x04"
+				  "\xf1\x56\x59\x93\x61\xf9\xac\x73"
+				  "\x24\x71\x30\x3a\x9e\x45\x61\xce"
+				  "\x31\x8c\x6e\xc0\x80\x58\x7e\xf8"
+				  "\xa2\x07\x3a\x03\xac\x56\x24\x0d"
+				  "\x9d\x26\x7a\xfe\xcd\xca\x80\x67"
+				  "\x4a\xbf\x2b\xd2\xda\x1b\xa2\x5e"
+				  "\x17\xaa\x0d\x2e\x24\x8b\xb1\x33"
+				  "\x0d\x1c\xa2\xb9\x21\xe1\x32\x4c"
+				  "\x2a\xf5\xde\x7d\x65\x5e\xed\xf6"
+				  "\xd6\x94\xf4\x5e\x35\xcf\x3d\x80"
+				  "\x6a\xce\x21\x29\xde\xd0\x61\x3a"
+				  "\x91\xe8\x4c\x87\xb2\x07\x5f\x7d"
+				  "\xfa\xf9\xb9\xe2\xc4\x53\xbc\x0d"
+				  "\x94\x81\xb7\x61\x67\x28\x42\xe6"
+				  "\x4b\xcb\xd7\x73\xfb\x13\xb7\x7b"
+				  "\x8e\x4f\x07\x55\x8b\xd1\xb6\x29"
+				  "\xfe\xbf\x70\x1b\x5e\x48\xcc\x8d"
+				  "\x10\xa2\x4a\x25\x5c\x8a\x1b\x3d"
+				  "\x57\x67\x1c\x5b\x6c\x66\xf8\x7f"
+				  "\x1e\xca\xb1\xdb\xf3\xac\x4b\xdc"
+				  "\xf4\x1f\x4a\x9c\x18\xdb\x81\xa3"
+				  "\x96\x28\x46\x6a\x55\x22\x9b\x00"
+				  "\x72\x42\xbe\xb0\xf3\x8c\xd7\x68"
+				  "\xe1\x93\x21\x15\x79\x7d\xf8\xfa"
+				  "\x6e\xbc\x53\xf9\xf9\xee\xad\xc4"
+				  "\x5c\x84\x64\x1b\x94\xa7\x01\xb5"
+				  "\xf3\x9d\xea\x9f\x48\x52\xad\x10"
+				  "\x21\xe1\x8a\x86\xd7\x81\x56\xe1"
+				  "\x24\x3b\x17\x09\x25\x53\x3d\xb4"
+				  "\x06\xe3\x13\xdc\x56\x0b\xbb\xd3"
+				  "\xc9\xb9\x59\x32\xc5\x00\xf5\xb7"
+				  "\xd5\x03\x2c\x3d\xc6\x54\xfe\xcf"
+				  "\x5c\x5f\x9a\xf8\x98\x3e\x7f\xfe"
+				  "\x2e\x6e\x6e\x83\x44\xbb\x7d\xf6"
+				  "\xa5\x6f\x18\xc2\xdc\xd0\x83\x78"
+				  "\xb2\x90\xda\x93\xdd\x8e\xf9\x29"
+				  "\x07\x6e\x8e\x8e\x14\x16\x48\x05"
+				  "\x24\x32\x16\xf6\xa3\xbf\xc9\x68"
+				  "\x0c\xa8\x81\x12\x74\xa5\xe4\xd7"
+				  "\x82\x9a\x66\xe5\xd7\x48\x67\x6c"
+				  "\x0f\xd2\x37\x14\x71\xbd\x0e\xf5"
+				  "\xcd\x42\xee\x7f\x97\xdc\xc3\x77"
+				  "\xde\xd3\xa5\xd1\x49\xab\x6f\x76"
+				  "\xfe\x79\x17\x49\xc8\x1f\x0c\x99"
+				  "\x11\x3d\x4b\xdc\xe7\x0b\x86\x2d"
+				  "\x73\x6f\x90\x27\x10\xcf\x6e\xd8"
+				  "\x16\x46\xdf\x8f\x8d\x3a\xc5\xd8"
+				  "\xfb\x55\x90\x55\xd8\x7a\xc3\x98"
+				  "\x2a\xc7\x35\x1d\xeb\x86\xd2\xf2"
+				  "\xf4\x13\xb2\x28\x21\x2a\x70\x66"
+				  "\x4d\xf0\x5d\x16\xb4\x1b\x52\xd4"
+				  "\xab\xa3\xdf\x4d\x13\x81\xc8\x7f",
+		.ksize		= 1088,
+		.plaintext	= "",
+		.psize		= 0,
+		.digest		= "\x00\x00\x00\x00\x00\x00\x00\x00"
+				  "\x00\x00\x00\x00\x00\x00\x00\x00",
+	}, {
+		.key		= "\x07\x85\x14\xeb\x96\xed\x14\xbc"
+				  "\xe1\x28\x2c\xdd\xa2\xe5\xe5\x7f"
+				  "\xa6\xe8\x09\x13\xb8\x5b\x8d\x89"
+				  "\x44\x69\x45\x46\x9f\x14\xe7\x00"
+				  "\xcb\xb0\xdf\x21\x24\x90\xc6\x25"
+				  "\x1a\x0a\xb1\x4b\x3e\x6c\x61\x3e"
+				  "\xcb\xf7\x2b\xf2\xc1\xf9\x68\x39"
+				  "\xc4\xd8\xdb\xa3\x4c\xd3\xe9\x5a"
+				  "\xc5\x8d\xf5\x30\xe5\xf0\x97\x85"
+				  "\x7f\x03\x82\x23\x35\xbb\x62\x50"
+				  "\x16\x69\x4c\xe5\xbe\x09\x16\xbc"
+				  "\x75\x47\x33\xcc\x2a\x24\x36\x13"
+				  "\x11\x6d\xb2\xb2\x4d\x1a\x38\x7d"
+				  "\x3a\xc0\xa2\xd5\x67\xc9\x8b\x30"
+				  "\x86\x2d\x19\xbf\xbe\xce\xec\x45"
+				  "\x61\x90\xcc\x75\x44\x40\x2d\xf5"
+				  "\xf4\x67\xad\x85\x0b\xc5\xc9\x7e"
+				  "\xac\x9a\xc6\xfc\x10\x3d\x0f\x08"
+				  "\xa2\x7f\x99\x4b\xd5\xb5\xaa\xef"
+				  "\x6f\x66\x43\x25\x94\xde\x0a\xb5"
+				  "\x84\x4a\x55\xac\xc7\x3e\x9b\x38"
+				  "\x23\x9e\xe2\xc3\x99\xe4\x4e\x3a"
+				  "\x2c\x01\x53\x2d\x8c\x0f\x9b\xa9"
+				  "\xf2\x5e\x52\xf4\xc2\xf3\xfa\xe6"
+				  "\xd2\x92\xbe\xf8\xb5\xa1\xa8\xf1"
+				  "\x1e\x05\x73\x85\xe5\xe2\x37\x5a"
+				  "\x37\xbc\xa5\x31\x74\x86\x4f\x6c"
+				  "\x77\xa6\xad\x81\xc5\x66\x49\x3e"
+				  "\x16\x1d\xee\x65\x3c\xe9\xd8\xf3"
+				  "\xe3\xd6\xe5\x2a\xd0\xe9\xf1\x29"
+				  "\xd3\x5f\x79\xf9\xea\xf8\xda\x45"
+				  "\x5f\x56\x85\xbb\x90\x94\x10\x96"
+				  "\x7e\xfc\xc0\xbf\x44\x71\x49\x8a"
+				  "\x1b\x41\x9e\xa9\x2b\xd4\x83\x8d"
+				  "\x99\x0c\x00\xcf\x4c\x4d\x51\x0e"
+				  "\x60\x44\x4a\x9d\x56\xb1\xa1\xd7"
+				  "\x05\x01\xfd\x37\xb0\x81\xeb\x50"
+				  "\xa6\x46\xca\x1f\xcb\x36\x72\xb4"
+				  "\x43\x38\x2b\x73\x72\xe1\xc3\x7d"
+				  "\x4a\xf7\x7e\x1c\xc8\xed\x35\xf9"
+				  "\xb8\xd9\x8a\x3d\xe6\xa1\xe6\x68"
+				  "\x0b\x70\x03\xaf\x35\xd4\x97\x2d"
+				  "\xcd\x4d\x4b\x11\x71\xd6\x55\x35"
+				  "\xee\x1d\x7a\xb8\x92\x8a\x86\x75"
+				  "\xf0\xa7\x13\xf8\x73\xaa\x59\x5e"
+				  "\x16\xc3\x9b\xa3\xbe\x65\x9a\x5e"
+				  "\x4c\xc4\x81\x4c\x24\x67\x46\xac"
+				  "\x3b\x19\x76\xf0\xba\x13\xad\x62"
+				  "\x16\x2c\x8e\x88\x76\x57\xdf\x9a"
+				  "\x28\x2a\x98\x2c\x8a\x7a\x23\x02"
+				  "\xe0\x11\x20\xa4\x07\xe2\x9c\xd1"
+				  "\xe6\x76\x8d\x3e\x5d\x44\xe2\xbe"
+				  "\x53\x0b\xde\xb1\xe8\x05\xaa\xfa"
+				  "\xaf\x65\x3e\x5f\xca\x59\x82\x51"
+				  "\x6d\x82\x2c\xc6\x02\x76\x34\x0e"
+				  "\xc3\x6e\x53\x7a\x79\x56\xb5\x3a"
+				  "\xb4\xba\x17\x9a\xe5\x07\xae\x1c"
+				  "\x06\xa0\x1b\x16\x75\x7e\xe1\x91"
+				  "\xa0\x73\xdb\x07\x1a\xc0\x82\xf5"
+				  "\xf4\x07\x6c\x2a\x00\xf3\x95\x8a"
+				  "\x4f\x29\xb8\x28\xc7\x3c\x0f\xc3"
+				  "\x9b\x80\x4f\x16\x03\x80\xd0\xe9"
+				  "\xb4\xb9\xf9\x59\x86\x24\xc2\x73"
+				  "\x1c\x8a\xb6\x02\xd5\x32\x3a\x46"
+				  "\x9d\xee\xfc\x99\x2a\x75\xa2\xd8"
+				  "\xcb\xfa\x14\x9a\x78\xf7\x57\x85"
+				  "\xa4\xf5\xfa\xd8\xaa\x88\x32\x55"
+				  "\x5e\xd7\x4c\x39\x1d\x77\x28\x53"
+				  "\x55\x29\xf9\x8d\xc9\x86\x8f\x98"
+				  "\xf1\xe5\x7c\x89\x90\x01\x85\x6a"
+				  "\x2a\xf4\x40\x47\xc6\xc3\x0f\x21"
+				  "\xb8\xf1\xfc\x24\x13\xcc\xe8\x42"
+				  "\x9f\x16\x53\x49\xc4\x60\xdb\x10"
+				  "\x10\x49\x89\xb0\xda\xce\x90\xf6"
+				  "\xf2\x52\x8a\x5a\x6a\x05\x4c\x5c"
+				  "\x25\xa9\x73\x81\x25\x32\x2c\xd8"
+				  "\xb7\xac\x2e\xb2\xff\xe8\xf1\x43"
+				  "\x26\x10\x44\x78\x01\x14\x4b\x7f"
+				  "\xc6\x16\x1f\xf1\x88\x73\x10\xb1"
+				  "\x17\xe8\x1e\xec\x35\xb8\xeb\xa1"
+				  "\xbc\xc0\x2b\xd6\x06\xb8\x75\xd8"
+				  "\x2a\xe0\xd3\xe0\xe2\x12\x30\x88"
+				  "\x8b\xd4\x6a\xbe\xf2\xc9\xc4\xa8"
+				  "\xd3\x97\x88\x71\x02\xe9\x14\x85"
+				  "\x30\xcc\xd7\xfb\x9d\x35\x6a\xc4"
+				  "\xe1\x29\x2c\xa6\x1a\xfb\x11\x99"
+				  "\xe6\x66\x5a\xae\xaa\x37\x1d\xdc"
+				  "\xcb\x51\xb1\xde\xe3\x1e\x40\x96"
+				  "\x14\xaa\x59\x98\x53\x1f\x4f\x0e"
+				  "\x0d\x64\x63\x86\x7f\x14\x06\xbd"
+				  "\x43\x54\x43\x01\x92\xea\x83\xf4"
+				  "\xef\x6b\xec\xe0\x45\x4e\x86\xce"
+				  "\x3b\x4e\xe6\xad\xed\x1d\x52\xbf"
+				  "\x7e\xaa\x66\x33\xea\xfc\x03\x9f"
+				  "\x0b\x9c\x2d\xc8\x1f\x2f\xff\xa0"
+				  "\x9f\xb8\x08\x60\x01\xce\x23\xda"
+				  "\x5f\xfb\x94\x51\x4b\xc9\x1b\x4f"
+				  "\x59\xc0\x8d\x92\xf5\xd3\x83\x8f"
+				  "\x99\x60\x39\xda\xef\x1e\xe7\x0e"
+				  "\xf9\x4e\x0a\xd7\x14\x02\xc5\x8c"
+				  "\x2e\xdc\x00\xa5\xab\xef\xe4\xcf"
+				  "\x66\xa7\x11\x6b\x5f\x2a\x88\xa0"
+				  "\x0e\x75\xf7\x08\x36\x9b\xbc\xe8"
+				  "\x38\xba\xa1\x5b\x09\x10\x46\xf2"
+				  "\xc3\xd4\xe4\x01\x27\xe6\x78\xbd"
+				  "\x86\x2e\x82\x05\xe8\xf0\x10\x23"
+				  "\x80\xb8\xcd\x6f\x1a\x49\xfc\x26"
+				  "\xa1\x2d\xfa\x9d\xe2\xd1\xdb\xd9"
+				  "\x42\xc3\xf5\xe4\x8d\x34\x2a\x94"
+				  "\xb7\x44\xc8\xf5\xec\x98\x06\xde"
+				  "\x49\xa9\x63\x2e\xc5\xb5\xf6\xf0"
+				  "\x8d\x45\x4f\x87\x0f\x62\xed\x71"
+				  "\x9b\x79\x25\xd7\xc9\xe1\x8e\xb6"
+				  "\x62\xcc\xbf\x27\x3b\x03\x10\x01"
+				  "\x53\xe7\xdf\xcb\x11\x62\x6e\xf8"
+				  "\x73\xbf\xee\xa6\x7f\xfd\xb1\x15"
+				  "\x9f\x9e\xb1\x70\xbc\x1d\x68\x39"
+				  "\x46\xdc\xa3\x84\x57\x80\xdb\x4d"
+				  "\x34\xfe\x27\xae\xbe\xb9\x3d\x56"
+				  "\x70\x06\xa3\x17\xc7\x5d\xcc\x17"
+				  "\xb2\x2e\x3d\x61\xe3\x90\xb1\xa6"
+				  "\xf8\xb4\xa1\x67\x35\x59\xfd\x5d"
+				  "\x88\x7f\x60\x81\x1b\xe3\x49\xf9"
+				  "\x49\xbc\xc8\x72\x5e\xda\xb6\xa4"
+				  "\x3c\x7e\xad\xe5\x59\x18\xd4\x5e"
+				  "\x32\xea\xc6\x02\xdf\xcb\xe1\xfc"
+				  "\xb8\x32\xc3\xf1\x22\xb6\x1d\x60"
+				  "\x2f\x67\x21\x50\x05\x5b\xf2\xfd"
+				  "\xe4\xcc\x06\xfd\x2b\x47\x41\xbe"
+				  "\x6d\x04\x1d\xc2\xff\xf4\x0d\x83"
+				  "\x26\xd7\xb6\x23\xc3\xcb\x1a\xd8"
+				  "\xb0\xc3\xbc\x25\xfb\x29\x9b\x92"
+				  "\xa2\x19\xae\x20\x90\x24\xd9\x68"
+				  "\x32\x9c\x18\xf2\xf9\xff\x82\xb7"
+				  "\x0d\xbf\x16\xd8\xac\xfe\xb2\x8a"
+				  "\xe4\xc6\xf5\x6d\x33\x0c\x6c\xcb",
+		.ksize		= 1088,
+		.plaintext	= "\x10\x05\x16\x58\x82\xc4\x79\xf9"
+				  "\x79\xd6\xc4\xab\xc1\x60\xb6\xd9",
+		.psize		= 16,
+		.digest		= "\x3c\x75\x04\xe2\x18\xe1\x5c\x5d"
+				  "\xff\x67\x6f\xc4\x68\x18\xae\x0f",
+	}, {
+		.key		= "\x07\x75\x72\x3b\xb5\x4d\x42\x21"
+				  "\xe9\x9b\x02\x69\x04\xe2\x09\x63"
+				  "\x64\x5e\x2e\x3d\xaf\x6f\xb5\xdc"
+				  "\xfa\x8b\xca\xc8\x42\x72\xa4\xb5"
+				  "\x24\x93\x8e\xb4\x1b\xb8\x0f\xd0"
+				  "\x98\x45\x79\x71\xa4\xaf\x60\x7f"
+				  "\x84\xeb\x2a\x72\x59\xfa\x5b\xc5"
+				  "\xb7\x63\xb9\x55\x89\x48\x3a\x9d"
+				  "\x43\x18\x62\x1a\x37\x4b\x66\x77"
+				  "\x06\x25\x5f\xa4\x4a\x4c\x6b\x3b"
+				  "\x3f\x73\xb2\x24\x14\xa5\x8e\x2d"
+				  "\x52\xc4\x5d\x05\x46\x7b\x72\x18"
+				  "\xae\x9e\x40\xca\x75\xe7\xc2\x03"
+				  "\xe9\x0d\x75\x57\xe9\xec\x8a\x0d"
+				  "\x22\x08\x31\x87\x74\x4f\x58\x3f"
+				  "\xfc\xc2\xac\x78\x1a\x12\xea\x53"
+				  "\xfd\x40\xa2\xbe\xf8\xcd\xfd\x51"
+				  "\xc9\xce\x07\xf0\x1e\xde\x02\x4c"
+				  "\x49\x39\x03\xec\xe9\x72\x17\xc9"
+				  "\xfe\x52\xc7\x33\x32\xb5\xe4\x65"
+				  "\x05\x82\x43\x33\xf8\x04\x98\x8e"
+				  "\x3e\x2f\xb5\x0b\x10\x08\x06\x23"
+				  "\x91\xdd\xb5\xf0\xec\x8a\x3f\x9d"
+				  "\x25\x34\x4a\x81\xbb\xaa\x99\xca"
+				  "\xee\x65\x55\xcd\xf4\xce\x5e\xde"
+				  "\x61\xad\xff\x9d\xc2\x7c\x0e\x7e"
+				  "\x68\x43\xa9\x33\xbe\xbf\x8b\xad"
+				  "\x57\x98\xce\x92\xa5\x32\xb3\xb6"
+				  "\xae\x72\xce\x8a\xfe\x66\xad\x37"
+				  "\x03\x84\x66\x30\x84\xa1\x79\x16"
+				  "\xbe\xf2\xd1\x99\xc1\xb7\x11\xb4"
+				  "\x38\x6b\x59\x98\x98\x64\xf5\xa0"
+				  "\x61\x60\xa3\x3f\x20\xa5\x8b\xf6"
+				  "\x9e\xf2\xf8\xb4\x89\x40\x07\xd1"
+				  "\xc3\xcd\xdc\xeb\x4d\x5b\x49\x8a"
+				  "\x64\x5c\x14\xb1\x96\x58\xf4\xf1"
+				  "\xe9\xc7\x9c\x45\x9c\xd9\x8b\x4e"
+				  "\x00\xa5\x2d\x0b\xd2\x77\x98\x9e"
+				  "\xdb\x7e\x23\x1c\x73\xfb\xdd\x9e"
+				  "\x62\x5f\x89\xba\x7b\xbe\x8a\xce"
+				  "\x9f\xda\x00\x3a\x13\x60\xd4\x52"
+				  "\x36\xfd\x76\x16\x99\x68\x25\x53"
+				  "\x76\xe9\x2b\x7d\x2c\x46\x9e\x1b"
+				  "\x3d\xfc\x7e\x76\xb0\x58\x7e\x7f"
+				  "\xf6\x3e\x00\xff\xab\xd4\xa0\x10"
+				  "\xe2\xed\xe5\x33\x61\xd4\x2f\x74"
+				  "\xc9\x97\xef\xbf\x0f\xb3\x78\xba"
+				  "\xb0\x94\xc1\x6a\xab\xf8\x5e\x98"
+				  "\x71\x79\x19\xab\x80\x3f\x57\x47"
+				  "\xae\x95\x7a\xb4\xb9\xe4\x8b\xde"
+				  "\x98\xc6\xd6\x1d\xaa\xcf\x53\x20"
+				  "\xa3\x15\x9e\x9a\x02\x7f\x51\x2f"
+				  "\xd1\x86\x2a\xc9\x3c\xa6\x5f\xd5"
+				  "\x40\x06\xc8\xc5\xce\xfd\x7d\x06"
+				  "\x3f\x55\xbe\xf4\x8f\x9e\x74\x27"
+				  "\x74\xd2\xa2\x70\x7d\x21\x8b\x20"
+				  "\xfc\x70\x37\x4a\x9d\x5f\x41\x09"
+				  "\x1b\x66\x82\x89\xea\x4b\x3d\x29"
+				  "\x66\x7f\x2c\x27\x59\xd5\xc9\xca"
+				  "\x9f\xf5\x67\x3f\x13\x91\x7e\x48"
+				  "\x7e\x84\x1a\xdb\x13\x3f\x8c\xca"
+				  "\x63\xfa\xe8\x2b\x3f\x8c\xde\xf4"
+				  "\x05\x23\x27\xed\xc6\xdc\x5e\xa5"
+				  "\x27\x60\x1c\x06\x86\xe0\x90\x88"
+				  "\x85\x8b\x75\xdd\xf3\xe6\x05\x96"
+				  "\x15\x3d\xe1\x62\x93\xb4\xe8\xf1"
+				  "\xc4\x4f\x93\x20\x27\x7e\xdb\xd4"
+				  "\x6e\x1e\x3f\xbd\x2e\x2d\x76\x9c"
+				  "\xdf\xdc\xc2\xed\xd6\xd3\xe0\x59"
+				  "\x58\x39\xad\x82\x4b\x9e\x2f\x24"
+				  "\xef\xa3\xaa\x7a\x3f\x13\x1c\xe2"
+				  "\xe9\xf3\x36\x63\xa3\x5e\x97\xe9"
+				  "\x22\xde\x93\x5a\x35\x57\xf6\x64"
+				  "\x96\x8a\xae\xa4\x6d\xcc\x28\xd3"
+				  "\xba\x4a\x12\x55\x71\x4a\xf3\x30"
+				  "\xbf\x04\x20\x3b\xbc\xd0\x46\x50"
+				  "\x91\xe6\x98\x1a\x1f\xe9\x44\x8d"
+				  "\x58\x71\xf3\xd5\xc9\xa3\x2b\x87"
+				  "\x15\xad\x2a\x13\x84\xff\x87\xe0"
+				  "\x75\xc0\x14\x99\x1e\x86\x1d\x4b"
+				  "\xbb\xdb\xeb\x83\xc2\xf0\x40\x10"
+				  "\xeb\x34\xde\xa2\x5b\x61\x4b\x23"
+				  "\xf0\x7f\x68\x53\x8c\x8b\xbc\x32"
+				  "\x67\xc0\x75\x85\x0a\x0a\xfd\x71"
+				  "\x84\x6a\x7f\x9d\x0d\x44\x01\xa1"
+				  "\xfa\x21\xea\xf0\xb1\x59\x9c\x1c"
+				  "\xe1\x25\xd9\x81\xe4\xac\x17\x7a"
+				  "\x38\xf8\x28\xc8\x1c\x2e\x7d\xd8"
+				  "\xda\xa6\x6d\x55\xa6\x1b\x21\x28"
+				  "\x8e\xff\x59\x9c\xc1\x2a\x48\x66"
+				  "\x70\x4c\x9d\xfc\x58\xfe\xf7\xb9"
+				  "\xc0\x7e\xa1\x2e\x41\x17\x0a\xf4"
+				  "\xba\x7f\x16\x93\xdc\x52\x8b\x20"
+				  "\xfa\x25\xe5\xc8\x73\x1a\x5f\xf9"
+				  "\xfc\x48\x34\xb6\x41\xa6\x11\xe3"
+				  "\xd0\x8c\x8f\xa1\x53\x69\xec\x72"
+				  "\x9f\x0a\x47\xcc\xa4\xd4\x36\xe8"
+				  "\xfa\x15\xf9\x5d\x3a\x12\xc7\x79"
+				  "\xfe\x11\xa2\x09\x01\x95\x99\x1a"
+				  "\xc9\x98\xef\x99\x21\x8f\xee\xfe"
+				  "\xad\x10\x28\xf7\x72\xe3\x23\xc4"
+				  "\xeb\xe4\x77\xd8\xeb\xf9\x6c\x50"
+				  "\x85\x22\x9c\x2c\x00\x04\xf6\xe4"
+				  "\xe8\x59\xd6\x3d\x7b\x64\x62\xf2"
+				  "\x98\x88\xd0\xec\xe5\xa0\x0e\xf3"
+				  "\x0e\x42\x17\x5b\xa1\x31\xc3\xf0"
+				  "\x0b\xe0\x4a\xd5\x70\xc8\x00\x34"
+				  "\x3c\x06\x8b\x72\xfb\x1a\x13\xa1"
+				  "\x9c\x6c\x92\x6e\x5a\xa5\x78\x4f"
+				  "\xa6\x01\x84\x25\x78\xd4\x29\x8b"
+				  "\xa3\xcf\x56\x65\xa5\x59\xe3\x75"
+				  "\x8a\xdf\xc2\x50\x38\x1d\xee\xf0"
+				  "\xdc\xba\x21\xbf\x2a\x63\xb2\x38"
+				  "\x2a\x5f\xed\x79\x38\x9e\x86\xaa"
+				  "\xac\x78\xd2\x39\x68\xce\x96\x9d"
+				  "\xbf\xf4\xc2\x92\x14\x3c\x88\xcf"
+				  "\xc4\x6f\xf6\xa2\x1c\xd3\x4a\x3b"
+				  "\xd8\x78\xbe\x6e\xca\xfe\x01\x47"
+				  "\x44\x7e\xff\x1f\x3a\x4e\x79\x94"
+				  "\x10\x82\x68\x01\xb2\x29\xe7\x57"
+				  "\xfb\x09\x77\x20\x6c\xbf\xfb\x56"
+				  "\x88\x8b\x06\xc7\x2e\x78\x72\xa9"
+				  "\x19\x2d\xbe\x9b\xa3\x18\xfe\x32"
+				  "\x88\x05\xd5\xab\xbe\x38\x45\xb7"
+				  "\x9d\x1f\xb8\x7a\xbd\x8b\x52\x42"
+				  "\x2a\xeb\xb5\xe7\xa0\x8e\xb1\x67"
+				  "\x35\x6c\xe5\x68\xf7\x5b\xf6\xc9"
+				  "\x91\xd2\x12\x1c\x99\x6e\xb9\xe2"
+				  "\xd2\x28\x10\xde\x78\x9b\xdb\x3b"
+				  "\xf5\xbe\x13\x0f\x69\x98\xef\x99"
+				  "\xbf\xa9\x3b\x29\x9a\x50\x95\xf8"
+				  "\xbd\xf7\xe2\xe3\x97\x1b\x19\x8e"
+				  "\x90\x15\xc5\x44\xe4\x5c\x97\x68"
+				  "\xb4\x09\xf8\xe6\x19\x74\xef\xe6"
+				  "\x26\x0b\x78\x06\x0f\x77\xc6\x57"
+				  "\xe1\x13\x58\xd8\xeb\x5e\xa6\xb9",
+		.ksize		= 1088,
+		.plaintext	= "\x76\x67\xf6\x30\x8a\x58\x2d\xce"
+				  "\xbc\x43\x28\xe0\x51\xc5\x33\x9a"
+				  "\x1d",
+		.psize		= 17,
+		.digest		= "\xb5\x89\xf5\xbc\x4e\x31\x5a\x55"
+				  "\x3c\x37\x54\xdd\x2d\x27\xc8\xdb",
+		.np		= 2,
+		.tap		= { 9, 8 },
+	}, {
+		.key		= "\xab\x34\xab\xa0\x31\x07\xa6\x2d"
+				  "\x1c\x50\x21\x8c\x56\xa6\xa3\x46"
+				  "\x53\x2d\x49\x34\x07\x22\x46\x26"
+				  "\xc2\x76\xe1\xdf\xb9\xf7\xe6\x58"
+				  "\xdc\x9f\x5a\x0a\x51\x3f\xe5\x60"
+				  "\xcf\x29\x24\x92\x7f\x6f\xa3\x0e"
+				  "\x6c\x0d\x02\x54\x81\xef\xeb\x14"
+				  "\x7a\x52\x42\x45\xed\xb9\x32\x85"
+				  "\x07\x1c\x76\x8e\xbe\x81\x5a\xa8"
+				  "\x0b\x81\x83\x88\xe1\xd7\x7e\xd6"
+				  "\xfc\x4b\x70\xef\x3c\xcb\x07\xd4"
+				  "\xc4\xbe\xa0\x7d\x7f\x08\x3c\x31"
+				  "\x49\x93\x13\x70\x0d\xfa\xff\xec"
+				  "\x8c\x1d\x89\xb6\x8a\x46\x33\x01"
+				  "\x53\xe8\x53\xd7\xad\x18\xf5\xc5"
+				  "\x2d\x21\xaf\x8e\x9f\x74\xcc\xb7"
+				  "\x7b\x68\xb6\xf6\x51\x2e\xdf\x7c"
+				  "\x90\x42\x82\xc9\x86\xf4\x6a\x08"
+				  "\xec\x2b\x9e\x7b\xb7\x34\x76\x8e"
+				  "\x5f\xa4\xaf\x14\x94\xfd\x4d\xbf"
+				  "\x63\x35\x15\x0e\xa4\x06\x59\x1c"
+				  "\xf8\x5f\xff\xd1\x98\x34\x59\x1c"
+				  "\x7c\xc7\x34\x35\x61\xde\xb0\x27"
+				  "\x3d\xa9\x04\xca\xdc\xd9\x98\x5e"
+				  "\xd0\x73\xca\xf1\xa7\xd0\x13\x1d"
+				  "\xc7\x54\x9b\x46\x74\x75\x52\xb5"
+				  "\x15\xd1\xe5\xde\xdc\xf4\x7d\x2a"
+				  "\xf7\x66\xfa\xe7\xb7\x0a\xc9\xda"
+				  "\xa1\x54\xf2\x05\x1a\xda\x5b\xcf"
+				  "\xd6\x3e\x83\xb3\x87\xa9\x9c\xa5"
+				  "\x40\xc9\xf8\x9f\xc3\x31\x1e\xf7"
+				  "\x05\xcc\x78\x33\x90\x04\xce\x91"
+				  "\xf7\x41\xa9\x7e\x05\xeb\x0e\x82"
+				  "\xe1\x4a\xdb\xdd\x9c\xda\x94\xd6"
+				  "\x5f\x8a\x2c\x82\xec\xb3\xb5\xab"
+				  "\xe0\xa1\x28\x05\xdf\xa6\x30\xe0"
+				  "\x30\x18\x80\x67\xe5\x5c\x3e\xdf"
+				  "\x91\xf4\x23\xf8\xf7\x6d\xe8\xdc"
+				  "\x9b\x4a\x5a\x8c\xaa\xbb\xac\xc5"
+				  "\x4a\x76\x9f\xe0\x96\x14\x81\xb6"
+				  "\xe8\x15\xae\xbc\xc5\x45\xf1\x97"
+				  "\x35\x65\x53\x88\x7a\x1b\xea\xe6"
+				  "\xcc\x6d\xee\xdb\xf4\x1c\x28\x26"
+				  "\x4c\x08\xdd\x15\xc5\x8b\xd8\xce"
+				  "\xd9\xeb\x06\x12\x8f\x1b\xa4\xd9"
+				  "\xad\x99\xa0\xb3\x9a\x86\xc9\x4e"
+				  "\xd8\x49\xc5\x9f\x3e\x50\x9c\xb3"
+				  "\xdc\xbc\x1d\x44\x9e\x9d\x9c\xe7"
+				  "\x11\xb6\x23\x82\xac\x0e\xb6\xf5"
+				  "\x46\xd5\xfe\xb6\xae\xc4\x2a\x31"
+				  "\x41\xbd\xa7\xc6\x8f\xc6\x1b\x68"
+				  "\xf3\xf7\x4a\x25\xa8\x02\x96\xa4"
+				  "\x00\x79\x73\x8f\x28\xef\x45\x54"
+				  "\xf2\xd1\xcb\xee\x87\x42\x2c\x7d"
+				  "\xcb\xc0\x41\x4e\xe8\xbe\xbb\xb6"
+				  "\x4d\x4b\x08\xf5\x5a\xd1\xfa\x3e"
+				  "\xd1\xa4\xff\x78\x73\x40\x76\x87"
+				  "\x17\x84\x70\x95\x71\xbf\x3c\x83"
+				  "\x30\x48\xd9\x7b\xbb\xac\x94\xbf"
+				  "\x74\x68\xe8\x1b\x82\x19\x90\x5c"
+				  "\x9d\x8d\xc8\xb2\x6c\x89\xa0\x64"
+				  "\xe0\xa5\xa2\x02\x53\xa5\xb3\x83"
+				  "\xec\xd3\xb1\x04\xff\x8a\xc0\xc5"
+				  "\x0f\x6f\x33\xc9\xfd\x0e\xcc\xb6"
+				  "\x2a\x25\xdf\x50\x61\xf1\x97\x45"
+				  "\x14\x22\x62\x70\x86\x68\xda\x6a"
+				  "\x1e\x0b\xae\x75\xe1\xff\x5e\x50"
+				  "\x5b\x16\x29\x8b\xb3\xf1\xc3\x0b"
+				  "\x4c\x85\xaa\x74\xd0\xb1\x62\xeb"
+				  "\xe6\xe1\x7e\x6b\x7c\x56\x30\x2f"
+				  "\x95\x95\xe3\xbd\x58\xca\x48\xcd"
+				  "\x52\xaf\x86\x2d\x7d\x33\xb2\x6c"
+				  "\xa4\x07\x34\x47\xd7\x47\xc6\x3c"
+				  "\x7a\x88\x5b\x11\x80\xc9\xec\x6e"
+				  "\x2f\x10\x11\xdc\xf8\xd9\x2d\x04"
+				  "\x41\xf9\x15\x6e\x94\x59\xba\x92"
+				  "\x1d\xc0\x32\xcf\xfe\xff\x84\x9e"
+				  "\x1e\x01\x91\xa2\x67\x32\x70\xdd"
+				  "\x2b\xcc\x64\x64\x7e\x5e\xf9\x6c"
+				  "\x59\xa9\xa8\xa8\x79\xbc\x75\x46"
+				  "\xc3\x6f\x24\xe6\x51\x90\xac\x23"
+				  "\xbd\xa1\x05\x21\x28\x66\x42\x0e"
+				  "\xc9\x40\xde\xcb\x74\x70\x4c\xd8"
+				  "\x2e\x14\x01\x2b\xcf\x4d\x3f\x28"
+				  "\x9a\x18\x2e\x24\xa9\x21\x78\x01"
+				  "\x9e\xe1\x1d\x24\xc7\x70\xc3\xc2"
+				  "\xfe\xb8\x97\xdf\x04\x4e\x1a\x62"
+				  "\x01\xef\xed\x3f\x20\x95\xf3\x1e"
+				  "\x22\xf7\x35\xbd\x85\xaa\xb2\x13"
+				  "\x27\xfb\xed\xd9\xd4\x39\x67\x47"
+				  "\x40\x7c\x40\x07\x12\x4f\xfd\xe1"
+				  "\x83\x0c\xcc\x0d\xa3\xdc\x3f\x37"
+				  "\x4c\x1e\x52\x2b\x40\x25\x06\x02"
+				  "\xed\xff\xa4\x24\xc5\xcb\x4f\x4c"
+				  "\x97\x02\x70\xd8\x17\x9a\x56\xeb"
+				  "\xa4\xe3\x6a\x02\xd0\xe4\x7f\x97"
+				  "\x24\xc1\x8d\x01\xe7\x7f\x4f\x11"
+				  "\x13\xb7\x48\x1d\x5d\xc8\xe4\x98"
+				  "\x79\x33\xb3\xa2\x58\x0e\x66\x27"
+				  "\x9b\x8d\xe7\xf3\x20\xdb\x7e\x9c"
+				  "\x06\x6b\xa1\x20\x41\x47\x21\x0c"
+				  "\x26\x14\xd6\x5c\xa0\x2b\xb3\x1b"
+				  "\xf8\x0b\x9e\xb4\xff\x65\xf4\x43"
+				  "\x03\xc0\x28\x72\x29\x1b\x63\x26"
+				  "\x88\x82\x5d\x91\xe1\xb8\x86\x94"
+				  "\x54\xb0\xfb\x1f\xd2\x79\x85\xbb"
+				  "\x1c\x6c\x7f\xd0\x8a\x40\xcf\x58"
+				  "\x09\x07\x35\x02\x00\xfa\x06\x31"
+				  "\xc4\x76\x69\xc9\xd3\xd6\x42\x49"
+				  "\x95\x1d\x19\x97\x4a\x10\xec\x1b"
+				  "\x9f\x3f\x60\xc2\xed\x07\xd6\x9d"
+				  "\xde\x1a\xee\x81\x63\xab\x2a\x8f"
+				  "\x66\x5d\x65\x15\xbc\xf8\x12\x3b"
+				  "\xa7\x14\x52\x74\x76\xd8\x81\x85"
+				  "\x8d\xc6\x66\x5b\xa4\x81\x90\x1e"
+				  "\x1b\x1a\x38\x85\x16\x89\xd7\x69"
+				  "\x69\xad\x5f\x29\x6c\x67\xbe\xe0"
+				  "\x8b\x92\xae\xfc\x26\xea\x82\xaf"
+				  "\x4d\xb7\xdc\x45\x77\xd6\x8b\x86"
+				  "\x2e\x43\x6e\x50\x24\x2e\x51\xb7"
+				  "\xab\xb5\x18\x01\x64\xc7\xe7\xec"
+				  "\x02\x34\x28\xd5\xe6\x9b\x53\x38"
+				  "\x49\xfc\x6b\x1d\xbe\x85\xfd\x12"
+				  "\x9f\x0c\x0d\x5a\xe5\xee\x22\xca"
+				  "\x6b\x4e\x30\xae\x64\x17\xe8\xac"
+				  "\xce\x55\x16\x09\x65\x0e\x4d\xd3"
+				  "\xd5\x8b\xf5\xdc\x1f\x4f\x98\x79"
+				  "\x07\x00\x35\xfd\x29\x6c\xd0\x2e"
+				  "\x98\x06\x83\x4a\x2c\xa4\x91\x0a"
+				  "\x1c\xd2\x6e\xac\xec\x3f\x1b\x23"
+				  "\xa0\xfa\x46\xd7\x4a\x7f\xa5\xb4"
+				  "\xde\x79\x69\xaf\x3a\x5f\x34\x65"
+				  "\x72\xa1\xdb\xa3\xdc\x3f\x92\x94"
+				  "\x06\xbe\x36\x86\xa6\xf6\x6a\x77"
+				  "\x8e\xb3\x20\x0c\x04\xfc\xf1\x9f"
+				  "\x69\x5b\xba\x57\x47\x9c\xfc\x8e",
+		.ksize		= 1088,
+		.plaintext	= "\x7b\x37\xbf\xa5\x34\x07\x47\x89"
+				  "\x82\xec\x6c\x88\x81\x2d\xb2\xc0"
+				  "\x7e\xff\x8f\x58\xd1\xd4\x49\x0f"
+				  "\x6d\x0f\x0f\x82\x3f\x75\x15\x69"
+				  "\x88\x1e\x21\xea\x8f\x52\x92\xf6"
+				  "\x24\x61\xdc\xa7\x00\xc7\x7d\x43"
+				  "\x48\xe0\xed\xf6\xc4\x8f\x2f\xc1"
+				  "\xc7\x5e\xc2\xd0\x96\x28\xe7\xf3"
+				  "\x69\x5d\x66\x8d\xad\xcb\x06\x23"
+				  "\x5a\x64\x83\x6b\xfb\xa4\xd7\xb9"
+				  "\x43\xf0\xaa\x63\x0a\x55\x82\x8e"
+				  "\x85\xd1\xf8\x35\x31\xa5\xae\x03"
+				  "\xbc\x9f\x39\x93\xcf\xcb\x52\xbd"
+				  "\xcf\xbb\xec\x59\xc6\x35\xfc\xe6"
+				  "\x45\x51\x4c\xa6\x66\x09\xb6\x2f"
+				  "\x34\x2c\x2c\xaf\xe3\x9b\x2c\x75"
+				  "\xd0\xcc\x69\x6f\x22\x65\x38\x65"
+				  "\x6f\x36\xb0\x27\x09\x16\x5b\xb1"
+				  "\x09\xd2\x77\x45\x5f\x9d\x3f\xe0"
+				  "\xd0\xda\x8d\xb9\xf3\x63\xd7\xa2"
+				  "\x80\xc3\x90\x38\x5a\xaf\x90\x78"
+				  "\x26\x8a\x7d\x86\x56\x53\x4c\x9c"
+				  "\x69\x3a\x13\x93\xa5\x00\x1b\xc1"
+				  "\x99\xcb\xdd\xdc\x2f\x30\x47\x4b"
+				  "\xef\x0e\x1b\xfd\xa2\x70\x74\xfd"
+				  "\x99\x54\xe3\x0f\x63\x9d\x46\x5e"
+				  "\xf1\x84\xf8\x6b\x89\xb0\xee\x4c"
+				  "\x50\x98\x80\xda\xa4\xb1\x75\xd5"
+				  "\xb5\xc5\xe3\xbe\x55\x20\xf8\x18"
+				  "\xd4\x95\x47\x62\x05\xb8\x2b\x90"
+				  "\x87\xbe\x01\x78\x3d\x0a\xc4\x34"
+				  "\xea\x99\x19\x9a\xda\x3c\x4c\x10"
+				  "\x29\x33\xe9\x7c\x75\x7c\x79\xa4"
+				  "\x4a\xdc\x53\x22\xaa\xca\x50\xc2"
+				  "\xac\xa3\xc2\x8d\xc8\x23\x42\xf5"
+				  "\xce\xe9\x9d\x33\x95\x37\xe4\x94"
+				  "\xc7\x62\x51\x0e\xdd\x2e\x47\xdd"
+				  "\x2c\xe1\xd6\xbe\xb7\xbd\x2d\xcd"
+				  "\xc8\x80\xda\xa0\xa3\x2d\x5a\xfb"
+				  "\x52\x5d\x0c\x38\xd2\x19\x02\x9b"
+				  "\xf8\x5d\xe7\x1c\x74\xbc\xe5\x3b"
+				  "\xbf\x53\x0b\x9b\x6d\xdd\x1a\x62"
+				  "\x2c\x12\x2e\xac\x1c\x10\x16\xa1"
+				  "\x6c\x02\xff\x9e\x89\x0a\x3f\xf1"
+				  "\xec\x6d\x3a\x38\x63\x0c\x8a\xc5"
+				  "\xd6\x9e\x19\x89\x2e\x03\x70\x83"
+				  "\xa9\x1a\x2d\x90\x5a\x4a\xc1\xad"
+				  "\x94\x40\x80\xb6\xed\xf1\x12\x3a"
+				  "\xa4\x0d\xff\x14\xff\x8a\x70\xce"
+				  "\x59\xfe\x6a\x1f\xfe\x75\xd5\xf9"
+				  "\x0d\xe0\x69\x14\x23\x26\x2c\xf5"
+				  "\x92\xac\x59\x1f\x0f\xc1\x1e\xdc"
+				  "\x75\xc0\x51\x5e\x9b\x20\x40\x9d"
+				  "\xab\x1a\x86\x5c\x4e\xa6\x96\x00"
+				  "\xa8\x83\x6f\x83\x6a\x85\x9d\x31"
+				  "\xcd\x74\x2c\x2f\x2f\x80\xf3\x33"
+				  "\x8b\x2b\x75\xc9\xc9\x00\xfd\x9d"
+				  "\x29\x2b\x9b\x8e\xf1\x90\x9d\xa6"
+				  "\x4f\xd6\x59\x22\x55\x43\x73\xe7"
+				  "\x3e\xe4\xdc\x95\xcf\x44\x76\xdb"
+				  "\x2d\xb2\xde\x6f\x06\x42\x53\x25"
+				  "\xe5\x90\xa8\xfe\xe8\x72\xea\x7a"
+				  "\x4e\x6d\x31\xe4\xdb\x1a\x5f\xa7"
+				  "\x52\x99\x46\x43\xaf\xda\x97\xd2"
+				  "\x81\xa2\xa1\x6e\xbc\x22\x08\x99"
+				  "\x42\xd7\xed\x8e\x9b\x80\xc0\xe4"
+				  "\x15\x88\xf2\xa4\xd5\xac\xb4\x8e"
+				  "\xc5\xf9\x18\xbf\xdf\xb1\xd7\x86"
+				  "\x0e\x6e\x8e\xd7\x98\x7c\x93\x46"
+				  "\x37\x85\xa8\x8e\x96\x0d\x95\x5f"
+				  "\x0e\x19\xcf\x24\x08\x3f\x0d\x55"
+				  "\x34\xf8\x3a\x8a\x9e\xfc\x0c\xad"
+				  "\x87\x9d\xf6\x49\xfc\xa6\x7b\xc0"
+				  "\x69\x0f\xd1\xc1\x50\xbe\x41\xb0"
+				  "\x76\xc3\xec\x8d\x0b\x2f\xfe\xc6"
+				  "\xf6\x5f\xd0\x25\xfc\x8f\x84\x9c"
+				  "\x91\xed\xc1\xaa\x1f\xea\xea\x31"
+				  "\xb9\x04\x3a\xd8\x78\x02\x6d\xcc"
+				  "\xa1\xdb\x8c\x07\x73\xf5\x73\xb1"
+				  "\x58\x10\x67\x11\x65\x06\x13\x14"
+				  "\xa7\x17\x77\x1e\xf8\x0c\xdf\xf6"
+				  "\x5d\xa8\x0c\xcf\x7f\x80\xa8\x40"
+				  "\x2b\x0e\xb0\x05\xb4\x9a\x79\xba"
+				  "\xf5\xed\xed\x5f\x39\xe8\xf8\x68"
+				  "\x82\x47\x14\x48\x1f\x06\xcf\x44"
+				  "\xed\x5b\xf1\xd6\xfb\x5d\x4a\xb4"
+				  "\xcf\x6e\x31\x0d\xb1\x8a\x31\x5c"
+				  "\x4e\xea\x33\x2f\xc9\x22\x96\x72"
+				  "\xdf\x7d\x2f\x98\x1f\x11\x45\xcd"
+				  "\xd3\x71\x96\x71\x60\xab\x98\x5d"
+				  "\xed\xb5\x35\x99\x6f\xe8\x43\xa5"
+				  "\x28\xe9\xc3\x30\xd2\x8d\x79\xf2"
+				  "\xad\x80\x5a\x88\xcb\x96\x3d\x66"
+				  "\x7c\x4b\x18\xd3\xe7\x12\xb5\x25"
+				  "\x98\x5e\x35\xeb\x37\x80\x51\x9f"
+				  "\x9c\x4d\x78\x9a\x79\x21\x97\x82"
+				  "\xa5\x14\xd3\xe5\xcd\xba\x9b\x25"
+				  "\x44\x68\x1e\x63\xe2\x06\x47\x52"
+				  "\xb3\xdc\xb6\x2f\x8b\xa0\x69\x49"
+				  "\x04\xf0\x5d\x5f\xf5\x22\xf0\x28"
+				  "\x69\x66\x8d\x13\xc3\x0c\xab\x77"
+				  "\xa6\x8f\xd7\xb8\x35\x28\x96\xf9"
+				  "\x0b\x16\xf6\x96\x21\xed\x49\xa2"
+				  "\x81\xf5\x8a\x27\x8e\x8a\xaa\x01"
+				  "\xb3\x6f\x30\x4e\xc7\xca\x47\x75"
+				  "\x44\x50\x5c\x54\x2d\x3d\x45\x2f"
+				  "\xa6\x2a\xd5\x4e\xf8\x81\x0b\x5e"
+				  "\xbb\x9d\xd2\x66\x41\x64\x52\xf9"
+				  "\x6f\xe2\xaf\xfe\xef\x16\x02\xcb"
+				  "\x65\x00\xee\x78\xe8\x3f\x64\x79"
+				  "\x00\x2e\xe0\x58\x0f\xf2\xf9\x7e"
+				  "\x6e\xe3\x8e\x08\x54\x52\x6a\xdb"
+				  "\xf0\xaa\x6a\xbf\xe2\xa1\xe3\x28"
+				  "\x49\xc7\x9f\x20\xde\x39\xb0\x4c"
+				  "\x75\xd0\x44\xbf\x4e\xf7\x59\x9c"
+				  "\x3b\xfb\x24\xce\x09\x6b\x4d\x82"
+				  "\xe3\x55\x02\x04\x94\x47\xa6\x07"
+				  "\x3e\xe7\x60\xe4\x99\x79\xaf\x43"
+				  "\xbf\x59\x5d\x3b\x1e\xe3\x33\xbb"
+				  "\x87\x0c\x50\xf0\xa3\x86\x1a\xf1"
+				  "\x35\xe2\xd0\x0a\xd3\xf7\xdb\x3a"
+				  "\xc4\x1b\x3a\x06\xf4\x84\x70\xa8"
+				  "\x87\x2e\x9c\x63\x6f\x6f\x7d\xa0"
+				  "\x9f\xd8\x97\xd7\xeb\xde\x89\xed"
+				  "\x87\xb5\x68\x5a\x87\x9c\xfb\x55"
+				  "\xad\x0c\xc1\x18\x13\xb4\x5a\x8a"
+				  "\xcf\x81\x2d\x71\x87\xe0\x34\x31"
+				  "\x65\xb4\x8e\xa7\x44\x21\x75\xfd"
+				  "\xf4\x62\xd1\x40\xd3\x53\xaf\x31"
+				  "\x67\xd8\x03\xd5\xd1\x3d\xce\x28",
+		.psize		= 1040,
+		.digest		= "\xe3\x65\xd8\x92\x82\xaa\x80\x1f"
+				  "\x06\xe7\xc3\x52\x6f\xb5\x92\x25",
+		.np		= 5,
+		.tap		= { 255, 255, 255, 255, 20 },
+	}, {
+		.key		= "\x62\xac\x75\xc0\x93\x67\x2d\x2a"
+				  "\x52\xce\x18\x9b\x87\xff\x13\xfb"
+				  "\xd3\x6c\xfd\x2b\x07\x3e\xda\x28"
+				  "\x6f\x07\xe3\xdd\x00\x4a\x8a\xff"
+				  "\x3b\x03\x2d\x34\x3e\x04\x20\x06"
+				  "\x41\x04\xaf\x3b\x93\x7e\x60\x13"
+				  "\xd3\x71\xfa\x9d\xe3\x05\xeb\xad"
+				  "\x31\xf9\xdb\xe0\x52\x45\x90\xbf"
+				  "\xbd\xac\x1e\x89\x6a\xa0\xe5\xda"
+				  "\x60\x79\x44\x06\x3c\xf5\xe4\x50"
+				  "\x32\x33\x27\x1a\x9c\x66\x27\x40"
+				  "\x2b\x57\xf2\xf2\xdc\xc5\xed\xa2"
+				  "\xd8\x7e\x3b\xa5\xba\xd1\x0a\x76"
+				  "\x05\x82\x6e\xdd\xb8\x9c\x56\x56"
+				  "\x3d\xc0\xde\x12\x6f\xa5\x7a\xb1"
+				  "\xfa\xec\xf2\xbd\x65\x6c\x1b\xf5"
+				  "\x1b\xc2\x65\x95\x37\x1d\x6e\x7c"
+				  "\x10\x7f\x21\x67\x1a\x34\x13\x19"
+				  "\xa7\x2f\xb0\x39\xa0\x0c\x83\x10"
+				  "\x74\x97\xee\x3d\x01\xc7\x40\xbf"
+				  "\xed\x9d\x79\xaa\x40\x7b\x00\x1e"
+				  "\x42\xbf\x9a\x93\xc8\xbc\x63\xbb"
+				  "\x0a\x03\x54\x04\x41\x50\xc9\x1a"
+				  "\xbc\x87\x21\x5f\x7f\x06\x4f\x42"
+				  "\x8a\x70\x8d\x51\x62\x38\x83\x36"
+				  "\xe7\xe2\xe2\x18\x19\xb8\xda\xa5"
+				  "\xf6\x33\xaa\xfc\x99\x78\xf5\x63"
+				  "\x36\x40\x98\xb8\x0e\x2d\x29\xe4"
+				  "\x86\xa9\x06\x53\x00\xd9\x09\x04"
+				  "\x86\x61\x0f\x62\xf7\xcb\x81\x57"
+				  "\x22\x2f\xd3\x82\x2e\x74\xb1\xf0"
+				  "\xcd\x6d\x18\x2d\xc7\x09\x5b\x08"
+				  "\x4b\x0f\x43\xc7\x6c\xb1\xe5\x26"
+				  "\xe8\x35\x56\x47\xd2\x82\x12\xd7"
+				  "\x24\xbd\x87\x11\x7b\x6a\x5d\x99"
+				  "\xf0\x82\xe8\x92\x40\x33\x5a\xb4"
+				  "\x5a\xd8\xb6\xe9\xf7\x9a\xac\x10"
+				  "\x3f\x8c\x55\x2f\xc7\x16\x63\x95"
+				  "\xe6\xe8\xfb\xb4\x1f\x0a\x03\xf7"
+				  "\xf6\x21\xc4\x99\x72\x04\x12\x91"
+				  "\x33\x10\x15\xf3\x42\x02\x97\x5b"
+				  "\xd5\x65\x3d\x8d\x13\xc3\x88\xee"
+				  "\x9c\xfc\x5b\x3b\xc1\x99\x3c\x9c"
+				  "\x62\xd8\x78\xa8\x8e\x32\x51\xc0"
+				  "\xa9\xe6\x38\x2d\x6f\x34\xd2\x06"
+				  "\xf1\xa2\xf4\x2b\x84\x1a\xb5\x48"
+				  "\x3f\x51\x85\xe6\x89\x2d\x12\x3d"
+				  "\x97\x16\x01\xc6\x30\x8c\xca\x57"
+				  "\x64\x68\xd2\x65\xd0\x19\xb3\x5d"
+				  "\xa1\x93\x8b\xa2\x0e\xfe\x0f\xf7"
+				  "\x59\x1e\x93\x4b\x26\x72\xaf\x30"
+				  "\x9f\x32\x33\x49\xac\x3c\xb6\x48"
+				  "\x77\x5f\xf7\xbe\x46\x20\x9f\xa5"
+				  "\x42\xab\x45\xff\xf1\xe3\xa9\x64"
+				  "\x47\x47\xfe\xb1\xd2\xd7\x0e\xf7"
+				  "\x68\x54\x3d\x51\x44\xb4\x67\x6f"
+				  "\xdf\xc0\x75\xd4\x42\x78\x55\x27"
+				  "\xc6\x3b\x51\xbf\x6c\xee\x97\x4d"
+				  "\x32\x4f\xd5\x0a\xec\x8a\xc1\xb3"
+				  "\x0c\xd0\xeb\xc0\xda\xf1\x46\x55"
+				  "\x66\x25\xd7\x1f\x71\x4d\xc6\x35"
+				  "\x43\xb6\x82\x6a\x43\xe8\xb9\x85"
+				  "\xb9\x1c\x95\x24\x4d\x98\xf4\xf5"
+				  "\x78\x47\x74\x64\xac\x7c\x1b\xe6"
+				  "\x31\x58\xc4\x67\x5b\x40\xbc\x8a"
+				  "\x15\x6a\x6a\x71\x97\x14\xa2\xb5"
+				  "\xc6\x45\xab\x90\xeb\x6d\xac\x54"
+				  "\x82\xc8\x19\xc5\x53\x35\x0a\xae"
+				  "\xa9\x99\x27\x46\x50\x17\xeb\x7c"
+				  "\x13\x2d\xa5\xd9\xf3\x91\xda\x20"
+				  "\x94\x2e\x24\x90\x8c\x0c\xe8\x3d"
+				  "\xbf\xed\xf7\x75\x05\x08\x9b\xb4"
+				  "\xbc\xa4\x95\x1a\x3e\x8f\xb2\xfb"
+				  "\x6a\xa9\x0d\x1f\x91\x57\xd4\x35"
+				  "\x11\xfd\x23\x3b\x3f\x9d\x76\x9d"
+				  "\xc5\xb1\x94\x9a\x85\x00\xcc\x24"
+				  "\x89\xe1\x64\xe1\x25\x95\xd6\xf2"
+				  "\xfb\x12\x58\x1f\xab\x60\x78\x0b"
+				  "\xd7\xb7\x87\xe2\x08\xab\xf5\xc4"
+				  "\x6b\x69\xa3\x65\xc8\xe7\xce\x3c"
+				  "\x8d\xbb\x34\x32\xf7\x5d\x3e\x49"
+				  "\x63\x7b\xe2\x86\xf5\x9b\x6e\xbc"
+				  "\x4c\x32\x02\x51\x6f\xc0\xef\x45"
+				  "\x91\x05\x5f\xdc\xfa\x63\x62\xa1"
+				  "\xcf\xb0\xb4\x66\x4f\xca\x7a\x84"
+				  "\xa7\xb3\x8c\xc1\xa1\x5e\xd2\x66"
+				  "\xc3\x11\x9c\x1f\xf4\xa4\x91\x55"
+				  "\x1c\x7e\x56\x85\xc4\x85\x7f\xfe"
+				  "\x26\xce\xc2\x5a\x38\x3d\x91\x29"
+				  "\xeb\xde\xce\x46\xdb\xf6\xa1\xf3"
+				  "\x24\x71\xab\x98\x7b\xb9\x61\x89"
+				  "\xe5\x33\x59\x93\xc5\x35\x60\xf1"
+				  "\xbc\xc0\x6c\xe6\xa3\x24\xea\x11"
+				  "\xc3\x73\x53\x01\xc0\xb6\xe5\x7a"
+				  "\xd7\xfc\x3d\xe9\x9d\x90\x0c\x0b"
+				  "\x21\xf1\xc2\x9d\xef\x6b\x2c\xd2"
+				  "\xe4\x9a\x5a\x6e\x34\x8e\x5d\x59"
+				  "\xf9\x95\x21\x7a\x2c\x60\x3c\x8b"
+				  "\x76\x26\x0e\x8e\x18\x78\x7a\xd6"
+				  "\x50\xe4\xf3\xaf\xa8\x54\x42\x59"
+				  "\x50\x61\x7f\xe3\xb9\x37\x20\xad"
+				  "\xb4\x5b\x5a\x8a\xa3\x64\x88\xb0"
+				  "\x36\xf4\x6e\xfd\x94\xca\x31\x13"
+				  "\x77\x09\xc9\x9d\x49\x7c\x55\xe6"
+				  "\x70\x7d\x23\xd5\x95\xa9\xf9\xdb"
+				  "\xad\xd4\xb8\xd0\xee\xd1\x3f\x48"
+				  "\x5e\x76\xca\xdf\xd6\x80\x06\xfe"
+				  "\xf1\x6c\xa3\x7c\x3e\xc7\x71\x32"
+				  "\x4f\x97\x6a\x95\xa2\xff\x73\x57"
+				  "\x02\xd0\x67\x0c\x8d\x87\xe1\xc3"
+				  "\xb6\x5c\x53\xcb\x64\xd9\xfc\xd3"
+				  "\x92\xb4\xe2\x9d\x7a\x1e\x79\xce"
+				  "\x26\xb6\x5e\xfe\x8f\x3f\xda\x06"
+				  "\x9a\xb6\xbf\xb0\xce\xc9\x1e\x78"
+				  "\x9c\xe4\x7a\xfa\x96\x66\x71\x3c"
+				  "\xf9\x40\xa5\xfe\x6c\x11\x31\x56"
+				  "\x88\x41\xa6\xa7\xda\x9c\x88\xd5"
+				  "\x10\xdd\xf5\x06\x1d\xf9\xdd\x25"
+				  "\x60\x98\x76\x39\x15\x53\x89\xf1"
+				  "\x3d\x35\xb2\x6d\x56\xdb\xe5\x41"
+				  "\x0c\x8b\x1b\xb4\x25\xbc\xdd\x0f"
+				  "\xdc\xfd\x22\x8e\xa6\xf6\x96\x53"
+				  "\x4d\x58\x9f\x4e\xc6\x3b\x5c\xe3"
+				  "\xf3\x97\x23\xbc\x80\x13\x2b\xe1"
+				  "\xf8\x3e\x9a\x89\xf8\xe4\x21\xd6"
+				  "\x9d\x17\xec\x84\x0f\xc7\xb5\xc7"
+				  "\x41\xbe\x69\x92\x9a\x9f\x0a\xba"
+				  "\x9b\x41\xcb\x29\x35\x01\x34\x04"
+				  "\xa9\x24\x14\xef\xd6\x62\xf7\xb0"
+				  "\x4a\x34\x9b\x70\x73\x65\x07\xf2"
+				  "\xff\x8e\xfb\x70\xc3\x57\x8a\x8e"
+				  "\x3f\x49\x89\x63\x9b\x05\x2e\x19"
+				  "\xb9\x90\x51\x9b\xf1\xf3\x79\x83"
+				  "\x4b\x6c\xfc\x95\x36\x69\x06\x84"
+				  "\x36\x91\x8b\x5e\x4b\x55\xb2\x29"
+				  "\x23\x6b\xb6\x5f\xea\x14\x38\x52",
+		.ksize		= 1088,
+		.plaintext	= "\x09\xbb\x1a\x67\xf3\xd2\x7f\x84"
+				  "\x1b\x5f\x1a\x4d\xca\xe3\xea\x9f"
+				  "\x9d\x73\x74\x74\x07\x52\x2e\x7e"
+				  "\xfe\xee\x76\x98\x57\x74\xfd\x8a"
+				  "\xfd\xa6\x24\x5c\x40\x4e\x9a\x92"
+				  "\xae\x53\x1b\x55\x98\x78\xfc\x58"
+				  "\x22\x1d\xb3\xdb\xc8\xf2\x72\xfa"
+				  "\x42\x19\x8e\x5e\xbc\xad\xa3\xbd"
+				  "\x2f\xaf\xb9\xa7\x4f\x81\x17\x93"
+				  "\xb4\x50\xfc\xe3\xd4\x8e\x05\xd3"
+				  "\xa7\x13\xa4\x38\x78\x9f\xd3\xe4"
+				  "\x4d\x36\x60\xb4\x9c\x77\x54\x9e"
+				  "\x88\x3a\xe8\x4c\x02\x53\x0b\x35"
+				  "\x15\x36\xe9\xe7\x6e\x3a\x3c\x64"
+				  "\xef\xe3\x41\x01\x4c\xa7\xf9\x76"
+				  "\xab\x8b\x5b\x04\x3f\x3e\x72\x8d"
+				  "\xd3\xf1\x5f\x8f\x31\x2a\xd7\x75"
+				  "\x1e\x4c\xe8\x7d\x56\x8a\xb8\x9c"
+				  "\xf5\x00\x1f\x9c\x3c\xe6\x4b\x88"
+				  "\xb3\xb6\x99\xc8\x3d\xae\xf4\x24"
+				  "\x19\xff\x7e\x0e\x18\x6d\x2e\xf9"
+				  "\xe1\xc0\x45\x37\xbd\x88\x61\xbe"
+				  "\x3b\x53\x1c\xd7\x31\x85\x1a\x7a"
+				  "\x5a\x91\x1e\xde\xb2\x4a\xd8\x5c"
+				  "\xe7\x08\x2f\x93\xae\x35\xa9\x9a"
+				  "\x34\x8a\x8a\x35\x54\x81\x6f\x80"
+				  "\xd0\x9e\xfb\xb6\xfd\xd9\xc1\x63"
+				  "\x83\x7e\x68\x81\xe6\x8f\xfd\xd0"
+				  "\xab\xeb\x32\x64\xf8\x6b\x55\xbc"
+				  "\xe9\x90\xe4\xc9\x1b\x5e\x5f\xa7"
+				  "\xb1\xb2\x81\xdc\xcd\x07\x35\x95"
+				  "\x2f\x57\x31\x9f\x63\x23\xae\x08"
+				  "\x35\xcd\x7b\xd2\x0f\xf5\x4f\x6a"
+				  "\xa0\xd9\x8f\xc9\x4b\x8d\x2f\x37"
+				  "\xfb\xe8\x0e\x44\x2c\x29\xa3\xc4"
+				  "\x10\x3f\xd1\xea\xb4\xc5\xcb\xb5"
+				  "\xc3\x1d\xa9\xd2\x20\x10\x10\x87"
+				  "\xbe\xf6\x1f\xad\xde\xa5\xd3\xd6"
+				  "\x05\x52\x96\x1c\xfa\x9b\x43\xdd"
+				  "\x3e\x18\xfb\xc3\xfa\x4c\x42\xfe"
+				  "\x67\x66\x0f\xbe\x51\xc2\x54\x45"
+				  "\x28\xb0\x9c\x3f\xa7\x29\x8a\x61"
+				  "\x49\xb4\xad\x08\x4b\xc1\xfe\x89"
+				  "\x62\x3e\x77\x5e\x63\x91\xc0\x18"
+				  "\xc7\xd0\x17\x63\x2d\x29\xf8\xa5"
+				  "\xab\xef\x6f\xfe\x07\x36\x70\x7b"
+				  "\xf2\xd6\xf7\x18\xa9\x8b\xfd\x84"
+				  "\x09\x67\xf4\x36\x76\x46\x12\x43"
+				  "\x46\x1b\x16\x66\xb8\x14\x1a\x1c"
+				  "\xe1\xe3\xd1\x96\xb9\x08\x1d\xdd"
+				  "\x9a\x48\xc3\xe0\xc4\xd0\x67\x9c"
+				  "\x2f\xc8\xbe\x20\xb7\x3e\x74\x72"
+				  "\xec\x49\x42\x14\x9a\x83\xc2\x54"
+				  "\xd6\x22\x1e\xd8\xf2\x26\x5a\x21"
+				  "\x11\x4f\x53\x96\x60\xc9\x83\x03"
+				  "\x41\x8b\x71\xdd\x3f\xf9\x8e\x8c"
+				  "\xdd\x10\x43\x60\x45\xba\xb2\xe2"
+				  "\x91\xa1\xce\x43\xa2\x4e\xcc\xf2"
+				  "\x52\x5a\x22\x48\x77\x96\x12\xd0"
+				  "\xee\x2d\x96\xee\x36\x4d\x1c\x1f"
+				  "\xcb\x5f\xb0\xfd\x3b\x30\x9a\xba"
+				  "\xa7\xc9\x8e\xcc\x2e\x75\xa3\xc9"
+				  "\xd3\xf7\x0a\x72\xa2\x52\x5a\xdf"
+				  "\xfc\xd1\x10\x54\x1d\x59\xbb\xcc"
+				  "\x2a\x0b\x56\x4f\xbb\x9c\x1d\xad"
+				  "\x3b\x49\x51\x32\x6e\xa3\x11\xa8"
+				  "\x46\xca\x54\xc2\x57\x26\x0b\x77"
+				  "\x9d\x80\x53\x2d\x2d\x56\xba\xdc"
+				  "\x38\xe6\x6d\xe9\xbe\xa2\x2b\x61"
+				  "\x4c\x60\x5a\x2f\x5c\x1a\x22\x7a"
+				  "\xbe\x3c\x03\x90\x6d\xf6\x78\x9c"
+				  "\xaa\x79\xa5\xb0\x00\x96\xc9\xba"
+				  "\x87\x7a\x16\x17\x44\xa0\x2a\x3a"
+				  "\x02\x73\x35\x21\xe4\xeb\x30\x61"
+				  "\x94\xd0\xd9\xf3\x9f\x64\xae\xb9"
+				  "\x05\xab\x39\x01\x18\x2f\x3f\x50"
+				  "\x56\x4f\x5e\x22\x4f\x20\x94\xa0"
+				  "\xab\x6b\x69\x75\x8f\x69\x3d\xdd"
+				  "\x87\xbf\xed\xbd\xa8\xb4\x37\x61"
+				  "\x90\x57\xeb\x64\x8e\x47\xca\xb2"
+				  "\xff\x65\xb9\x82\x17\x2d\x63\x65"
+				  "\x40\xc3\x91\x0f\x13\xc8\xa7\x24"
+				  "\xfc\xc9\x7e\x16\xb4\x79\x37\x87"
+				  "\xf9\x64\x19\x59\x38\xc2\xbf\x17"
+				  "\x4a\x84\xb7\xc5\x2d\xeb\x7d\xa8"
+				  "\x0b\xa5\x94\xfb\x1e\x4b\x1d\x62"
+				  "\x85\x89\x4d\x85\xdf\x05\x23\xd2"
+				  "\x3f\x46\x47\x97\x4e\x5e\xd0\x81"
+				  "\xf7\x4f\xc9\x2a\x3a\x67\x0f\x36"
+				  "\x96\x2e\xa3\xe1\x76\xb3\xe5\xd2"
+				  "\x21\xa5\xec\x6f\xea\x01\xfb\x27"
+				  "\xe6\xa3\x6c\x33\x88\x33\x08\xf6"
+				  "\xdd\x71\x77\x90\x8b\x45\x23\xa3"
+				  "\x23\xc2\x33\xf4\xd6\xb5\x8f\x9e"
+				  "\xa1\x4d\xf7\x4e\xb9\xf7\xc3\xd1"
+				  "\x36\xfa\xc0\xda\x33\x05\xf6\x7d"
+				  "\x19\xae\x63\x5b\xce\xe2\x3a\xbe"
+				  "\xc6\xa7\x19\x5f\xbf\x7d\xfa\x64"
+				  "\x5f\x81\x00\xb0\xb8\x56\x46\x21"
+				  "\xc6\x81\x6e\x0e\xb6\x0f\x06\x74"
+				  "\xfc\x9e\x94\xa5\xf1\x48\x59\x82"
+				  "\x6e\x4b\x8f\xc0\xdc\xbb\x36\xe4"
+				  "\xad\xdf\xcc\x26\x90\x3d\xe0\xb5"
+				  "\x86\xa0\x25\x52\xea\x3d\x15\xa5"
+				  "\x35\xa5\x01\xdf\x6b\xdb\x0e\x4e"
+				  "\x28\x39\x6c\xba\x5d\x2b\xa3\x9e"
+				  "\x2d\x7f\x04\xde\x2b\xb4\x9d\x2d"
+				  "\xbc\x92\x65\xd7\xa4\x53\xa7\x72"
+				  "\xa7\x0a\x02\xb4\x4d\xbd\x46\xf5"
+				  "\x78\x1d\xb4\xf2\xd0\x8c\x2a\x7b"
+				  "\x36\xf7\xc8\xdf\x99\x3d\xe9\x52"
+				  "\x96\x2f\x08\x7f\x27\x9c\x5a\x15"
+				  "\x3d\xa3\x15\x24\x3b\xf8\xcc\xed"
+				  "\x63\x3b\x7a\x1e\x8e\x11\x13\xae"
+				  "\xc4\x7a\xb6\x7f\x24\xe4\x90\x5f"
+				  "\x84\xd4\x77\xa4\xa4\xf7\xac\xeb"
+				  "\xdd\xdd\x12\x33\xbf\x4f\x1d\xee"
+				  "\x89\x62\xba\xe1\xa0\xb3\x81\xa4"
+				  "\xf2\x0e\xd2\x39\xfc\x28\x7f\x03"
+				  "\x24\xcd\x57\xc9\x66\xa5\x8e\xf9"
+				  "\xf2\xa9\x36\x7a\x05\x51\x45\xa5"
+				  "\x55\xbb\x31\x1d\xef\x3b\x5e\x94"
+				  "\x93\xc9\x63\x24\xc2\x88\xbd\xbc"
+				  "\xd5\x9c\xcd\x6f\x40\xf1\x1e\xe2"
+				  "\xb6\x9e\x79\xf0\xec\xd1\x4c\x75"
+				  "\x5e\x81\xb6\xfe\x44\x90\x78\x98"
+				  "\x31\x8f\xb3\xba\x57\x3f\x78\x34"
+				  "\xca\x81\x20\xa9\x64\x0f\x0a\xdb"
+				  "\xd3\x3d\x82\xe2\xa9\x57\xbb\xd9"
+				  "\x0f\x65\xcc\xda\x2f\x17\x5e\x14"
+				  "\x86\x3c\xe9\xe4\x00\x65\x1e\x77"
+				  "\x5f\x59\x0d\x49\xf3\xbf\x57\xf6"
+				  "\x7b\x0f\x42\xdf\x94\x5a\xd4\x77"
+				  "\xfd\x8f\x76\x1c\xb3\x28\xa4\x8c"
+				  "\xf6\x52\xc5\x0f\xda\x53\x48\x48"
+				  "\xb5\x28\xfa\xb2\xf5\x56\x81\x7b"
+				  "\xb6\x9a\xc0\xb8\xc1\x3c\x78\xf3"
+				  "\xff\x75\xb6\xcf\x9b\x26\xe5\xfa"
+				  "\x02\x6c\xb8\x73\xc7\x35\x8c\x87"
+				  "\xe1\xf1\x99\x99\xf3\x2d\xd4\x2e"
+				  "\xe7\x2f\xaa\x26\x50\x2e\x54\x2f"
+				  "\xd0\x4c\xf8\x7b\x30\x45\xfb\x2e"
+				  "\x66\xc8\x03\xc1\x87\x77\x77\xae"
+				  "\x14\x75\x01\xe2\x55\xbf\x96\xe5"
+				  "\x44\x08\xe8\x75\x47\x31\x71\x6a"
+				  "\x27\xe6\xd9\x6c\x30\x37\x43\x34"
+				  "\xfb\x31\xab\x2c\xcc\xed\x1c\x4f"
+				  "\xd2\xf0\x6c\xd7\xdc\x0d\x97\x2a"
+				  "\x3d\x9d\xf5\xb7\x96\x0a\x8b\x24"
+				  "\xf5\x77\x26\xaf\x99\x65\x9c\x2f"
+				  "\xfa\x82\xc4\x47\x70\x69\xce\x93"
+				  "\x1f\x0d\xa0\x14\xbb\x5b\xaa\x45"
+				  "\x49\x7f\x2c\xba\x97\xce\x0a\xe4"
+				  "\x4d\xf5\xf0\x43\xed\xf2\x0f\xcd"
+				  "\x44\x14\xc1\x05\x2a\xd6\x39\xf2"
+				  "\xdb\xcb\x1b\x91\x08\xc7\x35\x3e"
+				  "\xb4\x8a\x99\x2a\xb4\x95\x12\x26"
+				  "\x3b\xde\xf3\x32\x79\x42\x47\x0e"
+				  "\xa4\x5b\xda\x14\x10\xad\xa1\x67"
+				  "\x15\x3a\x93\xb7\x76\x72\x32\xe0"
+				  "\x2a\xf9\x6a\xaf\x36\xa7\x19\x87"
+				  "\x1b\x91\x2a\x93\x9c\x7a\xa3\x3c"
+				  "\x6d\xb9\x82\x93\xe9\xef\x82\x6d"
+				  "\x32\x4e\x7a\x76\xff\x1e\xd5\x5f"
+				  "\xca\x77\xe8\x13\xd4\x5b\x5d\x8e"
+				  "\xc2\x3a\x2d\x1a\xb6\x7c\xe2\x7e"
+				  "\x27\x2b\x1b\x67\xb7\xaf\x20\xf8"
+				  "\x44\xad\x9b\x29\xb7\x4d\x61\xb5"
+				  "\x5a\xbd\x9f\xe8\xd8\xcb\xaa\x9f"
+				  "\x57\x4a\x81\xf2\xb0\xd8\x6a\x2c"
+				  "\x1f\x58\x57\x1a\xf2\x9f\x5a\x04"
+				  "\xba\x8a\x28\x6a\xea\x0b\x3d\xa7"
+				  "\x7c\xb1\x3f\xac\xfc\x1b\x94\x49"
+				  "\x0e\xbd\xb0\x8c\xfa\x37\x57\xc3"
+				  "\x50\xbe\x47\xfc\x9b\x88\x37\x16"
+				  "\x11\xe1\x0e\xb9\x22\xf5\xdc\x2a"
+				  "\x8f\x1a\xd0\x1f\xfe\x4f\x97\x07"
+				  "\x08\xf3\x3f\x85\x86\xeb\x09\xb4"
+				  "\xcb\xae\x20\x70\x1c\x33\xa5\xa3"
+				  "\xb1\x35\x93\x6b\x55\x44\xed\x58"
+				  "\x55\x1d\xfe\xa7\x35\x15\xbf\x56"
+				  "\x96\x07\x87\x98\x1d\x89\x6e\xd4"
+				  "\xb6\xf4\x73\xc9\xc9\xb9\xd5\xde"
+				  "\x12\x7c\xdd\x26\x39\x27\x7c\x93"
+				  "\x32\xe9\x91\xa6\x3c\xcf\x03\x55"
+				  "\x72\x81\x85\xff\x2f\x2b\x2a\xe5"
+				  "\x76\x57\xb5\xd5\xfa\x3f\xfc\x57"
+				  "\x85\xeb\x6f\xc4",
+		.psize		= 1500,
+		.digest		= "\x39\x31\x6b\x23\xa8\x9b\x4f\x77"
+				  "\x40\xc3\x56\x76\xce\x2f\xe1\x97",
+		.np		= 8,
+		.tap		= { 200, 255, 1, 255, 255, 255, 255, 24 },
+	},
+};
+
 /*
  * DES test vectors.
  */
@@ -30818,6 +31857,678 @@ static const struct cipher_testvec chacha20_tv_template[] = {
 	},
 };
 
+static const struct cipher_testvec xchacha20_tv_template[] = {
+	{
+		.key	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.klen	= 32,
+		.iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.ptext	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.ctext	= "\xbc\xd0\x2a\x18\xbf\x3f\x01\xd1"
+			  "\x92\x92\xde\x30\xa7\xa8\xfd\xac"
+			  "\xa4\xb6\x5e\x50\xa6\x00\x2c\xc7"
+			  "\x2c\xd6\xd2\xf7\xc9\x1a\xc3\xd5"
+			  "\x72\x8f\x83\xe0\xaa\xd2\xbf\xcf"
+			  "\x9a\xbd\x2d\x2d\xb5\x8f\xae\xdd"
+			  "\x65\x01\x5d\xd8\x3f\xc0\x9b\x13"
+			  "\x1e\x27\x10\x43\x01\x9e\x8e\x0f",
+		.len	= 64,
+	}, {
+		.key	= "\x32\xe5\x76\xf8\xc2\x5b\x2d\x61"
+			  "\xed\x61\x03\xc4\x5a\xe3\xae\x94"
+			  "\x54\x1f\x02\x39\xc4\xc8\xc4\x39"
+			  "\xc3\x45\x40\xc4\x98\x28\x0a\x2e",
+		.klen	= 32,
+		.iv	= "\xa4\x42\x9a\xa8\x27\xc8\x0c\x8b"
+			  "\x1b\xdc\xd8\x5c\x0d\xd1\x4f\x0a"
+			  "\xf8\xe6\x1b\xed\x3b\xaf\xa6\xd0"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.ptext	= "\x14\xc8\xb1\x8e\x06\xb9\x35\x3c"
+			  "\xec\xb7\xa5\x1c\x20\x61\x72\x1c"
+			  "\x83\x09\xab\x17\xad\x49\x81\x3c"
+			  "\x68\x22\xdf\xf2\xa9\x33\x09\x41"
+			  "\x5b\xb6\xe6\x47\x8f\x6c\x3e\xb5"
+			  "\x4f\xbc\xf7\x77\x64\x7d\x49\x79"
+			  "\xad\x82\x11\x6d\xac\x53\xb0\x00"
+			  "\x53\xb8\x07\x37\x2e\x20\x11\x8f"
+			  "\xce\x44\xc9\x3c\x5a\x10\x09\x43"
+			  "\x6a\xc9\x3e\x0d\xd5\xaf\xd7\x30"
+			  "\x9f\x5c\x07\x4c\xd9\x57\x9e\x62"
+			  "\xf2\x72\x19\xf8\x68\x97\xce\x1b"
+			  "\x3a\xa1\x2f\xc2\x8b\x37\x0a\xac"
+			  "\xe6\x40\x06\x02\xe3\x25\xe7\x97"
+			  "\x97\xaf\x04\x5e\x33\xaa\x77\x0e"
+			  "\x0a\x97\x7c\x1f\xf4\x10\x8b\xae"
+			  "\x33\x39\x83",
+		.ctext	= "\xec\x41\x0b\x48\xc5\xf2\x74\x4c"
+			  "\xa1\x49\x6c\xea\x3d\xfb\x77\x34"
+			  "\xc1\x91\xce\x3b\xae\xa7\x89\xd0"
+			  "\xec\x91\x3c\x04\x25\xbe\x71\xb4"
+			  "\x48\x19\xd6\xcc\x48\xc5\xcd\xd8"
+			  "\x0a\x88\x99\xe0\x58\x1a\x66\x67"
+			  "\xe7\x46\xc4\x9b\x2f\xfa\x8c\x99"
+			  "\x8a\xee\xe7\x41\x67\x7c\xb3\x61"
+			  "\x91\xa7\x4e\xd1\xa1\x46\x00\xf9"
+			  "\xd6\x00\x19\x6b\x83\x10\xa0\x4a"
+			  "\x71\x84\xeb\x73\x1e\x45\x2c\x6b"
+			  "\x94\x81\xfa\x38\xa4\x94\x5f\x38"
+			  "\xc4\x29\x8b\x92\x43\x8e\x2d\x86"
+			  "\x5b\x85\x45\x6a\x41\xa8\x96\x2f"
+			  "\x46\x30\x17\xa0\xd3\x35\xd0\x53"
+			  "\x90\x11\xbc\xb9\x1f\x8b\xd0\xf7"
+			  "\x78\x00\x7b",
+		.len	= 131,
+		.also_non_np = 1,
+		.np	= 3,
+		.tap	= { 64, 3, 64 },
+	}, {
+		.key	= "\xb2\x97\x7d\x52\xbc\xcd\x80\x9f"
+			  "\x2c\xd8\x37\xf1\x44\x36\x25\x5e"
+			  "\x92\x51\x49\x8c\xe7\x3e\xa4\xbc"
+			  "\x7f\x97\x61\x88\x14\xae\x10\x2c",
+		.klen	= 32,
+		.iv	= "\x07\x65\x28\x66\xed\x14\xf3\x0f"
+			  "\xa7\xc8\xab\x74\x5e\x63\xe7\x91"
+			  "\x4b\x40\x1a\xdf\xe4\xb0\xbb\x5e"
+			  "\x01\x00\x00\x00\x00\x00\x00\x00",
+		.ptext	= "\x5e\xe8\x72\x61\x5e\x0b\x14\x8f"
+			  "\xd0\x3a\xaa\x05\x9e\x31\x0f\xeb"
+			  "\x90\xe3\xf7\x00\xad\xfe\x87\xb5"
+			  "\x7a\x47\xa7\x7e\x7b\xe9\xec\x2c"
+			  "\xd8\x11\xf6\x9e\xf0\x2c\xc2\xe6"
+			  "\x4b\xcf\x3c\xa4\x73\x5d\xaf\xcf"
+			  "\x6c\x62\xe8\x8b\xaa\x75\xd5\xee"
+			  "\x6c\xdf\xe0\x0a\x93\xa2\xa8\xc1"
+			  "\xca\x0f\xdf\x66\x6d\x6d\x78\xa3"
+			  "\x85\xe2\x66\xd7\xd3\xd4\xd6\x0f",
+		.ctext	= "\xb5\xbe\x26\x7c\x57\x29\xfa\x27"
+			  "\x18\x3a\xe3\x9b\x93\x4f\x97\x4c"
+			  "\xb8\xca\xf0\x1b\x49\x6c\xa4\xa3"
+			  "\xc9\x5a\x51\xf4\xc5\x74\x91\xc4"
+			  "\x2b\x5c\xe7\xa6\xd9\xfb\xbc\xca"
+			  "\x79\xb0\x86\x80\x92\x7d\x89\x89"
+			  "\xb2\xa4\x4b\x6c\x97\x9a\xeb\xad"
+			  "\x29\x76\xeb\xbd\xf2\x6b\x66\xb2"
+			  "\x7c\x2c\xa6\x32\x68\x9a\x74\x6e"
+			  "\x66\x28\xe9\x4f\x5a\xfb\xe5\xc4",
+		.len	= 80,
+	},
+};
+
+static const struct cipher_testvec xchacha12_tv_template[] = {
+	{
+		.key	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.klen	= 32,
+		.iv	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.ptext	= "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.ctext	= "\x10\xe0\xa5\x31\xa2\xf9\x16\xa3"
+			  "\x64\xea\xdb\xbf\x8e\x72\x6d\x4c"
+			  "\xb0\x1d\x18\xeb\x4a\xca\xda\x60"
+			  "\x79\x22\x02\x07\x2a\x7b\x4b\x7a"
+			  "\x13\x58\x46\xa9\xd4\x45\x2c\x5c"
+			  "\xe8\xdc\x06\xd7\x79\x07\xf1\xa1"
+			  "\x8e\xeb\xb9\x78\xfb\x8e\xe0\x0b"
+			  "\x9f\x39\x73\xfb\x7a\xf1\xb1\x13",
+		.len	= 64,
+	}, {
+		.key	= "\x08\xac\x7f\xbb\x59\x0b\xbb\x51"
+			  "\xe0\xc7\x13\x2b\xf8\x23\x8f\x1e"
+			  "\xa9\x69\x60\x16\xcc\x67\x4d\xc9"
+			  "\x9b\xf5\x7a\x0d\x18\x0a\x49\xd9",
+		.klen	= 32,
+		.iv	= "\x5f\x5b\xf6\x25\x13\x30\xac\x57"
+			  "\xde\x10\x7a\xb1\xec\xa3\x18\x1a"
+			  "\xf4\x60\xdf\x3d\xac\x9d\x0d\x5c"
+			  "\x00\x00\x00\x00\x00\x00\x00\x00",
+		.ptext	= "\xb3\x4e\x28\xfa\x8f\xea\xc0\xf7"
+			  "\x2c\xcb\xfc\x4f\xea\xd6\x5b\x4b"
+			  "\x78\xe4\x3c\x8e\x96\x52\x98\x5c"
+			  "\x61\x34\x5b\x81\xb7\x1e\x5b\x29"
+			  "\x55\x04\x03\xf6\x97\x09\xcd\xb6"
+			  "\x63\x39\xbe\xae\x7b\x8a\x34\x0f"
+			  "\x83\xe3\xb3\xa9\x8b\xe7\xfe\xa5"
+			  "\x85\x0e\x2a\xf1\x19\x94\xf7\x38"
+			  "\x4a\x9f\x63\x74\x88\x20\xa0\xa3"
+			  "\x25\x6d\xb8\x7a\x04\xe5\x1f\x10"
+			  "\x98\x50\x22\x89\x4b\xdb\xd6\x4d"
+			  "\x1c\x6d\x20\xeb\x7f\xb8\x43\x44"
+			  "\xb0\x89\x5d\x27\x44\x19\xcd\xe3"
+			  "\xae\x31\xc3\x63\x32\x94\xcd\xb0"
+			  "\x5e\x5d\x9f\xcf\x97\xe0\x3e\x83"
+			  "\x3c\x7a\xe8\x0c\x24\x60\xaf\x06"
+			  "\xc7\x3b\x7f",
+		.ctext	= "\x3f\x1f\x28\x88\x39\xea\x52\xbc"
+			  "\x5e\x0c\x2a\x21\x3e\x84\xc7\xfe"
+			  "\x39\x49\xca\xa5\x3c\xd7\x21\xbb"
+			  "\x16\x92\xd2\x3a\x4d\xbe\x45\x80"
+			  "\xd7\x93\xdf\x75\x70\x96\xb2\x44"
+			  "\x0f\x98\x30\x88\xd4\x5e\xe0\x3b"
+			  "\x28\x51\x05\xe0\x6a\xc9\x1e\xf3"
+			  "\x9a\x29\x66\x7f\x4f\xbc\xb0\xd4"
+			  "\x62\xb2\xc2\x84\x53\x2e\xdd\x48"
+			  "\xdb\xa0\x62\xce\x8a\xb2\xec\x1f"
+			  "\x2d\x6f\xa9\x95\x8b\xb5\x59\x5b"
+			  "\x37\xc8\x44\x55\x57\x02\xde\x30"
+			  "\x09\x00\xe7\xd1\x73\x6c\x85\xc2"
+			  "\xe9\x7a\x5c\xf8\x73\x10\x23\x6b"
+			  "\x47\xbf\x17\x3b\x66\x80\x3f\x35"
+			  "\xf2\xc5\xdc\xcc\x96\x40\x09\x04"
+			  "\xb6\xf0\x9b",
+		.len	= 131,
+		.also_non_np = 1,
+		.np	= 3,
+		.tap	= { 64, 3, 64 },
+	}, {
+		.key	= "\x7e\x80\x32\x65\x86\x82\xa6\x0a"
+			  "\x8a\x04\x64\x8f\x5e\x46\x28\xdd"
+			  "\xac\x19\xe9\xde\xf7\x6d\x6c\x4b"
+			  "\x4a\xda\x6d\x96\x16\x01\x31\xe7",
+		.klen	= 32,
+		.iv	= "\xfd\xa7\x93\xb9\xcb\xf1\x2e\x27"
+			  "\x92\xf3\xc1\x38\x2a\xb1\x14\x13"
+			  "\x1e\xa7\xc7\xca\x6c\x9c\xa2\x96"
+			  "\x01\x00\x00\x00\x00\x00\x00\x00",
+		.ptext	= "\x1b\x86\xba\x8b\xb0\x5b\x0c\x9b"
+			  "\xc1\x2f\xb1\x81\x71\xdf\xf9\xa8"
+			  "\x0c\x6f\xa4\xb5\x1e\x0b\xbf\x7b"
+			  "\xe5\x34\x85\xed\xe6\xfe\xa8\x7a"
+			  "\xbc\x34\x50\x62\x58\xdc\xa0\xfe"
+			  "\xa5\x65\x2a\x45\x5d\xd5\x24\x3a"
+			  "\x21\xa9\xe3\x65\xd3\x63\xff\x39"
+			  "\xcf\xc8\x0e\x0d\x01\xec\x9f\x01"
+			  "\xfb\xd5\x0a\x32\x37\x7a\x50\xad"
+			  "\x3c\xa0\x7a\x94\xc5\x42\x62\x86",
+		.ctext	= "\x26\x56\xab\x49\xcf\x2a\x8a\x8b"
+			  "\x7d\x45\x87\xdb\x0f\x5b\x6f\x88"
+			  "\x65\xbc\x3a\xc8\x30\x37\x45\x53"
+			  "\xdf\xd1\xa6\x8c\x1e\x8a\x50\x85"
+			  "\x90\x95\x3d\x7c\x33\x4c\xef\xbb"
+			  "\x28\x37\xcc\xd5\x82\xd4\x35\xef"
+			  "\x02\x34\x63\x4c\x0a\xfd\xb9\xa5"
+			  "\xee\x5a\x3f\x3d\x93\xeb\xd6\x94"
+			  "\x68\xb4\x2d\xb4\xfa\x44\xa0\x99"
+			  "\x12\x48\xc1\x67\xee\x92\x8a\xc1",
+		.len	= 80,
+	},
+};
+
+/*
+ * Adiantum test vectors, computed with an independent implementation of the
+ * algorithm from the Adiantum paper.
+ */
+static const struct cipher_testvec adiantum_xchacha12_aes_tv_template[] = {
+	{
+		.key	= "\x14\x4e\x0a\x32\x31\x8d\x35\x78"
+			  "\x6e\x12\xb0\x0b\x8f\x00\x68\xf8"
+			  "\x01\xa4\x3a\x9b\xfd\xf2\x18\x34"
+			  "\x43\x08\x0b\xa9\xdd\xfb\xc9\x2d",
+		.klen	= 32,
+		.iv	= "\x16\x47\xee\x72\x47\x99\x53\x97"
+			  "\xb6\xf7\xf1\xc8\xc4\x95\xde\x7c"
+			  "\x0a\xac\x25\x60\xfd\x69\xb0\x85"
+			  "\xe5\xe3\xe3\x90\xfa\xae\x03\xf9",
+		.ptext	= "\x94\xce\x69\x6f\xa3\xfa\x3e\xc5"
+			  "\xd0\xd8\xb6\xca\xe3\xcb\xcf\xaa",
+		.ctext	= "\x15\x62\xd3\xbc\x91\xc4\xe9\xdf"
+			  "\x4a\xac\x45\x01\x71\x9b\x96\x79",
+		.len	= 16,
+	}, {
+		.key	= "\x64\x75\x8d\x79\x56\x7c\x58\xd4"
+			  "\x06\x2e\x09\xb4\x3a\x49\xb6\x16"
+			  "\x84\xe0\xa2\x0e\xaa\x29\x08\x88"
+			  "\x5d\x74\x26\x86\xf7\x30\x4e\x92",
+		.klen	= 32,
+		.iv	= "\x9e\x25\xee\x52\x95\x95\x54\xd0"
+			  "\x85\x94\xa1\x44\x09\x9a\x31\x05"
+			  "\x4f\x2a\x30\xd1\x91\xf6\x54\xbd"
+			  "\x05\xf3\x19\x3b\xed\x27\x72\xf2",
+		.ptext	= "\x07\x29\x05\xd0\x5a\xc8\x37\xe8"
+			  "\x15\xb1\x4d\x96\x16\xc1\xe4\x02"
+			  "\xbf",
+		.ctext	= "\xd2\x79\x32\x21\xae\x09\x9d\x97"
+			  "\xee\xd3\xa0\xa5\x59\xf1\x43\x82"
+			  "\xc1",
+		.len	= 17,
+	}, {
+		.key	= "\x6f\x5c\xd7\x70\xd4\xf4\xb0\xa6"
+			  "\xa4\x44\x71\x87\x77\x75\xb7\xe3"
+			  "\xbe\x50\x20\xa4\x5e\xcd\x31\x40"
+			  "\xb0\x0d\x4e\x87\x2a\x35\x4e\x73",
+		.klen	= 32,
+		.iv	= "\x8e\x4a\x48\xbd\xb7\x65\xf0\x68"
+			  "\x5e\x93\xdf\xad\xeb\xc1\x25\x3c"
+			  "\x37\x70\xee\x2e\x3a\x14\xbd\x67"
+			  "\xfd\x71\xa7\x81\x47\x7d\x4e\x7c",
+		.ptext	= "\x76\xb4\xba\x73\xc1\x29\xc8\x9c"
+			  "\x98\xae\x38\x33\xd8\xc5\x45\x38"
+			  "\xb8\x4f\xcd\x71\xc2\xc6\x03\xb2"
+			  "\xf4\x65\x75\xc0\xe3\x24\x44\x60"
+			  "\x80\xed\x65\x07\xea\x70\x71\xf7"
+			  "\xab\xf2\x56\xf2\xa9\x47\xfa\x11"
+			  "\x14\x6a\x8c\x54\x61\xb2\x5c\xf9"
+			  "\x0f\xe8\x13\xf7\x20\xc8\x59\x50"
+			  "\x4c\x15\xc9\x27\xa0\x8e\xdb\x64"
+			  "\x92\xba\xd1\x9a\x55\xaf\xe3\x63"
+			  "\x88\x77\x75\xfd\x0b\x3c\xff\xa2"
+			  "\x83\xbf\xbc\xe0\x54\xb0\x48\x9a"
+			  "\xfb\xe6\x32\x7d\x11\x15\xea\xe9"
+			  "\xb4\x89\xc6\x1e\xd6\xcc\x0a\xf2"
+			  "\x19\x8c\x13\xc2\x50\x61\x7d\xb5"
+			  "\x9d\x4a\x53\x32\xab\xc7\xbd\x8a",
+		.ctext	= "\xf1\xaf\x00\x3b\x0a\x98\xfa\x4f"
+			  "\x0e\xed\x03\xf5\x04\x7f\x2e\xa4"
+			  "\xd7\x7a\x08\xc6\xfa\xc6\xa9\x72"
+			  "\x9e\x96\x09\x71\xe3\x22\x42\x39"
+			  "\x15\x72\xf5\x98\xad\x1f\xf7\xeb"
+			  "\xcc\x58\x60\x65\x66\xff\xcd\x7c"
+			  "\xde\x01\x52\x28\xae\xe0\x2f\x66"
+			  "\x50\x01\xdf\xc4\x86\x97\xd9\x00"
+			  "\x4f\x82\xe9\xb2\x85\xb0\x22\xcc"
+			  "\x79\xb8\x7b\x62\x6d\x7e\x32\x27"
+			  "\x6c\xae\x9a\xbe\xb3\x11\xeb\xce"
+			  "\x0e\xd0\x9f\x75\x16\x06\xbc\x23"
+			  "\x36\xf2\xb0\xbe\xc4\x9e\x5a\x73"
+			  "\x78\xd2\x10\x3d\xe5\xdd\xe9\x71"
+			  "\xcc\x23\xf6\x9f\x0d\x85\xc9\x9b"
+			  "\x89\x04\x0f\x5e\x92\x31\x48\x8b",
+		.len	= 128,
+		.also_non_np = 1,
+		.np	= 2,
+		.tap	= { 64, 64 },
+	}, {
+		.key	= "\x02\x4b\x54\xcb\x5d\xfb\x42\x9b"
+			  "\x63\x35\xad\x25\x64\x86\x95\x36"
+			  "\xcf\x59\x72\x3c\x57\x8c\xdd\x93"
+			  "\x52\x3d\x9b\xec\xf8\x73\x1e\xe1",
+		.klen	= 32,
+		.iv	= "\x58\x8b\x3a\x90\xfd\x6d\x5f\x6c"
+			  "\xf5\xda\x3f\xa0\x88\xe3\x8d\x9f"
+			  "\x23\x59\x31\xd7\xca\x3a\xdd\x9d"
+			  "\x85\x37\x42\xf6\x77\xdd\xc8\xd5",
+		.ptext	= "\xeb\xb2\xd5\xaa\x5e\xd8\x9c\x7a"
+			  "\x01\x3f\x94\xad\x28\x4e\x38\x1b"
+			  "\x61\x3c\x55\x9c\x40\x34\x19\x26"
+			  "\x30\x9f\x88\x59\x53\xf3\x51\x57"
+			  "\x72\x05\x1e\xf4\x8a\xcc\xcb\x98"
+			  "\x20\x41\xfb\x6c\x2c\xb6\x7b\x38"
+			  "\x3e\x43\x5c\x40\x1c\x40\x0b\xb4"
+			  "\x13\x78\x99\x89\xea\xb5\x5e\x58"
+			  "\xdb\x5f\xcc\x47\x9a\x48\x33\x75"
+			  "\xf7\xe4\x4f\x94\xd1\x9f\x2d\xe0"
+			  "\x47\xa8\x13\xad\x2b\x5f\x01\x94"
+			  "\x6a\x8a\x26\xd4\x05\x75\xaf\x30"
+			  "\xc7\x50\x56\xdc\x6e\xf8\xfb\xaa"
+			  "\x51\xe3\x92\x93\x9e\xf6\xc9\x50"
+			  "\x46\x82\x23\xc6\xdd\x60\xa9\x64"
+			  "\x96\x1a\x7e\x3b\x5a\x07\x05\x29"
+			  "\x83\x5a\x65\x60\xfa\xe0\x80\xbf"
+			  "\xbe\x1f\xb5\x9e\x61\x0a\x62\xf1"
+			  "\x76\x11\xe7\xc8\xeb\x91\x72\x5c"
+			  "\x21\x98\x8b\x8c\xb3\x29\x50\xfd"
+			  "\x8d\x14\x77\x01\x1a\x5d\x66\x8e"
+			  "\x88\x77\x1b\x31\x3c\x7d\x9f\x5c"
+			  "\xd7\x08\x6a\x12\xe7\x79\x60\xca"
+			  "\xed\xb8\x75\x4c\xe9\x97\x68\x09"
+			  "\x07\xf6\x5a\x30\xd6\x5c\x28\x10"
+			  "\xa4\xae\xfe\xaa\x96\xbf\x36\x4b"
+			  "\x9c\xeb\x96\x8a\x4c\xb4\xa6\x2c"
+			  "\x1a\xde\xc9\x2e\x66\x55\xc8\xd9"
+			  "\x80\x91\x65\xc6\x78\x2a\xba\xf5"
+			  "\x4a\xd3\x5c\x6d\x97\xff\x47\xa4"
+			  "\xc8\x06\x94\xb2\x76\xed\x78\x44"
+			  "\x33\x70\x9f\xc6\xcf\x9b\x5a\x6f"
+			  "\x3e\x81\x3e\x5a\xd0\x18\x09\x8f"
+			  "\x26\x46\x67\xbc\x91\x9c\x40\x4d"
+			  "\xda\xe1\xfb\x8f\x1a\xc0\x53\xb5"
+			  "\xae\x4a\x56\x9e\x7a\x42\x92\xf4"
+			  "\x71\x4e\x61\xd9\xf3\x64\xc6\x7f"
+			  "\x62\xe3\xac\xf0\x7b\xdf\x32\xed"
+			  "\x64\x74\x89\x56\xdf\xb0\x8b\xdf"
+			  "\xf9\xc2\xcf\x3a\xab\x95\x84\x91"
+			  "\xa7\xc0\x81\x5c\x93\x01\x27\x14"
+			  "\x85\x34\x8c\x57\x04\x82\xf2\x7f"
+			  "\x1c\x30\xb6\x98\xda\xf4\x9c\x01"
+			  "\xdb\x96\x8e\xfb\xbf\xdd\x3b\xc9"
+			  "\x01\x6c\x20\xe1\xbd\xa3\x51\xcb"
+			  "\x62\xbf\xc9\xc0\x3e\x61\x84\xd9"
+			  "\x80\xea\x0c\x96\x0a\x86\x14\xaa"
+			  "\x2c\xfc\x91\x59\x18\x3f\x8d\xb1"
+			  "\x00\x89\x78\x30\x67\xc1\x5f\x1c"
+			  "\x9e\x13\x90\x18\x4d\x9b\x60\x5d"
+			  "\xc4\x92\x6e\x4a\xef\x0f\x0f\x4b"
+			  "\x2b\xd7\x8d\xce\xe4\x4c\x08\xc6"
+			  "\xfd\xac\x38\x64\x10\xac\xda\xa8"
+			  "\x42\xa2\xf3\xc6\xce\x2f\xc0\x57"
+			  "\xca\x93\x57\x66\x3d\x44\xe1\xe8"
+			  "\x39\x6f\x74\xfa\xd3\x03\x29\x40"
+			  "\x50\x66\x36\xd9\x66\xd5\x36\xf0"
+			  "\x81\x5f\x11\xd7\x09\x68\x92\x37"
+			  "\xa4\xba\x50\x4a\xde\x10\x46\xde"
+			  "\xb0\xcf\x36\x38\xb4\x42\xae\xee"
+			  "\x20\x93\x76\x15\x8f\x6b\xf9\xf5"
+			  "\xa9\xc1\xc0\x48\xea\x90\xb9\x6d"
+			  "\x5a\xdd\x18\x7c\xae\x9f\x0e\x5d"
+			  "\x05\x7e\xcb\x90\x75\x1a\x21\xc5",
+		.ctext	= "\x37\x4c\x5a\x7f\xd2\x08\xa2\xc7"
+			  "\x2e\xa6\xdf\x49\xd6\xaf\x1e\xa1"
+			  "\x68\x36\xb3\xbd\xc0\x50\x59\x4b"
+			  "\x5d\x52\x6c\x9d\x70\xa3\x28\x8e"
+			  "\x31\xa2\x71\xa9\xe5\x11\xc2\xf5"
+			  "\xf0\x97\x31\x74\x4d\x3a\x18\x1b"
+			  "\x36\x15\xfb\xcd\xf4\xb2\x88\x5c"
+			  "\x5f\x85\x48\xcd\x04\x91\xb9\x6a"
+			  "\x8e\x9d\x5a\x7f\xd7\x84\x7d\xcb"
+			  "\x6d\xa9\x07\xd8\x35\x3d\x97\xf3"
+			  "\xc5\x1d\x4a\x31\x04\x6d\xe5\xca"
+			  "\x94\xdf\x28\xba\x3e\x66\x47\x96"
+			  "\xdb\x89\x3e\x01\x67\x3c\xbd\xd7"
+			  "\x90\x97\x2f\xdb\x93\x02\x12\xc9"
+			  "\x3c\xce\x5b\xaf\x74\x63\x26\xbd"
+			  "\x0c\x0e\x3b\xdf\xb8\x22\xfd\xfa"
+			  "\x1a\xec\x2b\xd4\x7b\x63\x22\xe8"
+			  "\x59\xea\x03\x01\x9b\x5a\x76\x41"
+			  "\x4a\x91\x00\x76\x31\x71\xe9\x13"
+			  "\xf9\x20\xfa\xd7\x55\x34\xd1\x9d"
+			  "\x06\xb2\x8d\x13\x66\x19\xe2\x51"
+			  "\xf0\x09\x61\x82\x86\x73\x13\x68"
+			  "\x4a\x6d\x4c\x1f\x87\x34\xde\xa3"
+			  "\x5a\x01\x6f\x73\x3f\xb4\x55\x12"
+			  "\xb5\xb5\xe3\x44\x65\x10\xc6\xf1"
+			  "\x3a\x2c\x04\x5f\xf4\x49\x39\xc8"
+			  "\x69\xa9\x52\x99\x7c\xd7\x5d\xf5"
+			  "\x58\x0b\x30\x7c\xde\x49\xfe\x7f"
+			  "\xd9\xef\x1e\x63\xf8\x8a\xf1\x37"
+			  "\xd7\xad\xcd\x92\x2c\xa9\x7c\x21"
+			  "\x75\xe9\x20\xc7\x15\x13\x67\x7b"
+			  "\xd5\x33\xd1\x57\x5e\x1e\x30\x69"
+			  "\x48\x01\xbe\x7b\xd6\xe8\x07\x72"
+			  "\x56\xa5\x4f\x95\x4e\x48\x84\x1c"
+			  "\x33\xfd\xf4\xce\x63\xcc\x0d\x66"
+			  "\x3c\x84\x44\x9f\xf8\x2e\xea\xd2"
+			  "\x54\x23\x44\x2f\x42\x60\x7c\x56"
+			  "\x05\x57\x36\x33\x2a\xfa\x94\xd9"
+			  "\x36\x7b\xb3\xc3\x5f\x90\x49\x11"
+			  "\xd7\xac\xb0\xdc\xd6\x0a\x0c\x35"
+			  "\x43\xd8\x1a\xb0\x57\x2a\xee\xc6"
+			  "\x66\x4a\x28\x13\x75\x00\x85\x2e"
+			  "\x17\xdf\x65\xcd\xe7\xb9\xbe\x83"
+			  "\x59\xb7\x69\x92\xa4\xe2\x4e\x0b"
+			  "\x55\x95\xa4\xb0\xbe\x9c\x60\x93"
+			  "\xd4\xd3\x35\xf0\xc9\x99\x8d\x01"
+			  "\x99\xdd\x7c\xe0\xe0\x35\xe4\x74"
+			  "\x86\x82\xc4\xa3\x36\x9c\x10\xbc"
+			  "\xd5\x83\x39\x34\xb6\xe1\x77\xdf"
+			  "\xea\x23\x50\xc2\x64\x77\xbc\x42"
+			  "\x39\x73\x82\xcc\xab\x22\xca\x37"
+			  "\x49\x4a\x0a\x4f\x67\x6f\xe1\x37"
+			  "\x1a\xae\xab\x68\x24\xde\x5f\x33"
+			  "\x32\xd4\x4c\x69\xae\x16\x55\xae"
+			  "\x27\x2d\x2e\x1d\x60\xc7\x2c\x0f"
+			  "\xc6\x10\x90\x6a\xa4\x1d\x42\xa4"
+			  "\x7d\x06\xd2\xb6\x7f\x2f\xd5\xc7"
+			  "\xec\x01\x72\x70\x58\x8e\xce\x7f"
+			  "\x90\x6b\x74\xde\x23\xc9\xcd\x12"
+			  "\x74\xd2\x2b\x31\x78\x6d\xe7\xfe"
+			  "\xa0\x3d\x11\x91\x50\xf4\x7a\xf4"
+			  "\xb7\x4d\xb7\xfe\x72\x9e\x06\x98"
+			  "\xda\x3e\xcc\xb2\x00\x54\x16\xf4"
+			  "\x05\x7e\xc4\x74\x4d\xbf\xa2\xb1",
+		.len	= 512,
+		.also_non_np = 1,
+		.np	= 3,
+		.tap	= { 211, 1, 300 },
+	},
+};
+
+static const struct cipher_testvec adiantum_xchacha20_aes_tv_template[] = {
+	{
+		.key	= "\x17\x88\x22\x53\x56\xa6\x89\x08"
+			  "\x82\xae\x00\x6d\x4e\x6d\xab\xa7"
+			  "\x9e\xb2\x9b\x50\xf2\x5a\x8c\x4a"
+			  "\xc7\x03\x92\x7a\x74\x64\x22\xa6",
+		.klen	= 32,
+		.iv	= "\x4e\xf1\x95\x46\x7c\x81\x75\x54"
+			  "\xbb\x9f\x22\xdf\xd0\x49\x3d\x90"
+			  "\x06\x76\x09\x9c\x78\x13\xd1\x9e"
+			  "\x45\xff\xbb\x78\x50\xee\x44\xf3",
+		.ptext	= "\x9c\xa9\xe0\x42\x7a\xee\x10\xe5"
+			  "\xd9\x5c\x7b\xec\x3a\xa6\xe3\xdc",
+		.ctext	= "\x14\xa9\x50\x22\x50\x11\xa4\xb8"
+			  "\xbd\xd8\xaa\x74\x00\xe7\x27\xe3",
+		.len	= 16,
+	}, {
+		.key	= "\x22\xea\x89\xb8\xeb\x74\xf8\x2d"
+			  "\xf5\xae\x2f\x59\x2b\x1a\x71\x5b"
+			  "\x74\x8f\x8c\x66\x65\xcb\x1a\xff"
+			  "\x22\x73\x67\xf9\xab\x1e\x34\x0f",
+		.klen	= 32,
+		.iv	= "\x76\xc4\xa2\xb9\xa7\x27\xb3\x23"
+			  "\x34\x55\xad\x52\xdc\x34\x18\x4f"
+			  "\x08\xf8\x99\x71\xbc\xe6\x9b\xfb"
+			  "\x86\x0b\xe9\x59\xe0\x6c\xd3\xa3",
+		.ptext	= "\xd3\x4a\xb7\xe0\xed\xb6\xb9\x8d"
+			  "\x7e\x06\xd9\xa3\x41\xe0\x5a\x50"
+			  "\xb4",
+		.ctext	= "\x4d\x3f\xfa\xb4\x3a\xb9\x0a\x23"
+			  "\xe5\xd5\xcc\x11\x9d\x56\xaa\x1d"
+			  "\x77",
+		.len	= 17,
+	}, {
+		.key	= "\x60\x98\x2b\x11\x54\xc0\x91\xb1"
+			  "\xe6\x30\x94\xf4\x42\x35\x76\x4f"
+			  "\xc2\x84\x67\x87\xa9\xbd\xd5\xdf"
+			  "\x6a\xbc\xdb\xd9\x63\x13\x50\x2a",
+		.klen	= 32,
+		.iv	= "\xa2\x5f\x66\x2f\x6e\xc1\xd9\xbd"
+			  "\x23\x53\xb2\x31\x59\xb2\x3d\x5d"
+			  "\x49\x68\x32\x9b\xc4\x90\xd1\xbb"
+			  "\x99\x2d\xa0\x9f\xdd\x95\x79\x20",
+		.ptext	= "\x8d\x5d\x7b\x80\xa8\xed\x8d\x56"
+			  "\xb8\x54\x3d\x4a\xcb\xeb\xd7\x9d"
+			  "\x9e\x55\x43\x05\x4d\x40\x55\x3d"
+			  "\x2b\x7d\x96\xdb\x72\xdc\x5a\xee"
+			  "\x4f\x79\xf5\x5b\xe3\x0d\x46\x18"
+			  "\x90\x3a\xc0\x6a\x70\xd5\xa7\xad"
+			  "\x3e\x2e\x0b\xa5\x6a\xd2\x38\x10"
+			  "\x7b\xff\x9c\x3b\xab\x5e\x4f\xed"
+			  "\xac\xa3\x7f\xd8\x86\xfb\xab\xaa"
+			  "\x18\x5d\x7b\xfd\xb0\xb8\xc3\x3b"
+			  "\xf5\xbd\x45\xa5\xf4\xd5\x99\xb1"
+			  "\x0d\xad\x6f\xc1\x08\xb1\xe4\x2d"
+			  "\x56\xd0\x3d\x27\x63\xa6\x4c\x1a"
+			  "\xbc\xa2\xa0\xea\x06\xd2\x94\xc2"
+			  "\xf2\x43\x79\x0e\x7b\xf7\x46\xa4"
+			  "\x44\xf5\xc9\x4f\xf6\x44\x64\xff",
+		.ctext	= "\x8d\xa4\x32\x45\xb3\x8d\xc8\x05"
+			  "\xa5\x9c\x60\x67\x25\x44\xc7\x46"
+			  "\x58\xb5\xc3\x1d\xe5\xb1\xcb\x66"
+			  "\x22\x8d\x84\x2d\xbe\x65\xed\x7f"
+			  "\xfd\xab\xc8\xb0\x45\x1f\x28\x71"
+			  "\x90\x07\x56\x1a\x97\x8a\x00\x7d"
+			  "\xaf\xe6\xab\xd3\x3d\x35\xa4\xc7"
+			  "\xec\xb5\xb0\x21\xca\x06\xa6\x70"
+			  "\xf2\x00\x89\x87\x48\x04\x20\x71"
+			  "\x2b\xc6\x83\x93\x34\xb6\xca\xee"
+			  "\x26\x2a\x1b\x38\x10\x35\xc0\x8e"
+			  "\x53\x23\x9b\x82\xa5\x74\xff\xe3"
+			  "\xca\xdb\x78\xd9\xed\x4e\xf1\x0d"
+			  "\xed\x95\x9c\x47\x7c\xcb\x9b\x68"
+			  "\x4c\xb1\xff\x57\xc9\xd9\xc9\xf9"
+			  "\xf2\x20\xd3\x47\xa5\x61\xe5\x77",
+		.len	= 128,
+		.also_non_np = 1,
+		.np	= 2,
+		.tap	= { 64, 64 },
+	}, {
+		.key	= "\xe6\xe5\x78\x97\x9e\xdb\x62\x59"
+			  "\x90\x59\x59\xa4\xfb\x1c\xa7\xdc"
+			  "\x78\x78\xf3\xa2\xa7\x6b\x9d\xb1"
+			  "\x2d\x48\x8d\xb9\x4e\x58\x9e\x8e",
+		.klen	= 32,
+		.iv	= "\x0e\x29\x07\xa3\x7c\xb4\x89\x2b"
+			  "\xfc\xd9\x6c\xa8\x4f\x24\xf0\x91"
+			  "\x39\x48\xe6\x48\xf5\xe2\x0b\x6c"
+			  "\x43\x19\xea\xfc\x76\x71\xcf\x7d",
+		.ptext	= "\x63\x30\x3f\xd4\x82\xd9\x0c\xb5"
+			  "\x52\xc2\x8e\x57\x95\x3b\x7f\xb1"
+			  "\xf4\x03\xf8\xca\xf5\x66\x65\x90"
+			  "\x25\x72\x13\x15\x8c\xbd\x94\x70"
+			  "\x48\x9a\x4b\xfe\x20\xaf\x92\xb8"
+			  "\x21\x70\xc5\x26\x10\x9e\xf4\x00"
+			  "\xb1\xa2\xcc\xcf\xde\x85\x61\x48"
+			  "\x91\xf6\x6d\xfe\x56\x8c\x43\xfe"
+			  "\xd1\x1f\xf5\xc8\xd0\x43\xd7\xb1"
+			  "\xed\x0d\x0d\x81\x68\xa4\xf4\x32"
+			  "\xdc\x50\xe2\xce\xcc\x94\x3f\x4a"
+			  "\xf8\x84\x8a\x07\xba\x33\xb3\xe6"
+			  "\x6e\xb3\xc3\x6b\x4f\xce\xd0\x4e"
+			  "\x48\x60\x14\xa5\x56\x0b\x6e\x65"
+			  "\x62\x69\x50\xa7\x59\x96\x65\xc7"
+			  "\x40\x17\x1f\x03\x43\x3f\x4c\xd1"
+			  "\xad\xe7\xfd\x5d\x33\x98\xc1\x77"
+			  "\xe2\xb5\xb3\xe3\x33\xb9\x3c\x64"
+			  "\xa3\xc1\x17\xca\x59\xba\x2a\x7b"
+			  "\xe6\xbe\xdf\x74\x24\xf8\xdd\x65"
+			  "\xbe\x5a\xae\xcf\xb9\xb1\xbc\xb4"
+			  "\xad\x02\x75\xa8\x51\x3f\x2c\x08"
+			  "\x6f\x3b\x52\x6d\x7a\xb9\x79\x40"
+			  "\x2b\xb4\xad\xab\x6f\x08\x43\x90"
+			  "\x50\x50\x07\x94\xf5\x4d\xf6\xeb"
+			  "\xed\xdd\xa7\x3e\xae\xae\xaf\xb3"
+			  "\x7c\x53\xf1\x91\x23\xab\x01\xb2"
+			  "\x64\x85\xc7\x9f\x7a\x4b\x63\x5f"
+			  "\x68\xe8\xf3\x79\xbd\x92\x7b\xaf"
+			  "\x34\xaf\xf2\x46\xf2\xa7\x07\xa8"
+			  "\xb4\x56\xc5\x45\xd7\x1d\x7e\xc4"
+			  "\x3b\x9c\x14\x09\x83\x32\x08\xce"
+			  "\x31\x16\x36\x41\x52\x57\x32\x8f"
+			  "\xea\x1b\x9d\xd8\xea\x36\x4f\x9f"
+			  "\xf3\xf5\x1c\x9d\x18\xe6\x66\x01"
+			  "\xa5\x76\x8c\x54\xc9\x73\xc3\xef"
+			  "\xa2\x35\x7c\x29\x5a\x36\x46\x72"
+			  "\x93\xfa\x97\x5e\x0b\xfb\xe2\x06"
+			  "\xf0\xdf\x49\xc1\x85\xe3\xbb\x24"
+			  "\x30\x05\xcc\x1e\x1f\x8a\x16\xe4"
+			  "\x70\x5f\x6a\x1c\x50\xb7\x31\x52"
+			  "\xe6\xa5\xb9\xf0\xa5\x28\x9f\xa1"
+			  "\xa6\x07\x5c\x1e\x15\x10\xf0\xc7"
+			  "\xc7\x7b\x35\xce\xd1\x6f\x56\xd7"
+			  "\xbf\x0e\x9a\xec\x1c\x2e\xf3\xa9"
+			  "\x04\x06\x39\x03\xf2\x9a\x6b\x89"
+			  "\x30\xfa\x6b\xac\xe7\x96\x87\x8f"
+			  "\x2b\xdd\x6b\x6e\x91\xfa\x2a\xb2"
+			  "\x79\x19\x0a\x62\x97\xae\xc6\xb0"
+			  "\xa6\x4f\x33\xbf\x08\x71\xaa\xfa"
+			  "\xf1\x12\x97\xc4\x37\x36\x2d\xe5"
+			  "\x64\xa3\x1e\xa1\xef\x2c\xb3\x66"
+			  "\x58\x67\x30\xc1\xd2\x5b\x4b\xdc"
+			  "\x69\x4b\xe8\xf3\x5f\x45\xfe\x1d"
+			  "\x2b\x46\xc8\x15\x94\xe3\x80\x63"
+			  "\xd4\x78\x2c\x5f\x36\xde\x81\x2b"
+			  "\x8d\xef\xbb\x27\x95\xc7\x7c\x7e"
+			  "\x94\x26\xec\x08\x23\x97\xf0\x9e"
+			  "\xc1\xbc\xe4\x31\x2a\x5e\x1c\xce"
+			  "\xaf\xf9\x82\x78\x1e\x68\xe6\x29"
+			  "\xff\xe5\xa6\x80\x1e\xdc\xeb\x9f"
+			  "\xc1\xf6\x2c\x8b\x96\xe9\xf7\xeb"
+			  "\xe2\xcd\x37\xad\x9a\x96\xe6\x7f"
+			  "\x45\xb1\x04\xda\x57\xc7\x29\x46",
+		.ctext	= "\x0e\x4b\xea\xf7\x29\x90\xe2\xcf"
+			  "\x5c\x1a\x78\x84\x99\x80\x61\xbb"
+			  "\x7d\x1b\x19\x03\xa5\x60\x49\x64"
+			  "\xf0\xa4\x6c\x02\xd6\xf5\x8f\x3d"
+			  "\xca\xfd\xd6\x0d\x8a\x85\x8a\x77"
+			  "\x2a\x55\x18\x30\x6f\x9d\x6e\xe9"
+			  "\x83\x53\xdf\x41\x3a\x19\x16\x37"
+			  "\x55\xb5\x05\xd0\x3c\xd2\x7d\x9f"
+			  "\x93\x97\xde\x60\x2c\x2f\x8d\xbd"
+			  "\x35\xe1\x8e\xa3\x35\x07\xf4\xaa"
+			  "\x7e\x73\xf9\x82\x90\x77\x8b\x3a"
+			  "\x3e\x6c\x7a\x10\x03\x93\x13\xfb"
+			  "\x6a\xe0\x77\xea\x33\x65\x90\xae"
+			  "\x88\x80\xed\xd0\xd8\x97\x06\x4c"
+			  "\x78\x6e\xfc\x87\xb4\xd4\xdf\x6c"
+			  "\x9e\x45\x83\x23\xed\x09\x63\x8e"
+			  "\x9b\xe2\xf7\x10\x86\x4f\x4c\x5f"
+			  "\x57\x76\x90\x74\x72\x1d\x62\xce"
+			  "\x69\x67\xac\xed\x52\x6b\x73\x35"
+			  "\xea\xaf\xd5\xf7\x13\xc5\x32\xf3"
+			  "\x97\x82\x1f\x57\xfc\x33\x83\x7e"
+			  "\x43\xb4\x06\x55\x88\x10\x4c\xde"
+			  "\x58\x76\x68\x0f\xd3\x33\xd9\xc9"
+			  "\xe3\x15\xb7\xd0\x28\x19\xe9\xd0"
+			  "\x61\xbc\x52\x3a\x02\x99\x34\x11"
+			  "\x6b\x65\x9c\x1c\xc9\x6c\x84\x1c"
+			  "\x2b\xdc\x66\xf4\x9b\xb0\xd0\xc7"
+			  "\xe7\x5d\xd0\xda\x35\x64\x6d\xbf"
+			  "\xd3\xb8\xd3\x36\xa6\xd8\x7f\xd5"
+			  "\xd3\x21\x6e\xb0\x16\x31\xce\x21"
+			  "\x5a\x8c\xba\x38\x1b\x8d\xb2\xb0"
+			  "\x70\xb2\xe1\xd2\x27\x2e\x25\xa6"
+			  "\x3d\x2f\x09\x1a\x52\x73\x97\x9b"
+			  "\xf8\xf1\x11\x76\x7e\x11\xc7\x57"
+			  "\x5e\x14\x5d\x62\xb6\x57\xe3\x51"
+			  "\x53\xe6\x28\x81\x22\xd5\x28\xbd"
+			  "\x43\x28\x07\x0a\xa9\xf9\xf5\x3c"
+			  "\x1a\x04\x08\xf5\x76\x2b\xfa\x30"
+			  "\xa9\x12\xd2\x7f\x59\x8a\xf1\x16"
+			  "\xbb\x01\x10\xb3\x50\xb4\x18\x22"
+			  "\x0e\xa1\xc6\x20\x55\xc7\x7a\xb7"
+			  "\x8d\xa3\x9f\x66\xb7\x46\x26\xf8"
+			  "\xe0\xdb\x55\xc7\x24\xed\xed\xe9"
+			  "\xbe\xbe\x7f\x6e\xa2\x8d\xde\xe0"
+			  "\x31\x89\x60\x01\x88\x94\xcd\xc9"
+			  "\x96\xf4\xb9\x9e\xcf\x6f\x1c\x3b"
+			  "\xbc\x59\xea\x58\x44\x2b\x68\xe1"
+			  "\xb2\xb9\xe2\x0f\x81\xaf\xe7\xd7"
+			  "\xa3\x79\xdf\x41\x6b\x18\xa0\x9c"
+			  "\xf1\xd4\xa2\xdb\x32\xd3\xb7\x1b"
+			  "\x39\x4d\xf1\x6e\x9a\xb4\x22\x93"
+			  "\x66\xc0\x57\x9e\x66\x98\x00\xc0"
+			  "\xfe\xe9\x55\x30\xd3\x73\x14\x8b"
+			  "\x09\x9d\x28\x03\x37\x7f\x3d\x85"
+			  "\x92\xc4\x09\xfc\xae\x64\x3b\xb6"
+			  "\xbf\xa3\x51\x3c\xa5\xc5\xb2\x85"
+			  "\xf2\x6b\xc2\x6b\x36\x12\xf1\xf6"
+			  "\x1f\x8f\x99\x15\xb7\x7a\xcc\x64"
+			  "\x52\x5e\x43\x74\xfb\xbd\x7e\x34"
+			  "\x21\x12\x4b\x53\xd1\x69\xb8\x3d"
+			  "\x60\x88\x10\x0e\x80\xd4\x79\xe9"
+			  "\xc3\x42\x8f\x0b\x45\x38\xc7\xdd"
+			  "\xac\xdd\xe8\xea\xc7\xce\x69\x83"
+			  "\x85\x49\x7d\x59\xde\x41\x08\xb7",
+		.len	= 512,
+		.also_non_np = 1,
+		.np	= 3,
+		.tap	= { 211, 1, 300 },
+	},
+};
+
 /*
  * CTS (Cipher Text Stealing) mode tests
  */
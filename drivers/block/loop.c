@@ -87,6 +87,9 @@ static DEFINE_MUTEX(loop_ctl_mutex);
 
 static int max_part;
 static int part_shift;
+#define LOOP_DEFAULT_HW_QUEUES	8
+static unsigned int hw_queues;
+static bool auto_dio = true;
 
 static int transfer_xor(struct loop_device *lo, int cmd,
 			struct page *raw_page, unsigned raw_off,
@@ -910,8 +913,15 @@ static void loop_config_discard(struct loop_device *lo)
 
 static void loop_unprepare_queue(struct loop_device *lo)
 {
-	kthread_flush_worker(&lo->worker);
-	kthread_stop(lo->worker_task);
+	unsigned int i;
+
+	for (i = 0; i < lo->nr_workers; i++) {
+		kthread_flush_worker(&lo->workers[i].worker);
+		kthread_stop(lo->workers[i].task);
+	}
+	kfree(lo->workers);
+	lo->workers = NULL;
+	lo->nr_workers = 0;
 }
 
 static int loop_kthread_worker_fn(void *worker_ptr)
@@ -920,15 +930,40 @@ static int loop_kthread_worker_fn(void *worker_ptr)
 	return kthread_worker_fn(worker_ptr);
 }
 
+/*
+ * Each hw queue gets its own worker, so that requests submitted from
+ * different CPUs are handed to the backing file in parallel.
+ */
 static int loop_prepare_queue(struct loop_device *lo)
 {
-	kthread_init_worker(&lo->worker);
-	lo->worker_task = kthread_run(loop_kthread_worker_fn,
-			&lo->worker, "loop%d", lo->lo_number);
-	if (IS_ERR(lo->worker_task))
+	unsigned int nr = lo->tag_set.nr_hw_queues;
+	struct loop_worker *w;
+	unsigned int i;
+
+	lo->workers = kcalloc(nr, sizeof(*lo->workers), GFP_KERNEL);
+	if (!lo->workers)
 		return -ENOMEM;
-	set_user_nice(lo->worker_task, MIN_NICE);
+
+	for (i = 0; i < nr; i++) {
+		w = &lo->workers[i];
+		kthread_init_worker(&w->worker);
+		if (nr == 1)
+			w->task = kthread_run(loop_kthread_worker_fn,
+					&w->worker, "loop%d", lo->lo_number);
+		else
+			w->task = kthread_run(loop_kthread_worker_fn,
+					&w->worker, "loop%d/%u",
+					lo->lo_number, i);
+		if (IS_ERR(w->task))
+			goto out_stop;
+		set_user_nice(w->task, MIN_NICE);
+		lo->nr_workers++;
+	}
 	return 0;
+
+out_stop:
+	loop_unprepare_queue(lo);
+	return -ENOMEM;
 }
 
 static int loop_set_fd(struct loop_device *lo, fmode_t mode,
@@ -994,7 +1029,12 @@ static int loop_set_fd(struct loop_device *lo, fmode_t mode,
 	if (!(lo_flags & LO_FLAGS_READ_ONLY) && file->f_op->fsync)
 		blk_queue_write_cache(lo->lo_queue, true, false);
 
-	loop_update_dio(lo);
+	/*
+	 * Use direct I/O whenever the backing file allows it, this avoids
+	 * caching the data twice and lets lo_rw_aio() keep many requests in
+	 * flight on the backing file.
+	 */
+	__loop_update_dio(lo, io_is_direct(file) || auto_dio);
 	set_capacity(lo->lo_disk, size);
 	bd_set_size(bdev, size << 9);
 	loop_sysfs_init(lo);
@@ -1831,6 +1871,10 @@ module_param(max_loop, int, 0444);
 MODULE_PARM_DESC(max_loop, "Maximum number of loop devices");
 module_param(max_part, int, 0444);
 MODULE_PARM_DESC(max_part, "Maximum number of partitions per loop device");
+module_param(hw_queues, uint, 0444);
+MODULE_PARM_DESC(hw_queues, "Number of hw queues and workers per loop device (default: number of online CPUs, at most 8)");
+module_param(auto_dio, bool, 0644);
+MODULE_PARM_DESC(auto_dio, "Use direct I/O on the backing file when it allows it (default: true)");
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_BLOCKDEV_MAJOR(LOOP_MAJOR);
 
@@ -1903,7 +1947,7 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 	} else
 #endif
 		cmd->css = NULL;
-	kthread_queue_work(&lo->worker, &cmd->work);
+	kthread_queue_work(&lo->workers[hctx->queue_num].worker, &cmd->work);
 
 	return BLK_STS_OK;
 }
@@ -1979,7 +2023,7 @@ static int loop_add(struct loop_device **l, int i)
 
 	err = -ENOMEM;
 	lo->tag_set.ops = &loop_mq_ops;
-	lo->tag_set.nr_hw_queues = 1;
+	lo->tag_set.nr_hw_queues = hw_queues;
 	lo->tag_set.queue_depth = 128;
 	lo->tag_set.numa_node = NUMA_NO_NODE;
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
@@ -2221,6 +2265,11 @@ static int __init loop_init(void)
 		goto err_out;
 	}
 
+	if (!hw_queues)
+		hw_queues = min_t(unsigned int, num_online_cpus(),
+				  LOOP_DEFAULT_HW_QUEUES);
+	hw_queues = min_t(unsigned int, hw_queues, nr_cpu_ids);
+
 	/*
 	 * If max_loop is specified, create that many devices upfront.
 	 * This also becomes a hard limit. If max_loop is not specified,
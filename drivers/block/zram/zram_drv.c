@@ -50,8 +50,15 @@ static unsigned int num_devices = 1;
  * uncompressed in memory.
  */
 static size_t huge_class_size;
+/*
+ * Pages a CPU's compression worker may have outstanding before
+ * zram_rw_page() goes back to compressing in the caller.
+ */
+#define ZRAM_ASYNC_MAX_DEPTH	256
 
 static void zram_free_page(struct zram *zram, size_t index);
+static int zram_read_from_zspool(struct zram *zram, struct page *page,
+				u32 index);
 
 static int zram_slot_trylock(struct zram *zram, u32 index)
 {
@@ -810,6 +817,89 @@ static ssize_t comp_algorithm_store(struct device *dev,
 	return len;
 }
 
+static ssize_t recomp_algorithm_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	size_t sz;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	sz = zcomp_available_show(zram->recomp_compressor, buf);
+	up_read(&zram->init_lock);
+
+	return sz;
+}
+
+/*
+ * The secondary algorithm is only used by recompress_store(), writing
+ * "none" (or an empty string) disables it again.
+ */
+static ssize_t recomp_algorithm_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char compressor[ARRAY_SIZE(zram->recomp_compressor)];
+	size_t sz;
+
+	strlcpy(compressor, buf, sizeof(compressor));
+	/* ignore trailing newline */
+	sz = strlen(compressor);
+	if (sz > 0 && compressor[sz - 1] == '\n')
+		compressor[sz - 1] = 0x00;
+
+	if (!strcmp(compressor, "none"))
+		compressor[0] = 0x00;
+	else if (compressor[0] && !zcomp_available_algorithm(compressor))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change algorithm for initialized device\n");
+		return -EBUSY;
+	}
+
+	strcpy(zram->recomp_compressor, compressor);
+	up_write(&zram->init_lock);
+	return len;
+}
+
+static ssize_t async_comp_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+
+	down_read(&zram->init_lock);
+	val = zram->async_comp;
+	up_read(&zram->init_lock);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", val);
+}
+
+static ssize_t async_comp_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	bool val;
+	int ret;
+
+	ret = kstrtobool(buf, &val);
+	if (ret)
+		return ret;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change async_comp for initialized device\n");
+		return -EBUSY;
+	}
+
+	zram->async_comp = val;
+	up_write(&zram->init_lock);
+	return len;
+}
+
 static ssize_t compact_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
@@ -827,6 +917,155 @@ static ssize_t compact_store(struct device *dev,
 	return len;
 }
 
+/*
+ * Writing "all" marks every page currently stored in memory idle. Any
+ * later read or write of the page clears the mark again, so the pages
+ * still idle at the next recompress_store() have gone cold since.
+ */
+static ssize_t idle_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages;
+	unsigned long index;
+
+	if (!sysfs_streq(buf, "all"))
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram)) {
+		up_read(&zram->init_lock);
+		return -EINVAL;
+	}
+
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		zram_slot_lock(zram, index);
+		if (zram_allocated(zram, index) &&
+		    !zram_test_flag(zram, index, ZRAM_WB) &&
+		    !zram_test_flag(zram, index, ZRAM_SAME))
+			zram_set_flag(zram, index, ZRAM_IDLE);
+		zram_slot_unlock(zram, index);
+	}
+	up_read(&zram->init_lock);
+
+	return len;
+}
+
+/*
+ * Recompress one slot with the secondary algorithm, with the slot lock
+ * held. The slot is left alone unless the new object is smaller.
+ */
+static int zram_recompress(struct zram *zram, u32 index, struct page *page)
+{
+	unsigned long handle, old_handle;
+	unsigned int comp_len, old_len;
+	struct zcomp_strm *zstrm;
+	void *src, *dst;
+	int ret;
+
+	ret = zram_read_from_zspool(zram, page, index);
+	if (ret)
+		return ret;
+
+	old_handle = zram_get_handle(zram, index);
+	old_len = zram_get_obj_size(zram, index);
+
+	zstrm = zcomp_stream_get(zram->recomp);
+	src = kmap_atomic(page);
+	ret = zcomp_compress(zstrm, src, &comp_len);
+	kunmap_atomic(src);
+
+	if (ret || comp_len >= old_len || comp_len >= huge_class_size) {
+		zcomp_stream_put(zram->recomp);
+		return ret;
+	}
+
+	/* we hold the slot lock, so this must not enter direct reclaim */
+	handle = zs_malloc(zram->mem_pool, comp_len,
+			__GFP_KSWAPD_RECLAIM |
+			__GFP_NOWARN |
+			__GFP_HIGHMEM |
+			__GFP_MOVABLE);
+	if (!handle) {
+		zcomp_stream_put(zram->recomp);
+		return -ENOMEM;
+	}
+
+	dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
+	memcpy(dst, zstrm->buffer, comp_len);
+	zs_unmap_object(zram->mem_pool, handle);
+	zcomp_stream_put(zram->recomp);
+
+	zs_free(zram->mem_pool, old_handle);
+	atomic64_sub(old_len, &zram->stats.compr_data_size);
+	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (zram_test_flag(zram, index, ZRAM_HUGE)) {
+		zram_clear_flag(zram, index, ZRAM_HUGE);
+		atomic64_dec(&zram->stats.huge_pages);
+	}
+
+	zram_set_handle(zram, index, handle);
+	zram_set_obj_size(zram, index, comp_len);
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+	zram_set_flag(zram, index, ZRAM_RECOMP);
+	atomic64_inc(&zram->stats.recomp_pages);
+
+	return 0;
+}
+
+/*
+ * Writing "idle" recompresses the pages left idle since the last
+ * idle_store(), "huge" the pages the primary algorithm stored
+ * uncompressed. Needs recomp_algorithm to be set before disksize.
+ */
+static ssize_t recompress_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	enum zram_pageflags mode;
+	unsigned long nr_pages;
+	unsigned long index;
+	struct page *page;
+	ssize_t ret = len;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = ZRAM_IDLE;
+	else if (sysfs_streq(buf, "huge"))
+		mode = ZRAM_HUGE;
+	else
+		return -EINVAL;
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram) || !zram->recomp) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	nr_pages = zram->disksize >> PAGE_SHIFT;
+	for (index = 0; index < nr_pages; index++) {
+		zram_slot_lock(zram, index);
+		if (zram_get_handle(zram, index) &&
+		    zram_test_flag(zram, index, mode) &&
+		    !zram_test_flag(zram, index, ZRAM_WB) &&
+		    !zram_test_flag(zram, index, ZRAM_SAME) &&
+		    !zram_test_flag(zram, index, ZRAM_RECOMP))
+			zram_recompress(zram, index, page);
+		zram_slot_unlock(zram, index);
+		cond_resched();
+	}
+out:
+	up_read(&zram->init_lock);
+	__free_page(page);
+
+	return ret;
+}
+
 static ssize_t io_stat_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
@@ -866,7 +1105,7 @@ static ssize_t mm_stat_show(struct device *dev,
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -874,7 +1113,9 @@ static ssize_t mm_stat_show(struct device *dev,
 			max_used << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			pool_stats.pages_compacted,
-			(u64)atomic64_read(&zram->stats.huge_pages));
+			(u64)atomic64_read(&zram->stats.huge_pages),
+			(u64)atomic64_read(&zram->stats.async_writes),
+			(u64)atomic64_read(&zram->stats.recomp_pages));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -945,6 +1186,12 @@ static void zram_free_page(struct zram *zram, size_t index)
 	unsigned long handle;
 
 	zram_reset_access(zram, index);
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+
+	if (zram_test_flag(zram, index, ZRAM_RECOMP)) {
+		zram_clear_flag(zram, index, ZRAM_RECOMP);
+		atomic64_dec(&zram->stats.recomp_pages);
+	}
 
 	if (zram_test_flag(zram, index, ZRAM_HUGE)) {
 		zram_clear_flag(zram, index, ZRAM_HUGE);
@@ -983,13 +1230,46 @@ static void zram_free_page(struct zram *zram, size_t index)
 	zram_set_obj_size(zram, index, 0);
 }
 
+/*
+ * Decompress a zsmalloc backed slot into @page, with the slot lock held.
+ * Slots rewritten by recompress_store() go through the secondary streams.
+ */
+static int zram_read_from_zspool(struct zram *zram, struct page *page,
+				u32 index)
+{
+	unsigned long handle = zram_get_handle(zram, index);
+	unsigned int size = zram_get_obj_size(zram, index);
+	struct zcomp *comp;
+	void *src, *dst;
+	int ret;
+
+	comp = zram_test_flag(zram, index, ZRAM_RECOMP) ?
+		zram->recomp : zram->comp;
+
+	src = zs_map_object(zram->mem_pool, handle, ZS_MM_RO);
+	if (size == PAGE_SIZE) {
+		dst = kmap_atomic(page);
+		memcpy(dst, src, PAGE_SIZE);
+		kunmap_atomic(dst);
+		ret = 0;
+	} else {
+		struct zcomp_strm *zstrm = zcomp_stream_get(comp);
+
+		dst = kmap_atomic(page);
+		ret = zcomp_decompress(zstrm, src, size, dst);
+		kunmap_atomic(dst);
+		zcomp_stream_put(comp);
+	}
+	zs_unmap_object(zram->mem_pool, handle);
+
+	return ret;
+}
+
 static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 				struct bio *bio, bool partial_io)
 {
 	int ret;
 	unsigned long handle;
-	unsigned int size;
-	void *src, *dst;
 
 	if (zram_wb_enabled(zram)) {
 		zram_slot_lock(zram, index);
@@ -1022,23 +1302,8 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		return 0;
 	}
 
-	size = zram_get_obj_size(zram, index);
-
-	src = zs_map_object(zram->mem_pool, handle, ZS_MM_RO);
-	if (size == PAGE_SIZE) {
-		dst = kmap_atomic(page);
-		memcpy(dst, src, PAGE_SIZE);
-		kunmap_atomic(dst);
-		ret = 0;
-	} else {
-		struct zcomp_strm *zstrm = zcomp_stream_get(zram->comp);
-
-		dst = kmap_atomic(page);
-		ret = zcomp_decompress(zstrm, src, size, dst);
-		kunmap_atomic(dst);
-		zcomp_stream_put(zram->comp);
-	}
-	zs_unmap_object(zram->mem_pool, handle);
+	zram_clear_flag(zram, index, ZRAM_IDLE);
+	ret = zram_read_from_zspool(zram, page, index);
 	zram_slot_unlock(zram, index);
 
 	/* Should NEVER happen. Return bio error if it does. */
@@ -1414,6 +1679,129 @@ static void zram_slot_free_notify(struct block_device *bdev,
 	zram_slot_unlock(zram, index);
 }
 
+static void zram_async_work(struct work_struct *work)
+{
+	struct zram_async_queue *q = container_of(work,
+					struct zram_async_queue, work);
+	struct zram *zram = q->zram;
+	struct zram_async_req *req, *tmp;
+	LIST_HEAD(list);
+
+	spin_lock(&q->lock);
+	list_splice_init(&q->list, &list);
+	q->depth = 0;
+	spin_unlock(&q->lock);
+
+	list_for_each_entry_safe(req, tmp, &list, list) {
+		struct page *page = req->page;
+		u32 index = req->index;
+		struct bio_vec bv;
+		int ret;
+
+		bv.bv_page = page;
+		bv.bv_len = PAGE_SIZE;
+		bv.bv_offset = 0;
+
+		ret = zram_bvec_rw(zram, &bv, index, 0, REQ_OP_WRITE, NULL);
+		atomic64_inc(&zram->stats.async_writes);
+		kfree(req);
+
+		/* a write to the backing device ends the page from its bio */
+		if (ret == 1)
+			continue;
+
+		/*
+		 * rw_page has already reported success, so there is no bio
+		 * to fall back to. Redirty the page the way the swap bio
+		 * completion does so that reclaim writes it again later.
+		 */
+		if (unlikely(ret < 0)) {
+			SetPageError(page);
+			set_page_dirty(page);
+			ClearPageReclaim(page);
+			pr_err_ratelimited("Async write failed! err=%d, page=%u\n",
+					ret, index);
+		}
+		end_page_writeback(page);
+	}
+}
+
+/*
+ * Queue a page under writeback to this CPU's compression worker. Returns
+ * false when the caller has to compress it synchronously instead: the
+ * request could not be allocated or the worker is already too far behind.
+ */
+static bool zram_async_submit(struct zram *zram, struct page *page, u32 index)
+{
+	struct zram_async_queue *q;
+	struct zram_async_req *req;
+	bool queued = false;
+
+	req = kmalloc(sizeof(*req), GFP_NOWAIT | __GFP_NOWARN);
+	if (!req)
+		return false;
+
+	req->page = page;
+	req->index = index;
+
+	q = get_cpu_ptr(zram->async_queue);
+	spin_lock(&q->lock);
+	if (q->depth < ZRAM_ASYNC_MAX_DEPTH) {
+		list_add_tail(&req->list, &q->list);
+		q->depth++;
+		queued = true;
+	}
+	spin_unlock(&q->lock);
+	if (queued)
+		queue_work_on(smp_processor_id(), zram->async_wq, &q->work);
+	put_cpu_ptr(zram->async_queue);
+
+	if (!queued)
+		kfree(req);
+	return queued;
+}
+
+static void zram_async_destroy(struct zram *zram)
+{
+	if (!zram->async_wq)
+		return;
+
+	/* flushes the pending work of every CPU before going away */
+	destroy_workqueue(zram->async_wq);
+	free_percpu(zram->async_queue);
+	zram->async_wq = NULL;
+	zram->async_queue = NULL;
+}
+
+static int zram_async_init(struct zram *zram)
+{
+	struct zram_async_queue *q;
+	int cpu;
+
+	zram->async_queue = alloc_percpu(struct zram_async_queue);
+	if (!zram->async_queue)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		q = per_cpu_ptr(zram->async_queue, cpu);
+		spin_lock_init(&q->lock);
+		INIT_LIST_HEAD(&q->list);
+		INIT_WORK(&q->work, zram_async_work);
+		q->zram = zram;
+	}
+
+	zram->async_wq = alloc_workqueue("%s_comp",
+					WQ_MEM_RECLAIM | WQ_HIGHPRI, 0,
+					zram->disk->disk_name);
+	if (!zram->async_wq) {
+		free_percpu(zram->async_queue);
+		zram->async_queue = NULL;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
 static int zram_rw_page(struct block_device *bdev, sector_t sector,
 		       struct page *page, unsigned int op)
 {
@@ -1439,6 +1827,10 @@ static int zram_rw_page(struct block_device *bdev, sector_t sector,
 	bv.bv_len = PAGE_SIZE;
 	bv.bv_offset = 0;
 
+	if (zram->async_wq && op_is_write(op) &&
+	    zram_async_submit(zram, page, index))
+		return 0;
+
 	ret = zram_bvec_rw(zram, &bv, index, offset, op, NULL);
 out:
 	/*
@@ -1487,10 +1879,15 @@ static void zram_reset_device(struct zram *zram)
 	part_stat_set_all(&zram->disk->part0, 0);
 
 	up_write(&zram->init_lock);
+	zram_async_destroy(zram);
 	/* I/O operation under all of CPU are done so let's free */
 	zram_meta_free(zram, disksize);
 	memset(&zram->stats, 0, sizeof(zram->stats));
 	zcomp_destroy(comp);
+	if (zram->recomp) {
+		zcomp_destroy(zram->recomp);
+		zram->recomp = NULL;
+	}
 	reset_bdev(zram);
 }
 
@@ -1527,6 +1924,23 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_free_meta;
 	}
 
+	if (zram->recomp_compressor[0]) {
+		zram->recomp = zcomp_create(zram->recomp_compressor);
+		if (IS_ERR(zram->recomp)) {
+			pr_err("Cannot initialise %s compressing backend\n",
+					zram->recomp_compressor);
+			err = PTR_ERR(zram->recomp);
+			zram->recomp = NULL;
+			goto out_free_comp;
+		}
+	}
+
+	if (zram->async_comp) {
+		err = zram_async_init(zram);
+		if (err)
+			goto out_free_recomp;
+	}
+
 	zram->comp = comp;
 	zram->disksize = disksize;
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
@@ -1536,6 +1950,13 @@ static ssize_t disksize_store(struct device *dev,
 
 	return len;
 
+out_free_recomp:
+	if (zram->recomp) {
+		zcomp_destroy(zram->recomp);
+		zram->recomp = NULL;
+	}
+out_free_comp:
+	zcomp_destroy(comp);
 out_free_meta:
 	zram_meta_free(zram, disksize);
 out_unlock:
@@ -1618,6 +2039,10 @@ static DEVICE_ATTR_WO(mem_limit);
 static DEVICE_ATTR_WO(mem_used_max);
 static DEVICE_ATTR_RW(max_comp_streams);
 static DEVICE_ATTR_RW(comp_algorithm);
+static DEVICE_ATTR_RW(recomp_algorithm);
+static DEVICE_ATTR_RW(async_comp);
+static DEVICE_ATTR_WO(idle);
+static DEVICE_ATTR_WO(recompress);
 #ifdef CONFIG_ZRAM_WRITEBACK
 static DEVICE_ATTR_RW(backing_dev);
 #endif
@@ -1631,6 +2056,10 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_mem_used_max.attr,
 	&dev_attr_max_comp_streams.attr,
 	&dev_attr_comp_algorithm.attr,
+	&dev_attr_recomp_algorithm.attr,
+	&dev_attr_async_comp.attr,
+	&dev_attr_idle.attr,
+	&dev_attr_recompress.attr,
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
 #endif
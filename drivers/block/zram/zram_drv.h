@@ -18,6 +18,7 @@
 #include <linux/rwsem.h>
 #include <linux/zsmalloc.h>
 #include <linux/crypto.h>
+#include <linux/workqueue.h>
 
 #include "zcomp.h"
 
@@ -48,6 +49,8 @@ enum zram_pageflags {
 	ZRAM_SAME,	/* Page consists the same element */
 	ZRAM_WB,	/* page is stored on backing_device */
 	ZRAM_HUGE,	/* Incompressible page */
+	ZRAM_IDLE,	/* not accessed since the last idle marking */
+	ZRAM_RECOMP,	/* compressed with the secondary algorithm */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -80,12 +83,30 @@ struct zram_stats {
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
 	atomic64_t miss_free;		/* no. of missed free */
+	atomic64_t async_writes;	/* no. of pages compressed by workers */
+	atomic64_t recomp_pages;	/* no. of recompressed pages */
+};
+
+/* Pages handed from zram_rw_page() to a compression worker */
+struct zram_async_req {
+	struct list_head list;
+	struct page *page;
+	u32 index;
+};
+
+struct zram_async_queue {
+	spinlock_t lock;
+	struct list_head list;
+	unsigned int depth;
+	struct work_struct work;
+	struct zram *zram;
 };
 
 struct zram {
 	struct zram_table_entry *table;
 	struct zs_pool *mem_pool;
 	struct zcomp *comp;
+	struct zcomp *recomp;
 	struct gendisk *disk;
 	/* Prevent concurrent execution of device init */
 	struct rw_semaphore init_lock;
@@ -101,6 +122,12 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 	char compressor[CRYPTO_MAX_ALG_NAME];
+	/* optional stronger algorithm for recompressing cold pages */
+	char recomp_compressor[CRYPTO_MAX_ALG_NAME];
+	/* hand rw_page writes to per-CPU compression workers */
+	bool async_comp;
+	struct zram_async_queue __percpu *async_queue;
+	struct workqueue_struct *async_wq;
 	/*
 	 * zram is claimed so open request will be failed
 	 */
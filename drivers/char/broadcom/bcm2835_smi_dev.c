@@ -44,6 +44,10 @@
 #include <linux/fs.h>
 #include <linux/cdev.h>
 #include <linux/fs.h>
+#include <linux/dma-mapping.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/wait.h>
 
 #include <linux/broadcom/bcm2835_smi.h>
 
@@ -58,6 +62,17 @@ static struct device *bcm2835_smi_dev;
 
 struct bcm2835_smi_dev_instance {
 	struct device *dev;
+
+	/* streaming mode, see struct smi_stream_config */
+	struct mutex stream_lock;
+	struct file *stream_file;
+	bool streaming;
+	struct smi_stream_ctrl *stream_ctrl;
+	void *stream_buf;
+	dma_addr_t stream_phys;
+	size_t stream_buffer_size;
+	unsigned int stream_buffer_count;
+	wait_queue_head_t stream_wait;
 };
 
 static struct bcm2835_smi_instance *smi_inst;
@@ -66,9 +81,128 @@ static struct bcm2835_smi_dev_instance *inst;
 static const char *const ioctl_names[] = {
 	"READ_SETTINGS",
 	"WRITE_SETTINGS",
-	"ADDRESS"
+	"ADDRESS",
+	"STREAM_SETUP",
+	"STREAM_START",
+	"STREAM_STOP"
 };
 
+/****************************************************************************
+*
+*   SMI streaming mode
+*
+***************************************************************************/
+
+static size_t smi_stream_size(void)
+{
+	return inst->stream_buffer_size * inst->stream_buffer_count;
+}
+
+/* Called from the DMA tasklet with the number of buffers filled */
+static void smi_stream_buffer_done(void *param, unsigned int periods)
+{
+	struct smi_stream_ctrl *ctrl = inst->stream_ctrl;
+	u32 producer = ctrl->producer + periods;
+
+	if (producer - READ_ONCE(ctrl->consumer) > inst->stream_buffer_count)
+		WRITE_ONCE(ctrl->overruns, ctrl->overruns + 1);
+	/* the buffer contents are coherent, order only the index update */
+	smp_store_release(&ctrl->producer, producer);
+
+	wake_up_interruptible(&inst->stream_wait);
+}
+
+static void smi_stream_stop(void)
+{
+	if (!inst->streaming)
+		return;
+
+	bcm2835_smi_stream_stop(smi_inst);
+	inst->streaming = false;
+	wake_up_interruptible(&inst->stream_wait);
+}
+
+static void smi_stream_free(void)
+{
+	smi_stream_stop();
+
+	if (inst->stream_buf)
+		dma_free_coherent(bcm2835_smi_dma_dev(smi_inst),
+				  smi_stream_size(), inst->stream_buf,
+				  inst->stream_phys);
+	free_page((unsigned long)inst->stream_ctrl);
+	inst->stream_buf = NULL;
+	inst->stream_ctrl = NULL;
+	inst->stream_file = NULL;
+}
+
+static long smi_stream_setup(struct file *file, void __user *arg)
+{
+	struct smi_stream_config config;
+
+	if (copy_from_user(&config, arg, sizeof(config)))
+		return -EFAULT;
+
+	if (!config.buffer_size || !PAGE_ALIGNED(config.buffer_size) ||
+	    config.buffer_count < 2 ||
+	    config.buffer_count > SMI_STREAM_MAX_BUFFERS ||
+	    config.buffer_size > SMI_STREAM_MAX_SIZE / config.buffer_count)
+		return -EINVAL;
+
+	/* the ring may be mapped already and is only freed on release */
+	if (inst->stream_file)
+		return -EBUSY;
+
+	inst->stream_ctrl = (struct smi_stream_ctrl *)get_zeroed_page(
+		GFP_KERNEL);
+	if (!inst->stream_ctrl)
+		return -ENOMEM;
+
+	inst->stream_buffer_size = config.buffer_size;
+	inst->stream_buffer_count = config.buffer_count;
+	inst->stream_buf = dma_alloc_coherent(bcm2835_smi_dma_dev(smi_inst),
+					      smi_stream_size(),
+					      &inst->stream_phys, GFP_KERNEL);
+	if (!inst->stream_buf) {
+		dev_err(inst->dev, "could not allocate %zu byte stream ring",
+			smi_stream_size());
+		free_page((unsigned long)inst->stream_ctrl);
+		inst->stream_ctrl = NULL;
+		return -ENOMEM;
+	}
+	inst->stream_file = file;
+
+	config.ctrl_offset = 0;
+	config.ring_offset = PAGE_SIZE;
+	if (copy_to_user(arg, &config, sizeof(config)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static long smi_stream_start(struct file *file)
+{
+	int ret;
+
+	if (inst->stream_file != file)
+		return -EINVAL;
+	if (inst->streaming)
+		return -EBUSY;
+
+	WRITE_ONCE(inst->stream_ctrl->producer, 0);
+	WRITE_ONCE(inst->stream_ctrl->consumer, 0);
+	WRITE_ONCE(inst->stream_ctrl->overruns, 0);
+
+	ret = bcm2835_smi_stream_start(smi_inst, inst->stream_phys,
+				       smi_stream_size(),
+				       inst->stream_buffer_size,
+				       smi_stream_buffer_done, NULL);
+	if (!ret)
+		inst->streaming = true;
+
+	return ret;
+}
+
 /****************************************************************************
 *
 *   SMI chardev file ops
@@ -108,6 +242,24 @@ bcm2835_smi_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		dev_info(inst->dev, "SMI address set: 0x%02x", (int)arg);
 		bcm2835_smi_set_address(smi_inst, arg);
 		break;
+	case BCM2835_SMI_IOC_STREAM_SETUP:
+		mutex_lock(&inst->stream_lock);
+		ret = smi_stream_setup(file, (void __user *)arg);
+		mutex_unlock(&inst->stream_lock);
+		break;
+	case BCM2835_SMI_IOC_STREAM_START:
+		mutex_lock(&inst->stream_lock);
+		ret = smi_stream_start(file);
+		mutex_unlock(&inst->stream_lock);
+		break;
+	case BCM2835_SMI_IOC_STREAM_STOP:
+		mutex_lock(&inst->stream_lock);
+		if (inst->stream_file == file)
+			smi_stream_stop();
+		else
+			ret = -EINVAL;
+		mutex_unlock(&inst->stream_lock);
+		break;
 	default:
 		dev_err(inst->dev, "invalid ioctl cmd: %d", cmd);
 		ret = -ENOTTY;
@@ -143,6 +295,60 @@ static int bcm2835_smi_release(struct inode *inode, struct file *file)
 		return -ENXIO;
 	}
 
+	mutex_lock(&inst->stream_lock);
+	if (inst->stream_file == file)
+		smi_stream_free();
+	mutex_unlock(&inst->stream_lock);
+
+	return 0;
+}
+
+/* Offset 0 maps the control page, the ring follows at PAGE_SIZE */
+static int bcm2835_smi_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	size_t size = vma->vm_end - vma->vm_start;
+	int ret = -EINVAL;
+
+	mutex_lock(&inst->stream_lock);
+	if (inst->stream_file != file)
+		goto out;
+
+	if (vma->vm_pgoff == 0) {
+		if (size != PAGE_SIZE)
+			goto out;
+		ret = remap_pfn_range(vma, vma->vm_start,
+				      virt_to_phys(inst->stream_ctrl) >>
+				      PAGE_SHIFT, size, vma->vm_page_prot);
+	} else if (vma->vm_pgoff == 1) {
+		if (size != smi_stream_size())
+			goto out;
+		/* dma_mmap_coherent() takes vm_pgoff as offset into the ring */
+		vma->vm_pgoff = 0;
+		ret = dma_mmap_coherent(bcm2835_smi_dma_dev(smi_inst), vma,
+					inst->stream_buf, inst->stream_phys,
+					size);
+	}
+out:
+	mutex_unlock(&inst->stream_lock);
+	return ret;
+}
+
+static __poll_t bcm2835_smi_poll(struct file *file, poll_table *wait)
+{
+	struct smi_stream_ctrl *ctrl;
+
+	if (inst->stream_file != file)
+		return EPOLLIN | EPOLLRDNORM | EPOLLOUT | EPOLLWRNORM;
+
+	poll_wait(file, &inst->stream_wait, wait);
+
+	ctrl = inst->stream_ctrl;
+	/* pairs with the release in smi_stream_buffer_done() */
+	if (smp_load_acquire(&ctrl->producer) != READ_ONCE(ctrl->consumer))
+		return EPOLLIN | EPOLLRDNORM;
+	if (!inst->streaming)
+		return EPOLLHUP;
+
 	return 0;
 }
 
@@ -192,6 +398,9 @@ bcm2835_read_file(struct file *f, char __user *user_ptr,
 {
 	int odd_bytes;
 
+	if (inst->streaming)
+		return -EBUSY;
+
 	dev_dbg(inst->dev, "User reading %d bytes from SMI.", count);
 	/* We don't want to DMA a number of bytes % 4 != 0 (32 bit FIFO) */
 	if (count > DMA_THRESHOLD_BYTES)
@@ -228,6 +437,9 @@ bcm2835_write_file(struct file *f, const char __user *user_ptr,
 {
 	int odd_bytes;
 
+	if (inst->streaming)
+		return -EBUSY;
+
 	dev_dbg(inst->dev, "User writing %d bytes to SMI.", count);
 	if (count > DMA_THRESHOLD_BYTES)
 		odd_bytes = count & 0x3;
@@ -265,6 +477,8 @@ bcm2835_smi_fops = {
 	.release = bcm2835_smi_release,
 	.read = bcm2835_read_file,
 	.write = bcm2835_write_file,
+	.mmap = bcm2835_smi_mmap,
+	.poll = bcm2835_smi_poll,
 };
 
 
@@ -306,6 +520,8 @@ static int bcm2835_smi_dev_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	inst->dev = dev;
+	mutex_init(&inst->stream_lock);
+	init_waitqueue_head(&inst->stream_wait);
 
 	/* Create character device entries */
 
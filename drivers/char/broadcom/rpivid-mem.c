@@ -47,10 +47,31 @@
 #include <linux/cdev.h>
 #include <linux/pagemap.h>
 #include <linux/io.h>
+#include <linux/dma-buf.h>
+#include <linux/interrupt.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
 
 #define DRIVER_NAME "rpivid-mem"
 #define DEVICE_MINOR 0
 
+/*
+ * Import a dma-buf for the decoder. On return @handle identifies the
+ * import for RPIVID_MEM_IOC_RELEASE and @dma_addr is where the decoder sees
+ * the buffer. The buffer stays mapped until released or the file is closed.
+ */
+struct rpivid_mem_import {
+	__s32 fd;
+	__u32 handle;
+	__u64 dma_addr;
+	__u64 size;
+};
+
+#define RPIVID_MEM_IOC_MAGIC 'R'
+#define RPIVID_MEM_IOC_IMPORT	_IOWR(RPIVID_MEM_IOC_MAGIC, 0x40, \
+				      struct rpivid_mem_import)
+#define RPIVID_MEM_IOC_RELEASE	_IOW(RPIVID_MEM_IOC_MAGIC, 0x41, __u32)
+
 struct rpivid_mem_priv {
 	dev_t devid;
 	struct class *class;
@@ -59,35 +80,281 @@ struct rpivid_mem_priv {
 	unsigned long mem_window_len;
 	struct device *dev;
 	const char *name;
+
+	/* interrupt delivery, only if the node has an interrupt */
+	int irq;
+	spinlock_t irq_lock;	/* protects irq_disabled */
+	bool irq_disabled;
+	atomic_t event;
+	wait_queue_head_t wait;
+};
+
+struct rpivid_mem_buf {
+	struct list_head node;
+	u32 handle;
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+};
+
+struct rpivid_mem_file {
+	struct rpivid_mem_priv *priv;
+	u32 event_count;
+	struct mutex lock;	/* protects bufs and next_handle */
+	struct list_head bufs;
+	u32 next_handle;
 };
 
+/*
+ * The interrupt stays disabled from when it fires until userspace has
+ * cleared the status in the mapped registers and written 1 to the device,
+ * so a level interrupt can't storm while the decoder is being serviced.
+ * The line is shared with the other decoder blocks and the driver cannot
+ * tell whose interrupt it is, so every interrupt is passed on; userspace
+ * finds out from the status registers whether it has anything to do.
+ */
+static irqreturn_t rpivid_mem_irq(int irq, void *data)
+{
+	struct rpivid_mem_priv *priv = data;
+
+	spin_lock(&priv->irq_lock);
+	if (!priv->irq_disabled) {
+		disable_irq_nosync(irq);
+		priv->irq_disabled = true;
+	}
+	spin_unlock(&priv->irq_lock);
+
+	atomic_inc(&priv->event);
+	wake_up_interruptible(&priv->wait);
+
+	return IRQ_HANDLED;
+}
+
+static void rpivid_mem_buf_free(struct rpivid_mem_buf *buf)
+{
+	dma_buf_unmap_attachment(buf->attach, buf->sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(buf->dmabuf, buf->attach);
+	dma_buf_put(buf->dmabuf);
+	kfree(buf);
+}
+
 static int rpivid_mem_open(struct inode *inode, struct file *file)
 {
 	int dev = iminor(inode);
-	int ret = 0;
 	struct rpivid_mem_priv *priv;
+	struct rpivid_mem_file *mf;
+
 	if (dev != DEVICE_MINOR && dev != DEVICE_MINOR + 1)
-		ret = -ENXIO;
+		return -ENXIO;
 
 	priv = container_of(inode->i_cdev, struct rpivid_mem_priv,
 				rpivid_mem_cdev);
 	if (!priv)
 		return -EINVAL;
-	file->private_data = priv;
-	return ret;
+
+	mf = kzalloc(sizeof(*mf), GFP_KERNEL);
+	if (!mf)
+		return -ENOMEM;
+
+	mf->priv = priv;
+	mf->event_count = atomic_read(&priv->event);
+	mutex_init(&mf->lock);
+	INIT_LIST_HEAD(&mf->bufs);
+	file->private_data = mf;
+
+	return 0;
 }
 
 static int rpivid_mem_release(struct inode *inode, struct file *file)
 {
-	int dev = iminor(inode);
-	int ret = 0;
+	struct rpivid_mem_file *mf = file->private_data;
+	struct rpivid_mem_buf *buf, *tmp;
 
-	if (dev != DEVICE_MINOR && dev != DEVICE_MINOR + 1)
-		ret = -ENXIO;
+	list_for_each_entry_safe(buf, tmp, &mf->bufs, node)
+		rpivid_mem_buf_free(buf);
+	kfree(mf);
+
+	return 0;
+}
+
+/* returns the number of interrupts so far, once it has moved on */
+static ssize_t rpivid_mem_read(struct file *file, char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	struct rpivid_mem_file *mf = file->private_data;
+	struct rpivid_mem_priv *priv = mf->priv;
+	u32 event;
+	int ret;
+
+	if (priv->irq <= 0)
+		return -EIO;
+	if (count != sizeof(event))
+		return -EINVAL;
+
+	for (;;) {
+		event = atomic_read(&priv->event);
+		if (event != mf->event_count)
+			break;
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		ret = wait_event_interruptible(priv->wait,
+				atomic_read(&priv->event) != mf->event_count);
+		if (ret)
+			return ret;
+	}
+
+	if (copy_to_user(ubuf, &event, sizeof(event)))
+		return -EFAULT;
+	mf->event_count = event;
+
+	return sizeof(event);
+}
 
+/* writing 1 re-enables the interrupt, 0 leaves it disabled */
+static ssize_t rpivid_mem_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	struct rpivid_mem_file *mf = file->private_data;
+	struct rpivid_mem_priv *priv = mf->priv;
+	unsigned long flags;
+	u32 enable;
+
+	if (priv->irq <= 0)
+		return -EIO;
+	if (count != sizeof(enable))
+		return -EINVAL;
+	if (copy_from_user(&enable, ubuf, sizeof(enable)))
+		return -EFAULT;
+
+	spin_lock_irqsave(&priv->irq_lock, flags);
+	if (enable && priv->irq_disabled) {
+		priv->irq_disabled = false;
+		enable_irq(priv->irq);
+	} else if (!enable && !priv->irq_disabled) {
+		priv->irq_disabled = true;
+		disable_irq_nosync(priv->irq);
+	}
+	spin_unlock_irqrestore(&priv->irq_lock, flags);
+
+	return sizeof(enable);
+}
+
+static __poll_t rpivid_mem_poll(struct file *file, poll_table *wait)
+{
+	struct rpivid_mem_file *mf = file->private_data;
+	struct rpivid_mem_priv *priv = mf->priv;
+
+	if (priv->irq <= 0)
+		return EPOLLERR;
+
+	poll_wait(file, &priv->wait, wait);
+	if (atomic_read(&priv->event) != mf->event_count)
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+static int rpivid_mem_import(struct rpivid_mem_file *mf, void __user *arg)
+{
+	struct rpivid_mem_priv *priv = mf->priv;
+	struct rpivid_mem_import imp;
+	struct rpivid_mem_buf *buf;
+	int ret;
+
+	if (copy_from_user(&imp, arg, sizeof(imp)))
+		return -EFAULT;
+
+	buf = kzalloc(sizeof(*buf), GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	buf->dmabuf = dma_buf_get(imp.fd);
+	if (IS_ERR(buf->dmabuf)) {
+		ret = PTR_ERR(buf->dmabuf);
+		goto err_free;
+	}
+
+	buf->attach = dma_buf_attach(buf->dmabuf, priv->dev);
+	if (IS_ERR(buf->attach)) {
+		ret = PTR_ERR(buf->attach);
+		goto err_put;
+	}
+
+	buf->sgt = dma_buf_map_attachment(buf->attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(buf->sgt)) {
+		ret = PTR_ERR(buf->sgt);
+		goto err_detach;
+	}
+
+	/* The decoder has no MMU, it needs one contiguous range */
+	if (buf->sgt->nents != 1) {
+		dev_dbg(priv->dev, "dma-buf is not contiguous\n");
+		ret = -EINVAL;
+		goto err_unmap;
+	}
+
+	mutex_lock(&mf->lock);
+	buf->handle = ++mf->next_handle;
+	list_add_tail(&buf->node, &mf->bufs);
+	mutex_unlock(&mf->lock);
+
+	imp.handle = buf->handle;
+	imp.dma_addr = sg_dma_address(buf->sgt->sgl);
+	imp.size = buf->dmabuf->size;
+	if (copy_to_user(arg, &imp, sizeof(imp))) {
+		mutex_lock(&mf->lock);
+		list_del(&buf->node);
+		mutex_unlock(&mf->lock);
+		rpivid_mem_buf_free(buf);
+		return -EFAULT;
+	}
+
+	return 0;
+
+err_unmap:
+	dma_buf_unmap_attachment(buf->attach, buf->sgt, DMA_BIDIRECTIONAL);
+err_detach:
+	dma_buf_detach(buf->dmabuf, buf->attach);
+err_put:
+	dma_buf_put(buf->dmabuf);
+err_free:
+	kfree(buf);
 	return ret;
 }
 
+static int rpivid_mem_release_buf(struct rpivid_mem_file *mf, u32 handle)
+{
+	struct rpivid_mem_buf *buf;
+
+	mutex_lock(&mf->lock);
+	list_for_each_entry(buf, &mf->bufs, node) {
+		if (buf->handle == handle) {
+			list_del(&buf->node);
+			mutex_unlock(&mf->lock);
+			rpivid_mem_buf_free(buf);
+			return 0;
+		}
+	}
+	mutex_unlock(&mf->lock);
+
+	return -ENOENT;
+}
+
+static long rpivid_mem_ioctl(struct file *file, unsigned int cmd,
+			     unsigned long arg)
+{
+	struct rpivid_mem_file *mf = file->private_data;
+
+	switch (cmd) {
+	case RPIVID_MEM_IOC_IMPORT:
+		return rpivid_mem_import(mf, (void __user *)arg);
+	case RPIVID_MEM_IOC_RELEASE:
+		return rpivid_mem_release_buf(mf, (u32)arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
 static const struct vm_operations_struct rpivid_mem_vm_ops = {
 #ifdef CONFIG_HAVE_IOREMAP_PROT
 	.access = generic_access_phys
@@ -96,10 +363,10 @@ static const struct vm_operations_struct rpivid_mem_vm_ops = {
 
 static int rpivid_mem_mmap(struct file *file, struct vm_area_struct *vma)
 {
-	struct rpivid_mem_priv *priv;
+	struct rpivid_mem_file *mf = file->private_data;
+	struct rpivid_mem_priv *priv = mf->priv;
 	unsigned long pages;
 
-	priv = file->private_data;
 	pages = priv->regs_phys >> PAGE_SHIFT;
 	/*
 	 * The address decode is far larger than the actual number of registers.
@@ -124,6 +391,11 @@ rpivid_mem_fops = {
 	.open = rpivid_mem_open,
 	.release = rpivid_mem_release,
 	.mmap = rpivid_mem_mmap,
+	.read = rpivid_mem_read,
+	.write = rpivid_mem_write,
+	.poll = rpivid_mem_poll,
+	.unlocked_ioctl = rpivid_mem_ioctl,
+	.compat_ioctl = rpivid_mem_ioctl,
 };
 
 static const struct of_device_id rpivid_mem_of_match[];
@@ -164,6 +436,23 @@ static int rpivid_mem_probe(struct platform_device *pdev)
 		goto failed_get_resource;
 	}
 
+	spin_lock_init(&priv->irq_lock);
+	init_waitqueue_head(&priv->wait);
+	priv->irq = platform_get_irq(pdev, 0);
+	if (priv->irq == -EPROBE_DEFER) {
+		err = -EPROBE_DEFER;
+		goto failed_get_resource;
+	}
+	if (priv->irq > 0) {
+		err = request_irq(priv->irq, rpivid_mem_irq, IRQF_SHARED,
+				  dev_name(dev), priv);
+		if (err) {
+			dev_err(priv->dev, "unable to request irq %d",
+				priv->irq);
+			goto failed_get_resource;
+		}
+	}
+
 	/* Create character device entries */
 
 	err = alloc_chrdev_region(&priv->devid,
@@ -221,6 +510,8 @@ static int rpivid_mem_probe(struct platform_device *pdev)
 failed_cdev_add:
 	unregister_chrdev_region(priv->devid, 1);
 failed_alloc_chrdev:
+	if (priv->irq > 0)
+		free_irq(priv->irq, priv);
 failed_get_resource:
 	kfree(priv);
 failed_inst_alloc:
@@ -237,6 +528,8 @@ static int rpivid_mem_remove(struct platform_device *pdev)
 	class_destroy(priv->class);
 	cdev_del(&priv->rpivid_mem_cdev);
 	unregister_chrdev_region(priv->devid, 1);
+	if (priv->irq > 0)
+		free_irq(priv->irq, priv);
 	kfree(priv);
 
 	dev_info(dev, "%s driver removed - OK", priv->name);
@@ -15,9 +15,12 @@
 #include <linux/fs.h>
 #include <linux/init.h>
 #include <linux/ioctl.h>
+#include <linux/kref.h>
 #include <linux/module.h>
+#include <linux/poll.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/wait.h>
 #include <soc/bcm2835/raspberrypi-firmware.h>
 
 #define MBOX_CHAN_PROPERTY 8
@@ -28,6 +31,39 @@
 #define IOCTL_MBOX_PROPERTY32 _IOWR(VCIO_IOC_MAGIC, 0, compat_uptr_t)
 #endif
 
+/* largest property buffer and number of unread requests per open file */
+#define VCIO_ASYNC_MAX_SIZE	(64 * 1024)
+#define VCIO_ASYNC_MAX_PENDING	32
+
+/*
+ * Asynchronous requests are written as a struct vcio_async_hdr followed by
+ * a property buffer laid out as for IOCTL_MBOX_PROPERTY. Each read()
+ * returns one completed request: the same header, with status and size
+ * filled in, followed by the response buffer. Requests may complete in
+ * any order relative to other users, but a file's own requests complete
+ * in the order they were written.
+ */
+struct vcio_async_hdr {
+	u64 id;
+	s32 status;
+	u32 size;
+};
+
+struct vcio_file {
+	struct kref kref;
+	spinlock_t lock;		/* protects done and pending */
+	struct list_head done;
+	unsigned int pending;		/* submitted and not yet read */
+	wait_queue_head_t wait;
+};
+
+struct vcio_request {
+	struct list_head node;
+	struct vcio_file *vf;
+	struct vcio_async_hdr hdr;
+	u32 buf[];
+};
+
 static struct {
 	dev_t devt;
 	struct cdev cdev;
@@ -69,8 +105,181 @@ static int vcio_user_property_list(void *user)
 	return ret;
 }
 
+static void vcio_file_free(struct kref *kref)
+{
+	struct vcio_file *vf = container_of(kref, struct vcio_file, kref);
+	struct vcio_request *req, *tmp;
+
+	list_for_each_entry_safe(req, tmp, &vf->done, node)
+		kfree(req);
+	kfree(vf);
+
+	module_put(THIS_MODULE);
+}
+
+static void vcio_async_done(void *context, int status)
+{
+	struct vcio_request *req = context;
+	struct vcio_file *vf = req->vf;
+	unsigned long flags;
+
+	req->hdr.status = status;
+	if (!status)
+		req->buf[1] = RPI_FIRMWARE_STATUS_SUCCESS;
+
+	spin_lock_irqsave(&vf->lock, flags);
+	list_add_tail(&req->node, &vf->done);
+	spin_unlock_irqrestore(&vf->lock, flags);
+
+	wake_up_interruptible(&vf->wait);
+	kref_put(&vf->kref, vcio_file_free);
+}
+
+static bool vcio_can_submit(struct vcio_file *vf)
+{
+	bool ret;
+
+	spin_lock_irq(&vf->lock);
+	ret = vf->pending < VCIO_ASYNC_MAX_PENDING;
+	if (ret)
+		vf->pending++;
+	spin_unlock_irq(&vf->lock);
+
+	return ret;
+}
+
+static ssize_t vcio_device_write(struct file *file, const char __user *ubuf,
+				 size_t count, loff_t *ppos)
+{
+	struct vcio_file *vf = file->private_data;
+	struct vcio_request *req;
+	size_t size;
+	int ret;
+
+	if (count < sizeof(req->hdr) + 12 ||
+	    count > sizeof(req->hdr) + VCIO_ASYNC_MAX_SIZE)
+		return -EINVAL;
+	size = count - sizeof(req->hdr);
+
+	req = kmalloc(sizeof(*req) + size, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	if (copy_from_user(&req->hdr, ubuf, sizeof(req->hdr)) ||
+	    copy_from_user(req->buf, ubuf + sizeof(req->hdr), size)) {
+		ret = -EFAULT;
+		goto err_free;
+	}
+
+	/* The first 32-bit is the size of the buffer */
+	if (req->buf[0] != size) {
+		ret = -EINVAL;
+		goto err_free;
+	}
+	req->hdr.size = size;
+	req->vf = vf;
+
+	if (!vcio_can_submit(vf)) {
+		if (file->f_flags & O_NONBLOCK) {
+			ret = -EAGAIN;
+			goto err_free;
+		}
+		ret = wait_event_interruptible(vf->wait, vcio_can_submit(vf));
+		if (ret)
+			goto err_free;
+	}
+
+	/* Strip off protocol encapsulation */
+	kref_get(&vf->kref);
+	ret = rpi_firmware_property_list_async(vcio.fw, &req->buf[2],
+					       size - 12, vcio_async_done, req);
+	if (ret) {
+		kref_put(&vf->kref, vcio_file_free);
+		spin_lock_irq(&vf->lock);
+		vf->pending--;
+		spin_unlock_irq(&vf->lock);
+		wake_up_interruptible(&vf->wait);
+		goto err_free;
+	}
+
+	return count;
+
+err_free:
+	kfree(req);
+	return ret;
+}
+
+static ssize_t vcio_device_read(struct file *file, char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	struct vcio_file *vf = file->private_data;
+	struct vcio_request *req;
+	int ret;
+
+	spin_lock_irq(&vf->lock);
+	while (list_empty(&vf->done)) {
+		spin_unlock_irq(&vf->lock);
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+		ret = wait_event_interruptible(vf->wait,
+					       !list_empty_careful(&vf->done));
+		if (ret)
+			return ret;
+		spin_lock_irq(&vf->lock);
+	}
+
+	req = list_first_entry(&vf->done, struct vcio_request, node);
+	if (count < sizeof(req->hdr) + req->hdr.size) {
+		spin_unlock_irq(&vf->lock);
+		return -EINVAL;
+	}
+	list_del(&req->node);
+	vf->pending--;
+	spin_unlock_irq(&vf->lock);
+	wake_up_interruptible(&vf->wait);
+
+	count = sizeof(req->hdr) + req->hdr.size;
+	if (copy_to_user(ubuf, &req->hdr, sizeof(req->hdr)) ||
+	    copy_to_user(ubuf + sizeof(req->hdr), req->buf, req->hdr.size))
+		count = -EFAULT;
+
+	kfree(req);
+
+	return count;
+}
+
+static __poll_t vcio_device_poll(struct file *file, poll_table *wait)
+{
+	struct vcio_file *vf = file->private_data;
+	__poll_t mask = 0;
+
+	poll_wait(file, &vf->wait, wait);
+
+	spin_lock_irq(&vf->lock);
+	if (!list_empty(&vf->done))
+		mask |= EPOLLIN | EPOLLRDNORM;
+	if (vf->pending < VCIO_ASYNC_MAX_PENDING)
+		mask |= EPOLLOUT | EPOLLWRNORM;
+	spin_unlock_irq(&vf->lock);
+
+	return mask;
+}
+
 static int vcio_device_open(struct inode *inode, struct file *file)
 {
+	struct vcio_file *vf;
+
+	vf = kzalloc(sizeof(*vf), GFP_KERNEL);
+	if (!vf)
+		return -ENOMEM;
+
+	kref_init(&vf->kref);
+	spin_lock_init(&vf->lock);
+	INIT_LIST_HEAD(&vf->done);
+	init_waitqueue_head(&vf->wait);
+	file->private_data = vf;
+
+	/* dropped once the last outstanding request has completed */
 	try_module_get(THIS_MODULE);
 
 	return 0;
@@ -78,7 +287,9 @@ static int vcio_device_open(struct inode *inode, struct file *file)
 
 static int vcio_device_release(struct inode *inode, struct file *file)
 {
-	module_put(THIS_MODULE);
+	struct vcio_file *vf = file->private_data;
+
+	kref_put(&vf->kref, vcio_file_free);
 
 	return 0;
 }
@@ -116,6 +327,10 @@ const struct file_operations vcio_fops = {
 #endif
 	.open = vcio_device_open,
 	.release = vcio_device_release,
+	.read = vcio_device_read,
+	.write = vcio_device_write,
+	.poll = vcio_device_poll,
+	.llseek = no_llseek,
 };
 
 static int __init vcio_init(void)
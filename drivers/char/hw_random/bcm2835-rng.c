@@ -16,6 +16,7 @@
 #include <linux/platform_device.h>
 #include <linux/printk.h>
 #include <linux/clk.h>
+#include <linux/delay.h>
 
 #define RNG_CTRL	0x0
 #define RNG_STATUS	0x4
@@ -67,22 +68,25 @@ static int bcm2835_rng_read(struct hwrng *rng, void *buf, size_t max,
 {
 	struct bcm2835_rng_priv *priv = to_rng_priv(rng);
 	u32 max_words = max / sizeof(u32);
-	u32 num_words, count;
-
-	while ((rng_readl(priv, RNG_STATUS) >> 24) == 0) {
-		if (!wait)
-			return 0;
-		cpu_relax();
+	u32 num_words, count = 0;
+
+	/* keep draining the FIFO until the caller's buffer is full */
+	while (count < max_words) {
+		num_words = rng_readl(priv, RNG_STATUS) >> 24;
+		if (!num_words) {
+			if (count || !wait)
+				break;
+			/* still warming up, don't spin for it */
+			usleep_range(100, 200);
+			continue;
+		}
+
+		num_words = min(num_words, max_words - count);
+		while (num_words--)
+			((u32 *)buf)[count++] = rng_readl(priv, RNG_DATA);
 	}
 
-	num_words = rng_readl(priv, RNG_STATUS) >> 24;
-	if (num_words > max_words)
-		num_words = max_words;
-
-	for (count = 0; count < num_words; count++)
-		((u32 *)buf)[count] = rng_readl(priv, RNG_DATA);
-
-	return num_words * sizeof(u32);
+	return count * sizeof(u32);
 }
 
 static int bcm2835_rng_init(struct hwrng *rng)
@@ -172,6 +176,12 @@ static int bcm2835_rng_probe(struct platform_device *pdev)
 	priv->rng.init = bcm2835_rng_init;
 	priv->rng.read = bcm2835_rng_read;
 	priv->rng.cleanup = bcm2835_rng_cleanup;
+	/*
+	 * Have the hwrng core credit what we produce, so its fill thread
+	 * seeds the CRNG from probe onwards instead of leaving getrandom()
+	 * to block on a headless first boot.
+	 */
+	priv->rng.quality = 1000;
 
 	if (dev_of_node(dev)) {
 		rng_id = of_match_node(bcm2835_rng_of_match, np);
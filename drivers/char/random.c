@@ -767,18 +767,18 @@ static int credit_entropy_bits_safe(struct entropy_store *r, int nbits)
 
 static DECLARE_WAIT_QUEUE_HEAD(crng_init_wait);
 
-#ifdef CONFIG_NUMA
+#ifdef CONFIG_SMP
 /*
- * Hack to deal with crazy userspace progams when they are all trying
- * to access /dev/urandom in parallel.  The programs are almost
- * certainly doing something terribly wrong, but we'll work around
- * their brain damage.
+ * Once primary_crng is seeded every cpu gets a crng of its own, keyed from
+ * primary_crng and rekeyed from it every CRNG_RESEED_INTERVAL, so that
+ * parallel readers of /dev/urandom and getrandom() neither contend on a
+ * single lock nor bounce the state between cpus.
  */
-static struct crng_state **crng_node_pool __read_mostly;
+static struct crng_state __percpu *crng_cpu_pool __read_mostly;
 #endif
 
 static void invalidate_batched_entropy(void);
-static void numa_crng_init(void);
+static void percpu_crng_init(void);
 
 static bool trust_cpu __ro_after_init = IS_ENABLED(CONFIG_RANDOM_TRUST_CPU);
 static int __init parse_trust_cpu(char *arg)
@@ -809,44 +809,42 @@ static void crng_initialize(struct crng_state *crng)
 	}
 	if (trust_cpu && arch_init && crng == &primary_crng) {
 		invalidate_batched_entropy();
-		numa_crng_init();
+		percpu_crng_init();
 		crng_init = 2;
 		pr_notice("random: crng done (trusting CPU's manufacturer)\n");
 	}
 	crng->init_time = jiffies - CRNG_RESEED_INTERVAL - 1;
 }
 
-#ifdef CONFIG_NUMA
-static void do_numa_crng_init(struct work_struct *work)
+#ifdef CONFIG_SMP
+static void do_percpu_crng_init(struct work_struct *work)
 {
 	int i;
 	struct crng_state *crng;
-	struct crng_state **pool;
+	struct crng_state __percpu *pool;
 
-	pool = kcalloc(nr_node_ids, sizeof(*pool), GFP_KERNEL|__GFP_NOFAIL);
-	for_each_online_node(i) {
-		crng = kmalloc_node(sizeof(struct crng_state),
-				    GFP_KERNEL | __GFP_NOFAIL, i);
+	/* Without a pool everybody simply keeps using primary_crng */
+	pool = alloc_percpu(struct crng_state);
+	if (!pool)
+		return;
+	for_each_possible_cpu(i) {
+		crng = per_cpu_ptr(pool, i);
 		spin_lock_init(&crng->lock);
 		crng_initialize(crng);
-		pool[i] = crng;
 	}
 	mb();
-	if (cmpxchg(&crng_node_pool, NULL, pool)) {
-		for_each_node(i)
-			kfree(pool[i]);
-		kfree(pool);
-	}
+	if (cmpxchg(&crng_cpu_pool, NULL, pool))
+		free_percpu(pool);
 }
 
-static DECLARE_WORK(numa_crng_init_work, do_numa_crng_init);
+static DECLARE_WORK(percpu_crng_init_work, do_percpu_crng_init);
 
-static void numa_crng_init(void)
+static void percpu_crng_init(void)
 {
-	schedule_work(&numa_crng_init_work);
+	schedule_work(&percpu_crng_init_work);
 }
 #else
-static void numa_crng_init(void) {}
+static void percpu_crng_init(void) {}
 #endif
 
 /*
@@ -955,7 +953,7 @@ static void crng_reseed(struct crng_state *crng, struct entropy_store *r)
 	spin_unlock_irqrestore(&crng->lock, flags);
 	if (crng == &primary_crng && crng_init < 2) {
 		invalidate_batched_entropy();
-		numa_crng_init();
+		percpu_crng_init();
 		crng_init = 2;
 		process_random_ready_list();
 		wake_up_interruptible(&crng_init_wait);
@@ -993,17 +991,33 @@ static void _extract_crng(struct crng_state *crng,
 	spin_unlock_irqrestore(&crng->lock, flags);
 }
 
-static void extract_crng(__u8 out[CHACHA20_BLOCK_SIZE])
+/*
+ * The crng of the cpu we happen to run on.  Being migrated afterwards is
+ * harmless, crng->lock still serialises the users of each state; it is just
+ * uncontended in the common case.
+ */
+static struct crng_state *select_crng(void)
 {
-	struct crng_state *crng = NULL;
+#ifdef CONFIG_SMP
+	struct crng_state __percpu *pool;
 
-#ifdef CONFIG_NUMA
-	if (crng_node_pool)
-		crng = crng_node_pool[numa_node_id()];
-	if (crng == NULL)
+	pool = READ_ONCE(crng_cpu_pool);
+	if (pool)
+		return raw_cpu_ptr(pool);
 #endif
-		crng = &primary_crng;
+	return &primary_crng;
+}
+
+/*
+ * Returns the state that produced @out, so that _crng_backtrack_protect()
+ * mutates that one even if we have been migrated in between.
+ */
+static struct crng_state *extract_crng(__u8 out[CHACHA20_BLOCK_SIZE])
+{
+	struct crng_state *crng = select_crng();
+
 	_extract_crng(crng, out);
+	return crng;
 }
 
 /*
@@ -1019,7 +1033,7 @@ static void _crng_backtrack_protect(struct crng_state *crng,
 
 	used = round_up(used, sizeof(__u32));
 	if (used + CHACHA20_KEY_SIZE > CHACHA20_BLOCK_SIZE) {
-		extract_crng(tmp);
+		_extract_crng(crng, tmp);
 		used = 0;
 	}
 	spin_lock_irqsave(&crng->lock, flags);
@@ -1030,23 +1044,11 @@ static void _crng_backtrack_protect(struct crng_state *crng,
 	spin_unlock_irqrestore(&crng->lock, flags);
 }
 
-static void crng_backtrack_protect(__u8 tmp[CHACHA20_BLOCK_SIZE], int used)
-{
-	struct crng_state *crng = NULL;
-
-#ifdef CONFIG_NUMA
-	if (crng_node_pool)
-		crng = crng_node_pool[numa_node_id()];
-	if (crng == NULL)
-#endif
-		crng = &primary_crng;
-	_crng_backtrack_protect(crng, tmp, used);
-}
-
 static ssize_t extract_crng_user(void __user *buf, size_t nbytes)
 {
 	ssize_t ret = 0, i = CHACHA20_BLOCK_SIZE;
 	__u8 tmp[CHACHA20_BLOCK_SIZE] __aligned(4);
+	struct crng_state *crng = NULL;
 	int large_request = (nbytes > 256);
 
 	while (nbytes) {
@@ -1059,7 +1061,7 @@ static ssize_t extract_crng_user(void __user *buf, size_t nbytes)
 			schedule();
 		}
 
-		extract_crng(tmp);
+		crng = extract_crng(tmp);
 		i = min_t(int, nbytes, CHACHA20_BLOCK_SIZE);
 		if (copy_to_user(buf, tmp, i)) {
 			ret = -EFAULT;
@@ -1070,7 +1072,7 @@ static ssize_t extract_crng_user(void __user *buf, size_t nbytes)
 		buf += i;
 		ret += i;
 	}
-	crng_backtrack_protect(tmp, i);
+	_crng_backtrack_protect(crng ?: select_crng(), tmp, i);
 
 	/* Wipe data just written to memory */
 	memzero_explicit(tmp, sizeof(tmp));
@@ -1626,21 +1628,23 @@ static void _warn_unseeded_randomness(const char *func_name, void *caller,
 static void _get_random_bytes(void *buf, int nbytes)
 {
 	__u8 tmp[CHACHA20_BLOCK_SIZE] __aligned(4);
+	struct crng_state *crng = NULL;
 
 	trace_get_random_bytes(nbytes, _RET_IP_);
 
 	while (nbytes >= CHACHA20_BLOCK_SIZE) {
-		extract_crng(buf);
+		crng = extract_crng(buf);
 		buf += CHACHA20_BLOCK_SIZE;
 		nbytes -= CHACHA20_BLOCK_SIZE;
 	}
 
 	if (nbytes > 0) {
-		extract_crng(tmp);
+		crng = extract_crng(tmp);
 		memcpy(buf, tmp, nbytes);
-		crng_backtrack_protect(tmp, nbytes);
+		_crng_backtrack_protect(crng, tmp, nbytes);
 	} else
-		crng_backtrack_protect(tmp, CHACHA20_BLOCK_SIZE);
+		_crng_backtrack_protect(crng ?: select_crng(), tmp,
+					CHACHA20_BLOCK_SIZE);
 	memzero_explicit(tmp, sizeof(tmp));
 }
 
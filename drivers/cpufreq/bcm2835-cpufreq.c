@@ -18,6 +18,9 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/cpufreq.h>
+#include <linux/irq_work.h>
+#include <linux/spinlock.h>
+#include <linux/wait_bit.h>
 #include <soc/bcm2835/raspberrypi-firmware.h>
 
 /* ---------- DEFINES ---------- */
@@ -40,6 +43,21 @@ static struct cpufreq_driver bcm2835_cpufreq_driver;	/* the cpufreq driver globa
 static unsigned int min_frequency, max_frequency;
 static struct cpufreq_frequency_table bcm2835_freq_table[3];
 
+/*
+ * Fast switching posts the new rate to the firmware and returns without
+ * waiting for the reply. One message is in flight at a time: a request
+ * made meanwhile only updates post_target and is sent from the completion.
+ */
+static struct {
+	struct rpi_firmware_property_tag_header header;
+	u32 id;
+	u32 val;
+} post_msg;
+static DEFINE_SPINLOCK(post_lock);
+static struct irq_work post_work;
+static unsigned int post_target, post_sent;
+static bool post_busy;
+
 /*
  ===============================================
   clk_rate either gets or sets the clock rates.
@@ -104,6 +122,55 @@ static uint32_t bcm2835_cpufreq_get_clock(int tag)
 	return rate;
 }
 
+/* Called with post_lock held */
+static void bcm2835_cpufreq_post(void);
+
+static void bcm2835_cpufreq_posted(void *context, int status)
+{
+	unsigned long flags;
+
+	if (status)
+		print_err("Failed to set clock: %d (%d)\n", post_sent, status);
+
+	spin_lock_irqsave(&post_lock, flags);
+	if (post_target != post_sent) {
+		bcm2835_cpufreq_post();
+	} else {
+		post_busy = false;
+		wake_up_var(&post_busy);
+	}
+	spin_unlock_irqrestore(&post_lock, flags);
+}
+
+static void bcm2835_cpufreq_post(void)
+{
+	int ret;
+
+	post_sent = post_target;
+	post_msg.header.tag = RPI_FIRMWARE_SET_CLOCK_RATE;
+	post_msg.header.buf_size = sizeof(post_msg.id) + sizeof(post_msg.val);
+	post_msg.header.req_resp_size = 0;
+	post_msg.id = VCMSG_ID_ARM_CLOCK;
+	post_msg.val = post_sent * 1000;
+
+	ret = rpi_firmware_property_list_async(rpi_firmware_get(NULL), &post_msg, sizeof(post_msg), bcm2835_cpufreq_posted, NULL);
+	if (ret) {
+		print_err("Failed to post clock: %d (%d)\n", post_sent, ret);
+		post_busy = false;
+		wake_up_var(&post_busy);
+	}
+}
+
+/* The mailbox may not be kicked from the scheduler, so go via irq_work */
+static void bcm2835_cpufreq_post_work(struct irq_work *work)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&post_lock, flags);
+	bcm2835_cpufreq_post();
+	spin_unlock_irqrestore(&post_lock, flags);
+}
+
 /*
  ====================================================
   Module Initialisation registers the cpufreq driver
@@ -112,6 +179,7 @@ static uint32_t bcm2835_cpufreq_get_clock(int tag)
 static int __init bcm2835_cpufreq_module_init(void)
 {
 	print_debug("IN\n");
+	init_irq_work(&post_work, bcm2835_cpufreq_post_work);
 	return cpufreq_register_driver(&bcm2835_cpufreq_driver);
 }
 
@@ -124,6 +192,8 @@ static void __exit bcm2835_cpufreq_module_exit(void)
 {
 	print_debug("IN\n");
 	cpufreq_unregister_driver(&bcm2835_cpufreq_driver);
+	irq_work_sync(&post_work);
+	wait_var_event(&post_busy, !READ_ONCE(post_busy));
 	return;
 }
 
@@ -156,6 +226,7 @@ static int bcm2835_cpufreq_driver_init(struct cpufreq_policy *policy)
 	}
 
 	print_info("min=%d max=%d\n", min_frequency, max_frequency);
+	policy->fast_switch_possible = true;
 	return cpufreq_generic_init(policy, bcm2835_freq_table, transition_latency);
 }
 
@@ -179,6 +250,27 @@ static int bcm2835_cpufreq_driver_target_index(struct cpufreq_policy *policy, un
 	return 0;
 }
 
+/*
+ ==================================================================
+  Fast switch function posts the new frequency, called by schedutil
+ ==================================================================
+*/
+
+static unsigned int bcm2835_cpufreq_driver_fast_switch(struct cpufreq_policy *policy, unsigned int target_freq)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&post_lock, flags);
+	post_target = target_freq;
+	if (!post_busy) {
+		post_busy = true;
+		irq_work_queue(&post_work);
+	}
+	spin_unlock_irqrestore(&post_lock, flags);
+
+	return target_freq;
+}
+
 /*
  ======================================================
   Get function returns the current frequency from table
@@ -198,6 +290,7 @@ static struct cpufreq_driver bcm2835_cpufreq_driver = {
 	.init         = bcm2835_cpufreq_driver_init,
 	.verify       = cpufreq_generic_frequency_table_verify,
 	.target_index = bcm2835_cpufreq_driver_target_index,
+	.fast_switch  = bcm2835_cpufreq_driver_fast_switch,
 	.get          = bcm2835_cpufreq_driver_get,
 	.attr         = cpufreq_generic_attr,
 };
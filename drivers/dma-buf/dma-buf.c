@@ -597,6 +597,10 @@ void dma_buf_detach(struct dma_buf *dmabuf, struct dma_buf_attachment *attach)
 		return;
 
 	mutex_lock(&dmabuf->lock);
+	if (attach->sgt) {
+		dmabuf->ops->unmap_dma_buf(attach, attach->sgt, attach->dir);
+		atomic_long_inc(&dmabuf->exp_unmap_count);
+	}
 	list_del(&attach->node);
 	if (dmabuf->ops->detach)
 		dmabuf->ops->detach(dmabuf, attach);
@@ -620,10 +624,16 @@ EXPORT_SYMBOL_GPL(dma_buf_detach);
  * the underlying backing storage is pinned for as long as a mapping exists,
  * therefore users/importers should not hold onto a mapping for undue amounts of
  * time.
+ *
+ * If the exporter sets &dma_buf_ops.cache_sgt_mapping, the first mapping of
+ * an attachment is kept until dma_buf_detach() and returned again here; asking
+ * for a different direction than it was made with then fails with -EBUSY,
+ * unless that was DMA_BIDIRECTIONAL.
  */
 struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 					enum dma_data_direction direction)
 {
+	struct dma_buf *dmabuf;
 	struct sg_table *sg_table;
 
 	might_sleep();
@@ -631,9 +641,28 @@ struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 	if (WARN_ON(!attach || !attach->dmabuf))
 		return ERR_PTR(-EINVAL);
 
-	sg_table = attach->dmabuf->ops->map_dma_buf(attach, direction);
+	dmabuf = attach->dmabuf;
+	atomic_long_inc(&dmabuf->map_count);
+
+	if (attach->sgt) {
+		if (attach->dir != direction &&
+		    attach->dir != DMA_BIDIRECTIONAL)
+			return ERR_PTR(-EBUSY);
+
+		return attach->sgt;
+	}
+
+	sg_table = dmabuf->ops->map_dma_buf(attach, direction);
 	if (!sg_table)
 		sg_table = ERR_PTR(-ENOMEM);
+	if (IS_ERR(sg_table))
+		return sg_table;
+
+	atomic_long_inc(&dmabuf->exp_map_count);
+	if (dmabuf->ops->cache_sgt_mapping) {
+		attach->sgt = sg_table;
+		attach->dir = direction;
+	}
 
 	return sg_table;
 }
@@ -658,8 +687,15 @@ void dma_buf_unmap_attachment(struct dma_buf_attachment *attach,
 	if (WARN_ON(!attach || !attach->dmabuf || !sg_table))
 		return;
 
+	atomic_long_inc(&attach->dmabuf->unmap_count);
+
+	/* a cached mapping lives until dma_buf_detach() */
+	if (attach->sgt == sg_table)
+		return;
+
 	attach->dmabuf->ops->unmap_dma_buf(attach, sg_table,
 						direction);
+	atomic_long_inc(&attach->dmabuf->exp_unmap_count);
 }
 EXPORT_SYMBOL_GPL(dma_buf_unmap_attachment);
 
@@ -1043,6 +1079,11 @@ static int dma_buf_debug_show(struct seq_file *s, void *unused)
 				buf_obj->file->f_flags, buf_obj->file->f_mode,
 				file_count(buf_obj->file),
 				buf_obj->exp_name);
+		seq_printf(s, "\tMaps: %ld (%ld by exporter), unmaps: %ld (%ld by exporter)\n",
+			   atomic_long_read(&buf_obj->map_count),
+			   atomic_long_read(&buf_obj->exp_map_count),
+			   atomic_long_read(&buf_obj->unmap_count),
+			   atomic_long_read(&buf_obj->exp_unmap_count));
 
 		robj = buf_obj->resv;
 		while (true) {
@@ -1077,7 +1118,8 @@ static int dma_buf_debug_show(struct seq_file *s, void *unused)
 		attach_count = 0;
 
 		list_for_each_entry(attach_obj, &buf_obj->attachments, node) {
-			seq_printf(s, "\t%s\n", dev_name(attach_obj->dev));
+			seq_printf(s, "\t%s%s\n", dev_name(attach_obj->dev),
+				   attach_obj->sgt ? " (mapping cached)" : "");
 			attach_count++;
 		}
 
@@ -52,6 +52,14 @@
 #define BCM2835_DMA_BULK_MASK  BIT(0)
 #define BCM2838_DMA_MEMCPY_CHAN 14
 
+/*
+ * Descriptors of up to BCM2835_DMA_CACHE_FRAMES control blocks (the common
+ * case for audio periods and SPI transfers) are recycled per channel along
+ * with their control blocks instead of going back to the pool.
+ */
+#define BCM2835_DMA_CACHE_FRAMES 16
+#define BCM2835_DMA_CACHE_DESCS 8
+
 struct bcm2835_dma_cfg_data {
 	u32	chan_40bit_mask;
 };
@@ -99,8 +107,13 @@ struct bcm2835_chan {
 
 	int ch;
 	struct bcm2835_desc *desc;
+	struct bcm2835_desc *next_desc;	/* linked onto the tail of desc */
 	struct dma_pool *cb_pool;
 
+	spinlock_t cache_lock;
+	struct list_head desc_cache;
+	unsigned int desc_cache_len;
+
 	void __iomem *chan_base;
 	int irq_number;
 	unsigned int irq_flags;
@@ -119,6 +132,7 @@ struct bcm2835_desc {
 
 	bool cyclic;
 
+	unsigned int cb_slots;	/* entries in cb_list, possibly allocated */
 	struct bcm2835_cb_entry cb_list[];
 };
 
@@ -204,6 +218,10 @@ struct bcm2835_desc {
 #define MAX_DMA_LEN SZ_1G
 #define MAX_LITE_DMA_LEN (SZ_64K - 4)
 
+/* 2D mode: XLENGTH is 16 bits, YLENGTH 14 bits and the strides are s16 */
+#define MAX_TD_XLEN		0xffff
+#define MAX_TD_YLEN		(0x3fff + 1)
+
 /* 40-bit DMA support */
 #define BCM2838_DMA40_CS	0x00
 #define BCM2838_DMA40_CB	0x04
@@ -363,17 +381,88 @@ static inline uint32_t to_bcm2838_cbaddr(dma_addr_t addr)
 	return (addr >> 5);
 }
 
-static void bcm2835_dma_free_cb_chain(struct bcm2835_desc *desc)
+static void __bcm2835_dma_free_cb_chain(struct bcm2835_desc *desc)
 {
 	size_t i;
 
-	for (i = 0; i < desc->frames; i++)
-		dma_pool_free(desc->c->cb_pool, desc->cb_list[i].cb,
-			      desc->cb_list[i].paddr);
+	for (i = 0; i < desc->cb_slots; i++)
+		if (desc->cb_list[i].cb)
+			dma_pool_free(desc->c->cb_pool, desc->cb_list[i].cb,
+				      desc->cb_list[i].paddr);
 
 	kfree(desc);
 }
 
+static void bcm2835_dma_free_cb_chain(struct bcm2835_desc *desc)
+{
+	struct bcm2835_chan *c = desc->c;
+	unsigned long flags;
+
+	if (desc->cb_slots == BCM2835_DMA_CACHE_FRAMES) {
+		spin_lock_irqsave(&c->cache_lock, flags);
+		if (c->desc_cache_len < BCM2835_DMA_CACHE_DESCS) {
+			list_add(&desc->vd.node, &c->desc_cache);
+			c->desc_cache_len++;
+			desc = NULL;
+		}
+		spin_unlock_irqrestore(&c->cache_lock, flags);
+
+		if (!desc)
+			return;
+	}
+
+	__bcm2835_dma_free_cb_chain(desc);
+}
+
+/* the control blocks of a recycled descriptor are kept but not cleared */
+static struct bcm2835_desc *bcm2835_dma_desc_alloc(struct bcm2835_chan *c,
+						   size_t frames, gfp_t gfp)
+{
+	struct bcm2835_desc *d;
+	unsigned long flags;
+
+	if (frames <= BCM2835_DMA_CACHE_FRAMES) {
+		spin_lock_irqsave(&c->cache_lock, flags);
+		d = list_first_entry_or_null(&c->desc_cache,
+					     struct bcm2835_desc, vd.node);
+		if (d) {
+			list_del(&d->vd.node);
+			c->desc_cache_len--;
+		}
+		spin_unlock_irqrestore(&c->cache_lock, flags);
+
+		if (d) {
+			memset(d, 0, offsetof(struct bcm2835_desc, cb_list));
+			d->cb_slots = BCM2835_DMA_CACHE_FRAMES;
+			return d;
+		}
+
+		frames = BCM2835_DMA_CACHE_FRAMES;
+	}
+
+	d = kzalloc(sizeof(*d) + frames * sizeof(struct bcm2835_cb_entry),
+		    gfp);
+	if (d)
+		d->cb_slots = frames;
+
+	return d;
+}
+
+static void bcm2835_dma_drain_desc_cache(struct bcm2835_chan *c)
+{
+	struct bcm2835_desc *d, *tmp;
+	unsigned long flags;
+	LIST_HEAD(head);
+
+	spin_lock_irqsave(&c->cache_lock, flags);
+	list_splice_init(&c->desc_cache, &head);
+	c->desc_cache_len = 0;
+	spin_unlock_irqrestore(&c->cache_lock, flags);
+
+	list_for_each_entry_safe(d, tmp, &head, vd.node)
+		__bcm2835_dma_free_cb_chain(d);
+}
+
 static void bcm2835_dma_desc_free(struct virt_dma_desc *vd)
 {
 	bcm2835_dma_free_cb_chain(
@@ -483,8 +572,7 @@ static struct bcm2835_desc *bcm2835_dma_create_cb_chain(
 		return NULL;
 
 	/* allocate and setup the descriptor. */
-	d = kzalloc(sizeof(*d) + frames * sizeof(struct bcm2835_cb_entry),
-		    gfp);
+	d = bcm2835_dma_desc_alloc(c, frames, gfp);
 	if (!d)
 		return NULL;
 
@@ -498,8 +586,9 @@ static struct bcm2835_desc *bcm2835_dma_create_cb_chain(
 	 */
 	for (frame = 0, total_len = 0; frame < frames; d->frames++, frame++) {
 		cb_entry = &d->cb_list[frame];
-		cb_entry->cb = dma_pool_alloc(c->cb_pool, gfp,
-					      &cb_entry->paddr);
+		if (!cb_entry->cb)
+			cb_entry->cb = dma_pool_alloc(c->cb_pool, gfp,
+						      &cb_entry->paddr);
 		if (!cb_entry->cb)
 			goto error_cb;
 
@@ -678,6 +767,73 @@ static void bcm2835_dma_start_desc(struct bcm2835_chan *c)
 	}
 }
 
+/*
+ * Link the next issued descriptor onto the tail of the running one so the
+ * channel moves straight on to it. NEXTCONBK may only be rewritten while the
+ * channel is paused, which covers the case of the final control block
+ * already being loaded. Called with vc.lock held.
+ */
+static void bcm2835_dma_link_next(struct bcm2835_chan *c)
+{
+	void __iomem *chan_base = c->chan_base;
+	struct bcm2835_desc *d = c->desc, *next;
+	struct bcm2835_dma_cb *last;
+	struct virt_dma_desc *vd;
+	long timeout = 1000;
+	u32 addr;
+
+	if (!d || d->cyclic || c->next_desc || c->is_40bit_channel)
+		return;
+
+	vd = vchan_next_desc(&c->vc);
+	if (!vd)
+		return;
+
+	next = to_bcm2835_dma_desc(&vd->tx);
+	if (next->cyclic)
+		return;
+
+	last = d->cb_list[d->frames - 1].cb;
+	last->next = next->cb_list[0].paddr;
+	/* the link must be visible before the channel can load @last */
+	wmb();
+
+	/* Write 0 to the active bit - Pause the DMA */
+	writel(BCM2835_DMA_CS_FLAGS(c->dreq), chan_base + BCM2835_DMA_CS);
+	while (!(readl(chan_base + BCM2835_DMA_CS) & BCM2835_DMA_ISPAUSED) &&
+	       --timeout)
+		cpu_relax();
+	if (!timeout)
+		dev_warn_once(c->vc.chan.device->dev,
+			      "channel %d did not pause for linking\n", c->ch);
+
+	addr = readl(chan_base + BCM2835_DMA_ADDR);
+	if (addr == d->cb_list[d->frames - 1].paddr)
+		writel(next->cb_list[0].paddr, chan_base + BCM2835_DMA_NEXTCB);
+
+	if (addr) {
+		list_del(&vd->node);
+		c->next_desc = next;
+	} else {
+		/* already finished, the interrupt handler starts @next */
+		last->next = 0;
+	}
+
+	writel(BCM2835_DMA_ACTIVE | BCM2835_DMA_CS_FLAGS(c->dreq),
+	       chan_base + BCM2835_DMA_CS);
+}
+
+static bool bcm2835_dma_desc_has_cb(struct bcm2835_desc *d, u32 addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < d->frames; i++)
+		if (d->cb_list[i].paddr == addr)
+			return true;
+
+	return false;
+}
+
 static irqreturn_t bcm2835_dma_callback(int irq, void *data)
 {
 	struct bcm2835_chan *c = data;
@@ -708,12 +864,26 @@ static irqreturn_t bcm2835_dma_callback(int irq, void *data)
 	d = c->desc;
 
 	if (d) {
+		u32 addr = readl(c->chan_base + BCM2835_DMA_ADDR);
+
 		if (d->cyclic) {
 			/* call the cyclic callback */
 			vchan_cyclic_callback(&d->vd);
-		} else if (!readl(c->chan_base + BCM2835_DMA_ADDR)) {
-			vchan_cookie_complete(&c->desc->vd);
+		} else if (!addr) {
+			vchan_cookie_complete(&d->vd);
+			/* a linked descriptor has finished as well */
+			if (c->next_desc) {
+				vchan_cookie_complete(&c->next_desc->vd);
+				c->next_desc = NULL;
+			}
 			bcm2835_dma_start_desc(c);
+			bcm2835_dma_link_next(c);
+		} else if (c->next_desc && !bcm2835_dma_desc_has_cb(d, addr)) {
+			/* the channel has moved on to the linked descriptor */
+			vchan_cookie_complete(&d->vd);
+			c->desc = c->next_desc;
+			c->next_desc = NULL;
+			bcm2835_dma_link_next(c);
 		}
 	}
 
@@ -746,6 +916,7 @@ static void bcm2835_dma_free_chan_resources(struct dma_chan *chan)
 
 	vchan_free_chan_resources(&c->vc);
 	free_irq(c->irq_number, c);
+	bcm2835_dma_drain_desc_cache(c);
 	dma_pool_destroy(c->cb_pool);
 
 	dev_dbg(c->vc.chan.device->dev, "Freeing DMA channel %u\n", c->ch);
@@ -764,6 +935,7 @@ static size_t bcm2835_dma_desc_size_pos(struct bcm2835_desc *d, dma_addr_t addr)
 	for (size = i = 0; i < d->frames; i++) {
 		struct bcm2835_dma_cb *control_block = d->cb_list[i].cb;
 		size_t this_size = control_block->length;
+		size_t span = this_size, xlen = 0, pitch = 0;
 		dma_addr_t dma;
 
 		if (d->dir == DMA_DEV_TO_MEM)
@@ -771,9 +943,24 @@ static size_t bcm2835_dma_desc_size_pos(struct bcm2835_desc *d, dma_addr_t addr)
 		else
 			dma = control_block->src;
 
+		/*
+		 * 2D blocks hold YLENGTH - 1 and XLENGTH in the length word.
+		 * Only memory to memory copies use them, and their position is
+		 * the source, which steps by the source stride after each line.
+		 */
+		if (control_block->info & BCM2835_DMA_TDMODE) {
+			xlen = this_size & 0xffff;
+			pitch = xlen + (s16)(control_block->stride & 0xffff);
+			span = ((this_size >> 16) + 1) * pitch;
+			this_size = ((this_size >> 16) + 1) * xlen;
+		}
+
 		if (size)
 			size += this_size;
-		else if (addr >= dma && addr < dma + this_size)
+		else if (addr >= dma && addr < dma + span && pitch)
+			size += this_size - (addr - dma) / pitch * xlen -
+				min_t(size_t, (addr - dma) % pitch, xlen);
+		else if (addr >= dma && addr < dma + span)
 			size += dma + this_size - addr;
 	}
 
@@ -813,10 +1000,14 @@ static enum dma_status bcm2835_dma_tx_status(struct dma_chan *chan,
 				  0xff) << 8);
 		else if (d->dir == DMA_DEV_TO_MEM && !c->is_40bit_channel)
 			pos = readl(c->chan_base + BCM2835_DMA_DEST_AD);
+		else if (d->dir == DMA_MEM_TO_MEM && !c->is_40bit_channel)
+			pos = readl(c->chan_base + BCM2835_DMA_SOURCE_AD);
 		else
 			pos = 0;
 
 		txstate->residue = bcm2835_dma_desc_size_pos(d, pos);
+	} else if (c->next_desc && c->next_desc->vd.tx.cookie == cookie) {
+		txstate->residue = bcm2835_dma_desc_size(c->next_desc);
 	} else {
 		txstate->residue = 0;
 	}
@@ -832,8 +1023,11 @@ static void bcm2835_dma_issue_pending(struct dma_chan *chan)
 	unsigned long flags;
 
 	spin_lock_irqsave(&c->vc.lock, flags);
-	if (vchan_issue_pending(&c->vc) && !c->desc)
-		bcm2835_dma_start_desc(c);
+	if (vchan_issue_pending(&c->vc)) {
+		if (!c->desc)
+			bcm2835_dma_start_desc(c);
+		bcm2835_dma_link_next(c);
+	}
 
 	spin_unlock_irqrestore(&c->vc.lock, flags);
 }
@@ -866,6 +1060,69 @@ static struct dma_async_tx_descriptor *bcm2835_dma_prep_dma_memcpy(
 	return vchan_tx_prep(&c->vc, &d->vd, flags);
 }
 
+/*
+ * Interleaved memory to memory copies map onto the 2D mode (TDMODE) of the
+ * full 32-bit channels: each control block moves up to MAX_TD_YLEN lines of
+ * one chunk each, with the inter-chunk gaps as source and destination
+ * strides. Lite channels have no 2D mode and the 40-bit channels are only
+ * set up for linear transfers here, so those reject the template.
+ */
+static struct dma_async_tx_descriptor *bcm2835_dma_prep_interleaved_dma(
+	struct dma_chan *chan, struct dma_interleaved_template *xt,
+	unsigned long flags)
+{
+	struct bcm2835_chan *c = to_bcm2835_dma_chan(chan);
+	struct bcm2835_desc *d;
+	u32 info = BCM2835_DMA_TDMODE | BCM2835_DMA_D_INC | BCM2835_DMA_S_INC;
+	u32 extra = BCM2835_DMA_INT_EN | BCM2835_DMA_WAIT_RESP;
+	size_t xlen, lines, frames, frame;
+	size_t src_icg, dst_icg;
+	dma_addr_t src, dst;
+
+	if (c->is_lite_channel || c->is_40bit_channel)
+		return NULL;
+
+	if (xt->dir != DMA_MEM_TO_MEM || xt->frame_size != 1 || !xt->numf ||
+	    !xt->src_inc || !xt->dst_inc)
+		return NULL;
+
+	xlen = xt->sgl[0].size;
+	src_icg = dmaengine_get_src_icg(xt, &xt->sgl[0]);
+	dst_icg = dmaengine_get_dst_icg(xt, &xt->sgl[0]);
+	if (!xlen || xlen > MAX_TD_XLEN || src_icg > S16_MAX ||
+	    dst_icg > S16_MAX)
+		return NULL;
+
+	frames = DIV_ROUND_UP(xt->numf, MAX_TD_YLEN);
+
+	/* allocate the CB chain, lengths and strides are filled in below */
+	d = bcm2835_dma_create_cb_chain(c, DMA_MEM_TO_MEM, false,
+					info, extra, frames,
+					0, 0, 0, 0, GFP_NOWAIT);
+	if (!d)
+		return NULL;
+
+	src = xt->src_start;
+	dst = xt->dst_start;
+	for (frame = 0; frame < frames; frame++) {
+		struct bcm2835_dma_cb *control_block = d->cb_list[frame].cb;
+
+		lines = min_t(size_t, xt->numf - frame * MAX_TD_YLEN,
+			      MAX_TD_YLEN);
+
+		control_block->src = src;
+		control_block->dst = dst;
+		control_block->length = ((lines - 1) << 16) | xlen;
+		control_block->stride = (dst_icg << 16) | src_icg;
+
+		src += lines * (xlen + src_icg);
+		dst += lines * (xlen + dst_icg);
+	}
+	d->size = xt->numf * xlen;
+
+	return vchan_tx_prep(&c->vc, &d->vd, flags);
+}
+
 static struct dma_async_tx_descriptor *bcm2835_dma_prep_slave_sg(
 	struct dma_chan *chan,
 	struct scatterlist *sgl, unsigned int sg_len,
@@ -1041,6 +1298,10 @@ static int bcm2835_dma_terminate_all(struct dma_chan *chan)
 	if (c->desc) {
 		vchan_terminate_vdesc(&c->desc->vd);
 		c->desc = NULL;
+		if (c->next_desc) {
+			vchan_terminate_vdesc(&c->next_desc->vd);
+			c->next_desc = NULL;
+		}
 		bcm2835_dma_abort(c);
 	}
 
@@ -1070,6 +1331,8 @@ static int bcm2835_dma_chan_init(struct bcm2835_dmadev *d, int chan_id,
 	c->vc.desc_free = bcm2835_dma_desc_free;
 	vchan_init(&c->vc, &d->ddev);
 	INIT_LIST_HEAD(&c->node);
+	spin_lock_init(&c->cache_lock);
+	INIT_LIST_HEAD(&c->desc_cache);
 
 	c->chan_base = BCM2835_DMA_CHANIO(d->base, chan_id);
 	c->ch = chan_id;
@@ -1159,10 +1422,25 @@ static struct dma_chan *bcm2835_dma_xlate(struct of_phandle_args *spec,
 	struct bcm2835_dmadev *d = ofdma->of_dma_data;
 	struct dma_chan *chan;
 
+	/*
+	 * DREQ paced peripheral transfers don't need the bandwidth or the 2D
+	 * mode of a full channel, so hand out lite channels first and keep
+	 * the full ones (which come first in the channel list, so are what
+	 * dma_request_channel() finds) for memcpy and interleaved users.
+	 */
+	list_for_each_entry(chan, &d->ddev.channels, device_node) {
+		if (!to_bcm2835_dma_chan(chan)->is_lite_channel ||
+		    chan->client_count)
+			continue;
+		if (dma_get_slave_channel(chan))
+			goto found;
+	}
+
 	chan = dma_get_any_slave_channel(&d->ddev);
 	if (!chan)
 		return NULL;
 
+found:
 	/* Set DREQ from param */
 	to_bcm2835_dma_chan(chan)->dreq = spec->args[0];
 
@@ -1218,6 +1496,7 @@ static int bcm2835_dma_probe(struct platform_device *pdev)
 	dma_cap_set(DMA_CYCLIC, od->ddev.cap_mask);
 	dma_cap_set(DMA_SLAVE, od->ddev.cap_mask);
 	dma_cap_set(DMA_MEMCPY, od->ddev.cap_mask);
+	dma_cap_set(DMA_INTERLEAVE, od->ddev.cap_mask);
 	od->ddev.device_alloc_chan_resources = bcm2835_dma_alloc_chan_resources;
 	od->ddev.device_free_chan_resources = bcm2835_dma_free_chan_resources;
 	od->ddev.device_tx_status = bcm2835_dma_tx_status;
@@ -1225,6 +1504,8 @@ static int bcm2835_dma_probe(struct platform_device *pdev)
 	od->ddev.device_prep_dma_cyclic = bcm2835_dma_prep_dma_cyclic;
 	od->ddev.device_prep_slave_sg = bcm2835_dma_prep_slave_sg;
 	od->ddev.device_prep_dma_memcpy = bcm2835_dma_prep_dma_memcpy;
+	od->ddev.device_prep_interleaved_dma =
+		bcm2835_dma_prep_interleaved_dma;
 	od->ddev.device_config = bcm2835_dma_slave_config;
 	od->ddev.device_terminate_all = bcm2835_dma_terminate_all;
 	od->ddev.device_synchronize = bcm2835_dma_synchronize;
@@ -9,13 +9,18 @@
  * published by the Free Software Foundation.
  */
 
+#include <linux/debugfs.h>
 #include <linux/dma-mapping.h>
+#include <linux/ktime.h>
 #include <linux/mailbox_client.h>
 #include <linux/module.h>
+#include <linux/notifier.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
 #include <linux/reboot.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
 #include <soc/bcm2835/raspberrypi-firmware.h>
 
 #define MBOX_MSG(chan, data28)		(((data28) & ~0xf) | ((chan) & 0xf))
@@ -23,15 +28,70 @@
 #define MBOX_DATA28(msg)		((msg) & ~0xf)
 #define MBOX_CHAN_PROPERTY		8
 
+/*
+ * Queued property lists are merged into one mailbox buffer of up to this
+ * size, including the buffer header and end tag. Larger lists are sent on
+ * their own.
+ */
+#define RPI_FIRMWARE_BATCH_SIZE		PAGE_SIZE
+#define RPI_FIRMWARE_STAT_TAGS		64
+
+/* firmware clock ids */
+#define RPI_FIRMWARE_ARM_CLK_ID		3
+#define RPI_FIRMWARE_CORE_CLK_ID	4
+
+/* get_throttled: bits currently limiting the clocks */
+#define RPI_FIRMWARE_THROTTLED_NOW	0x6
+
+#define RPI_FIRMWARE_THROTTLE_POLL_MS	250
+
 static struct platform_device *rpi_hwmon;
 static struct platform_device *rpi_clk;
 
+struct rpi_firmware_request {
+	struct list_head node;
+	void *data;
+	size_t tag_size;
+	rpi_firmware_callback_t callback;
+	void *context;
+	ktime_t submitted;
+};
+
+struct rpi_firmware_tag_stat {
+	u32 tag;
+	u32 count;
+	u64 total_ns;
+	u64 max_ns;
+};
+
 struct rpi_firmware {
 	struct mbox_client cl;
 	struct mbox_chan *chan; /* The property channel. */
 	struct completion c;
 	u32 enabled;
 	u32 get_throttled;
+
+	/* asynchronous property lists waiting for the mailbox */
+	spinlock_t queue_lock;
+	struct list_head queue;
+	struct workqueue_struct *wq;
+	struct work_struct work;
+	u32 *batch_buf;
+	dma_addr_t batch_addr;
+
+	/* per-tag request latency, exported in debugfs */
+	spinlock_t stats_lock;
+	struct rpi_firmware_tag_stat stats[RPI_FIRMWARE_STAT_TAGS];
+	u64 transactions;
+	u64 merged;
+	struct dentry *debugfs;
+
+	/* early warning below the firmware temperature limit */
+	struct delayed_work throttle_work;
+	struct blocking_notifier_head throttle_notifier;
+	int throttle_temp;
+	int throttle_margin;
+	bool throttle_warning;
 };
 
 static struct platform_device *g_pdev;
@@ -71,51 +131,49 @@ rpi_firmware_transaction(struct rpi_firmware *fw, u32 chan, u32 data)
 }
 EXPORT_SYMBOL_GPL(rpi_firmware_transaction);
 
-/**
- * rpi_firmware_property_list - Submit firmware property list
- * @fw:		Pointer to firmware structure from rpi_firmware_get().
- * @data:	Buffer holding tags.
- * @tag_size:	Size of tags buffer.
- *
- * Submits a set of concatenated tags to the VPU firmware through the
- * mailbox property interface.
- *
- * The buffer header and the ending tag are added by this function and
- * don't need to be supplied, just the actual tags for your operation.
- * See struct rpi_firmware_property_tag_header for the per-tag
- * structure.
+/*
+ * Sends the property lists on @batch in one mailbox buffer. If the
+ * firmware rejects a merged buffer the responses are not copied back and
+ * -EAGAIN is returned, so that the lists can be retried one at a time.
  */
-int rpi_firmware_property_list(struct rpi_firmware *fw,
-			       void *data, size_t tag_size)
+static int rpi_firmware_send_batch(struct rpi_firmware *fw,
+				   struct list_head *batch, size_t tag_size)
 {
+	struct rpi_firmware_request *req;
 	size_t size = tag_size + 12;
-	u32 *buf;
-	dma_addr_t bus_addr;
+	dma_addr_t bus_addr = fw->batch_addr;
+	u32 *buf = fw->batch_buf;
+	u8 *p;
 	int ret;
 
-	/* Packets are processed a dword at a time. */
-	if (size & 3)
-		return -EINVAL;
-
-	buf = dma_alloc_coherent(fw->cl.dev, PAGE_ALIGN(size), &bus_addr,
-				 GFP_ATOMIC);
-	if (!buf)
-		return -ENOMEM;
+	if (size > RPI_FIRMWARE_BATCH_SIZE) {
+		buf = dma_alloc_coherent(fw->cl.dev, PAGE_ALIGN(size),
+					 &bus_addr, GFP_KERNEL);
+		if (!buf)
+			return -ENOMEM;
+	}
 
 	/* The firmware will error out without parsing in this case. */
 	WARN_ON(size >= 1024 * 1024);
 
 	buf[0] = size;
 	buf[1] = RPI_FIRMWARE_STATUS_REQUEST;
-	memcpy(&buf[2], data, tag_size);
+	p = (u8 *)&buf[2];
+	list_for_each_entry(req, batch, node) {
+		memcpy(p, req->data, req->tag_size);
+		p += req->tag_size;
+	}
 	buf[size / 4 - 1] = RPI_FIRMWARE_PROPERTY_END;
 	wmb();
 
 	ret = rpi_firmware_transaction(fw, MBOX_CHAN_PROPERTY, bus_addr);
 
 	rmb();
-	memcpy(data, &buf[2], tag_size);
 	if (ret == 0 && buf[1] != RPI_FIRMWARE_STATUS_SUCCESS) {
+		if (!list_is_singular(batch)) {
+			ret = -EAGAIN;
+			goto out;
+		}
 		/*
 		 * The tag name here might not be the one causing the
 		 * error, if there were multiple tags in the request.
@@ -126,10 +184,210 @@ int rpi_firmware_property_list(struct rpi_firmware *fw,
 		ret = -EINVAL;
 	}
 
-	dma_free_coherent(fw->cl.dev, PAGE_ALIGN(size), buf, bus_addr);
+	p = (u8 *)&buf[2];
+	list_for_each_entry(req, batch, node) {
+		memcpy(req->data, p, req->tag_size);
+		p += req->tag_size;
+	}
+
+out:
+	if (buf != fw->batch_buf)
+		dma_free_coherent(fw->cl.dev, PAGE_ALIGN(size), buf, bus_addr);
 
 	return ret;
 }
+
+static struct rpi_firmware_tag_stat *
+rpi_firmware_tag_stat(struct rpi_firmware *fw, u32 tag)
+{
+	int i;
+
+	for (i = 0; i < RPI_FIRMWARE_STAT_TAGS; i++) {
+		if (fw->stats[i].tag == tag)
+			return &fw->stats[i];
+		if (!fw->stats[i].tag) {
+			fw->stats[i].tag = tag;
+			return &fw->stats[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Charges the latency of a request to each of the tags it contains. */
+static void rpi_firmware_account(struct rpi_firmware *fw,
+				 struct rpi_firmware_request *req)
+{
+	u64 delta = ktime_to_ns(ktime_sub(ktime_get(), req->submitted));
+	struct rpi_firmware_property_tag_header *header;
+	struct rpi_firmware_tag_stat *stat;
+	size_t offset = 0;
+
+	spin_lock_irq(&fw->stats_lock);
+	while (offset + sizeof(*header) <= req->tag_size) {
+		header = req->data + offset;
+		if (header->tag == RPI_FIRMWARE_PROPERTY_END)
+			break;
+
+		stat = rpi_firmware_tag_stat(fw, header->tag);
+		if (stat) {
+			stat->count++;
+			stat->total_ns += delta;
+			stat->max_ns = max(stat->max_ns, delta);
+		}
+		offset += sizeof(*header) + ALIGN(header->buf_size, 4);
+	}
+	spin_unlock_irq(&fw->stats_lock);
+}
+
+static void rpi_firmware_complete(struct rpi_firmware *fw,
+				  struct rpi_firmware_request *req, int status)
+{
+	list_del(&req->node);
+	rpi_firmware_account(fw, req);
+	req->callback(req->context, status);
+	kfree(req);
+}
+
+static void rpi_firmware_work(struct work_struct *work)
+{
+	struct rpi_firmware *fw = container_of(work, struct rpi_firmware,
+					       work);
+	struct rpi_firmware_request *req, *tmp;
+	LIST_HEAD(batch);
+	unsigned int n;
+	size_t size;
+	int ret;
+
+	for (;;) {
+		size = 0;
+		n = 0;
+		spin_lock_irq(&fw->queue_lock);
+		list_for_each_entry_safe(req, tmp, &fw->queue, node) {
+			if (size &&
+			    size + req->tag_size > RPI_FIRMWARE_BATCH_SIZE - 12)
+				break;
+			list_move_tail(&req->node, &batch);
+			size += req->tag_size;
+			n++;
+		}
+		spin_unlock_irq(&fw->queue_lock);
+
+		if (list_empty(&batch))
+			return;
+
+		ret = rpi_firmware_send_batch(fw, &batch, size);
+
+		spin_lock_irq(&fw->stats_lock);
+		fw->transactions++;
+		fw->merged += n - 1;
+		spin_unlock_irq(&fw->stats_lock);
+
+		list_for_each_entry_safe(req, tmp, &batch, node) {
+			if (ret == -EAGAIN) {
+				LIST_HEAD(single);
+
+				list_move(&req->node, &single);
+				rpi_firmware_complete(fw, req,
+					rpi_firmware_send_batch(fw, &single,
+								req->tag_size));
+			} else {
+				rpi_firmware_complete(fw, req, ret);
+			}
+		}
+	}
+}
+
+/**
+ * rpi_firmware_property_list_async - Queue a firmware property list
+ * @fw:		Pointer to firmware structure from rpi_firmware_get().
+ * @data:	Buffer holding tags, must stay valid until @callback.
+ * @tag_size:	Size of tags buffer.
+ * @callback:	Called with the result once the response is in @data.
+ * @context:	Passed to @callback.
+ *
+ * Queues a set of concatenated tags for the VPU firmware and returns
+ * without waiting for the mailbox. Lists queued by different callers
+ * while an earlier transaction is in flight are sent together in one
+ * mailbox buffer, each list staying contiguous and in submission order.
+ * May be called from atomic context.
+ */
+int rpi_firmware_property_list_async(struct rpi_firmware *fw,
+				     void *data, size_t tag_size,
+				     rpi_firmware_callback_t callback,
+				     void *context)
+{
+	struct rpi_firmware_request *req;
+	unsigned long flags;
+
+	/* Packets are processed a dword at a time. */
+	if (tag_size & 3)
+		return -EINVAL;
+
+	req = kzalloc(sizeof(*req), GFP_ATOMIC);
+	if (!req)
+		return -ENOMEM;
+
+	req->data = data;
+	req->tag_size = tag_size;
+	req->callback = callback;
+	req->context = context;
+	req->submitted = ktime_get();
+
+	spin_lock_irqsave(&fw->queue_lock, flags);
+	list_add_tail(&req->node, &fw->queue);
+	spin_unlock_irqrestore(&fw->queue_lock, flags);
+
+	queue_work(fw->wq, &fw->work);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(rpi_firmware_property_list_async);
+
+struct rpi_firmware_sync {
+	struct completion done;
+	int status;
+};
+
+static void rpi_firmware_sync_callback(void *context, int status)
+{
+	struct rpi_firmware_sync *sync = context;
+
+	sync->status = status;
+	complete(&sync->done);
+}
+
+/**
+ * rpi_firmware_property_list - Submit firmware property list
+ * @fw:		Pointer to firmware structure from rpi_firmware_get().
+ * @data:	Buffer holding tags.
+ * @tag_size:	Size of tags buffer.
+ *
+ * Submits a set of concatenated tags to the VPU firmware through the
+ * mailbox property interface and waits for the reply.
+ *
+ * The buffer header and the ending tag are added by this function and
+ * don't need to be supplied, just the actual tags for your operation.
+ * See struct rpi_firmware_property_tag_header for the per-tag
+ * structure.
+ */
+int rpi_firmware_property_list(struct rpi_firmware *fw,
+			       void *data, size_t tag_size)
+{
+	struct rpi_firmware_sync sync;
+	int ret;
+
+	init_completion(&sync.done);
+	ret = rpi_firmware_property_list_async(fw, data, tag_size,
+					       rpi_firmware_sync_callback,
+					       &sync);
+	if (ret)
+		return ret;
+
+	wait_for_completion(&sync.done);
+
+	return sync.status;
+}
 EXPORT_SYMBOL_GPL(rpi_firmware_property_list);
 
 /**
@@ -225,6 +483,241 @@ static const struct attribute_group rpi_firmware_dev_group = {
 	.attrs = rpi_firmware_dev_attrs,
 };
 
+/**
+ * rpi_firmware_register_throttle_notifier - Watch for throttle warnings
+ * @fw:		Pointer to firmware structure from rpi_firmware_get().
+ * @nb:		Notifier called with RPI_FIRMWARE_THROTTLE_WARNING or
+ *		RPI_FIRMWARE_THROTTLE_CLEAR and a pointer to the SoC
+ *		temperature in millidegrees Celsius.
+ *
+ * The warning is raised once the temperature comes within throttle_margin
+ * of the limit at which the firmware drops the clocks, or the firmware
+ * has already capped them.
+ */
+int rpi_firmware_register_throttle_notifier(struct rpi_firmware *fw,
+					    struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&fw->throttle_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(rpi_firmware_register_throttle_notifier);
+
+int rpi_firmware_unregister_throttle_notifier(struct rpi_firmware *fw,
+					      struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&fw->throttle_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(rpi_firmware_unregister_throttle_notifier);
+
+static void rpi_firmware_throttle_work(struct work_struct *work)
+{
+	struct rpi_firmware *fw = container_of(to_delayed_work(work),
+					       struct rpi_firmware,
+					       throttle_work);
+	int margin = READ_ONCE(fw->throttle_margin);
+	u32 packet[2] = { 0, 0 };
+	u32 throttled = 0;
+	bool warning;
+	int temp;
+
+	if (!margin) {
+		warning = false;
+		temp = 0;
+		goto update;
+	}
+
+	/* a zero request leaves the sticky bits for the hwmon driver */
+	if (rpi_firmware_property(fw, RPI_FIRMWARE_GET_THROTTLED,
+				  &throttled, sizeof(throttled)))
+		throttled = 0;
+	if (rpi_firmware_property(fw, RPI_FIRMWARE_GET_TEMPERATURE,
+				  packet, sizeof(packet)))
+		goto out;
+	temp = packet[1];
+
+	warning = temp >= fw->throttle_temp - margin ||
+		  (throttled & RPI_FIRMWARE_THROTTLED_NOW);
+
+update:
+	if (warning != fw->throttle_warning) {
+		fw->throttle_warning = warning;
+		sysfs_notify(&fw->cl.dev->kobj, NULL, "throttle_warning");
+		blocking_notifier_call_chain(&fw->throttle_notifier,
+					     warning ?
+					     RPI_FIRMWARE_THROTTLE_WARNING :
+					     RPI_FIRMWARE_THROTTLE_CLEAR,
+					     &temp);
+	}
+out:
+	if (margin)
+		schedule_delayed_work(&fw->throttle_work,
+			msecs_to_jiffies(RPI_FIRMWARE_THROTTLE_POLL_MS));
+}
+
+static ssize_t throttle_margin_show(struct device *dev,
+				    struct device_attribute *attr, char *buf)
+{
+	struct rpi_firmware *fw = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", READ_ONCE(fw->throttle_margin));
+}
+
+/* millidegrees below throttle_temp, 0 stops the monitor */
+static ssize_t throttle_margin_store(struct device *dev,
+				     struct device_attribute *attr,
+				     const char *buf, size_t count)
+{
+	struct rpi_firmware *fw = dev_get_drvdata(dev);
+	int margin, ret;
+
+	ret = kstrtoint(buf, 10, &margin);
+	if (ret)
+		return ret;
+	if (margin < 0)
+		return -EINVAL;
+
+	WRITE_ONCE(fw->throttle_margin, margin);
+	mod_delayed_work(system_wq, &fw->throttle_work, 0);
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(throttle_margin);
+
+static ssize_t throttle_warning_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct rpi_firmware *fw = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", fw->throttle_warning);
+}
+
+static DEVICE_ATTR_RO(throttle_warning);
+
+static ssize_t throttle_temp_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct rpi_firmware *fw = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", fw->throttle_temp);
+}
+
+static DEVICE_ATTR_RO(throttle_temp);
+
+/*
+ * While the firmware is capping the clocks, the rate it runs at is the
+ * cap, otherwise it may go up to the maximum rate.
+ */
+static ssize_t rpi_firmware_clock_cap_show(struct device *dev, u32 id,
+					   char *buf)
+{
+	struct rpi_firmware *fw = dev_get_drvdata(dev);
+	u32 throttled = 0;
+	u32 packet[2];
+	u32 tag;
+	int ret;
+
+	if (rpi_firmware_property(fw, RPI_FIRMWARE_GET_THROTTLED,
+				  &throttled, sizeof(throttled)))
+		throttled = 0;
+
+	tag = (throttled & RPI_FIRMWARE_THROTTLED_NOW) ?
+	      RPI_FIRMWARE_GET_CLOCK_RATE : RPI_FIRMWARE_GET_MAX_CLOCK_RATE;
+	packet[0] = id;
+	packet[1] = 0;
+	ret = rpi_firmware_property(fw, tag, packet, sizeof(packet));
+	if (ret)
+		return ret;
+
+	return sprintf(buf, "%u\n", packet[1] / 1000);
+}
+
+static ssize_t arm_clock_cap_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	return rpi_firmware_clock_cap_show(dev, RPI_FIRMWARE_ARM_CLK_ID, buf);
+}
+
+static DEVICE_ATTR_RO(arm_clock_cap);
+
+static ssize_t core_clock_cap_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	return rpi_firmware_clock_cap_show(dev, RPI_FIRMWARE_CORE_CLK_ID, buf);
+}
+
+static DEVICE_ATTR_RO(core_clock_cap);
+
+static struct attribute *rpi_firmware_throttle_attrs[] = {
+	&dev_attr_throttle_margin.attr,
+	&dev_attr_throttle_warning.attr,
+	&dev_attr_throttle_temp.attr,
+	&dev_attr_arm_clock_cap.attr,
+	&dev_attr_core_clock_cap.attr,
+	NULL,
+};
+
+static const struct attribute_group rpi_firmware_throttle_group = {
+	.attrs = rpi_firmware_throttle_attrs,
+};
+
+static int rpi_firmware_latency_show(struct seq_file *m, void *v)
+{
+	struct rpi_firmware *fw = m->private;
+	struct rpi_firmware_tag_stat stat;
+	int i;
+
+	spin_lock_irq(&fw->stats_lock);
+	seq_printf(m, "transactions %llu, merged requests %llu\n",
+		   fw->transactions, fw->merged);
+	spin_unlock_irq(&fw->stats_lock);
+
+	seq_puts(m, "tag         count    avg_us    max_us\n");
+	for (i = 0; i < RPI_FIRMWARE_STAT_TAGS; i++) {
+		spin_lock_irq(&fw->stats_lock);
+		stat = fw->stats[i];
+		spin_unlock_irq(&fw->stats_lock);
+
+		if (!stat.tag)
+			break;
+		seq_printf(m, "0x%08x %8u %9llu %9llu\n", stat.tag, stat.count,
+			   div_u64(div_u64(stat.total_ns, stat.count),
+				   NSEC_PER_USEC),
+			   div_u64(stat.max_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static int rpi_firmware_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rpi_firmware_latency_show, inode->i_private);
+}
+
+static ssize_t rpi_firmware_latency_write(struct file *file,
+					  const char __user *buf,
+					  size_t count, loff_t *ppos)
+{
+	struct rpi_firmware *fw = file_inode(file)->i_private;
+
+	spin_lock_irq(&fw->stats_lock);
+	memset(fw->stats, 0, sizeof(fw->stats));
+	fw->transactions = 0;
+	fw->merged = 0;
+	spin_unlock_irq(&fw->stats_lock);
+
+	return count;
+}
+
+/* reading shows the per-tag latency, any write clears it */
+static const struct file_operations rpi_firmware_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = rpi_firmware_latency_open,
+	.read = seq_read,
+	.write = rpi_firmware_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void
 rpi_firmware_print_firmware_revision(struct rpi_firmware *fw)
 {
@@ -298,6 +791,23 @@ rpi_register_hwmon_driver(struct device *dev, struct rpi_firmware *fw)
 	}
 }
 
+static void
+rpi_register_throttle_monitor(struct device *dev, struct rpi_firmware *fw)
+{
+	u32 packet[2] = { 0, 0 };
+	int ret = rpi_firmware_property(fw, RPI_FIRMWARE_GET_MAX_TEMPERATURE,
+					packet, sizeof(packet));
+
+	if (ret)
+		return;
+
+	if (devm_device_add_group(dev, &rpi_firmware_throttle_group)) {
+		dev_err(dev, "Failed to create throttle attrs\n");
+		return;
+	}
+	fw->throttle_temp = packet[1];
+}
+
 static void rpi_register_clk_driver(struct device *dev)
 {
 	rpi_clk = platform_device_register_data(dev, "raspberrypi-clk",
@@ -326,6 +836,26 @@ static int rpi_firmware_probe(struct platform_device *pdev)
 	}
 
 	init_completion(&fw->c);
+	spin_lock_init(&fw->queue_lock);
+	INIT_LIST_HEAD(&fw->queue);
+	INIT_WORK(&fw->work, rpi_firmware_work);
+	spin_lock_init(&fw->stats_lock);
+	INIT_DELAYED_WORK(&fw->throttle_work, rpi_firmware_throttle_work);
+	BLOCKING_INIT_NOTIFIER_HEAD(&fw->throttle_notifier);
+
+	fw->batch_buf = dmam_alloc_coherent(dev, RPI_FIRMWARE_BATCH_SIZE,
+					    &fw->batch_addr, GFP_KERNEL);
+	fw->wq = alloc_ordered_workqueue("rpi-firmware", WQ_HIGHPRI);
+	if (!fw->batch_buf || !fw->wq) {
+		if (fw->wq)
+			destroy_workqueue(fw->wq);
+		mbox_free_channel(fw->chan);
+		return -ENOMEM;
+	}
+
+	fw->debugfs = debugfs_create_dir("raspberrypi-firmware", NULL);
+	debugfs_create_file("latency", 0644, fw->debugfs, fw,
+			    &rpi_firmware_latency_fops);
 
 	platform_set_drvdata(pdev, fw);
 	g_pdev = pdev;
@@ -333,6 +863,7 @@ static int rpi_firmware_probe(struct platform_device *pdev)
 	rpi_firmware_print_firmware_revision(fw);
 	rpi_firmware_print_firmware_hash(fw);
 	rpi_register_hwmon_driver(dev, fw);
+	rpi_register_throttle_monitor(dev, fw);
 	rpi_register_clk_driver(dev);
 
 	return 0;
@@ -346,8 +877,15 @@ static int rpi_firmware_remove(struct platform_device *pdev)
 	rpi_hwmon = NULL;
 	platform_device_unregister(rpi_clk);
 	rpi_clk = NULL;
-	mbox_free_channel(fw->chan);
 	g_pdev = NULL;
+	if (fw->throttle_temp)
+		devm_device_remove_group(&pdev->dev,
+					 &rpi_firmware_throttle_group);
+	WRITE_ONCE(fw->throttle_margin, 0);
+	cancel_delayed_work_sync(&fw->throttle_work);
+	destroy_workqueue(fw->wq);
+	debugfs_remove_recursive(fw->debugfs);
+	mbox_free_channel(fw->chan);
 
 	return 0;
 }
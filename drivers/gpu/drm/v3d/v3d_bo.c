@@ -10,6 +10,10 @@
  *
  * Physically contiguous objects may still be imported to V3D, but the
  * driver doesn't allocate physically contiguous objects on its own.
+ * When transparent huge pages are available, BOs do come from a
+ * private tmpfs mount with huge pages enabled, so that large BOs are
+ * mostly made of physically contiguous chunks the MMU can map with
+ * its 64KB and 1MB page entries.
  * Display engines requiring physically contiguous allocations should
  * look into Mesa's "renderonly" support (as used by the Mesa pl111
  * driver) for an example of how to integrate with V3D.
@@ -20,7 +24,10 @@
  */
 
 #include <linux/dma-buf.h>
+#include <linux/fs.h>
+#include <linux/mount.h>
 #include <linux/pfn_t.h>
+#include <linux/shmem_fs.h>
 
 #include "v3d_drv.h"
 #include "uapi/drm/v3d_drm.h"
@@ -100,6 +107,66 @@ v3d_bo_put_pages(struct v3d_bo *bo)
 	mutex_unlock(&bo->lock);
 }
 
+int v3d_gemfs_init(struct v3d_dev *v3d)
+{
+	struct file_system_type *type;
+	struct vfsmount *gemfs;
+	struct super_block *sb;
+	char options[] = "huge=within_size";
+	int flags = 0;
+	int ret;
+
+	/* Without THP, plain shmem is just as good. */
+	if (!has_transparent_hugepage())
+		return 0;
+
+	type = get_fs_type("tmpfs");
+	if (!type)
+		return -ENODEV;
+
+	gemfs = kern_mount(type);
+	if (IS_ERR(gemfs))
+		return PTR_ERR(gemfs);
+
+	sb = gemfs->mnt_sb;
+	ret = sb->s_op->remount_fs(sb, &flags, options);
+	if (ret) {
+		kern_unmount(gemfs);
+		return ret;
+	}
+
+	v3d->gemfs = gemfs;
+
+	return 0;
+}
+
+void v3d_gemfs_fini(struct v3d_dev *v3d)
+{
+	if (v3d->gemfs)
+		kern_unmount(v3d->gemfs);
+	v3d->gemfs = NULL;
+}
+
+static int v3d_gem_object_init(struct v3d_dev *v3d,
+			       struct drm_gem_object *obj, size_t size)
+{
+	struct file *filp;
+
+	if (!v3d->gemfs)
+		return drm_gem_object_init(&v3d->drm, obj, size);
+
+	drm_gem_private_object_init(&v3d->drm, obj, size);
+
+	filp = shmem_file_setup_with_mnt(v3d->gemfs, "v3d", size,
+					 VM_NORESERVE);
+	if (IS_ERR(filp))
+		return PTR_ERR(filp);
+
+	obj->filp = filp;
+
+	return 0;
+}
+
 static struct v3d_bo *v3d_bo_create_struct(struct drm_device *dev,
 					   size_t unaligned_size)
 {
@@ -107,6 +174,7 @@ static struct v3d_bo *v3d_bo_create_struct(struct drm_device *dev,
 	struct drm_gem_object *obj;
 	struct v3d_bo *bo;
 	size_t size = roundup(unaligned_size, PAGE_SIZE);
+	u64 align = GMP_GRANULARITY;
 	int ret;
 
 	if (size == 0)
@@ -121,14 +189,18 @@ static struct v3d_bo *v3d_bo_create_struct(struct drm_device *dev,
 	INIT_LIST_HEAD(&bo->unref_head);
 	mutex_init(&bo->lock);
 
-	ret = drm_gem_object_init(dev, obj, size);
+	ret = v3d_gem_object_init(v3d, obj, size);
 	if (ret)
 		goto free_bo;
 
+	/* Give large BOs an address the MMU's superpages can be used at. */
+	if (size >= SZ_1M)
+		align = SZ_1M;
+
 	spin_lock(&v3d->mm_lock);
 	ret = drm_mm_insert_node_generic(&v3d->mm, &bo->node,
 					 obj->size >> PAGE_SHIFT,
-					 GMP_GRANULARITY >> PAGE_SHIFT, 0, 0);
+					 align >> PAGE_SHIFT, 0, 0);
 	spin_unlock(&v3d->mm_lock);
 	if (ret)
 		goto free_obj;
@@ -194,6 +194,50 @@ static int v3d_debugfs_bo_stats(struct seq_file *m, void *unused)
 	return 0;
 }
 
+static int v3d_debugfs_job_stats(struct seq_file *m, void *unused)
+{
+	static const char * const queue_names[V3D_MAX_QUEUES] = {
+		[V3D_BIN] = "bin",
+		[V3D_RENDER] = "render",
+		[V3D_TFU] = "tfu",
+		[V3D_CSD] = "csd",
+		[V3D_CACHE_CLEAN] = "cache_clean",
+	};
+	struct drm_info_node *node = (struct drm_info_node *)m->private;
+	struct drm_device *dev = node->minor->dev;
+	struct v3d_dev *v3d = to_v3d_dev(dev);
+	unsigned long irqflags;
+	enum v3d_queue q;
+	int i;
+
+	for (q = 0; q < V3D_MAX_QUEUES; q++) {
+		struct v3d_job_stats stats;
+
+		spin_lock_irqsave(&v3d->job_lock, irqflags);
+		stats = v3d->queue[q].job_stats;
+		spin_unlock_irqrestore(&v3d->job_lock, irqflags);
+
+		/* The cache clean jobs are synchronous, so never show up. */
+		if (!stats.count)
+			continue;
+
+		seq_printf(m, "%s: %llu jobs, avg %llu us, max %llu us\n",
+			   queue_names[q], stats.count,
+			   div64_u64(stats.total_ns,
+				     stats.count * NSEC_PER_USEC),
+			   div_u64(stats.max_ns, NSEC_PER_USEC));
+
+		for (i = 0; i < V3D_JOB_HIST_BUCKETS; i++) {
+			if (!stats.hist[i])
+				continue;
+			seq_printf(m, "  >= %8lu us: %u\n",
+				   i ? 1UL << (i - 1) : 0UL, stats.hist[i]);
+		}
+	}
+
+	return 0;
+}
+
 static int v3d_measure_clock(struct seq_file *m, void *unused)
 {
 	struct drm_info_node *node = (struct drm_info_node *)m->private;
@@ -234,6 +278,7 @@ static const struct drm_info_list v3d_debugfs_list[] = {
 	{"v3d_regs", v3d_v3d_debugfs_regs, 0},
 	{"measure_clock", v3d_measure_clock, 0},
 	{"bo_stats", v3d_debugfs_bo_stats, 0},
+	{"job_stats", v3d_debugfs_job_stats, 0},
 };
 
 int
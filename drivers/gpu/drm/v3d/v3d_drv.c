@@ -20,6 +20,7 @@
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/reset.h>
+#include <drm/drm_auth.h>
 #include <drm/drm_fb_cma_helper.h>
 #include <drm/drm_fb_helper.h>
 
@@ -118,6 +119,7 @@ static int v3d_get_param_ioctl(struct drm_device *dev, void *data,
 		args->value = v3d_has_csd(v3d);
 		return 0;
 	case DRM_V3D_PARAM_SUPPORTS_CACHE_FLUSH:
+	case DRM_V3D_PARAM_SUPPORTS_PRIORITY:
 		args->value = 1;
 		return 0;
 	default:
@@ -126,6 +128,50 @@ static int v3d_get_param_ioctl(struct drm_device *dev, void *data,
 	}
 }
 
+static int v3d_set_priority_ioctl(struct drm_device *dev, void *data,
+				  struct drm_file *file_priv)
+{
+	struct v3d_dev *v3d = to_v3d_dev(dev);
+	struct v3d_file_priv *v3d_priv = file_priv->driver_priv;
+	struct drm_v3d_set_priority *args = data;
+	enum drm_sched_priority priority;
+	struct drm_sched_rq *rq;
+	enum v3d_queue q;
+
+	if (args->pad != 0)
+		return -EINVAL;
+
+	switch (args->priority) {
+	case DRM_V3D_PRIORITY_LOW:
+		priority = DRM_SCHED_PRIORITY_LOW;
+		break;
+	case DRM_V3D_PRIORITY_NORMAL:
+		priority = DRM_SCHED_PRIORITY_NORMAL;
+		break;
+	case DRM_V3D_PRIORITY_HIGH:
+		/* Keep random clients from starving the compositor. */
+		if (!drm_is_current_master(file_priv) &&
+		    !capable(CAP_SYS_NICE))
+			return -EACCES;
+		priority = DRM_SCHED_PRIORITY_HIGH_SW;
+		break;
+	default:
+		DRM_DEBUG("Unknown priority %d\n", args->priority);
+		return -EINVAL;
+	}
+
+	/* The bin and render queues get the same priority, so that a
+	 * high priority frame doesn't get stuck behind its own binning.
+	 * Jobs already queued on the entity move along with it.
+	 */
+	for (q = 0; q < V3D_MAX_QUEUES; q++) {
+		rq = &v3d->queue[q].sched.sched_rq[priority];
+		drm_sched_entity_set_rq(&v3d_priv->sched_entity[q], rq);
+	}
+
+	return 0;
+}
+
 static int
 v3d_open(struct drm_device *dev, struct drm_file *file)
 {
@@ -190,6 +236,7 @@ static const struct drm_ioctl_desc v3d_drm_ioctls[] = {
 	DRM_IOCTL_DEF_DRV(V3D_GET_BO_OFFSET, v3d_get_bo_offset_ioctl, DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(V3D_SUBMIT_TFU, v3d_submit_tfu_ioctl, DRM_RENDER_ALLOW | DRM_AUTH),
 	DRM_IOCTL_DEF_DRV(V3D_SUBMIT_CSD, v3d_submit_csd_ioctl, DRM_RENDER_ALLOW | DRM_AUTH),
+	DRM_IOCTL_DEF_DRV(V3D_SET_PRIORITY, v3d_set_priority_ioctl, DRM_RENDER_ALLOW),
 };
 
 static const struct vm_operations_struct v3d_vm_ops = {
@@ -22,11 +22,29 @@ enum v3d_queue {
 
 #define V3D_MAX_QUEUES (V3D_CACHE_CLEAN + 1)
 
+/* Job durations are kept in power-of-two microsecond buckets: bucket 0
+ * is under 1us, bucket n is [2^(n-1), 2^n) us and the last one holds
+ * everything from about a second up.
+ */
+#define V3D_JOB_HIST_BUCKETS 22
+
+struct v3d_job_stats {
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+	u32 hist[V3D_JOB_HIST_BUCKETS];
+};
+
 struct v3d_queue_state {
 	struct drm_gpu_scheduler sched;
 
 	u64 fence_context;
 	u64 emit_seqno;
+
+	/* Time from the job being handed to the HW to its completion
+	 * interrupt, protected by v3d->job_lock.
+	 */
+	struct v3d_job_stats job_stats;
 };
 
 struct v3d_dev {
@@ -107,6 +125,11 @@ struct v3d_dev {
 	 */
 	struct mutex cache_clean_lock;
 
+	/* Private tmpfs mount with huge pages enabled that BOs are
+	 * allocated from, if THP is available.
+	 */
+	struct vfsmount *gemfs;
+
 	struct {
 		u32 num_allocated;
 		u32 pages_allocated;
@@ -174,6 +197,8 @@ struct v3d_fence {
 	/* v3d seqno for signaled() test */
 	u64 seqno;
 	enum v3d_queue queue;
+	/* When the job was submitted to the HW, for the job_stats. */
+	u64 start_ns;
 };
 
 static inline struct v3d_fence *
@@ -314,6 +339,8 @@ static inline unsigned long nsecs_to_jiffies_timeout(const u64 n)
 }
 
 /* v3d_bo.c */
+int v3d_gemfs_init(struct v3d_dev *v3d);
+void v3d_gemfs_fini(struct v3d_dev *v3d);
 void v3d_free_object(struct drm_gem_object *gem_obj);
 struct v3d_bo *v3d_bo_create(struct drm_device *dev, struct drm_file *file_priv,
 			     size_t size);
@@ -1060,10 +1060,16 @@ v3d_gem_init(struct drm_device *dev)
 	 */
 	drm_mm_init(&v3d->mm, 1, pt_size / sizeof(u32) - 1);
 
+	ret = v3d_gemfs_init(v3d);
+	if (ret)
+		DRM_NOTE("Unable to create a private tmpfs mount, huge page support will be disabled (%d).\n",
+			 ret);
+
 	v3d->pt = dma_alloc_wc(v3d->dev, pt_size,
 			       &v3d->pt_paddr,
 			       GFP_KERNEL | __GFP_NOWARN | __GFP_ZERO);
 	if (!v3d->pt) {
+		v3d_gemfs_fini(v3d);
 		drm_mm_takedown(&v3d->mm);
 		dev_err(v3d->dev,
 			"Failed to allocate page tables. "
@@ -1076,6 +1082,7 @@ v3d_gem_init(struct drm_device *dev)
 
 	ret = v3d_sched_init(v3d);
 	if (ret) {
+		v3d_gemfs_fini(v3d);
 		drm_mm_takedown(&v3d->mm);
 		dma_free_coherent(v3d->dev, 4096 * 1024, (void *)v3d->pt,
 				  v3d->pt_paddr);
@@ -1098,6 +1105,7 @@ v3d_gem_destroy(struct drm_device *dev)
 	WARN_ON(v3d->render_job);
 
 	drm_mm_takedown(&v3d->mm);
+	v3d_gemfs_fini(v3d);
 
 	dma_free_coherent(v3d->dev, 4096 * 1024, (void *)v3d->pt, v3d->pt_paddr);
 }
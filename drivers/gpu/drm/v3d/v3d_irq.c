@@ -13,6 +13,8 @@
  * current job can make progress.
  */
 
+#include <linux/log2.h>
+
 #include "v3d_drv.h"
 #include "v3d_regs.h"
 #include "v3d_trace.h"
@@ -71,6 +73,26 @@ v3d_overflow_mem_work(struct work_struct *work)
 	drm_gem_object_put_unlocked(&bo->base);
 }
 
+/* Accounts the run time of the job that @fence signals the end of. */
+static void
+v3d_job_stats_update(struct v3d_dev *v3d, struct v3d_fence *fence)
+{
+	struct v3d_queue_state *queue = &v3d->queue[fence->queue];
+	u64 ns = ktime_get_ns() - fence->start_ns;
+	u64 us = div_u64(ns, NSEC_PER_USEC);
+	unsigned int bucket;
+
+	bucket = us ? min_t(unsigned int, ilog2(us) + 1,
+			    V3D_JOB_HIST_BUCKETS - 1) : 0;
+
+	spin_lock(&v3d->job_lock);
+	queue->job_stats.count++;
+	queue->job_stats.total_ns += ns;
+	queue->job_stats.max_ns = max(queue->job_stats.max_ns, ns);
+	queue->job_stats.hist[bucket]++;
+	spin_unlock(&v3d->job_lock);
+}
+
 static irqreturn_t
 v3d_irq(int irq, void *arg)
 {
@@ -97,6 +119,7 @@ v3d_irq(int irq, void *arg)
 			to_v3d_fence(v3d->bin_job->base.irq_fence);
 
 		trace_v3d_bcl_irq(&v3d->drm, fence->seqno);
+		v3d_job_stats_update(v3d, fence);
 		dma_fence_signal(&fence->base);
 		status = IRQ_HANDLED;
 	}
@@ -106,6 +129,7 @@ v3d_irq(int irq, void *arg)
 			to_v3d_fence(v3d->render_job->base.irq_fence);
 
 		trace_v3d_rcl_irq(&v3d->drm, fence->seqno);
+		v3d_job_stats_update(v3d, fence);
 		dma_fence_signal(&fence->base);
 		status = IRQ_HANDLED;
 	}
@@ -115,6 +139,7 @@ v3d_irq(int irq, void *arg)
 			to_v3d_fence(v3d->csd_job->base.irq_fence);
 
 		trace_v3d_csd_irq(&v3d->drm, fence->seqno);
+		v3d_job_stats_update(v3d, fence);
 		dma_fence_signal(&fence->base);
 		status = IRQ_HANDLED;
 	}
@@ -151,6 +176,7 @@ v3d_hub_irq(int irq, void *arg)
 			to_v3d_fence(v3d->tfu_job->base.irq_fence);
 
 		trace_v3d_tfu_irq(&v3d->drm, fence->seqno);
+		v3d_job_stats_update(v3d, fence);
 		dma_fence_signal(&fence->base);
 		status = IRQ_HANDLED;
 	}
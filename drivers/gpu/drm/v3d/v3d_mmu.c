@@ -16,6 +16,11 @@
  * To protect clients from each other, we should use the GMP to
  * quickly mask out (at 128kb granularity) what pages are available to
  * each client.  This is not yet implemented.
+ *
+ * Besides 4KB pages, the MMU can map 64KB "big pages" and 1MB
+ * superpages, which each take a single TLB entry.  We use them for any
+ * part of a BO where both the V3D and the bus address are aligned to
+ * the larger size and the pages are physically contiguous.
  */
 
 #include <linux/pm_runtime.h>
@@ -26,9 +31,10 @@
 #define V3D_MMU_PAGE_SHIFT 12
 
 /* Note: All PTEs for the 1MB superpage must be filled with the
- * superpage bit set.
+ * superpage bit set, and likewise for the 64KB big page.
  */
 #define V3D_PTE_SUPERPAGE BIT(31)
+#define V3D_PTE_BIGPAGE BIT(30)
 #define V3D_PTE_WRITEABLE BIT(29)
 #define V3D_PTE_VALID BIT(28)
 
@@ -94,6 +100,13 @@ int v3d_mmu_set_page_table(struct v3d_dev *v3d)
 	return v3d_mmu_flush_all(v3d);
 }
 
+static bool v3d_mmu_is_aligned(u32 page, u32 page_address, size_t alignment)
+{
+	u32 mask = (alignment >> V3D_MMU_PAGE_SHIFT) - 1;
+
+	return !(page & mask) && !(page_address & mask);
+}
+
 void v3d_mmu_insert_ptes(struct v3d_bo *bo)
 {
 	struct v3d_dev *v3d = to_v3d_dev(bo->base.dev);
@@ -104,14 +117,33 @@ void v3d_mmu_insert_ptes(struct v3d_bo *bo)
 
 	for_each_sg(bo->sgt->sgl, sgl, bo->sgt->nents, count) {
 		u32 page_address = sg_dma_address(sgl) >> V3D_MMU_PAGE_SHIFT;
-		u32 pte = page_prot | page_address;
-		u32 i;
-
-		BUG_ON(page_address + (sg_dma_len(sgl) >> V3D_MMU_PAGE_SHIFT) >=
-		       BIT(24));
-
-		for (i = 0; i < sg_dma_len(sgl) >> V3D_MMU_PAGE_SHIFT; i++)
-			v3d->pt[page++] = pte + i;
+		u32 npages = sg_dma_len(sgl) >> V3D_MMU_PAGE_SHIFT;
+
+		BUG_ON(page_address + npages >= BIT(24));
+
+		while (npages) {
+			u32 pte = page_prot | page_address;
+			u32 i, chunk;
+
+			if (npages >= SZ_1M >> V3D_MMU_PAGE_SHIFT &&
+			    v3d_mmu_is_aligned(page, page_address, SZ_1M)) {
+				chunk = SZ_1M >> V3D_MMU_PAGE_SHIFT;
+				pte |= V3D_PTE_SUPERPAGE;
+			} else if (npages >= SZ_64K >> V3D_MMU_PAGE_SHIFT &&
+				   v3d_mmu_is_aligned(page, page_address,
+						      SZ_64K)) {
+				chunk = SZ_64K >> V3D_MMU_PAGE_SHIFT;
+				pte |= V3D_PTE_BIGPAGE;
+			} else {
+				chunk = 1;
+			}
+
+			for (i = 0; i < chunk; i++)
+				v3d->pt[page++] = pte + i;
+
+			page_address += chunk;
+			npages -= chunk;
+		}
 	}
 
 	WARN_ON_ONCE(page - bo->node.start !=
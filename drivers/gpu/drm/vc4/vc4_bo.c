@@ -20,6 +20,10 @@
  */
 
 #include <linux/dma-buf.h>
+#include <linux/log2.h>
+#include <linux/shrinker.h>
+
+#include <drm/drm_print.h>
 
 #include "vc4_drv.h"
 #include "uapi/drm/vc4_drm.h"
@@ -40,8 +44,41 @@ static bool is_user_label(int label)
 	return label >= VC4_BO_TYPE_COUNT;
 }
 
+static unsigned int vc4_bo_size_class(size_t size)
+{
+	return min_t(unsigned int, ilog2(size >> PAGE_SHIFT),
+		     VC4_BO_CACHE_SIZE_CLASSES - 1);
+}
+
+static void vc4_bo_cache_stats_print(struct vc4_dev *vc4,
+				     struct drm_printer *p)
+{
+	int i;
+
+	lockdep_assert_held(&vc4->bo_lock);
+
+	drm_printf(p, "BO cache: %lukb, expiry %ums\n",
+		   vc4->bo_cache.num_pages << (PAGE_SHIFT - 10),
+		   vc4->bo_cache.expire_ms);
+	drm_printf(p, "%12s %10s %10s %10s %10s\n", "size",
+		   "hits", "misses", "expired", "reclaimed");
+	for (i = 0; i < VC4_BO_CACHE_SIZE_CLASSES; i++) {
+		struct vc4_bo_cache_stats *stats = &vc4->bo_cache.stats[i];
+
+		if (!stats->hits && !stats->misses)
+			continue;
+
+		drm_printf(p, "%9lukb%s %10u %10u %10u %10u\n",
+			   PAGE_SIZE << i >> 10,
+			   i == VC4_BO_CACHE_SIZE_CLASSES - 1 ? "+ " : "  ",
+			   stats->hits, stats->misses, stats->expired,
+			   stats->reclaimed);
+	}
+}
+
 static void vc4_bo_stats_dump(struct vc4_dev *vc4)
 {
+	struct drm_printer p = drm_info_printer(vc4->dev->dev);
 	int i;
 
 	for (i = 0; i < vc4->num_labels; i++) {
@@ -64,6 +101,10 @@ static void vc4_bo_stats_dump(struct vc4_dev *vc4)
 			 vc4->purgeable.purged_size / 1024,
 			 vc4->purgeable.purged_num);
 	mutex_unlock(&vc4->purgeable.lock);
+
+	mutex_lock(&vc4->bo_lock);
+	vc4_bo_cache_stats_print(vc4, &p);
+	mutex_unlock(&vc4->bo_lock);
 }
 
 #ifdef CONFIG_DEBUG_FS
@@ -72,6 +113,7 @@ int vc4_bo_stats_debugfs(struct seq_file *m, void *unused)
 	struct drm_info_node *node = (struct drm_info_node *)m->private;
 	struct drm_device *dev = node->minor->dev;
 	struct vc4_dev *vc4 = to_vc4_dev(dev);
+	struct drm_printer p = drm_seq_file_printer(m);
 	int i;
 
 	mutex_lock(&vc4->bo_lock);
@@ -84,6 +126,7 @@ int vc4_bo_stats_debugfs(struct seq_file *m, void *unused)
 			   vc4->bo_labels[i].size_allocated / 1024,
 			   vc4->bo_labels[i].num_allocated);
 	}
+	vc4_bo_cache_stats_print(vc4, &p);
 	mutex_unlock(&vc4->bo_lock);
 
 	mutex_lock(&vc4->purgeable.lock);
@@ -213,6 +256,7 @@ static void vc4_bo_remove_from_cache(struct vc4_bo *bo)
 	lockdep_assert_held(&vc4->bo_lock);
 	list_del(&bo->unref_head);
 	list_del(&bo->size_head);
+	vc4->bo_cache.num_pages -= bo->base.base.size >> PAGE_SHIFT;
 }
 
 static struct list_head *vc4_get_cache_list_for_size(struct drm_device *dev,
@@ -264,6 +308,8 @@ static void vc4_bo_cache_purge(struct drm_device *dev)
 	while (!list_empty(&vc4->bo_cache.time_list)) {
 		struct vc4_bo *bo = list_last_entry(&vc4->bo_cache.time_list,
 						    struct vc4_bo, unref_head);
+		vc4->bo_cache.stats[vc4_bo_size_class(bo->base.base.size)]
+			.reclaimed++;
 		vc4_bo_remove_from_cache(bo);
 		vc4_bo_destroy(bo);
 	}
@@ -396,8 +442,12 @@ static struct vc4_bo *vc4_bo_get_from_cache(struct drm_device *dev,
 	kref_init(&bo->base.base.refcount);
 
 out:
-	if (bo)
+	if (bo) {
+		vc4->bo_cache.stats[vc4_bo_size_class(size)].hits++;
 		vc4_bo_set_label(&bo->base.base, type);
+	} else {
+		vc4->bo_cache.stats[vc4_bo_size_class(size)].misses++;
+	}
 	mutex_unlock(&vc4->bo_lock);
 	return bo;
 }
@@ -527,25 +577,75 @@ int vc4_dumb_create(struct drm_file *file_priv,
 static void vc4_bo_cache_free_old(struct drm_device *dev)
 {
 	struct vc4_dev *vc4 = to_vc4_dev(dev);
-	unsigned long expire_time = jiffies - msecs_to_jiffies(1000);
+	u32 expire_ms = READ_ONCE(vc4->bo_cache.expire_ms);
+	unsigned long expire_time = jiffies - msecs_to_jiffies(expire_ms);
 
 	lockdep_assert_held(&vc4->bo_lock);
 
+	/* Left to the shrinker and CMA allocation failures. */
+	if (!expire_ms)
+		return;
+
 	while (!list_empty(&vc4->bo_cache.time_list)) {
 		struct vc4_bo *bo = list_last_entry(&vc4->bo_cache.time_list,
 						    struct vc4_bo, unref_head);
 		if (time_before(expire_time, bo->free_time)) {
+			unsigned long next = jiffies +
+					     msecs_to_jiffies(expire_ms);
+
 			mod_timer(&vc4->bo_cache.time_timer,
-				  round_jiffies_up(jiffies +
-						   msecs_to_jiffies(1000)));
+				  round_jiffies_up(next));
 			return;
 		}
 
+		vc4->bo_cache.stats[vc4_bo_size_class(bo->base.base.size)]
+			.expired++;
 		vc4_bo_remove_from_cache(bo);
 		vc4_bo_destroy(bo);
 	}
 }
 
+static unsigned long
+vc4_bo_cache_shrinker_count(struct shrinker *shrinker,
+			    struct shrink_control *sc)
+{
+	struct vc4_dev *vc4 = container_of(shrinker, struct vc4_dev,
+					   bo_cache.shrinker);
+
+	return READ_ONCE(vc4->bo_cache.num_pages);
+}
+
+/* Frees the least recently used cached BOs when the system is short of
+ * memory, since CMA pages held by the cache can't be used for anything
+ * else.
+ */
+static unsigned long
+vc4_bo_cache_shrinker_scan(struct shrinker *shrinker,
+			   struct shrink_control *sc)
+{
+	struct vc4_dev *vc4 = container_of(shrinker, struct vc4_dev,
+					   bo_cache.shrinker);
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&vc4->bo_lock))
+		return SHRINK_STOP;
+
+	while (freed < sc->nr_to_scan &&
+	       !list_empty(&vc4->bo_cache.time_list)) {
+		struct vc4_bo *bo = list_last_entry(&vc4->bo_cache.time_list,
+						    struct vc4_bo, unref_head);
+
+		freed += bo->base.base.size >> PAGE_SHIFT;
+		vc4->bo_cache.stats[vc4_bo_size_class(bo->base.base.size)]
+			.reclaimed++;
+		vc4_bo_remove_from_cache(bo);
+		vc4_bo_destroy(bo);
+	}
+	mutex_unlock(&vc4->bo_lock);
+
+	return freed;
+}
+
 /* Called on the last userspace/kernel unreference of the BO.  Returns
  * it to the BO cache if possible, otherwise frees it.
  */
@@ -606,6 +706,7 @@ void vc4_free_object(struct drm_gem_object *gem_bo)
 	bo->free_time = jiffies;
 	list_add(&bo->size_head, cache_list);
 	list_add(&bo->unref_head, &vc4->bo_cache.time_list);
+	vc4->bo_cache.num_pages += gem_bo->size >> PAGE_SHIFT;
 
 	vc4_bo_set_label(&bo->base.base, VC4_BO_TYPE_KERNEL_CACHE);
 
@@ -1020,7 +1121,7 @@ int vc4_get_tiling_ioctl(struct drm_device *dev, void *data,
 int vc4_bo_cache_init(struct drm_device *dev)
 {
 	struct vc4_dev *vc4 = to_vc4_dev(dev);
-	int i;
+	int i, ret;
 
 	/* Create the initial set of BO labels that the kernel will
 	 * use.  This lets us avoid a bunch of string reallocation in
@@ -1042,6 +1143,16 @@ int vc4_bo_cache_init(struct drm_device *dev)
 
 	INIT_WORK(&vc4->bo_cache.time_work, vc4_bo_cache_time_work);
 	timer_setup(&vc4->bo_cache.time_timer, vc4_bo_cache_time_timer, 0);
+	vc4->bo_cache.expire_ms = 1000;
+
+	vc4->bo_cache.shrinker.count_objects = vc4_bo_cache_shrinker_count;
+	vc4->bo_cache.shrinker.scan_objects = vc4_bo_cache_shrinker_scan;
+	vc4->bo_cache.shrinker.seeks = DEFAULT_SEEKS;
+	ret = register_shrinker(&vc4->bo_cache.shrinker);
+	if (ret) {
+		kfree(vc4->bo_labels);
+		return ret;
+	}
 
 	return 0;
 }
@@ -1051,6 +1162,7 @@ void vc4_bo_cache_destroy(struct drm_device *dev)
 	struct vc4_dev *vc4 = to_vc4_dev(dev);
 	int i;
 
+	unregister_shrinker(&vc4->bo_cache.shrinker);
 	del_timer(&vc4->bo_cache.time_timer);
 	cancel_work_sync(&vc4->bo_cache.time_work);
 
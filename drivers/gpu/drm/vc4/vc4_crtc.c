@@ -67,6 +67,9 @@ to_vc4_crtc_state(struct drm_crtc_state *crtc_state)
 #define CRTC_READ(offset) readl(vc4_crtc->regs + (offset))
 
 #define CRTC_REG(reg) { reg, #reg }
+
+/* Dlist allocations are rounded up to a multiple of this many dwords. */
+#define VC4_DLIST_GRANULE 16
 static const struct {
 	u32 reg;
 	const char *name;
@@ -686,6 +689,14 @@ static int vc4_crtc_atomic_check(struct drm_crtc *crtc,
 
 	dlist_count++; /* Account for SCALER_CTL0_END. */
 
+	/* Each commit allocates the new dlist while the hardware is still
+	 * scanning out of the old one. Rounding the sizes to a few classes
+	 * lets the best-fit allocator reuse the holes left by earlier
+	 * commits instead of fragmenting the dlist memory as planes come
+	 * and go.
+	 */
+	dlist_count = roundup(dlist_count, VC4_DLIST_GRANULE);
+
 	spin_lock_irqsave(&vc4->hvs->mm_lock, flags);
 	ret = drm_mm_insert_node(&vc4->hvs->dlist_mm, &vc4_state->mm,
 				 dlist_count);
@@ -759,7 +770,7 @@ static void vc4_crtc_atomic_flush(struct drm_crtc *crtc,
 	writel(SCALER_CTL0_END, dlist_next);
 	dlist_next++;
 
-	WARN_ON_ONCE(dlist_next - dlist_start != vc4_state->mm.size);
+	WARN_ON_ONCE(dlist_next - dlist_start > vc4_state->mm.size);
 
 	if (enable_bg_fill)
 		/* This sets a black background color fill, as is the case
@@ -333,12 +333,18 @@ static void vc4_drm_unbind(struct device *dev)
 	struct drm_device *drm = dev_get_drvdata(dev);
 	struct vc4_dev *vc4 = to_vc4_dev(drm);
 
+	/* The relay files live in debugfs, so close them before
+	 * unregistering tears down the debugfs directory.
+	 */
+	vc4_perfmon_sampler_fini(vc4);
+
 	drm_dev_unregister(drm);
 
 	drm_fb_cma_fbdev_fini(drm);
 
 	drm_mode_config_cleanup(drm);
 
+	drm_atomic_private_obj_fini(&vc4->load_tracker);
 	drm_atomic_private_obj_fini(&vc4->ctm_manager);
 
 	drm_dev_put(drm);
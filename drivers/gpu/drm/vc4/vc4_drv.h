@@ -6,6 +6,7 @@
  * published by the Free Software Foundation.
  */
 
+#include <linux/hrtimer.h>
 #include <linux/mm_types.h>
 #include <linux/reservation.h>
 #include <drm/drmP.h>
@@ -81,6 +82,7 @@ struct vc4_dev {
 
 	struct vc4_hang_state *hang_state;
 
+#define VC4_BO_CACHE_SIZE_CLASSES	12
 	/* The kernel-space BO cache.  Tracks buffers that have been
 	 * unreferenced by all other users (refcounts of 0!) but not
 	 * yet freed, so we can do cheap allocations.
@@ -100,6 +102,22 @@ struct vc4_dev {
 		struct list_head time_list;
 		struct work_struct time_work;
 		struct timer_list time_timer;
+
+		/* Age after which a cached BO is freed, or 0 to only free
+		 * them under memory pressure.  Tunable through debugfs.
+		 */
+		u32 expire_ms;
+		/* Pages held by the cache, reported to the shrinker. */
+		unsigned long num_pages;
+		struct shrinker shrinker;
+
+		/* Per size class (log2 of the number of pages) counters. */
+		struct vc4_bo_cache_stats {
+			u32 hits;
+			u32 misses;
+			u32 expired;
+			u32 reclaimed;
+		} stats[VC4_BO_CACHE_SIZE_CLASSES];
 	} bo_cache;
 
 	u32 num_labels;
@@ -166,6 +184,26 @@ struct vc4_dev {
 	 */
 	struct vc4_perfmon *active_perfmon;
 
+	/* System-wide sampling of the perf counters, controlled through
+	 * debugfs. See vc4_perfmon.c.
+	 */
+	struct {
+		/* Protects the configuration and enabling/disabling. */
+		struct mutex lock;
+		struct hrtimer timer;
+		struct rchan *chan;
+
+		/* Set while the sampler owns the HW perf counters. Changed
+		 * under job_lock, so that it can't race with a job's perfmon
+		 * being started.
+		 */
+		bool active;
+
+		u32 period_us;
+		u8 ncounters;
+		u8 events[DRM_VC4_MAX_PERF_COUNTERS];
+	} perfmon_sampler;
+
 	/* List of struct vc4_seqno_cb for callbacks to be made from a
 	 * workqueue when the given seqno is passed.
 	 */
@@ -204,6 +242,14 @@ struct vc4_dev {
 
 	struct drm_modeset_lock ctm_state_lock;
 	struct drm_private_obj ctm_manager;
+
+	/* Sum of the HVS and memory bus load of all the active planes,
+	 * checked against what the hardware can sustain at atomic_check
+	 * time unless load_tracker_enabled is cleared from debugfs.
+	 */
+	struct drm_modeset_lock load_tracker_lock;
+	struct drm_private_obj load_tracker;
+	bool load_tracker_enabled;
 };
 
 static inline struct vc4_dev *
@@ -373,6 +419,12 @@ struct vc4_plane_state {
 	 * to enable background color fill.
 	 */
 	bool needs_bg_fill;
+
+	/* Load of this plane on the HVS block, in HVS clock cycles per
+	 * second, and on the memory bus, in bytes per second.
+	 */
+	u64 hvs_load;
+	u64 membus_load;
 };
 
 static inline struct vc4_plane_state *
@@ -776,6 +828,7 @@ int vc4_hvs_debugfs_regs(struct seq_file *m, void *unused);
 
 /* vc4_kms.c */
 int vc4_kms_load(struct drm_device *dev);
+int vc4_load_tracker_debugfs(struct seq_file *m, void *unused);
 
 /* vc4_plane.c */
 struct drm_plane *vc4_plane_init(struct drm_device *dev,
@@ -831,3 +884,9 @@ int vc4_perfmon_destroy_ioctl(struct drm_device *dev, void *data,
 			      struct drm_file *file_priv);
 int vc4_perfmon_get_values_ioctl(struct drm_device *dev, void *data,
 				 struct drm_file *file_priv);
+#ifdef CONFIG_DEBUG_FS
+int vc4_perfmon_sampler_debugfs_init(struct drm_minor *minor);
+void vc4_perfmon_sampler_fini(struct vc4_dev *vc4);
+#else
+static inline void vc4_perfmon_sampler_fini(struct vc4_dev *vc4) {}
+#endif
@@ -24,6 +24,9 @@
 #include "drm/drm_fb_cma_helper.h"
 #include "linux/component.h"
 #include "linux/of_device.h"
+#include "linux/dma-buf.h"
+#include "linux/dma-fence.h"
+#include "linux/reservation.h"
 #include "vc4_drv.h"
 #include "vc4_regs.h"
 #include "vc_image_types.h"
@@ -35,6 +38,15 @@ struct get_display_cfg {
 
 struct vc4_fkms {
 	struct get_display_cfg cfg;
+
+	/* SET_PLANE tags queued up by the plane and CRTC hooks during a
+	 * commit, sent to the firmware as one property list by
+	 * vc4_fkms_flush_planes(). Commits are serialised by
+	 * vc4->async_modeset, so this needs no locking of its own.
+	 */
+	struct mailbox_set_plane *pending_planes;
+	unsigned int num_pending_planes;
+	unsigned int max_pending_planes;
 };
 
 #define PLANES_PER_CRTC		3
@@ -369,9 +381,9 @@ static inline struct vc4_fkms_plane *to_vc4_fkms_plane(struct drm_plane *plane)
 	return (struct vc4_fkms_plane *)plane;
 }
 
-static int vc4_plane_set_blank(struct drm_plane *plane, bool blank)
+static void vc4_plane_get_mb(struct drm_plane *plane, bool blank,
+			     struct mailbox_set_plane *mb)
 {
-	struct vc4_dev *vc4 = to_vc4_dev(plane->dev);
 	struct vc4_fkms_plane *vc4_plane = to_vc4_fkms_plane(plane);
 	struct mailbox_set_plane blank_mb = {
 		.tag = { RPI_FIRMWARE_SET_PLANE, sizeof(struct set_plane), 0 },
@@ -385,24 +397,75 @@ static int vc4_plane_set_blank(struct drm_plane *plane, bool blank)
 							"primary",
 							"cursor"
 						  };
-	int ret;
 
 	DRM_DEBUG_ATOMIC("[PLANE:%d:%s] %s plane %s",
 			 plane->base.id, plane->name, plane_types[plane->type],
 			 blank ? "blank" : "unblank");
 
-	if (blank)
-		ret = rpi_firmware_property_list(vc4->firmware, &blank_mb,
-						 sizeof(blank_mb));
-	else
-		ret = rpi_firmware_property_list(vc4->firmware, &vc4_plane->mb,
-						 sizeof(vc4_plane->mb));
+	*mb = blank ? blank_mb : vc4_plane->mb;
+}
+
+static int vc4_plane_set_blank(struct drm_plane *plane, bool blank)
+{
+	struct vc4_dev *vc4 = to_vc4_dev(plane->dev);
+	struct mailbox_set_plane mb;
+	int ret;
+
+	vc4_plane_get_mb(plane, blank, &mb);
+
+	ret = rpi_firmware_property_list(vc4->firmware, &mb, sizeof(mb));
 
 	WARN_ONCE(ret, "%s: firmware call failed. Please update your firmware",
 		  __func__);
 	return ret;
 }
 
+/* Like vc4_plane_set_blank(), but only queues the update until the next
+ * vc4_fkms_flush_planes(), so that a commit touching several planes costs
+ * a single firmware round-trip.
+ */
+static void vc4_plane_queue_blank(struct drm_plane *plane, bool blank)
+{
+	struct vc4_fkms *fkms = to_vc4_dev(plane->dev)->fkms;
+	struct vc4_fkms_plane *vc4_plane = to_vc4_fkms_plane(plane);
+	struct set_plane *pending;
+	unsigned int i;
+
+	/* Only the latest update of a plane needs to be sent. */
+	for (i = 0; i < fkms->num_pending_planes; i++) {
+		pending = &fkms->pending_planes[i].plane;
+		if (pending->display == vc4_plane->mb.plane.display &&
+		    pending->plane_id == vc4_plane->mb.plane.plane_id)
+			break;
+	}
+
+	if (WARN_ON_ONCE(i == fkms->max_pending_planes)) {
+		vc4_plane_set_blank(plane, blank);
+		return;
+	}
+
+	vc4_plane_get_mb(plane, blank, &fkms->pending_planes[i]);
+	if (i == fkms->num_pending_planes)
+		fkms->num_pending_planes++;
+}
+
+static void vc4_fkms_flush_planes(struct vc4_dev *vc4)
+{
+	struct vc4_fkms *fkms = vc4->fkms;
+	int ret;
+
+	if (!fkms->num_pending_planes)
+		return;
+
+	ret = rpi_firmware_property_list(vc4->firmware, fkms->pending_planes,
+					 fkms->num_pending_planes *
+					 sizeof(*fkms->pending_planes));
+	fkms->num_pending_planes = 0;
+
+	WARN_ONCE(ret, "%s: firmware call failed. Please update your firmware",
+		  __func__);
+}
+
 static void vc4_fkms_crtc_get_margins(struct drm_crtc_state *state,
 				      unsigned int *left, unsigned int *right,
 				      unsigned int *top, unsigned int *bottom)
@@ -491,7 +554,7 @@ static void vc4_plane_atomic_update(struct drm_plane *plane,
 	 * then unblank.  Otherwise, stay blank until CRTC enable.
 	 */
 	if (state->crtc->state->active)
-		vc4_plane_set_blank(plane, false);
+		vc4_plane_queue_blank(plane, false);
 }
 
 static void vc4_plane_atomic_disable(struct drm_plane *plane,
@@ -507,7 +570,7 @@ static void vc4_plane_atomic_disable(struct drm_plane *plane,
 			 vc4_plane->mb.plane.vc_image_type,
 			 state->crtc_x,
 			 state->crtc_y);
-	vc4_plane_set_blank(plane, true);
+	vc4_plane_queue_blank(plane, true);
 }
 
 static bool plane_enabled(struct drm_plane_state *state)
@@ -946,6 +1009,7 @@ static void vc4_crtc_disable(struct drm_crtc *crtc, struct drm_crtc_state *old_s
 
 	drm_atomic_crtc_for_each_plane(plane, crtc)
 		vc4_plane_atomic_disable(plane, plane->state);
+	vc4_fkms_flush_planes(to_vc4_dev(dev));
 
 	/*
 	 * Make sure we issue a vblank event after disabling the CRTC if
@@ -992,7 +1056,8 @@ static void vc4_crtc_enable(struct drm_crtc *crtc, struct drm_crtc_state *old_st
 	/* Unblank the planes (if they're supposed to be displayed). */
 	drm_atomic_crtc_for_each_plane(plane, crtc)
 		if (plane->state->fb)
-			vc4_plane_set_blank(plane, plane->state->visible);
+			vc4_plane_queue_blank(plane, plane->state->visible);
+	vc4_fkms_flush_planes(to_vc4_dev(crtc->dev));
 }
 
 static enum drm_mode_status
@@ -1061,6 +1126,12 @@ static void vc4_crtc_atomic_flush(struct drm_crtc *crtc,
 {
 	DRM_DEBUG_KMS("[CRTC:%d] crtc_atomic_flush.\n",
 		      crtc->base.id);
+
+	/* The plane hooks for every CRTC in the commit have run by now, so
+	 * this sends all of their updates at once.
+	 */
+	vc4_fkms_flush_planes(to_vc4_dev(crtc->dev));
+
 	if (crtc->state->active && old_state->active && crtc->state->event)
 		vc4_crtc_consume_event(crtc);
 }
@@ -1130,15 +1201,150 @@ static irqreturn_t vc4_crtc_irq_handler(int irq, void *data)
 	return ret;
 }
 
+struct vc4_fkms_async_flip {
+	struct drm_crtc *crtc;
+	struct drm_framebuffer *fb;
+	struct drm_framebuffer *old_fb;
+	struct drm_pending_vblank_event *event;
+
+	struct dma_fence *fence;
+	struct dma_fence_cb cb;
+	struct work_struct work;
+};
+
+/* Runs once rendering to the new FB has finished. */
+static void vc4_fkms_async_flip_work(struct work_struct *work)
+{
+	struct vc4_fkms_async_flip *flip =
+		container_of(work, struct vc4_fkms_async_flip, work);
+	struct drm_crtc *crtc = flip->crtc;
+	struct drm_device *dev = crtc->dev;
+	struct vc4_dev *vc4 = to_vc4_dev(dev);
+	struct drm_plane *plane = crtc->primary;
+	struct vc4_fkms_plane *vc4_plane = to_vc4_fkms_plane(plane);
+	struct drm_gem_cma_object *bo = drm_fb_cma_get_gem_obj(flip->fb, 0);
+	struct drm_framebuffer *fb = flip->fb;
+	int i;
+
+	/* Only the buffer changes, everything else in the plane setup
+	 * computed at the last atomic_check still applies.
+	 */
+	vc4_plane->mb.plane.planes[0] = bo->paddr + fb->offsets[0];
+	for (i = 1; i < fb->format->num_planes; i++)
+		vc4_plane->mb.plane.planes[i] = bo->paddr + fb->offsets[i];
+
+	if (crtc->state->active)
+		vc4_plane_set_blank(plane, false);
+
+	/* The firmware shows the most recent buffer from the next frame
+	 * on, so complete the flip now rather than a vblank later.
+	 */
+	if (flip->event) {
+		unsigned long flags;
+
+		spin_lock_irqsave(&dev->event_lock, flags);
+		drm_crtc_send_vblank_event(crtc, flip->event);
+		spin_unlock_irqrestore(&dev->event_lock, flags);
+	}
+
+	drm_crtc_vblank_put(crtc);
+	drm_framebuffer_put(flip->fb);
+	if (flip->old_fb)
+		drm_framebuffer_put(flip->old_fb);
+	dma_fence_put(flip->fence);
+	kfree(flip);
+
+	up(&vc4->async_modeset);
+}
+
+static void vc4_fkms_async_flip_fence_cb(struct dma_fence *fence,
+					 struct dma_fence_cb *cb)
+{
+	struct vc4_fkms_async_flip *flip =
+		container_of(cb, struct vc4_fkms_async_flip, cb);
+
+	schedule_work(&flip->work);
+}
+
+/* Implements async page flips of the primary plane.
+ *
+ * The firmware latches plane updates at its next frame, so rather than
+ * having the flip wait for the vblank interrupt like an atomic commit, the
+ * event is sent as soon as the new buffer has been handed to the firmware.
+ * A client can then queue its next frame straight away, at the cost of
+ * the previous buffer possibly still being scanned out.
+ */
+static int vc4_fkms_async_page_flip(struct drm_crtc *crtc,
+				    struct drm_framebuffer *fb,
+				    struct drm_pending_vblank_event *event,
+				    uint32_t flags)
+{
+	struct drm_device *dev = crtc->dev;
+	struct vc4_dev *vc4 = to_vc4_dev(dev);
+	struct drm_plane *plane = crtc->primary;
+	struct drm_framebuffer *cur_fb = plane->state->fb;
+	struct drm_gem_object *obj = drm_gem_fb_get_obj(fb, 0);
+	struct vc4_fkms_async_flip *flip;
+	int ret;
+
+	if (!cur_fb || cur_fb->format != fb->format ||
+	    cur_fb->modifier != fb->modifier ||
+	    cur_fb->pitches[0] != fb->pitches[0]) {
+		DRM_DEBUG_KMS("Async flip can't change the FB layout\n");
+		return -EINVAL;
+	}
+
+	flip = kzalloc(sizeof(*flip), GFP_KERNEL);
+	if (!flip)
+		return -ENOMEM;
+
+	INIT_WORK(&flip->work, vc4_fkms_async_flip_work);
+	drm_framebuffer_get(fb);
+	flip->fb = fb;
+	flip->crtc = crtc;
+	flip->event = event;
+
+	/* Make sure all other async modesets have landed. */
+	ret = down_interruptible(&vc4->async_modeset);
+	if (ret) {
+		drm_framebuffer_put(fb);
+		kfree(flip);
+		return ret;
+	}
+
+	flip->old_fb = plane->state->fb;
+	drm_framebuffer_get(flip->old_fb);
+
+	WARN_ON(drm_crtc_vblank_get(crtc) != 0);
+
+	/* Immediately update the plane's legacy fb pointer, so that later
+	 * modeset prep sees the state that will be present when the semaphore
+	 * is released.
+	 */
+	drm_atomic_set_fb_for_plane(plane->state, fb);
+
+	/* Wait for rendering to an imported buffer, as prepare_fb would. */
+	if (obj->dma_buf) {
+		struct reservation_object *resv = obj->dma_buf->resv;
+
+		flip->fence = reservation_object_get_excl_rcu(resv);
+	}
+
+	if (!flip->fence ||
+	    dma_fence_add_callback(flip->fence, &flip->cb,
+				   vc4_fkms_async_flip_fence_cb))
+		schedule_work(&flip->work);
+
+	return 0;
+}
+
 static int vc4_page_flip(struct drm_crtc *crtc,
 			 struct drm_framebuffer *fb,
 			 struct drm_pending_vblank_event *event,
 			 uint32_t flags, struct drm_modeset_acquire_ctx *ctx)
 {
-	if (flags & DRM_MODE_PAGE_FLIP_ASYNC) {
-		DRM_ERROR("Async flips aren't allowed\n");
-		return -EINVAL;
-	}
+	if (flags & DRM_MODE_PAGE_FLIP_ASYNC)
+		return vc4_fkms_async_page_flip(crtc, fb, event, flags);
 
 	return drm_atomic_helper_page_flip(crtc, fb, event, flags, ctx);
 }
@@ -1807,6 +2013,13 @@ static int vc4_fkms_bind(struct device *dev, struct device *master, void *data)
 	fkms->cfg.max_pixel_clock[0] /= 1000;
 	fkms->cfg.max_pixel_clock[1] /= 1000;
 
+	fkms->max_pending_planes = num_displays * PLANES_PER_CRTC;
+	fkms->pending_planes = devm_kcalloc(dev, fkms->max_pending_planes,
+					    sizeof(*fkms->pending_planes),
+					    GFP_KERNEL);
+	if (!fkms->pending_planes)
+		return -ENOMEM;
+
 	/* Allocate a list, with space for a NULL on the end */
 	crtc_list = devm_kzalloc(dev, sizeof(crtc_list) * (num_displays + 1),
 				 GFP_KERNEL);
@@ -1173,6 +1173,12 @@ vc4_submit_cl_ioctl(struct drm_device *dev, void *data,
 		goto fail;
 
 	if (args->perfmonid) {
+		/* The counters are in use by the system-wide sampler. */
+		if (READ_ONCE(vc4->perfmon_sampler.active)) {
+			ret = -EBUSY;
+			goto fail;
+		}
+
 		exec->perfmon = vc4_perfmon_find(vc4file,
 						 args->perfmonid);
 		if (!exec->perfmon) {
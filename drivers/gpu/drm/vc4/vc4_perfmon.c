@@ -7,14 +7,30 @@
  * DOC: VC4 V3D performance monitor module
  *
  * The V3D block provides 16 hardware counters which can count various events.
+ *
+ * Besides the perfmons attached to jobs, the counters can be sampled
+ * system-wide from a timer through debugfs: write the event numbers to
+ * perfmon_sampler/events, the period to perfmon_sampler/period_us and 1 to
+ * perfmon_sampler/enable. Each period, a struct drm_vc4_perfmon_sample with
+ * the counts since the previous one is appended to the
+ * perfmon_sampler/samples<cpu> relay files, which can be read or mmapped.
+ * Jobs with a perfmon attached are rejected while sampling.
  */
 
+#include <linux/debugfs.h>
+#include <linux/pm_runtime.h>
+#include <linux/relay.h>
+
 #include "vc4_drv.h"
 #include "vc4_regs.h"
 
 #define VC4_PERFMONID_MIN	1
 #define VC4_PERFMONID_MAX	U32_MAX
 
+#define VC4_PERFMON_SAMPLER_MIN_PERIOD_US	100
+#define VC4_PERFMON_SAMPLER_SUBBUF_SIZE		(64 * 1024)
+#define VC4_PERFMON_SAMPLER_N_SUBBUFS		8
+
 void vc4_perfmon_get(struct vc4_perfmon *perfmon)
 {
 	if (perfmon)
@@ -35,6 +51,14 @@ void vc4_perfmon_start(struct vc4_dev *vc4, struct vc4_perfmon *perfmon)
 	if (WARN_ON_ONCE(!perfmon || vc4->active_perfmon))
 		return;
 
+	/* Only jobs queued before the sampler was enabled get here, leave
+	 * the counters alone and just track the perfmon.
+	 */
+	if (vc4->perfmon_sampler.active) {
+		vc4->active_perfmon = perfmon;
+		return;
+	}
+
 	for (i = 0; i < perfmon->ncounters; i++)
 		V3D_WRITE(V3D_PCTRS(i), perfmon->events[i]);
 
@@ -53,6 +77,11 @@ void vc4_perfmon_stop(struct vc4_dev *vc4, struct vc4_perfmon *perfmon,
 			 perfmon != vc4->active_perfmon))
 		return;
 
+	if (vc4->perfmon_sampler.active) {
+		vc4->active_perfmon = NULL;
+		return;
+	}
+
 	if (capture) {
 		for (i = 0; i < perfmon->ncounters; i++)
 			perfmon->counters[i] += V3D_READ(V3D_PCTR(i));
@@ -204,3 +233,308 @@ int vc4_perfmon_get_values_ioctl(struct drm_device *dev, void *data,
 	vc4_perfmon_put(perfmon);
 	return ret;
 }
+
+#ifdef CONFIG_DEBUG_FS
+/* period_us can be changed from debugfs while the timer is running. */
+static ktime_t vc4_perfmon_sampler_period(struct vc4_dev *vc4)
+{
+	return us_to_ktime(max_t(u32, READ_ONCE(vc4->perfmon_sampler.period_us),
+				 VC4_PERFMON_SAMPLER_MIN_PERIOD_US));
+}
+
+static enum hrtimer_restart vc4_perfmon_sampler_timer(struct hrtimer *timer)
+{
+	struct vc4_dev *vc4 = container_of(timer, struct vc4_dev,
+					   perfmon_sampler.timer);
+	struct drm_vc4_perfmon_sample sample = { };
+	unsigned int i, n = vc4->perfmon_sampler.ncounters;
+
+	sample.timestamp_ns = ktime_get_ns();
+	sample.emit_seqno = vc4->emit_seqno;
+	sample.finished_seqno = vc4->finished_seqno;
+	sample.ncounters = n;
+	for (i = 0; i < n; i++)
+		sample.counters[i] = V3D_READ(V3D_PCTR(i));
+	V3D_WRITE(V3D_PCTRC, GENMASK(n - 1, 0));
+
+	relay_write(vc4->perfmon_sampler.chan, &sample, sizeof(sample));
+
+	hrtimer_forward_now(timer, vc4_perfmon_sampler_period(vc4));
+	return HRTIMER_RESTART;
+}
+
+static int vc4_perfmon_sampler_enable(struct vc4_dev *vc4)
+{
+	struct device *v3d_dev = &vc4->v3d->pdev->dev;
+	unsigned long irqflags;
+	unsigned int i;
+	u32 mask;
+	int ret = 0;
+
+	if (!vc4->perfmon_sampler.ncounters)
+		return -EINVAL;
+
+	/* Keep V3D powered up while we're reading its registers. */
+	mutex_lock(&vc4->power_lock);
+	if (vc4->power_refcount++ == 0) {
+		ret = pm_runtime_get_sync(v3d_dev);
+		if (ret < 0) {
+			vc4->power_refcount--;
+			mutex_unlock(&vc4->power_lock);
+			return ret;
+		}
+	}
+	mutex_unlock(&vc4->power_lock);
+
+	spin_lock_irqsave(&vc4->job_lock, irqflags);
+	if (vc4->active_perfmon) {
+		ret = -EBUSY;
+	} else {
+		for (i = 0; i < vc4->perfmon_sampler.ncounters; i++)
+			V3D_WRITE(V3D_PCTRS(i), vc4->perfmon_sampler.events[i]);
+
+		mask = GENMASK(vc4->perfmon_sampler.ncounters - 1, 0);
+		V3D_WRITE(V3D_PCTRC, mask);
+		V3D_WRITE(V3D_PCTRE, V3D_PCTRE_EN | mask);
+		vc4->perfmon_sampler.active = true;
+	}
+	spin_unlock_irqrestore(&vc4->job_lock, irqflags);
+
+	if (ret) {
+		mutex_lock(&vc4->power_lock);
+		if (--vc4->power_refcount == 0) {
+			pm_runtime_mark_last_busy(v3d_dev);
+			pm_runtime_put_autosuspend(v3d_dev);
+		}
+		mutex_unlock(&vc4->power_lock);
+		return ret;
+	}
+
+	relay_reset(vc4->perfmon_sampler.chan);
+	hrtimer_start(&vc4->perfmon_sampler.timer,
+		      vc4_perfmon_sampler_period(vc4), HRTIMER_MODE_REL);
+
+	return 0;
+}
+
+static void vc4_perfmon_sampler_disable(struct vc4_dev *vc4)
+{
+	struct device *v3d_dev = &vc4->v3d->pdev->dev;
+	unsigned long irqflags;
+
+	hrtimer_cancel(&vc4->perfmon_sampler.timer);
+
+	spin_lock_irqsave(&vc4->job_lock, irqflags);
+	vc4->perfmon_sampler.active = false;
+	V3D_WRITE(V3D_PCTRE, 0);
+	spin_unlock_irqrestore(&vc4->job_lock, irqflags);
+
+	relay_flush(vc4->perfmon_sampler.chan);
+
+	mutex_lock(&vc4->power_lock);
+	if (--vc4->power_refcount == 0) {
+		pm_runtime_mark_last_busy(v3d_dev);
+		pm_runtime_put_autosuspend(v3d_dev);
+	}
+	mutex_unlock(&vc4->power_lock);
+}
+
+static ssize_t vc4_perfmon_sampler_enable_read(struct file *file,
+					       char __user *buf,
+					       size_t count, loff_t *ppos)
+{
+	struct vc4_dev *vc4 = file->private_data;
+	char val[2] = { vc4->perfmon_sampler.active ? '1' : '0', '\n' };
+
+	return simple_read_from_buffer(buf, count, ppos, val, sizeof(val));
+}
+
+static ssize_t vc4_perfmon_sampler_enable_write(struct file *file,
+						const char __user *buf,
+						size_t count, loff_t *ppos)
+{
+	struct vc4_dev *vc4 = file->private_data;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(buf, count, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&vc4->perfmon_sampler.lock);
+	if (enable && !vc4->perfmon_sampler.active)
+		ret = vc4_perfmon_sampler_enable(vc4);
+	else if (!enable && vc4->perfmon_sampler.active)
+		vc4_perfmon_sampler_disable(vc4);
+	mutex_unlock(&vc4->perfmon_sampler.lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations vc4_perfmon_sampler_enable_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = vc4_perfmon_sampler_enable_read,
+	.write = vc4_perfmon_sampler_enable_write,
+	.llseek = default_llseek,
+};
+
+static int vc4_perfmon_sampler_events_show(struct seq_file *m, void *unused)
+{
+	struct vc4_dev *vc4 = m->private;
+	unsigned int i;
+
+	mutex_lock(&vc4->perfmon_sampler.lock);
+	for (i = 0; i < vc4->perfmon_sampler.ncounters; i++)
+		seq_printf(m, "%s%u", i ? " " : "",
+			   vc4->perfmon_sampler.events[i]);
+	mutex_unlock(&vc4->perfmon_sampler.lock);
+	seq_puts(m, "\n");
+
+	return 0;
+}
+
+static int vc4_perfmon_sampler_events_open(struct inode *inode,
+					   struct file *file)
+{
+	return single_open(file, vc4_perfmon_sampler_events_show,
+			   inode->i_private);
+}
+
+/* Takes a space-separated list of up to DRM_VC4_MAX_PERF_COUNTERS event
+ * numbers from enum drm_vc4_perfcnt_events.
+ */
+static ssize_t vc4_perfmon_sampler_events_write(struct file *file,
+						const char __user *ubuf,
+						size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct vc4_dev *vc4 = m->private;
+	u8 events[DRM_VC4_MAX_PERF_COUNTERS];
+	unsigned int n = 0, event;
+	char *buf, *cur, *tok;
+	int ret = 0;
+
+	buf = memdup_user_nul(ubuf, count);
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+
+	cur = buf;
+	while ((tok = strsep(&cur, " \t\n"))) {
+		if (!*tok)
+			continue;
+
+		if (n == DRM_VC4_MAX_PERF_COUNTERS) {
+			ret = -E2BIG;
+			break;
+		}
+
+		ret = kstrtouint(tok, 0, &event);
+		if (ret)
+			break;
+
+		if (event >= VC4_PERFCNT_NUM_EVENTS) {
+			ret = -EINVAL;
+			break;
+		}
+
+		events[n++] = event;
+	}
+	kfree(buf);
+
+	if (ret)
+		return ret;
+
+	mutex_lock(&vc4->perfmon_sampler.lock);
+	if (vc4->perfmon_sampler.active) {
+		ret = -EBUSY;
+	} else {
+		memcpy(vc4->perfmon_sampler.events, events, n);
+		vc4->perfmon_sampler.ncounters = n;
+	}
+	mutex_unlock(&vc4->perfmon_sampler.lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations vc4_perfmon_sampler_events_fops = {
+	.owner = THIS_MODULE,
+	.open = vc4_perfmon_sampler_events_open,
+	.read = seq_read,
+	.write = vc4_perfmon_sampler_events_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct dentry *
+vc4_perfmon_sampler_create_buf_file(const char *filename,
+				    struct dentry *parent, umode_t mode,
+				    struct rchan_buf *buf, int *is_global)
+{
+	return debugfs_create_file(filename, mode, parent, buf,
+				   &relay_file_operations);
+}
+
+static int vc4_perfmon_sampler_remove_buf_file(struct dentry *dentry)
+{
+	debugfs_remove(dentry);
+	return 0;
+}
+
+static struct rchan_callbacks vc4_perfmon_sampler_relay_cb = {
+	.create_buf_file = vc4_perfmon_sampler_create_buf_file,
+	.remove_buf_file = vc4_perfmon_sampler_remove_buf_file,
+};
+
+int vc4_perfmon_sampler_debugfs_init(struct drm_minor *minor)
+{
+	struct vc4_dev *vc4 = to_vc4_dev(minor->dev);
+	struct dentry *dir;
+
+	/* Only create it once, for the primary node. */
+	if (!vc4->v3d || vc4->perfmon_sampler.chan)
+		return 0;
+
+	mutex_init(&vc4->perfmon_sampler.lock);
+	hrtimer_init(&vc4->perfmon_sampler.timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	vc4->perfmon_sampler.timer.function = vc4_perfmon_sampler_timer;
+	vc4->perfmon_sampler.period_us = 1000;
+
+	dir = debugfs_create_dir("perfmon_sampler", minor->debugfs_root);
+	if (IS_ERR_OR_NULL(dir))
+		return -ENOMEM;
+
+	vc4->perfmon_sampler.chan =
+		relay_open("samples", dir, VC4_PERFMON_SAMPLER_SUBBUF_SIZE,
+			   VC4_PERFMON_SAMPLER_N_SUBBUFS,
+			   &vc4_perfmon_sampler_relay_cb, NULL);
+	if (!vc4->perfmon_sampler.chan) {
+		debugfs_remove_recursive(dir);
+		return -ENOMEM;
+	}
+
+	debugfs_create_file("enable", 0644, dir, vc4,
+			    &vc4_perfmon_sampler_enable_fops);
+	debugfs_create_file("events", 0644, dir, vc4,
+			    &vc4_perfmon_sampler_events_fops);
+	debugfs_create_u32("period_us", 0644, dir,
+			   &vc4->perfmon_sampler.period_us);
+
+	return 0;
+}
+
+void vc4_perfmon_sampler_fini(struct vc4_dev *vc4)
+{
+	if (!vc4->perfmon_sampler.chan)
+		return;
+
+	mutex_lock(&vc4->perfmon_sampler.lock);
+	if (vc4->perfmon_sampler.active)
+		vc4_perfmon_sampler_disable(vc4);
+	mutex_unlock(&vc4->perfmon_sampler.lock);
+
+	relay_close(vc4->perfmon_sampler.chan);
+	vc4->perfmon_sampler.chan = NULL;
+}
+#endif
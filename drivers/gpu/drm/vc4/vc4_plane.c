@@ -547,6 +547,56 @@ static const u32 colorspace_coeffs[2][DRM_COLOR_ENCODING_MAX][3] = {
 	}
 };
 
+static void vc4_plane_calc_load(struct drm_plane_state *state)
+{
+	struct vc4_plane_state *vc4_state = to_vc4_plane_state(state);
+	struct drm_framebuffer *fb = state->fb;
+	struct drm_crtc_state *crtc_state;
+	unsigned int hvs_load_shift, vrefresh, vscale_factor, i;
+
+	crtc_state = drm_atomic_get_existing_crtc_state(state->state,
+							state->crtc);
+	vrefresh = drm_mode_vrefresh(&crtc_state->adjusted_mode);
+
+	/* The HVS processes 2 pixels/cycle when scaling the source and 4
+	 * pixels/cycle otherwise. Blending always runs at 4 pixels/cycle, so
+	 * the scaler is the limiting step.
+	 */
+	if (vc4_state->x_scaling[0] != VC4_SCALING_NONE ||
+	    vc4_state->x_scaling[1] != VC4_SCALING_NONE ||
+	    vc4_state->y_scaling[0] != VC4_SCALING_NONE ||
+	    vc4_state->y_scaling[1] != VC4_SCALING_NONE)
+		hvs_load_shift = 1;
+	else
+		hvs_load_shift = 2;
+
+	vc4_state->membus_load = 0;
+	vc4_state->hvs_load = 0;
+	for (i = 0; i < fb->format->num_planes; i++) {
+		/* src_w/src_h only have luma and chroma entries, the two
+		 * chroma planes of 3-plane formats share the second one.
+		 */
+		unsigned int src = i ? 1 : 0;
+
+		/* When downscaling vertically more source lines have to be
+		 * fetched in the time of one output line, so the demand
+		 * peaks above the per-frame average. Account for it with the
+		 * downscale factor, which over-estimates rather than risk an
+		 * underflow.
+		 */
+		vscale_factor = DIV_ROUND_UP(vc4_state->src_h[src],
+					     vc4_state->crtc_h);
+		vc4_state->membus_load += (u64)vc4_state->src_w[src] *
+					  vc4_state->src_h[src] *
+					  vscale_factor * fb->format->cpp[i];
+		vc4_state->hvs_load += vc4_state->crtc_h * vc4_state->crtc_w;
+	}
+
+	vc4_state->hvs_load *= vrefresh;
+	vc4_state->hvs_load >>= hvs_load_shift;
+	vc4_state->membus_load *= vrefresh;
+}
+
 /* Writes out a full display list for an active plane to the plane's
  * private dlist state.
  */
@@ -928,6 +978,8 @@ static int vc4_plane_mode_set(struct drm_plane *plane,
 	vc4_state->needs_bg_fill = fb->format->has_alpha || !covers_screen ||
 				   state->alpha != DRM_BLEND_ALPHA_OPAQUE;
 
+	vc4_plane_calc_load(state);
+
 	return 0;
 }
 
@@ -230,6 +230,8 @@ static const u32 drm_fmts[] = {
 	DRM_FORMAT_BGRX8888,
 	DRM_FORMAT_RGBA8888,
 	DRM_FORMAT_BGRA8888,
+	DRM_FORMAT_RGB565,
+	DRM_FORMAT_BGR565,
 };
 
 static const u32 txp_fmts[] = {
@@ -243,6 +245,8 @@ static const u32 txp_fmts[] = {
 	TXP_FORMAT_BGRA8888,
 	TXP_FORMAT_RGBA8888,
 	TXP_FORMAT_BGRA8888,
+	TXP_FORMAT_RGB565,
+	TXP_FORMAT_BGR565,
 };
 
 static int vc4_txp_connector_atomic_check(struct drm_connector *conn,
@@ -281,6 +285,18 @@ static int vc4_txp_connector_atomic_check(struct drm_connector *conn,
 	if (fb->pitches[0] & GENMASK(3, 0))
 		return -EINVAL;
 
+	/* The TXP writes the whole frame, so make sure it fits in the BO.
+	 * Writeback buffers are commonly imported dma-bufs cycled between
+	 * KMS and an encoder, which may have been allocated for a smaller
+	 * format.
+	 */
+	if (fb->offsets[0] + (u64)fb->pitches[0] * fb->height >
+	    gem->base.size) {
+		DRM_DEBUG_KMS("Writeback BO too small for %ux%u, pitch %u\n",
+			      fb->width, fb->height, fb->pitches[0]);
+		return -EINVAL;
+	}
+
 	vc4_crtc_txp_armed(crtc_state);
 
 	return 0;
@@ -318,6 +334,10 @@ static void vc4_txp_connector_atomic_commit(struct drm_connector *conn,
 	if (fb->format->has_alpha)
 		ctrl |= TXP_ALPHA_ENABLE;
 
+	/* Dither down to 16bpp rather than truncating the HVS output. */
+	if (fb->format->cpp[0] == 2)
+		ctrl |= TXP_DITHER;
+
 	gem = drm_fb_cma_get_gem_obj(fb, 0);
 	TXP_WRITE(TXP_DST_PTR, gem->paddr + fb->offsets[0]);
 	TXP_WRITE(TXP_DST_PITCH, fb->pitches[0]);
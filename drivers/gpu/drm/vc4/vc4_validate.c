@@ -476,6 +476,14 @@ static const struct cmd_info {
 	VC4_DEFINE_PACKET(VC4_PACKET_GEM_HANDLES, validate_gem_handles),
 };
 
+/* State packets that are copied to the validated CL without any checks. */
+static bool
+vc4_bin_packet_is_plain(u8 cmd)
+{
+	return cmd < ARRAY_SIZE(cmd_info) && cmd_info[cmd].name &&
+	       !cmd_info[cmd].func && cmd != VC4_PACKET_HALT;
+}
+
 int
 vc4_validate_bin_cl(struct drm_device *dev,
 		    void *validated,
@@ -513,6 +521,29 @@ vc4_validate_bin_cl(struct drm_device *dev,
 			return -EINVAL;
 		}
 
+		/* Most of a typical bin CL is runs of plain state packets
+		 * between the primitives.  Copy each run in one go, leaving
+		 * anything that doesn't fit entirely within the CL to the
+		 * per-packet path below to report.
+		 */
+		if (vc4_bin_packet_is_plain(cmd)) {
+			uint32_t run = info->len;
+
+			while (src_offset + run < len) {
+				u8 next = *(uint8_t *)(src_pkt + run);
+
+				if (!vc4_bin_packet_is_plain(next) ||
+				    src_offset + run + cmd_info[next].len > len)
+					break;
+				run += cmd_info[next].len;
+			}
+
+			memcpy(dst_pkt, src_pkt, run);
+			src_offset += run;
+			dst_offset += run;
+			continue;
+		}
+
 		if (cmd != VC4_PACKET_GEM_HANDLES)
 			memcpy(dst_pkt, src_pkt, info->len);
 
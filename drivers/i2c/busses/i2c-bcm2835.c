@@ -351,6 +351,21 @@ static void bcm2835_i2c_start_transfer(struct bcm2835_i2c_dev *i2c_dev)
 
 	bcm2835_i2c_writel(i2c_dev, BCM2835_I2C_A, msg->addr);
 	bcm2835_i2c_writel(i2c_dev, BCM2835_I2C_DLEN, msg->len);
+
+	/*
+	 * No repeated start follows the last message, so a final write can
+	 * be prefilled and only needs TXW if it is longer than the FIFO.
+	 * This saves the interrupt per write that would otherwise only
+	 * report an empty FIFO.
+	 */
+	if (last_msg && !(msg->flags & I2C_M_RD)) {
+		bcm2835_i2c_writel(i2c_dev, BCM2835_I2C_C,
+				   BCM2835_I2C_C_I2CEN);
+		bcm2835_fill_txfifo(i2c_dev);
+		if (!i2c_dev->msg_buf_remaining)
+			c &= ~BCM2835_I2C_C_INTT;
+	}
+
 	bcm2835_i2c_writel(i2c_dev, BCM2835_I2C_C, c);
 	bcm2835_debug_add(i2c_dev, ~0);
 }
@@ -402,7 +417,8 @@ static irqreturn_t bcm2835_i2c_isr(int this_irq, void *data)
 		goto complete;
 	}
 
-	if (val & BCM2835_I2C_S_TXW) {
+	if ((val & BCM2835_I2C_S_TXW) &&
+	    (bcm2835_i2c_readl(i2c_dev, BCM2835_I2C_C) & BCM2835_I2C_C_INTT)) {
 		if (!i2c_dev->msg_buf_remaining) {
 			i2c_dev->msg_err = val | BCM2835_I2C_S_LEN;
 			goto complete;
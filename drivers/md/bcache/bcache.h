@@ -472,6 +472,7 @@ struct cache {
 struct gc_stat {
 	size_t			nodes;
 	size_t			nodes_pre;
+	uint64_t		slice_start;	/* local_clock() */
 	size_t			key_bytes;
 
 	size_t			nkeys;
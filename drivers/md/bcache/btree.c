@@ -93,6 +93,7 @@
 #define MAX_GC_TIMES		100
 #define MIN_GC_NODES		100
 #define GC_SLEEP_MS		100
+#define GC_SLICE_MS		20
 
 #define PTR_DIRTY_BIT		(((uint64_t) 1 << 36))
 
@@ -1596,6 +1597,17 @@ static size_t btree_gc_min_nodes(struct cache_set *c)
 	return min_nodes;
 }
 
+/*
+ * GC holds write locks on the whole path down to the nodes it's working on,
+ * so foreground lookups in that part of the btree wait for the slice to end.
+ * Besides processing btree_gc_min_nodes() nodes, a slice therefore also ends
+ * once it has run for GC_SLICE_MS while there is front side I/O.
+ */
+static bool btree_gc_slice_expired(struct gc_stat *gc)
+{
+	return local_clock() - gc->slice_start >=
+		GC_SLICE_MS * NSEC_PER_MSEC;
+}
 
 static int btree_gc_recurse(struct btree *b, struct btree_op *op,
 			    struct closure *writes, struct gc_stat *gc)
@@ -1669,6 +1681,13 @@ static int btree_gc_recurse(struct btree *b, struct btree_op *op,
 			break;
 		}
 
+		/* keep nodes_pre, the node quota carries over */
+		if (atomic_read(&b->c->search_inflight) &&
+		    btree_gc_slice_expired(gc)) {
+			ret = -EAGAIN;
+			break;
+		}
+
 		if (need_resched()) {
 			ret = -EAGAIN;
 			break;
@@ -1833,13 +1852,22 @@ static void bch_btree_gc(struct cache_set *c)
 
 	/* if CACHE_SET_IO_DISABLE set, gc thread should stop too */
 	do {
+		stats.slice_start = local_clock();
 		ret = btree_root(gc_root, c, &op, &writes, &stats);
 		closure_sync(&writes);
 		cond_resched();
 
-		if (ret == -EAGAIN)
+		/*
+		 * Sleep for long only once the node quota of this round is
+		 * done, short slices cut off by time only get a short break
+		 * so that gc still finishes in about MAX_GC_TIMES rounds.
+		 */
+		if (ret == -EAGAIN && stats.nodes == stats.nodes_pre)
 			schedule_timeout_interruptible(msecs_to_jiffies
 						       (GC_SLEEP_MS));
+		else if (ret == -EAGAIN)
+			schedule_timeout_interruptible(msecs_to_jiffies
+						       (GC_SLICE_MS));
 		else if (ret)
 			pr_warn("gc failed!");
 	} while (ret && !test_bit(CACHE_SET_IO_DISABLE, &c->flags));
@@ -56,6 +56,11 @@
  */
 #define DM_BUFIO_WRITE_ALIGN		4096
 
+/*
+ * Number of independently locked trees the buffers are spread over.
+ */
+#define DM_BUFIO_TREE_SHARDS		16
+
 /*
  * dm_buffer->list_mode
  */
@@ -65,7 +70,11 @@
 
 /*
  * Linking of buffers:
- *	All buffers are linked to cache_hash with their hash_list field.
+ *	All buffers are linked to one of the trees[] with their node field,
+ *	chosen by block number.  A tree is only modified with both c->lock
+ *	and its own lock held, so it may be searched holding either.
+ *	dm_bufio_cache_get() searches with just the tree lock, which lets
+ *	lookups of cached buffers run in parallel.
  *
  *	Clean buffers that are not being written (B_WRITING not set)
  *	are linked to lru[LIST_CLEAN] with their lru_list field.
@@ -77,7 +86,17 @@
  *	context), so some clean-not-writing buffers can be held on
  *	dirty_lru too.  They are later added to lru in the process
  *	context.
+ *
+ *	Lookups under the tree lock don't touch the LRU lists, they only set
+ *	the buffer's accessed flag.  Reclaim gives such buffers a second
+ *	chance by moving them to the head of their list instead of freeing
+ *	them.
  */
+struct dm_buffer_tree {
+	rwlock_t lock;
+	struct rb_root root;
+} ____cacheline_aligned_in_smp;
+
 struct dm_bufio_client {
 	struct mutex lock;
 
@@ -99,8 +118,9 @@ struct dm_bufio_client {
 
 	unsigned minimum_buffers;
 
-	struct rb_root buffer_tree;
+	struct dm_buffer_tree trees[DM_BUFIO_TREE_SHARDS];
 	wait_queue_head_t free_buffer_wait;
+	atomic_t release_seq;	/* bumped when a hold count drops to zero */
 
 	sector_t start;
 
@@ -136,9 +156,10 @@ struct dm_buffer {
 	void *data;
 	unsigned char data_mode;		/* DATA_MODE_* */
 	unsigned char list_mode;		/* LIST_* */
+	unsigned char accessed;
 	blk_status_t read_error;
 	blk_status_t write_error;
-	unsigned hold_count;
+	atomic_t hold_count;
 	unsigned long state;
 	unsigned long last_accessed;
 	unsigned dirty_start;
@@ -241,11 +262,18 @@ static void buffer_record_stack(struct dm_buffer *b)
 #endif
 
 /*----------------------------------------------------------------
- * A red/black tree acts as an index for all the buffers.
+ * Red/black trees act as an index for all the buffers.
  *--------------------------------------------------------------*/
-static struct dm_buffer *__find(struct dm_bufio_client *c, sector_t block)
+static struct dm_buffer_tree *buffer_tree(struct dm_bufio_client *c,
+					  sector_t block)
 {
-	struct rb_node *n = c->buffer_tree.rb_node;
+	return &c->trees[block & (DM_BUFIO_TREE_SHARDS - 1)];
+}
+
+static struct dm_buffer *__find_in_tree(struct dm_buffer_tree *t,
+					sector_t block)
+{
+	struct rb_node *n = t->root.rb_node;
 	struct dm_buffer *b;
 
 	while (n) {
@@ -260,17 +288,25 @@ static struct dm_buffer *__find(struct dm_bufio_client *c, sector_t block)
 	return NULL;
 }
 
+static struct dm_buffer *__find(struct dm_bufio_client *c, sector_t block)
+{
+	return __find_in_tree(buffer_tree(c, block), block);
+}
+
 static void __insert(struct dm_bufio_client *c, struct dm_buffer *b)
 {
-	struct rb_node **new = &c->buffer_tree.rb_node, *parent = NULL;
+	struct dm_buffer_tree *t = buffer_tree(c, b->block);
+	struct rb_node **new = &t->root.rb_node, *parent = NULL;
 	struct dm_buffer *found;
 
+	write_lock(&t->lock);
+
 	while (*new) {
 		found = container_of(*new, struct dm_buffer, node);
 
 		if (found->block == b->block) {
 			BUG_ON(found != b);
-			return;
+			goto out;
 		}
 
 		parent = *new;
@@ -279,12 +315,60 @@ static void __insert(struct dm_bufio_client *c, struct dm_buffer *b)
 	}
 
 	rb_link_node(&b->node, parent, new);
-	rb_insert_color(&b->node, &c->buffer_tree);
+	rb_insert_color(&b->node, &t->root);
+out:
+	write_unlock(&t->lock);
 }
 
 static void __remove(struct dm_bufio_client *c, struct dm_buffer *b)
 {
-	rb_erase(&b->node, &c->buffer_tree);
+	struct dm_buffer_tree *t = buffer_tree(c, b->block);
+
+	write_lock(&t->lock);
+	rb_erase(&b->node, &t->root);
+	write_unlock(&t->lock);
+}
+
+/*
+ * Remove the buffer from its tree if nobody but the caller holds it,
+ * i.e. its hold count is @holders and there is no I/O or dirty data on it.
+ * The check is made under the tree lock because dm_bufio_cache_get() may
+ * take a reference without c->lock.
+ */
+static bool __remove_if_unheld(struct dm_buffer *b, int holders)
+{
+	struct dm_buffer_tree *t = buffer_tree(b->c, b->block);
+	bool removed = false;
+
+	write_lock(&t->lock);
+	if (atomic_read(&b->hold_count) == holders && !b->state) {
+		rb_erase(&b->node, &t->root);
+		removed = true;
+	}
+	write_unlock(&t->lock);
+
+	return removed;
+}
+
+/*
+ * Find a buffer and take a reference on it without taking c->lock.
+ */
+static struct dm_buffer *dm_bufio_cache_get(struct dm_bufio_client *c,
+					    sector_t block)
+{
+	struct dm_buffer_tree *t = buffer_tree(c, block);
+	struct dm_buffer *b;
+
+	read_lock(&t->lock);
+	b = __find_in_tree(t, block);
+	if (b) {
+		atomic_inc(&b->hold_count);
+		WRITE_ONCE(b->accessed, 1);
+		WRITE_ONCE(b->last_accessed, jiffies);
+	}
+	read_unlock(&t->lock);
+
+	return b;
 }
 
 /*----------------------------------------------------------------*/
@@ -466,23 +550,29 @@ static void __link_buffer(struct dm_buffer *b, sector_t block, int dirty)
 	c->n_buffers[dirty]++;
 	b->block = block;
 	b->list_mode = dirty;
+	b->accessed = 0;
 	list_add(&b->lru_list, &c->lru[dirty]);
 	__insert(b->c, b);
 	b->last_accessed = jiffies;
 }
 
 /*
- * Unlink buffer from the hash list and dirty or clean queue.
+ * Unlink buffer from the tree and dirty or clean queue, provided that
+ * nobody holds it and it is clean and idle.
  */
-static void __unlink_buffer(struct dm_buffer *b)
+static bool __unlink_unheld_buffer(struct dm_buffer *b)
 {
 	struct dm_bufio_client *c = b->c;
 
+	if (!__remove_if_unheld(b, 0))
+		return false;
+
 	BUG_ON(!c->n_buffers[b->list_mode]);
 
 	c->n_buffers[b->list_mode]--;
-	__remove(b->c, b);
 	list_del(&b->lru_list);
+
+	return true;
 }
 
 /*
@@ -497,10 +587,27 @@ static void __relink_lru(struct dm_buffer *b, int dirty)
 	c->n_buffers[b->list_mode]--;
 	c->n_buffers[dirty]++;
 	b->list_mode = dirty;
+	WRITE_ONCE(b->accessed, 0);
 	list_move(&b->lru_list, &c->lru[dirty]);
 	b->last_accessed = jiffies;
 }
 
+/*
+ * If the buffer was found by dm_bufio_cache_get() since it was last
+ * relinked, clear the accessed flag and move it to the head of its list
+ * rather than reclaiming it.
+ */
+static bool __lru_second_chance(struct dm_buffer *b)
+{
+	if (!READ_ONCE(b->accessed))
+		return false;
+
+	WRITE_ONCE(b->accessed, 0);
+	list_move(&b->lru_list, &b->c->lru[b->list_mode]);
+
+	return true;
+}
+
 /*----------------------------------------------------------------
  * Submit I/O on the buffer.
  *
@@ -725,8 +832,6 @@ static void __flush_write_list(struct list_head *write_list)
  */
 static void __make_buffer_clean(struct dm_buffer *b)
 {
-	BUG_ON(b->hold_count);
-
 	if (!b->state)	/* fast case */
 		return;
 
@@ -741,27 +846,33 @@ static void __make_buffer_clean(struct dm_buffer *b)
  */
 static struct dm_buffer *__get_unclaimed_buffer(struct dm_bufio_client *c)
 {
-	struct dm_buffer *b;
+	struct dm_buffer *b, *tmp;
 
-	list_for_each_entry_reverse(b, &c->lru[LIST_CLEAN], lru_list) {
+	list_for_each_entry_safe_reverse(b, tmp, &c->lru[LIST_CLEAN], lru_list) {
 		BUG_ON(test_bit(B_WRITING, &b->state));
 		BUG_ON(test_bit(B_DIRTY, &b->state));
 
-		if (!b->hold_count) {
+		if (__lru_second_chance(b))
+			continue;
+
+		if (!atomic_read(&b->hold_count)) {
 			__make_buffer_clean(b);
-			__unlink_buffer(b);
-			return b;
+			if (__unlink_unheld_buffer(b))
+				return b;
 		}
 		cond_resched();
 	}
 
-	list_for_each_entry_reverse(b, &c->lru[LIST_DIRTY], lru_list) {
+	list_for_each_entry_safe_reverse(b, tmp, &c->lru[LIST_DIRTY], lru_list) {
 		BUG_ON(test_bit(B_READING, &b->state));
 
-		if (!b->hold_count) {
+		if (__lru_second_chance(b))
+			continue;
+
+		if (!atomic_read(&b->hold_count)) {
 			__make_buffer_clean(b);
-			__unlink_buffer(b);
-			return b;
+			if (__unlink_unheld_buffer(b))
+				return b;
 		}
 		cond_resched();
 	}
@@ -769,22 +880,44 @@ static struct dm_buffer *__get_unclaimed_buffer(struct dm_bufio_client *c)
 	return NULL;
 }
 
+/*
+ * Sample c->release_seq before looking for a buffer with a zero hold count.
+ */
+static int __release_seq(struct dm_bufio_client *c)
+{
+	int seq = atomic_read(&c->release_seq);
+
+	/* paired with atomic_dec_and_test() in dm_bufio_release() */
+	smp_rmb();
+
+	return seq;
+}
+
 /*
  * Wait until some other threads free some buffer or release hold count on
  * some buffer.
  *
+ * dm_bufio_release() drops hold counts without c->lock, so @seq is the
+ * value of c->release_seq sampled before the caller looked for a free
+ * buffer.  If it has changed since, a hold count dropped to zero and
+ * there is no point in sleeping.
+ *
  * This function is entered with c->lock held, drops it and regains it
  * before exiting.
  */
-static void __wait_for_free_buffer(struct dm_bufio_client *c)
+static void __wait_for_free_buffer(struct dm_bufio_client *c, int seq)
 {
 	DECLARE_WAITQUEUE(wait, current);
 
 	add_wait_queue(&c->free_buffer_wait, &wait);
+	/* implies a full barrier, paired with the one in dm_bufio_release() */
 	set_current_state(TASK_UNINTERRUPTIBLE);
 	dm_bufio_unlock(c);
 
-	io_schedule();
+	if (atomic_read(&c->release_seq) == seq)
+		io_schedule();
+	else
+		__set_current_state(TASK_RUNNING);
 
 	remove_wait_queue(&c->free_buffer_wait, &wait);
 
@@ -808,6 +941,7 @@ static struct dm_buffer *__alloc_buffer_wait_no_callback(struct dm_bufio_client
 {
 	struct dm_buffer *b;
 	bool tried_noio_alloc = false;
+	int seq;
 
 	/*
 	 * dm-bufio is resistant to allocation failures (it just keeps
@@ -823,6 +957,8 @@ static struct dm_buffer *__alloc_buffer_wait_no_callback(struct dm_bufio_client
 	 * be allocated.
 	 */
 	while (1) {
+		seq = __release_seq(c);
+
 		if (dm_bufio_cache_size_latch != 1) {
 			b = alloc_buffer(c, GFP_NOWAIT | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
 			if (b)
@@ -854,7 +990,7 @@ static struct dm_buffer *__alloc_buffer_wait_no_callback(struct dm_bufio_client
 		if (b)
 			return b;
 
-		__wait_for_free_buffer(c);
+		__wait_for_free_buffer(c, seq);
 	}
 }
 
@@ -1003,18 +1139,20 @@ static struct dm_buffer *__bufio_new(struct dm_bufio_client *c, sector_t block,
 
 	__check_watermark(c, write_list);
 
+	/*
+	 * The buffer is visible to dm_bufio_cache_get() as soon as it is
+	 * linked, so it must be fully set up first.
+	 */
 	b = new_b;
-	b->hold_count = 1;
+	atomic_set(&b->hold_count, 1);
 	b->read_error = 0;
 	b->write_error = 0;
+	b->state = nf == NF_FRESH ? 0 : 1 << B_READING;
 	__link_buffer(b, block, LIST_CLEAN);
 
-	if (nf == NF_FRESH) {
-		b->state = 0;
+	if (nf == NF_FRESH)
 		return b;
-	}
 
-	b->state = 1 << B_READING;
 	*need_submit = 1;
 
 	return b;
@@ -1032,7 +1170,7 @@ static struct dm_buffer *__bufio_new(struct dm_bufio_client *c, sector_t block,
 	if (nf == NF_GET && unlikely(test_bit(B_READING, &b->state)))
 		return NULL;
 
-	b->hold_count++;
+	atomic_inc(&b->hold_count);
 	__relink_lru(b, test_bit(B_DIRTY, &b->state) ||
 		     test_bit(B_WRITING, &b->state));
 	return b;
@@ -1064,15 +1202,34 @@ static void read_endio(struct dm_buffer *b, blk_status_t status)
 static void *new_read(struct dm_bufio_client *c, sector_t block,
 		      enum new_flag nf, struct dm_buffer **bp)
 {
-	int need_submit;
+	int need_submit = 0;
 	struct dm_buffer *b;
 
 	LIST_HEAD(write_list);
 
+	/*
+	 * Fast path: the buffer is cached, so there's nothing to allocate
+	 * or link and c->lock isn't needed.  The stack tracing debug option
+	 * records the first holder under c->lock, so it always takes the
+	 * slow path.
+	 */
+	if (!IS_ENABLED(CONFIG_DM_DEBUG_BLOCK_STACK_TRACING)) {
+		b = dm_bufio_cache_get(c, block);
+		if (b) {
+			/* See the comment at found_buffer in __bufio_new */
+			if (nf == NF_GET &&
+			    unlikely(test_bit(B_READING, &b->state))) {
+				dm_bufio_release(b);
+				return NULL;
+			}
+			goto wait;
+		}
+	}
+
 	dm_bufio_lock(c);
 	b = __bufio_new(c, block, nf, &need_submit, &write_list);
 #ifdef CONFIG_DM_DEBUG_BLOCK_STACK_TRACING
-	if (b && b->hold_count == 1)
+	if (b && atomic_read(&b->hold_count) == 1)
 		buffer_record_stack(b);
 #endif
 	dm_bufio_unlock(c);
@@ -1085,6 +1242,7 @@ static void *new_read(struct dm_bufio_client *c, sector_t block,
 	if (need_submit)
 		submit_io(b, REQ_OP_READ, read_endio);
 
+wait:
 	wait_on_bit_io(&b->state, B_READING, TASK_UNINTERRUPTIBLE);
 
 	if (b->read_error) {
@@ -1175,29 +1333,38 @@ void dm_bufio_release(struct dm_buffer *b)
 {
 	struct dm_bufio_client *c = b->c;
 
-	dm_bufio_lock(c);
-
-	BUG_ON(!b->hold_count);
-
-	b->hold_count--;
-	if (!b->hold_count) {
-		wake_up(&c->free_buffer_wait);
+	BUG_ON(!atomic_read(&b->hold_count));
 
-		/*
-		 * If there were errors on the buffer, and the buffer is not
-		 * to be written, free the buffer. There is no point in caching
-		 * invalid buffer.
-		 */
-		if ((b->read_error || b->write_error) &&
-		    !test_bit(B_READING, &b->state) &&
-		    !test_bit(B_WRITING, &b->state) &&
-		    !test_bit(B_DIRTY, &b->state)) {
-			__unlink_buffer(b);
-			__free_buffer_wake(b);
+	/*
+	 * If there were errors on the buffer, and the buffer is not
+	 * to be written, free the buffer. There is no point in caching
+	 * invalid buffer.
+	 */
+	if (unlikely(b->read_error || b->write_error)) {
+		dm_bufio_lock(c);
+		if (atomic_dec_and_test(&b->hold_count)) {
+			wake_up(&c->free_buffer_wait);
+			if (__unlink_unheld_buffer(b))
+				__free_buffer_wake(b);
 		}
+		dm_bufio_unlock(c);
+		return;
 	}
 
-	dm_bufio_unlock(c);
+	/*
+	 * An unused cached buffer stays where it is, so the common case
+	 * needs no lock.  A waiter may have looked for a free buffer just
+	 * before the hold count dropped and not be queued yet: bumping
+	 * release_seq makes it skip the sleep, and the barrier pairs with
+	 * set_current_state() in __wait_for_free_buffer() so that either
+	 * the waiter sees the new release_seq or it is seen here.
+	 */
+	if (atomic_dec_and_test(&b->hold_count)) {
+		atomic_inc(&c->release_seq);
+		smp_mb__after_atomic();
+		if (waitqueue_active(&c->free_buffer_wait))
+			wake_up(&c->free_buffer_wait);
+	}
 }
 EXPORT_SYMBOL_GPL(dm_bufio_release);
 
@@ -1280,12 +1447,12 @@ int dm_bufio_write_dirty_buffers(struct dm_bufio_client *c)
 		if (test_bit(B_WRITING, &b->state)) {
 			if (buffers_processed < c->n_buffers[LIST_DIRTY]) {
 				dropped_lock = 1;
-				b->hold_count++;
+				atomic_inc(&b->hold_count);
 				dm_bufio_unlock(c);
 				wait_on_bit_io(&b->state, B_WRITING,
 					       TASK_UNINTERRUPTIBLE);
 				dm_bufio_lock(c);
-				b->hold_count--;
+				atomic_dec(&b->hold_count);
 			} else
 				wait_on_bit_io(&b->state, B_WRITING,
 					       TASK_UNINTERRUPTIBLE);
@@ -1366,16 +1533,18 @@ void dm_bufio_release_move(struct dm_buffer *b, sector_t new_block)
 {
 	struct dm_bufio_client *c = b->c;
 	struct dm_buffer *new;
+	int seq;
 
 	BUG_ON(dm_bufio_in_request());
 
 	dm_bufio_lock(c);
 
 retry:
+	seq = __release_seq(c);
 	new = __find(c, new_block);
 	if (new) {
-		if (new->hold_count) {
-			__wait_for_free_buffer(c);
+		if (atomic_read(&new->hold_count)) {
+			__wait_for_free_buffer(c, seq);
 			goto retry;
 		}
 
@@ -1384,41 +1553,43 @@ void dm_bufio_release_move(struct dm_buffer *b, sector_t new_block)
 		 * to be overwritten in a bit?
 		 */
 		__make_buffer_clean(new);
-		__unlink_buffer(new);
+		if (!__unlink_unheld_buffer(new))
+			goto retry;
 		__free_buffer_wake(new);
 	}
 
-	BUG_ON(!b->hold_count);
+	BUG_ON(!atomic_read(&b->hold_count));
 	BUG_ON(test_bit(B_READING, &b->state));
 
 	__write_dirty_buffer(b, NULL);
-	if (b->hold_count == 1) {
-		wait_on_bit_io(&b->state, B_WRITING,
-			       TASK_UNINTERRUPTIBLE);
+	wait_on_bit_io(&b->state, B_WRITING, TASK_UNINTERRUPTIBLE);
+	if (__remove_if_unheld(b, 1)) {
 		set_bit(B_DIRTY, &b->state);
 		b->dirty_start = 0;
 		b->dirty_end = c->block_size;
-		__unlink_buffer(b);
-		__link_buffer(b, new_block, LIST_DIRTY);
+		b->block = new_block;
+		__insert(c, b);
+		__relink_lru(b, LIST_DIRTY);
 	} else {
 		sector_t old_block;
 		wait_on_bit_lock_io(&b->state, B_WRITING,
 				    TASK_UNINTERRUPTIBLE);
 		/*
-		 * Relink buffer to "new_block" so that write_callback
-		 * sees "new_block" as a block number.
-		 * After the write, link the buffer back to old_block.
-		 * All this must be done in bufio lock, so that block number
-		 * change isn't visible to other threads.
+		 * Change the block number to "new_block" so that
+		 * write_callback sees "new_block" as a block number.
+		 * After the write, put the buffer back at old_block.
+		 * The buffer is out of the tree meanwhile, so lookups
+		 * fall back to the slow path and wait for the bufio lock;
+		 * the block number change isn't visible to other threads.
 		 */
 		old_block = b->block;
-		__unlink_buffer(b);
-		__link_buffer(b, new_block, b->list_mode);
+		__remove(c, b);
+		b->block = new_block;
 		submit_io(b, REQ_OP_WRITE, write_endio);
 		wait_on_bit_io(&b->state, B_WRITING,
 			       TASK_UNINTERRUPTIBLE);
-		__unlink_buffer(b);
-		__link_buffer(b, old_block, b->list_mode);
+		b->block = old_block;
+		__insert(c, b);
 	}
 
 	dm_bufio_unlock(c);
@@ -1439,10 +1610,8 @@ void dm_bufio_forget(struct dm_bufio_client *c, sector_t block)
 	dm_bufio_lock(c);
 
 	b = __find(c, block);
-	if (b && likely(!b->hold_count) && likely(!b->state)) {
-		__unlink_buffer(b);
+	if (b && likely(__unlink_unheld_buffer(b)))
 		__free_buffer_wake(b);
-	}
 
 	dm_bufio_unlock(c);
 }
@@ -1517,11 +1686,13 @@ static void drop_buffers(struct dm_bufio_client *c)
 		list_for_each_entry(b, &c->lru[i], lru_list) {
 			WARN_ON(!warned);
 			warned = true;
-			DMERR("leaked buffer %llx, hold count %u, list %d",
-			      (unsigned long long)b->block, b->hold_count, i);
+			DMERR("leaked buffer %llx, hold count %d, list %d",
+			      (unsigned long long)b->block,
+			      atomic_read(&b->hold_count), i);
 #ifdef CONFIG_DM_DEBUG_BLOCK_STACK_TRACING
 			print_stack_trace(&b->stack_trace, 1);
-			b->hold_count = 0; /* mark unclaimed to avoid BUG_ON below */
+			/* mark unclaimed to avoid BUG_ON below */
+			atomic_set(&b->hold_count, 0);
 #endif
 		}
 
@@ -1553,11 +1724,12 @@ static bool __try_evict_buffer(struct dm_buffer *b, gfp_t gfp)
 			return false;
 	}
 
-	if (b->hold_count)
+	if (atomic_read(&b->hold_count))
 		return false;
 
 	__make_buffer_clean(b);
-	__unlink_buffer(b);
+	if (!__unlink_unheld_buffer(b))
+		return false;
 	__free_buffer_wake(b);
 
 	return true;
@@ -1585,7 +1757,8 @@ static unsigned long __scan(struct dm_bufio_client *c, unsigned long nr_to_scan,
 
 	for (l = 0; l < LIST_SIZE; l++) {
 		list_for_each_entry_safe_reverse(b, tmp, &c->lru[l], lru_list) {
-			if (__try_evict_buffer(b, gfp_mask))
+			if (!__lru_second_chance(b) &&
+			    __try_evict_buffer(b, gfp_mask))
 				freed++;
 			if (!--nr_to_scan || ((count - freed) <= retain_target))
 				return freed;
@@ -1647,7 +1820,10 @@ struct dm_bufio_client *dm_bufio_client_create(struct block_device *bdev, unsign
 		r = -ENOMEM;
 		goto bad_client;
 	}
-	c->buffer_tree = RB_ROOT;
+	for (i = 0; i < DM_BUFIO_TREE_SHARDS; i++) {
+		rwlock_init(&c->trees[i].lock);
+		c->trees[i].root = RB_ROOT;
+	}
 
 	c->bdev = bdev;
 	c->block_size = block_size;
@@ -1671,6 +1847,7 @@ struct dm_bufio_client *dm_bufio_client_create(struct block_device *bdev, unsign
 	dm_bufio_set_minimum_buffers(c, DM_BUFIO_MIN_BUFFERS);
 
 	init_waitqueue_head(&c->free_buffer_wait);
+	atomic_set(&c->release_seq, 0);
 	c->async_write_error = 0;
 
 	c->dm_io = dm_io_client_create();
@@ -1765,7 +1942,8 @@ void dm_bufio_client_destroy(struct dm_bufio_client *c)
 
 	mutex_unlock(&dm_bufio_clients_lock);
 
-	BUG_ON(!RB_EMPTY_ROOT(&c->buffer_tree));
+	for (i = 0; i < DM_BUFIO_TREE_SHARDS; i++)
+		BUG_ON(!RB_EMPTY_ROOT(&c->trees[i].root));
 	BUG_ON(c->need_reserved_buffers);
 
 	while (!list_empty(&c->reserved_buffers)) {
@@ -1832,6 +2010,9 @@ static void __evict_old_buffers(struct dm_bufio_client *c, unsigned long age_hz)
 		if (count <= retain_target)
 			break;
 
+		if (__lru_second_chance(b))
+			continue;
+
 		if (!older_than(b, age_hz))
 			break;
 
@@ -19,6 +19,7 @@
 #include <linux/slab.h>
 #include <linux/crypto.h>
 #include <linux/workqueue.h>
+#include <linux/interrupt.h>
 #include <linux/kthread.h>
 #include <linux/backing-dev.h>
 #include <linux/atomic.h>
@@ -67,6 +68,7 @@ struct dm_crypt_io {
 	u8 *integrity_metadata;
 	bool integrity_metadata_from_pool;
 	struct work_struct work;
+	struct tasklet_struct tasklet;
 
 	struct convert_context ctx;
 
@@ -125,11 +127,13 @@ struct iv_tcw_private {
  * and encrypts / decrypts at the same time.
  */
 enum flags { DM_CRYPT_SUSPENDED, DM_CRYPT_KEY_VALID,
-	     DM_CRYPT_SAME_CPU, DM_CRYPT_NO_OFFLOAD };
+	     DM_CRYPT_SAME_CPU, DM_CRYPT_NO_OFFLOAD,
+	     DM_CRYPT_NO_READ_WORKQUEUE, DM_CRYPT_NO_WRITE_WORKQUEUE };
 
 enum cipher_flags {
 	CRYPT_MODE_INTEGRITY_AEAD,	/* Use authenticated mode for cihper */
 	CRYPT_IV_LARGE_SECTORS,		/* Calculate IV from sector_size, not 512B sectors */
+	CRYPT_SYNC_CIPHER,		/* Cipher never completes asynchronously */
 };
 
 /*
@@ -245,6 +249,21 @@ static struct crypto_aead *any_tfm_aead(struct crypt_config *cc)
 	return cc->cipher_tfm.tfms_aead[0];
 }
 
+/*
+ * Whether to en/decrypt in the context submitting or completing the bio
+ * rather than bouncing it through kcryptd. Asynchronous ciphers always
+ * use the workqueue, their completion may come in any context and
+ * crypt_convert() would have to wait for a full driver queue.
+ */
+static bool crypt_inline(struct crypt_config *cc, int rw)
+{
+	if (!test_bit(CRYPT_SYNC_CIPHER, &cc->cipher_flags))
+		return false;
+
+	return test_bit(rw == READ ? DM_CRYPT_NO_READ_WORKQUEUE :
+				     DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
+}
+
 /*
  * Different IV generation algorithms:
  *
@@ -1317,8 +1336,14 @@ static void crypt_free_req(struct crypt_config *cc, void *req, struct bio *base_
 /*
  * Encrypt / decrypt data from one bio to another one (can be the same one)
  */
+/*
+ * With @atomic set we may be running from bio completion, which the
+ * no_read_workqueue option allows for synchronous ciphers only. Those
+ * never leave the request embedded in the per-bio data, so nothing here
+ * allocates or waits, we just must not reschedule.
+ */
 static blk_status_t crypt_convert(struct crypt_config *cc,
-			 struct convert_context *ctx)
+			 struct convert_context *ctx, bool atomic)
 {
 	unsigned int tag_offset = 0;
 	unsigned int sector_step = cc->sector_size >> SECTOR_SHIFT;
@@ -1361,7 +1386,8 @@ static blk_status_t crypt_convert(struct crypt_config *cc,
 			atomic_dec(&ctx->cc_pending);
 			ctx->cc_sector += sector_step;
 			tag_offset++;
-			cond_resched();
+			if (!atomic)
+				cond_resched();
 			continue;
 		/*
 		 * There was a data integrity error.
@@ -1687,7 +1713,15 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 
 	clone->bi_iter.bi_sector = cc->start + io->sector;
 
-	if (likely(!async) && test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags)) {
+	/*
+	 * Sorting writes only pays off on rotational devices, submit
+	 * straight away for the rest unless we're in crypto completion
+	 * context.
+	 */
+	if (likely(!async) &&
+	    (test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags) ||
+	     test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags) ||
+	     blk_queue_nonrot(bdev_get_queue(cc->dev->bdev)))) {
 		generic_make_request(clone);
 		return;
 	}
@@ -1736,7 +1770,7 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 	sector += bio_sectors(clone);
 
 	crypt_inc_pending(io);
-	r = crypt_convert(cc, &io->ctx);
+	r = crypt_convert(cc, &io->ctx, false);
 	if (r)
 		io->error = r;
 	crypt_finished = atomic_dec_and_test(&io->ctx.cc_pending);
@@ -1766,7 +1800,7 @@ static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
 	crypt_convert_init(cc, &io->ctx, io->base_bio, io->base_bio,
 			   io->sector);
 
-	r = crypt_convert(cc, &io->ctx);
+	r = crypt_convert(cc, &io->ctx, crypt_inline(cc, READ));
 	if (r)
 		io->error = r;
 
@@ -1825,10 +1859,36 @@ static void kcryptd_crypt(struct work_struct *work)
 		kcryptd_crypt_write_convert(io);
 }
 
+static void kcryptd_crypt_tasklet(unsigned long data)
+{
+	kcryptd_crypt_read_convert((struct dm_crypt_io *)data);
+}
+
 static void kcryptd_queue_crypt(struct dm_crypt_io *io)
 {
 	struct crypt_config *cc = io->cc;
 
+	if (crypt_inline(cc, bio_data_dir(io->base_bio))) {
+		/*
+		 * The skcipher walk refuses to run in hard irq context,
+		 * where reads may complete. Softirq is as close as we get.
+		 * Only the read path may run there: for a synchronous cipher
+		 * it neither allocates nor waits, whereas the write path
+		 * allocates pages and may sleep. Writes are only queued from
+		 * crypt_map(), which runs in process context.
+		 */
+		if (bio_data_dir(io->base_bio) == READ &&
+		    (in_irq() || irqs_disabled())) {
+			tasklet_init(&io->tasklet, kcryptd_crypt_tasklet,
+				     (unsigned long)io);
+			tasklet_schedule(&io->tasklet);
+			return;
+		}
+
+		kcryptd_crypt(&io->work);
+		return;
+	}
+
 	INIT_WORK(&io->work, kcryptd_crypt);
 	queue_work(cc->crypt_queue, &io->work);
 }
@@ -2600,7 +2660,7 @@ static int crypt_ctr_optional(struct dm_target *ti, unsigned int argc, char **ar
 	struct crypt_config *cc = ti->private;
 	struct dm_arg_set as;
 	static const struct dm_arg _args[] = {
-		{0, 6, "Invalid number of feature args"},
+		{0, 8, "Invalid number of feature args"},
 	};
 	unsigned int opt_params, val;
 	const char *opt_string, *sval;
@@ -2630,6 +2690,10 @@ static int crypt_ctr_optional(struct dm_target *ti, unsigned int argc, char **ar
 
 		else if (!strcasecmp(opt_string, "submit_from_crypt_cpus"))
 			set_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags);
+		else if (!strcasecmp(opt_string, "no_read_workqueue"))
+			set_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags);
+		else if (!strcasecmp(opt_string, "no_write_workqueue"))
+			set_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
 		else if (sscanf(opt_string, "integrity:%u:", &val) == 1) {
 			if (val == 0 || val > MAX_TAG_SIZE) {
 				ti->error = "Invalid integrity arguments";
@@ -2673,12 +2737,24 @@ static int crypt_ctr_optional(struct dm_target *ti, unsigned int argc, char **ar
 /*
  * Construct an encryption mapping:
  * <cipher> [<key>|:<key_size>:<user|logon>:<key_description>] <iv_offset> <dev_path> <start>
+ *     [<#opt_params> <opt_params>]
+ *
+ * Optional parameters:
+ *   allow_discards
+ *   same_cpu_crypt
+ *   submit_from_crypt_cpus
+ *   no_read_workqueue	decrypt reads when they complete (synchronous ciphers)
+ *   no_write_workqueue	encrypt writes when they are submitted (synchronous ciphers)
+ *   integrity:<bytes>:<type>
+ *   sector_size:<bytes>
+ *   iv_large_sectors
  */
 static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 {
 	struct crypt_config *cc;
 	int key_size;
 	unsigned int align_mask;
+	u32 alg_flags;
 	unsigned long long tmpll;
 	int ret;
 	size_t iv_size_padding, additional_req_size;
@@ -2726,6 +2802,16 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	if (ret < 0)
 		goto bad;
 
+	if (crypt_integrity_aead(cc))
+		alg_flags = crypto_aead_alg(any_tfm_aead(cc))->base.cra_flags;
+	else
+		alg_flags = crypto_skcipher_alg(any_tfm(cc))->base.cra_flags;
+	if (!(alg_flags & CRYPTO_ALG_ASYNC))
+		set_bit(CRYPT_SYNC_CIPHER, &cc->cipher_flags);
+	else if (test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags) ||
+		 test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags))
+		DMWARN("Asynchronous cipher, ignoring no_*_workqueue");
+
 	if (crypt_integrity_aead(cc)) {
 		cc->dmreq_start = sizeof(struct aead_request);
 		cc->dmreq_start += crypto_aead_reqsize(any_tfm_aead(cc));
@@ -2956,6 +3042,8 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 		num_feature_args += !!ti->num_discard_bios;
 		num_feature_args += test_bit(DM_CRYPT_SAME_CPU, &cc->flags);
 		num_feature_args += test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags);
+		num_feature_args += test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags);
+		num_feature_args += test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
 		num_feature_args += cc->sector_size != (1 << SECTOR_SHIFT);
 		num_feature_args += test_bit(CRYPT_IV_LARGE_SECTORS, &cc->cipher_flags);
 		if (cc->on_disk_tag_size)
@@ -2968,6 +3056,10 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 				DMEMIT(" same_cpu_crypt");
 			if (test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags))
 				DMEMIT(" submit_from_crypt_cpus");
+			if (test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags))
+				DMEMIT(" no_read_workqueue");
+			if (test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags))
+				DMEMIT(" no_write_workqueue");
 			if (cc->on_disk_tag_size)
 				DMEMIT(" integrity:%u:%s", cc->on_disk_tag_size, cc->cipher_auth);
 			if (cc->sector_size != (1 << SECTOR_SHIFT))
@@ -3086,7 +3178,7 @@ static void crypt_io_hints(struct dm_target *ti, struct queue_limits *limits)
 
 static struct target_type crypt_target = {
 	.name   = "crypt",
-	.version = {1, 18, 1},
+	.version = {1, 19, 0},
 	.module = THIS_MODULE,
 	.ctr    = crypt_ctr,
 	.dtr    = crypt_dtr,
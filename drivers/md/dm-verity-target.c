@@ -12,6 +12,14 @@
  * hash device. Setting this greatly improves performance when data and hash
  * are on the same disk on different partitions on devices with poor random
  * access behavior.
+ *
+ * Sequential reads also prefetch the hash blocks for the data blocks in the
+ * following readahead window of the verity device.
+ *
+ * In the file "/sys/module/dm_verity/parameters/split_bytes" you can set the
+ * size of the slices a large read is split into for verification on several
+ * CPUs at once. Reads smaller than two slices are verified by one worker.
+ * Zero disables splitting.
  */
 
 #include "dm-verity.h"
@@ -27,6 +35,8 @@
 
 #define DM_VERITY_DEFAULT_PREFETCH_SIZE	262144
 
+#define DM_VERITY_DEFAULT_SPLIT_SIZE	65536
+
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
 #define DM_VERITY_OPT_LOGGING		"ignore_corruption"
@@ -40,6 +50,10 @@ static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
 module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO | S_IWUSR);
 
+static unsigned dm_verity_split_bytes = DM_VERITY_DEFAULT_SPLIT_SIZE;
+
+module_param_named(split_bytes, dm_verity_split_bytes, uint, S_IRUGO | S_IWUSR);
+
 struct dm_verity_prefetch_work {
 	struct work_struct work;
 	struct dm_verity *v;
@@ -47,6 +61,17 @@ struct dm_verity_prefetch_work {
 	unsigned n_blocks;
 };
 
+/*
+ * A slice of a large dm_verity_io that is verified on its own work item.
+ * The io is a private copy followed by its own hash request and digests,
+ * it shares the parent's bio.
+ */
+struct dm_verity_split_work {
+	struct work_struct work;
+	struct dm_verity_io *parent;
+	struct dm_verity_io io;		/* must be last */
+};
+
 /*
  * Auxiliary structure appended to each dm-bufio buffer. If the value
  * hash_verified is nonzero, hash of the block has been verified.
@@ -368,7 +393,7 @@ static int verity_for_io_block(struct dm_verity *v, struct dm_verity_io *io,
 			       struct bvec_iter *iter, struct crypto_wait *wait)
 {
 	unsigned int todo = 1 << v->data_dev_block_bits;
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio *bio = io->bio;
 	struct scatterlist sg;
 	struct ahash_request *req = verity_io_hash_req(v, io);
 
@@ -415,7 +440,7 @@ int verity_for_bv_block(struct dm_verity *v, struct dm_verity_io *io,
 				       size_t len))
 {
 	unsigned todo = 1 << v->data_dev_block_bits;
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio *bio = io->bio;
 
 	do {
 		int r;
@@ -456,7 +481,7 @@ static inline void verity_bv_skip_block(struct dm_verity *v,
 					struct dm_verity_io *io,
 					struct bvec_iter *iter)
 {
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct bio *bio = io->bio;
 
 	bio_advance_iter(bio, iter, 1 << v->data_dev_block_bits);
 }
@@ -549,10 +574,102 @@ static void verity_finish_io(struct dm_verity_io *io, blk_status_t status)
 	bio_endio(bio);
 }
 
+/*
+ * Account for one finished slice of a split io, the last one ends the io.
+ */
+static void verity_split_done(struct dm_verity_io *io, int r)
+{
+	if (unlikely(r))
+		(void)cmpxchg(&io->split_error, 0, r);
+
+	if (atomic_dec_and_test(&io->split_pending)) {
+		r = READ_ONCE(io->split_error);
+		verity_finish_io(io, errno_to_blk_status(r));
+	}
+}
+
+static void verity_split_work(struct work_struct *w)
+{
+	struct dm_verity_split_work *sw =
+		container_of(w, struct dm_verity_split_work, work);
+	struct dm_verity_io *parent = sw->parent;
+	int r;
+
+	r = verity_verify_io(&sw->io);
+	kfree(sw);
+
+	verity_split_done(parent, r);
+}
+
+/*
+ * Verify a large io on several CPUs. The blocks are divided into slices of
+ * at least "split_bytes", all but the last are queued as separate works and
+ * the last one is verified by the caller. Nobody waits for the slices;
+ * whichever finishes last ends the io.
+ *
+ * Returns false if the io should rather be verified in one piece.
+ */
+static bool verity_verify_split(struct dm_verity_io *io)
+{
+	struct dm_verity *v = io->v;
+	unsigned split_blocks = READ_ONCE(dm_verity_split_bytes) >>
+				v->data_dev_block_bits;
+	size_t size = sizeof(struct dm_verity_split_work) +
+		      v->ahash_reqsize + v->digest_size * 2;
+	unsigned n_slices, per_slice;
+	int r;
+
+	/* FEC decoding keeps its state in the per-bio data */
+	if (!split_blocks || verity_fec_is_enabled(v))
+		return false;
+
+	n_slices = min(io->n_blocks / split_blocks, num_online_cpus());
+	if (n_slices < 2)
+		return false;
+	per_slice = DIV_ROUND_UP(io->n_blocks, n_slices);
+
+	atomic_set(&io->split_pending, 1);
+	io->split_error = 0;
+
+	while (io->n_blocks > per_slice) {
+		struct dm_verity_split_work *sw;
+
+		sw = kmalloc(size, GFP_NOIO | __GFP_NORETRY |
+			     __GFP_NOMEMALLOC | __GFP_NOWARN);
+		if (!sw)
+			break;
+
+		sw->parent = io;
+		sw->io.v = v;
+		sw->io.bio = io->bio;
+		sw->io.block = io->block;
+		sw->io.n_blocks = per_slice;
+		sw->io.iter = io->iter;
+
+		io->block += per_slice;
+		io->n_blocks -= per_slice;
+		bio_advance_iter(io->bio, &io->iter,
+				 per_slice << v->data_dev_block_bits);
+
+		atomic_inc(&io->split_pending);
+		INIT_WORK(&sw->work, verity_split_work);
+		queue_work(v->verify_wq, &sw->work);
+	}
+
+	/* The rest, which is everything if no work could be allocated */
+	r = verity_verify_io(io);
+	verity_split_done(io, r);
+
+	return true;
+}
+
 static void verity_work(struct work_struct *w)
 {
 	struct dm_verity_io *io = container_of(w, struct dm_verity_io, work);
 
+	if (verity_verify_split(io))
+		return;
+
 	verity_finish_io(io, errno_to_blk_status(verity_verify_io(io)));
 }
 
@@ -609,9 +726,43 @@ static void verity_prefetch_io(struct work_struct *work)
 	kfree(pw);
 }
 
+/*
+ * The readahead window of the verity device, in data blocks.
+ */
+static sector_t verity_readahead_blocks(struct dm_verity *v)
+{
+	struct mapped_device *md = dm_table_get_md(v->ti->table);
+	unsigned long ra_pages = dm_disk(md)->queue->backing_dev_info->ra_pages;
+
+	return ((sector_t)ra_pages << PAGE_SHIFT) >> v->data_dev_block_bits;
+}
+
 static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 {
 	struct dm_verity_prefetch_work *pw;
+	sector_t block = io->block;
+	sector_t end = io->block + io->n_blocks;
+
+	/*
+	 * A sequential stream is going to read the data blocks after this io
+	 * next, so get the hash blocks for the following readahead window too.
+	 * Whatever an earlier io of the stream already prefetched is skipped.
+	 */
+	if (block == READ_ONCE(v->next_block)) {
+		sector_t prefetched_end = READ_ONCE(v->prefetched_end);
+		sector_t ra_end = end + verity_readahead_blocks(v);
+
+		if (ra_end > v->data_blocks)
+			ra_end = v->data_blocks;
+		if (prefetched_end >= end && prefetched_end <= ra_end)
+			block = prefetched_end;
+		end = ra_end;
+		WRITE_ONCE(v->prefetched_end, end);
+	}
+	WRITE_ONCE(v->next_block, io->block + io->n_blocks);
+
+	if (block >= end)
+		return;
 
 	pw = kmalloc(sizeof(struct dm_verity_prefetch_work),
 		GFP_NOIO | __GFP_NORETRY | __GFP_NOMEMALLOC | __GFP_NOWARN);
@@ -621,8 +772,8 @@ static void verity_submit_prefetch(struct dm_verity *v, struct dm_verity_io *io)
 
 	INIT_WORK(&pw->work, verity_prefetch_io);
 	pw->v = v;
-	pw->block = io->block;
-	pw->n_blocks = io->n_blocks;
+	pw->block = block;
+	pw->n_blocks = end - block;
 	queue_work(v->verify_wq, &pw->work);
 }
 
@@ -656,6 +807,7 @@ static int verity_map(struct dm_target *ti, struct bio *bio)
 	io = dm_per_bio_data(bio, ti->per_io_data_size);
 	io->v = v;
 	io->orig_bi_end_io = bio->bi_end_io;
+	io->bio = bio;
 	io->block = bio->bi_iter.bi_sector >> (v->data_dev_block_bits - SECTOR_SHIFT);
 	io->n_blocks = bio->bi_iter.bi_size >> v->data_dev_block_bits;
 
@@ -64,6 +64,10 @@ struct dm_verity {
 
 	struct dm_verity_fec *fec;	/* forward error correction */
 	unsigned long *validated_blocks; /* bitset blocks validated */
+
+	/* unlocked hints for readahead of the hash tree */
+	sector_t next_block;	/* data block following the last io */
+	sector_t prefetched_end;/* hash tree prefetched up to this block */
 };
 
 struct dm_verity_io {
@@ -72,6 +76,9 @@ struct dm_verity_io {
 	/* original value of bio->bi_end_io */
 	bio_end_io_t *orig_bi_end_io;
 
+	/* the bio being verified, shared with any split works */
+	struct bio *bio;
+
 	sector_t block;
 	unsigned n_blocks;
 
@@ -79,6 +86,10 @@ struct dm_verity_io {
 
 	struct work_struct work;
 
+	/* split verification, see verity_verify_split() */
+	atomic_t split_pending;
+	int split_error;
+
 	/*
 	 * Three variably-size fields follow this struct:
 	 *
@@ -74,6 +74,10 @@ static bool devices_handle_discard_safely = false;
 module_param(devices_handle_discard_safely, bool, 0644);
 MODULE_PARM_DESC(devices_handle_discard_safely,
 		 "Set to Y if all devices in each array reliably return zeroes on reads from discarded regions");
+static unsigned int default_group_thread_cnt;
+module_param(default_group_thread_cnt, uint, 0644);
+MODULE_PARM_DESC(default_group_thread_cnt,
+		 "Initial group_thread_cnt of new arrays, 0 handles all stripes in raid5d");
 static struct workqueue_struct *raid5_wq;
 
 static inline struct hlist_head *stripe_hash(struct r5conf *conf, sector_t sect)
@@ -206,7 +210,8 @@ static void raid5_wakeup_stripe_thread(struct stripe_head *sh)
 	/* at least one worker should run to avoid race */
 	queue_work_on(sh->cpu, raid5_wq, &group->workers[0].work);
 
-	thread_cnt = group->stripes_cnt / MAX_STRIPE_BATCH - 1;
+	/* one worker per batch of stripes queued to the group */
+	thread_cnt = DIV_ROUND_UP(group->stripes_cnt, MAX_STRIPE_BATCH) - 1;
 	/* wakeup more workers */
 	for (i = 1; i < conf->worker_cnt_per_group && thread_cnt > 0; i++) {
 		if (group->workers[i].working == false) {
@@ -6921,8 +6926,9 @@ static struct r5conf *setup_conf(struct mddev *mddev)
 		goto abort;
 	for (i = 0; i < PENDING_IO_MAX; i++)
 		list_add(&conf->pending_data[i].sibling, &conf->free_list);
-	/* Don't enable multi-threading by default*/
-	if (!alloc_thread_groups(conf, 0, &group_cnt, &worker_cnt_per_group,
+	/* Don't enable multi-threading unless the module parameter says so */
+	if (!alloc_thread_groups(conf, min(default_group_thread_cnt, 8192U),
+				 &group_cnt, &worker_cnt_per_group,
 				 &new_group)) {
 		conf->group_cnt = group_cnt;
 		conf->worker_cnt_per_group = worker_cnt_per_group;
@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * vb2-latency.c - per-queue buffer latency histograms
+ *
+ * Hooks the vb2 tracepoints to time each buffer from VIDIOC_QBUF to the
+ * driver's buf_queue, from buf_queue to vb2_buffer_done() and from there
+ * to VIDIOC_DQBUF. The probes are only registered whilst
+ * /sys/kernel/debug/vb2/enable is set, so the tracepoints cost nothing the
+ * rest of the time. Each queue gets a directory under /sys/kernel/debug/vb2/
+ * from the first buffer allocation until vb2_core_queue_release(), which
+ * vb2_fop_release() calls each time the owning file handle is closed.
+ */
+
+#include <linux/atomic.h>
+#include <linux/debugfs.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/uaccess.h>
+
+#include <media/videobuf2-core.h>
+#include <trace/events/vb2.h>
+
+#include "vb2-latency.h"
+
+/*
+ * Bucket 0 holds intervals under 1us, bucket n holds [2^(n-1), 2^n) us and
+ * the last bucket everything from about one second upwards.
+ */
+#define VB2_LAT_BUCKETS		22
+
+enum vb2_latency_interval {
+	VB2_LAT_QUEUED,		/* QBUF to buf_queue */
+	VB2_LAT_DRIVER,		/* buf_queue to vb2_buffer_done() */
+	VB2_LAT_DEQUEUE,	/* vb2_buffer_done() to DQBUF */
+	VB2_LAT_TOTAL,		/* QBUF to DQBUF */
+	VB2_LAT_NUM
+};
+
+static const char * const vb2_latency_names[VB2_LAT_NUM] = {
+	[VB2_LAT_QUEUED]	= "qbuf-to-driver",
+	[VB2_LAT_DRIVER]	= "driver-to-done",
+	[VB2_LAT_DEQUEUE]	= "done-to-dqbuf",
+	[VB2_LAT_TOTAL]		= "qbuf-to-dqbuf",
+};
+
+struct vb2_latency_hist {
+	u64 count;
+	u64 sum_ns;
+	u64 min_ns;
+	u64 max_ns;
+	u32 buckets[VB2_LAT_BUCKETS];
+};
+
+struct vb2_latency {
+	struct dentry *dir;
+	/* protects hist, vb2_buffer_done() may run in interrupt context */
+	spinlock_t lock;
+	struct vb2_latency_hist hist[VB2_LAT_NUM];
+};
+
+static DEFINE_MUTEX(vb2_latency_mutex);
+static struct dentry *vb2_latency_root;
+static bool vb2_latency_enabled;
+static atomic_t vb2_latency_next_id = ATOMIC_INIT(0);
+
+static void vb2_latency_record(struct vb2_queue *q,
+			       enum vb2_latency_interval interval, u64 delta)
+{
+	struct vb2_latency *lat = q->latency;
+	struct vb2_latency_hist *hist;
+	unsigned long flags;
+	u64 us = div_u64(delta, NSEC_PER_USEC);
+	unsigned int bucket;
+
+	if (!lat)
+		return;
+
+	bucket = us ? min_t(unsigned int, ilog2(us) + 1,
+			    VB2_LAT_BUCKETS - 1) : 0;
+
+	spin_lock_irqsave(&lat->lock, flags);
+	hist = &lat->hist[interval];
+	if (!hist->count || delta < hist->min_ns)
+		hist->min_ns = delta;
+	if (delta > hist->max_ns)
+		hist->max_ns = delta;
+	hist->count++;
+	hist->sum_ns += delta;
+	hist->buckets[bucket]++;
+	spin_unlock_irqrestore(&lat->lock, flags);
+}
+
+static void vb2_latency_qbuf(void *data, struct vb2_queue *q,
+			     struct vb2_buffer *vb)
+{
+	vb->lat_qbuf_ns = ktime_get_ns();
+	vb->lat_queue_ns = 0;
+	vb->lat_done_ns = 0;
+}
+
+static void vb2_latency_buf_queue(void *data, struct vb2_queue *q,
+				  struct vb2_buffer *vb)
+{
+	u64 now = ktime_get_ns();
+
+	/* a buffer requeued by the driver keeps its first hand-off time */
+	if (vb->lat_queue_ns)
+		return;
+
+	if (vb->lat_qbuf_ns)
+		vb2_latency_record(q, VB2_LAT_QUEUED, now - vb->lat_qbuf_ns);
+	vb->lat_queue_ns = now;
+}
+
+static void vb2_latency_buf_done(void *data, struct vb2_queue *q,
+				 struct vb2_buffer *vb)
+{
+	u64 now = ktime_get_ns();
+
+	/* returned to the queued state rather than completed */
+	if (vb->state == VB2_BUF_STATE_QUEUED || !vb->lat_queue_ns)
+		return;
+
+	vb2_latency_record(q, VB2_LAT_DRIVER, now - vb->lat_queue_ns);
+	vb->lat_done_ns = now;
+}
+
+static void vb2_latency_dqbuf(void *data, struct vb2_queue *q,
+			      struct vb2_buffer *vb)
+{
+	u64 now = ktime_get_ns();
+
+	if (vb->lat_done_ns)
+		vb2_latency_record(q, VB2_LAT_DEQUEUE, now - vb->lat_done_ns);
+	if (vb->lat_qbuf_ns)
+		vb2_latency_record(q, VB2_LAT_TOTAL, now - vb->lat_qbuf_ns);
+
+	vb->lat_qbuf_ns = 0;
+	vb->lat_queue_ns = 0;
+	vb->lat_done_ns = 0;
+}
+
+static int vb2_latency_set_enabled(bool enable)
+{
+	int ret = 0;
+
+	mutex_lock(&vb2_latency_mutex);
+	if (enable == vb2_latency_enabled)
+		goto unlock;
+
+	if (enable) {
+		ret = register_trace_vb2_qbuf(vb2_latency_qbuf, NULL);
+		if (ret)
+			goto unlock;
+		ret = register_trace_vb2_buf_queue(vb2_latency_buf_queue, NULL);
+		if (ret)
+			goto unreg_qbuf;
+		ret = register_trace_vb2_buf_done(vb2_latency_buf_done, NULL);
+		if (ret)
+			goto unreg_buf_queue;
+		ret = register_trace_vb2_dqbuf(vb2_latency_dqbuf, NULL);
+		if (ret)
+			goto unreg_buf_done;
+		vb2_latency_enabled = true;
+		goto unlock;
+	}
+
+	unregister_trace_vb2_dqbuf(vb2_latency_dqbuf, NULL);
+unreg_buf_done:
+	unregister_trace_vb2_buf_done(vb2_latency_buf_done, NULL);
+unreg_buf_queue:
+	unregister_trace_vb2_buf_queue(vb2_latency_buf_queue, NULL);
+unreg_qbuf:
+	unregister_trace_vb2_qbuf(vb2_latency_qbuf, NULL);
+	tracepoint_synchronize_unregister();
+	if (!ret)
+		vb2_latency_enabled = false;
+unlock:
+	mutex_unlock(&vb2_latency_mutex);
+	return ret;
+}
+
+static ssize_t vb2_latency_enable_read(struct file *file, char __user *buf,
+				       size_t count, loff_t *ppos)
+{
+	char val[2] = { vb2_latency_enabled ? '1' : '0', '\n' };
+
+	return simple_read_from_buffer(buf, count, ppos, val, sizeof(val));
+}
+
+static ssize_t vb2_latency_enable_write(struct file *file,
+					const char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(buf, count, &enable);
+	if (ret)
+		return ret;
+
+	ret = vb2_latency_set_enabled(enable);
+	return ret ? ret : count;
+}
+
+static const struct file_operations vb2_latency_enable_fops = {
+	.owner = THIS_MODULE,
+	.read = vb2_latency_enable_read,
+	.write = vb2_latency_enable_write,
+	.llseek = default_llseek,
+};
+
+static int vb2_latency_show(struct seq_file *m, void *v)
+{
+	struct vb2_queue *q = m->private;
+	struct vb2_latency *lat = q->latency;
+	struct vb2_latency_hist hist;
+	unsigned long flags;
+	int i, j;
+
+	seq_printf(m, "type %u, %s, %u buffers\n", q->type,
+		   q->streaming ? "streaming" : "idle", q->num_buffers);
+
+	for (i = 0; i < VB2_LAT_NUM; i++) {
+		spin_lock_irqsave(&lat->lock, flags);
+		hist = lat->hist[i];
+		spin_unlock_irqrestore(&lat->lock, flags);
+
+		seq_printf(m, "\n%s: count %llu", vb2_latency_names[i],
+			   hist.count);
+		if (hist.count)
+			seq_printf(m, ", min %llu us, avg %llu us, max %llu us",
+				   div_u64(hist.min_ns, NSEC_PER_USEC),
+				   div64_u64(hist.sum_ns,
+					     hist.count * NSEC_PER_USEC),
+				   div_u64(hist.max_ns, NSEC_PER_USEC));
+		seq_puts(m, "\n");
+
+		for (j = 0; j < VB2_LAT_BUCKETS; j++)
+			seq_printf(m, "  >= %8lu us: %u\n",
+				   j ? 1UL << (j - 1) : 0UL, hist.buckets[j]);
+	}
+
+	return 0;
+}
+
+static int vb2_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, vb2_latency_show, inode->i_private);
+}
+
+static ssize_t vb2_latency_reset(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct vb2_queue *q = m->private;
+	unsigned long flags;
+
+	spin_lock_irqsave(&q->latency->lock, flags);
+	memset(q->latency->hist, 0, sizeof(q->latency->hist));
+	spin_unlock_irqrestore(&q->latency->lock, flags);
+
+	return count;
+}
+
+/* reading shows the histograms, any write clears them */
+static const struct file_operations vb2_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = vb2_latency_open,
+	.read = seq_read,
+	.write = vb2_latency_reset,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct dentry *vb2_latency_get_root(void)
+{
+	mutex_lock(&vb2_latency_mutex);
+	if (!vb2_latency_root) {
+		vb2_latency_root = debugfs_create_dir("vb2", NULL);
+		if (IS_ERR(vb2_latency_root))
+			vb2_latency_root = NULL;
+		else
+			debugfs_create_file("enable", 0644, vb2_latency_root,
+					    NULL, &vb2_latency_enable_fops);
+	}
+	mutex_unlock(&vb2_latency_mutex);
+
+	return vb2_latency_root;
+}
+
+void vb2_latency_queue_init(struct vb2_queue *q)
+{
+	struct dentry *root = vb2_latency_get_root();
+	struct vb2_latency *lat;
+	char name[48];
+
+	if (!root || q->latency)
+		return;
+
+	lat = kzalloc(sizeof(*lat), GFP_KERNEL);
+	if (!lat)
+		return;
+
+	spin_lock_init(&lat->lock);
+	snprintf(name, sizeof(name), "%s-%d",
+		 q->dev ? dev_name(q->dev) : "queue",
+		 atomic_inc_return(&vb2_latency_next_id));
+	lat->dir = debugfs_create_dir(name, root);
+	if (IS_ERR_OR_NULL(lat->dir)) {
+		kfree(lat);
+		return;
+	}
+	debugfs_create_file("histogram", 0644, lat->dir, q,
+			    &vb2_latency_fops);
+
+	q->latency = lat;
+}
+
+void vb2_latency_queue_release(struct vb2_queue *q)
+{
+	struct vb2_latency *lat = q->latency;
+
+	if (!lat)
+		return;
+
+	debugfs_remove_recursive(lat->dir);
+	q->latency = NULL;
+	kfree(lat);
+}
+
+static void __exit vb2_latency_exit(void)
+{
+	vb2_latency_set_enabled(false);
+	debugfs_remove_recursive(vb2_latency_root);
+}
+module_exit(vb2_latency_exit);
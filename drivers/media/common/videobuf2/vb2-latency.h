@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * vb2-latency.h - per-queue buffer latency histograms
+ */
+#ifndef _VB2_LATENCY_H
+#define _VB2_LATENCY_H
+
+#include <media/videobuf2-core.h>
+
+#ifdef CONFIG_VIDEOBUF2_LATENCY_HIST
+void vb2_latency_queue_init(struct vb2_queue *q);
+void vb2_latency_queue_release(struct vb2_queue *q);
+#else
+static inline void vb2_latency_queue_init(struct vb2_queue *q) {}
+static inline void vb2_latency_queue_release(struct vb2_queue *q) {}
+#endif
+
+#endif /* _VB2_LATENCY_H */
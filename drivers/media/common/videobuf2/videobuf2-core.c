@@ -31,6 +31,8 @@
 
 #include <trace/events/vb2.h>
 
+#include "vb2-latency.h"
+
 static int debug;
 module_param(debug, int, 0644);
 
@@ -342,6 +344,13 @@ static int __vb2_queue_alloc(struct vb2_queue *q, enum vb2_memory memory,
 	num_buffers = min_t(unsigned int, num_buffers,
 			    VB2_MAX_FRAME - q->num_buffers);
 
+	/*
+	 * The histograms are freed by vb2_core_queue_release() whenever the
+	 * owning file handle is closed, so (re)create them here rather than
+	 * once in vb2_core_queue_init().
+	 */
+	vb2_latency_queue_init(q);
+
 	for (buffer = 0; buffer < num_buffers; ++buffer) {
 		/* Allocate videobuf buffer structures */
 		vb = kzalloc(q->buf_struct_size, GFP_KERNEL);
@@ -2085,6 +2094,7 @@ void vb2_core_queue_release(struct vb2_queue *q)
 	mutex_lock(&q->mmap_lock);
 	__vb2_queue_free(q, q->num_buffers);
 	mutex_unlock(&q->mmap_lock);
+	vb2_latency_queue_release(q);
 }
 EXPORT_SYMBOL_GPL(vb2_core_queue_release);
 
@@ -21,6 +21,8 @@
 #include <linux/module.h>
 #include <linux/pm_runtime.h>
 #include <linux/regulator/consumer.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 #include <media/v4l2-ctrls.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-fwnode.h>
@@ -34,6 +36,11 @@
 #define IMX219_MODE_STANDBY		0x00
 #define IMX219_MODE_STREAMING		0x01
 
+#define IMX219_REG_GROUPED_HOLD		0x0104
+
+/* Most data bytes sent in one auto-incrementing register write */
+#define IMX219_MAX_BURST		32
+
 /* Chip ID */
 #define IMX219_REG_CHIP_ID		0x0000
 #define IMX219_CHIP_ID			0x0219
@@ -75,6 +82,12 @@
 #define IMX219_DGTL_GAIN_DEFAULT	0x0100
 #define IMX219_DGTL_GAIN_STEP		1
 
+/*
+ * Analogue gain, digital gain and exposure are contiguous, so all three can
+ * be written in a single auto-incrementing transfer starting at analogue gain.
+ */
+#define IMX219_REG_GAIN_EXPOSURE_LEN	5
+
 /* Test Pattern Control */
 #define IMX219_REG_TEST_PATTERN		0x0600
 #define IMX219_TEST_PATTERN_DISABLE	0
@@ -381,6 +394,23 @@ struct imx219 {
 	int power_count;
 	/* Streaming on/off */
 	bool streaming;
+	/*
+	 * Set between the stream on and stream off register writes. Unlike
+	 * streaming, it is clear whilst start_streaming (including from
+	 * resume) programs the sensor.
+	 */
+	bool sensor_streaming;
+
+	/*
+	 * Exposure and gains set whilst streaming are staged here and written
+	 * in one transfer by apply_work, so VIDIOC_S_EXT_CTRLS doesn't wait
+	 * for the I2C bus every frame.
+	 */
+	spinlock_t staged_lock;
+	struct work_struct apply_work;
+	u8 staged_again;
+	u16 staged_dgain;
+	u16 staged_exposure;
 };
 
 static inline struct imx219 *to_imx219(struct v4l2_subdev *_sd)
@@ -438,22 +468,31 @@ static int imx219_write_reg(struct imx219 *imx219, u16 reg, u32 len, u32 val)
 	return 0;
 }
 
-/* Write a list of registers */
+/*
+ * Write a list of registers, sending each run of consecutive addresses as a
+ * single auto-incrementing transfer.
+ */
 static int imx219_write_regs(struct imx219 *imx219,
 			     const struct imx219_reg *regs, u32 len)
 {
 	struct i2c_client *client = v4l2_get_subdevdata(&imx219->sd);
-	unsigned int i;
-	int ret;
+	u8 buf[2 + IMX219_MAX_BURST];
+	unsigned int i, n;
+
+	for (i = 0; i < len; i += n) {
+		put_unaligned_be16(regs[i].address, buf);
+		for (n = 0; i + n < len && n < IMX219_MAX_BURST; n++) {
+			if (regs[i + n].address != regs[i].address + n)
+				break;
+			buf[2 + n] = regs[i + n].val;
+		}
 
-	for (i = 0; i < len; i++) {
-		ret = imx219_write_reg(imx219, regs[i].address, 1, regs[i].val);
-		if (ret) {
+		if (i2c_master_send(client, buf, n + 2) != n + 2) {
 			dev_err_ratelimited(&client->dev,
-					    "Failed to write reg 0x%4.4x. error = %d\n",
-					    regs[i].address, ret);
+					    "Failed to write %u regs from 0x%4.4x\n",
+					    n, regs[i].address);
 
-			return ret;
+			return -EIO;
 		}
 	}
 
@@ -558,6 +597,77 @@ static int imx219_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 	return 0;
 }
 
+/*
+ * Write the staged exposure and gains in a single transfer, inside a grouped
+ * parameter hold so that they all take effect on the same frame.
+ */
+static void imx219_apply_work(struct work_struct *work)
+{
+	struct imx219 *imx219 = container_of(work, struct imx219, apply_work);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx219->sd);
+	u8 hold_on[3] = { IMX219_REG_GROUPED_HOLD >> 8,
+			  IMX219_REG_GROUPED_HOLD & 0xff, 1 };
+	u8 hold_off[3] = { IMX219_REG_GROUPED_HOLD >> 8,
+			   IMX219_REG_GROUPED_HOLD & 0xff, 0 };
+	u8 buf[2 + IMX219_REG_GAIN_EXPOSURE_LEN];
+	struct i2c_msg msgs[] = {
+		{ .addr = client->addr, .len = 3, .buf = hold_on },
+		{ .addr = client->addr, .len = sizeof(buf), .buf = buf },
+		{ .addr = client->addr, .len = 3, .buf = hold_off },
+	};
+	int ret;
+
+	if (pm_runtime_get_if_in_use(&client->dev) == 0)
+		return;
+
+	put_unaligned_be16(IMX219_REG_ANALOG_GAIN, buf);
+	spin_lock(&imx219->staged_lock);
+	buf[2] = imx219->staged_again;
+	put_unaligned_be16(imx219->staged_dgain, buf + 3);
+	put_unaligned_be16(imx219->staged_exposure, buf + 5);
+	spin_unlock(&imx219->staged_lock);
+
+	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
+	if (ret != ARRAY_SIZE(msgs))
+		dev_err_ratelimited(&client->dev,
+				    "Failed to write exposure and gains: %d\n",
+				    ret);
+
+	pm_runtime_put(&client->dev);
+}
+
+/*
+ * Stage exposure and gain values. Returns true if the write has been left to
+ * apply_work, which is only done once the sensor is streaming so that
+ * __v4l2_ctrl_handler_setup() still programs the sensor before stream on.
+ */
+static bool imx219_stage_ctrl(struct imx219 *imx219, struct v4l2_ctrl *ctrl)
+{
+	spin_lock(&imx219->staged_lock);
+	switch (ctrl->id) {
+	case V4L2_CID_ANALOGUE_GAIN:
+		imx219->staged_again = ctrl->val;
+		break;
+	case V4L2_CID_DIGITAL_GAIN:
+		imx219->staged_dgain = ctrl->val;
+		break;
+	case V4L2_CID_EXPOSURE:
+		imx219->staged_exposure = ctrl->val;
+		break;
+	default:
+		spin_unlock(&imx219->staged_lock);
+		return false;
+	}
+	spin_unlock(&imx219->staged_lock);
+
+	if (!imx219->sensor_streaming)
+		return false;
+
+	/* several controls set together are coalesced into one write */
+	queue_work(system_highpri_wq, &imx219->apply_work);
+	return true;
+}
+
 static int imx219_set_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct imx219 *imx219 =
@@ -565,6 +675,9 @@ static int imx219_set_ctrl(struct v4l2_ctrl *ctrl)
 	struct i2c_client *client = v4l2_get_subdevdata(&imx219->sd);
 	int ret = 0;
 
+	if (imx219_stage_ctrl(imx219, ctrl))
+		return 0;
+
 	/*
 	 * Applying V4L2 control value only happens
 	 * when power is up for streaming
@@ -734,8 +847,14 @@ static int imx219_start_streaming(struct imx219 *imx219)
 		return ret;
 
 	/* set stream on register */
-	return imx219_write_reg(imx219, IMX219_REG_MODE_SELECT,
-				IMX219_REG_VALUE_08BIT, IMX219_MODE_STREAMING);
+	ret = imx219_write_reg(imx219, IMX219_REG_MODE_SELECT,
+			       IMX219_REG_VALUE_08BIT, IMX219_MODE_STREAMING);
+	if (ret)
+		return ret;
+
+	imx219->sensor_streaming = true;
+
+	return 0;
 }
 
 /* Stop streaming */
@@ -744,6 +863,10 @@ static int imx219_stop_streaming(struct imx219 *imx219)
 	struct i2c_client *client = v4l2_get_subdevdata(&imx219->sd);
 	int ret;
 
+	/* stop staging, and let any staged exposure and gains land first */
+	imx219->sensor_streaming = false;
+	flush_work(&imx219->apply_work);
+
 	/* set stream off register */
 	ret = imx219_write_reg(imx219, IMX219_REG_MODE_SELECT,
 			       IMX219_REG_VALUE_08BIT, IMX219_MODE_STANDBY);
@@ -916,6 +1039,8 @@ static int imx219_init_controls(struct imx219 *imx219)
 
 	mutex_init(&imx219->mutex);
 	ctrl_hdlr->lock = &imx219->mutex;
+	spin_lock_init(&imx219->staged_lock);
+	INIT_WORK(&imx219->apply_work, imx219_apply_work);
 
 	imx219->exposure = v4l2_ctrl_new_std(ctrl_hdlr, &imx219_ctrl_ops,
 					     V4L2_CID_EXPOSURE,
@@ -957,6 +1082,7 @@ static int imx219_init_controls(struct imx219 *imx219)
 
 static void imx219_free_controls(struct imx219 *imx219)
 {
+	cancel_work_sync(&imx219->apply_work);
 	v4l2_ctrl_handler_free(imx219->sd.ctrl_handler);
 	mutex_destroy(&imx219->mutex);
 }
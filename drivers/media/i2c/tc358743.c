@@ -94,6 +94,15 @@ struct tc358743_state {
 	u32 mbus_fmt_code;
 	u8 csi_lanes_in_use;
 
+	/*
+	 * Detected timings, read once and then reused until an HDMI interrupt
+	 * says they may have changed
+	 */
+	struct mutex detect_mutex;
+	struct v4l2_dv_timings detected_timings;
+	int detected_ret;
+	bool detected_valid;
+
 	struct gpio_desc *reset_gpio;
 
 	struct cec_adapter *cec_adap;
@@ -318,19 +327,25 @@ static inline unsigned fps(const struct v4l2_bt_timings *t)
 			V4L2_DV_BT_FRAME_HEIGHT(t) * V4L2_DV_BT_FRAME_WIDTH(t));
 }
 
-static int tc358743_get_detected_timings(struct v4l2_subdev *sd,
+#define TC358743_SIZE_REG(regs, lo)	((regs)[(lo) - DE_WIDTH_H_LO] | \
+					 (regs)[(lo) + 1 - DE_WIDTH_H_LO] << 8)
+
+static int tc358743_read_detected_timings(struct v4l2_subdev *sd,
 				     struct v4l2_dv_timings *timings)
 {
 	struct v4l2_bt_timings *bt = &timings->bt;
 	unsigned width, height, frame_width, frame_height, frame_interval, fps;
+	u8 sys_status = i2c_rd8(sd, SYS_STATUS);
+	u8 regs[V_SIZE_HI - DE_WIDTH_H_LO + 1];
+	u8 fv_cnt[2];
 
 	memset(timings, 0, sizeof(struct v4l2_dv_timings));
 
-	if (no_signal(sd)) {
+	if (!(sys_status & MASK_S_TMDS)) {
 		v4l2_dbg(1, debug, sd, "%s: no valid signal\n", __func__);
 		return -ENOLINK;
 	}
-	if (no_sync(sd)) {
+	if (!(sys_status & MASK_S_SYNC)) {
 		v4l2_dbg(1, debug, sd, "%s: no sync on signal\n", __func__);
 		return -ENOLCK;
 	}
@@ -339,18 +354,18 @@ static int tc358743_get_detected_timings(struct v4l2_subdev *sd,
 	bt->interlaced = i2c_rd8(sd, VI_STATUS1) & MASK_S_V_INTERLACE ?
 		V4L2_DV_INTERLACED : V4L2_DV_PROGRESSIVE;
 
-	width = ((i2c_rd8(sd, DE_WIDTH_H_HI) & 0x1f) << 8) +
-		i2c_rd8(sd, DE_WIDTH_H_LO);
-	height = ((i2c_rd8(sd, DE_WIDTH_V_HI) & 0x1f) << 8) +
-		i2c_rd8(sd, DE_WIDTH_V_LO);
-	frame_width = ((i2c_rd8(sd, H_SIZE_HI) & 0x1f) << 8) +
-		i2c_rd8(sd, H_SIZE_LO);
-	frame_height = (((i2c_rd8(sd, V_SIZE_HI) & 0x3f) << 8) +
-		i2c_rd8(sd, V_SIZE_LO)) / 2;
+	/* The size registers are contiguous, fetch them in one transfer */
+	if (i2c_rd(sd, DE_WIDTH_H_LO, regs, sizeof(regs)) ||
+	    i2c_rd(sd, FV_CNT_LO, fv_cnt, sizeof(fv_cnt)))
+		return -EIO;
+
+	width = TC358743_SIZE_REG(regs, DE_WIDTH_H_LO) & 0x1fff;
+	height = TC358743_SIZE_REG(regs, DE_WIDTH_V_LO) & 0x1fff;
+	frame_width = TC358743_SIZE_REG(regs, H_SIZE_LO) & 0x1fff;
+	frame_height = (TC358743_SIZE_REG(regs, V_SIZE_LO) & 0x3fff) / 2;
 	/* frame interval in milliseconds * 10
 	 * Require SYS_FREQ0 and SYS_FREQ1 are precisely set */
-	frame_interval = ((i2c_rd8(sd, FV_CNT_HI) & 0x3) << 8) +
-		i2c_rd8(sd, FV_CNT_LO);
+	frame_interval = ((fv_cnt[1] & 0x3) << 8) + fv_cnt[0];
 	fps = (frame_interval > 0) ?
 		DIV_ROUND_CLOSEST(10000, frame_interval) : 0;
 
@@ -368,6 +383,35 @@ static int tc358743_get_detected_timings(struct v4l2_subdev *sd,
 	return 0;
 }
 
+static int tc358743_get_detected_timings(struct v4l2_subdev *sd,
+				     struct v4l2_dv_timings *timings)
+{
+	struct tc358743_state *state = to_state(sd);
+	int ret;
+
+	mutex_lock(&state->detect_mutex);
+	if (!state->detected_valid) {
+		state->detected_ret = tc358743_read_detected_timings(sd,
+						&state->detected_timings);
+		/* don't cache a failed read, try again next time */
+		state->detected_valid = state->detected_ret != -EIO;
+	}
+	*timings = state->detected_timings;
+	ret = state->detected_ret;
+	mutex_unlock(&state->detect_mutex);
+
+	return ret;
+}
+
+static void tc358743_invalidate_detected_timings(struct v4l2_subdev *sd)
+{
+	struct tc358743_state *state = to_state(sd);
+
+	mutex_lock(&state->detect_mutex);
+	state->detected_valid = false;
+	mutex_unlock(&state->detect_mutex);
+}
+
 /* --------------- HOTPLUG / HDCP / EDID --------------- */
 
 static void tc358743_delayed_work_enable_hotplug(struct work_struct *work)
@@ -995,6 +1039,35 @@ static void tc358743_cec_isr(struct v4l2_subdev *sd, u16 intstatus,
 
 /* --------------- IRQ --------------- */
 
+/*
+ * A source that only changes frame rate (e.g. 1080p50 -> 1080p60) keeps the
+ * same active area. As long as the CSI lanes already in use can carry the new
+ * rate, adopt the new timings without stopping the stream, so the receiver
+ * carries on into the buffers it has already allocated.
+ */
+static bool tc358743_relock_same_size(struct v4l2_subdev *sd,
+				      const struct v4l2_dv_timings *timings)
+{
+	struct tc358743_state *state = to_state(sd);
+	struct v4l2_dv_timings old = state->timings;
+
+	if (!old.bt.width || old.bt.width != timings->bt.width ||
+	    old.bt.height != timings->bt.height ||
+	    old.bt.interlaced != timings->bt.interlaced)
+		return false;
+
+	if (!v4l2_valid_dv_timings(timings, &tc358743_timings_cap, NULL, NULL))
+		return false;
+
+	state->timings = *timings;
+	if (tc358743_num_csi_lanes_needed(sd) > state->csi_lanes_in_use) {
+		state->timings = old;
+		return false;
+	}
+
+	return true;
+}
+
 static void tc358743_format_change(struct v4l2_subdev *sd)
 {
 	struct tc358743_state *state = to_state(sd);
@@ -1010,8 +1083,16 @@ static void tc358743_format_change(struct v4l2_subdev *sd)
 		v4l2_dbg(1, debug, sd, "%s: No signal\n",
 				__func__);
 	} else {
-		if (!v4l2_match_dv_timings(&state->timings, &timings, 0, false))
+		if (!v4l2_match_dv_timings(&state->timings, &timings, 0,
+					   false)) {
+			if (tc358743_relock_same_size(sd, &timings)) {
+				v4l2_dbg(1, debug, sd,
+					 "%s: frame rate change only\n",
+					 __func__);
+				return;
+			}
 			enable_stream(sd, false);
+		}
 
 		if (debug)
 			v4l2_print_dv_timings(sd->name,
@@ -1432,6 +1513,11 @@ static int tc358743_isr(struct v4l2_subdev *sd, u32 status, bool *handled)
 		u8 hdmi_int0 = i2c_rd8(sd, HDMI_INT0);
 		u8 hdmi_int1 = i2c_rd8(sd, HDMI_INT1);
 
+		/* any change in the HDMI input may leave the cache stale */
+		if (hdmi_int0 & MASK_I_MISC ||
+		    hdmi_int1 & (MASK_I_CLK | MASK_I_SYS))
+			tc358743_invalidate_detected_timings(sd);
+
 		if (hdmi_int0 & MASK_I_MISC)
 			tc358743_hdmi_misc_int_handler(sd, handled);
 		if (hdmi_int1 & MASK_I_CBIT)
@@ -2137,6 +2223,7 @@ static int tc358743_probe(struct i2c_client *client,
 		goto err_hdl;
 
 	mutex_init(&state->confctl_mutex);
+	mutex_init(&state->detect_mutex);
 
 	INIT_DELAYED_WORK(&state->delayed_work_enable_hotplug,
 			tc358743_delayed_work_enable_hotplug);
@@ -2203,6 +2290,7 @@ static int tc358743_probe(struct i2c_client *client,
 		flush_work(&state->work_i2c_poll);
 	cancel_delayed_work(&state->delayed_work_enable_hotplug);
 	mutex_destroy(&state->confctl_mutex);
+	mutex_destroy(&state->detect_mutex);
 err_hdl:
 	media_entity_cleanup(&sd->entity);
 	v4l2_ctrl_handler_free(&state->hdl);
@@ -2223,6 +2311,7 @@ static int tc358743_remove(struct i2c_client *client)
 	v4l2_async_unregister_subdev(sd);
 	v4l2_device_unregister_subdev(sd);
 	mutex_destroy(&state->confctl_mutex);
+	mutex_destroy(&state->detect_mutex);
 	media_entity_cleanup(&sd->entity);
 	v4l2_ctrl_handler_free(&state->hdl);
 
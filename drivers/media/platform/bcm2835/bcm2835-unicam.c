@@ -55,6 +55,7 @@
  */
 
 #include <linux/clk.h>
+#include <linux/completion.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/err.h>
@@ -119,6 +120,17 @@ MODULE_PARM_DESC(debug, "Debug level 0-3");
 /* Define a nominal minimum image size */
 #define MIN_WIDTH	16
 #define MIN_HEIGHT	16
+
+/*
+ * Size of the buffers used for the sensor embedded data stream, and the
+ * number of embedded data lines the hardware is asked to capture. This is
+ * sufficient for the register dump lines emitted by the supported Sony and
+ * Omnivision sensors.
+ */
+#define UNICAM_EMBEDDED_SIZE	16384
+#define UNICAM_EMBEDDED_LINES	2
+/* How long to wait for the receiver to move off the embedded data buffers */
+#define UNICAM_EMBEDDED_STOP_MS	1000
 /*
  * Whilst Unicam doesn't require any additional padding on the image
  * height, various other parts of the BCM283x frameworks require a multiple
@@ -433,6 +445,40 @@ struct unicam_device {
 	struct mutex lock;
 	/* Flag to denote that we are processing buffers */
 	int streaming;
+
+	/*
+	 * Frame statistics for the current stream, reported through
+	 * VIDIOC_LOG_STATUS. Only updated from the ISR.
+	 */
+	unsigned int frames_captured;
+	/* Frames overwritten as no new buffer had been programmed in time */
+	unsigned int frames_dropped;
+	/* Frames where the next buffer was only armed at frame start */
+	unsigned int late_schedules;
+
+	/* Embedded data (metadata) capture node */
+	struct video_device embedded_dev;
+	struct media_pad embedded_pad;
+	struct vb2_queue embedded_queue;
+	/* Queue of empty embedded data buffers, protected by dma_queue_lock */
+	struct unicam_dmaqueue embedded_dma_queue;
+	struct unicam_buffer *embedded_cur_frm;
+	struct unicam_buffer *embedded_next_frm;
+	/* lock used to access the embedded data node */
+	struct mutex embedded_lock;
+	/* The embedded data queue is streaming */
+	int embedded_streaming;
+	/* The hardware is writing embedded data into embedded_cur_frm */
+	int embedded_active;
+	/*
+	 * Frame starts left until the data buffer pointers parked on
+	 * embedded_scratch are known to be latched by the hardware.
+	 */
+	int embedded_stopping;
+	struct completion embedded_stopped;
+	/* Written by the hardware while the embedded data queue is stopping */
+	void *embedded_scratch;
+	dma_addr_t embedded_scratch_addr;
 };
 
 /* Hardware access */
@@ -674,6 +720,47 @@ static inline void unicam_schedule_next_buffer(struct unicam_device *dev)
 	unicam_wr_dma_addr(dev, addr);
 }
 
+static void unicam_wr_embedded_dma_addr(struct unicam_device *dev,
+					unsigned int dmaaddr)
+{
+	reg_write(&dev->cfg, UNICAM_DBSA0, dmaaddr);
+	reg_write(&dev->cfg, UNICAM_DBEA0, dmaaddr + UNICAM_EMBEDDED_SIZE);
+}
+
+static inline void unicam_schedule_next_embedded(struct unicam_device *dev)
+{
+	struct unicam_dmaqueue *dma_q = &dev->embedded_dma_queue;
+	struct unicam_buffer *buf;
+	dma_addr_t addr;
+
+	buf = list_entry(dma_q->active.next, struct unicam_buffer, list);
+	dev->embedded_next_frm = buf;
+	list_del(&buf->list);
+
+	addr = vb2_dma_contig_plane_dma_addr(&buf->vb.vb2_buf, 0);
+	unicam_wr_embedded_dma_addr(dev, addr);
+}
+
+/*
+ * Embedded data buffers are returned with the same sequence number and
+ * timestamp as the image frame they were received with. If no new embedded
+ * buffer was available the data is overwritten, as for image frames.
+ */
+static inline void unicam_process_embedded_complete(struct unicam_device *dev)
+{
+	struct unicam_buffer *buf = dev->embedded_cur_frm;
+
+	if (buf == dev->embedded_next_frm)
+		return;
+
+	buf->vb.field = V4L2_FIELD_NONE;
+	buf->vb.sequence = dev->sequence;
+	buf->vb.vb2_buf.timestamp = dev->cur_frm->vb.vb2_buf.timestamp;
+
+	vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
+	dev->embedded_cur_frm = dev->embedded_next_frm;
+}
+
 static inline void unicam_process_buffer_complete(struct unicam_device *dev)
 {
 	dev->cur_frm->vb.field = dev->m_fmt.field;
@@ -681,6 +768,33 @@ static inline void unicam_process_buffer_complete(struct unicam_device *dev)
 
 	vb2_buffer_done(&dev->cur_frm->vb.vb2_buf, VB2_BUF_STATE_DONE);
 	dev->cur_frm = dev->next_frm;
+	dev->frames_captured++;
+}
+
+/*
+ * The frame that has just ended was written into a buffer that is still
+ * being reused, as no other buffer was available when the hardware latched
+ * the next address. Account for it and bump the sequence number so that
+ * userspace can see the gap.
+ */
+static inline void unicam_process_buffer_dropped(struct unicam_device *dev)
+{
+	dev->sequence++;
+	dev->frames_dropped++;
+}
+
+/*
+ * Signal V4L2_EVENT_FRAME_SYNC to any listeners, carrying the sequence
+ * number that the frame being started will be returned with.
+ */
+static void unicam_queue_frame_sync(struct unicam_device *dev)
+{
+	struct v4l2_event event = {
+		.type = V4L2_EVENT_FRAME_SYNC,
+		.u.frame_sync.frame_sequence = dev->sequence,
+	};
+
+	v4l2_event_queue(&dev->video_dev, &event);
 }
 
 /*
@@ -697,6 +811,7 @@ static irqreturn_t unicam_isr(int irq, void *dev)
 	struct unicam_cfg *cfg = &unicam->cfg;
 	struct unicam_dmaqueue *dma_q = &unicam->dma_queue;
 	int ista, sta;
+	u64 ts;
 
 	/*
 	 * Don't service interrupts if not streaming.
@@ -707,6 +822,13 @@ static irqreturn_t unicam_isr(int irq, void *dev)
 	if (!unicam->streaming)
 		return IRQ_HANDLED;
 
+	/*
+	 * Unicam has no hardware timestamp, so sample the time before
+	 * touching any registers to keep it as close as possible to the
+	 * interrupt being raised.
+	 */
+	ts = ktime_get_ns();
+
 	sta = reg_read(cfg, UNICAM_STA);
 	/* Write value back to clear the interrupts */
 	reg_write(cfg, UNICAM_STA, sta);
@@ -718,29 +840,65 @@ static irqreturn_t unicam_isr(int irq, void *dev)
 	if (!(sta && (UNICAM_IS | UNICAM_PI0)))
 		return IRQ_HANDLED;
 
-	if (ista & UNICAM_FSI) {
-		/*
-		 * Timestamp is to be when the first data byte was captured,
-		 * aka frame start.
-		 */
-		if (unicam->cur_frm)
-			unicam->cur_frm->vb.vb2_buf.timestamp = ktime_get_ns();
-	}
 	if (ista & UNICAM_FEI || sta & UNICAM_PI0) {
 		/*
 		 * Ensure we have swapped buffers already as we can't
 		 * stop the peripheral. Overwrite the frame we've just
 		 * captured instead.
 		 */
+		if (unicam->cur_frm) {
+			spin_lock(&unicam->dma_queue_lock);
+			if (unicam->embedded_active &&
+			    !unicam->embedded_stopping)
+				unicam_process_embedded_complete(unicam);
+			spin_unlock(&unicam->dma_queue_lock);
+		}
 		if (unicam->cur_frm && unicam->cur_frm != unicam->next_frm)
 			unicam_process_buffer_complete(unicam);
+		else if (unicam->cur_frm)
+			unicam_process_buffer_dropped(unicam);
 	}
 
+	/*
+	 * Frame start is handled after frame end, as if both are pending the
+	 * frame end belongs to the previous frame.
+	 */
+	if (ista & UNICAM_FSI) {
+		/*
+		 * Timestamp is to be when the first data byte was captured,
+		 * aka frame start.
+		 */
+		if (unicam->cur_frm)
+			unicam->cur_frm->vb.vb2_buf.timestamp = ts;
+		unicam_queue_frame_sync(unicam);
+
+		spin_lock(&unicam->dma_queue_lock);
+		if (unicam->embedded_stopping &&
+		    !--unicam->embedded_stopping)
+			complete(&unicam->embedded_stopped);
+		spin_unlock(&unicam->dma_queue_lock);
+	}
+
+	/*
+	 * The hardware only has a single shadowed buffer address, which is
+	 * latched at frame start. It must not be written at frame end, as the
+	 * buffer armed during the previous frame is still sitting unlatched
+	 * in the shadow registers at that point. Arm the next buffer on the
+	 * line interrupt part way through the frame, or at frame start as a
+	 * last resort.
+	 */
 	if (ista & (UNICAM_FSI | UNICAM_LCI)) {
 		spin_lock(&unicam->dma_queue_lock);
 		if (!list_empty(&dma_q->active) &&
-		    unicam->cur_frm == unicam->next_frm)
+		    unicam->cur_frm == unicam->next_frm) {
 			unicam_schedule_next_buffer(unicam);
+			if (!(ista & UNICAM_LCI))
+				unicam->late_schedules++;
+		}
+		if (unicam->embedded_active && !unicam->embedded_stopping &&
+		    !list_empty(&unicam->embedded_dma_queue.active) &&
+		    unicam->embedded_cur_frm == unicam->embedded_next_frm)
+			unicam_schedule_next_embedded(unicam);
 		spin_unlock(&unicam->dma_queue_lock);
 	}
 
@@ -1054,6 +1212,9 @@ static void unicam_buffer_queue(struct vb2_buffer *vb)
 	struct unicam_dmaqueue *dma_queue = &dev->dma_queue;
 	unsigned long flags = 0;
 
+	if (vb->vb2_queue == &dev->embedded_queue)
+		dma_queue = &dev->embedded_dma_queue;
+
 	/* recheck locking */
 	spin_lock_irqsave(&dev->dma_queue_lock, flags);
 	list_add_tail(&buf->list, &dma_queue->active);
@@ -1277,10 +1438,24 @@ static void unicam_start_rx(struct unicam_device *dev, unsigned long addr)
 	unicam_set_packing_config(dev);
 	unicam_cfg_image_id(dev);
 
-	/* Disabled embedded data */
-	val = 0;
-	set_field(&val, 0, UNICAM_EDL_MASK);
-	reg_write(cfg, UNICAM_DCS, val);
+	if (dev->embedded_active) {
+		/*
+		 * Packets that don't match the image data type are written to
+		 * the data buffer. Don't wrap at the end of it.
+		 */
+		struct vb2_buffer *vb = &dev->embedded_cur_frm->vb.vb2_buf;
+
+		unicam_wr_embedded_dma_addr(dev,
+					    vb2_dma_contig_plane_dma_addr(vb, 0));
+		val = 0;
+		set_field(&val, UNICAM_EMBEDDED_LINES, UNICAM_EDL_MASK);
+		reg_write(cfg, UNICAM_DCS, val);
+	} else {
+		/* Disabled embedded data */
+		val = 0;
+		set_field(&val, 0, UNICAM_EDL_MASK);
+		reg_write(cfg, UNICAM_DCS, val);
+	}
 
 	val = reg_read(cfg, UNICAM_MISC);
 	set_field(&val, 1, UNICAM_FL0);
@@ -1293,6 +1468,10 @@ static void unicam_start_rx(struct unicam_device *dev, unsigned long addr)
 	/* Load image pointers */
 	reg_write_field(cfg, UNICAM_ICTL, 1, UNICAM_LIP_MASK);
 
+	/* Load data pointers */
+	if (dev->embedded_active)
+		reg_write_field(cfg, UNICAM_DCS, 1, UNICAM_LDP);
+
 	/*
 	 * Enable trigger only for the first frame to
 	 * sync correctly to the FS from the source.
@@ -1331,6 +1510,26 @@ static void unicam_disable(struct unicam_device *dev)
 	clk_write(cfg, 0);
 }
 
+/*
+ * Hand the embedded data buffers owned by the hardware back to the embedded
+ * data queue once the receiver has stopped. They are returned to userspace
+ * when that queue is stopped. Must be called with dma_queue_lock held.
+ */
+static void unicam_release_embedded_buffers(struct unicam_device *dev)
+{
+	struct list_head *active = &dev->embedded_dma_queue.active;
+
+	if (!dev->embedded_active)
+		return;
+
+	if (dev->embedded_cur_frm != dev->embedded_next_frm)
+		list_add(&dev->embedded_next_frm->list, active);
+	list_add(&dev->embedded_cur_frm->list, active);
+	dev->embedded_cur_frm = NULL;
+	dev->embedded_next_frm = NULL;
+	dev->embedded_active = 0;
+}
+
 static int unicam_start_streaming(struct vb2_queue *vq, unsigned int count)
 {
 	struct unicam_device *dev = vb2_get_drv_priv(vq);
@@ -1345,10 +1544,27 @@ static int unicam_start_streaming(struct vb2_queue *vq, unsigned int count)
 	dev->cur_frm = buf;
 	dev->next_frm = buf;
 	list_del(&buf->list);
+
+	/*
+	 * Embedded data is only captured if its queue was started before the
+	 * image queue.
+	 */
+	if (dev->embedded_streaming &&
+	    !list_empty(&dev->embedded_dma_queue.active)) {
+		buf = list_entry(dev->embedded_dma_queue.active.next,
+				 struct unicam_buffer, list);
+		dev->embedded_cur_frm = buf;
+		dev->embedded_next_frm = buf;
+		list_del(&buf->list);
+		dev->embedded_active = 1;
+	}
 	spin_unlock_irqrestore(&dev->dma_queue_lock, flags);
 
 	addr = vb2_dma_contig_plane_dma_addr(&dev->cur_frm->vb.vb2_buf, 0);
 	dev->sequence = 0;
+	dev->frames_captured = 0;
+	dev->frames_dropped = 0;
+	dev->late_schedules = 0;
 
 	ret = unicam_runtime_get(dev);
 	if (ret < 0) {
@@ -1409,10 +1625,14 @@ static int unicam_start_streaming(struct vb2_queue *vq, unsigned int count)
 
 err_disable_unicam:
 	unicam_disable(dev);
+	dev->streaming = 0;
 	clk_disable_unprepare(dev->clock);
 err_pm_put:
 	unicam_runtime_put(dev);
 err_release_buffers:
+	spin_lock_irqsave(&dev->dma_queue_lock, flags);
+	unicam_release_embedded_buffers(dev);
+	spin_unlock_irqrestore(&dev->dma_queue_lock, flags);
 	list_for_each_entry_safe(buf, tmp, &dma_q->active, list) {
 		list_del(&buf->list);
 		vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_QUEUED);
@@ -1438,6 +1658,7 @@ static void unicam_stop_streaming(struct vb2_queue *vq)
 		unicam_err(dev, "stream off failed in subdev\n");
 
 	unicam_disable(dev);
+	dev->streaming = 0;
 
 	/* Release all active buffers */
 	spin_lock_irqsave(&dev->dma_queue_lock, flags);
@@ -1455,6 +1676,12 @@ static void unicam_stop_streaming(struct vb2_queue *vq)
 	}
 	dev->cur_frm = NULL;
 	dev->next_frm = NULL;
+	unicam_release_embedded_buffers(dev);
+	/* The receiver is off, so an embedded data stop need not wait */
+	if (dev->embedded_stopping) {
+		dev->embedded_stopping = 0;
+		complete(&dev->embedded_stopped);
+	}
 	spin_unlock_irqrestore(&dev->dma_queue_lock, flags);
 
 	clk_disable_unprepare(dev->clock);
@@ -1704,6 +1931,8 @@ static int unicam_subscribe_event(struct v4l2_fh *fh,
 				  const struct v4l2_event_subscription *sub)
 {
 	switch (sub->type) {
+	case V4L2_EVENT_FRAME_SYNC:
+		return v4l2_event_subscribe(fh, sub, 2, NULL);
 	case V4L2_EVENT_SOURCE_CHANGE:
 		return v4l2_event_subscribe(fh, sub, 4, NULL);
 	}
@@ -1738,6 +1967,10 @@ static int unicam_log_status(struct file *file, void *fh)
 		    reg_read(cfg, UNICAM_IVSTA));
 	unicam_info(dev, "Write pointer:       %08x\n",
 		    reg_read(cfg, UNICAM_IBWP));
+	unicam_info(dev, "----Frame statistics----\n");
+	unicam_info(dev, "Frames captured:     %u\n", dev->frames_captured);
+	unicam_info(dev, "Frames dropped:      %u\n", dev->frames_dropped);
+	unicam_info(dev, "Late buffer arming:  %u\n", dev->late_schedules);
 
 	return 0;
 }
@@ -1767,6 +2000,125 @@ static const struct vb2_ops unicam_video_qops = {
 	.stop_streaming		= unicam_stop_streaming,
 };
 
+static int unicam_embedded_queue_setup(struct vb2_queue *vq,
+				       unsigned int *nbuffers,
+				       unsigned int *nplanes,
+				       unsigned int sizes[],
+				       struct device *alloc_devs[])
+{
+	unsigned int size = UNICAM_EMBEDDED_SIZE;
+
+	if (vq->num_buffers + *nbuffers < 3)
+		*nbuffers = 3 - vq->num_buffers;
+
+	if (*nplanes) {
+		if (sizes[0] < size)
+			return -EINVAL;
+		size = sizes[0];
+	}
+
+	*nplanes = 1;
+	sizes[0] = size;
+
+	return 0;
+}
+
+static int unicam_embedded_buffer_prepare(struct vb2_buffer *vb)
+{
+	struct unicam_device *dev = vb2_get_drv_priv(vb->vb2_queue);
+
+	if (vb2_plane_size(vb, 0) < UNICAM_EMBEDDED_SIZE) {
+		unicam_err(dev, "data will not fit into plane (%lu < %u)\n",
+			   vb2_plane_size(vb, 0), UNICAM_EMBEDDED_SIZE);
+		return -EINVAL;
+	}
+
+	vb2_set_plane_payload(vb, 0, UNICAM_EMBEDDED_SIZE);
+	return 0;
+}
+
+static void unicam_embedded_return_buffers(struct unicam_device *dev,
+					   enum vb2_buffer_state state)
+{
+	struct unicam_buffer *buf, *tmp;
+
+	list_for_each_entry_safe(buf, tmp, &dev->embedded_dma_queue.active,
+				 list) {
+		list_del(&buf->list);
+		vb2_buffer_done(&buf->vb.vb2_buf, state);
+	}
+}
+
+static int unicam_embedded_start_streaming(struct vb2_queue *vq,
+					   unsigned int count)
+{
+	struct unicam_device *dev = vb2_get_drv_priv(vq);
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&dev->dma_queue_lock, flags);
+	if (dev->streaming) {
+		/*
+		 * The data channel is configured when the receiver is
+		 * started, so embedded data can't be added to a running
+		 * image stream.
+		 */
+		unicam_embedded_return_buffers(dev, VB2_BUF_STATE_QUEUED);
+		ret = -EBUSY;
+	} else {
+		dev->embedded_streaming = 1;
+	}
+	spin_unlock_irqrestore(&dev->dma_queue_lock, flags);
+
+	if (ret)
+		unicam_err(dev, "embedded data must be started before the image stream\n");
+
+	return ret;
+}
+
+static void unicam_embedded_stop_streaming(struct vb2_queue *vq)
+{
+	struct unicam_device *dev = vb2_get_drv_priv(vq);
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->dma_queue_lock, flags);
+	dev->embedded_streaming = 0;
+	if (dev->embedded_active) {
+		/*
+		 * The image stream is still running. Stop it capturing
+		 * embedded data lines and point the data buffer at the
+		 * scratch buffer. The new pointers are only latched at a
+		 * frame start, and this may be racing with one, so wait for
+		 * two of them before handing the buffers back.
+		 */
+		reg_write_field(&dev->cfg, UNICAM_DCS, 0, UNICAM_EDL_MASK);
+		unicam_wr_embedded_dma_addr(dev, dev->embedded_scratch_addr);
+		reinit_completion(&dev->embedded_stopped);
+		dev->embedded_stopping = 2;
+		spin_unlock_irqrestore(&dev->dma_queue_lock, flags);
+
+		if (!wait_for_completion_timeout(&dev->embedded_stopped,
+				msecs_to_jiffies(UNICAM_EMBEDDED_STOP_MS)))
+			unicam_err(dev, "timed out stopping embedded data\n");
+
+		spin_lock_irqsave(&dev->dma_queue_lock, flags);
+		dev->embedded_stopping = 0;
+		unicam_release_embedded_buffers(dev);
+	}
+	unicam_embedded_return_buffers(dev, VB2_BUF_STATE_ERROR);
+	spin_unlock_irqrestore(&dev->dma_queue_lock, flags);
+}
+
+static const struct vb2_ops unicam_embedded_qops = {
+	.wait_prepare		= vb2_ops_wait_prepare,
+	.wait_finish		= vb2_ops_wait_finish,
+	.queue_setup		= unicam_embedded_queue_setup,
+	.buf_prepare		= unicam_embedded_buffer_prepare,
+	.buf_queue		= unicam_buffer_queue,
+	.start_streaming	= unicam_embedded_start_streaming,
+	.stop_streaming		= unicam_embedded_stop_streaming,
+};
+
 /*
  * unicam_open : This function is based on the v4l2_fh_open helper function.
  * It has been augmented to handle sensor subdevice power management,
@@ -1831,6 +2183,58 @@ static const struct v4l2_file_operations unicam_fops = {
 };
 
 /* unicam capture ioctl operations */
+static int unicam_enum_fmt_meta_cap(struct file *file, void *priv,
+				    struct v4l2_fmtdesc *f)
+{
+	if (f->index)
+		return -EINVAL;
+
+	f->pixelformat = V4L2_META_FMT_SENSOR_DATA;
+
+	return 0;
+}
+
+static int unicam_g_fmt_meta_cap(struct file *file, void *priv,
+				 struct v4l2_format *f)
+{
+	f->fmt.meta.dataformat = V4L2_META_FMT_SENSOR_DATA;
+	f->fmt.meta.buffersize = UNICAM_EMBEDDED_SIZE;
+
+	return 0;
+}
+
+/* unicam embedded data node file operations */
+static const struct v4l2_file_operations unicam_embedded_fops = {
+	.owner		= THIS_MODULE,
+	.open		= v4l2_fh_open,
+	.release	= vb2_fop_release,
+	.poll		= vb2_fop_poll,
+	.unlocked_ioctl	= video_ioctl2,
+	.mmap		= vb2_fop_mmap,
+};
+
+static const struct v4l2_ioctl_ops unicam_embedded_ioctl_ops = {
+	.vidioc_querycap		= unicam_querycap,
+	.vidioc_enum_fmt_meta_cap	= unicam_enum_fmt_meta_cap,
+	.vidioc_g_fmt_meta_cap		= unicam_g_fmt_meta_cap,
+	.vidioc_s_fmt_meta_cap		= unicam_g_fmt_meta_cap,
+	.vidioc_try_fmt_meta_cap	= unicam_g_fmt_meta_cap,
+
+	.vidioc_reqbufs			= vb2_ioctl_reqbufs,
+	.vidioc_create_bufs		= vb2_ioctl_create_bufs,
+	.vidioc_prepare_buf		= vb2_ioctl_prepare_buf,
+	.vidioc_querybuf		= vb2_ioctl_querybuf,
+	.vidioc_qbuf			= vb2_ioctl_qbuf,
+	.vidioc_dqbuf			= vb2_ioctl_dqbuf,
+	.vidioc_expbuf			= vb2_ioctl_expbuf,
+	.vidioc_streamon		= vb2_ioctl_streamon,
+	.vidioc_streamoff		= vb2_ioctl_streamoff,
+
+	.vidioc_log_status		= unicam_log_status,
+	.vidioc_subscribe_event		= v4l2_ctrl_subscribe_event,
+	.vidioc_unsubscribe_event	= v4l2_event_unsubscribe,
+};
+
 static const struct v4l2_ioctl_ops unicam_ioctl_ops = {
 	.vidioc_querycap		= unicam_querycap,
 	.vidioc_enum_fmt_vid_cap	= unicam_enum_fmt_vid_cap,
@@ -1896,6 +2300,74 @@ unicam_async_bound(struct v4l2_async_notifier *notifier,
 	return 0;
 }
 
+/*
+ * Register the metadata node that receives the sensor embedded data lines.
+ * It shares the CSI-2 receiver with the image node.
+ */
+static int unicam_register_embedded_node(struct unicam_device *unicam)
+{
+	struct video_device *vdev = &unicam->embedded_dev;
+	struct vb2_queue *q = &unicam->embedded_queue;
+	int ret;
+
+	mutex_init(&unicam->embedded_lock);
+	INIT_LIST_HEAD(&unicam->embedded_dma_queue.active);
+	init_completion(&unicam->embedded_stopped);
+
+	unicam->embedded_scratch =
+		dmam_alloc_coherent(&unicam->pdev->dev, UNICAM_EMBEDDED_SIZE,
+				    &unicam->embedded_scratch_addr, GFP_KERNEL);
+	if (!unicam->embedded_scratch)
+		return -ENOMEM;
+
+	q->type = V4L2_BUF_TYPE_META_CAPTURE;
+	q->io_modes = VB2_MMAP | VB2_DMABUF;
+	q->drv_priv = unicam;
+	q->ops = &unicam_embedded_qops;
+	q->mem_ops = &vb2_dma_contig_memops;
+	q->buf_struct_size = sizeof(struct unicam_buffer);
+	q->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+	q->lock = &unicam->embedded_lock;
+	q->min_buffers_needed = 2;
+	q->dev = &unicam->pdev->dev;
+
+	ret = vb2_queue_init(q);
+	if (ret) {
+		unicam_err(unicam, "vb2_queue_init() failed for embedded data\n");
+		return ret;
+	}
+
+	snprintf(vdev->name, sizeof(vdev->name), "%s-embedded",
+		 UNICAM_MODULE_NAME);
+	vdev->release = video_device_release_empty;
+	vdev->fops = &unicam_embedded_fops;
+	vdev->ioctl_ops = &unicam_embedded_ioctl_ops;
+	vdev->v4l2_dev = &unicam->v4l2_dev;
+	vdev->vfl_dir = VFL_DIR_RX;
+	vdev->queue = q;
+	vdev->lock = &unicam->embedded_lock;
+	vdev->device_caps = V4L2_CAP_META_CAPTURE | V4L2_CAP_STREAMING;
+	video_set_drvdata(vdev, unicam);
+
+	ret = video_register_device(vdev, VFL_TYPE_GRABBER, -1);
+	if (ret) {
+		unicam_err(unicam, "Unable to register embedded data device.\n");
+		return ret;
+	}
+
+	ret = media_create_pad_link(&unicam->sensor->entity, 0,
+				    &vdev->entity, 0,
+				    MEDIA_LNK_FL_ENABLED |
+				    MEDIA_LNK_FL_IMMUTABLE);
+	if (ret) {
+		unicam_err(unicam, "Unable to create embedded data pad link.\n");
+		video_unregister_device(vdev);
+		return ret;
+	}
+
+	return 0;
+}
+
 static int unicam_probe_complete(struct unicam_device *unicam)
 {
 	struct video_device *vdev;
@@ -2068,6 +2540,15 @@ static int unicam_probe_complete(struct unicam_device *unicam)
 		return ret;
 	}
 
+	/* Embedded data is only carried on CSI-2 */
+	if (unicam->bus_type == V4L2_MBUS_CSI2) {
+		ret = unicam_register_embedded_node(unicam);
+		if (ret) {
+			video_unregister_device(&unicam->video_dev);
+			return ret;
+		}
+	}
+
 	return 0;
 }
 
@@ -2279,6 +2760,9 @@ static int unicam_probe(struct platform_device *pdev)
 	unicam->mdev.hw_revision = 1;
 
 	media_entity_pads_init(&unicam->video_dev.entity, 1, &unicam->pad);
+	unicam->embedded_pad.flags = MEDIA_PAD_FL_SINK;
+	media_entity_pads_init(&unicam->embedded_dev.entity, 1,
+			       &unicam->embedded_pad);
 	media_device_init(&unicam->mdev);
 
 	unicam->v4l2_dev.mdev = &unicam->mdev;
@@ -2342,6 +2826,7 @@ static int unicam_remove(struct platform_device *pdev)
 	v4l2_ctrl_handler_free(&unicam->ctrl_handler);
 	v4l2_device_unregister(&unicam->v4l2_dev);
 	video_unregister_device(&unicam->video_dev);
+	video_unregister_device(&unicam->embedded_dev);
 	if (unicam->sensor_config)
 		v4l2_subdev_free_pad_config(unicam->sensor_config);
 	media_device_unregister(&unicam->mdev);
@@ -198,6 +198,17 @@ static int vimc_cap_enum_framesizes(struct file *file, void *fh,
 	return 0;
 }
 
+static int vimc_cap_log_status(struct file *file, void *priv)
+{
+	struct vimc_cap_device *vcap = video_drvdata(file);
+
+	dev_info(vcap->dev, "%s: frames produced %llu, dropped %llu\n",
+		 vcap->vdev.name, vcap->stream.frames_produced,
+		 vcap->stream.frames_dropped);
+
+	return 0;
+}
+
 static const struct v4l2_file_operations vimc_cap_fops = {
 	.owner		= THIS_MODULE,
 	.open		= v4l2_fh_open,
@@ -226,6 +237,8 @@ static const struct v4l2_ioctl_ops vimc_cap_ioctl_ops = {
 	.vidioc_expbuf = vb2_ioctl_expbuf,
 	.vidioc_streamon = vb2_ioctl_streamon,
 	.vidioc_streamoff = vb2_ioctl_streamoff,
+
+	.vidioc_log_status = vimc_cap_log_status,
 };
 
 static void vimc_cap_return_all_buffers(struct vimc_cap_device *vcap,
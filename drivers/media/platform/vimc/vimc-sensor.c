@@ -27,6 +27,7 @@
 #include <media/tpg/v4l2-tpg.h>
 
 #include "vimc-common.h"
+#include "vimc-streamer.h"
 
 #define VIMC_SEN_DRV_NAME "vimc-sensor"
 
@@ -282,6 +283,7 @@ static int vimc_sen_s_ctrl(struct v4l2_ctrl *ctrl)
 	default:
 		return -EINVAL;
 	}
+	vimc_streamer_invalidate(&vsen->sd.entity);
 	return 0;
 }
 
@@ -9,10 +9,21 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/freezer.h>
+#include <linux/hrtimer.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 
 #include "vimc-streamer.h"
 
+static unsigned int fps = 60;
+module_param(fps, uint, 0644);
+MODULE_PARM_DESC(fps, " frame rate the streamer thread is paced to");
+
+static bool bench;
+module_param(bench, bool, 0644);
+MODULE_PARM_DESC(bench, " benchmark mode: reuse the processed test pattern "
+	"instead of running every entity of the pipeline for each frame");
+
 /**
  * vimc_get_source_entity - get the entity connected with the first sink pad
  *
@@ -114,10 +125,55 @@ static int vimc_streamer_pipeline_init(struct vimc_stream *stream,
 	return -EINVAL;
 }
 
+/*
+ * vimc_streamer_process_frame - run one frame through the pipeline
+ *
+ * @stream: the stream to generate a frame for
+ *
+ * The first entity of @ved_pipeline is the capture device, which returns
+ * NULL once it has filled a buffer. In benchmark mode the frame handed to
+ * the capture device is kept, and as long as nothing upstream changed the
+ * following frames skip the sensor, debayer and scaler entirely.
+ */
+static void vimc_streamer_process_frame(struct vimc_stream *stream)
+{
+	int generation = atomic_read(&stream->generation);
+	int i = stream->pipe_size - 1;
+
+	if (bench && stream->bench_frame &&
+	    stream->bench_generation == generation) {
+		stream->frame = stream->bench_frame;
+		i = 0;
+	} else {
+		stream->frame = NULL;
+	}
+
+	for (; i >= 0; i--) {
+		if (i == 0 && bench) {
+			stream->bench_frame = stream->frame;
+			stream->bench_generation = generation;
+		}
+		stream->frame = stream->ved_pipeline[i]->process_frame(
+				stream->ved_pipeline[i],
+				stream->frame);
+		if (!stream->frame)
+			break;
+		if (IS_ERR(stream->frame))
+			break;
+	}
+
+	if (i == 0 && !stream->frame)
+		stream->frames_produced++;
+	else
+		stream->frames_dropped++;
+}
+
 static int vimc_streamer_thread(void *data)
 {
 	struct vimc_stream *stream = data;
-	int i;
+	ktime_t next = ktime_get();
+	ktime_t now;
+	u64 missed;
 
 	set_freezable();
 
@@ -126,18 +182,24 @@ static int vimc_streamer_thread(void *data)
 		if (kthread_should_stop())
 			break;
 
-		for (i = stream->pipe_size - 1; i >= 0; i--) {
-			stream->frame = stream->ved_pipeline[i]->process_frame(
-					stream->ved_pipeline[i],
-					stream->frame);
-			if (!stream->frame)
-				break;
-			if (IS_ERR(stream->frame))
-				break;
+		vimc_streamer_process_frame(stream);
+
+		/*
+		 * Keep to the absolute frame grid, so that the time spent
+		 * processing doesn't lower the frame rate. Frames that fell
+		 * due whilst we were still busy are counted as dropped.
+		 */
+		next = ktime_add_ns(next, stream->period_ns);
+		now = ktime_get();
+		if (ktime_after(now, next)) {
+			missed = div64_u64(ktime_to_ns(ktime_sub(now, next)),
+					   stream->period_ns) + 1;
+			stream->frames_dropped += missed;
+			next = ktime_add_ns(next, missed * stream->period_ns);
 		}
-		//wait for 60hz
+
 		set_current_state(TASK_UNINTERRUPTIBLE);
-		schedule_timeout(HZ / 60);
+		schedule_hrtimeout(&next, HRTIMER_MODE_ABS);
 	}
 
 	return 0;
@@ -160,6 +222,11 @@ int vimc_streamer_s_stream(struct vimc_stream *stream,
 		if (ret)
 			return ret;
 
+		stream->period_ns = div_u64(NSEC_PER_SEC, max(fps, 1U));
+		stream->bench_frame = NULL;
+		stream->frames_produced = 0;
+		stream->frames_dropped = 0;
+
 		stream->kthread = kthread_run(vimc_streamer_thread, stream,
 					      "vimc-streamer thread");
 
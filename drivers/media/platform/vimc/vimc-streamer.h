@@ -15,14 +15,55 @@
 
 #define VIMC_STREAMER_PIPELINE_MAX_SIZE 16
 
+/**
+ * struct vimc_stream - struct that represents a stream in the pipeline
+ *
+ * @pipe:		the media pipeline object associated with this stream
+ * @ved_pipeline:	array containing all the entities participating in the
+ *			stream. The order is from a video device (usually a
+ *			capture device) where stream_on was called, to the
+ *			entity generating the first base image to be
+ *			processed in the pipeline.
+ * @pipe_size:		size of @ved_pipeline
+ * @frame:		frame returned by the last stage that ran
+ * @kthread:		thread that generates the frames of the stream
+ * @period_ns:		interval between two frames at the target frame rate
+ * @generation:		bumped whenever the generated pattern changes
+ * @bench_frame:	in benchmark mode, the frame handed to the capture
+ *			device, reused until @generation changes
+ * @bench_generation:	value of @generation when @bench_frame was produced
+ * @frames_produced:	frames delivered to the capture device
+ * @frames_dropped:	frames lost to a missing buffer or a missed deadline
+ */
 struct vimc_stream {
 	struct media_pipeline pipe;
 	struct vimc_ent_device *ved_pipeline[VIMC_STREAMER_PIPELINE_MAX_SIZE];
 	unsigned int pipe_size;
 	u8 *frame;
 	struct task_struct *kthread;
+	u64 period_ns;
+	atomic_t generation;
+	u8 *bench_frame;
+	int bench_generation;
+	u64 frames_produced;
+	u64 frames_dropped;
 };
 
+/**
+ * vimc_streamer_invalidate - flag that an entity's output has changed
+ *
+ * @ent:	entity whose output frame changed, e.g. via a control
+ *
+ * Makes a benchmark mode stream run the whole pipeline again for its next
+ * frame instead of reusing the last processed one.
+ */
+static inline void vimc_streamer_invalidate(struct media_entity *ent)
+{
+	if (ent->pipe)
+		atomic_inc(&container_of(ent->pipe, struct vimc_stream,
+					 pipe)->generation);
+}
+
 /**
  * vimc_streamer_s_streamer - start/stop the stream
  *
@@ -41,7 +41,7 @@ module_param(debug, bool, 0644);
 
 /* Instance is already queued on the job_queue */
 #define TRANS_QUEUED		(1 << 0)
-/* Instance is currently running in hardware */
+/* Instance has at least one job running in hardware */
 #define TRANS_RUNNING		(1 << 1)
 /* Instance is currently aborting */
 #define TRANS_ABORT		(1 << 2)
@@ -84,9 +84,12 @@ static const char * const m2m_entity_name[] = {
  *			v4l2_m2m_unregister_media_controller().
  * @intf_devnode:	&struct media_intf devnode pointer with the interface
  *			with controls the M2M device.
- * @curr_ctx:		currently running instance
+ * @curr_ctx:		currently running instance, or the one started last
+ *			when more than one job is in flight
  * @job_queue:		instances queued to run
- * @job_spinlock:	protects job_queue
+ * @job_spinlock:	protects job_queue, curr_ctx and num_running
+ * @num_running:	jobs currently inside the driver
+ * @max_inflight:	how many jobs may be inside the driver at once
  * @m2m_ops:		driver callbacks
  */
 struct v4l2_m2m_dev {
@@ -103,6 +106,8 @@ struct v4l2_m2m_dev {
 
 	struct list_head	job_queue;
 	spinlock_t		job_spinlock;
+	unsigned int		num_running;
+	unsigned int		max_inflight;
 
 	const struct v4l2_m2m_ops *m2m_ops;
 };
@@ -239,36 +244,54 @@ void *v4l2_m2m_get_curr_priv(struct v4l2_m2m_dev *m2m_dev)
 }
 EXPORT_SYMBOL(v4l2_m2m_get_curr_priv);
 
+static void __v4l2_m2m_try_queue(struct v4l2_m2m_dev *m2m_dev,
+				 struct v4l2_m2m_ctx *m2m_ctx);
+
 /**
  * v4l2_m2m_try_run() - select next job to perform and run it if possible
  * @m2m_dev: per-device context
  *
- * Get next transaction (if present) from the waiting jobs list and run it.
+ * Get next transactions (if present) from the waiting jobs list and run them
+ * until the device has max_inflight jobs running.
  */
 static void v4l2_m2m_try_run(struct v4l2_m2m_dev *m2m_dev)
 {
+	struct v4l2_m2m_ctx *m2m_ctx;
 	unsigned long flags;
 
 	spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
-	if (NULL != m2m_dev->curr_ctx) {
-		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
-		dprintk("Another instance is running, won't run now\n");
-		return;
-	}
+	for (;;) {
+		if (m2m_dev->num_running >= m2m_dev->max_inflight) {
+			spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+			dprintk("Another instance is running, won't run now\n");
+			return;
+		}
+
+		if (list_empty(&m2m_dev->job_queue)) {
+			spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+			dprintk("No job pending\n");
+			return;
+		}
 
-	if (list_empty(&m2m_dev->job_queue)) {
+		m2m_ctx = list_first_entry(&m2m_dev->job_queue,
+					   struct v4l2_m2m_ctx, queue);
+		list_del(&m2m_ctx->queue);
+		m2m_ctx->job_flags &= ~TRANS_QUEUED;
+		m2m_ctx->job_flags |= TRANS_RUNNING;
+		m2m_ctx->num_jobs++;
+		m2m_dev->num_running++;
+		m2m_dev->curr_ctx = m2m_ctx;
 		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
-		dprintk("No job pending\n");
-		return;
-	}
 
-	m2m_dev->curr_ctx = list_first_entry(&m2m_dev->job_queue,
-				   struct v4l2_m2m_ctx, queue);
-	m2m_dev->curr_ctx->job_flags |= TRANS_RUNNING;
-	spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+		dprintk("Running job on m2m_ctx: %p\n", m2m_ctx);
+		m2m_dev->m2m_ops->device_run(m2m_ctx->priv);
+
+		/* the context may be able to take another job straight away */
+		if (m2m_dev->m2m_ops->job_ready_batch)
+			__v4l2_m2m_try_queue(m2m_dev, m2m_ctx);
 
-	dprintk("Running job on m2m_ctx: %p\n", m2m_dev->curr_ctx);
-	m2m_dev->m2m_ops->device_run(m2m_dev->curr_ctx->priv);
+		spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
+	}
 }
 
 /*
@@ -308,6 +331,13 @@ static void __v4l2_m2m_try_queue(struct v4l2_m2m_dev *m2m_dev,
 		return;
 	}
 
+	if ((m2m_ctx->job_flags & TRANS_RUNNING) &&
+	    !m2m_dev->m2m_ops->job_ready_batch) {
+		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags_job);
+		dprintk("Already running\n");
+		return;
+	}
+
 	spin_lock_irqsave(&m2m_ctx->out_q_ctx.rdy_spinlock, flags_out);
 	if (list_empty(&m2m_ctx->out_q_ctx.rdy_queue)
 	    && !m2m_ctx->out_q_ctx.buffered) {
@@ -331,7 +361,15 @@ static void __v4l2_m2m_try_queue(struct v4l2_m2m_dev *m2m_dev,
 	spin_unlock_irqrestore(&m2m_ctx->cap_q_ctx.rdy_spinlock, flags_cap);
 	spin_unlock_irqrestore(&m2m_ctx->out_q_ctx.rdy_spinlock, flags_out);
 
-	if (m2m_dev->m2m_ops->job_ready
+	if (m2m_dev->m2m_ops->job_ready_batch) {
+		if (!m2m_dev->m2m_ops->job_ready_batch(m2m_ctx->priv,
+						       m2m_ctx->num_jobs)) {
+			spin_unlock_irqrestore(&m2m_dev->job_spinlock,
+					       flags_job);
+			dprintk("Driver not ready\n");
+			return;
+		}
+	} else if (m2m_dev->m2m_ops->job_ready
 		&& (!m2m_dev->m2m_ops->job_ready(m2m_ctx->priv))) {
 		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags_job);
 		dprintk("Driver not ready\n");
@@ -384,6 +422,11 @@ static void v4l2_m2m_cancel_job(struct v4l2_m2m_ctx *m2m_ctx)
 
 	m2m_ctx->job_flags |= TRANS_ABORT;
 	if (m2m_ctx->job_flags & TRANS_RUNNING) {
+		/* a batching context may also be waiting for another slot */
+		if (m2m_ctx->job_flags & TRANS_QUEUED) {
+			list_del(&m2m_ctx->queue);
+			m2m_ctx->job_flags &= ~TRANS_QUEUED;
+		}
 		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
 		if (m2m_dev->m2m_ops->job_abort)
 			m2m_dev->m2m_ops->job_abort(m2m_ctx->priv);
@@ -408,22 +451,25 @@ void v4l2_m2m_job_finish(struct v4l2_m2m_dev *m2m_dev,
 	unsigned long flags;
 
 	spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
-	if (!m2m_dev->curr_ctx || m2m_dev->curr_ctx != m2m_ctx) {
+	if (!(m2m_ctx->job_flags & TRANS_RUNNING) || !m2m_ctx->num_jobs) {
 		spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
 		dprintk("Called by an instance not currently running\n");
 		return;
 	}
 
-	list_del(&m2m_dev->curr_ctx->queue);
-	m2m_dev->curr_ctx->job_flags &= ~(TRANS_QUEUED | TRANS_RUNNING);
-	wake_up(&m2m_dev->curr_ctx->finished);
-	m2m_dev->curr_ctx = NULL;
+	m2m_dev->num_running--;
+	if (!--m2m_ctx->num_jobs) {
+		m2m_ctx->job_flags &= ~TRANS_RUNNING;
+		wake_up(&m2m_ctx->finished);
+		if (m2m_dev->curr_ctx == m2m_ctx)
+			m2m_dev->curr_ctx = NULL;
+	}
 
 	spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
 
-	/* This instance might have more buffers ready, but since we do not
-	 * allow more than one job on the job_queue per instance, each has
-	 * to be scheduled separately after the previous one finishes. */
+	/* This instance might have more buffers ready, but an instance is
+	 * only on the job_queue once, and without job_ready_batch only runs
+	 * one job at a time, so requeue it now that a job has finished. */
 	v4l2_m2m_try_schedule(m2m_ctx);
 }
 EXPORT_SYMBOL(v4l2_m2m_job_finish);
@@ -567,6 +613,9 @@ int v4l2_m2m_streamoff(struct file *file, struct v4l2_m2m_ctx *m2m_ctx,
 	if (m2m_ctx->job_flags & TRANS_QUEUED)
 		list_del(&m2m_ctx->queue);
 	m2m_ctx->job_flags = 0;
+	/* any job_finish() still to come for this instance will be ignored */
+	m2m_dev->num_running -= m2m_ctx->num_jobs;
+	m2m_ctx->num_jobs = 0;
 
 	spin_lock_irqsave(&q_ctx->rdy_spinlock, flags);
 	/* Drop queue, since streamoff returns device to the same state as after
@@ -861,6 +910,7 @@ struct v4l2_m2m_dev *v4l2_m2m_init(const struct v4l2_m2m_ops *m2m_ops)
 
 	m2m_dev->curr_ctx = NULL;
 	m2m_dev->m2m_ops = m2m_ops;
+	m2m_dev->max_inflight = 1;
 	INIT_LIST_HEAD(&m2m_dev->job_queue);
 	spin_lock_init(&m2m_dev->job_spinlock);
 
@@ -868,6 +918,17 @@ struct v4l2_m2m_dev *v4l2_m2m_init(const struct v4l2_m2m_ops *m2m_ops)
 }
 EXPORT_SYMBOL_GPL(v4l2_m2m_init);
 
+void v4l2_m2m_set_max_inflight(struct v4l2_m2m_dev *m2m_dev,
+			       unsigned int max_inflight)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&m2m_dev->job_spinlock, flags);
+	m2m_dev->max_inflight = max(max_inflight, 1U);
+	spin_unlock_irqrestore(&m2m_dev->job_spinlock, flags);
+}
+EXPORT_SYMBOL_GPL(v4l2_m2m_set_max_inflight);
+
 void v4l2_m2m_release(struct v4l2_m2m_dev *m2m_dev)
 {
 	kfree(m2m_dev);
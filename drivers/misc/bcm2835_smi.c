@@ -60,6 +60,9 @@
 #define DMA_WRITE_TO_MEM true
 #define DMA_READ_FROM_MEM false
 
+/* Length of a streaming read, it is re-armed from the DMA callback */
+#define SMI_STREAM_TRANSFERS INT_MAX
+
 struct bcm2835_smi_instance {
 	struct device *dev;
 	struct smi_settings settings;
@@ -73,6 +76,13 @@ struct bcm2835_smi_instance {
 
 	struct scatterlist buffer_sgl;
 
+	void (*stream_callback)(void *param, unsigned int periods);
+	void *stream_param;
+	dma_cookie_t stream_cookie;
+	size_t stream_len;
+	size_t stream_period_len;
+	unsigned int stream_period;
+
 	struct clk *clk;
 
 	/* Sometimes we are called into in an atomic context (e.g. by
@@ -666,6 +676,94 @@ ssize_t bcm2835_smi_user_dma(
 }
 EXPORT_SYMBOL(bcm2835_smi_user_dma);
 
+static void smi_dma_callback_stream(void *param)
+{
+	struct bcm2835_smi_instance *inst =
+		(struct bcm2835_smi_instance *)param;
+	unsigned int nr_periods = inst->stream_len / inst->stream_period_len;
+	unsigned int period, done = 1;
+	struct dma_tx_state state;
+
+	/* The programmed read has run out: start another one */
+	if (!(read_smi_reg(inst, SMICS) & SMICS_ACTIVE))
+		smi_init_programmed_read(inst, SMI_STREAM_TRANSFERS);
+
+	/* Several periods can complete before the tasklet gets to run and
+	   they only produce one callback, so count them from the position
+	   the DMA has reached. */
+	if (dmaengine_tx_status(inst->dma_chan, inst->stream_cookie,
+				&state) == DMA_IN_PROGRESS &&
+	    state.residue && state.residue <= inst->stream_len) {
+		period = (inst->stream_len - state.residue) /
+			inst->stream_period_len;
+		done = (period + nr_periods - inst->stream_period) %
+			nr_periods;
+		inst->stream_period = period;
+		if (!done)
+			return;
+	}
+
+	inst->stream_callback(inst->stream_param, done);
+}
+
+/* Starts a continuous read into a ring of buf_len bytes at buf, which must
+   have been allocated against bcm2835_smi_dma_dev(). callback is called
+   from the DMA tasklet with the number of period_len byte periods written
+   since the previous call. The read runs until bcm2835_smi_stream_stop(). */
+int bcm2835_smi_stream_start(struct bcm2835_smi_instance *inst,
+	dma_addr_t buf, size_t buf_len, size_t period_len,
+	void (*callback)(void *param, unsigned int periods), void *param)
+{
+	struct dma_async_tx_descriptor *desc;
+	int ret = 0;
+
+	spin_lock(&inst->transaction_lock);
+
+	smi_disable(inst, DMA_DEV_TO_MEM);
+
+	desc = dmaengine_prep_dma_cyclic(inst->dma_chan, buf, buf_len,
+					 period_len, DMA_DEV_TO_MEM,
+					 DMA_PREP_INTERRUPT);
+	if (!desc) {
+		dev_err(inst->dev, "stream: dma cyclic preparation failed!");
+		ret = -ENOMEM;
+		goto out;
+	}
+	inst->stream_callback = callback;
+	inst->stream_param = param;
+	inst->stream_len = buf_len;
+	inst->stream_period_len = period_len;
+	inst->stream_period = 0;
+	desc->callback = smi_dma_callback_stream;
+	desc->callback_param = inst;
+	inst->stream_cookie = dmaengine_submit(desc);
+	if (dma_submit_error(inst->stream_cookie)) {
+		ret = -EIO;
+		goto out;
+	}
+	dma_async_issue_pending(inst->dma_chan);
+
+	smi_init_programmed_read(inst, SMI_STREAM_TRANSFERS);
+out:
+	spin_unlock(&inst->transaction_lock);
+	return ret;
+}
+EXPORT_SYMBOL(bcm2835_smi_stream_start);
+
+/* May sleep: waits for a running stream callback to return */
+void bcm2835_smi_stream_stop(struct bcm2835_smi_instance *inst)
+{
+	smi_disable(inst, DMA_DEV_TO_MEM);
+	dmaengine_terminate_sync(inst->dma_chan);
+}
+EXPORT_SYMBOL(bcm2835_smi_stream_stop);
+
+struct device *bcm2835_smi_dma_dev(struct bcm2835_smi_instance *inst)
+{
+	return inst->dev;
+}
+EXPORT_SYMBOL(bcm2835_smi_dma_dev);
+
 
 /****************************************************************************
 *
@@ -38,6 +38,8 @@
 #include <linux/pm_runtime.h>
 #include <linux/idr.h>
 #include <linux/debugfs.h>
+#include <linux/log2.h>
+#include <linux/seq_file.h>
 
 #include <linux/mmc/ioctl.h>
 #include <linux/mmc/card.h>
@@ -134,6 +136,7 @@ struct mmc_blk_data {
 	/* debugfs files (only in main mmc_blk_data) */
 	struct dentry *status_dentry;
 	struct dentry *ext_csd_dentry;
+	struct dentry *queue_stats_dentry;
 };
 
 /* Device type for RPMB character devices */
@@ -2144,6 +2147,26 @@ static int mmc_blk_rw_wait(struct mmc_queue *mq, struct request **prev_req)
 	return err;
 }
 
+static void mmc_blk_mq_rw_stats(struct mmc_queue *mq, struct request *req)
+{
+	struct mmc_queue_stats *stats = &mq->stats;
+	unsigned int sectors = blk_rq_sectors(req);
+	unsigned long flags;
+
+	spin_lock_irqsave(mq->queue->queue_lock, flags);
+	stats->rw_reqs += 1;
+	stats->rw_sectors += sectors;
+	if (mq->rw_wait)
+		stats->overlapped += 1;
+	if (blk_rq_pos(req) == stats->next_sector)
+		stats->sequential += 1;
+	stats->next_sector = blk_rq_pos(req) + sectors;
+	if (sectors)
+		stats->size[min_t(unsigned int, ilog2(sectors),
+				  MMC_QUEUE_SIZE_BUCKETS - 1)] += 1;
+	spin_unlock_irqrestore(mq->queue->queue_lock, flags);
+}
+
 static int mmc_blk_mq_issue_rw_rq(struct mmc_queue *mq,
 				  struct request *req)
 {
@@ -2158,6 +2181,8 @@ static int mmc_blk_mq_issue_rw_rq(struct mmc_queue *mq,
 
 	mmc_pre_req(host, &mqrq->brq.mrq);
 
+	mmc_blk_mq_rw_stats(mq, req);
+
 	err = mmc_blk_rw_wait(mq, &prev_req);
 	if (err)
 		goto out_post_req;
@@ -2820,6 +2845,62 @@ static const struct file_operations mmc_dbg_ext_csd_fops = {
 	.llseek		= default_llseek,
 };
 
+static int mmc_queue_stats_show(struct seq_file *s, void *data)
+{
+	struct mmc_queue *mq = s->private;
+	struct mmc_queue_stats stats;
+	int i;
+
+	spin_lock_irq(mq->queue->queue_lock);
+	stats = mq->stats;
+	spin_unlock_irq(mq->queue->queue_lock);
+
+	seq_printf(s, "rw requests:\t%llu\n", stats.rw_reqs);
+	seq_printf(s, "rw sectors:\t%llu\n", stats.rw_sectors);
+	seq_printf(s, "overlapped:\t%llu\n", stats.overlapped);
+	seq_printf(s, "sequential:\t%llu\n", stats.sequential);
+	seq_printf(s, "max depth:\t%d\n", stats.max_depth);
+
+	for (i = 0; i < MMC_QUEUE_DEPTH_BUCKETS; i++)
+		seq_printf(s, "depth %d%s:\t%llu\n", i + 1,
+			   i == MMC_QUEUE_DEPTH_BUCKETS - 1 ? "+" : "",
+			   stats.depth[i]);
+
+	for (i = 0; i < MMC_QUEUE_SIZE_BUCKETS; i++)
+		seq_printf(s, "sectors %u%s:\t%llu\n", 1U << i,
+			   i == MMC_QUEUE_SIZE_BUCKETS - 1 ? "+" : "",
+			   stats.size[i]);
+
+	return 0;
+}
+
+static int mmc_queue_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mmc_queue_stats_show, inode->i_private);
+}
+
+static ssize_t mmc_queue_stats_write(struct file *file,
+				     const char __user *ubuf,
+				     size_t cnt, loff_t *ppos)
+{
+	struct mmc_queue *mq = ((struct seq_file *)file->private_data)->private;
+
+	spin_lock_irq(mq->queue->queue_lock);
+	memset(&mq->stats, 0, sizeof(mq->stats));
+	spin_unlock_irq(mq->queue->queue_lock);
+
+	return cnt;
+}
+
+/* Any write clears the statistics */
+static const struct file_operations mmc_dbg_queue_stats_fops = {
+	.open		= mmc_queue_stats_open,
+	.read		= seq_read,
+	.write		= mmc_queue_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int mmc_blk_add_debugfs(struct mmc_card *card, struct mmc_blk_data *md)
 {
 	struct dentry *root;
@@ -2845,6 +2926,12 @@ static int mmc_blk_add_debugfs(struct mmc_card *card, struct mmc_blk_data *md)
 			return -EIO;
 	}
 
+	md->queue_stats_dentry =
+		debugfs_create_file("queue_stats", S_IRUSR | S_IWUSR, root,
+				    &md->queue, &mmc_dbg_queue_stats_fops);
+	if (!md->queue_stats_dentry)
+		return -EIO;
+
 	return 0;
 }
 
@@ -2863,6 +2950,11 @@ static void mmc_blk_remove_debugfs(struct mmc_card *card,
 		debugfs_remove(md->ext_csd_dentry);
 		md->ext_csd_dentry = NULL;
 	}
+
+	if (!IS_ERR_OR_NULL(md->queue_stats_dentry)) {
+		debugfs_remove(md->queue_stats_dentry);
+		md->queue_stats_dentry = NULL;
+	}
 }
 
 #else
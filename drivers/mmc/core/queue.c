@@ -238,6 +238,16 @@ static void mmc_mq_exit_request(struct blk_mq_tag_set *set, struct request *req,
 	mmc_exit_request(mq->queue, req);
 }
 
+/* Called with the queue lock held */
+static void mmc_queue_stats_depth(struct mmc_queue *mq)
+{
+	int depth = mmc_tot_in_flight(mq);
+
+	mq->stats.depth[min(depth, MMC_QUEUE_DEPTH_BUCKETS) - 1] += 1;
+	if (depth > mq->stats.max_depth)
+		mq->stats.max_depth = depth;
+}
+
 static blk_status_t mmc_mq_queue_rq(struct blk_mq_hw_ctx *hctx,
 				    const struct blk_mq_queue_data *bd)
 {
@@ -292,6 +302,7 @@ static blk_status_t mmc_mq_queue_rq(struct blk_mq_hw_ctx *hctx,
 
 	mq->in_flight[issue_type] += 1;
 	get_card = (mmc_tot_in_flight(mq) == 1);
+	mmc_queue_stats_depth(mq);
 	cqe_retune_ok = (mmc_cqe_qcnt(mq) == 1);
 
 	spin_unlock_irq(q->queue_lock);
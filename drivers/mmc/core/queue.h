@@ -71,6 +71,26 @@ struct mmc_queue_req {
 	int			retries;
 };
 
+#define MMC_QUEUE_DEPTH_BUCKETS	4	/* 1, 2, 3, 4 or more */
+#define MMC_QUEUE_SIZE_BUCKETS	12	/* log2 of sectors, 2048 and up */
+
+/*
+ * Read/write issue statistics, protected by the queue lock. "overlapped"
+ * counts requests prepared while the previous one was still on the host,
+ * "sequential" those starting where the previous one ended that the block
+ * layer did not merge.
+ */
+struct mmc_queue_stats {
+	u64			rw_reqs;
+	u64			rw_sectors;
+	u64			overlapped;
+	u64			sequential;
+	u64			depth[MMC_QUEUE_DEPTH_BUCKETS];
+	u64			size[MMC_QUEUE_SIZE_BUCKETS];
+	sector_t		next_sector;
+	int			max_depth;
+};
+
 struct mmc_queue {
 	struct mmc_card		*card;
 	struct mmc_ctx		ctx;
@@ -93,6 +113,7 @@ struct mmc_queue {
 	struct request		*complete_req;
 	struct mutex		complete_lock;
 	struct work_struct	complete_work;
+	struct mmc_queue_stats	stats;
 };
 
 extern int mmc_init_queue(struct mmc_queue *, struct mmc_card *, spinlock_t *,
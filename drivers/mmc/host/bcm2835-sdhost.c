@@ -53,6 +53,7 @@
 #include <linux/workqueue.h>
 #include <linux/interrupt.h>
 #include <linux/highmem.h>
+#include <linux/sizes.h>
 #include <soc/bcm2835/raspberrypi-firmware.h>
 
 /* For mmc_card_blockaddr */
@@ -143,6 +144,13 @@
 
 #define MHZ 1000000
 
+/* mmc_data.host_cookie: the sg list was mapped for DMA by pre_req */
+#define SDHOST_COOKIE_UNMAPPED   0
+#define SDHOST_COOKIE_PRE_MAPPED 1
+
+/* Transfers up to pio_limit blocks are bounced through this buffer */
+#define SDHOST_BOUNCE_SIZE       SZ_4K
+
 
 struct bcm2835_host {
 	spinlock_t		lock;
@@ -203,6 +211,10 @@ struct bcm2835_host {
 	u32				drain_words;
 	struct page 			*drain_page;
 	u32				drain_offset;
+	u32				*drain_buf;		/* Drain target when bouncing */
+	void				*bounce_buf;		/* Coherent buffer for small transfers */
+	dma_addr_t			bounce_addr;
+	bool				use_bounce;		/* Current transfer is bounced */
 
 	bool				allow_dma;
 	bool				use_dma;
@@ -532,14 +544,34 @@ static void bcm2835_sdhost_dma_complete(void *param)
 		  bcm2835_sdhost_read(host, SDEDM));
 
 	if (host->dma_chan) {
-		dma_unmap_sg(host->dma_chan->device->dev,
-			     data->sg, data->sg_len,
-			     host->dma_dir);
+		/* Reads are unmapped before the drain words are written by
+		   the CPU, otherwise the invalidate of the last partial cache
+		   line could discard them. Pre-mapped writes are left for
+		   post_req. */
+		if (host->use_bounce) {
+			/* Nothing was mapped */
+		} else if (data->host_cookie != SDHOST_COOKIE_PRE_MAPPED ||
+			   host->dma_dir == DMA_FROM_DEVICE) {
+			dma_unmap_sg(host->dma_chan->device->dev,
+				     data->sg, data->sg_len,
+				     host->dma_dir);
+			data->host_cookie = SDHOST_COOKIE_UNMAPPED;
+		}
 
 		host->dma_chan = NULL;
 	}
 
-	if (host->drain_words) {
+	if (host->drain_words && host->drain_buf) {
+		u32 *buf = host->drain_buf;
+
+		while (host->drain_words) {
+			u32 edm = bcm2835_sdhost_read(host, SDEDM);
+			if ((edm >> 4) & 0x1f)
+				*(buf++) = bcm2835_sdhost_read(host,
+							       SDDATA);
+			host->drain_words--;
+		}
+	} else if (host->drain_words) {
 		void *page;
 		u32 *buf;
 
@@ -562,6 +594,14 @@ static void bcm2835_sdhost_dma_complete(void *param)
 		kunmap_atomic(page);
 	}
 
+	if (host->use_bounce) {
+		if (host->dma_dir == DMA_FROM_DEVICE)
+			sg_copy_from_buffer(data->sg, data->sg_len,
+					    host->bounce_buf,
+					    data->blocks * data->blksz);
+		host->use_bounce = false;
+	}
+
 	bcm2835_sdhost_finish_data(host);
 
 	log_event("DMA>", host->data, 0);
@@ -781,12 +821,35 @@ static void bcm2835_sdhost_transfer_pio(struct bcm2835_host *host)
 	log_event("XFP>", host->data, host->blocks);
 }
 
+/* The block doesn't manage the FIFO DREQs properly for multi-block
+   transfers, so don't attempt to DMA the final few words.
+   Unfortunately this requires the final sg entry to be trimmed.
+   N.B. This code demands that the overspill is contained in
+   a single sg entry.
+*/
+static u32 bcm2835_sdhost_drain_len(struct mmc_data *data)
+{
+	if ((data->blocks > 1) && (data->flags & MMC_DATA_READ))
+		return min((u32)(FIFO_READ_THRESHOLD - 1) * 4,
+			   (u32)data->blocks * data->blksz);
+	return 0;
+}
+
+static void bcm2835_sdhost_trim_sg(struct mmc_data *data, u32 len)
+{
+	struct scatterlist *sg = sg_last(data->sg, data->sg_len);
+
+	BUG_ON(sg->length < len);
+	sg->length -= len;
+}
+
 static void bcm2835_sdhost_prepare_dma(struct bcm2835_host *host,
 	struct mmc_data *data)
 {
 	int len, dir_data, dir_slave;
 	struct dma_async_tx_descriptor *desc = NULL;
 	struct dma_chan *dma_chan;
+	u32 drain_len;
 
 	log_event("PRD<", data, 0);
 	pr_debug("bcm2835_sdhost_prepare_dma()\n");
@@ -805,31 +868,19 @@ static void bcm2835_sdhost_prepare_dma(struct bcm2835_host *host,
 	BUG_ON(!dma_chan->device->dev);
 	BUG_ON(!data->sg);
 
-	/* The block doesn't manage the FIFO DREQs properly for multi-block
-	   transfers, so don't attempt to DMA the final few words.
-	   Unfortunately this requires the final sg entry to be trimmed.
-	   N.B. This code demands that the overspill is contained in
-	   a single sg entry.
-	*/
+	/* A pre-mapped sg list was already trimmed by pre_req */
+	drain_len = bcm2835_sdhost_drain_len(data);
+	if (drain_len && data->host_cookie != SDHOST_COOKIE_PRE_MAPPED)
+		bcm2835_sdhost_trim_sg(data, drain_len);
 
 	host->drain_words = 0;
-	if ((data->blocks > 1) && (dir_data == DMA_FROM_DEVICE)) {
-		struct scatterlist *sg;
-		u32 len;
-		int i;
-
-		len = min((u32)(FIFO_READ_THRESHOLD - 1) * 4,
-			  (u32)data->blocks * data->blksz);
-
-		for_each_sg(data->sg, sg, data->sg_len, i) {
-			if (sg_is_last(sg)) {
-				BUG_ON(sg->length < len);
-				sg->length -= len;
-				host->drain_page = sg_page(sg);
-				host->drain_offset = sg->offset + sg->length;
-			}
-		}
-		host->drain_words = len/4;
+	host->drain_buf = NULL;
+	if (drain_len) {
+		struct scatterlist *sg = sg_last(data->sg, data->sg_len);
+
+		host->drain_page = sg_page(sg);
+		host->drain_offset = sg->offset + sg->length;
+		host->drain_words = drain_len/4;
 	}
 
 	/* The parameters have already been validated, so this will not fail */
@@ -838,8 +889,11 @@ static void bcm2835_sdhost_prepare_dma(struct bcm2835_host *host,
 				     &host->dma_cfg_rx :
 				     &host->dma_cfg_tx);
 
-	len = dma_map_sg(dma_chan->device->dev, data->sg, data->sg_len,
-			 dir_data);
+	if (data->host_cookie == SDHOST_COOKIE_PRE_MAPPED)
+		len = data->sg_count;
+	else
+		len = dma_map_sg(dma_chan->device->dev, data->sg,
+				 data->sg_len, dir_data);
 
 	log_event("PRD2", len, 0);
 	if (len > 0)
@@ -854,10 +908,65 @@ static void bcm2835_sdhost_prepare_dma(struct bcm2835_host *host,
 		host->dma_desc = desc;
 		host->dma_chan = dma_chan;
 		host->dma_dir = dir_data;
+	} else if (data->host_cookie == SDHOST_COOKIE_PRE_MAPPED) {
+		/* Falling back to PIO - hand the buffers back to the CPU */
+		dma_unmap_sg(dma_chan->device->dev, data->sg, data->sg_len,
+			     dir_data);
+		data->host_cookie = SDHOST_COOKIE_UNMAPPED;
 	}
 	log_event("PDM>", data, 0);
 }
 
+/* Small transfers go through the preallocated coherent bounce buffer.
+   This avoids both the PIO FIFO polling loops and the cost of mapping
+   the scatterlist for a few hundred bytes.
+*/
+static void bcm2835_sdhost_prepare_bounce_dma(struct bcm2835_host *host,
+	struct mmc_data *data)
+{
+	struct dma_async_tx_descriptor *desc;
+	struct dma_chan *dma_chan = host->dma_chan_rxtx;
+	u32 len = data->blocks * data->blksz;
+	u32 drain_len;
+	int dir_data, dir_slave;
+
+	log_event("PRB<", data, len);
+
+	if (data->flags & MMC_DATA_READ) {
+		dir_data = DMA_FROM_DEVICE;
+		dir_slave = DMA_DEV_TO_MEM;
+	} else {
+		dir_data = DMA_TO_DEVICE;
+		dir_slave = DMA_MEM_TO_DEV;
+		sg_copy_to_buffer(data->sg, data->sg_len,
+				  host->bounce_buf, len);
+	}
+
+	drain_len = bcm2835_sdhost_drain_len(data);
+
+	/* The parameters have already been validated, so this will not fail */
+	(void)dmaengine_slave_config(dma_chan,
+				     (dir_data == DMA_FROM_DEVICE) ?
+				     &host->dma_cfg_rx :
+				     &host->dma_cfg_tx);
+
+	desc = dmaengine_prep_slave_single(dma_chan, host->bounce_addr,
+					   len - drain_len, dir_slave,
+					   DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc)
+		return;
+
+	desc->callback = bcm2835_sdhost_dma_complete;
+	desc->callback_param = host;
+	host->dma_desc = desc;
+	host->dma_chan = dma_chan;
+	host->dma_dir = dir_data;
+	host->use_bounce = true;
+	host->drain_words = drain_len/4;
+	host->drain_buf = host->bounce_buf + len - drain_len;
+	log_event("PRB>", data, 0);
+}
+
 static void bcm2835_sdhost_start_dma(struct bcm2835_host *host)
 {
 	log_event("SDMA", host->data, host->dma_chan);
@@ -1688,6 +1797,9 @@ static void bcm2835_sdhost_request(struct mmc_host *mmc, struct mmc_request *mrq
 	if (host->use_dma && mrq->data &&
 	    (mrq->data->blocks > host->pio_limit))
 		bcm2835_sdhost_prepare_dma(host, mrq->data);
+	else if (host->bounce_buf && mrq->data &&
+		 (mrq->data->blocks * mrq->data->blksz <= SDHOST_BOUNCE_SIZE))
+		bcm2835_sdhost_prepare_bounce_dma(host, mrq->data);
 
 	if (host->reset_clock)
 	    bcm2835_sdhost_set_clock(host, host->clock);
@@ -1780,8 +1892,59 @@ static void bcm2835_sdhost_set_ios(struct mmc_host *mmc, struct mmc_ios *ios)
 		bcm2835_sdhost_set_clock(host, ios->clock);
 }
 
+/* Map the next request's buffers while the current one is in flight, so
+   the cache maintenance is off the critical path. The descriptor itself is
+   still built in the request path - terminating the channel after an error
+   would free any prepared but unsubmitted descriptor along with it. */
+static void bcm2835_sdhost_pre_req(struct mmc_host *mmc,
+				   struct mmc_request *mrq)
+{
+	struct bcm2835_host *host = mmc_priv(mmc);
+	struct mmc_data *data = mrq->data;
+	int dir_data;
+	u32 drain_len;
+
+	if (!data)
+		return;
+
+	data->host_cookie = SDHOST_COOKIE_UNMAPPED;
+	if (!host->use_dma || data->blocks <= host->pio_limit)
+		return;
+
+	dir_data = (data->flags & MMC_DATA_READ) ?
+		DMA_FROM_DEVICE : DMA_TO_DEVICE;
+
+	drain_len = bcm2835_sdhost_drain_len(data);
+	if (drain_len)
+		bcm2835_sdhost_trim_sg(data, drain_len);
+
+	data->sg_count = dma_map_sg(host->dma_chan_rxtx->device->dev,
+				    data->sg, data->sg_len, dir_data);
+	if (data->sg_count > 0)
+		data->host_cookie = SDHOST_COOKIE_PRE_MAPPED;
+	else if (drain_len)
+		sg_last(data->sg, data->sg_len)->length += drain_len;
+}
+
+static void bcm2835_sdhost_post_req(struct mmc_host *mmc,
+				    struct mmc_request *mrq, int err)
+{
+	struct bcm2835_host *host = mmc_priv(mmc);
+	struct mmc_data *data = mrq->data;
+
+	if (data && data->host_cookie == SDHOST_COOKIE_PRE_MAPPED) {
+		dma_unmap_sg(host->dma_chan_rxtx->device->dev,
+			     data->sg, data->sg_len,
+			     (data->flags & MMC_DATA_READ) ?
+			     DMA_FROM_DEVICE : DMA_TO_DEVICE);
+		data->host_cookie = SDHOST_COOKIE_UNMAPPED;
+	}
+}
+
 static struct mmc_host_ops bcm2835_sdhost_ops = {
 	.request = bcm2835_sdhost_request,
+	.pre_req = bcm2835_sdhost_pre_req,
+	.post_req = bcm2835_sdhost_post_req,
 	.set_ios = bcm2835_sdhost_set_ios,
 	.hw_reset = bcm2835_sdhost_reset,
 };
@@ -1867,6 +2030,7 @@ static void bcm2835_sdhost_tasklet_finish(unsigned long param)
 	host->dma_desc = NULL;
 	terminate_chan = host->dma_chan;
 	host->dma_chan = NULL;
+	host->use_bounce = false;
 
 	spin_unlock_irqrestore(&host->lock, flags);
 
@@ -1897,6 +2061,17 @@ static void bcm2835_sdhost_tasklet_finish(unsigned long param)
 	log_event("TSK>", mrq, 0);
 }
 
+static void bcm2835_sdhost_free_bounce(struct bcm2835_host *host)
+{
+	if (!host->bounce_buf)
+		return;
+
+	dma_free_coherent(host->dma_chan_rxtx->device->dev,
+			  SDHOST_BOUNCE_SIZE, host->bounce_buf,
+			  host->bounce_addr);
+	host->bounce_buf = NULL;
+}
+
 int bcm2835_sdhost_add_host(struct bcm2835_host *host)
 {
 	struct mmc_host *mmc;
@@ -1969,6 +2144,16 @@ int bcm2835_sdhost_add_host(struct bcm2835_host *host)
 		host->use_dma = false;
 	}
 
+	if (host->use_dma && host->pio_limit) {
+		host->bounce_buf =
+			dma_alloc_coherent(host->dma_chan_rxtx->device->dev,
+					   SDHOST_BOUNCE_SIZE,
+					   &host->bounce_addr, GFP_KERNEL);
+		if (!host->bounce_buf)
+			pr_warn("%s: no bounce buffer, using PIO for small transfers\n",
+				mmc_hostname(mmc));
+	}
+
 	mmc->max_segs = 128;
 	mmc->max_req_size = 524288;
 	mmc->max_seg_size = mmc->max_req_size;
@@ -1999,7 +2184,7 @@ int bcm2835_sdhost_add_host(struct bcm2835_host *host)
 	mmc_add_host(mmc);
 
 	pio_limit_string[0] = '\0';
-	if (host->use_dma && (host->pio_limit > 0))
+	if (host->use_dma && (host->pio_limit > 0) && !host->bounce_buf)
 		sprintf(pio_limit_string, " (>%d)", host->pio_limit);
 	pr_info("%s: %s loaded - DMA %s%s\n",
 		mmc_hostname(mmc), DRIVER_NAME,
@@ -2010,6 +2195,7 @@ int bcm2835_sdhost_add_host(struct bcm2835_host *host)
 
 untasklet:
 	tasklet_kill(&host->finish_tasklet);
+	bcm2835_sdhost_free_bounce(host);
 
 	return ret;
 }
@@ -2178,6 +2364,7 @@ static int bcm2835_sdhost_remove(struct platform_device *pdev)
 	del_timer_sync(&host->timer);
 
 	tasklet_kill(&host->finish_tasklet);
+	bcm2835_sdhost_free_bounce(host);
 	if (host->dma_chan_rxtx)
 		dma_release_channel(host->dma_chan_rxtx);
 	mmc_free_host(host->mmc);
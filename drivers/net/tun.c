@@ -127,7 +127,8 @@ do {								\
 #define TUN_VNET_BE     0x40000000
 
 #define TUN_FEATURES (IFF_NO_PI | IFF_ONE_QUEUE | IFF_VNET_HDR | \
-		      IFF_MULTI_QUEUE | IFF_NAPI | IFF_NAPI_FRAGS)
+		      IFF_MULTI_QUEUE | IFF_NAPI | IFF_NAPI_FRAGS | \
+		      IFF_MULTI_FRAME)
 
 #define GOODCOPY_LEN 128
 
@@ -1561,6 +1562,35 @@ static void tun_rx_batched(struct tun_struct *tun, struct tun_file *tfile,
 	}
 }
 
+/* Push whatever tun_rx_batched() or the NAPI path left queued by a
+ * caller that promised more packets and then could not deliver them.
+ */
+static void tun_rx_flush(struct tun_struct *tun, struct tun_file *tfile)
+{
+	struct sk_buff_head *queue = &tfile->sk.sk_write_queue;
+	struct sk_buff_head process_queue;
+	struct sk_buff *skb;
+
+	if (tfile->napi_enabled) {
+		local_bh_disable();
+		napi_schedule(&tfile->napi);
+		local_bh_enable();
+		return;
+	}
+
+	__skb_queue_head_init(&process_queue);
+	spin_lock(&queue->lock);
+	skb_queue_splice_tail_init(queue, &process_queue);
+	spin_unlock(&queue->lock);
+
+	local_bh_disable();
+	while ((skb = __skb_dequeue(&process_queue))) {
+		skb_record_rx_queue(skb, tfile->queue_index);
+		netif_receive_skb(skb);
+	}
+	local_bh_enable();
+}
+
 static bool tun_can_build_skb(struct tun_struct *tun, struct tun_file *tfile,
 			      int len, int noblock, bool zerocopy)
 {
@@ -1976,18 +2006,59 @@ static ssize_t tun_get_user(struct tun_struct *tun, struct tun_file *tfile,
 	return total_len;
 }
 
+/* With IFF_MULTI_FRAME every iovec handed to writev() is a complete
+ * packet, with its own tun_pi and virtio_net_hdr.  All but the last one are
+ * injected with more set so that they are batched on their way into the
+ * stack.  Returns the number of bytes of the packets accepted, or the error
+ * of the first one.
+ */
+static ssize_t tun_get_user_multi(struct tun_struct *tun,
+				  struct tun_file *tfile,
+				  struct iov_iter *from, int noblock)
+{
+	const struct iovec *iov = from->iov;
+	unsigned long last = from->nr_segs - 1;
+	ssize_t total = 0, ret = 0;
+	unsigned long i;
+
+	while (last && !iov[last].iov_len)
+		last--;
+
+	for (i = 0; i <= last; i++) {
+		struct iov_iter seg;
+
+		if (!iov[i].iov_len)
+			continue;
+
+		iov_iter_init(&seg, WRITE, &iov[i], 1, iov[i].iov_len);
+		ret = tun_get_user(tun, tfile, NULL, &seg, noblock, i < last);
+		if (ret < 0) {
+			if (total)
+				tun_rx_flush(tun, tfile);
+			break;
+		}
+		total += iov[i].iov_len;
+	}
+
+	return total ? total : ret;
+}
+
 static ssize_t tun_chr_write_iter(struct kiocb *iocb, struct iov_iter *from)
 {
 	struct file *file = iocb->ki_filp;
 	struct tun_file *tfile = file->private_data;
 	struct tun_struct *tun = tun_get(tfile);
+	int noblock = file->f_flags & O_NONBLOCK;
 	ssize_t result;
 
 	if (!tun)
 		return -EBADFD;
 
-	result = tun_get_user(tun, tfile, NULL, from,
-			      file->f_flags & O_NONBLOCK, false);
+	if ((tun->flags & IFF_MULTI_FRAME) && iter_is_iovec(from) &&
+	    !from->iov_offset && from->nr_segs > 1)
+		result = tun_get_user_multi(tun, tfile, from, noblock);
+	else
+		result = tun_get_user(tun, tfile, NULL, from, noblock, false);
 
 	tun_put(tun);
 	return result;
@@ -2202,16 +2273,50 @@ static ssize_t tun_do_read(struct tun_struct *tun, struct tun_file *tfile,
 	return ret;
 }
 
+/* The IFF_MULTI_FRAME counterpart of tun_do_read(): fill one packet into
+ * each iovec handed to readv().  Only the first packet may block, the read
+ * returns as soon as the queue runs dry.  A packet larger than its iovec is
+ * truncated, just as it would be by a plain read().
+ */
+static ssize_t tun_do_read_multi(struct tun_struct *tun,
+				 struct tun_file *tfile,
+				 struct iov_iter *to, int noblock)
+{
+	const struct iovec *iov = to->iov;
+	ssize_t total = 0, ret = 0;
+	unsigned long i;
+
+	for (i = 0; i < to->nr_segs; i++) {
+		struct iov_iter seg;
+
+		if (!iov[i].iov_len)
+			continue;
+
+		iov_iter_init(&seg, READ, &iov[i], 1, iov[i].iov_len);
+		ret = tun_do_read(tun, tfile, &seg, noblock || total, NULL);
+		if (ret < 0)
+			break;
+		total += min_t(ssize_t, ret, iov[i].iov_len);
+	}
+
+	return total ? total : ret;
+}
+
 static ssize_t tun_chr_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
 	struct file *file = iocb->ki_filp;
 	struct tun_file *tfile = file->private_data;
 	struct tun_struct *tun = tun_get(tfile);
 	ssize_t len = iov_iter_count(to), ret;
+	int noblock = file->f_flags & O_NONBLOCK;
 
 	if (!tun)
 		return -EBADFD;
-	ret = tun_do_read(tun, tfile, to, file->f_flags & O_NONBLOCK, NULL);
+	if ((tun->flags & IFF_MULTI_FRAME) && iter_is_iovec(to) &&
+	    !to->iov_offset && to->nr_segs > 1)
+		ret = tun_do_read_multi(tun, tfile, to, noblock);
+	else
+		ret = tun_do_read(tun, tfile, to, noblock, NULL);
 	ret = min_t(ssize_t, ret, len);
 	if (ret > 0)
 		iocb->ki_pos = ret;
@@ -2534,6 +2639,10 @@ static int tun_set_iff(struct net *net, struct file *file, struct ifreq *ifr)
 		if (!(ifr->ifr_flags & IFF_NAPI) ||
 		    (ifr->ifr_flags & TUN_TYPE_MASK) != IFF_TAP)
 			return -EINVAL;
+
+		/* NAPI frags already map each iovec onto a page fragment */
+		if (ifr->ifr_flags & IFF_MULTI_FRAME)
+			return -EINVAL;
 	}
 
 	dev = __dev_get_by_name(net, ifr->ifr_name);
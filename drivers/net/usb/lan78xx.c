@@ -99,6 +99,8 @@
 /* statistic update interval (mSec) */
 #define STAT_UPDATE_TIMER		(1 * 1000)
 
+#define LAN78XX_NAPI_WEIGHT		64
+
 /* defines interrupts from interrupt EP */
 #define MAX_INT_EP			(32)
 #define INT_EP_INTEP			(31)
@@ -385,7 +387,7 @@ struct lan78xx_net {
 	struct sk_buff_head	rxq_pause;
 	struct sk_buff_head	txq_pend;
 
-	struct tasklet_struct	bh;
+	struct napi_struct	napi;
 	struct delayed_work	wq;
 
 	struct usb_host_endpoint *ep_blkin;
@@ -1258,16 +1260,16 @@ static int lan78xx_link_reset(struct lan78xx_net *dev)
 				  jiffies + STAT_UPDATE_TIMER);
 		}
 
-		tasklet_schedule(&dev->bh);
+		napi_schedule(&dev->napi);
 	}
 
 	return ret;
 }
 
-/* some work can't be done in tasklets, so we use keventd
+/* some work can't be done in softirq context, so we use keventd
  *
  * NOTE:  annoying asymmetry:  if it's active, schedule_work() fails,
- * but tasklet_schedule() doesn't.	hope the failure is rare.
+ * but napi_schedule() doesn't.	hope the failure is rare.
  */
 static void lan78xx_defer_kevent(struct lan78xx_net *dev, int work)
 {
@@ -2337,7 +2339,7 @@ static int lan78xx_change_mtu(struct net_device *netdev, int new_mtu)
 		if (dev->rx_urb_size > old_rx_urb_size) {
 			if (netif_running(dev->net)) {
 				unlink_urbs(dev, &dev->rxq);
-				tasklet_schedule(&dev->bh);
+				napi_schedule(&dev->napi);
 			}
 		}
 	}
@@ -2703,6 +2705,7 @@ static int lan78xx_open(struct net_device *net)
 
 	set_bit(EVENT_DEV_OPEN, &dev->flags);
 
+	napi_enable(&dev->napi);
 	netif_start_queue(net);
 
 	dev->link_on = false;
@@ -2771,7 +2774,7 @@ static int lan78xx_stop(struct net_device *net)
 	 */
 	dev->flags = 0;
 	cancel_delayed_work_sync(&dev->wq);
-	tasklet_kill(&dev->bh);
+	napi_disable(&dev->napi);
 
 	usb_autopm_put_interface(dev->intf);
 
@@ -2840,7 +2843,7 @@ static enum skb_state defer_bh(struct lan78xx_net *dev, struct sk_buff *skb,
 
 	__skb_queue_tail(&dev->done, skb);
 	if (skb_queue_len(&dev->done) == 1)
-		tasklet_schedule(&dev->bh);
+		napi_schedule(&dev->napi);
 	spin_unlock_irqrestore(&dev->done.lock, flags);
 
 	return old_state;
@@ -2919,7 +2922,7 @@ lan78xx_start_xmit(struct sk_buff *skb, struct net_device *net)
 		dev->net->stats.tx_dropped++;
 	}
 
-	tasklet_schedule(&dev->bh);
+	napi_schedule(&dev->napi);
 
 	return NETDEV_TX_OK;
 }
@@ -3129,8 +3132,6 @@ static void lan78xx_rx_vlan_offload(struct lan78xx_net *dev,
 
 static void lan78xx_skb_return(struct lan78xx_net *dev, struct sk_buff *skb)
 {
-	int		status;
-
 	if (test_bit(EVENT_RX_PAUSED, &dev->flags)) {
 		skb_queue_tail(&dev->rxq_pause, skb);
 		return;
@@ -3148,14 +3149,17 @@ static void lan78xx_skb_return(struct lan78xx_net *dev, struct sk_buff *skb)
 	if (skb_defer_rx_timestamp(skb))
 		return;
 
-	status = netif_rx(skb);
-	if (status != NET_RX_SUCCESS)
-		netif_dbg(dev, rx_err, dev->net,
-			  "netif_rx status %d\n", status);
+	if (napi_gro_receive(&dev->napi, skb) == GRO_DROP)
+		netif_dbg(dev, rx_err, dev->net, "napi_gro_receive dropped\n");
 }
 
+/* returns the number of frames found in the URB buffer, the last of which
+ * is left in @skb, or 0 if the buffer could not be parsed
+ */
 static int lan78xx_rx(struct lan78xx_net *dev, struct sk_buff *skb)
 {
+	int count = 0;
+
 	if (skb->len < dev->net->hard_header_len)
 		return 0;
 
@@ -3197,7 +3201,7 @@ static int lan78xx_rx(struct lan78xx_net *dev, struct sk_buff *skb)
 				skb_trim(skb, skb->len - 4); /* remove fcs */
 				skb->truesize = size + sizeof(struct sk_buff);
 
-				return 1;
+				return count + 1;
 			}
 
 			skb2 = skb_clone(skb, GFP_ATOMIC);
@@ -3217,6 +3221,7 @@ static int lan78xx_rx(struct lan78xx_net *dev, struct sk_buff *skb)
 			skb2->truesize = size + sizeof(struct sk_buff);
 
 			lan78xx_skb_return(dev, skb2);
+			count++;
 		}
 
 		skb_pull(skb, size);
@@ -3226,25 +3231,28 @@ static int lan78xx_rx(struct lan78xx_net *dev, struct sk_buff *skb)
 			skb_pull(skb, align_count);
 	}
 
-	return 1;
+	return count + 1;
 }
 
-static inline void rx_process(struct lan78xx_net *dev, struct sk_buff *skb)
+static inline int rx_process(struct lan78xx_net *dev, struct sk_buff *skb)
 {
-	if (!lan78xx_rx(dev, skb)) {
+	int count = lan78xx_rx(dev, skb);
+
+	if (!count) {
 		dev->net->stats.rx_errors++;
 		goto done;
 	}
 
 	if (skb->len) {
 		lan78xx_skb_return(dev, skb);
-		return;
+		return count;
 	}
 
 	netif_dbg(dev, rx_err, dev->net, "drop\n");
 	dev->net->stats.rx_errors++;
 done:
 	skb_queue_tail(&dev->done, skb);
+	return count;
 }
 
 static void rx_complete(struct urb *urb);
@@ -3295,7 +3303,7 @@ static int rx_submit(struct lan78xx_net *dev, struct urb *urb, gfp_t flags)
 		default:
 			netif_dbg(dev, rx_err, dev->net,
 				  "rx submit, %d\n", ret);
-			tasklet_schedule(&dev->bh);
+			napi_schedule(&dev->napi);
 		}
 	} else {
 		netif_dbg(dev, ifdown, dev->net, "rx: stopped\n");
@@ -3507,7 +3515,8 @@ static void lan78xx_tx_bh(struct lan78xx_net *dev)
 			  "> tx, len %d, type 0x%x\n", length, skb->protocol);
 }
 
-static void lan78xx_rx_bh(struct lan78xx_net *dev)
+/* returns true when the RX queue is still short and wants another pass */
+static bool lan78xx_rx_bh(struct lan78xx_net *dev)
 {
 	struct urb *urb;
 	int i;
@@ -3519,28 +3528,27 @@ static void lan78xx_rx_bh(struct lan78xx_net *dev)
 			urb = usb_alloc_urb(0, GFP_ATOMIC);
 			if (urb)
 				if (rx_submit(dev, urb, GFP_ATOMIC) == -ENOLINK)
-					return;
+					return false;
 		}
-
-		if (skb_queue_len(&dev->rxq) < dev->rx_qlen)
-			tasklet_schedule(&dev->bh);
 	}
 	if (skb_queue_len(&dev->txq) < dev->tx_qlen)
 		netif_wake_queue(dev->net);
+
+	return skb_queue_len(&dev->rxq) < dev->rx_qlen;
 }
 
-static void lan78xx_bh(unsigned long param)
+static int lan78xx_bh(struct lan78xx_net *dev, int budget)
 {
-	struct lan78xx_net *dev = (struct lan78xx_net *)param;
 	struct sk_buff *skb;
 	struct skb_data *entry;
+	int work_done = 0;
 
-	while ((skb = skb_dequeue(&dev->done))) {
+	while (work_done < budget && (skb = skb_dequeue(&dev->done))) {
 		entry = (struct skb_data *)(skb->cb);
 		switch (entry->state) {
 		case rx_done:
 			entry->state = rx_cleanup;
-			rx_process(dev, skb);
+			work_done += rx_process(dev, skb);
 			continue;
 		case tx_done:
 			usb_free_urb(entry->urb);
@@ -3552,7 +3560,7 @@ static void lan78xx_bh(unsigned long param)
 			continue;
 		default:
 			netdev_dbg(dev->net, "skb state %d\n", entry->state);
-			return;
+			return work_done;
 		}
 	}
 
@@ -3567,10 +3575,35 @@ static void lan78xx_bh(unsigned long param)
 		if (!skb_queue_empty(&dev->txq_pend))
 			lan78xx_tx_bh(dev);
 
+		/* keep polling until the RX queue is refilled */
 		if (!timer_pending(&dev->delay) &&
-		    !test_bit(EVENT_RX_HALT, &dev->flags))
-			lan78xx_rx_bh(dev);
+		    !test_bit(EVENT_RX_HALT, &dev->flags) &&
+		    lan78xx_rx_bh(dev))
+			return budget;
+	}
+
+	return min(work_done, budget);
+}
+
+static int lan78xx_poll(struct napi_struct *napi, int budget)
+{
+	struct lan78xx_net *dev = container_of(napi, struct lan78xx_net, napi);
+	int work_done;
+
+	work_done = lan78xx_bh(dev, budget);
+
+	if (work_done < budget) {
+		napi_complete_done(napi, work_done);
+
+		/* defer_bh() only schedules NAPI when the done
+		 * list goes non-empty, which it may have done after the
+		 * loop above drained it but before NAPI was completed
+		 */
+		if (!skb_queue_empty(&dev->done))
+			napi_schedule(napi);
 	}
+
+	return work_done;
 }
 
 static void lan78xx_delayedwork(struct work_struct *work)
@@ -3618,7 +3651,7 @@ static void lan78xx_delayedwork(struct work_struct *work)
 					   status);
 		} else {
 			clear_bit(EVENT_RX_HALT, &dev->flags);
-			tasklet_schedule(&dev->bh);
+			napi_schedule(&dev->napi);
 		}
 	}
 
@@ -3731,7 +3764,7 @@ static void lan78xx_tx_timeout(struct net_device *net)
 	struct lan78xx_net *dev = netdev_priv(net);
 
 	unlink_urbs(dev, &dev->txq);
-	tasklet_schedule(&dev->bh);
+	napi_schedule(&dev->napi);
 }
 
 static netdev_features_t lan78xx_features_check(struct sk_buff *skb,
@@ -3808,7 +3841,7 @@ static int lan78xx_probe(struct usb_interface *intf,
 	skb_queue_head_init(&dev->txq_pend);
 	mutex_init(&dev->phy_mutex);
 
-	tasklet_init(&dev->bh, lan78xx_bh, (unsigned long)dev);
+	netif_napi_add(netdev, &dev->napi, lan78xx_poll, LAN78XX_NAPI_WEIGHT);
 	INIT_DELAYED_WORK(&dev->wq, lan78xx_delayedwork);
 	init_usb_anchor(&dev->deferred);
 
@@ -4209,7 +4242,7 @@ static int lan78xx_resume(struct usb_interface *intf)
 		if (test_bit(EVENT_DEV_OPEN, &dev->flags)) {
 			if (!(skb_queue_len(&dev->txq) >= dev->tx_qlen))
 				netif_start_queue(dev->net);
-			tasklet_schedule(&dev->bh);
+			napi_schedule(&dev->napi);
 		}
 	}
 
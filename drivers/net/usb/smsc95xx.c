@@ -1996,7 +1996,7 @@ static int smsc95xx_rx_fixup(struct usbnet *dev, struct sk_buff *skb)
 		u32 header, align_count;
 		struct sk_buff *ax_skb;
 		unsigned char *packet;
-		u16 size;
+		u16 size, frame_len;
 
 		memcpy(&header, skb->data, sizeof(header));
 		le32_to_cpus(&header);
@@ -2042,19 +2042,21 @@ static int smsc95xx_rx_fixup(struct usbnet *dev, struct sk_buff *skb)
 				return 1;
 			}
 
-			ax_skb = skb_clone(skb, GFP_ATOMIC);
+			/* leave the checksum and fcs trailers behind */
+			frame_len = size - 4;
+			if (dev->net->features & NETIF_F_RXCSUM)
+				frame_len -= 2;
+
+			ax_skb = usbnet_rx_frag(dev, packet, frame_len);
 			if (unlikely(!ax_skb)) {
 				netdev_warn(dev->net, "Error allocating skb\n");
 				return 0;
 			}
 
-			ax_skb->len = size;
-			ax_skb->data = packet;
-			skb_set_tail_pointer(ax_skb, size);
-
-			if (dev->net->features & NETIF_F_RXCSUM)
-				smsc95xx_rx_csum_offload(ax_skb);
-			skb_trim(ax_skb, ax_skb->len - 4); /* remove fcs */
+			if (dev->net->features & NETIF_F_RXCSUM) {
+				ax_skb->csum = *(u16 *)(packet + size - 2);
+				ax_skb->ip_summed = CHECKSUM_COMPLETE;
+			}
 			if (truesize_mode)
 				ax_skb->truesize = size + sizeof(struct sk_buff);
 
@@ -2162,7 +2164,8 @@ static const struct driver_info smsc95xx_info = {
 	.tx_fixup	= smsc95xx_tx_fixup,
 	.status		= smsc95xx_status,
 	.manage_power	= smsc95xx_manage_power,
-	.flags		= FLAG_ETHER | FLAG_SEND_ZLP | FLAG_LINK_INTR,
+	.flags		= FLAG_ETHER | FLAG_SEND_ZLP | FLAG_LINK_INTR |
+			  FLAG_NAPI,
 };
 
 static const struct usb_device_id products[] = {
@@ -328,6 +328,9 @@ void usbnet_skb_return (struct usbnet *dev, struct sk_buff *skb)
 		return;
 	}
 
+	if (dev->driver_info->flags & FLAG_NAPI)
+		dev->napi_work++;
+
 	/* only update if unset to allow minidriver rx_fixup override */
 	if (skb->protocol == 0)
 		skb->protocol = eth_type_trans (skb, dev->net);
@@ -344,6 +347,13 @@ void usbnet_skb_return (struct usbnet *dev, struct sk_buff *skb)
 	if (skb_defer_rx_timestamp(skb))
 		return;
 
+	if (dev->driver_info->flags & FLAG_NAPI) {
+		if (napi_gro_receive(&dev->napi, skb) == GRO_DROP)
+			netif_dbg(dev, rx_err, dev->net,
+				  "napi_gro_receive dropped\n");
+		return;
+	}
+
 	status = netif_rx (skb);
 	if (status != NET_RX_SUCCESS)
 		netif_dbg(dev, rx_err, dev->net,
@@ -351,6 +361,47 @@ void usbnet_skb_return (struct usbnet *dev, struct sk_buff *skb)
 }
 EXPORT_SYMBOL_GPL(usbnet_skb_return);
 
+/* Frames up to this size are copied whole and longer ones only have
+ * their headers copied, which is enough for eth_type_trans() and GRO.
+ */
+#define USBNET_RX_COPY_HDR	128
+
+/**
+ * usbnet_rx_frag - wrap one frame of an RX URB buffer in its own skb
+ * @dev: usbnet device running with FLAG_NAPI
+ * @data: start of the frame within the URB buffer
+ * @len: length of the frame
+ *
+ * For use from rx_fixup. The frame's headers are copied into a small
+ * linear skb and the rest is attached as a fragment of the page backing
+ * the URB buffer, so the payload is not copied and the buffer lives
+ * until the last frame referencing it is freed.
+ *
+ * Return: the new skb, ready for usbnet_skb_return(), or NULL.
+ */
+struct sk_buff *usbnet_rx_frag(struct usbnet *dev, void *data, unsigned int len)
+{
+	unsigned int hlen = min_t(unsigned int, len, USBNET_RX_COPY_HDR);
+	struct sk_buff *skb;
+	struct page *page;
+
+	skb = napi_alloc_skb(&dev->napi, hlen);
+	if (!skb)
+		return NULL;
+
+	skb_put_data(skb, data, hlen);
+	if (len > hlen) {
+		page = virt_to_head_page(data);
+		get_page(page);
+		skb_add_rx_frag(skb, 0, page,
+				data + hlen - page_address(page),
+				len - hlen, len - hlen);
+	}
+
+	return skb;
+}
+EXPORT_SYMBOL_GPL(usbnet_rx_frag);
+
 /* must be called if hard_mtu or rx_urb_size changed */
 void usbnet_update_max_qlen(struct usbnet *dev)
 {
@@ -428,6 +479,14 @@ static void __usbnet_queue_skb(struct sk_buff_head *list,
 
 /*-------------------------------------------------------------------------*/
 
+static void usbnet_bh_schedule(struct usbnet *dev)
+{
+	if (dev->driver_info->flags & FLAG_NAPI)
+		napi_schedule(&dev->napi);
+	else
+		tasklet_schedule(&dev->bh);
+}
+
 /* some LK 2.4 HCDs oopsed if we freed or resubmitted urbs from
  * completion callbacks.  2.5 should have fixed those bugs...
  */
@@ -452,7 +511,7 @@ static enum skb_state defer_bh(struct usbnet *dev, struct sk_buff *skb,
 
 	__skb_queue_tail(&dev->done, skb);
 	if (dev->done.qlen == 1)
-		tasklet_schedule(&dev->bh);
+		usbnet_bh_schedule(dev);
 	spin_unlock(&dev->done.lock);
 	spin_unlock_irqrestore(&list->lock, flags);
 	return old_state;
@@ -477,6 +536,38 @@ EXPORT_SYMBOL_GPL(usbnet_defer_kevent);
 
 static void rx_complete (struct urb *urb);
 
+/* NAPI mode RX buffers sit in their own pages for usbnet_rx_frag() */
+static struct sk_buff *usbnet_alloc_rx_page_skb(struct usbnet *dev,
+						size_t size, gfp_t flags)
+{
+	unsigned int headroom = NET_SKB_PAD;
+	unsigned int truesize, order;
+	struct sk_buff *skb;
+	struct page *page;
+
+	if (!test_bit(EVENT_NO_IP_ALIGN, &dev->flags))
+		headroom += NET_IP_ALIGN;
+
+	truesize = SKB_DATA_ALIGN(headroom + size) +
+		   SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+	order = get_order(truesize);
+
+	page = __dev_alloc_pages(flags, order);
+	if (!page)
+		return NULL;
+
+	skb = build_skb(page_address(page), PAGE_SIZE << order);
+	if (!skb) {
+		__free_pages(page, order);
+		return NULL;
+	}
+
+	skb_reserve(skb, headroom);
+	skb->dev = dev->net;
+
+	return skb;
+}
+
 static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 {
 	struct sk_buff		*skb;
@@ -491,7 +582,9 @@ static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 		return -ENOLINK;
 	}
 
-	if (test_bit(EVENT_NO_IP_ALIGN, &dev->flags))
+	if (dev->driver_info->flags & FLAG_NAPI)
+		skb = usbnet_alloc_rx_page_skb(dev, size, flags);
+	else if (test_bit(EVENT_NO_IP_ALIGN, &dev->flags))
 		skb = __netdev_alloc_skb(dev->net, size, flags);
 	else
 		skb = __netdev_alloc_skb_ip_align(dev->net, size, flags);
@@ -534,7 +627,7 @@ static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 		default:
 			netif_dbg(dev, rx_err, dev->net,
 				  "rx submit, %d\n", retval);
-			tasklet_schedule (&dev->bh);
+			usbnet_bh_schedule(dev);
 			break;
 		case 0:
 			__usbnet_queue_skb(&dev->rxq, skb, rx_start);
@@ -691,12 +784,16 @@ void usbnet_resume_rx(struct usbnet *dev)
 
 	clear_bit(EVENT_RX_PAUSED, &dev->flags);
 
-	while ((skb = skb_dequeue(&dev->rxq_pause)) != NULL) {
-		usbnet_skb_return(dev, skb);
-		num++;
-	}
+	/* with NAPI the paused frames are handed up from usbnet_poll() */
+	if (dev->driver_info->flags & FLAG_NAPI)
+		num = skb_queue_len(&dev->rxq_pause);
+	else
+		while ((skb = skb_dequeue(&dev->rxq_pause)) != NULL) {
+			usbnet_skb_return(dev, skb);
+			num++;
+		}
 
-	tasklet_schedule(&dev->bh);
+	usbnet_bh_schedule(dev);
 
 	netif_dbg(dev, rx_status, dev->net,
 		  "paused rx queue disabled, %d skbs requeued\n", num);
@@ -765,7 +862,7 @@ void usbnet_unlink_rx_urbs(struct usbnet *dev)
 {
 	if (netif_running(dev->net)) {
 		(void) unlink_urbs (dev, &dev->rxq);
-		tasklet_schedule(&dev->bh);
+		usbnet_bh_schedule(dev);
 	}
 }
 EXPORT_SYMBOL_GPL(usbnet_unlink_rx_urbs);
@@ -851,7 +948,10 @@ int usbnet_stop (struct net_device *net)
 	 */
 	dev->flags = 0;
 	del_timer_sync (&dev->delay);
-	tasklet_kill (&dev->bh);
+	if (info->flags & FLAG_NAPI)
+		napi_disable(&dev->napi);
+	else
+		tasklet_kill(&dev->bh);
 	if (!pm)
 		usb_autopm_put_interface(dev->intf);
 
@@ -917,6 +1017,8 @@ int usbnet_open (struct net_device *net)
 	}
 
 	set_bit(EVENT_DEV_OPEN, &dev->flags);
+	if (info->flags & FLAG_NAPI)
+		napi_enable(&dev->napi);
 	netif_start_queue (net);
 	netif_info(dev, ifup, dev->net,
 		   "open: enable queueing (rx %d, tx %d) mtu %d %s framing\n",
@@ -935,7 +1037,7 @@ int usbnet_open (struct net_device *net)
 	clear_bit(EVENT_RX_KILL, &dev->flags);
 
 	// delay posting reads until we're fully open
-	tasklet_schedule (&dev->bh);
+	usbnet_bh_schedule(dev);
 	if (info->manage_power) {
 		retval = info->manage_power(dev, 1);
 		if (retval < 0) {
@@ -1111,7 +1213,7 @@ static void __handle_link_change(struct usbnet *dev)
 		 */
 	} else {
 		/* submitting URBs for reading packets */
-		tasklet_schedule(&dev->bh);
+		usbnet_bh_schedule(dev);
 	}
 
 	/* hard_mtu or rx_urb_size may change during link change */
@@ -1184,7 +1286,7 @@ usbnet_deferred_kevent (struct work_struct *work)
 					   status);
 		} else {
 			clear_bit (EVENT_RX_HALT, &dev->flags);
-			tasklet_schedule (&dev->bh);
+			usbnet_bh_schedule(dev);
 		}
 	}
 
@@ -1209,7 +1311,7 @@ usbnet_deferred_kevent (struct work_struct *work)
 			usb_autopm_put_interface(dev->intf);
 fail_lowmem:
 			if (resched)
-				tasklet_schedule (&dev->bh);
+				usbnet_bh_schedule(dev);
 		}
 	}
 
@@ -1310,7 +1412,7 @@ void usbnet_tx_timeout (struct net_device *net)
 	struct usbnet		*dev = netdev_priv(net);
 
 	unlink_urbs (dev, &dev->txq);
-	tasklet_schedule (&dev->bh);
+	usbnet_bh_schedule(dev);
 	/* this needs to be handled individually because the generic layer
 	 * doesn't know what is sufficient and could not restore private
 	 * information if a remedy of an unconditional reset were used.
@@ -1524,15 +1626,15 @@ static int rx_alloc_submit(struct usbnet *dev, gfp_t flags)
 
 /*-------------------------------------------------------------------------*/
 
-// tasklet (work deferred from completions, in_irq) or timer
+// tasklet or NAPI poll (work deferred from completions, in_irq)
+// returns true if it wants to run again
 
-static void usbnet_bh (struct timer_list *t)
+static bool __usbnet_bh(struct usbnet *dev, int budget)
 {
-	struct usbnet		*dev = from_timer(dev, t, delay);
 	struct sk_buff		*skb;
 	struct skb_data		*entry;
 
-	while ((skb = skb_dequeue (&dev->done))) {
+	while (dev->napi_work < budget && (skb = skb_dequeue(&dev->done))) {
 		entry = (struct skb_data *) skb->cb;
 		switch (entry->state) {
 		case rx_done:
@@ -1571,17 +1673,60 @@ static void usbnet_bh (struct timer_list *t)
 
 		if (temp < RX_QLEN(dev)) {
 			if (rx_alloc_submit(dev, GFP_ATOMIC) == -ENOLINK)
-				return;
+				return false;
 			if (temp != dev->rxq.qlen)
 				netif_dbg(dev, link, dev->net,
 					  "rxqlen %d --> %d\n",
 					  temp, dev->rxq.qlen);
 			if (dev->rxq.qlen < RX_QLEN(dev))
-				tasklet_schedule (&dev->bh);
+				return true;
 		}
 		if (dev->txq.qlen < TX_QLEN (dev))
 			netif_wake_queue (dev->net);
 	}
+
+	return false;
+}
+
+// tasklet or timer
+
+static void usbnet_bh (struct timer_list *t)
+{
+	struct usbnet		*dev = from_timer(dev, t, delay);
+
+	if (dev->driver_info->flags & FLAG_NAPI)
+		napi_schedule(&dev->napi);
+	else if (__usbnet_bh(dev, INT_MAX))
+		tasklet_schedule(&dev->bh);
+}
+
+static int usbnet_poll(struct napi_struct *napi, int budget)
+{
+	struct usbnet		*dev = container_of(napi, struct usbnet, napi);
+	struct sk_buff		*skb;
+
+	dev->napi_work = 0;
+
+	while (dev->napi_work < budget &&
+	       !test_bit(EVENT_RX_PAUSED, &dev->flags) &&
+	       (skb = skb_dequeue(&dev->rxq_pause)))
+		usbnet_skb_return(dev, skb);
+
+	if (__usbnet_bh(dev, budget) || dev->napi_work >= budget)
+		return budget;
+
+	napi_complete_done(napi, dev->napi_work);
+
+	/* defer_bh() and usbnet_resume_rx() only schedule NAPI, which is
+	 * a no-op until the poll has completed, so look again for work
+	 * that arrived after the queues were drained
+	 */
+	if (!skb_queue_empty(&dev->done) ||
+	    (!test_bit(EVENT_RX_PAUSED, &dev->flags) &&
+	     !skb_queue_empty(&dev->rxq_pause)))
+		napi_schedule(napi);
+
+	return dev->napi_work;
 }
 
 
@@ -1716,6 +1861,8 @@ usbnet_probe (struct usb_interface *udev, const struct usb_device_id *prod)
 	INIT_WORK (&dev->kevent, usbnet_deferred_kevent);
 	init_usb_anchor(&dev->deferred);
 	timer_setup(&dev->delay, usbnet_bh, 0);
+	if (info->flags & FLAG_NAPI)
+		netif_napi_add(net, &dev->napi, usbnet_poll, NAPI_POLL_WEIGHT);
 	mutex_init (&dev->phy_mutex);
 	mutex_init(&dev->interrupt_mutex);
 	dev->interrupt_count = 0;
@@ -1931,7 +2078,7 @@ int usbnet_resume (struct usb_interface *intf)
 
 			if (!(dev->txq.qlen >= TX_QLEN(dev)))
 				netif_tx_wake_all_queues(dev->net);
-			tasklet_schedule (&dev->bh);
+			usbnet_bh_schedule(dev);
 		}
 	}
 
@@ -34,6 +34,7 @@
 #include <linux/pci.h>
 #include <net/route.h>
 #include <net/xdp.h>
+#include <net/xdp_sock.h>
 #include <net/net_failover.h>
 
 static int napi_weight = NAPI_POLL_WEIGHT;
@@ -59,6 +60,13 @@ module_param(napi_tx, bool, 0644);
 
 #define VIRTIO_XDP_FLAG	BIT(0)
 
+/* AF_XDP zero-copy frames carry their length in the token instead */
+#define VIRTIO_XSK_FLAG	BIT(1)
+#define VIRTIO_XSK_FLAG_OFFSET	2
+
+/* An AF_XDP frame takes two slots and must still leave room for an skb */
+#define VIRTNET_XSK_MIN_FREE	(2 + 2 + MAX_SKB_FRAGS)
+
 /* RX packet size EWMA. The average packet size is used to determine the packet
  * buffer size when refilling RX rings. As the entire RX ring may be refilled
  * at once, the weight is chosen so that the EWMA will be insensitive to short-
@@ -141,6 +149,17 @@ struct send_queue {
 	struct virtnet_sq_stats stats;
 
 	struct napi_struct napi;
+
+	struct {
+		/* AF_XDP umem bound to this queue for zero-copy TX */
+		struct xdp_umem __rcu *umem;
+
+		/* Frames from the umem still owned by the device */
+		u32 inflight;
+
+		/* Zeroed virtio header shared by all AF_XDP frames */
+		struct virtio_net_hdr_mrg_rxbuf hdr;
+	} xsk;
 };
 
 /* Internal representation of a receive virtqueue */
@@ -268,6 +287,22 @@ static struct xdp_frame *ptr_to_xdp(void *ptr)
 	return (struct xdp_frame *)((unsigned long)ptr & ~VIRTIO_XDP_FLAG);
 }
 
+static bool is_xsk_frame(void *ptr)
+{
+	return (unsigned long)ptr & VIRTIO_XSK_FLAG;
+}
+
+static void *xsk_to_ptr(u32 len)
+{
+	return (void *)((unsigned long)len << VIRTIO_XSK_FLAG_OFFSET |
+			VIRTIO_XSK_FLAG);
+}
+
+static u32 ptr_to_xsk(void *ptr)
+{
+	return (unsigned long)ptr >> VIRTIO_XSK_FLAG_OFFSET;
+}
+
 /* Converting between virtqueue no. and kernel tx/rx queue no.
  * 0:rx0 1:tx0 2:rx1 3:tx1 ... 2N:rxN 2N+1:txN 2N+2:cvq
  */
@@ -1360,21 +1395,38 @@ static int virtnet_receive(struct receive_queue *rq, int budget,
 	return stats.packets;
 }
 
+static void virtnet_xsk_complete(struct send_queue *sq, u32 num)
+{
+	struct xdp_umem *umem;
+
+	sq->xsk.inflight -= num;
+
+	rcu_read_lock();
+	umem = rcu_dereference(sq->xsk.umem);
+	if (umem)
+		xsk_umem_complete_tx(umem, num);
+	rcu_read_unlock();
+}
+
 static void free_old_xmit_skbs(struct send_queue *sq, bool in_napi)
 {
 	unsigned int len;
 	unsigned int packets = 0;
 	unsigned int bytes = 0;
+	unsigned int xsk = 0;
 	void *ptr;
 
 	while ((ptr = virtqueue_get_buf(sq->vq, &len)) != NULL) {
-		if (likely(!is_xdp_frame(ptr))) {
+		if (likely(!is_xdp_frame(ptr) && !is_xsk_frame(ptr))) {
 			struct sk_buff *skb = ptr;
 
 			pr_debug("Sent skb %p\n", skb);
 
 			bytes += skb->len;
 			napi_consume_skb(skb, in_napi);
+		} else if (is_xsk_frame(ptr)) {
+			bytes += ptr_to_xsk(ptr);
+			xsk++;
 		} else {
 			struct xdp_frame *frame = ptr_to_xdp(ptr);
 
@@ -1390,12 +1442,86 @@ static void free_old_xmit_skbs(struct send_queue *sq, bool in_napi)
 	if (!packets)
 		return;
 
+	if (xsk)
+		virtnet_xsk_complete(sq, xsk);
+
 	u64_stats_update_begin(&sq->stats.syncp);
 	sq->stats.bytes += bytes;
 	sq->stats.packets += packets;
 	u64_stats_update_end(&sq->stats.syncp);
 }
 
+/* Post up to @budget frames from the AF_XDP TX rings bound to @sq. The
+ * umem memory is handed to the device as is, behind a shared zeroed
+ * header. Called with the TX queue lock held. Returns true if the budget
+ * ran out before the rings did.
+ */
+static bool virtnet_xsk_xmit(struct send_queue *sq, int budget)
+{
+	struct virtnet_info *vi = sq->vq->vdev->priv;
+	struct xdp_umem *umem;
+	struct xdp_desc desc;
+	bool rechecked = false;
+	int sent = 0;
+	int err;
+
+	rcu_read_lock();
+	umem = rcu_dereference(sq->xsk.umem);
+	if (!umem)
+		goto out;
+
+again:
+	while (sent < budget && sq->vq->num_free >= VIRTNET_XSK_MIN_FREE) {
+		if (!xsk_umem_consume_tx(umem, &desc))
+			break;
+
+		sg_init_table(sq->sg, 2);
+		sg_set_buf(sq->sg, &sq->xsk.hdr, vi->hdr_len);
+		sg_set_buf(sq->sg + 1, xdp_umem_get_data(umem, desc.addr),
+			   desc.len);
+
+		err = virtqueue_add_outbuf(sq->vq, sq->sg, 2,
+					   xsk_to_ptr(desc.len), GFP_ATOMIC);
+		if (unlikely(err)) {
+			/* The completion slot is taken, hand it back unsent */
+			xsk_umem_complete_tx(umem, 1);
+			break;
+		}
+		sq->xsk.inflight++;
+		sent++;
+	}
+
+	if (sent) {
+		if (virtqueue_kick_prepare(sq->vq) && virtqueue_notify(sq->vq)) {
+			u64_stats_update_begin(&sq->stats.syncp);
+			sq->stats.kicks++;
+			u64_stats_update_end(&sq->stats.syncp);
+		}
+		xsk_umem_consume_tx_done(umem);
+	}
+
+	if (xsk_umem_uses_need_wakeup(umem)) {
+		/* With TX napi a completion interrupt is pending for anything
+		 * in flight, and the poll will pick up new descriptors.
+		 * Otherwise userspace has to kick us.
+		 */
+		if (sq->napi.weight && sq->xsk.inflight) {
+			xsk_clear_tx_need_wakeup(umem);
+		} else {
+			xsk_set_tx_need_wakeup(umem);
+			/* Catch descriptors queued before the flag was seen */
+			smp_mb();
+			if (!rechecked && sent < budget) {
+				rechecked = true;
+				goto again;
+			}
+		}
+	}
+out:
+	rcu_read_unlock();
+	return sent >= budget;
+}
+
 static bool is_xdp_raw_buffer_queue(struct virtnet_info *vi, int q)
 {
 	if (q < (vi->curr_queue_pairs - vi->xdp_queue_pairs))
@@ -1492,6 +1618,7 @@ static int virtnet_poll_tx(struct napi_struct *napi, int budget)
 	struct virtnet_info *vi = sq->vq->vdev->priv;
 	unsigned int index = vq2txq(sq->vq);
 	struct netdev_queue *txq;
+	bool busy;
 
 	if (unlikely(is_xdp_raw_buffer_queue(vi, index))) {
 		/* We don't need to enable cb for XDP */
@@ -1502,8 +1629,12 @@ static int virtnet_poll_tx(struct napi_struct *napi, int budget)
 	txq = netdev_get_tx_queue(vi->dev, index);
 	__netif_tx_lock(txq, raw_smp_processor_id());
 	free_old_xmit_skbs(sq, true);
+	busy = virtnet_xsk_xmit(sq, budget);
 	__netif_tx_unlock(txq);
 
+	if (busy)
+		return budget;
+
 	virtqueue_napi_complete(napi, sq->vq, 0);
 
 	if (sq->vq->num_free >= 2 + MAX_SKB_FRAGS)
@@ -2055,7 +2186,7 @@ static int virtnet_set_channels(struct net_device *dev,
 {
 	struct virtnet_info *vi = netdev_priv(dev);
 	u16 queue_pairs = channels->combined_count;
-	int err;
+	int i, err;
 
 	/* We don't support separate rx/tx channels.
 	 * We don't allow setting 'other' channels.
@@ -2073,6 +2204,11 @@ static int virtnet_set_channels(struct net_device *dev,
 	if (vi->rq[0].xdp_prog)
 		return -EINVAL;
 
+	/* Nor dropping a queue an AF_XDP socket transmits on */
+	for (i = queue_pairs; i < vi->curr_queue_pairs; i++)
+		if (rtnl_dereference(vi->sq[i].xsk.umem))
+			return -EBUSY;
+
 	get_online_cpus();
 	err = _virtnet_set_queues(vi, queue_pairs);
 	if (!err) {
@@ -2488,14 +2624,125 @@ static u32 virtnet_xdp_query(struct net_device *dev)
 	return 0;
 }
 
+static int virtnet_xsk_umem_enable(struct virtnet_info *vi,
+				   struct xdp_umem *umem, u16 qid)
+{
+	struct send_queue *sq;
+
+	/* Only the regular TX queues, XDP_TX owns the ones past them */
+	if (qid >= vi->curr_queue_pairs - vi->xdp_queue_pairs)
+		return -EINVAL;
+
+	sq = &vi->sq[qid];
+	if (rtnl_dereference(sq->xsk.umem))
+		return -EBUSY;
+
+	rcu_assign_pointer(sq->xsk.umem, umem);
+	return 0;
+}
+
+static int virtnet_xsk_umem_disable(struct virtnet_info *vi, u16 qid)
+{
+	struct netdev_queue *txq;
+	struct send_queue *sq;
+	unsigned long timeout;
+
+	if (qid >= vi->max_queue_pairs)
+		return -EINVAL;
+
+	sq = &vi->sq[qid];
+	if (!rtnl_dereference(sq->xsk.umem))
+		return -EINVAL;
+
+	rcu_assign_pointer(sq->xsk.umem, NULL);
+	synchronize_net();
+
+	/* The umem pages are unpinned once we return, so wait for the
+	 * device to let go of the frames it still has from them. There is
+	 * no per-queue reset to take them back, and giving up would leave
+	 * the device reading freed memory, so only complain meanwhile.
+	 */
+	txq = netdev_get_tx_queue(vi->dev, qid);
+	timeout = jiffies + HZ;
+	while (READ_ONCE(sq->xsk.inflight)) {
+		if (time_after(jiffies, timeout)) {
+			netdev_warn(vi->dev, "TXQ %u: still waiting for %u AF_XDP frames\n",
+				    qid, sq->xsk.inflight);
+			timeout = jiffies + 10 * HZ;
+		}
+		__netif_tx_lock_bh(txq);
+		free_old_xmit_skbs(sq, false);
+		__netif_tx_unlock_bh(txq);
+		usleep_range(50, 100);
+	}
+
+	return 0;
+}
+
+static int virtnet_xsk_umem_setup(struct net_device *dev,
+				  struct xdp_umem *umem, u16 qid)
+{
+	struct virtnet_info *vi = netdev_priv(dev);
+
+	return umem ? virtnet_xsk_umem_enable(vi, umem, qid) :
+		      virtnet_xsk_umem_disable(vi, qid);
+}
+
+static int virtnet_xsk_wakeup(struct net_device *dev, u32 qid, u32 flags)
+{
+	struct virtnet_info *vi = netdev_priv(dev);
+	struct netdev_queue *txq;
+	struct send_queue *sq;
+
+	if (!netif_running(dev))
+		return -ENETDOWN;
+
+	if (qid >= vi->curr_queue_pairs - vi->xdp_queue_pairs)
+		return -EINVAL;
+
+	sq = &vi->sq[qid];
+	if (!rcu_access_pointer(sq->xsk.umem))
+		return -ENXIO;
+
+	/* RX is copied into the umem by XDP_REDIRECT, nothing to kick */
+	if (!(flags & XDP_WAKEUP_TX))
+		return 0;
+
+	local_bh_disable();
+	if (sq->napi.weight) {
+		virtqueue_napi_schedule(&sq->napi, sq->vq);
+	} else {
+		txq = netdev_get_tx_queue(dev, qid);
+		__netif_tx_lock(txq, smp_processor_id());
+		free_old_xmit_skbs(sq, false);
+		virtnet_xsk_xmit(sq, INT_MAX);
+		__netif_tx_unlock(txq);
+	}
+	local_bh_enable();
+
+	return 0;
+}
+
 static int virtnet_xdp(struct net_device *dev, struct netdev_bpf *xdp)
 {
+	struct virtnet_info *vi = netdev_priv(dev);
+	u16 qid;
+
 	switch (xdp->command) {
 	case XDP_SETUP_PROG:
 		return virtnet_xdp_set(dev, xdp->prog, xdp->extack);
 	case XDP_QUERY_PROG:
 		xdp->prog_id = virtnet_xdp_query(dev);
 		return 0;
+	case XDP_QUERY_XSK_UMEM:
+		qid = xdp->xsk.queue_id;
+		if (qid >= vi->max_queue_pairs)
+			return -EINVAL;
+		xdp->xsk.umem = rtnl_dereference(vi->sq[qid].xsk.umem);
+		return 0;
+	case XDP_SETUP_XSK_UMEM:
+		return virtnet_xsk_umem_setup(dev, xdp->xsk.umem,
+					      xdp->xsk.queue_id);
 	default:
 		return -EINVAL;
 	}
@@ -2529,6 +2776,7 @@ static const struct net_device_ops virtnet_netdev = {
 	.ndo_vlan_rx_kill_vid = virtnet_vlan_rx_kill_vid,
 	.ndo_bpf		= virtnet_xdp,
 	.ndo_xdp_xmit		= virtnet_xdp_xmit,
+	.ndo_xsk_wakeup		= virtnet_xsk_wakeup,
 	.ndo_features_check	= passthru_features_check,
 	.ndo_get_phys_port_name	= virtnet_get_phys_port_name,
 };
@@ -2632,7 +2880,9 @@ static void free_unused_bufs(struct virtnet_info *vi)
 	for (i = 0; i < vi->max_queue_pairs; i++) {
 		struct virtqueue *vq = vi->sq[i].vq;
 		while ((buf = virtqueue_detach_unused_buf(vq)) != NULL) {
-			if (!is_xdp_frame(buf))
+			if (is_xsk_frame(buf))
+				vi->sq[i].xsk.inflight--;
+			else if (!is_xdp_frame(buf))
 				dev_kfree_skb(buf);
 			else
 				xdp_return_frame(ptr_to_xdp(buf));
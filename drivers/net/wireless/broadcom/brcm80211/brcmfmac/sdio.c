@@ -34,6 +34,10 @@
 #include <linux/debugfs.h>
 #include <linux/vmalloc.h>
 #include <asm/unaligned.h>
+#include <net/codel.h>
+#include <net/codel_impl.h>
+#include <net/fq.h>
+#include <net/fq_impl.h>
 #include <defs.h>
 #include <brcmu_wifi.h>
 #include <brcmu_utils.h>
@@ -122,6 +126,9 @@ struct rte_console {
 
 #define BRCMF_TXMINMAX	1	/* Max tx frames if rx still pending */
 
+#define BRCMF_RXBOUND_MAX	(4 * BRCMF_RXBOUND)	/* Limits of the */
+#define BRCMF_TXBOUND_MAX	(4 * BRCMF_TXBOUND)	/* adaptive bounds */
+
 #define MEMBLOCK	2048	/* Block size used for downloading
 				 of dongle image */
 #define MAX_DATA_BUF	(32 * 1024)	/* Must be large enough to hold
@@ -129,6 +136,25 @@ struct rte_console {
 
 #define BRCMF_FIRSTREAD	(1 << 6)
 
+/* Data frames wait in per-flow fair queues, one tin per precedence, and
+ * are only moved to bus->txq, which the dpc sends from, a glom or two at
+ * a time. That keeps the standing queue where fq and CoDel can act on it.
+ */
+#define BRCMF_SDIO_FQ_FLOWS	1024
+#define BRCMF_SDIO_TXQ_DEPTH	64
+
+/* CoDel enqueue time, kept clear of the bus flags and fwsignal state at
+ * the front of skb->cb
+ */
+#define brcmf_sdio_txtime(skb) \
+	(*(codel_time_t *)&(skb)->cb[sizeof((skb)->cb) - sizeof(codel_time_t)])
+
+static const char * const brcmf_sdio_ac_names[] = { "BK", "BE", "VI", "VO" };
+
+/* precedence 0-1 carry BK, 2-3 BE, 4-5 VI and 6-7 VO, see prio2prec() */
+#define BRCMF_SDIO_PREC_AC(prec)	((prec) / 2)
+#define BRCMF_SDIO_NUM_AC		ARRAY_SIZE(brcmf_sdio_ac_names)
+
 #define BRCMF_CONSOLE	10	/* watchdog interval to poll console */
 
 /* SBSDIO_DEVICE_CTL */
@@ -425,6 +451,10 @@ struct brcmf_sdio_count {
 	uint rxglomfail;	/* Failed deglom attempts */
 	uint rxglomframes;	/* Number of glom frames (superframes) */
 	uint rxglompkts;	/* Number of packets from glom frames */
+	uint txglomframes;	/* Number of tx glom frames (superframes) */
+	uint txglompkts;	/* Number of packets sent in tx glom frames */
+	uint rxbound_hits;	/* Dpc passes that used the whole rxbound */
+	uint txbound_hits;	/* Dpc passes that used the whole txbound */
 	uint f2rxhdrs;		/* Number of header reads */
 	uint f2rxdata;		/* Number of frame data reads */
 	uint f2txdata;		/* Number of f2 frame writes */
@@ -437,6 +467,22 @@ struct brcmf_sdio_count {
 	ulong rx_readahead_cnt;	/* packets where header read-ahead was used */
 };
 
+/* tx queueing latency, from brcmf_sdio_bus_txdata() to bus->txq */
+struct brcmf_sdio_ac_lat {
+	u32 pkts;		/* Packets moved to bus->txq */
+	u64 total_us;		/* Sum of their queueing latency */
+	u32 max_us;		/* Largest queueing latency seen */
+};
+
+/* fair queueing state for one precedence */
+struct brcmf_sdio_tin {
+	struct brcmf_sdio *bus;
+	struct fq_tin tin;
+	struct fq_flow def_flow;	/* Used on flow hash collisions */
+	struct codel_vars def_cvars;
+	struct codel_stats cstats;
+};
+
 /* misc chip info needed by some of the routines */
 /* Private data for SDIO bus interaction */
 struct brcmf_sdio {
@@ -506,7 +552,13 @@ struct brcmf_sdio {
 	bool ctrl_frame_stat;
 	int ctrl_frame_err;
 
-	spinlock_t txq_lock;		/* protect bus->txq */
+	spinlock_t txq_lock;		/* protect bus->txq, fq and txdrop */
+	struct fq fq;
+	struct codel_vars *cvars;	/* One per fq flow */
+	struct codel_params cparams;
+	struct brcmf_sdio_tin tins[PRIOMASK + 1];
+	struct sk_buff_head txdrop;	/* Dropped, awaiting tx completion */
+	struct brcmf_sdio_ac_lat ac_lat[BRCMF_SDIO_NUM_AC];
 	wait_queue_head_t ctrl_wait;
 	wait_queue_head_t dcmd_resp_wait;
 
@@ -2289,6 +2341,174 @@ static int brcmf_sdio_txpkt(struct brcmf_sdio *bus, struct sk_buff_head *pktq,
 	return ret;
 }
 
+static void brcmf_sdio_fq_drop(struct fq *fq, struct fq_tin *tin,
+			       struct fq_flow *flow, struct sk_buff *pkt)
+{
+	struct brcmf_sdio *bus = container_of(fq, struct brcmf_sdio, fq);
+
+	__skb_queue_tail(&bus->txdrop, pkt);
+}
+
+static struct fq_flow *brcmf_sdio_fq_default_flow(struct fq *fq,
+						  struct fq_tin *tin, int idx,
+						  struct sk_buff *pkt)
+{
+	return &container_of(tin, struct brcmf_sdio_tin, tin)->def_flow;
+}
+
+static u32 brcmf_sdio_codel_len(const struct sk_buff *pkt)
+{
+	return pkt->len;
+}
+
+static codel_time_t brcmf_sdio_codel_time(const struct sk_buff *pkt)
+{
+	return brcmf_sdio_txtime(pkt);
+}
+
+static struct sk_buff *brcmf_sdio_codel_dequeue(struct codel_vars *cvars,
+						void *ctx)
+{
+	struct brcmf_sdio_tin *btin = ctx;
+	struct brcmf_sdio *bus = btin->bus;
+	struct fq_flow *flow;
+
+	if (cvars == &btin->def_cvars)
+		flow = &btin->def_flow;
+	else
+		flow = &bus->fq.flows[cvars - bus->cvars];
+
+	return fq_flow_dequeue(&bus->fq, flow);
+}
+
+static void brcmf_sdio_codel_drop(struct sk_buff *pkt, void *ctx)
+{
+	struct brcmf_sdio_tin *btin = ctx;
+
+	__skb_queue_tail(&btin->bus->txdrop, pkt);
+}
+
+static struct sk_buff *brcmf_sdio_fq_dequeue(struct fq *fq,
+					     struct fq_tin *tin,
+					     struct fq_flow *flow)
+{
+	struct brcmf_sdio *bus = container_of(fq, struct brcmf_sdio, fq);
+	struct brcmf_sdio_tin *btin;
+	struct codel_vars *cvars;
+
+	btin = container_of(tin, struct brcmf_sdio_tin, tin);
+	if (flow == &btin->def_flow)
+		cvars = &btin->def_cvars;
+	else
+		cvars = &bus->cvars[flow - fq->flows];
+
+	return codel_dequeue(btin, &flow->backlog, &bus->cparams, cvars,
+			     &btin->cstats, brcmf_sdio_codel_len,
+			     brcmf_sdio_codel_time, brcmf_sdio_codel_drop,
+			     brcmf_sdio_codel_dequeue);
+}
+
+static bool brcmf_sdio_fq_match_all(struct fq *fq, struct fq_tin *tin,
+				    struct fq_flow *flow, struct sk_buff *pkt,
+				    void *data)
+{
+	return true;
+}
+
+/* moves a packet filtered out of a tin straight onto bus->txq */
+static void brcmf_sdio_fq_reclaim(struct fq *fq, struct fq_tin *tin,
+				  struct fq_flow *flow, struct sk_buff *pkt)
+{
+	struct brcmf_sdio *bus = container_of(fq, struct brcmf_sdio, fq);
+	struct brcmf_sdio_tin *btin;
+
+	btin = container_of(tin, struct brcmf_sdio_tin, tin);
+	if (!brcmu_pktq_penq(&bus->txq, btin - bus->tins, pkt))
+		__skb_queue_tail(&bus->txdrop, pkt);
+}
+
+static void brcmf_sdio_fq_free(struct fq *fq, struct fq_tin *tin,
+			       struct fq_flow *flow, struct sk_buff *pkt)
+{
+	brcmu_pkt_buf_free_skb(pkt);
+}
+
+/* number of data packets queued on precedences that are not flow
+ * controlled, both in the fair queues and on bus->txq
+ */
+static uint brcmf_sdio_txq_mlen(struct brcmf_sdio *bus)
+{
+	uint len = brcmu_pktq_mlen(&bus->txq, ~bus->flowcontrol);
+	int prec;
+
+	for (prec = 0; prec <= PRIOMASK; prec++)
+		if (!(bus->flowcontrol & BIT(prec)))
+			len += bus->tins[prec].tin.backlog_packets;
+
+	return len;
+}
+
+/* hand packets dropped by fq or CoDel back to the protocol layer */
+static void brcmf_sdio_txq_complete_drops(struct brcmf_sdio *bus)
+{
+	struct sk_buff_head drops;
+	struct sk_buff *pkt;
+
+	if (skb_queue_empty(&bus->txdrop))
+		return;
+
+	__skb_queue_head_init(&drops);
+	spin_lock_bh(&bus->txq_lock);
+	skb_queue_splice_init(&bus->txdrop, &drops);
+	spin_unlock_bh(&bus->txq_lock);
+
+	while ((pkt = __skb_dequeue(&drops))) {
+		skb_pull(pkt, bus->tx_hdrlen);
+		brcmf_proto_bcdc_txcomplete(bus->sdiodev->dev, pkt, false);
+	}
+}
+
+/* top bus->txq up from the fair queues, highest precedence first */
+static void brcmf_sdio_txq_refill(struct brcmf_sdio *bus)
+{
+	struct brcmf_sdio_ac_lat *lat;
+	struct sk_buff *pkt;
+	codel_time_t now;
+	u32 us;
+	int prec;
+
+	if (pktq_len(&bus->txq) >= BRCMF_SDIO_TXQ_DEPTH || !bus->fq.backlog)
+		goto drops;
+
+	spin_lock_bh(&bus->txq_lock);
+	spin_lock(&bus->fq.lock);
+	now = codel_get_time();
+	for (prec = PRIOMASK; prec >= 0; prec--) {
+		if (bus->flowcontrol & BIT(prec))
+			continue;
+
+		lat = &bus->ac_lat[BRCMF_SDIO_PREC_AC(prec)];
+		while (pktq_len(&bus->txq) < BRCMF_SDIO_TXQ_DEPTH) {
+			pkt = fq_tin_dequeue(&bus->fq, &bus->tins[prec].tin,
+					     brcmf_sdio_fq_dequeue);
+			if (!pkt)
+				break;
+
+			us = codel_time_to_us(now - brcmf_sdio_txtime(pkt));
+			lat->pkts++;
+			lat->total_us += us;
+			lat->max_us = max(lat->max_us, us);
+
+			brcmu_pktq_penq(&bus->txq, prec, pkt);
+		}
+	}
+	spin_unlock(&bus->fq.lock);
+	spin_unlock_bh(&bus->txq_lock);
+
+drops:
+	brcmf_sdio_txq_complete_drops(bus);
+}
+
 static uint brcmf_sdio_sendfromq(struct brcmf_sdio *bus, uint maxframes)
 {
 	struct sk_buff *pkt;
@@ -2305,6 +2525,8 @@ static uint brcmf_sdio_sendfromq(struct brcmf_sdio *bus, uint maxframes)
 
 	/* Send frames until the limit or some other event */
 	for (cnt = 0; (cnt < maxframes) && data_ok(bus);) {
+		brcmf_sdio_txq_refill(bus);
+
 		pkt_num = 1;
 		if (bus->txglom)
 			pkt_num = min_t(u8, bus->tx_max - bus->tx_seq,
@@ -2326,6 +2548,10 @@ static uint brcmf_sdio_sendfromq(struct brcmf_sdio *bus, uint maxframes)
 
 		ret = brcmf_sdio_txpkt(bus, &pktq, SDPCM_DATA_CHANNEL);
 
+		if (i > 1) {
+			bus->sdcnt.txglomframes++;
+			bus->sdcnt.txglompkts += i;
+		}
 		cnt += i;
 
 		/* In poll mode, need to check for other events */
@@ -2346,7 +2572,7 @@ static uint brcmf_sdio_sendfromq(struct brcmf_sdio *bus, uint maxframes)
 
 	/* Deflow-control stack if needed */
 	if ((bus->sdiodev->state == BRCMF_SDIOD_DATA) &&
-	    bus->txoff && (pktq_len(&bus->txq) < TXLOW)) {
+	    bus->txoff && (pktq_len(&bus->txq) + bus->fq.backlog < TXLOW)) {
 		bus->txoff = false;
 		brcmf_proto_bcdc_txflowblock(bus->sdiodev->dev, false);
 	}
@@ -2422,9 +2648,10 @@ static void brcmf_sdio_bus_stop(struct device *dev)
 	struct brcmf_sdio_dev *sdiodev = bus_if->bus_priv.sdio;
 	struct brcmf_sdio *bus = sdiodev->bus;
 	struct brcmf_core *core = bus->sdio_core;
+	struct sk_buff *pkt;
 	u32 local_hostintmask;
 	u8 saveclk;
-	int err;
+	int err, prec;
 
 	brcmf_dbg(TRACE, "Enter\n");
 
@@ -2468,6 +2695,15 @@ static void brcmf_sdio_bus_stop(struct device *dev)
 		sdio_release_host(sdiodev->func1);
 	}
 	/* Clear the data packet queues */
+	spin_lock_bh(&bus->txq_lock);
+	spin_lock(&bus->fq.lock);
+	for (prec = 0; prec <= PRIOMASK; prec++)
+		fq_tin_reset(&bus->fq, &bus->tins[prec].tin,
+			     brcmf_sdio_fq_free);
+	spin_unlock(&bus->fq.lock);
+	while ((pkt = __skb_dequeue(&bus->txdrop)))
+		brcmu_pkt_buf_free_skb(pkt);
+	spin_unlock_bh(&bus->txq_lock);
 	brcmu_pktq_flush(&bus->txq, true, NULL, NULL);
 
 	/* Clear any held glomming stuff */
@@ -2528,6 +2764,23 @@ static int brcmf_sdio_intr_rstatus(struct brcmf_sdio *bus)
 	return ret;
 }
 
+/*
+ * Double a per-dpc frame bound when the last pass used all of it and left
+ * work behind, and halve it again once a pass needs under a quarter. Deep
+ * queues then move in fewer passes, each of which costs interrupt status
+ * reads and writes over the bus.
+ */
+static void brcmf_sdio_adapt_bound(uint *bound, uint done, bool more,
+				   uint min, uint max, uint *hits)
+{
+	if (done >= *bound && more) {
+		(*hits)++;
+		*bound = min_t(uint, *bound * 2, max);
+	} else if (done < *bound / 4) {
+		*bound = max_t(uint, *bound / 2, min);
+	}
+}
+
 static void brcmf_sdio_dpc(struct brcmf_sdio *bus)
 {
 	struct brcmf_sdio_dev *sdiod = bus->sdiodev;
@@ -2536,6 +2789,7 @@ static void brcmf_sdio_dpc(struct brcmf_sdio *bus)
 	unsigned long intstatus;
 	uint txlimit = bus->txbound;	/* Tx frames to send before resched */
 	uint framecnt;			/* Temporary counter of tx/rx frames */
+	bool more;
 	int err = 0;
 
 	brcmf_dbg(SDIO, "Enter\n");
@@ -2633,7 +2887,10 @@ static void brcmf_sdio_dpc(struct brcmf_sdio *bus)
 
 	/* On frame indication, read available frames */
 	if ((intstatus & I_HMB_FRAME_IND) && (bus->clkstate == CLK_AVAIL)) {
-		brcmf_sdio_readframes(bus, bus->rxbound);
+		framecnt = brcmf_sdio_readframes(bus, bus->rxbound);
+		brcmf_sdio_adapt_bound(&bus->rxbound, framecnt, bus->rxpending,
+				       BRCMF_RXBOUND, BRCMF_RXBOUND_MAX,
+				       &bus->sdcnt.rxbound_hits);
 		if (!bus->rxpending)
 			intstatus &= ~I_HMB_FRAME_IND;
 	}
@@ -2659,11 +2916,17 @@ static void brcmf_sdio_dpc(struct brcmf_sdio *bus)
 	}
 	/* Send queued frames (limit 1 if rx may still be pending) */
 	if ((bus->clkstate == CLK_AVAIL) && !atomic_read(&bus->fcstate) &&
-	    brcmu_pktq_mlen(&bus->txq, ~bus->flowcontrol) && txlimit &&
+	    brcmf_sdio_txq_mlen(bus) && txlimit &&
 	    data_ok(bus)) {
-		framecnt = bus->rxpending ? min(txlimit, bus->txminmax) :
-					    txlimit;
-		brcmf_sdio_sendfromq(bus, framecnt);
+		if (bus->rxpending) {
+			brcmf_sdio_sendfromq(bus, min(txlimit, bus->txminmax));
+		} else {
+			framecnt = brcmf_sdio_sendfromq(bus, txlimit);
+			more = brcmf_sdio_txq_mlen(bus);
+			brcmf_sdio_adapt_bound(&bus->txbound, framecnt, more,
+					       BRCMF_TXBOUND, BRCMF_TXBOUND_MAX,
+					       &bus->sdcnt.txbound_hits);
+		}
 	}
 
 	if ((bus->sdiodev->state != BRCMF_SDIOD_DATA) || (err != 0)) {
@@ -2682,8 +2945,7 @@ static void brcmf_sdio_dpc(struct brcmf_sdio *bus)
 	} else if (atomic_read(&bus->intstatus) ||
 		   atomic_read(&bus->ipend) > 0 ||
 		   (!atomic_read(&bus->fcstate) &&
-		    brcmu_pktq_mlen(&bus->txq, ~bus->flowcontrol) &&
-		    data_ok(bus))) {
+		    brcmf_sdio_txq_mlen(bus) && data_ok(bus))) {
 		bus->dpc_triggered = true;
 	}
 }
@@ -2693,50 +2955,22 @@ static struct pktq *brcmf_sdio_bus_gettxq(struct device *dev)
 	struct brcmf_bus *bus_if = dev_get_drvdata(dev);
 	struct brcmf_sdio_dev *sdiodev = bus_if->bus_priv.sdio;
 	struct brcmf_sdio *bus = sdiodev->bus;
+	unsigned long flags;
+	int prec;
 
-	return &bus->txq;
-}
-
-static bool brcmf_sdio_prec_enq(struct pktq *q, struct sk_buff *pkt, int prec)
-{
-	struct sk_buff *p;
-	int eprec = -1;		/* precedence to evict from */
-
-	/* Fast case, precedence queue is not full and we are also not
-	 * exceeding total queue length
+	/* fwsignal only asks for the queue to clean it up, so everything
+	 * still waiting in the fair queues has to be on it first
 	 */
-	if (!pktq_pfull(q, prec) && !pktq_full(q)) {
-		brcmu_pktq_penq(q, prec, pkt);
-		return true;
-	}
-
-	/* Determine precedence from which to evict packet, if any */
-	if (pktq_pfull(q, prec)) {
-		eprec = prec;
-	} else if (pktq_full(q)) {
-		p = brcmu_pktq_peek_tail(q, &eprec);
-		if (eprec > prec)
-			return false;
-	}
+	spin_lock_irqsave(&bus->txq_lock, flags);
+	spin_lock(&bus->fq.lock);
+	for (prec = 0; prec <= PRIOMASK; prec++)
+		fq_tin_filter(&bus->fq, &bus->tins[prec].tin,
+			      brcmf_sdio_fq_match_all, NULL,
+			      brcmf_sdio_fq_reclaim);
+	spin_unlock(&bus->fq.lock);
+	spin_unlock_irqrestore(&bus->txq_lock, flags);
 
-	/* Evict if needed */
-	if (eprec >= 0) {
-		/* Detect queueing to unconfigured precedence */
-		if (eprec == prec)
-			return false;	/* refuse newer (incoming) packet */
-		/* Evict packet according to discard policy */
-		p = brcmu_pktq_pdeq_tail(q, eprec);
-		if (p == NULL)
-			brcmf_err("brcmu_pktq_pdeq_tail() failed\n");
-		brcmu_pkt_buf_free_skb(p);
-	}
-
-	/* Enqueue */
-	p = brcmu_pktq_penq(q, prec, pkt);
-	if (p == NULL)
-		brcmf_err("brcmu_pktq_penq() failed\n");
-
-	return p != NULL;
+	return &bus->txq;
 }
 
 static int brcmf_sdio_bus_txdata(struct device *dev, struct sk_buff *pkt)
@@ -2766,23 +3000,23 @@ static int brcmf_sdio_bus_txdata(struct device *dev, struct sk_buff *pkt)
 	spin_lock_bh(&bus->txq_lock);
 	/* reset bus_flags in packet cb */
 	*(u16 *)(pkt->cb) = 0;
-	if (!brcmf_sdio_prec_enq(&bus->txq, pkt, prec)) {
-		skb_pull(pkt, bus->tx_hdrlen);
-		brcmf_err("out of bus->txq !!!\n");
-		ret = -ENOSR;
-	} else {
-		ret = 0;
-	}
+	brcmf_sdio_txtime(pkt) = codel_get_time();
+	/* a full fq drops from the fattest flow rather than refusing pkt */
+	spin_lock(&bus->fq.lock);
+	fq_tin_enqueue(&bus->fq, &bus->tins[prec].tin, pkt,
+		       brcmf_sdio_fq_drop, brcmf_sdio_fq_default_flow);
+	spin_unlock(&bus->fq.lock);
+	ret = 0;
 
-	if (pktq_len(&bus->txq) >= TXHI) {
+	if (pktq_len(&bus->txq) + bus->fq.backlog >= TXHI) {
 		bus->txoff = true;
 		brcmf_proto_bcdc_txflowblock(dev, true);
 	}
 	spin_unlock_bh(&bus->txq_lock);
 
 #ifdef DEBUG
-	if (pktq_plen(&bus->txq, prec) > qcount[prec])
-		qcount[prec] = pktq_plen(&bus->txq, prec);
+	if (bus->tins[prec].tin.backlog_packets > qcount[prec])
+		qcount[prec] = bus->tins[prec].tin.backlog_packets;
 #endif
 
 	brcmf_sdio_trigger_dpc(bus);
@@ -3114,7 +3348,10 @@ static int brcmf_debugfs_sdio_count_read(struct seq_file *seq, void *data)
 		   "f2txdata:     %u\nf1regdata:    %u\n"
 		   "tickcnt:      %u\ntx_ctlerrs:   %lu\n"
 		   "tx_ctlpkts:   %lu\nrx_ctlerrs:   %lu\n"
-		   "rx_ctlpkts:   %lu\nrx_readahead: %lu\n",
+		   "rx_ctlpkts:   %lu\nrx_readahead: %lu\n"
+		   "txglomframes: %u\ntxglompkts:   %u\n"
+		   "rxbound:      %u\nrxbound_hits: %u\n"
+		   "txbound:      %u\ntxbound_hits: %u\n",
 		   sdcnt->intrcount, sdcnt->lastintrs,
 		   sdcnt->pollcnt, sdcnt->regfails,
 		   sdcnt->tx_sderrs, sdcnt->fcqueued,
@@ -3128,7 +3365,48 @@ static int brcmf_debugfs_sdio_count_read(struct seq_file *seq, void *data)
 		   sdcnt->f2txdata, sdcnt->f1regdata,
 		   sdcnt->tickcnt, sdcnt->tx_ctlerrs,
 		   sdcnt->tx_ctlpkts, sdcnt->rx_ctlerrs,
-		   sdcnt->rx_ctlpkts, sdcnt->rx_readahead_cnt);
+		   sdcnt->rx_ctlpkts, sdcnt->rx_readahead_cnt,
+		   sdcnt->txglomframes, sdcnt->txglompkts,
+		   sdiodev->bus->rxbound, sdcnt->rxbound_hits,
+		   sdiodev->bus->txbound, sdcnt->txbound_hits);
+
+	return 0;
+}
+
+static int brcmf_debugfs_sdio_txq_read(struct seq_file *seq, void *data)
+{
+	struct brcmf_bus *bus_if = dev_get_drvdata(seq->private);
+	struct brcmf_sdio *bus = bus_if->bus_priv.sdio->bus;
+	struct brcmf_sdio_ac_lat lat;
+	struct brcmf_sdio_tin *btin;
+	u32 backlog, drops, marks, overlimit;
+	int ac, prec;
+
+	seq_puts(seq, "ac  backlog  pkts       avg_us   max_us   codel_drops ecn_marks  overlimit\n");
+	for (ac = 0; ac < BRCMF_SDIO_NUM_AC; ac++) {
+		backlog = 0;
+		drops = 0;
+		marks = 0;
+		overlimit = 0;
+
+		spin_lock_bh(&bus->txq_lock);
+		lat = bus->ac_lat[ac];
+		for (prec = 0; prec <= PRIOMASK; prec++) {
+			if (BRCMF_SDIO_PREC_AC(prec) != ac)
+				continue;
+			btin = &bus->tins[prec];
+			backlog += btin->tin.backlog_packets;
+			drops += btin->cstats.drop_count;
+			marks += btin->cstats.ecn_mark;
+			overlimit += btin->tin.overlimit;
+		}
+		spin_unlock_bh(&bus->txq_lock);
+
+		seq_printf(seq, "%s  %-8u %-10u %-8llu %-8u %-11u %-10u %u\n",
+			   brcmf_sdio_ac_names[ac], backlog, lat.pkts,
+			   lat.pkts ? div_u64(lat.total_us, lat.pkts) : 0,
+			   lat.max_us, drops, marks, overlimit);
+	}
 
 	return 0;
 }
@@ -3149,6 +3427,8 @@ static void brcmf_sdio_debugfs_create(struct device *dev)
 	brcmf_debugfs_add_entry(drvr, "forensics", brcmf_sdio_forensic_read);
 	brcmf_debugfs_add_entry(drvr, "counters",
 				brcmf_debugfs_sdio_count_read);
+	brcmf_debugfs_add_entry(drvr, "txq_latency",
+				brcmf_debugfs_sdio_txq_read);
 	debugfs_create_u32("console_interval", 0644, dentry,
 			   &bus->console_interval);
 }
@@ -3847,6 +4127,7 @@ brcmf_sdio_probe_attach(struct brcmf_sdio *bus)
 	int reg_addr;
 	u32 reg_val;
 	u32 drivestrength;
+	int i;
 
 	sdiodev = bus->sdiodev;
 	sdio_claim_host(sdiodev->func1);
@@ -3960,6 +4241,28 @@ brcmf_sdio_probe_attach(struct brcmf_sdio *bus)
 
 	brcmu_pktq_init(&bus->txq, (PRIOMASK + 1), TXQLEN);
 
+	if (fq_init(&bus->fq, BRCMF_SDIO_FQ_FLOWS))
+		return false;
+	bus->fq.limit = TXQLEN;
+	bus->cvars = kcalloc(bus->fq.flows_cnt, sizeof(*bus->cvars),
+			     GFP_KERNEL);
+	if (!bus->cvars)
+		return false;
+	for (i = 0; i < bus->fq.flows_cnt; i++)
+		codel_vars_init(&bus->cvars[i]);
+	codel_params_init(&bus->cparams);
+	bus->cparams.interval = MS2TIME(100);
+	bus->cparams.target = MS2TIME(20);
+	bus->cparams.ecn = true;
+	for (i = 0; i <= PRIOMASK; i++) {
+		bus->tins[i].bus = bus;
+		fq_tin_init(&bus->tins[i].tin);
+		fq_flow_init(&bus->tins[i].def_flow);
+		codel_vars_init(&bus->tins[i].def_cvars);
+		codel_stats_init(&bus->tins[i].cstats);
+	}
+	skb_queue_head_init(&bus->txdrop);
+
 	/* allocate header buffer */
 	bus->hdrbuf = kzalloc(MAX_HDR_READ + bus->head_align, GFP_KERNEL);
 	if (!bus->hdrbuf)
@@ -4371,6 +4674,8 @@ void brcmf_sdio_remove(struct brcmf_sdio *bus)
 		if (bus->sdiodev->settings)
 			brcmf_release_module_param(bus->sdiodev->settings);
 
+		fq_reset(&bus->fq, brcmf_sdio_fq_free);
+		kfree(bus->cvars);
 		kfree(bus->rxbuf);
 		kfree(bus->hdrbuf);
 		kfree(bus);
@@ -314,6 +314,35 @@ static int bcm2835_gpio_get(struct gpio_chip *chip, unsigned offset)
 	return bcm2835_gpio_get_bit(pc, GPLEV0, offset);
 }
 
+/* the 32 lines of @bank as they are laid out in a gpiolib bitmap */
+static inline u32 bcm2835_gpio_bank_bits(const unsigned long *bits,
+		unsigned int bank)
+{
+	return bits[BIT_WORD(bank * 32)] >> ((bank * 32) % BITS_PER_LONG);
+}
+
+static int bcm2835_gpio_get_multiple(struct gpio_chip *chip,
+		unsigned long *mask, unsigned long *bits)
+{
+	struct bcm2835_pinctrl *pc = gpiochip_get_data(chip);
+	unsigned int bank, shift;
+	unsigned long val;
+	u32 m;
+
+	for (bank = 0; bank < BCM2835_NUM_BANKS; bank++) {
+		m = bcm2835_gpio_bank_bits(mask, bank);
+		if (!m)
+			continue;
+
+		val = bcm2835_gpio_rd(pc, GPLEV0 + bank * 4) & m;
+		shift = (bank * 32) % BITS_PER_LONG;
+		bits[BIT_WORD(bank * 32)] &= ~((unsigned long)m << shift);
+		bits[BIT_WORD(bank * 32)] |= val << shift;
+	}
+
+	return 0;
+}
+
 static int bcm2835_gpio_get_direction(struct gpio_chip *chip, unsigned int offset)
 {
 	struct bcm2835_pinctrl *pc = gpiochip_get_data(chip);
@@ -333,6 +362,30 @@ static void bcm2835_gpio_set(struct gpio_chip *chip, unsigned offset, int value)
 	bcm2835_gpio_set_bit(pc, value ? GPSET0 : GPCLR0, offset);
 }
 
+/*
+ * One GPSET and one GPCLR write per bank. The lines being set change a
+ * register write ahead of the lines being cleared, not on the same cycle.
+ */
+static void bcm2835_gpio_set_multiple(struct gpio_chip *chip,
+		unsigned long *mask, unsigned long *bits)
+{
+	struct bcm2835_pinctrl *pc = gpiochip_get_data(chip);
+	unsigned int bank;
+	u32 m, val;
+
+	for (bank = 0; bank < BCM2835_NUM_BANKS; bank++) {
+		m = bcm2835_gpio_bank_bits(mask, bank);
+		if (!m)
+			continue;
+
+		val = bcm2835_gpio_bank_bits(bits, bank);
+		if (m & val)
+			bcm2835_gpio_wr(pc, GPSET0 + bank * 4, m & val);
+		if (m & ~val)
+			bcm2835_gpio_wr(pc, GPCLR0 + bank * 4, m & ~val);
+	}
+}
+
 static int bcm2835_gpio_direction_output(struct gpio_chip *chip,
 		unsigned offset, int value)
 {
@@ -349,7 +402,9 @@ static const struct gpio_chip bcm2835_gpio_chip = {
 	.direction_output = bcm2835_gpio_direction_output,
 	.get_direction = bcm2835_gpio_get_direction,
 	.get = bcm2835_gpio_get,
+	.get_multiple = bcm2835_gpio_get_multiple,
 	.set = bcm2835_gpio_set,
+	.set_multiple = bcm2835_gpio_set_multiple,
 	.base = 0,
 	.set_config = gpiochip_generic_config,
 	.ngpio = BCM2835_NUM_GPIOS,
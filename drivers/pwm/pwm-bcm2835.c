@@ -7,30 +7,68 @@
  */
 
 #include <linux/clk.h>
+#include <linux/delay.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
 #include <linux/err.h>
+#include <linux/fs.h>
 #include <linux/io.h>
+#include <linux/miscdevice.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
+#include <linux/of_address.h>
 #include <linux/platform_device.h>
 #include <linux/pwm.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
 
 #define PWM_CONTROL		0x000
 #define PWM_CONTROL_SHIFT(x)	((x) * 8)
 #define PWM_CONTROL_MASK	0xff
 #define PWM_MODE		0x80		/* set timer in PWM mode */
 #define PWM_ENABLE		(1 << 0)
+#define PWM_SERIALISE		(1 << 1)
 #define PWM_POLARITY		(1 << 4)
+#define PWM_USE_FIFO		(1 << 5)
+#define PWM_CLEAR_FIFO		(1 << 6)	/* both channels */
+
+#define PWM_STATUS		0x004
+#define PWM_STATUS_EMPTY	(1 << 1)
+#define PWM_DMAC		0x008
+#define PWM_DMAC_ENABLE		(1 << 31)
+#define PWM_DMAC_CFG		((7 << 8) | 7)	/* PANIC and DREQ at 7 */
+#define PWM_FIFO		0x018
 
 #define PERIOD(x)		(((x) * 0x10) + 0x10)
 #define DUTY(x)			(((x) * 0x10) + 0x14)
 
 #define MIN_PERIOD		108		/* 9.2 MHz max. PWM clock */
 
+/* stream buffer, each period is handed to the DMA engine as one transfer */
+#define STREAM_PERIODS		16
+#define STREAM_PERIOD_BYTES	4096
+#define STREAM_BUF_BYTES	(STREAM_PERIODS * STREAM_PERIOD_BYTES)
+
 struct bcm2835_pwm {
 	struct pwm_chip chip;
 	struct device *dev;
 	void __iomem *base;
 	struct clk *clk;
+
+	/* FIFO streaming to channel 0, only when a "tx" DMA channel exists */
+	struct dma_chan *dma;
+	struct miscdevice misc;
+	struct mutex stream_lock;	/* serialises writers */
+	spinlock_t queue_lock;		/* protects queued */
+	wait_queue_head_t stream_wait;
+	void *stream_buf;
+	dma_addr_t stream_dma;
+	unsigned int head;
+	unsigned int queued;
+	unsigned long stream_busy;
+	bool serialise;
+	struct pwm_device *stream_pwm;	/* channel 0, claimed while open */
 };
 
 static inline struct bcm2835_pwm *to_bcm2835_pwm(struct pwm_chip *chip)
@@ -137,6 +175,312 @@ static const struct pwm_ops bcm2835_pwm_ops = {
 	.owner = THIS_MODULE,
 };
 
+static void bcm2835_pwm_stream_complete(void *data)
+{
+	struct bcm2835_pwm *pc = data;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pc->queue_lock, flags);
+	pc->queued--;
+	spin_unlock_irqrestore(&pc->queue_lock, flags);
+
+	wake_up(&pc->stream_wait);
+}
+
+static bool bcm2835_pwm_stream_space(struct bcm2835_pwm *pc)
+{
+	unsigned long flags;
+	bool space;
+
+	spin_lock_irqsave(&pc->queue_lock, flags);
+	space = pc->queued < STREAM_PERIODS;
+	spin_unlock_irqrestore(&pc->queue_lock, flags);
+
+	return space;
+}
+
+static bool bcm2835_pwm_stream_idle(struct bcm2835_pwm *pc)
+{
+	unsigned long flags;
+	bool idle;
+
+	spin_lock_irqsave(&pc->queue_lock, flags);
+	idle = !pc->queued;
+	spin_unlock_irqrestore(&pc->queue_lock, flags);
+
+	return idle;
+}
+
+/*
+ * Samples go out in the order they were written. Waiting for each period
+ * instead of running a cyclic transfer means that an underrun lets the
+ * FIFO run dry, which leaves the output idle rather than replaying stale
+ * samples.
+ */
+static ssize_t bcm2835_pwm_stream_write(struct file *file,
+					const char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	struct bcm2835_pwm *pc = container_of(file->private_data,
+					      struct bcm2835_pwm, misc);
+	struct dma_async_tx_descriptor *desc;
+	size_t done = 0, len;
+	unsigned long flags;
+	void *period;
+	ssize_t ret = 0;
+
+	if (count % 4)
+		return -EINVAL;
+
+	mutex_lock(&pc->stream_lock);
+	while (done < count) {
+		if (!bcm2835_pwm_stream_space(pc)) {
+			if (file->f_flags & O_NONBLOCK) {
+				ret = -EAGAIN;
+				break;
+			}
+			ret = wait_event_interruptible(pc->stream_wait,
+					bcm2835_pwm_stream_space(pc));
+			if (ret)
+				break;
+		}
+
+		len = min_t(size_t, count - done, STREAM_PERIOD_BYTES);
+		period = pc->stream_buf + pc->head * STREAM_PERIOD_BYTES;
+		if (copy_from_user(period, buf + done, len)) {
+			ret = -EFAULT;
+			break;
+		}
+
+		desc = dmaengine_prep_slave_single(pc->dma,
+				pc->stream_dma + pc->head * STREAM_PERIOD_BYTES,
+				len, DMA_MEM_TO_DEV, DMA_PREP_INTERRUPT);
+		if (!desc) {
+			ret = -ENOMEM;
+			break;
+		}
+		desc->callback = bcm2835_pwm_stream_complete;
+		desc->callback_param = pc;
+
+		spin_lock_irqsave(&pc->queue_lock, flags);
+		pc->queued++;
+		spin_unlock_irqrestore(&pc->queue_lock, flags);
+
+		dmaengine_submit(desc);
+		dma_async_issue_pending(pc->dma);
+
+		pc->head = (pc->head + 1) % STREAM_PERIODS;
+		done += len;
+	}
+	mutex_unlock(&pc->stream_lock);
+
+	return done ? done : ret;
+}
+
+static int bcm2835_pwm_stream_open(struct inode *inode, struct file *file)
+{
+	struct bcm2835_pwm *pc = container_of(file->private_data,
+					      struct bcm2835_pwm, misc);
+	struct pwm_device *pwm;
+	u32 value, polarity;
+	int ret = 0;
+
+	if (test_and_set_bit(0, &pc->stream_busy))
+		return -EBUSY;
+
+	mutex_lock(&pc->stream_lock);
+
+	/*
+	 * Only take channel 0 if it is idle: not left running by the
+	 * firmware and not claimed by a PWM user. Claim it for as long as
+	 * the stream is open so that no PWM user can get it meanwhile.
+	 */
+	value = readl(pc->base + PWM_CONTROL);
+	if (value & PWM_ENABLE) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+	polarity = value & PWM_POLARITY;
+
+	pwm = pwm_request_from_chip(&pc->chip, 0, "pwm-stream");
+	if (IS_ERR(pwm)) {
+		ret = PTR_ERR(pwm);
+		goto unlock;
+	}
+	pc->stream_pwm = pwm;
+	pc->head = 0;
+
+	/*
+	 * The range set through the PWM API beforehand remains the period
+	 * (PWM mode) or the bits per word (serialiser mode).
+	 */
+	value = readl(pc->base + PWM_CONTROL);
+	value &= ~PWM_CONTROL_MASK;
+	writel(value | PWM_CLEAR_FIFO, pc->base + PWM_CONTROL);
+	value |= PWM_ENABLE | PWM_USE_FIFO |
+		 (pc->serialise ? PWM_SERIALISE : PWM_MODE) | polarity;
+	writel(value, pc->base + PWM_CONTROL);
+	writel(PWM_DMAC_ENABLE | PWM_DMAC_CFG, pc->base + PWM_DMAC);
+
+unlock:
+	mutex_unlock(&pc->stream_lock);
+	if (ret)
+		clear_bit(0, &pc->stream_busy);
+
+	return ret;
+}
+
+static int bcm2835_pwm_stream_release(struct inode *inode, struct file *file)
+{
+	struct bcm2835_pwm *pc = container_of(file->private_data,
+					      struct bcm2835_pwm, misc);
+	int timeout = 100;
+
+	/* let what was written play out unless the closer is interrupted */
+	if (!wait_event_interruptible(pc->stream_wait,
+				      bcm2835_pwm_stream_idle(pc)))
+		while (!(readl(pc->base + PWM_STATUS) & PWM_STATUS_EMPTY) &&
+		       timeout--)
+			usleep_range(100, 200);
+
+	dmaengine_terminate_sync(pc->dma);
+	pc->queued = 0;
+
+	mutex_lock(&pc->stream_lock);
+	writel(0, pc->base + PWM_DMAC);
+	/* clears channel 0's control bits, leaving it idle as we found it */
+	pwm_free(pc->stream_pwm);
+	pc->stream_pwm = NULL;
+	mutex_unlock(&pc->stream_lock);
+
+	clear_bit(0, &pc->stream_busy);
+
+	return 0;
+}
+
+static const struct file_operations bcm2835_pwm_stream_fops = {
+	.owner = THIS_MODULE,
+	.open = bcm2835_pwm_stream_open,
+	.release = bcm2835_pwm_stream_release,
+	.write = bcm2835_pwm_stream_write,
+	.llseek = no_llseek,
+};
+
+static ssize_t serialise_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct miscdevice *misc = dev_get_drvdata(dev);
+	struct bcm2835_pwm *pc = container_of(misc, struct bcm2835_pwm, misc);
+
+	return sprintf(buf, "%d\n", pc->serialise);
+}
+
+static ssize_t serialise_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct miscdevice *misc = dev_get_drvdata(dev);
+	struct bcm2835_pwm *pc = container_of(misc, struct bcm2835_pwm, misc);
+	bool serialise;
+	int ret;
+
+	ret = kstrtobool(buf, &serialise);
+	if (ret)
+		return ret;
+
+	/* takes effect at the next open */
+	mutex_lock(&pc->stream_lock);
+	pc->serialise = serialise;
+	mutex_unlock(&pc->stream_lock);
+
+	return count;
+}
+static DEVICE_ATTR_RW(serialise);
+
+static struct attribute *bcm2835_pwm_stream_attrs[] = {
+	&dev_attr_serialise.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(bcm2835_pwm_stream);
+
+/*
+ * The stream device is optional: without a "tx" DMA channel in the device
+ * tree the PWM works exactly as before.
+ */
+static int bcm2835_pwm_stream_init(struct bcm2835_pwm *pc)
+{
+	struct dma_slave_config slave_config = { };
+	const __be32 *addr;
+	int ret;
+
+	pc->dma = dma_request_slave_channel(pc->dev, "tx");
+	if (!pc->dma)
+		return 0;
+
+	/* base address in dma-space */
+	addr = of_get_address(pc->dev->of_node, 0, NULL, NULL);
+	if (!addr) {
+		dev_err(pc->dev, "could not get DMA-register address\n");
+		ret = -EINVAL;
+		goto err_release;
+	}
+
+	slave_config.direction = DMA_MEM_TO_DEV;
+	slave_config.dst_addr = be32_to_cpup(addr) + PWM_FIFO;
+	slave_config.dst_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+	ret = dmaengine_slave_config(pc->dma, &slave_config);
+	if (ret)
+		goto err_release;
+
+	pc->stream_buf = dma_alloc_coherent(pc->dma->device->dev,
+					    STREAM_BUF_BYTES, &pc->stream_dma,
+					    GFP_KERNEL);
+	if (!pc->stream_buf) {
+		ret = -ENOMEM;
+		goto err_release;
+	}
+
+	mutex_init(&pc->stream_lock);
+	spin_lock_init(&pc->queue_lock);
+	init_waitqueue_head(&pc->stream_wait);
+
+	pc->misc.minor = MISC_DYNAMIC_MINOR;
+	pc->misc.name = devm_kasprintf(pc->dev, GFP_KERNEL, "pwm-stream-%s",
+				       dev_name(pc->dev));
+	pc->misc.fops = &bcm2835_pwm_stream_fops;
+	pc->misc.parent = pc->dev;
+	pc->misc.groups = bcm2835_pwm_stream_groups;
+	if (!pc->misc.name) {
+		ret = -ENOMEM;
+		goto err_free;
+	}
+
+	ret = misc_register(&pc->misc);
+	if (ret)
+		goto err_free;
+
+	return 0;
+
+err_free:
+	dma_free_coherent(pc->dma->device->dev, STREAM_BUF_BYTES,
+			  pc->stream_buf, pc->stream_dma);
+err_release:
+	dma_release_channel(pc->dma);
+	pc->dma = NULL;
+	return ret;
+}
+
+static void bcm2835_pwm_stream_remove(struct bcm2835_pwm *pc)
+{
+	if (!pc->dma)
+		return;
+
+	misc_deregister(&pc->misc);
+	dma_free_coherent(pc->dma->device->dev, STREAM_BUF_BYTES,
+			  pc->stream_buf, pc->stream_dma);
+	dma_release_channel(pc->dma);
+}
+
 static int bcm2835_pwm_probe(struct platform_device *pdev)
 {
 	struct bcm2835_pwm *pc;
@@ -177,6 +521,12 @@ static int bcm2835_pwm_probe(struct platform_device *pdev)
 	if (ret < 0)
 		goto add_fail;
 
+	ret = bcm2835_pwm_stream_init(pc);
+	if (ret) {
+		pwmchip_remove(&pc->chip);
+		goto add_fail;
+	}
+
 	return 0;
 
 add_fail:
@@ -188,6 +538,7 @@ static int bcm2835_pwm_remove(struct platform_device *pdev)
 {
 	struct bcm2835_pwm *pc = platform_get_drvdata(pdev);
 
+	bcm2835_pwm_stream_remove(pc);
 	clk_disable_unprepare(pc->clk);
 
 	return pwmchip_remove(&pc->chip);
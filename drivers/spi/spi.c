@@ -836,24 +836,28 @@ void spi_unmap_buf(struct spi_controller *ctlr, struct device *dev,
 	}
 }
 
-static int __spi_map_msg(struct spi_controller *ctlr, struct spi_message *msg)
+static void spi_dma_devs(struct spi_controller *ctlr,
+			 struct device **tx_dev, struct device **rx_dev)
 {
-	struct device *tx_dev, *rx_dev;
-	struct spi_transfer *xfer;
-	int ret;
-
-	if (!ctlr->can_dma)
-		return 0;
-
 	if (ctlr->dma_tx)
-		tx_dev = ctlr->dma_tx->device->dev;
+		*tx_dev = ctlr->dma_tx->device->dev;
 	else
-		tx_dev = ctlr->dev.parent;
+		*tx_dev = ctlr->dev.parent;
 
 	if (ctlr->dma_rx)
-		rx_dev = ctlr->dma_rx->device->dev;
+		*rx_dev = ctlr->dma_rx->device->dev;
 	else
-		rx_dev = ctlr->dev.parent;
+		*rx_dev = ctlr->dev.parent;
+}
+
+static int __spi_map_xfers(struct spi_controller *ctlr,
+			   struct spi_message *msg)
+{
+	struct device *tx_dev, *rx_dev;
+	struct spi_transfer *xfer;
+	int ret;
+
+	spi_dma_devs(ctlr, &tx_dev, &rx_dev);
 
 	list_for_each_entry(xfer, &msg->transfers, transfer_list) {
 		if (!ctlr->can_dma(ctlr, msg->spi, xfer))
@@ -879,28 +883,16 @@ static int __spi_map_msg(struct spi_controller *ctlr, struct spi_message *msg)
 		}
 	}
 
-	ctlr->cur_msg_mapped = true;
-
 	return 0;
 }
 
-static int __spi_unmap_msg(struct spi_controller *ctlr, struct spi_message *msg)
+static void __spi_unmap_xfers(struct spi_controller *ctlr,
+			      struct spi_message *msg)
 {
 	struct spi_transfer *xfer;
 	struct device *tx_dev, *rx_dev;
 
-	if (!ctlr->cur_msg_mapped || !ctlr->can_dma)
-		return 0;
-
-	if (ctlr->dma_tx)
-		tx_dev = ctlr->dma_tx->device->dev;
-	else
-		tx_dev = ctlr->dev.parent;
-
-	if (ctlr->dma_rx)
-		rx_dev = ctlr->dma_rx->device->dev;
-	else
-		rx_dev = ctlr->dev.parent;
+	spi_dma_devs(ctlr, &tx_dev, &rx_dev);
 
 	list_for_each_entry(xfer, &msg->transfers, transfer_list) {
 		if (!ctlr->can_dma(ctlr, msg->spi, xfer))
@@ -909,6 +901,70 @@ static int __spi_unmap_msg(struct spi_controller *ctlr, struct spi_message *msg)
 		spi_unmap_buf(ctlr, rx_dev, &xfer->rx_sg, DMA_FROM_DEVICE);
 		spi_unmap_buf(ctlr, tx_dev, &xfer->tx_sg, DMA_TO_DEVICE);
 	}
+}
+
+/*
+ * A pre-mapped message keeps its mapping across submissions, so only the
+ * cache maintenance is done around each one.
+ */
+static void __spi_sync_xfers(struct spi_controller *ctlr,
+			     struct spi_message *msg, bool for_device)
+{
+	struct spi_transfer *xfer;
+	struct device *tx_dev, *rx_dev;
+
+	spi_dma_devs(ctlr, &tx_dev, &rx_dev);
+
+	list_for_each_entry(xfer, &msg->transfers, transfer_list) {
+		if (!ctlr->can_dma(ctlr, msg->spi, xfer))
+			continue;
+
+		if (for_device) {
+			if (xfer->tx_sg.orig_nents)
+				dma_sync_sg_for_device(tx_dev, xfer->tx_sg.sgl,
+						       xfer->tx_sg.orig_nents,
+						       DMA_TO_DEVICE);
+			if (xfer->rx_sg.orig_nents)
+				dma_sync_sg_for_device(rx_dev, xfer->rx_sg.sgl,
+						       xfer->rx_sg.orig_nents,
+						       DMA_FROM_DEVICE);
+		} else if (xfer->rx_sg.orig_nents) {
+			dma_sync_sg_for_cpu(rx_dev, xfer->rx_sg.sgl,
+					    xfer->rx_sg.orig_nents,
+					    DMA_FROM_DEVICE);
+		}
+	}
+}
+
+static int __spi_map_msg(struct spi_controller *ctlr, struct spi_message *msg)
+{
+	int ret;
+
+	if (!ctlr->can_dma)
+		return 0;
+
+	if (msg->pre_mapped) {
+		__spi_sync_xfers(ctlr, msg, true);
+	} else {
+		ret = __spi_map_xfers(ctlr, msg);
+		if (ret)
+			return ret;
+	}
+
+	ctlr->cur_msg_mapped = true;
+
+	return 0;
+}
+
+static int __spi_unmap_msg(struct spi_controller *ctlr, struct spi_message *msg)
+{
+	if (!ctlr->cur_msg_mapped || !ctlr->can_dma)
+		return 0;
+
+	if (msg->pre_mapped)
+		__spi_sync_xfers(ctlr, msg, false);
+	else
+		__spi_unmap_xfers(ctlr, msg);
 
 	return 0;
 }
@@ -924,6 +980,17 @@ static inline int __spi_unmap_msg(struct spi_controller *ctlr,
 {
 	return 0;
 }
+
+static inline int __spi_map_xfers(struct spi_controller *ctlr,
+				  struct spi_message *msg)
+{
+	return 0;
+}
+
+static inline void __spi_unmap_xfers(struct spi_controller *ctlr,
+				     struct spi_message *msg)
+{
+}
 #endif /* !CONFIG_HAS_DMA */
 
 static inline int spi_unmap_msg(struct spi_controller *ctlr,
@@ -2943,6 +3010,101 @@ static int __spi_validate(struct spi_device *spi, struct spi_message *message)
 	return 0;
 }
 
+/* A message prepared by spi_optimize_message() skips the validation */
+static int __spi_check_message(struct spi_device *spi,
+			       struct spi_message *message)
+{
+	if (!message->optimized)
+		return __spi_validate(spi, message);
+
+	if (message->spi != spi)
+		return -EINVAL;
+
+	message->status = -EINPROGRESS;
+
+	return 0;
+}
+
+/* Dummy buffers are shared by the controller and resized per message */
+static bool spi_msg_needs_dummy(struct spi_controller *ctlr,
+				struct spi_message *msg)
+{
+	struct spi_transfer *xfer;
+
+	list_for_each_entry(xfer, &msg->transfers, transfer_list) {
+		if (!xfer->len)
+			continue;
+		if ((ctlr->flags & SPI_CONTROLLER_MUST_TX) && !xfer->tx_buf)
+			return true;
+		if ((ctlr->flags & SPI_CONTROLLER_MUST_RX) && !xfer->rx_buf)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * spi_optimize_message - validate and pre-map a message for repeated use
+ * @spi: device with which data will be exchanged
+ * @msg: message to prepare
+ * Context: can sleep
+ *
+ * Does the checks spi_async() and spi_sync() would otherwise repeat on
+ * every submission and, for queued controllers doing DMA, maps the
+ * transfer buffers once.  The message may then be submitted any number of
+ * times, from any context spi_async() allows, as long as the transfer list,
+ * lengths and buffer addresses are left alone; the buffer contents may
+ * change between submissions.  Undo with spi_unoptimize_message() before
+ * freeing or changing the message.
+ *
+ * Transfers using the controller's dummy buffers are only validated, not
+ * pre-mapped, since those buffers are resized by other messages.
+ *
+ * Return: zero on success, else a negative error code.
+ */
+int spi_optimize_message(struct spi_device *spi, struct spi_message *msg)
+{
+	struct spi_controller *ctlr = spi->controller;
+	int ret;
+
+	if (msg->optimized)
+		return -EBUSY;
+
+	ret = __spi_validate(spi, msg);
+	if (ret)
+		return ret;
+
+	msg->spi = spi;
+
+	if (ctlr->transfer == spi_queued_transfer && ctlr->can_dma &&
+	    !msg->is_dma_mapped && !spi_msg_needs_dummy(ctlr, msg)) {
+		ret = __spi_map_xfers(ctlr, msg);
+		if (ret)
+			return ret;
+		msg->pre_mapped = 1;
+	}
+
+	msg->optimized = 1;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(spi_optimize_message);
+
+/**
+ * spi_unoptimize_message - release a message from spi_optimize_message()
+ * @msg: message that is no longer in flight
+ * Context: can sleep
+ */
+void spi_unoptimize_message(struct spi_message *msg)
+{
+	if (msg->pre_mapped)
+		__spi_unmap_xfers(msg->spi->controller, msg);
+
+	msg->pre_mapped = 0;
+	msg->optimized = 0;
+}
+EXPORT_SYMBOL_GPL(spi_unoptimize_message);
+
 static int __spi_async(struct spi_device *spi, struct spi_message *message)
 {
 	struct spi_controller *ctlr = spi->controller;
@@ -3001,7 +3163,7 @@ int spi_async(struct spi_device *spi, struct spi_message *message)
 	int ret;
 	unsigned long flags;
 
-	ret = __spi_validate(spi, message);
+	ret = __spi_check_message(spi, message);
 	if (ret != 0)
 		return ret;
 
@@ -3055,7 +3217,7 @@ int spi_async_locked(struct spi_device *spi, struct spi_message *message)
 	int ret;
 	unsigned long flags;
 
-	ret = __spi_validate(spi, message);
+	ret = __spi_check_message(spi, message);
 	if (ret != 0)
 		return ret;
 
@@ -3089,7 +3251,7 @@ static int __spi_sync(struct spi_device *spi, struct spi_message *message)
 	struct spi_controller *ctlr = spi->controller;
 	unsigned long flags;
 
-	status = __spi_validate(spi, message);
+	status = __spi_check_message(spi, message);
 	if (status != 0)
 		return status;
 
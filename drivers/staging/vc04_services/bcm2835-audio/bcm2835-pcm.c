@@ -8,6 +8,12 @@
 
 #include "bcm2835.h"
 
+/*
+ * Writes are held back until this much data is pending, one full VCHIQ
+ * message, as long as the VPU still has more than two periods queued.
+ */
+#define BCM2835_WRITE_COALESCE_BYTES	4000
+
 /* hardware definition */
 static const struct snd_pcm_hardware snd_bcm2835_playback_hw = {
 	.info = (SNDRV_PCM_INFO_INTERLEAVED | SNDRV_PCM_INFO_BLOCK_TRANSFER |
@@ -45,6 +51,8 @@ static const struct snd_pcm_hardware snd_bcm2835_playback_spdif_hw = {
 	.periods_max = 128,
 };
 
+static void snd_bcm2835_pcm_flush_work(struct work_struct *work);
+
 static void snd_bcm2835_playback_free(struct snd_pcm_runtime *runtime)
 {
 	kfree(runtime->private_data);
@@ -74,6 +82,11 @@ void bcm2835_playback_fifo(struct bcm2835_alsa_stream *alsa_stream,
 	pos %= alsa_stream->buffer_size;
 	atomic_set(&alsa_stream->pos, pos);
 
+	if (atomic_sub_return(bytes, &alsa_stream->queued) < 0)
+		atomic_set(&alsa_stream->queued, 0);
+	if (READ_ONCE(alsa_stream->deferred))
+		schedule_work(&alsa_stream->flush_work);
+
 	alsa_stream->period_offset += bytes;
 	alsa_stream->interpolate_start = ktime_get();
 	if (alsa_stream->period_offset >= alsa_stream->period_size) {
@@ -120,6 +133,7 @@ static int snd_bcm2835_playback_open_generic(
 	alsa_stream->chip = chip;
 	alsa_stream->substream = substream;
 	alsa_stream->idx = idx;
+	INIT_WORK(&alsa_stream->flush_work, snd_bcm2835_pcm_flush_work);
 
 	err = bcm2835_audio_open(alsa_stream);
 	if (err) {
@@ -179,6 +193,7 @@ static int snd_bcm2835_playback_close(struct snd_pcm_substream *substream)
 
 	alsa_stream->period_size = 0;
 	alsa_stream->buffer_size = 0;
+	cancel_work_sync(&alsa_stream->flush_work);
 
 	bcm2835_audio_close(alsa_stream);
 	alsa_stream->chip->alsa_stream[alsa_stream->idx] = NULL;
@@ -240,6 +255,8 @@ static int snd_bcm2835_pcm_prepare(struct snd_pcm_substream *substream)
 	alsa_stream->period_offset = 0;
 	alsa_stream->draining = false;
 	alsa_stream->interpolate_start = ktime_get();
+	atomic_set(&alsa_stream->queued, 0);
+	alsa_stream->deferred = false;
 
 	return 0;
 }
@@ -251,7 +268,28 @@ static void snd_bcm2835_pcm_transfer(struct snd_pcm_substream *substream,
 	struct bcm2835_alsa_stream *alsa_stream = runtime->private_data;
 	void *src = (void *) (substream->runtime->dma_area + rec->sw_data);
 
-	bcm2835_audio_write(alsa_stream, bytes, src);
+	if (!bcm2835_audio_write(alsa_stream, bytes, src))
+		atomic_add(bytes, &alsa_stream->queued);
+}
+
+static bool snd_bcm2835_pcm_defer(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct bcm2835_alsa_stream *alsa_stream = runtime->private_data;
+	struct snd_pcm_indirect *rec = &alsa_stream->pcm_indirect;
+	snd_pcm_sframes_t diff = runtime->control->appl_ptr - rec->appl_ptr;
+	int pending;
+
+	if (runtime->status->state != SNDRV_PCM_STATE_RUNNING ||
+	    alsa_stream->draining)
+		return false;
+
+	if (diff < 0)
+		diff += runtime->boundary;
+	pending = rec->sw_ready + frames_to_bytes(runtime, diff);
+
+	return pending < BCM2835_WRITE_COALESCE_BYTES &&
+	       atomic_read(&alsa_stream->queued) > 2 * alsa_stream->period_size;
 }
 
 static int snd_bcm2835_pcm_ack(struct snd_pcm_substream *substream)
@@ -260,10 +298,28 @@ static int snd_bcm2835_pcm_ack(struct snd_pcm_substream *substream)
 	struct bcm2835_alsa_stream *alsa_stream = runtime->private_data;
 	struct snd_pcm_indirect *pcm_indirect = &alsa_stream->pcm_indirect;
 
+	/* bcm2835_playback_fifo() flushes once the VPU has played more */
+	alsa_stream->deferred = snd_bcm2835_pcm_defer(substream);
+	if (alsa_stream->deferred)
+		return 0;
+
 	return snd_pcm_indirect_playback_transfer(substream, pcm_indirect,
 						  snd_bcm2835_pcm_transfer);
 }
 
+static void snd_bcm2835_pcm_flush_work(struct work_struct *work)
+{
+	struct bcm2835_alsa_stream *alsa_stream =
+		container_of(work, struct bcm2835_alsa_stream, flush_work);
+	struct snd_pcm_substream *substream = alsa_stream->substream;
+
+	snd_pcm_stream_lock(substream);
+	if (alsa_stream->deferred &&
+	    substream->runtime->status->state == SNDRV_PCM_STATE_RUNNING)
+		snd_bcm2835_pcm_ack(substream);
+	snd_pcm_stream_unlock(substream);
+}
+
 /* trigger callback */
 static int snd_bcm2835_pcm_trigger(struct snd_pcm_substream *substream, int cmd)
 {
@@ -303,7 +359,14 @@ snd_bcm2835_pcm_pointer(struct snd_pcm_substream *substream)
 				alsa_stream->interpolate_start)));
 		u64 frames_output_in_interval =
 			div_u64((interval * runtime->rate), 1000000000);
-		snd_pcm_sframes_t frames_output_in_interval_sized =
+		/* no further than the data the VPU actually holds */
+		u64 frames_queued = bytes_to_frames(runtime,
+			atomic_read(&alsa_stream->queued));
+		snd_pcm_sframes_t frames_output_in_interval_sized;
+
+		frames_output_in_interval = min(frames_output_in_interval,
+						frames_queued);
+		frames_output_in_interval_sized =
 			-frames_output_in_interval;
 		runtime->delay = frames_output_in_interval_sized;
 	}
@@ -6,6 +6,7 @@
 
 #include <linux/device.h>
 #include <linux/wait.h>
+#include <linux/workqueue.h>
 #include <sound/core.h>
 #include <sound/pcm.h>
 #include <sound/pcm-indirect.h>
@@ -82,6 +83,10 @@ struct bcm2835_alsa_stream {
 	unsigned int period_size;
 	ktime_t interpolate_start;
 
+	atomic_t queued;	/* bytes written but not yet played */
+	bool deferred;		/* writes held back by snd_bcm2835_pcm_ack() */
+	struct work_struct flush_work;
+
 	struct bcm2835_audio_instance *instance;
 	int idx;
 };
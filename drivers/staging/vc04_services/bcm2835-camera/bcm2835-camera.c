@@ -15,7 +15,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/slab.h>
-#include <media/videobuf2-vmalloc.h>
+#include <linux/dma-buf.h>
 #include <media/videobuf2-dma-contig.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-ioctl.h>
@@ -66,6 +66,10 @@ MODULE_PARM_DESC(max_video_width, "Threshold for video mode");
 module_param(max_video_height, int, 0644);
 MODULE_PARM_DESC(max_video_height, "Threshold for video mode");
 
+static bool preview_node;
+module_param(preview_node, bool, 0444);
+MODULE_PARM_DESC(preview_node, "Expose the preview port as a second capture node");
+
 /* global device data array */
 static struct bm2835_mmal_dev *gdev[MAX_BCM2835_CAMERAS];
 
@@ -280,11 +284,6 @@ static int queue_setup(struct vb2_queue *vq,
 
 	sizes[0] = size;
 
-	/*
-	 * videobuf2-vmalloc allocator is context-less so no need to set
-	 * alloc_ctxs array.
-	 */
-
 	v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev, "%s: dev:%p\n",
 		 __func__, dev);
 
@@ -309,15 +308,24 @@ static int buffer_init(struct vb2_buffer *vb)
 static int buffer_prepare(struct vb2_buffer *vb)
 {
 	struct bm2835_mmal_dev *dev = vb2_get_drv_priv(vb->vb2_queue);
+	struct vb2_v4l2_buffer *vb2 = to_vb2_v4l2_buffer(vb);
+	struct vb2_mmal_buffer *buf =
+				container_of(vb2, struct vb2_mmal_buffer, vb);
+	struct dma_buf *dma_buf;
 	unsigned long size;
+	int ret;
 
 	v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev, "%s: dev:%p, vb %p\n",
 		 __func__, dev, vb);
 
-	if (!dev->capture.port || !dev->capture.fmt)
-		return -ENODEV;
+	if (vb->vb2_queue == &dev->preview.vb_vidq) {
+		size = dev->preview.stride * dev->preview.height;
+	} else {
+		if (!dev->capture.port || !dev->capture.fmt)
+			return -ENODEV;
 
-	size = dev->capture.stride * dev->capture.height;
+		size = dev->capture.stride * dev->capture.height;
+	}
 	if (vb2_plane_size(vb, 0) < size) {
 		v4l2_err(&dev->v4l2_dev,
 			 "%s data will not fit into plane (%lu < %lu)\n",
@@ -325,7 +333,54 @@ static int buffer_prepare(struct vb2_buffer *vb)
 		return -EINVAL;
 	}
 
-	return 0;
+	/*
+	 * The VPU writes straight into the buffer via vc-sm-cma, so it needs
+	 * a dmabuf for every buffer.
+	 */
+	switch (vb->memory) {
+	case VB2_MEMORY_DMABUF:
+		dma_buf = dma_buf_get(vb->planes[0].m.fd);
+		if (IS_ERR(dma_buf))
+			return PTR_ERR(dma_buf);
+
+		if (dma_buf != buf->mmal.dma_buf) {
+			/* dmabuf either hasn't been imported, or has changed */
+			if (buf->mmal.dma_buf) {
+				mmal_vchi_buffer_unmap(&buf->mmal);
+				dma_buf_put(buf->mmal.dma_buf);
+			}
+			buf->mmal.dma_buf = dma_buf;
+		} else {
+			/* Already hold a reference, so drop the new one */
+			dma_buf_put(dma_buf);
+		}
+		ret = 0;
+		break;
+	case VB2_MEMORY_MMAP:
+		/*
+		 * We want to do this at init, but vb2_core_expbuf checks that
+		 * the index < q->num_buffers, and q->num_buffers only gets
+		 * updated once all the buffers are allocated.
+		 */
+		if (!buf->mmal.dma_buf) {
+			ret = vb2_core_expbuf_dmabuf(vb->vb2_queue,
+						     vb->vb2_queue->type,
+						     vb->index, 0, O_CLOEXEC,
+						     &buf->mmal.dma_buf);
+			if (ret)
+				v4l2_err(&dev->v4l2_dev,
+					 "%s: Failed to expbuf idx %d, ret %d\n",
+					 __func__, vb->index, ret);
+		} else {
+			ret = 0;
+		}
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	return ret;
 }
 
 static void buffer_cleanup(struct vb2_buffer *vb)
@@ -339,6 +394,10 @@ static void buffer_cleanup(struct vb2_buffer *vb)
 		 __func__, dev, vb);
 
 	mmal_vchi_buffer_cleanup(&buf->mmal);
+	if (buf->mmal.dma_buf) {
+		dma_buf_put(buf->mmal.dma_buf);
+		buf->mmal.dma_buf = NULL;
+	}
 }
 
 static inline bool is_capturing(struct bm2835_mmal_dev *dev)
@@ -544,14 +603,17 @@ static void buffer_queue(struct vb2_buffer *vb)
 	struct vb2_v4l2_buffer *vb2 = to_vb2_v4l2_buffer(vb);
 	struct vb2_mmal_buffer *buf =
 				container_of(vb2, struct vb2_mmal_buffer, vb);
+	struct vchiq_mmal_port *port = dev->capture.port;
 	int ret;
 
 	v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev,
 		 "%s: dev:%p buf:%p, idx %u\n",
 		 __func__, dev, buf, vb2->vb2_buf.index);
 
-	ret = vchiq_mmal_submit_buffer(dev->instance, dev->capture.port,
-				       &buf->mmal);
+	if (vb->vb2_queue == &dev->preview.vb_vidq)
+		port = dev->preview.port;
+
+	ret = vchiq_mmal_submit_buffer(dev->instance, port, &buf->mmal);
 	if (ret < 0)
 		v4l2_err(&dev->v4l2_dev, "%s: error submitting buffer\n",
 			 __func__);
@@ -725,6 +787,270 @@ static const struct vb2_ops bm2835_mmal_video_qops = {
 	.wait_finish = vb2_ops_wait_finish,
 };
 
+/* ------------------------------------------------------------------
+ *	Preview node queue operations
+ *
+ * The camera only allows the preview port to differ from the video port
+ * in resolution when the video port is idle, so the preview port is
+ * tunnelled into the ISP and the ISP output is scaled to the size
+ * requested on this node.
+ * ------------------------------------------------------------------
+ */
+
+static int preview_queue_setup(struct vb2_queue *vq,
+			       unsigned int *nbuffers, unsigned int *nplanes,
+			       unsigned int sizes[],
+			       struct device *alloc_ctxs[])
+{
+	struct bm2835_mmal_dev *dev = vb2_get_drv_priv(vq);
+	struct vchiq_mmal_port *port = dev->preview.port;
+
+	/* Handle CREATE_BUFS situation - *nplanes != 0 */
+	if (*nplanes) {
+		if (*nplanes != 1 || sizes[0] < dev->preview.buffersize)
+			return -EINVAL;
+		return 0;
+	}
+
+	if (*nbuffers < port->minimum_buffer.num)
+		*nbuffers = port->minimum_buffer.num;
+
+	*nplanes = 1;
+	sizes[0] = dev->preview.buffersize;
+
+	v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev, "%s: dev:%p\n",
+		 __func__, dev);
+
+	return 0;
+}
+
+static void preview_buffer_cb(struct vchiq_mmal_instance *instance,
+			      struct vchiq_mmal_port *port,
+			      int status,
+			      struct mmal_buffer *mmal_buf)
+{
+	struct bm2835_mmal_dev *dev = port->cb_ctx;
+	struct vb2_mmal_buffer *buf =
+			container_of(mmal_buf, struct vb2_mmal_buffer, mmal);
+
+	v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev,
+		 "%s: status:%d, buf:%p, length:%lu, flags %u, pts %lld\n",
+		 __func__, status, buf, mmal_buf->length, mmal_buf->mmal_flags,
+		 mmal_buf->pts);
+
+	if (!dev->preview.streaming) {
+		/* stopping streaming - return buffer and signal completion */
+		vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
+		complete(&dev->preview.frame_cmplt);
+		return;
+	}
+
+	if (status != 0) {
+		vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_ERROR);
+		return;
+	}
+
+	if (mmal_buf->length == 0) {
+		/* empty buffer whilst streaming, so hand it straight back */
+		if (vchiq_mmal_submit_buffer(instance, port, &buf->mmal))
+			v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev,
+				 "Failed to return empty buffer");
+		return;
+	}
+
+	if (dev->preview.vc_start_timestamp == -1 || !mmal_buf->pts ||
+	    mmal_buf->pts == MMAL_TIME_UNKNOWN) {
+		buf->vb.vb2_buf.timestamp = ktime_get_ns();
+	} else {
+		s64 runtime_us = mmal_buf->pts -
+				 dev->preview.vc_start_timestamp;
+
+		buf->vb.vb2_buf.timestamp =
+			ktime_to_ns(ktime_add_us(dev->preview.kernel_start_ts,
+						 runtime_us));
+	}
+	buf->vb.sequence = dev->preview.sequence++;
+	buf->vb.field = V4L2_FIELD_NONE;
+
+	vb2_set_plane_payload(&buf->vb.vb2_buf, 0, mmal_buf->length);
+	vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_DONE);
+}
+
+/* program the ISP output port with the format set on the preview node */
+static int preview_set_port_format(struct bm2835_mmal_dev *dev,
+				   unsigned int num_buffers)
+{
+	struct vchiq_mmal_port *port = dev->preview.port;
+	int ret;
+
+	port->format.encoding = dev->preview.fmt->mmal;
+	port->format.encoding_variant = 0;
+	port->es.video.width = dev->preview.stride / dev->preview.fmt->ybbp;
+	port->es.video.height = ALIGN(dev->preview.height, 16);
+	port->es.video.crop.x = 0;
+	port->es.video.crop.y = 0;
+	port->es.video.crop.width = dev->preview.width;
+	port->es.video.crop.height = dev->preview.height;
+	port->es.video.frame_rate.num = 0;
+	port->es.video.frame_rate.den = 1;
+
+	ret = vchiq_mmal_port_set_format(dev->instance, port);
+	if (ret)
+		return ret;
+
+	/* configure buffering */
+	port->current_buffer.num = num_buffers;
+	port->current_buffer.size = dev->preview.buffersize;
+	port->current_buffer.alignment = 0;
+
+	return 0;
+}
+
+/* hand back buffers that never made it to the VPU */
+static void preview_return_buffers(struct bm2835_mmal_dev *dev)
+{
+	struct vchiq_mmal_port *port = dev->preview.port;
+	struct mmal_buffer *mmal_buf, *tmp;
+	unsigned long flags;
+
+	spin_lock_irqsave(&port->slock, flags);
+	list_for_each_entry_safe(mmal_buf, tmp, &port->buffers, list) {
+		struct vb2_mmal_buffer *buf =
+			container_of(mmal_buf, struct vb2_mmal_buffer, mmal);
+
+		list_del(&mmal_buf->list);
+		vb2_buffer_done(&buf->vb.vb2_buf, VB2_BUF_STATE_QUEUED);
+	}
+	spin_unlock_irqrestore(&port->slock, flags);
+}
+
+static int preview_start_streaming(struct vb2_queue *vq, unsigned int count)
+{
+	struct bm2835_mmal_dev *dev = vb2_get_drv_priv(vq);
+	struct vchiq_mmal_component *isp = dev->component[COMP_PREVIEW_ISP];
+	struct vchiq_mmal_port *src =
+		&dev->component[COMP_CAMERA]->output[CAM_PORT_PREVIEW];
+	struct vchiq_mmal_port *port = dev->preview.port;
+	u32 parameter_size;
+	int ret;
+
+	v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev, "%s: dev:%p\n",
+		 __func__, dev);
+
+	/* the overlay and this node can't both own the preview port */
+	if (dev->component[COMP_PREVIEW]->enabled) {
+		ret = -EBUSY;
+		goto return_buffers;
+	}
+
+	if (enable_camera(dev) < 0) {
+		v4l2_err(&dev->v4l2_dev, "Failed to enable camera\n");
+		ret = -EINVAL;
+		goto return_buffers;
+	}
+
+	dev->preview.sequence = 0;
+
+	ret = vchiq_mmal_port_set_format(dev->instance, src);
+	if (!ret)
+		ret = vchiq_mmal_port_connect_tunnel(dev->instance, src,
+						     &isp->input[0]);
+	if (!ret)
+		ret = preview_set_port_format(dev, vq->num_buffers);
+	if (!ret)
+		ret = vchiq_mmal_component_enable(dev->instance, isp);
+	if (!ret)
+		ret = vchiq_mmal_port_enable(dev->instance, src, NULL);
+	if (ret) {
+		v4l2_err(&dev->v4l2_dev,
+			 "Failed to set up preview ISP - error %d\n", ret);
+		goto disconnect;
+	}
+
+	/* Get VC timestamp at this point in time */
+	parameter_size = sizeof(dev->preview.vc_start_timestamp);
+	if (vchiq_mmal_port_parameter_get(dev->instance, src,
+					  MMAL_PARAMETER_SYSTEM_TIME,
+					  &dev->preview.vc_start_timestamp,
+					  &parameter_size))
+		dev->preview.vc_start_timestamp = -1;
+	dev->preview.kernel_start_ts = ktime_get();
+
+	dev->preview.streaming = true;
+	/*
+	 * Not direct_cb: preview_buffer_cb hands empty buffers straight back
+	 * to the VPU, which must not be done from the VCHIQ callback thread.
+	 */
+	port->cb_ctx = dev;
+	ret = vchiq_mmal_port_enable(dev->instance, port, preview_buffer_cb);
+	if (ret) {
+		v4l2_err(&dev->v4l2_dev,
+			 "Failed to enable preview port - error %d\n", ret);
+		dev->preview.streaming = false;
+		goto disconnect;
+	}
+
+	return 0;
+
+disconnect:
+	vchiq_mmal_port_disable(dev->instance, src);
+	vchiq_mmal_port_connect_tunnel(dev->instance, src, NULL);
+	vchiq_mmal_component_disable(dev->instance, isp);
+	disable_camera(dev);
+return_buffers:
+	preview_return_buffers(dev);
+	return ret;
+}
+
+static void preview_stop_streaming(struct vb2_queue *vq)
+{
+	struct bm2835_mmal_dev *dev = vb2_get_drv_priv(vq);
+	struct vchiq_mmal_port *src =
+		&dev->component[COMP_CAMERA]->output[CAM_PORT_PREVIEW];
+	struct vchiq_mmal_port *port = dev->preview.port;
+	unsigned long timeout;
+
+	v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev, "%s: dev:%p\n",
+		 __func__, dev);
+
+	init_completion(&dev->preview.frame_cmplt);
+	dev->preview.streaming = false;
+
+	vchiq_mmal_port_disable(dev->instance, src);
+	vchiq_mmal_port_connect_tunnel(dev->instance, src, NULL);
+	vchiq_mmal_port_disable(dev->instance, port);
+
+	/* wait for all buffers to be returned */
+	while (atomic_read(&port->buffers_with_vpu)) {
+		timeout = wait_for_completion_timeout(&dev->preview.frame_cmplt,
+						      HZ);
+		if (timeout == 0) {
+			v4l2_err(&dev->v4l2_dev, "%s: Timeout waiting for buffers to be returned - %d outstanding\n",
+				 __func__,
+				 atomic_read(&port->buffers_with_vpu));
+			break;
+		}
+	}
+
+	vchiq_mmal_component_disable(dev->instance,
+				     dev->component[COMP_PREVIEW_ISP]);
+
+	if (disable_camera(dev) < 0)
+		v4l2_err(&dev->v4l2_dev, "Failed to disable camera\n");
+}
+
+static const struct vb2_ops bm2835_mmal_preview_qops = {
+	.queue_setup = preview_queue_setup,
+	.buf_init = buffer_init,
+	.buf_prepare = buffer_prepare,
+	.buf_cleanup = buffer_cleanup,
+	.buf_queue = buffer_queue,
+	.start_streaming = preview_start_streaming,
+	.stop_streaming = preview_stop_streaming,
+	.wait_prepare = vb2_ops_wait_prepare,
+	.wait_finish = vb2_ops_wait_finish,
+};
+
 /* ------------------------------------------------------------------
  *	IOCTL operations
  * ------------------------------------------------------------------
@@ -839,6 +1165,9 @@ static int vidioc_overlay(struct file *file, void *f, unsigned int on)
 	    (!on && !dev->component[COMP_PREVIEW]->enabled))
 		return 0;	/* already in requested state */
 
+	if (on && vb2_is_streaming(&dev->preview.vb_vidq))
+		return -EBUSY;	/* preview port is feeding the preview node */
+
 	src =
 	    &dev->component[COMP_CAMERA]->output[CAM_PORT_PREVIEW];
 
@@ -1093,6 +1422,17 @@ static int mmal_setup_components(struct bm2835_mmal_dev *dev,
 	if (!mfmt)
 		return -EINVAL;
 
+	/*
+	 * The preview port has to follow the video port's resolution, which
+	 * it can't do whilst it is streaming to the preview node.
+	 */
+	if (vb2_is_streaming(&dev->preview.vb_vidq) &&
+	    (mfmt->mmal_component == COMP_VIDEO_ENCODE ||
+	     (mfmt->mmal_component == COMP_CAMERA &&
+	      f->fmt.pix.width <= max_video_width &&
+	      f->fmt.pix.height <= max_video_height)))
+		return -EBUSY;
+
 	if (dev->capture.encode_component) {
 		v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev,
 			 "vid_cap - disconnect previous tunnel\n");
@@ -1386,7 +1726,9 @@ static int vidioc_s_fmt_vid_cap(struct file *file, void *priv,
 	}
 
 	ret = mmal_setup_components(dev, f);
-	if (ret != 0) {
+	if (ret == -EBUSY) {
+		v4l2_info(&dev->v4l2_dev, "%s preview node busy\n", __func__);
+	} else if (ret != 0) {
 		v4l2_err(&dev->v4l2_dev,
 			 "%s: failed to setup mmal components: %d\n",
 			 __func__, ret);
@@ -1396,6 +1738,132 @@ static int vidioc_s_fmt_vid_cap(struct file *file, void *priv,
 	return ret;
 }
 
+/* preview node capture ioctls */
+static int vidioc_querycap_preview(struct file *file, void *priv,
+				   struct v4l2_capability *cap)
+{
+	vidioc_querycap(file, priv, cap);
+	cap->device_caps = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING |
+			   V4L2_CAP_READWRITE;
+
+	return 0;
+}
+
+static int vidioc_enum_fmt_vid_cap_preview(struct file *file, void *priv,
+					   struct v4l2_fmtdesc *f)
+{
+	unsigned int index = f->index;
+	struct mmal_fmt *fmt;
+	int i;
+
+	/* only the raw formats can come out of the ISP */
+	for (i = 0; i < ARRAY_SIZE(formats); i++) {
+		fmt = &formats[i];
+		if (fmt->mmal_component != COMP_CAMERA)
+			continue;
+		if (index--)
+			continue;
+
+		strlcpy((char *)f->description, fmt->name,
+			sizeof(f->description));
+		f->pixelformat = fmt->fourcc;
+		f->flags = fmt->flags;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+static int vidioc_g_fmt_vid_cap_preview(struct file *file, void *priv,
+					struct v4l2_format *f)
+{
+	struct bm2835_mmal_dev *dev = video_drvdata(file);
+
+	f->fmt.pix.width = dev->preview.width;
+	f->fmt.pix.height = dev->preview.height;
+	f->fmt.pix.field = V4L2_FIELD_NONE;
+	f->fmt.pix.pixelformat = dev->preview.fmt->fourcc;
+	f->fmt.pix.bytesperline = dev->preview.stride;
+	f->fmt.pix.sizeimage = dev->preview.buffersize;
+
+	if (dev->preview.fmt->fourcc == V4L2_PIX_FMT_RGB24)
+		f->fmt.pix.colorspace = V4L2_COLORSPACE_SRGB;
+	else
+		f->fmt.pix.colorspace = V4L2_COLORSPACE_SMPTE170M;
+	f->fmt.pix.priv = 0;
+
+	return 0;
+}
+
+static struct mmal_fmt *preview_try_fmt(struct bm2835_mmal_dev *dev,
+					struct v4l2_format *f)
+{
+	struct mmal_fmt *mfmt = get_format(f);
+
+	if (!mfmt || mfmt->mmal_component != COMP_CAMERA) {
+		v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev,
+			 "Fourcc format (0x%08x) not supported on preview.\n",
+			 f->fmt.pix.pixelformat);
+		mfmt = &formats[0];
+		f->fmt.pix.pixelformat = mfmt->fourcc;
+	}
+
+	f->fmt.pix.field = V4L2_FIELD_NONE;
+
+	v4l_bound_align_image(&f->fmt.pix.width, MIN_WIDTH, dev->max_width, 1,
+			      &f->fmt.pix.height, MIN_HEIGHT, dev->max_height,
+			      1, 0);
+
+	/* ISP output lines are padded to a multiple of 32 pixels */
+	f->fmt.pix.bytesperline = ALIGN(f->fmt.pix.width, 32) * mfmt->ybbp;
+	f->fmt.pix.sizeimage = (f->fmt.pix.bytesperline *
+				ALIGN(f->fmt.pix.height, 16) * mfmt->depth) /
+			       (mfmt->ybbp << 3);
+
+	if (f->fmt.pix.pixelformat == V4L2_PIX_FMT_RGB24)
+		f->fmt.pix.colorspace = V4L2_COLORSPACE_SRGB;
+	else
+		f->fmt.pix.colorspace = V4L2_COLORSPACE_SMPTE170M;
+	f->fmt.pix.priv = 0;
+
+	return mfmt;
+}
+
+static void preview_set_fmt(struct bm2835_mmal_dev *dev,
+			    struct v4l2_format *f)
+{
+	dev->preview.fmt = preview_try_fmt(dev, f);
+	dev->preview.width = f->fmt.pix.width;
+	dev->preview.height = f->fmt.pix.height;
+	dev->preview.stride = f->fmt.pix.bytesperline;
+	dev->preview.buffersize = f->fmt.pix.sizeimage;
+}
+
+static int vidioc_try_fmt_vid_cap_preview(struct file *file, void *priv,
+					  struct v4l2_format *f)
+{
+	struct bm2835_mmal_dev *dev = video_drvdata(file);
+
+	preview_try_fmt(dev, f);
+
+	return 0;
+}
+
+static int vidioc_s_fmt_vid_cap_preview(struct file *file, void *priv,
+					struct v4l2_format *f)
+{
+	struct bm2835_mmal_dev *dev = video_drvdata(file);
+
+	if (vb2_is_busy(&dev->preview.vb_vidq)) {
+		v4l2_info(&dev->v4l2_dev, "%s device busy\n", __func__);
+		return -EBUSY;
+	}
+
+	preview_set_fmt(dev, f);
+
+	return 0;
+}
+
 static int vidioc_enum_framesizes(struct file *file, void *fh,
 				  struct v4l2_frmsizeenum *fsize)
 {
@@ -1523,6 +1991,7 @@ static const struct v4l2_ioctl_ops camera0_ioctl_ops = {
 	.vidioc_querybuf = vb2_ioctl_querybuf,
 	.vidioc_qbuf = vb2_ioctl_qbuf,
 	.vidioc_dqbuf = vb2_ioctl_dqbuf,
+	.vidioc_expbuf = vb2_ioctl_expbuf,
 	.vidioc_enum_framesizes = vidioc_enum_framesizes,
 	.vidioc_enum_frameintervals = vidioc_enum_frameintervals,
 	.vidioc_g_parm        = vidioc_g_parm,
@@ -1535,6 +2004,37 @@ static const struct v4l2_ioctl_ops camera0_ioctl_ops = {
 	.vidioc_unsubscribe_event = v4l2_event_unsubscribe,
 };
 
+static const struct v4l2_ioctl_ops camera0_preview_ioctl_ops = {
+	/* inputs */
+	.vidioc_enum_input = vidioc_enum_input,
+	.vidioc_g_input = vidioc_g_input,
+	.vidioc_s_input = vidioc_s_input,
+
+	/* capture */
+	.vidioc_querycap = vidioc_querycap_preview,
+	.vidioc_enum_fmt_vid_cap = vidioc_enum_fmt_vid_cap_preview,
+	.vidioc_g_fmt_vid_cap = vidioc_g_fmt_vid_cap_preview,
+	.vidioc_try_fmt_vid_cap = vidioc_try_fmt_vid_cap_preview,
+	.vidioc_s_fmt_vid_cap = vidioc_s_fmt_vid_cap_preview,
+
+	/* buffer management */
+	.vidioc_reqbufs = vb2_ioctl_reqbufs,
+	.vidioc_create_bufs = vb2_ioctl_create_bufs,
+	.vidioc_prepare_buf = vb2_ioctl_prepare_buf,
+	.vidioc_querybuf = vb2_ioctl_querybuf,
+	.vidioc_qbuf = vb2_ioctl_qbuf,
+	.vidioc_dqbuf = vb2_ioctl_dqbuf,
+	.vidioc_expbuf = vb2_ioctl_expbuf,
+	.vidioc_g_parm        = vidioc_g_parm,
+	.vidioc_s_parm        = vidioc_s_parm,
+	.vidioc_streamon = vb2_ioctl_streamon,
+	.vidioc_streamoff = vb2_ioctl_streamoff,
+
+	.vidioc_log_status = v4l2_ctrl_log_status,
+	.vidioc_subscribe_event = v4l2_ctrl_subscribe_event,
+	.vidioc_unsubscribe_event = v4l2_event_unsubscribe,
+};
+
 /* ------------------------------------------------------------------
  *	Driver init/finalise
  * ------------------------------------------------------------------
@@ -1557,6 +2057,13 @@ static const struct video_device vdev_template = {
 	.release = video_device_release_empty,
 };
 
+static const struct video_device preview_vdev_template = {
+	.name = "camera0-preview",
+	.fops = &camera0_fops,
+	.ioctl_ops = &camera0_preview_ioctl_ops,
+	.release = video_device_release_empty,
+};
+
 /* Returns the number of cameras, and also the max resolution supported
  * by those cameras.
  */
@@ -1794,6 +2301,24 @@ static int mmal_init(struct bm2835_mmal_dev *dev)
 
 	{
 		unsigned int enable = 1;
+		struct vchiq_mmal_port *capture_ports[] = {
+			&camera->output[CAM_PORT_VIDEO],
+			&camera->output[CAM_PORT_CAPTURE],
+			&dev->component[COMP_IMAGE_ENCODE]->output[0],
+			&dev->component[COMP_VIDEO_ENCODE]->output[0],
+		};
+		int i;
+
+		/*
+		 * Every port that can be dev->capture.port returns buffers
+		 * imported through vc-sm-cma rather than bulk transferring
+		 * the payload.
+		 */
+		for (i = 0; i < ARRAY_SIZE(capture_ports); i++)
+			vchiq_mmal_port_parameter_set(dev->instance,
+						      capture_ports[i],
+						      MMAL_PARAMETER_ZERO_COPY,
+						      &enable, sizeof(enable));
 
 		vchiq_mmal_port_parameter_set(
 			dev->instance,
@@ -1807,15 +2332,51 @@ static int mmal_init(struct bm2835_mmal_dev *dev)
 					      &enable,
 					      sizeof(enable));
 	}
+
+	if (preview_node) {
+		struct vchiq_mmal_component *isp;
+		unsigned int enable = 1;
+
+		/* get the ISP scaling the preview port ready */
+		ret = vchiq_mmal_component_init(
+			dev->instance, "ril.isp",
+			&dev->component[COMP_PREVIEW_ISP]);
+		if (ret < 0)
+			goto unreg_vid_encoder;
+
+		isp = dev->component[COMP_PREVIEW_ISP];
+		if (isp->inputs < 1 || isp->outputs < 1) {
+			ret = -EINVAL;
+			v4l2_err(&dev->v4l2_dev, "%s: too few ISP ports\n",
+				 __func__);
+			goto unreg_preview_isp;
+		}
+
+		dev->preview.port = &isp->output[0];
+		vchiq_mmal_port_parameter_set(dev->instance, dev->preview.port,
+					      MMAL_PARAMETER_ZERO_COPY,
+					      &enable, sizeof(enable));
+	}
+
 	ret = bm2835_mmal_set_all_camera_controls(dev);
 	if (ret < 0) {
 		v4l2_err(&dev->v4l2_dev, "%s: failed to set all camera controls: %d\n",
 			 __func__, ret);
-		goto unreg_vid_encoder;
+		goto unreg_preview_isp;
 	}
 
 	return 0;
 
+unreg_preview_isp:
+	if (dev->component[COMP_PREVIEW_ISP]) {
+		pr_err("Cleanup: Destroy preview ISP\n");
+		vchiq_mmal_component_finalise(
+			dev->instance,
+			dev->component[COMP_PREVIEW_ISP]);
+		dev->component[COMP_PREVIEW_ISP] = NULL;
+		dev->preview.port = NULL;
+	}
+
 unreg_vid_encoder:
 	pr_err("Cleanup: Destroy video encoder\n");
 	vchiq_mmal_component_finalise(
@@ -1873,6 +2434,31 @@ static int bm2835_mmal_init_device(struct bm2835_mmal_dev *dev,
 	return 0;
 }
 
+static int bm2835_mmal_init_preview_device(struct bm2835_mmal_dev *dev)
+{
+	struct video_device *vfd = &dev->preview.vdev;
+	int ret;
+
+	*vfd = preview_vdev_template;
+
+	vfd->v4l2_dev = &dev->v4l2_dev;
+
+	vfd->lock = &dev->mutex;
+
+	vfd->queue = &dev->preview.vb_vidq;
+
+	video_set_drvdata(vfd, dev);
+
+	ret = video_register_device(vfd, VFL_TYPE_GRABBER, -1);
+	if (ret < 0)
+		return ret;
+
+	v4l2_info(vfd->v4l2_dev, "Preview node registered as %s\n",
+		  video_device_node_name(vfd));
+
+	return 0;
+}
+
 static void bcm2835_cleanup_instance(struct bm2835_mmal_dev *dev)
 {
 	if (!dev)
@@ -1882,6 +2468,7 @@ static void bcm2835_cleanup_instance(struct bm2835_mmal_dev *dev)
 		  video_device_node_name(&dev->vdev));
 
 	video_unregister_device(&dev->vdev);
+	video_unregister_device(&dev->preview.vdev);
 
 	if (dev->capture.encode_component) {
 		v4l2_dbg(1, bcm2835_v4l2_debug, &dev->v4l2_dev,
@@ -1894,6 +2481,10 @@ static void bcm2835_cleanup_instance(struct bm2835_mmal_dev *dev)
 	vchiq_mmal_component_disable(dev->instance,
 				     dev->component[COMP_CAMERA]);
 
+	if (dev->component[COMP_PREVIEW_ISP])
+		vchiq_mmal_component_finalise(dev->instance,
+					      dev->component[COMP_PREVIEW_ISP]);
+
 	vchiq_mmal_component_finalise(dev->instance,
 				      dev->component[COMP_VIDEO_ENCODE]);
 
@@ -1921,6 +2512,12 @@ static struct v4l2_format default_v4l2_format = {
 	.fmt.pix.sizeimage = 1024 * 768,
 };
 
+static const struct v4l2_format default_preview_format = {
+	.fmt.pix.pixelformat = V4L2_PIX_FMT_YUV420,
+	.fmt.pix.width = 640,
+	.fmt.pix.height = 480,
+};
+
 static int bcm2835_mmal_probe(struct platform_device *pdev)
 {
 	int ret;
@@ -2003,11 +2600,12 @@ static int bcm2835_mmal_probe(struct platform_device *pdev)
 		q = &dev->capture.vb_vidq;
 		memset(q, 0, sizeof(*q));
 		q->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-		q->io_modes = VB2_MMAP | VB2_USERPTR | VB2_READ;
+		q->io_modes = VB2_MMAP | VB2_DMABUF | VB2_READ;
 		q->drv_priv = dev;
 		q->buf_struct_size = sizeof(struct vb2_mmal_buffer);
 		q->ops = &bm2835_mmal_video_qops;
-		q->mem_ops = &vb2_vmalloc_memops;
+		q->mem_ops = &vb2_dma_contig_memops;
+		q->dev = &pdev->dev;
 		q->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
 		q->lock = &dev->mutex;
 		ret = vb2_queue_init(q);
@@ -2032,6 +2630,33 @@ static int bcm2835_mmal_probe(struct platform_device *pdev)
 			goto unreg_dev;
 		}
 
+		if (dev->preview.port) {
+			struct v4l2_format f = default_preview_format;
+
+			q = &dev->preview.vb_vidq;
+			q->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			q->io_modes = VB2_MMAP | VB2_DMABUF | VB2_READ;
+			q->drv_priv = dev;
+			q->buf_struct_size = sizeof(struct vb2_mmal_buffer);
+			q->ops = &bm2835_mmal_preview_qops;
+			q->mem_ops = &vb2_dma_contig_memops;
+			q->dev = &pdev->dev;
+			q->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+			q->lock = &dev->mutex;
+			ret = vb2_queue_init(q);
+			if (ret < 0)
+				goto unreg_dev;
+
+			preview_set_fmt(dev, &f);
+
+			ret = bm2835_mmal_init_preview_device(dev);
+			if (ret < 0) {
+				v4l2_err(&dev->v4l2_dev, "%s: could not init preview device: %d\n",
+					 __func__, ret);
+				goto unreg_dev;
+			}
+		}
+
 		v4l2_info(&dev->v4l2_dev,
 			  "Broadcom 2835 MMAL video capture ver %s loaded.\n",
 			  BM2835_MMAL_VERSION);
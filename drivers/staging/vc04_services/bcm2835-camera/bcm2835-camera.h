@@ -20,6 +20,7 @@ enum {
 	COMP_PREVIEW,
 	COMP_IMAGE_ENCODE,
 	COMP_VIDEO_ENCODE,
+	COMP_PREVIEW_ISP,
 	COMP_COUNT
 };
 
@@ -108,6 +109,31 @@ struct bm2835_mmal_dev {
 
 	} capture;
 
+	/* second capture node, fed from the preview port via the ISP */
+	struct {
+		struct video_device	vdev;
+		unsigned int     width;  /* width */
+		unsigned int     height;  /* height */
+		unsigned int     stride;  /* stride */
+		unsigned int     buffersize; /* buffer size with padding */
+		struct mmal_fmt  *fmt;
+
+		struct vb2_queue	vb_vidq;
+
+		/* VC start timestamp for streaming */
+		s64         vc_start_timestamp;
+		/* Kernel start timestamp for streaming */
+		ktime_t kernel_start_ts;
+		/* Sequence number of last buffer */
+		u32		sequence;
+
+		struct vchiq_mmal_port  *port; /* ISP output port */
+		/* set whilst buffers should be returned to userspace */
+		bool		streaming;
+		/* last frame completion */
+		struct completion  frame_cmplt;
+	} preview;
+
 	unsigned int camera_num;
 	unsigned int max_width;
 	unsigned int max_height;
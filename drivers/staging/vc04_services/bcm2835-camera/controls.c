@@ -157,22 +157,54 @@ static const struct v4l2_mmal_scene_config scene_configs[] = {
 
 /* control handlers*/
 
+static void ctrl_set_async_cb(struct vchiq_mmal_instance *instance,
+			      struct vchiq_mmal_port *port, int status,
+			      void *cb_ctx)
+{
+	if (status)
+		pr_warn("camera control port %d MMAL param update returned ret %d\n",
+			port->handle, status);
+}
+
+/*
+ * Queue parameters on the camera control port without waiting for the VPU
+ * to reply, so that controls updated every frame don't stall the ioctl.
+ * The VPU handles messages in order, so any later synchronous call still
+ * sees them applied. Errors from the VPU itself can only be logged.
+ */
+static int ctrl_set_camera_params(struct bm2835_mmal_dev *dev,
+				  const struct vchiq_mmal_param *params,
+				  unsigned int num_params)
+{
+	return vchiq_mmal_port_parameter_set_async(dev->instance,
+					&dev->component[COMP_CAMERA]->control,
+					params, num_params,
+					ctrl_set_async_cb, NULL);
+}
+
+static int ctrl_set_camera_param(struct bm2835_mmal_dev *dev, u32 id,
+				 void *value, u32 size)
+{
+	const struct vchiq_mmal_param param = {
+		.id = id,
+		.value = value,
+		.size = size,
+	};
+
+	return ctrl_set_camera_params(dev, &param, 1);
+}
+
 static int ctrl_set_rational(struct bm2835_mmal_dev *dev,
 			     struct v4l2_ctrl *ctrl,
 			     const struct bm2835_mmal_v4l2_ctrl *mmal_ctrl)
 {
 	struct mmal_parameter_rational rational_value;
-	struct vchiq_mmal_port *control;
-
-	control = &dev->component[COMP_CAMERA]->control;
 
 	rational_value.num = ctrl->val;
 	rational_value.den = 100;
 
-	return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     mmal_ctrl->mmal_id,
-					     &rational_value,
-					     sizeof(rational_value));
+	return ctrl_set_camera_param(dev, mmal_ctrl->mmal_id, &rational_value,
+				     sizeof(rational_value));
 }
 
 static int ctrl_set_value(struct bm2835_mmal_dev *dev,
@@ -180,15 +212,11 @@ static int ctrl_set_value(struct bm2835_mmal_dev *dev,
 			  const struct bm2835_mmal_v4l2_ctrl *mmal_ctrl)
 {
 	u32 u32_value;
-	struct vchiq_mmal_port *control;
-
-	control = &dev->component[COMP_CAMERA]->control;
 
 	u32_value = ctrl->val;
 
-	return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     mmal_ctrl->mmal_id,
-					     &u32_value, sizeof(u32_value));
+	return ctrl_set_camera_param(dev, mmal_ctrl->mmal_id,
+				     &u32_value, sizeof(u32_value));
 }
 
 static int ctrl_set_iso(struct bm2835_mmal_dev *dev,
@@ -196,7 +224,6 @@ static int ctrl_set_iso(struct bm2835_mmal_dev *dev,
 			const struct bm2835_mmal_v4l2_ctrl *mmal_ctrl)
 {
 	u32 u32_value;
-	struct vchiq_mmal_port *control;
 
 	if (ctrl->val > mmal_ctrl->max || ctrl->val < mmal_ctrl->min)
 		return 1;
@@ -207,16 +234,13 @@ static int ctrl_set_iso(struct bm2835_mmal_dev *dev,
 		dev->manual_iso_enabled =
 				(ctrl->val == V4L2_ISO_SENSITIVITY_MANUAL);
 
-	control = &dev->component[COMP_CAMERA]->control;
-
 	if (dev->manual_iso_enabled)
 		u32_value = dev->iso;
 	else
 		u32_value = 0;
 
-	return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     MMAL_PARAMETER_ISO,
-					     &u32_value, sizeof(u32_value));
+	return ctrl_set_camera_param(dev, MMAL_PARAMETER_ISO,
+				     &u32_value, sizeof(u32_value));
 }
 
 static int ctrl_set_value_ev(struct bm2835_mmal_dev *dev,
@@ -224,15 +248,11 @@ static int ctrl_set_value_ev(struct bm2835_mmal_dev *dev,
 			     const struct bm2835_mmal_v4l2_ctrl *mmal_ctrl)
 {
 	s32 s32_value;
-	struct vchiq_mmal_port *control;
-
-	control = &dev->component[COMP_CAMERA]->control;
 
 	s32_value = (ctrl->val - 12) * 2;	/* Convert from index to 1/6ths */
 
-	return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     mmal_ctrl->mmal_id,
-					     &s32_value, sizeof(s32_value));
+	return ctrl_set_camera_param(dev, mmal_ctrl->mmal_id,
+				     &s32_value, sizeof(s32_value));
 }
 
 static int ctrl_set_rotate(struct bm2835_mmal_dev *dev,
@@ -315,11 +335,12 @@ static int ctrl_set_exposure(struct bm2835_mmal_dev *dev,
 {
 	enum mmal_parameter_exposuremode exp_mode = dev->exposure_mode_user;
 	u32 shutter_speed = 0;
-	struct vchiq_mmal_port *control;
+	struct vchiq_mmal_param params[] = {
+		{ MMAL_PARAMETER_SHUTTER_SPEED, &shutter_speed, sizeof(u32) },
+		{ MMAL_PARAMETER_EXPOSURE_MODE, &exp_mode, sizeof(u32) },
+	};
 	int ret = 0;
 
-	control = &dev->component[COMP_CAMERA]->control;
-
 	if (mmal_ctrl->mmal_id == MMAL_PARAMETER_SHUTTER_SPEED)	{
 		/* V4L2 is in 100usec increments.
 		 * MMAL is 1usec.
@@ -345,22 +366,16 @@ static int ctrl_set_exposure(struct bm2835_mmal_dev *dev,
 		if (exp_mode == MMAL_PARAM_EXPOSUREMODE_OFF)
 			shutter_speed = dev->manual_shutter_speed;
 
-		ret = vchiq_mmal_port_parameter_set(dev->instance,
-						    control,
-						    MMAL_PARAMETER_SHUTTER_SPEED,
-						    &shutter_speed,
-						    sizeof(shutter_speed));
-		ret += vchiq_mmal_port_parameter_set(dev->instance,
-						     control,
-						     MMAL_PARAMETER_EXPOSURE_MODE,
-						     &exp_mode,
-						     sizeof(u32));
+		ret = ctrl_set_camera_params(dev, params, ARRAY_SIZE(params));
 		dev->exposure_mode_active = exp_mode;
 	}
 	/* exposure_dynamic_framerate (V4L2_CID_EXPOSURE_AUTO_PRIORITY) should
-	 * always apply irrespective of scene mode.
+	 * always apply irrespective of scene mode. The shutter speed alone
+	 * doesn't affect the frame rate range, so skip the synchronous update
+	 * for it.
 	 */
-	ret += set_framerate_params(dev);
+	if (mmal_ctrl->mmal_id != MMAL_PARAMETER_SHUTTER_SPEED)
+		ret += set_framerate_params(dev);
 
 	return ret;
 }
@@ -390,13 +405,9 @@ static int ctrl_set_metering_mode(struct bm2835_mmal_dev *dev,
 	}
 
 	if (dev->scene_mode == V4L2_SCENE_MODE_NONE) {
-		struct vchiq_mmal_port *control;
 		u32 u32_value = dev->metering_mode;
 
-		control = &dev->component[COMP_CAMERA]->control;
-
-		return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     mmal_ctrl->mmal_id,
+		return ctrl_set_camera_param(dev, mmal_ctrl->mmal_id,
 					     &u32_value, sizeof(u32_value));
 	} else {
 		return 0;
@@ -408,9 +419,6 @@ static int ctrl_set_flicker_avoidance(struct bm2835_mmal_dev *dev,
 				      const struct bm2835_mmal_v4l2_ctrl *mmal_ctrl)
 {
 	u32 u32_value;
-	struct vchiq_mmal_port *control;
-
-	control = &dev->component[COMP_CAMERA]->control;
 
 	switch (ctrl->val) {
 	case V4L2_CID_POWER_LINE_FREQUENCY_DISABLED:
@@ -427,9 +435,8 @@ static int ctrl_set_flicker_avoidance(struct bm2835_mmal_dev *dev,
 		break;
 	}
 
-	return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     mmal_ctrl->mmal_id,
-					     &u32_value, sizeof(u32_value));
+	return ctrl_set_camera_param(dev, mmal_ctrl->mmal_id,
+				     &u32_value, sizeof(u32_value));
 }
 
 static int ctrl_set_awb_mode(struct bm2835_mmal_dev *dev,
@@ -437,9 +444,6 @@ static int ctrl_set_awb_mode(struct bm2835_mmal_dev *dev,
 			     const struct bm2835_mmal_v4l2_ctrl *mmal_ctrl)
 {
 	u32 u32_value;
-	struct vchiq_mmal_port *control;
-
-	control = &dev->component[COMP_CAMERA]->control;
 
 	switch (ctrl->val) {
 	case V4L2_WHITE_BALANCE_MANUAL:
@@ -487,20 +491,16 @@ static int ctrl_set_awb_mode(struct bm2835_mmal_dev *dev,
 		break;
 	}
 
-	return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     mmal_ctrl->mmal_id,
-					     &u32_value, sizeof(u32_value));
+	return ctrl_set_camera_param(dev, mmal_ctrl->mmal_id,
+				     &u32_value, sizeof(u32_value));
 }
 
 static int ctrl_set_awb_gains(struct bm2835_mmal_dev *dev,
 			      struct v4l2_ctrl *ctrl,
 			      const struct bm2835_mmal_v4l2_ctrl *mmal_ctrl)
 {
-	struct vchiq_mmal_port *control;
 	struct mmal_parameter_awbgains gains;
 
-	control = &dev->component[COMP_CAMERA]->control;
-
 	if (ctrl->id == V4L2_CID_RED_BALANCE)
 		dev->red_gain = ctrl->val;
 	else if (ctrl->id == V4L2_CID_BLUE_BALANCE)
@@ -510,9 +510,8 @@ static int ctrl_set_awb_gains(struct bm2835_mmal_dev *dev,
 	gains.b_gain.num = dev->blue_gain;
 	gains.r_gain.den = gains.b_gain.den = 1000;
 
-	return vchiq_mmal_port_parameter_set(dev->instance, control,
-					     mmal_ctrl->mmal_id,
-					     &gains, sizeof(gains));
+	return ctrl_set_camera_param(dev, mmal_ctrl->mmal_id,
+				     &gains, sizeof(gains));
 }
 
 static int ctrl_set_image_effect(struct bm2835_mmal_dev *dev,
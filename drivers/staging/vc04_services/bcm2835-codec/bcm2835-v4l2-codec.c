@@ -21,12 +21,14 @@
  * License, or (at your option) any later version
  */
 #include <linux/module.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/fs.h>
 #include <linux/timer.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/syscalls.h>
 
 #include <media/v4l2-mem2mem.h>
@@ -40,6 +42,7 @@
 #include "vchiq-mmal/mmal-msg.h"
 #include "vchiq-mmal/mmal-parameters.h"
 #include "vchiq-mmal/mmal-vchiq.h"
+#include "vc-sm-cma/vc_sm_knl.h"
 
 /*
  * Default /dev/videoN node numbers for decode and encode.
@@ -58,6 +61,10 @@ static int isp_video_nr = 12;
 module_param(isp_video_nr, int, 0644);
 MODULE_PARM_DESC(isp_video_nr, "isp video device number");
 
+static int encode_image_nr = 13;
+module_param(encode_image_nr, int, 0644);
+MODULE_PARM_DESC(encode_image_nr, "image encoder video device number");
+
 /*
  * Workaround for GStreamer v4l2convert component not considering Bayer formats
  * as raw, and therefore not considering a V4L2 device that supports them as
@@ -71,22 +78,43 @@ static unsigned int debug;
 module_param(debug, uint, 0644);
 MODULE_PARM_DESC(debug, "activates debug info (0-3)");
 
+/*
+ * Submit all the buffers that are ready on both queues in a single
+ * device_run, rather than one source and one destination buffer per job.
+ */
+static bool batch_submit = true;
+module_param(batch_submit, bool, 0644);
+MODULE_PARM_DESC(batch_submit, "Submit all ready buffers in one m2m job");
+
+/*
+ * With batch_submit, limit each job to job_quantum buffers per port for
+ * every unit of a context's scheduling weight. The context then goes to the
+ * back of the mem2mem job queue, giving a weighted round robin between
+ * instances sharing the VPU.
+ */
+static unsigned int job_quantum = 2;
+module_param(job_quantum, uint, 0644);
+MODULE_PARM_DESC(job_quantum, "Buffers per port per unit weight in each job");
+
 enum bcm2835_codec_role {
 	DECODE,
 	ENCODE,
 	ISP,
+	ENCODE_IMAGE,
 };
 
 static const char * const roles[] = {
 	"decode",
 	"encode",
-	"isp"
+	"isp",
+	"encode_image",
 };
 
 static const char * const components[] = {
 	"ril.video_decode",
 	"ril.video_encode",
 	"ril.isp",
+	"ril.image_encode",
 };
 
 #define MIN_W		32
@@ -354,6 +382,11 @@ static const struct bcm2835_codec_fmt supported_formats[] = {
 		.depth			= 0,
 		.flags			= V4L2_FMT_FLAG_COMPRESSED,
 		.mmal_fmt		= MMAL_ENCODING_MJPEG,
+	}, {
+		.fourcc			= V4L2_PIX_FMT_JPEG,
+		.depth			= 0,
+		.flags			= V4L2_FMT_FLAG_COMPRESSED,
+		.mmal_fmt		= MMAL_ENCODING_JPEG,
 	}, {
 		.fourcc			= V4L2_PIX_FMT_MPEG4,
 		.depth			= 0,
@@ -387,6 +420,44 @@ struct m2m_mmal_buffer {
 	struct mmal_buffer	mmal;
 };
 
+/*
+ * VideoCore imports of dma-bufs are retained for the lifetime of the context
+ * once videobuf2 has finished with them, so that a dma-buf which moves
+ * between buffer indices, or is detached and queued again, doesn't have to
+ * be imported through vc-sm-cma again.
+ */
+#define MAX_IMPORT_CACHE	(2 * VIDEO_MAX_FRAME)
+
+/* Upper bound on the debugfs weight, so a job can't grow without limit */
+#define MAX_CTX_WEIGHT		16
+#define NUM_LATENCY_SLOTS	16
+
+/* Per context throughput statistics, exported through debugfs */
+struct bcm2835_codec_ctx_stats {
+	/* Lock over all the following fields */
+	spinlock_t		lock;
+	ktime_t			start;
+	u64			frames;
+	u64			bytes;
+	u64			latency_total_ns;
+	u64			latency_max_ns;
+	u64			latency_count;
+	/* Submission times of recent input buffers, matched by pts */
+	struct {
+		s64		pts;
+		ktime_t		submitted;
+	} inflight[NUM_LATENCY_SLOTS];
+	unsigned int		inflight_idx;
+};
+
+struct bcm2835_codec_import {
+	struct list_head	list;
+	/* Reference on the dma-buf that was imported */
+	struct dma_buf		*dma_buf;
+	void			*vcsm_handle;
+	u32			vc_handle;
+};
+
 /* Per-queue, driver-specific private data */
 struct bcm2835_codec_q_data {
 	/*
@@ -428,6 +499,16 @@ struct bcm2835_codec_dev {
 	struct vchiq_mmal_instance	*instance;
 
 	struct v4l2_m2m_dev	*m2m_dev;
+
+	/* Statistics for this role, exported through debugfs */
+	struct dentry		*debugfs_dir;
+	atomic64_t		num_device_runs;
+	/* Buffer submissions, each of which is a VCHIQ message */
+	atomic64_t		num_ip_submits;
+	atomic64_t		num_op_submits;
+	atomic64_t		num_op_frames;
+	atomic64_t		num_import_hits;
+	atomic_t		next_ctx_id;
 };
 
 struct bcm2835_codec_ctx {
@@ -450,10 +531,23 @@ struct bcm2835_codec_ctx {
 	unsigned int	framerate_num;
 	unsigned int	framerate_denom;
 
+	/* Encoder slice configuration, from the MULTI_SLICE controls */
+	enum v4l2_mpeg_video_multi_slice_mode slice_mode;
+	unsigned int	slice_max_mb;
+
 	bool aborting;
 	int num_ip_buffers;
 	int num_op_buffers;
 	struct completion frame_cmplt;
+
+	/* Cache of struct bcm2835_codec_import, most recent first */
+	struct list_head import_cache;
+	unsigned int num_imports;
+
+	/* Scheduling weight relative to other contexts on this role */
+	u32 weight;
+	struct bcm2835_codec_ctx_stats stats;
+	struct dentry *debugfs_dir;
 };
 
 struct bcm2835_codec_driver {
@@ -463,6 +557,9 @@ struct bcm2835_codec_driver {
 	struct bcm2835_codec_dev *encode;
 	struct bcm2835_codec_dev *decode;
 	struct bcm2835_codec_dev *isp;
+	struct bcm2835_codec_dev *encode_image;
+
+	struct dentry *debugfs_root;
 };
 
 enum {
@@ -782,6 +879,67 @@ static void handle_fmt_changed(struct bcm2835_codec_ctx *ctx,
 	queue_res_chg_event(ctx);
 }
 
+static void bcm2835_codec_stats_reset(struct bcm2835_codec_ctx *ctx)
+{
+	struct bcm2835_codec_ctx_stats *stats = &ctx->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->start = ktime_get();
+	stats->frames = 0;
+	stats->bytes = 0;
+	stats->latency_total_ns = 0;
+	stats->latency_max_ns = 0;
+	stats->latency_count = 0;
+	memset(stats->inflight, 0, sizeof(stats->inflight));
+	stats->inflight_idx = 0;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+static void bcm2835_codec_stats_ip_submit(struct bcm2835_codec_ctx *ctx,
+					  struct mmal_buffer *mmal_buf)
+{
+	struct bcm2835_codec_ctx_stats *stats = &ctx->stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	stats->inflight[stats->inflight_idx].pts = mmal_buf->pts;
+	stats->inflight[stats->inflight_idx].submitted = ktime_get();
+	stats->inflight_idx = (stats->inflight_idx + 1) % NUM_LATENCY_SLOTS;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
+static void bcm2835_codec_stats_op_done(struct bcm2835_codec_ctx *ctx,
+					struct mmal_buffer *mmal_buf)
+{
+	struct bcm2835_codec_ctx_stats *stats = &ctx->stats;
+	unsigned long flags;
+	unsigned int i;
+	u64 latency;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	/* Slices other than the last one of a frame don't count as frames */
+	if (ctx->slice_mode == V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_SINGLE ||
+	    mmal_buf->mmal_flags & MMAL_BUFFER_HEADER_FLAG_FRAME_END)
+		stats->frames++;
+	stats->bytes += mmal_buf->length;
+	for (i = 0; i < NUM_LATENCY_SLOTS; i++) {
+		if (!stats->inflight[i].submitted ||
+		    stats->inflight[i].pts != mmal_buf->pts)
+			continue;
+
+		latency = ktime_to_ns(ktime_sub(ktime_get(),
+						stats->inflight[i].submitted));
+		stats->inflight[i].submitted = 0;
+		stats->latency_total_ns += latency;
+		stats->latency_count++;
+		if (latency > stats->latency_max_ns)
+			stats->latency_max_ns = latency;
+		break;
+	}
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+
 static void op_buffer_cb(struct vchiq_mmal_instance *instance,
 			 struct vchiq_mmal_port *port, int status,
 			 struct mmal_buffer *mmal_buf)
@@ -850,8 +1008,11 @@ static void op_buffer_cb(struct vchiq_mmal_instance *instance,
 	if (mmal_buf->mmal_flags & MMAL_BUFFER_HEADER_FLAG_KEYFRAME)
 		vb2->flags |= V4L2_BUF_FLAG_KEYFRAME;
 
+	bcm2835_codec_stats_op_done(ctx, mmal_buf);
+
 	vb2_buffer_done(&vb2->vb2_buf, VB2_BUF_STATE_DONE);
 	ctx->num_op_buffers++;
+	atomic64_inc(&ctx->dev->num_op_frames);
 
 	v4l2_dbg(2, debug, &ctx->dev->v4l2_dev, "%s: done %d output buffers\n",
 		 __func__, ctx->num_op_buffers);
@@ -903,6 +1064,11 @@ static void vb2_to_mmal_buffer(struct m2m_mmal_buffer *buf,
  * This simulates all the immediate preparations required before starting
  * a device. This will be called by the framework when it decides to schedule
  * a particular instance.
+ *
+ * With batch_submit set, the buffers that are ready on either queue are
+ * passed to the VPU in this one job, so that the v4l2-mem2mem scheduling
+ * overhead is only paid once per burst of buffers. The burst is bounded by
+ * the context's weight so that one instance can't starve the others.
  */
 static void device_run(void *priv)
 {
@@ -911,43 +1077,63 @@ static void device_run(void *priv)
 	struct vb2_v4l2_buffer *src_buf, *dst_buf;
 	struct m2m_mmal_buffer *src_m2m_buf = NULL, *dst_m2m_buf = NULL;
 	struct v4l2_m2m_buffer *m2m;
+	unsigned int num_src = 0, num_dst = 0;
+	unsigned int quantum = clamp_t(u32, READ_ONCE(ctx->weight), 1,
+				       MAX_CTX_WEIGHT) * max(job_quantum, 1U);
 	int ret;
 
 	v4l2_dbg(3, debug, &ctx->dev->v4l2_dev, "%s: off we go\n", __func__);
 
-	src_buf = v4l2_m2m_buf_remove(&ctx->fh.m2m_ctx->out_q_ctx);
-	if (src_buf) {
-		m2m = container_of(src_buf, struct v4l2_m2m_buffer, vb);
-		src_m2m_buf = container_of(m2m, struct m2m_mmal_buffer, m2m);
-		vb2_to_mmal_buffer(src_m2m_buf, src_buf);
+	atomic64_inc(&dev->num_device_runs);
 
-		ret = vchiq_mmal_submit_buffer(dev->instance,
-					       &ctx->component->input[0],
-					       &src_m2m_buf->mmal);
-		v4l2_dbg(3, debug, &ctx->dev->v4l2_dev, "%s: Submitted ip buffer len %lu, pts %llu, flags %04x\n",
-			 __func__, src_m2m_buf->mmal.length,
-			 src_m2m_buf->mmal.pts, src_m2m_buf->mmal.mmal_flags);
-		if (ret)
-			v4l2_err(&ctx->dev->v4l2_dev, "%s: Failed submitting ip buffer\n",
-				 __func__);
-	}
+	do {
+		src_buf = NULL;
+		if (num_src < quantum)
+			src_buf = v4l2_m2m_buf_remove(&ctx->fh.m2m_ctx->out_q_ctx);
+		if (src_buf) {
+			m2m = container_of(src_buf, struct v4l2_m2m_buffer, vb);
+			src_m2m_buf = container_of(m2m, struct m2m_mmal_buffer,
+						   m2m);
+			vb2_to_mmal_buffer(src_m2m_buf, src_buf);
+			bcm2835_codec_stats_ip_submit(ctx, &src_m2m_buf->mmal);
+
+			ret = vchiq_mmal_submit_buffer(dev->instance,
+						       &ctx->component->input[0],
+						       &src_m2m_buf->mmal);
+			v4l2_dbg(3, debug, &ctx->dev->v4l2_dev, "%s: Submitted ip buffer len %lu, pts %llu, flags %04x\n",
+				 __func__, src_m2m_buf->mmal.length,
+				 src_m2m_buf->mmal.pts,
+				 src_m2m_buf->mmal.mmal_flags);
+			if (ret)
+				v4l2_err(&ctx->dev->v4l2_dev, "%s: Failed submitting ip buffer\n",
+					 __func__);
+			num_src++;
+		}
 
-	dst_buf = v4l2_m2m_buf_remove(&ctx->fh.m2m_ctx->cap_q_ctx);
-	if (dst_buf) {
-		m2m = container_of(dst_buf, struct v4l2_m2m_buffer, vb);
-		dst_m2m_buf = container_of(m2m, struct m2m_mmal_buffer, m2m);
-		vb2_to_mmal_buffer(dst_m2m_buf, dst_buf);
+		dst_buf = NULL;
+		if (num_dst < quantum)
+			dst_buf = v4l2_m2m_buf_remove(&ctx->fh.m2m_ctx->cap_q_ctx);
+		if (dst_buf) {
+			m2m = container_of(dst_buf, struct v4l2_m2m_buffer, vb);
+			dst_m2m_buf = container_of(m2m, struct m2m_mmal_buffer,
+						   m2m);
+			vb2_to_mmal_buffer(dst_m2m_buf, dst_buf);
 
-		ret = vchiq_mmal_submit_buffer(dev->instance,
-					       &ctx->component->output[0],
-					       &dst_m2m_buf->mmal);
-		if (ret)
-			v4l2_err(&ctx->dev->v4l2_dev, "%s: Failed submitting op buffer\n",
-				 __func__);
-	}
+			ret = vchiq_mmal_submit_buffer(dev->instance,
+						       &ctx->component->output[0],
+						       &dst_m2m_buf->mmal);
+			if (ret)
+				v4l2_err(&ctx->dev->v4l2_dev, "%s: Failed submitting op buffer\n",
+					 __func__);
+			num_dst++;
+		}
+	} while (batch_submit && (src_buf || dst_buf));
 
-	v4l2_dbg(3, debug, &ctx->dev->v4l2_dev, "%s: Submitted src %p, dst %p\n",
-		 __func__, src_m2m_buf, dst_m2m_buf);
+	atomic64_add(num_src, &dev->num_ip_submits);
+	atomic64_add(num_dst, &dev->num_op_submits);
+
+	v4l2_dbg(3, debug, &ctx->dev->v4l2_dev, "%s: Submitted %u src, %u dst\n",
+		 __func__, num_src, num_dst);
 
 	/* Complete the job here. */
 	v4l2_m2m_job_finish(ctx->dev->m2m_dev, ctx->fh.m2m_ctx);
@@ -1280,7 +1466,8 @@ static int vidioc_g_selection(struct file *file, void *priv,
 	switch (s->type) {
 	case V4L2_BUF_TYPE_VIDEO_CAPTURE:
 		/* CAPTURE on encoder is not valid. */
-		if (ctx->dev->role == ENCODE)
+		if (ctx->dev->role == ENCODE ||
+		    ctx->dev->role == ENCODE_IMAGE)
 			return -EINVAL;
 		q_data = &ctx->q_data[V4L2_M2M_DST];
 		break;
@@ -1315,6 +1502,7 @@ static int vidioc_g_selection(struct file *file, void *priv,
 		}
 		break;
 	case ENCODE:
+	case ENCODE_IMAGE:
 		switch (s->target) {
 		case V4L2_SEL_TGT_CROP_DEFAULT:
 		case V4L2_SEL_TGT_CROP_BOUNDS:
@@ -1357,7 +1545,8 @@ static int vidioc_s_selection(struct file *file, void *priv,
 	switch (s->type) {
 	case V4L2_BUF_TYPE_VIDEO_CAPTURE:
 		/* CAPTURE on encoder is not valid. */
-		if (ctx->dev->role == ENCODE)
+		if (ctx->dev->role == ENCODE ||
+		    ctx->dev->role == ENCODE_IMAGE)
 			return -EINVAL;
 		q_data = &ctx->q_data[V4L2_M2M_DST];
 		break;
@@ -1393,6 +1582,7 @@ static int vidioc_s_selection(struct file *file, void *priv,
 		}
 		break;
 	case ENCODE:
+	case ENCODE_IMAGE:
 		switch (s->target) {
 		case V4L2_SEL_TGT_CROP:
 			/* Only support crop from (0,0) */
@@ -1560,6 +1750,40 @@ static int bcm2835_codec_set_level_profile(struct bcm2835_codec_ctx *ctx,
 	return ret;
 }
 
+/*
+ * In multi-slice mode the encoder is also switched into low latency mode, so
+ * that each slice is returned in its own buffer as soon as it has been
+ * encoded rather than waiting for the whole frame. All the buffers for a
+ * frame carry the same timestamp, with the following frame starting when the
+ * timestamp changes.
+ */
+static int bcm2835_codec_set_slices(struct bcm2835_codec_ctx *ctx)
+{
+	struct bcm2835_codec_q_data *q_data = &ctx->q_data[V4L2_M2M_SRC];
+	u32 low_latency = 0;
+	u32 mb_rows = 0;
+	u32 mb_width;
+	int ret;
+
+	if (ctx->slice_mode == V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_MAX_MB) {
+		mb_width = DIV_ROUND_UP(q_data->crop_width, 16);
+		mb_rows = max(ctx->slice_max_mb / mb_width, 1U);
+		low_latency = 1;
+	}
+
+	ret = vchiq_mmal_port_parameter_set(ctx->dev->instance,
+					    &ctx->component->output[0],
+					    MMAL_PARAMETER_MB_ROWS_PER_SLICE,
+					    &mb_rows, sizeof(mb_rows));
+	if (ret)
+		return ret;
+
+	return vchiq_mmal_port_parameter_set(ctx->dev->instance,
+					     &ctx->component->output[0],
+					     MMAL_PARAMETER_VIDEO_ENCODE_H264_LOW_LATENCY,
+					     &low_latency, sizeof(low_latency));
+}
+
 static int bcm2835_codec_s_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct bcm2835_codec_ctx *ctx =
@@ -1632,6 +1856,29 @@ static int bcm2835_codec_s_ctrl(struct v4l2_ctrl *ctrl)
 		ret = bcm2835_codec_set_level_profile(ctx, ctrl);
 		break;
 
+	case V4L2_CID_MPEG_VIDEO_MULTI_SLICE_MODE:
+	case V4L2_CID_MPEG_VIDEO_MULTI_SLICE_MAX_MB:
+		if (ctrl->id == V4L2_CID_MPEG_VIDEO_MULTI_SLICE_MODE)
+			ctx->slice_mode = ctrl->val;
+		else
+			ctx->slice_max_mb = ctrl->val;
+		if (!ctx->component)
+			break;
+
+		ret = bcm2835_codec_set_slices(ctx);
+		break;
+
+	case V4L2_CID_JPEG_COMPRESSION_QUALITY:
+		if (!ctx->component)
+			break;
+
+		ret = vchiq_mmal_port_parameter_set(ctx->dev->instance,
+						    &ctx->component->output[0],
+						    MMAL_PARAMETER_JPEG_Q_FACTOR,
+						    &ctrl->val,
+						    sizeof(ctrl->val));
+		break;
+
 	case V4L2_CID_MPEG_VIDEO_FORCE_KEY_FRAME: {
 		u32 mmal_bool = 1;
 
@@ -1740,7 +1987,7 @@ static int vidioc_try_encoder_cmd(struct file *file, void *priv,
 {
 	struct bcm2835_codec_ctx *ctx = file2ctx(file);
 
-	if (ctx->dev->role != ENCODE)
+	if (ctx->dev->role != ENCODE && ctx->dev->role != ENCODE_IMAGE)
 		return -EINVAL;
 
 	switch (cmd->cmd) {
@@ -1887,6 +2134,9 @@ static int bcm2835_codec_set_ctrls(struct bcm2835_codec_ctx *ctx)
 		V4L2_CID_MPEG_VIDEO_H264_I_PERIOD,
 		V4L2_CID_MPEG_VIDEO_H264_LEVEL,
 		V4L2_CID_MPEG_VIDEO_H264_PROFILE,
+		V4L2_CID_MPEG_VIDEO_MULTI_SLICE_MAX_MB,
+		V4L2_CID_MPEG_VIDEO_MULTI_SLICE_MODE,
+		V4L2_CID_JPEG_COMPRESSION_QUALITY,
 	};
 	int i;
 
@@ -1968,6 +2218,9 @@ static int bcm2835_codec_create_component(struct bcm2835_codec_ctx *ctx)
 					&param, sizeof(param));
 
 	} else {
+		if (dev->role == ENCODE_IMAGE)
+			bcm2835_codec_set_ctrls(ctx);
+
 		if (ctx->q_data[V4L2_M2M_DST].sizeimage <
 			ctx->component->output[0].minimum_buffer.size)
 			v4l2_err(&dev->v4l2_dev, "buffer size mismatch sizeimage %u < min size %u\n",
@@ -2041,6 +2294,82 @@ static int bcm2835_codec_mmal_buf_cleanup(struct mmal_buffer *mmal_buf)
 	return 0;
 }
 
+static void bcm2835_codec_import_free(struct bcm2835_codec_import *import)
+{
+	vc_sm_cma_free(import->vcsm_handle);
+	dma_buf_put(import->dma_buf);
+	kfree(import);
+}
+
+/*
+ * Take over the VideoCore import of a dma-buf that videobuf2 is releasing,
+ * so that it can be reused if the same dma-buf is queued again. Must be
+ * called with the queue lock held.
+ */
+static void bcm2835_codec_import_cache_put(struct bcm2835_codec_ctx *ctx,
+					   struct mmal_buffer *mmal_buf)
+{
+	struct bcm2835_codec_import *import;
+
+	if (!mmal_buf->dma_buf || !mmal_buf->vcsm_handle)
+		return;
+
+	import = kzalloc(sizeof(*import), GFP_KERNEL);
+	if (!import)
+		return;
+
+	import->dma_buf = mmal_buf->dma_buf;
+	import->vcsm_handle = mmal_buf->vcsm_handle;
+	import->vc_handle = mmal_buf->vc_handle;
+	mmal_buf->dma_buf = NULL;
+	mmal_buf->vcsm_handle = NULL;
+	mmal_buf->vc_handle = 0;
+
+	list_add(&import->list, &ctx->import_cache);
+	if (++ctx->num_imports > MAX_IMPORT_CACHE) {
+		import = list_last_entry(&ctx->import_cache,
+					 struct bcm2835_codec_import, list);
+		list_del(&import->list);
+		ctx->num_imports--;
+		bcm2835_codec_import_free(import);
+	}
+}
+
+/*
+ * Reuse a cached import for the dma-buf now attached to mmal_buf, if there
+ * is one. mmal_buf already holds its own reference on the dma-buf.
+ */
+static void bcm2835_codec_import_cache_get(struct bcm2835_codec_ctx *ctx,
+					   struct mmal_buffer *mmal_buf)
+{
+	struct bcm2835_codec_import *import;
+
+	list_for_each_entry(import, &ctx->import_cache, list) {
+		if (import->dma_buf != mmal_buf->dma_buf)
+			continue;
+
+		mmal_buf->vcsm_handle = import->vcsm_handle;
+		mmal_buf->vc_handle = import->vc_handle;
+		list_del(&import->list);
+		ctx->num_imports--;
+		dma_buf_put(import->dma_buf);
+		kfree(import);
+		atomic64_inc(&ctx->dev->num_import_hits);
+		return;
+	}
+}
+
+static void bcm2835_codec_import_cache_flush(struct bcm2835_codec_ctx *ctx)
+{
+	struct bcm2835_codec_import *import, *tmp;
+
+	list_for_each_entry_safe(import, tmp, &ctx->import_cache, list) {
+		list_del(&import->list);
+		bcm2835_codec_import_free(import);
+	}
+	ctx->num_imports = 0;
+}
+
 static int bcm2835_codec_buf_init(struct vb2_buffer *vb)
 {
 	struct bcm2835_codec_ctx *ctx = vb2_get_drv_priv(vb->vb2_queue);
@@ -2112,6 +2441,7 @@ static int bcm2835_codec_buf_prepare(struct vb2_buffer *vb)
 			}
 
 			buf->mmal.dma_buf = dma_buf;
+			bcm2835_codec_import_cache_get(ctx, &buf->mmal);
 		} else {
 			/* We already have a reference count on the dmabuf, so
 			 * release the one we acquired above.
@@ -2171,6 +2501,8 @@ static void bcm2835_codec_buffer_cleanup(struct vb2_buffer *vb)
 	v4l2_dbg(2, debug, &ctx->dev->v4l2_dev, "%s: ctx:%p, vb %p\n",
 		 __func__, ctx, vb);
 
+	if (vb->memory == VB2_MEMORY_DMABUF)
+		bcm2835_codec_import_cache_put(ctx, &buf->mmal);
 	bcm2835_codec_mmal_buf_cleanup(&buf->mmal);
 }
 
@@ -2185,6 +2517,8 @@ static int bcm2835_codec_start_streaming(struct vb2_queue *q,
 	v4l2_dbg(1, debug, &ctx->dev->v4l2_dev, "%s: type: %d count %d\n",
 		 __func__, q->type, count);
 	q_data->sequence = 0;
+	if (!V4L2_TYPE_IS_OUTPUT(q->type))
+		bcm2835_codec_stats_reset(ctx);
 
 	if (!ctx->component_enabled) {
 		ret = vchiq_mmal_component_enable(dev->instance,
@@ -2207,6 +2541,7 @@ static int bcm2835_codec_start_streaming(struct vb2_queue *q,
 		q_data->eos_buffer_in_use = false;
 
 		ctx->component->input[0].cb_ctx = ctx;
+		ctx->component->input[0].direct_cb = 1;
 		ret = vchiq_mmal_port_enable(dev->instance,
 					     &ctx->component->input[0],
 					     ip_buffer_cb);
@@ -2215,6 +2550,7 @@ static int bcm2835_codec_start_streaming(struct vb2_queue *q,
 				 __func__, ret);
 	} else {
 		ctx->component->output[0].cb_ctx = ctx;
+		ctx->component->output[0].direct_cb = 1;
 		ret = vchiq_mmal_port_enable(dev->instance,
 					     &ctx->component->output[0],
 					     op_buffer_cb);
@@ -2349,6 +2685,61 @@ static int queue_init(void *priv, struct vb2_queue *src_vq,
 	return vb2_queue_init(dst_vq);
 }
 
+static int bcm2835_codec_ctx_stats_show(struct seq_file *s, void *data)
+{
+	struct bcm2835_codec_ctx *ctx = s->private;
+	struct bcm2835_codec_ctx_stats *stats = &ctx->stats;
+	u64 frames, bytes, lat_total, lat_max, lat_count, elapsed_us;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	elapsed_us = ktime_us_delta(ktime_get(), stats->start);
+	frames = stats->frames;
+	bytes = stats->bytes;
+	lat_total = stats->latency_total_ns;
+	lat_max = stats->latency_max_ns;
+	lat_count = stats->latency_count;
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	seq_printf(s, "weight:             %u\n", ctx->weight);
+	seq_printf(s, "frames:             %llu\n", frames);
+	seq_printf(s, "bytes:              %llu\n", bytes);
+	if (elapsed_us) {
+		/* Reported in hundredths to avoid floating point */
+		seq_printf(s, "fps_x100:           %llu\n",
+			   div64_u64(frames * 100 * USEC_PER_SEC, elapsed_us));
+		seq_printf(s, "bitrate_kbps:       %llu\n",
+			   div64_u64(bytes * 8 * 1000, elapsed_us));
+	}
+	seq_printf(s, "latency_avg_us:     %llu\n",
+		   lat_count ? div64_u64(lat_total, lat_count * NSEC_PER_USEC) :
+			       0);
+	seq_printf(s, "latency_max_us:     %llu\n",
+		   div64_u64(lat_max, NSEC_PER_USEC));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bcm2835_codec_ctx_stats);
+
+static void bcm2835_codec_ctx_debugfs_init(struct bcm2835_codec_ctx *ctx)
+{
+	struct bcm2835_codec_dev *dev = ctx->dev;
+	char name[16];
+
+	if (!dev->debugfs_dir)
+		return;
+
+	snprintf(name, sizeof(name), "ctx%d",
+		 atomic_inc_return(&dev->next_ctx_id));
+	ctx->debugfs_dir = debugfs_create_dir(name, dev->debugfs_dir);
+	if (!ctx->debugfs_dir)
+		return;
+
+	debugfs_create_u32("weight", 0644, ctx->debugfs_dir, &ctx->weight);
+	debugfs_create_file("stats", 0444, ctx->debugfs_dir, ctx,
+			    &bcm2835_codec_ctx_stats_fops);
+}
+
 /*
  * File operations
  */
@@ -2402,6 +2793,11 @@ static int bcm2835_codec_open(struct file *file)
 	ctx->framerate_num = 30;
 	ctx->framerate_denom = 1;
 
+	INIT_LIST_HEAD(&ctx->import_cache);
+
+	ctx->weight = 1;
+	spin_lock_init(&ctx->stats.lock);
+
 	/* Initialise V4L2 contexts */
 	v4l2_fh_init(&ctx->fh, video_devdata(file));
 	file->private_data = &ctx->fh;
@@ -2409,7 +2805,7 @@ static int bcm2835_codec_open(struct file *file)
 	hdl = &ctx->hdl;
 	if (dev->role == ENCODE) {
 		/* Encode controls */
-		v4l2_ctrl_handler_init(hdl, 7);
+		v4l2_ctrl_handler_init(hdl, 9);
 
 		v4l2_ctrl_new_std_menu(hdl, &bcm2835_codec_ctrl_ops,
 				       V4L2_CID_MPEG_VIDEO_BITRATE_MODE,
@@ -2456,6 +2852,30 @@ static int bcm2835_codec_open(struct file *file)
 		v4l2_ctrl_new_std(hdl, &bcm2835_codec_ctrl_ops,
 				  V4L2_CID_MPEG_VIDEO_FORCE_KEY_FRAME,
 				  0, 0, 0, 0);
+		v4l2_ctrl_new_std_menu(hdl, &bcm2835_codec_ctrl_ops,
+				       V4L2_CID_MPEG_VIDEO_MULTI_SLICE_MODE,
+				       V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_MAX_MB,
+				       ~(BIT(V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_SINGLE) |
+					 BIT(V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_MAX_MB)),
+				       V4L2_MPEG_VIDEO_MULTI_SLICE_MODE_SINGLE);
+		v4l2_ctrl_new_std(hdl, &bcm2835_codec_ctrl_ops,
+				  V4L2_CID_MPEG_VIDEO_MULTI_SLICE_MAX_MB,
+				  1, (MAX_W / 16) * (MAX_H / 16),
+				  1, MAX_W / 16);
+		if (hdl->error) {
+			rc = hdl->error;
+			goto free_ctrl_handler;
+		}
+		ctx->fh.ctrl_handler = hdl;
+		v4l2_ctrl_handler_setup(hdl);
+	} else if (dev->role == ENCODE_IMAGE) {
+		/* Image encode controls */
+		v4l2_ctrl_handler_init(hdl, 1);
+
+		v4l2_ctrl_new_std(hdl, &bcm2835_codec_ctrl_ops,
+				  V4L2_CID_JPEG_COMPRESSION_QUALITY,
+				  1, 100,
+				  1, 80);
 		if (hdl->error) {
 			rc = hdl->error;
 			goto free_ctrl_handler;
@@ -2494,6 +2914,8 @@ static int bcm2835_codec_open(struct file *file)
 	v4l2_fh_add(&ctx->fh);
 	atomic_inc(&dev->num_inst);
 
+	bcm2835_codec_ctx_debugfs_init(ctx);
+
 	mutex_unlock(&dev->dev_mutex);
 	return 0;
 
@@ -2513,11 +2935,14 @@ static int bcm2835_codec_release(struct file *file)
 	v4l2_dbg(1, debug, &dev->v4l2_dev, "%s: Releasing instance %p\n",
 		 __func__, ctx);
 
+	debugfs_remove_recursive(ctx->debugfs_dir);
+
 	v4l2_fh_del(&ctx->fh);
 	v4l2_fh_exit(&ctx->fh);
 	v4l2_ctrl_handler_free(&ctx->hdl);
 	mutex_lock(&dev->dev_mutex);
 	v4l2_m2m_ctx_release(ctx->fh.m2m_ctx);
+	bcm2835_codec_import_cache_flush(ctx);
 
 	if (ctx->component)
 		vchiq_mmal_component_finalise(dev->instance, ctx->component);
@@ -2669,6 +3094,44 @@ static int bcm2835_codec_get_supported_fmts(struct bcm2835_codec_dev *dev)
 	return ret;
 }
 
+static int bcm2835_codec_stats_show(struct seq_file *s, void *data)
+{
+	struct bcm2835_codec_dev *dev = s->private;
+	u64 runs = atomic64_read(&dev->num_device_runs);
+	u64 ip = atomic64_read(&dev->num_ip_submits);
+	u64 op = atomic64_read(&dev->num_op_submits);
+	u64 frames = atomic64_read(&dev->num_op_frames);
+	u64 msgs = ip + op;
+
+	seq_printf(s, "device_runs:        %llu\n", runs);
+	seq_printf(s, "ip_buffers_sent:    %llu\n", ip);
+	seq_printf(s, "op_buffers_sent:    %llu\n", op);
+	seq_printf(s, "op_frames_returned: %llu\n", frames);
+	seq_printf(s, "import_cache_hits:  %llu\n",
+		   (u64)atomic64_read(&dev->num_import_hits));
+	/* Reported in hundredths to avoid floating point */
+	seq_printf(s, "msgs_per_frame_x100: %llu\n",
+		   frames ? div64_u64(msgs * 100, frames) : 0);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bcm2835_codec_stats);
+
+static void bcm2835_codec_debugfs_init(struct bcm2835_codec_driver *drv,
+				       struct bcm2835_codec_dev *dev)
+{
+	if (!drv->debugfs_root)
+		return;
+
+	dev->debugfs_dir = debugfs_create_dir(roles[dev->role],
+					      drv->debugfs_root);
+	if (!dev->debugfs_dir)
+		return;
+
+	debugfs_create_file("stats", 0444, dev->debugfs_dir, dev,
+			    &bcm2835_codec_stats_fops);
+}
+
 static int bcm2835_codec_create(struct bcm2835_codec_driver *drv,
 				struct bcm2835_codec_dev **new_dev,
 				enum bcm2835_codec_role role)
@@ -2737,6 +3200,12 @@ static int bcm2835_codec_create(struct bcm2835_codec_driver *drv,
 		function = MEDIA_ENT_F_PROC_VIDEO_SCALER;
 		video_nr = isp_video_nr;
 		break;
+	case ENCODE_IMAGE:
+		v4l2_disable_ioctl(vfd, VIDIOC_DECODER_CMD);
+		v4l2_disable_ioctl(vfd, VIDIOC_TRY_DECODER_CMD);
+		function = MEDIA_ENT_F_PROC_VIDEO_ENCODER;
+		video_nr = encode_image_nr;
+		break;
 	default:
 		ret = -EINVAL;
 		goto unreg_dev;
@@ -2767,6 +3236,8 @@ static int bcm2835_codec_create(struct bcm2835_codec_driver *drv,
 	if (ret)
 		goto err_m2m;
 
+	bcm2835_codec_debugfs_init(drv, dev);
+
 	v4l2_info(&dev->v4l2_dev, "Loaded V4L2 %s\n",
 		  roles[role]);
 	return 0;
@@ -2788,6 +3259,7 @@ static int bcm2835_codec_destroy(struct bcm2835_codec_dev *dev)
 
 	v4l2_info(&dev->v4l2_dev, "Removing " MEM2MEM_NAME ", %s\n",
 		  roles[dev->role]);
+	debugfs_remove_recursive(dev->debugfs_dir);
 	v4l2_m2m_unregister_media_controller(dev->m2m_dev);
 	v4l2_m2m_release(dev->m2m_dev);
 	video_unregister_device(&dev->vfd);
@@ -2820,6 +3292,10 @@ static int bcm2835_codec_probe(struct platform_device *pdev)
 	mdev->hw_revision = 1;
 	media_device_init(mdev);
 
+	drv->debugfs_root = debugfs_create_dir(MEM2MEM_NAME, NULL);
+	if (IS_ERR(drv->debugfs_root))
+		drv->debugfs_root = NULL;
+
 	ret = bcm2835_codec_create(drv, &drv->decode, DECODE);
 	if (ret)
 		goto out;
@@ -2832,6 +3308,10 @@ static int bcm2835_codec_probe(struct platform_device *pdev)
 	if (ret)
 		goto out;
 
+	ret = bcm2835_codec_create(drv, &drv->encode_image, ENCODE_IMAGE);
+	if (ret)
+		goto out;
+
 	/* Register the media device node */
 	if (media_device_register(mdev) < 0)
 		goto out;
@@ -2841,6 +3321,14 @@ static int bcm2835_codec_probe(struct platform_device *pdev)
 	return 0;
 
 out:
+	if (drv->encode_image) {
+		bcm2835_codec_destroy(drv->encode_image);
+		drv->encode_image = NULL;
+	}
+	if (drv->isp) {
+		bcm2835_codec_destroy(drv->isp);
+		drv->isp = NULL;
+	}
 	if (drv->encode) {
 		bcm2835_codec_destroy(drv->encode);
 		drv->encode = NULL;
@@ -2849,6 +3337,7 @@ static int bcm2835_codec_probe(struct platform_device *pdev)
 		bcm2835_codec_destroy(drv->decode);
 		drv->decode = NULL;
 	}
+	debugfs_remove_recursive(drv->debugfs_root);
 	return ret;
 }
 
@@ -2858,12 +3347,16 @@ static int bcm2835_codec_remove(struct platform_device *pdev)
 
 	media_device_unregister(&drv->mdev);
 
+	bcm2835_codec_destroy(drv->encode_image);
+
 	bcm2835_codec_destroy(drv->isp);
 
 	bcm2835_codec_destroy(drv->encode);
 
 	bcm2835_codec_destroy(drv->decode);
 
+	debugfs_remove_recursive(drv->debugfs_root);
+
 	media_device_cleanup(&drv->mdev);
 
 	return 0;
@@ -35,7 +35,9 @@
 #include <linux/errno.h>
 #include <linux/fs.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 #include <linux/miscdevice.h>
 #include <linux/module.h>
 #include <linux/mm.h>
@@ -65,6 +67,21 @@
 #define VC_SM_DIR_ROOT_NAME	"vcsm-cma"
 #define VC_SM_STATE		"state"
 
+/* Size classes per power of two when rounding pooled allocations. */
+#define VC_SM_POOL_CLASS_SHIFT	3
+
+static unsigned int pool_max_mb = 32;
+module_param(pool_max_mb, uint, 0644);
+MODULE_PARM_DESC(pool_max_mb, "Maximum size of the free buffer pool in MB");
+
+static unsigned int cache_flush_all_kb = 8192;
+module_param(cache_flush_all_kb, uint, 0644);
+MODULE_PARM_DESC(cache_flush_all_kb,
+		 "Flush the whole CPU cache rather than by range for clean/flush requests above this size in KB (0 to disable)");
+
+/* Upper bound on the number of operations in one cache maintenance call. */
+#define VC_SM_MAX_CACHE_OPS	1024
+
 /* Private file data associated with each opened device. */
 struct vc_sm_privdata_t {
 	pid_t pid;                      /* PID of creator. */
@@ -104,6 +121,28 @@ struct sm_state_t {
 					 * has finished with a resource.
 					 */
 	u32 int_trans_id;		/* Interrupted transaction. */
+
+	struct mutex pool_lock;		/* Protects the buffer pool */
+	struct list_head pool;		/* Free allocations, newest first */
+	size_t pool_size;		/* Bytes held in the pool */
+	u64 pool_hits;
+	u64 pool_misses;
+	u64 pool_reclaimed;		/* Bytes handed back to CMA */
+	struct shrinker pool_shrinker;
+
+	/* Cache maintenance statistics */
+	atomic64_t cache_calls;
+	atomic64_t cache_bytes;
+	atomic64_t cache_time_ns;
+	atomic64_t cache_flush_alls;
+};
+
+/* A freed CMA allocation held for reuse. */
+struct vc_sm_pool_entry {
+	struct list_head list;
+	void *cookie;
+	dma_addr_t dma_handle;
+	size_t size;
 };
 
 struct vc_sm_dma_buf_attachment {
@@ -145,6 +184,166 @@ static void free_kernel_id(int handle)
 	spin_unlock(&sm_state->kernelid_map_lock);
 }
 
+/*
+ * Buffer pool.
+ *
+ * Codec and ISP instances allocate and free their buffers on every stream
+ * start and stop, which fragments CMA over time. Freed allocations are
+ * rounded into size classes and kept on a LRU free list for reuse, up to
+ * pool_max_mb. A shrinker returns them to CMA under memory pressure, and
+ * the pool is drained if a fresh allocation fails.
+ */
+static size_t vc_sm_pool_class_size(size_t size)
+{
+	size_t step;
+
+	size = PAGE_ALIGN(size);
+	step = max_t(size_t, rounddown_pow_of_two(size) >>
+			     VC_SM_POOL_CLASS_SHIFT, PAGE_SIZE);
+
+	return ALIGN(size, step);
+}
+
+static void vc_sm_pool_release(struct list_head *list)
+{
+	struct vc_sm_pool_entry *entry, *tmp;
+
+	list_for_each_entry_safe(entry, tmp, list, list) {
+		list_del(&entry->list);
+		dma_free_coherent(&sm_state->pdev->dev, entry->size,
+				  entry->cookie, entry->dma_handle);
+		kfree(entry);
+	}
+}
+
+/* Move entries from the cold end of the pool onto list. */
+static size_t vc_sm_pool_evict(struct list_head *list, size_t target)
+{
+	struct vc_sm_pool_entry *entry;
+	size_t freed = 0;
+
+	while (freed < target && !list_empty(&sm_state->pool)) {
+		entry = list_last_entry(&sm_state->pool,
+					struct vc_sm_pool_entry, list);
+		list_move(&entry->list, list);
+		sm_state->pool_size -= entry->size;
+		freed += entry->size;
+	}
+	sm_state->pool_reclaimed += freed;
+
+	return freed;
+}
+
+static void vc_sm_pool_drain(void)
+{
+	LIST_HEAD(list);
+
+	mutex_lock(&sm_state->pool_lock);
+	vc_sm_pool_evict(&list, SIZE_MAX);
+	mutex_unlock(&sm_state->pool_lock);
+
+	vc_sm_pool_release(&list);
+}
+
+static void *vc_sm_pool_alloc(size_t size, dma_addr_t *dma_handle,
+			      size_t *alloc_size, bool zero)
+{
+	struct vc_sm_pool_entry *entry, *found = NULL;
+	void *cookie;
+
+	size = vc_sm_pool_class_size(size);
+
+	mutex_lock(&sm_state->pool_lock);
+	list_for_each_entry(entry, &sm_state->pool, list) {
+		if (entry->size == size) {
+			list_del(&entry->list);
+			sm_state->pool_size -= size;
+			found = entry;
+			break;
+		}
+	}
+	if (found)
+		sm_state->pool_hits++;
+	else
+		sm_state->pool_misses++;
+	mutex_unlock(&sm_state->pool_lock);
+
+	if (found) {
+		cookie = found->cookie;
+		*dma_handle = found->dma_handle;
+		kfree(found);
+
+		/* Fresh CMA allocations are zeroed, so match that */
+		if (zero)
+			memset(cookie, 0, size);
+		*alloc_size = size;
+		return cookie;
+	}
+
+	cookie = dma_alloc_coherent(&sm_state->pdev->dev, size, dma_handle,
+				    GFP_KERNEL);
+	if (!cookie && READ_ONCE(sm_state->pool_size)) {
+		vc_sm_pool_drain();
+		cookie = dma_alloc_coherent(&sm_state->pdev->dev, size,
+					    dma_handle, GFP_KERNEL);
+	}
+	if (cookie)
+		*alloc_size = size;
+
+	return cookie;
+}
+
+static void vc_sm_pool_free(void *cookie, dma_addr_t dma_handle, size_t size)
+{
+	size_t max_size = (size_t)READ_ONCE(pool_max_mb) << 20;
+	struct vc_sm_pool_entry *entry = NULL;
+	LIST_HEAD(list);
+
+	if (size <= max_size)
+		entry = kmalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry) {
+		dma_free_coherent(&sm_state->pdev->dev, size, cookie,
+				  dma_handle);
+		return;
+	}
+
+	entry->cookie = cookie;
+	entry->dma_handle = dma_handle;
+	entry->size = size;
+
+	mutex_lock(&sm_state->pool_lock);
+	if (sm_state->pool_size + size > max_size)
+		vc_sm_pool_evict(&list,
+				 sm_state->pool_size + size - max_size);
+	list_add(&entry->list, &sm_state->pool);
+	sm_state->pool_size += size;
+	mutex_unlock(&sm_state->pool_lock);
+
+	vc_sm_pool_release(&list);
+}
+
+static unsigned long vc_sm_pool_count(struct shrinker *shrinker,
+				      struct shrink_control *sc)
+{
+	return READ_ONCE(sm_state->pool_size) >> PAGE_SHIFT;
+}
+
+static unsigned long vc_sm_pool_scan(struct shrinker *shrinker,
+				     struct shrink_control *sc)
+{
+	LIST_HEAD(list);
+	size_t freed;
+
+	if (!mutex_trylock(&sm_state->pool_lock))
+		return SHRINK_STOP;
+	freed = vc_sm_pool_evict(&list, sc->nr_to_scan << PAGE_SHIFT);
+	mutex_unlock(&sm_state->pool_lock);
+
+	vc_sm_pool_release(&list);
+
+	return freed >> PAGE_SHIFT;
+}
+
 static int vc_sm_cma_seq_file_show(struct seq_file *s, void *v)
 {
 	struct sm_pde_t *sm_pde;
@@ -179,6 +378,26 @@ static int vc_sm_cma_global_state_show(struct seq_file *s, void *v)
 
 	seq_printf(s, "\nVC-ServiceHandle     %p\n", sm_state->sm_handle);
 
+	mutex_lock(&sm_state->pool_lock);
+	seq_puts(s, "\nBuffer pool\n");
+	seq_printf(s, "           SIZE         %zu\n", sm_state->pool_size);
+	seq_printf(s, "           MAX          %u MB\n", pool_max_mb);
+	seq_printf(s, "           HITS         %llu\n", sm_state->pool_hits);
+	seq_printf(s, "           MISSES       %llu\n", sm_state->pool_misses);
+	seq_printf(s, "           RECLAIMED    %llu\n",
+		   sm_state->pool_reclaimed);
+	mutex_unlock(&sm_state->pool_lock);
+
+	seq_puts(s, "\nCache maintenance\n");
+	seq_printf(s, "           CALLS        %lld\n",
+		   atomic64_read(&sm_state->cache_calls));
+	seq_printf(s, "           BYTES        %lld\n",
+		   atomic64_read(&sm_state->cache_bytes));
+	seq_printf(s, "           TIME_NS      %lld\n",
+		   atomic64_read(&sm_state->cache_time_ns));
+	seq_printf(s, "           FLUSH_ALL    %lld\n",
+		   atomic64_read(&sm_state->cache_flush_alls));
+
 	/* Log all applicable mapping(s). */
 
 	mutex_lock(&sm_state->map_lock);
@@ -320,9 +539,9 @@ static void vc_sm_release_resource(struct vc_sm_buffer *buffer)
 			pr_err("%s: Imported dmabuf already been put for buf %p\n",
 			       __func__, buffer);
 		buffer->import.dma_buf = NULL;
-	} else {
-		dma_free_coherent(&sm_state->pdev->dev, buffer->size,
-				  buffer->cookie, buffer->dma_addr);
+	} else if (buffer->cookie) {
+		vc_sm_pool_free(buffer->cookie, buffer->alloc.dma_handle,
+				buffer->alloc.alloc_size);
 	}
 
 	/* Free our buffer. Start by removing it from the list */
@@ -482,8 +701,12 @@ static void vc_sm_unmap_dma_buf(struct dma_buf_attachment *attachment,
 				struct sg_table *table,
 				enum dma_data_direction direction)
 {
+	/*
+	 * Nothing to do: the mapping stays cached in the attachment and is
+	 * released at detach.  Unmapping here left a stale table behind for
+	 * the next map to hand out, and detach unmapped it a second time.
+	 */
 	pr_debug("%s attachment %p\n", __func__, attachment);
-	dma_unmap_sg(attachment->dev, table->sgl, table->nents, direction);
 }
 
 static int vc_sm_dmabuf_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
@@ -610,6 +833,7 @@ static void vc_sm_dma_buf_kunmap(struct dma_buf *dmabuf, unsigned long offset,
 }
 
 static const struct dma_buf_ops dma_buf_ops = {
+	.cache_sgt_mapping = true,
 	.map_dma_buf = vc_sm_map_dma_buf,
 	.unmap_dma_buf = vc_sm_unmap_dma_buf,
 	.mmap = vc_sm_dmabuf_mmap,
@@ -937,9 +1161,9 @@ static int vc_sm_cma_vpu_alloc(u32 size, u32 align, const char *name,
 	 */
 	mutex_lock(&buffer->lock);
 
-	buffer->cookie = dma_alloc_coherent(&sm_state->pdev->dev,
-					    aligned_size, &buffer->dma_addr,
-					    GFP_KERNEL);
+	buffer->cookie = vc_sm_pool_alloc(aligned_size,
+					  &buffer->alloc.dma_handle,
+					  &buffer->alloc.alloc_size, false);
 	if (!buffer->cookie) {
 		pr_err("[%s]: dma_alloc_coherent alloc of %d bytes failed\n",
 		       __func__, aligned_size);
@@ -957,7 +1181,7 @@ static int vc_sm_cma_vpu_alloc(u32 size, u32 align, const char *name,
 	}
 
 	ret = dma_get_sgtable(&sm_state->pdev->dev, sgt, buffer->cookie,
-			      buffer->dma_addr, buffer->size);
+			      buffer->alloc.dma_handle, aligned_size);
 	if (ret < 0) {
 		pr_err("failed to get scatterlist from DMA API\n");
 		kfree(sgt);
@@ -1173,10 +1397,9 @@ int vc_sm_cma_ioctl_alloc(struct vc_sm_privdata_t *private,
 		goto error;
 	}
 
-	buffer->cookie = dma_alloc_coherent(&sm_state->pdev->dev,
-					    aligned_size,
-					    &buffer->dma_addr,
-					    GFP_KERNEL);
+	buffer->cookie = vc_sm_pool_alloc(aligned_size,
+					  &buffer->alloc.dma_handle,
+					  &buffer->alloc.alloc_size, true);
 	if (!buffer->cookie) {
 		pr_err("[%s]: dma_alloc_coherent alloc of %d bytes failed\n",
 		       __func__, aligned_size);
@@ -1210,6 +1433,7 @@ int vc_sm_cma_ioctl_alloc(struct vc_sm_privdata_t *private,
 	}
 	buffer->dma_buf = dmabuf;
 
+	buffer->dma_addr = buffer->alloc.dma_handle;
 	import.addr = buffer->dma_addr;
 	import.size = aligned_size;
 	import.kernel_id = get_kernel_id(buffer);
@@ -1281,8 +1505,9 @@ int vc_sm_cma_ioctl_alloc(struct vc_sm_privdata_t *private,
 	} else {
 		/* No dmabuf, therefore just free the buffer here */
 		if (buffer->cookie)
-			dma_free_coherent(&sm_state->pdev->dev, buffer->size,
-					  buffer->cookie, buffer->dma_addr);
+			vc_sm_pool_free(buffer->cookie,
+					buffer->alloc.dma_handle,
+					buffer->alloc.alloc_size);
 		kfree(buffer);
 	}
 	return ret;
@@ -1333,16 +1558,30 @@ static int clean_invalid_contig_2d(const void __user *addr,
 	if (!op_fn)
 		return -EINVAL;
 
+	/* Rows with no gap between them can be done as one range */
+	if (stride == block_size) {
+		op_fn(addr, addr + block_count * block_size);
+		return 0;
+	}
+
 	for (i = 0; i < block_count; i ++, addr += stride)
 		op_fn(addr, addr + block_size);
 
 	return 0;
 }
 
+static void vc_sm_flush_cache_all(void *unused)
+{
+	flush_cache_all();
+}
+
 static int vc_sm_cma_clean_invalid2(unsigned int cmdnr, unsigned long arg)
 {
 	struct vc_sm_cma_ioctl_clean_invalid2 ioparam;
 	struct vc_sm_cma_ioctl_clean_invalid_block *block = NULL;
+	unsigned int threshold = READ_ONCE(cache_flush_all_kb);
+	bool invalidate = false;
+	u64 start, bytes = 0;
 	int i, ret = 0;
 
 	/* Get parameter data. */
@@ -1351,7 +1590,9 @@ static int vc_sm_cma_clean_invalid2(unsigned int cmdnr, unsigned long arg)
 		       __func__, cmdnr);
 		return -EFAULT;
 	}
-	block = kmalloc(ioparam.op_count * sizeof(*block), GFP_KERNEL);
+	if (ioparam.op_count > VC_SM_MAX_CACHE_OPS)
+		return -EINVAL;
+	block = kmalloc_array(ioparam.op_count, sizeof(*block), GFP_KERNEL);
 	if (!block)
 		return -EFAULT;
 
@@ -1363,6 +1604,28 @@ static int vc_sm_cma_clean_invalid2(unsigned int cmdnr, unsigned long arg)
 		goto out;
 	}
 
+	start = ktime_get_ns();
+
+	for (i = 0; i < ioparam.op_count; i++) {
+		if (block[i].invalidate_mode == VC_SM_CACHE_OP_NOP)
+			continue;
+		if (block[i].invalidate_mode == VC_SM_CACHE_OP_INV)
+			invalidate = true;
+		bytes += (u64)block[i].block_count * block[i].block_size;
+	}
+
+	/*
+	 * Above the threshold, cleaning by set/way on every CPU is cheaper
+	 * than walking the ranges. That leaves lines outside the requested
+	 * ranges valid, but writes them back too, so it is not usable for
+	 * invalidates.
+	 */
+	if (threshold && !invalidate && bytes >= (u64)threshold << 10) {
+		on_each_cpu(vc_sm_flush_cache_all, NULL, 1);
+		atomic64_inc(&sm_state->cache_flush_alls);
+		goto stats;
+	}
+
 	for (i = 0; i < ioparam.op_count; i++) {
 		const struct vc_sm_cma_ioctl_clean_invalid_block * const op =
 								block + i;
@@ -1377,6 +1640,11 @@ static int vc_sm_cma_clean_invalid2(unsigned int cmdnr, unsigned long arg)
 		if (ret)
 			break;
 	}
+
+stats:
+	atomic64_inc(&sm_state->cache_calls);
+	atomic64_add(bytes, &sm_state->cache_bytes);
+	atomic64_add(ktime_get_ns() - start, &sm_state->cache_time_ns);
 out:
 	kfree(block);
 
@@ -1384,6 +1652,104 @@ static int vc_sm_cma_clean_invalid2(unsigned int cmdnr, unsigned long arg)
 }
 #endif
 
+/*
+ * A complete begin/end cpu access cycle, as DMA_BUF_IOCTL_SYNC would do, so
+ * that exporters tracking CPU access always see the two calls paired.
+ */
+static int vc_sm_cma_sync_dmabuf(struct dma_buf *dma_buf,
+				 enum dma_data_direction direction)
+{
+	int ret;
+
+	ret = dma_buf_begin_cpu_access(dma_buf, direction);
+	if (ret)
+		return ret;
+
+	return dma_buf_end_cpu_access(dma_buf, direction);
+}
+
+/*
+ * Sync whole dma-bufs for the CPU or device in one call, via each
+ * exporter's cpu access hooks.
+ */
+static int vc_sm_cma_sync_dmabufs(unsigned int cmdnr, unsigned long arg)
+{
+	struct vc_sm_cma_ioctl_sync_dmabufs ioparam;
+	struct vc_sm_cma_ioctl_sync_dmabuf *op = NULL;
+	u64 start, bytes = 0;
+	unsigned int i;
+	int ret = 0;
+
+	if (copy_from_user(&ioparam, (void *)arg, sizeof(ioparam))) {
+		pr_err("[%s]: failed to copy-from-user header for cmd %x\n",
+		       __func__, cmdnr);
+		return -EFAULT;
+	}
+	if (ioparam.op_count > VC_SM_MAX_CACHE_OPS)
+		return -EINVAL;
+
+	op = kmalloc_array(ioparam.op_count, sizeof(*op), GFP_KERNEL);
+	if (!op)
+		return -ENOMEM;
+
+	if (copy_from_user(op, (void *)(arg + sizeof(ioparam)),
+			   ioparam.op_count * sizeof(*op)) != 0) {
+		pr_err("[%s]: failed to copy-from-user payload for cmd %x\n",
+		       __func__, cmdnr);
+		ret = -EFAULT;
+		goto out;
+	}
+
+	start = ktime_get_ns();
+
+	for (i = 0; i < ioparam.op_count && !ret; i++) {
+		struct dma_buf *dma_buf;
+
+		if (op[i].cache_op == VC_SM_CACHE_OP_NOP)
+			continue;
+
+		dma_buf = dma_buf_get(op[i].dmabuf_fd);
+		if (IS_ERR(dma_buf)) {
+			ret = PTR_ERR(dma_buf);
+			break;
+		}
+
+		switch (op[i].cache_op) {
+		case VC_SM_CACHE_OP_INV:
+			ret = vc_sm_cma_sync_dmabuf(dma_buf, DMA_FROM_DEVICE);
+			break;
+		case VC_SM_CACHE_OP_CLEAN:
+			ret = vc_sm_cma_sync_dmabuf(dma_buf, DMA_TO_DEVICE);
+			break;
+		case VC_SM_CACHE_OP_FLUSH:
+			/*
+			 * Not a single DMA_BIDIRECTIONAL cycle: beginning
+			 * that invalidates, and would drop dirty lines
+			 * before they are written back.
+			 */
+			ret = vc_sm_cma_sync_dmabuf(dma_buf, DMA_TO_DEVICE);
+			if (!ret)
+				ret = vc_sm_cma_sync_dmabuf(dma_buf,
+							    DMA_FROM_DEVICE);
+			break;
+		default:
+			ret = -EINVAL;
+			break;
+		}
+		bytes += dma_buf->size;
+
+		dma_buf_put(dma_buf);
+	}
+
+	atomic64_inc(&sm_state->cache_calls);
+	atomic64_add(bytes, &sm_state->cache_bytes);
+	atomic64_add(ktime_get_ns() - start, &sm_state->cache_time_ns);
+out:
+	kfree(op);
+
+	return ret;
+}
+
 static long vc_sm_cma_ioctl(struct file *file, unsigned int cmd,
 			    unsigned long arg)
 {
@@ -1490,6 +1856,11 @@ static long vc_sm_cma_ioctl(struct file *file, unsigned int cmd,
 		break;
 #endif
 
+	/* Cache maintenance on a set of whole dma-bufs. */
+	case VC_SM_CMA_CMD_SYNC_DMABUFS:
+		ret = vc_sm_cma_sync_dmabufs(cmdnr, arg);
+		break;
+
 	default:
 		pr_debug("[%s]: cmd %x tgid %u, owner %u\n", __func__, cmdnr,
 			 current->tgid, file_data->pid);
@@ -1646,6 +2017,14 @@ static int bcm2835_vc_sm_cma_probe(struct platform_device *pdev)
 	sm_state->pdev = pdev;
 	mutex_init(&sm_state->map_lock);
 
+	mutex_init(&sm_state->pool_lock);
+	INIT_LIST_HEAD(&sm_state->pool);
+	sm_state->pool_shrinker.count_objects = vc_sm_pool_count;
+	sm_state->pool_shrinker.scan_objects = vc_sm_pool_scan;
+	sm_state->pool_shrinker.seeks = DEFAULT_SEEKS;
+	if (register_shrinker(&sm_state->pool_shrinker))
+		pr_warn("%s: Failed to register pool shrinker\n", __func__);
+
 	spin_lock_init(&sm_state->kernelid_map_lock);
 	idr_init_base(&sm_state->kernelid_map, 1);
 
@@ -1674,6 +2053,10 @@ static int bcm2835_vc_sm_cma_remove(struct platform_device *pdev)
 	}
 
 	if (sm_state) {
+		unregister_shrinker(&sm_state->pool_shrinker);
+		vc_sm_pool_drain();
+		mutex_destroy(&sm_state->pool_lock);
+
 		idr_destroy(&sm_state->kernelid_map);
 
 		/* Free the memory for the state structure. */
@@ -1721,6 +2104,44 @@ int vc_sm_cma_free(void *handle)
 }
 EXPORT_SYMBOL_GPL(vc_sm_cma_free);
 
+/*
+ * Look for an existing kernel import of a dma_buf, and take a reference on
+ * it if found. This allows multiple users of the same dma_buf (eg the ISP
+ * output and encoder input ports) to share a single VPU mapping.
+ */
+static struct dma_buf *vc_sm_cma_find_kernel_import(struct dma_buf *dma_buf)
+{
+	struct vc_sm_buffer *buffer;
+	struct dma_buf *found = NULL;
+
+	mutex_lock(&sm_state->map_lock);
+	list_for_each_entry(buffer, &sm_state->buffer_list,
+			    global_buffer_list) {
+		if (!buffer->imported ||
+		    buffer->private != sm_state->data_knl ||
+		    buffer->import.dma_buf != dma_buf)
+			continue;
+
+		/*
+		 * buffer->lock is taken before map_lock on release, so only
+		 * try for it. Whilst held and in_use is set our dma_buf can't
+		 * be freed, but may already be on its way to being released.
+		 */
+		if (!mutex_trylock(&buffer->lock))
+			continue;
+		if (buffer->in_use && buffer->vpu_state == VPU_MAPPED &&
+		    get_file_rcu(buffer->dma_buf->file))
+			found = buffer->dma_buf;
+		mutex_unlock(&buffer->lock);
+
+		if (found)
+			break;
+	}
+	mutex_unlock(&sm_state->map_lock);
+
+	return found;
+}
+
 /* Import a dmabuf to be shared with VC. */
 int vc_sm_cma_import_dmabuf(struct dma_buf *src_dmabuf, void **handle)
 {
@@ -1734,6 +2155,13 @@ int vc_sm_cma_import_dmabuf(struct dma_buf *src_dmabuf, void **handle)
 		return -EPERM;
 	}
 
+	new_dma_buf = vc_sm_cma_find_kernel_import(src_dmabuf);
+	if (new_dma_buf) {
+		pr_debug("%s: reusing import %p\n", __func__, new_dma_buf);
+		*handle = new_dma_buf;
+		return 0;
+	}
+
 	ret = vc_sm_cma_import_dmabuf_internal(sm_state->data_knl, src_dmabuf,
 					       -1, &new_dma_buf);
 
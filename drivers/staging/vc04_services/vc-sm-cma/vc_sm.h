@@ -33,6 +33,9 @@ struct vc_sm_alloc_data {
 	unsigned long num_pages;
 	void *priv_virt;
 	struct sg_table *sg_table;
+	/* Backing allocation as handed out by the buffer pool */
+	dma_addr_t dma_handle;
+	size_t alloc_size;
 };
 
 struct vc_sm_imported {
@@ -125,6 +125,19 @@ static const char *const port_action_type_names[] = {
 #endif
 
 struct vchiq_mmal_instance;
+struct mmal_msg_context;
+
+/* shared state for a group of asynchronous parameter messages */
+struct mmal_param_batch {
+	struct vchiq_mmal_instance *instance;
+	struct vchiq_mmal_port *port;
+	/* replies outstanding, plus one held by the submitter */
+	atomic_t pending;
+	/* first error reported by any message in the batch */
+	int status;
+	vchiq_mmal_param_cb cb;
+	void *cb_ctx;
+};
 
 /* normal message context */
 struct mmal_msg_context {
@@ -135,10 +148,16 @@ struct mmal_msg_context {
 	 */
 	int handle;
 
+	/* Reply handler for asynchronous messages, called from the VCHIQ
+	 * callback thread. NULL for synchronous messages.
+	 */
+	void (*reply_cb)(struct mmal_msg_context *msg_context,
+			 struct mmal_msg *rmsg, u32 msg_len);
+
 	union {
 		struct {
-			/* work struct for buffer_cb callback */
-			struct work_struct work;
+			/* set once the buffer may be passed to buffer_cb */
+			int ready;
 			/* work struct for deferred callback */
 			struct work_struct buffer_to_host_work;
 			/* mmal instance */
@@ -171,6 +190,14 @@ struct mmal_msg_context {
 			/* completion upon reply */
 			struct completion cmplt;
 		} sync;		/* synchronous response */
+
+		struct {
+			struct mmal_param_batch *batch;
+			u32 parameter;
+			/* destination of a parameter get */
+			void *value;
+			u32 *value_size;
+		} param;	/* asynchronous parameter set/get */
 	} u;
 
 };
@@ -244,15 +271,9 @@ release_msg_context(struct mmal_msg_context *msg_context)
 	kfree(msg_context);
 }
 
-/* workqueue scheduled callback
- *
- * we do this because it is important we do not call any other vchiq
- * sync calls from witin the message delivery thread
- */
-static void buffer_work_cb(struct work_struct *work)
+/* pass a returned buffer or event to the port owner */
+static void buffer_cb_deliver(struct mmal_msg_context *msg_context)
 {
-	struct mmal_msg_context *msg_context =
-		container_of(work, struct mmal_msg_context, u.bulk.work);
 	struct mmal_buffer *buffer = msg_context->u.bulk.buffer;
 
 	if (!buffer) {
@@ -279,6 +300,115 @@ static void buffer_work_cb(struct work_struct *work)
 		mutex_unlock(&msg_context->u.bulk.port->event_context_mutex);
 }
 
+/* port completion ring
+ *
+ * Every buffer and event returned for a port is added to the port's
+ * cb_ring by the VCHIQ callback thread, in the order the messages arrive,
+ * and handed to buffer_cb strictly in that order. A buffer whose data
+ * still has to be bulk received holds its place in the ring until the
+ * transfer completes.
+ *
+ * Whoever sets MMAL_CB_DRAINING delivers entries. The VCHIQ callback
+ * thread does so directly for data buffers on direct_cb ports, but must
+ * not call any other vchiq sync calls itself, so at the first entry that
+ * may sleep (an event, or any buffer on other ports) it hands the rest of
+ * the ring to cb_work. The bit stays set until cb_work has emptied the
+ * ring, so later buffers cannot overtake the deferred one.
+ */
+#define MMAL_CB_DRAINING	0
+
+static bool cb_ring_add(struct vchiq_mmal_port *port,
+			struct mmal_msg_context *msg_context, int ready)
+{
+	unsigned int head = port->cb_head;
+
+	/* cannot fill, every context is in the ring at most once */
+	if (WARN_ON_ONCE(head - READ_ONCE(port->cb_tail) >=
+			 VCHIQ_MMAL_CB_RING_SIZE))
+		return false;
+
+	msg_context->u.bulk.ready = ready;
+	port->cb_ring[head & (VCHIQ_MMAL_CB_RING_SIZE - 1)] = msg_context;
+	/* publish the entry before moving the head past it */
+	smp_store_release(&port->cb_head, head + 1);
+
+	return true;
+}
+
+/* the oldest entry, if it is ready to be delivered */
+static struct mmal_msg_context *cb_ring_peek(struct vchiq_mmal_port *port)
+{
+	unsigned int tail = port->cb_tail;
+	struct mmal_msg_context *msg_context;
+
+	if (tail == smp_load_acquire(&port->cb_head))
+		return NULL;
+
+	msg_context = port->cb_ring[tail & (VCHIQ_MMAL_CB_RING_SIZE - 1)];
+	if (!smp_load_acquire(&msg_context->u.bulk.ready))
+		return NULL;
+
+	return msg_context;
+}
+
+/* deliver ready entries; called with MMAL_CB_DRAINING held */
+static void cb_ring_drain(struct vchiq_mmal_port *port, bool can_sleep)
+{
+	struct mmal_msg_context *msg_context;
+
+	for (;;) {
+		while ((msg_context = cb_ring_peek(port))) {
+			if (!can_sleep &&
+			    (!port->direct_cb || msg_context->u.bulk.cmd)) {
+				/* cb_work inherits MMAL_CB_DRAINING */
+				schedule_work(&port->cb_work);
+				return;
+			}
+
+			smp_store_release(&port->cb_tail, port->cb_tail + 1);
+			buffer_cb_deliver(msg_context);
+		}
+
+		clear_bit_unlock(MMAL_CB_DRAINING, &port->cb_flags);
+		/* pairs with the barrier in cb_ring_kick() */
+		smp_mb__after_atomic();
+
+		/* pick up anything added or completed whilst we held the bit */
+		if (!cb_ring_peek(port) ||
+		    test_and_set_bit_lock(MMAL_CB_DRAINING, &port->cb_flags))
+			return;
+	}
+}
+
+/* deliver whatever became ready, unless another context is already */
+static void cb_ring_kick(struct vchiq_mmal_port *port)
+{
+	/* order the new entry against the drain bit, see cb_ring_drain() */
+	smp_mb();
+	if (!test_and_set_bit_lock(MMAL_CB_DRAINING, &port->cb_flags))
+		cb_ring_drain(port, false);
+}
+
+/* mark an entry added by cb_ring_add() as ready and deliver it in turn */
+static void cb_ring_complete(struct mmal_msg_context *msg_context)
+{
+	smp_store_release(&msg_context->u.bulk.ready, 1);
+	cb_ring_kick(msg_context->u.bulk.port);
+}
+
+/* workqueue scheduled callback
+ *
+ * we do this because it is important we do not call any other vchiq
+ * sync calls from witin the message delivery thread
+ */
+static void cb_ring_work(struct work_struct *work)
+{
+	struct vchiq_mmal_port *port =
+		container_of(work, struct vchiq_mmal_port, cb_work);
+
+	cb_ring_drain(port, true);
+}
+
 /* workqueue scheduled callback to handle receiving buffers
  *
  * VCHI will allow up to 4 bulk receives to be scheduled before blocking.
@@ -312,9 +442,14 @@ static void buffer_to_host_work_cb(struct work_struct *work)
 
 	vchi_service_release(instance->handle);
 
-	if (ret != 0)
+	if (ret != 0) {
 		pr_err("%s: ctx: %p, vchi_bulk_queue_receive failed %d\n",
 		       __func__, msg_context, ret);
+
+		/* no bulk callback will come, and the port waits on this */
+		msg_context->u.bulk.status = ret;
+		cb_ring_complete(msg_context);
+	}
 }
 
 /* enqueue a bulk receive for a given message context */
@@ -405,9 +540,9 @@ buffer_from_host(struct vchiq_mmal_instance *instance,
 	msg_context->u.bulk.port = port;
 	msg_context->u.bulk.buffer = buf;
 	msg_context->u.bulk.buffer_used = 0;
+	msg_context->u.bulk.cmd = 0;
 
 	/* initialise work structure ready to schedule callback */
-	INIT_WORK(&msg_context->u.bulk.work, buffer_work_cb);
 	INIT_WORK(&msg_context->u.bulk.buffer_to_host_work,
 		  buffer_to_host_work_cb);
 
@@ -564,7 +699,11 @@ static void event_to_host_cb(struct vchiq_mmal_instance *instance,
 			 msg->u.event_to_host.cmd, msg->u.event_to_host.length);
 	}
 
-	schedule_work(&msg_context->u.bulk.work);
+	if (!cb_ring_add(port, msg_context, 1)) {
+		mutex_unlock(&port->event_context_mutex);
+		return;
+	}
+	cb_ring_kick(port);
 }
 
 /* deals with receipt of buffer to host message */
@@ -591,6 +730,14 @@ static void buffer_to_host_cb(struct vchiq_mmal_instance *instance,
 		return;
 	}
 
+	/* hold our place in the port's ring until the data is in */
+	if (!cb_ring_add(msg_context->u.bulk.port, msg_context, 0)) {
+		/* the context is already in the ring, leave it alone */
+		pr_err("%s: ctx: %p, returned twice, dropping it\n",
+		       __func__, msg_context);
+		return;
+	}
+
 	msg_context->u.bulk.mmal_flags =
 				msg->u.buffer_from_host.buffer_header.flags;
 
@@ -659,7 +806,7 @@ static void buffer_to_host_cb(struct vchiq_mmal_instance *instance,
 	}
 
 	/* schedule the port callback */
-	schedule_work(&msg_context->u.bulk.work);
+	cb_ring_complete(msg_context);
 }
 
 static void bulk_receive_cb(struct vchiq_mmal_instance *instance,
@@ -668,7 +815,7 @@ static void bulk_receive_cb(struct vchiq_mmal_instance *instance,
 	msg_context->u.bulk.status = 0;
 
 	/* schedule the port callback */
-	schedule_work(&msg_context->u.bulk.work);
+	cb_ring_complete(msg_context);
 }
 
 static void bulk_abort_cb(struct vchiq_mmal_instance *instance,
@@ -678,7 +825,7 @@ static void bulk_abort_cb(struct vchiq_mmal_instance *instance,
 
 	msg_context->u.bulk.status = -EINTR;
 
-	schedule_work(&msg_context->u.bulk.work);
+	cb_ring_complete(msg_context);
 }
 
 /* incoming event service callback */
@@ -743,6 +890,13 @@ static void service_callback(void *param,
 				break;
 			}
 
+			if (msg_context->reply_cb) {
+				msg_context->reply_cb(msg_context, msg,
+						      msg_len);
+				vchi_held_msg_release(&msg_handle);
+				break;
+			}
+
 			/* fill in context values */
 			msg_context->u.sync.msg_handle = msg_handle;
 			msg_context->u.sync.msg = msg;
@@ -784,6 +938,32 @@ static void service_callback(void *param,
 	}
 }
 
+/* queue a message tagged with msg_context, without waiting for the reply */
+static int queue_mmal_msg(struct vchiq_mmal_instance *instance,
+			  struct mmal_msg_context *msg_context,
+			  struct mmal_msg *msg, unsigned int payload_len)
+{
+	int ret;
+
+	msg->h.magic = MMAL_MAGIC;
+	msg->h.context = msg_context->handle;
+	msg->h.status = 0;
+
+	DBG_DUMP_MSG(msg, (sizeof(struct mmal_msg_header) + payload_len),
+		     ">>> message");
+
+	vchi_service_use(instance->handle);
+
+	ret = vchi_queue_kernel_message(instance->handle,
+					msg,
+					sizeof(struct mmal_msg_header) +
+					payload_len);
+
+	vchi_service_release(instance->handle);
+
+	return ret;
+}
+
 static int send_synchronous_mmal_msg(struct vchiq_mmal_instance *instance,
 				     struct mmal_msg *msg,
 				     unsigned int payload_len,
@@ -809,22 +989,7 @@ static int send_synchronous_mmal_msg(struct vchiq_mmal_instance *instance,
 
 	init_completion(&msg_context->u.sync.cmplt);
 
-	msg->h.magic = MMAL_MAGIC;
-	msg->h.context = msg_context->handle;
-	msg->h.status = 0;
-
-	DBG_DUMP_MSG(msg, (sizeof(struct mmal_msg_header) + payload_len),
-		     ">>> sync message");
-
-	vchi_service_use(instance->handle);
-
-	ret = vchi_queue_kernel_message(instance->handle,
-					msg,
-					sizeof(struct mmal_msg_header) +
-					payload_len);
-
-	vchi_service_release(instance->handle);
-
+	ret = queue_mmal_msg(instance, msg_context, msg, payload_len);
 	if (ret) {
 		pr_err("error %d queuing message\n", ret);
 		release_msg_context(msg_context);
@@ -1589,6 +1754,233 @@ int vchiq_mmal_port_parameter_get(struct vchiq_mmal_instance *instance,
 }
 EXPORT_SYMBOL_GPL(vchiq_mmal_port_parameter_get);
 
+/* drop a reference on an asynchronous parameter batch, reporting the
+ * result to the owner once every message has completed
+ */
+static void param_batch_put(struct mmal_param_batch *batch, int status,
+			    bool notify)
+{
+	if (status)
+		cmpxchg(&batch->status, 0, status);
+
+	if (!atomic_dec_and_test(&batch->pending))
+		return;
+
+	if (notify && batch->cb)
+		batch->cb(batch->instance, batch->port, batch->status,
+			  batch->cb_ctx);
+	kfree(batch);
+}
+
+static void param_reply_cb(struct mmal_msg_context *msg_context,
+			   struct mmal_msg *rmsg, u32 msg_len)
+{
+	struct mmal_param_batch *batch = msg_context->u.param.batch;
+	const u32 hdr_len = offsetof(struct mmal_msg,
+				     u.port_parameter_get_reply.value);
+	u32 size, copy;
+	int ret;
+
+	switch (rmsg->h.type) {
+	case MMAL_MSG_TYPE_PORT_PARAMETER_SET:
+		ret = -rmsg->u.port_parameter_set_reply.status;
+		break;
+
+	case MMAL_MSG_TYPE_PORT_PARAMETER_GET:
+		ret = -rmsg->u.port_parameter_get_reply.status;
+
+		/* reply size includes the header, *value_size doesn't */
+		size = rmsg->u.port_parameter_get_reply.size;
+		size = size > 2 * sizeof(u32) ? size - 2 * sizeof(u32) : 0;
+
+		/* Copy only as much as we have space for and the VPU actually
+		 * sent, but report true size of parameter
+		 */
+		copy = min(size, *msg_context->u.param.value_size);
+		copy = min_t(u32, copy,
+			     sizeof(rmsg->u.port_parameter_get_reply.value));
+		copy = min(copy, msg_len > hdr_len ? msg_len - hdr_len : 0);
+		memcpy(msg_context->u.param.value,
+		       &rmsg->u.port_parameter_get_reply.value, copy);
+		*msg_context->u.param.value_size = size;
+		break;
+
+	default:
+		pr_err("Incorrect reply type %d\n", rmsg->h.type);
+		ret = -EINVAL;
+		break;
+	}
+
+	pr_debug("%s:result:%d component:0x%x port:%d parameter:%d\n",
+		 __func__, ret, batch->port->component->handle,
+		 batch->port->handle, msg_context->u.param.parameter);
+
+	release_msg_context(msg_context);
+	param_batch_put(batch, ret, true);
+}
+
+static struct mmal_param_batch *
+param_batch_alloc(struct vchiq_mmal_instance *instance,
+		  struct vchiq_mmal_port *port, unsigned int num_msgs,
+		  vchiq_mmal_param_cb cb, void *cb_ctx)
+{
+	struct mmal_param_batch *batch;
+
+	batch = kzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return NULL;
+
+	batch->instance = instance;
+	batch->port = port;
+	atomic_set(&batch->pending, num_msgs + 1);
+	batch->cb = cb;
+	batch->cb_ctx = cb_ctx;
+
+	return batch;
+}
+
+/* queue one asynchronous parameter message as part of batch */
+static int param_msg_queue(struct vchiq_mmal_instance *instance,
+			   struct mmal_param_batch *batch, struct mmal_msg *m,
+			   unsigned int payload_len, u32 parameter,
+			   void *value, u32 *value_size)
+{
+	struct mmal_msg_context *msg_context;
+	int ret;
+
+	msg_context = get_msg_context(instance);
+	if (IS_ERR(msg_context))
+		return PTR_ERR(msg_context);
+
+	msg_context->reply_cb = param_reply_cb;
+	msg_context->u.param.batch = batch;
+	msg_context->u.param.parameter = parameter;
+	msg_context->u.param.value = value;
+	msg_context->u.param.value_size = value_size;
+
+	ret = queue_mmal_msg(instance, msg_context, m, payload_len);
+	if (ret) {
+		pr_err("error %d queuing message\n", ret);
+		release_msg_context(msg_context);
+	}
+
+	return ret;
+}
+
+int vchiq_mmal_port_parameter_set_async(struct vchiq_mmal_instance *instance,
+					struct vchiq_mmal_port *port,
+					const struct vchiq_mmal_param *params,
+					unsigned int num_params,
+					vchiq_mmal_param_cb cb, void *cb_ctx)
+{
+	struct mmal_param_batch *batch;
+	struct mmal_msg m;
+	unsigned int i;
+	int ret = 0;
+
+	if (!num_params)
+		return -EINVAL;
+
+	for (i = 0; i < num_params; i++) {
+		/* zero copy changes how buffers are sent, so must be sync */
+		if (params[i].id == MMAL_PARAMETER_ZERO_COPY ||
+		    params[i].size > sizeof(m.u.port_parameter_set.value))
+			return -EINVAL;
+	}
+
+	batch = param_batch_alloc(instance, port, num_params, cb, cb_ctx);
+	if (!batch)
+		return -ENOMEM;
+
+	i = 0;
+	if (mutex_lock_interruptible(&instance->vchiq_mutex)) {
+		ret = -EINTR;
+		goto put_unsent;
+	}
+
+	for (i = 0; i < num_params; i++) {
+		m.h.type = MMAL_MSG_TYPE_PORT_PARAMETER_SET;
+
+		m.u.port_parameter_set.component_handle =
+						port->component->handle;
+		m.u.port_parameter_set.port_handle = port->handle;
+		m.u.port_parameter_set.id = params[i].id;
+		m.u.port_parameter_set.size = (2 * sizeof(u32)) +
+					      params[i].size;
+		memcpy(&m.u.port_parameter_set.value, params[i].value,
+		       params[i].size);
+
+		ret = param_msg_queue(instance, batch, &m,
+				      (4 * sizeof(u32)) + params[i].size,
+				      params[i].id, NULL, NULL);
+		if (ret)
+			break;
+	}
+
+	mutex_unlock(&instance->vchiq_mutex);
+
+put_unsent:
+	if (!i) {
+		/* nothing was queued, so the callback will never run */
+		kfree(batch);
+		return ret;
+	}
+
+	/* messages that were never queued will not get a reply */
+	for (; i < num_params; i++)
+		param_batch_put(batch, ret, true);
+	param_batch_put(batch, 0, true);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(vchiq_mmal_port_parameter_set_async);
+
+int vchiq_mmal_port_parameter_get_async(struct vchiq_mmal_instance *instance,
+					struct vchiq_mmal_port *port,
+					u32 parameter, void *value,
+					u32 *value_size,
+					vchiq_mmal_param_cb cb, void *cb_ctx)
+{
+	struct mmal_param_batch *batch;
+	struct mmal_msg m;
+	int ret;
+
+	if (*value_size > sizeof(m.u.port_parameter_get_reply.value))
+		return -EINVAL;
+
+	batch = param_batch_alloc(instance, port, 1, cb, cb_ctx);
+	if (!batch)
+		return -ENOMEM;
+
+	m.h.type = MMAL_MSG_TYPE_PORT_PARAMETER_GET;
+
+	m.u.port_parameter_get.component_handle = port->component->handle;
+	m.u.port_parameter_get.port_handle = port->handle;
+	m.u.port_parameter_get.id = parameter;
+	m.u.port_parameter_get.size = (2 * sizeof(u32)) + *value_size;
+
+	if (mutex_lock_interruptible(&instance->vchiq_mutex)) {
+		kfree(batch);
+		return -EINTR;
+	}
+
+	ret = param_msg_queue(instance, batch, &m,
+			      sizeof(struct mmal_msg_port_parameter_get),
+			      parameter, value, value_size);
+
+	mutex_unlock(&instance->vchiq_mutex);
+
+	if (ret) {
+		kfree(batch);
+		return ret;
+	}
+
+	param_batch_put(batch, 0, true);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(vchiq_mmal_port_parameter_get_async);
+
 /* enable a port
  *
  * enables a port and queues buffers for satisfying callbacks if we
@@ -1817,13 +2209,26 @@ int mmal_vchi_buffer_cleanup(struct mmal_buffer *buf)
 }
 EXPORT_SYMBOL_GPL(mmal_vchi_buffer_cleanup);
 
-static void init_event_context(struct vchiq_mmal_instance *instance,
-			       struct vchiq_mmal_port *port)
+static int init_event_context(struct vchiq_mmal_instance *instance,
+			      struct vchiq_mmal_port *port)
 {
-	struct mmal_msg_context *ctx = get_msg_context(instance);
+	struct mmal_msg_context *ctx;
 
 	mutex_init(&port->event_context_mutex);
 
+	port->cb_head = 0;
+	port->cb_tail = 0;
+	port->cb_flags = 0;
+	INIT_WORK(&port->cb_work, cb_ring_work);
+	port->cb_ring = kcalloc(VCHIQ_MMAL_CB_RING_SIZE,
+				sizeof(*port->cb_ring), GFP_KERNEL);
+	if (!port->cb_ring)
+		return -ENOMEM;
+
+	ctx = get_msg_context(instance);
+	if (IS_ERR(ctx))
+		goto free_ring;
+
 	port->event_context = ctx;
 	ctx->u.bulk.instance = instance;
 	ctx->u.bulk.port = port;
@@ -1836,19 +2241,30 @@ static void init_event_context(struct vchiq_mmal_instance *instance,
 	if (!ctx->u.bulk.buffer->buffer)
 		goto release_buffer;
 
-	INIT_WORK(&ctx->u.bulk.work, buffer_work_cb);
-	return;
+	return 0;
 
 release_buffer:
 	kfree(ctx->u.bulk.buffer);
 release_msg_context:
 	release_msg_context(ctx);
+	port->event_context = NULL;
+free_ring:
+	kfree(port->cb_ring);
+	port->cb_ring = NULL;
+	return -ENOMEM;
 }
 
 static void free_event_context(struct vchiq_mmal_port *port)
 {
 	struct mmal_msg_context *ctx = port->event_context;
 
+	/* no callbacks may still be in flight once the ring goes away */
+	if (port->cb_ring) {
+		flush_work(&port->cb_work);
+		kfree(port->cb_ring);
+		port->cb_ring = NULL;
+	}
+
 	if (!ctx)
 		return;
 
@@ -1920,7 +2336,9 @@ int vchiq_mmal_component_init(struct vchiq_mmal_instance *instance,
 	ret = port_info_get(instance, &component->control);
 	if (ret < 0)
 		goto release_component;
-	init_event_context(instance, &component->control);
+	ret = init_event_context(instance, &component->control);
+	if (ret < 0)
+		goto release_component;
 
 	for (idx = 0; idx < component->inputs; idx++) {
 		component->input[idx].type = MMAL_PORT_TYPE_INPUT;
@@ -1931,7 +2349,9 @@ int vchiq_mmal_component_init(struct vchiq_mmal_instance *instance,
 		ret = port_info_get(instance, &component->input[idx]);
 		if (ret < 0)
 			goto release_component;
-		init_event_context(instance, &component->input[idx]);
+		ret = init_event_context(instance, &component->input[idx]);
+		if (ret < 0)
+			goto release_component;
 	}
 
 	for (idx = 0; idx < component->outputs; idx++) {
@@ -1943,7 +2363,9 @@ int vchiq_mmal_component_init(struct vchiq_mmal_instance *instance,
 		ret = port_info_get(instance, &component->output[idx]);
 		if (ret < 0)
 			goto release_component;
-		init_event_context(instance, &component->output[idx]);
+		ret = init_event_context(instance, &component->output[idx]);
+		if (ret < 0)
+			goto release_component;
 	}
 
 	for (idx = 0; idx < component->clocks; idx++) {
@@ -1955,7 +2377,9 @@ int vchiq_mmal_component_init(struct vchiq_mmal_instance *instance,
 		ret = port_info_get(instance, &component->clock[idx]);
 		if (ret < 0)
 			goto release_component;
-		init_event_context(instance, &component->clock[idx]);
+		ret = init_event_context(instance, &component->clock[idx]);
+		if (ret < 0)
+			goto release_component;
 	}
 
 	*component_out = component;
@@ -2072,7 +2496,9 @@ EXPORT_SYMBOL_GPL(vchiq_mmal_version);
 
 int vchiq_mmal_finalise(struct vchiq_mmal_instance *instance)
 {
+	struct mmal_msg_context *msg_context;
 	int status = 0;
+	int handle;
 
 	if (!instance)
 		return -EINVAL;
@@ -2093,6 +2519,15 @@ int vchiq_mmal_finalise(struct vchiq_mmal_instance *instance)
 
 	vfree(instance->bulk_scratch);
 
+	/* the service is closed, so asynchronous replies will never arrive */
+	idr_for_each_entry(&instance->context_map, msg_context, handle) {
+		if (msg_context->reply_cb) {
+			param_batch_put(msg_context->u.param.batch, -ENODEV,
+					false);
+			release_msg_context(msg_context);
+		}
+	}
+
 	idr_destroy(&instance->context_map);
 
 	vchi_disconnect(instance->vchi_instance);
@@ -21,6 +21,13 @@
 
 #define MAX_PORT_COUNT 4
 
+/*
+ * Entries in each port's completion ring. Must be a power of two, and at
+ * least the number of buffers a port may have with the VPU plus one for
+ * the event buffer.
+ */
+#define VCHIQ_MMAL_CB_RING_SIZE 64
+
 /* Maximum size of the format extradata. */
 #define MMAL_FORMAT_EXTRADATA_MAX_SIZE 128
 
@@ -47,9 +54,26 @@ typedef void (*vchiq_mmal_buffer_cb)(
 		struct vchiq_mmal_port *port,
 		int status, struct mmal_buffer *buffer);
 
+typedef void (*vchiq_mmal_param_cb)(
+		struct vchiq_mmal_instance *instance,
+		struct vchiq_mmal_port *port,
+		int status, void *cb_ctx);
+
+/* one entry of an asynchronous parameter set */
+struct vchiq_mmal_param {
+	u32 id;
+	void *value;
+	u32 size;
+};
+
 struct vchiq_mmal_port {
 	u32 enabled:1;
 	u32 zero_copy:1;
+	/*
+	 * buffer_cb never sleeps nor calls back into vchiq for data buffers,
+	 * so they can be returned directly from the VCHIQ callback thread.
+	 */
+	u32 direct_cb:1;
 	u32 handle;
 	u32 type; /* port type, cached to use on port info set */
 	u32 index; /* port index, cached to use on port info set */
@@ -84,6 +108,17 @@ struct vchiq_mmal_port {
 	/* ensure serialised use of the one event context structure */
 	struct mutex event_context_mutex;
 	struct mmal_msg_context *event_context;
+
+	/*
+	 * Returned buffers and events in the order the VPU sent them. Only
+	 * the VCHIQ callback thread adds entries; they are delivered from
+	 * there or from cb_work, whichever holds the drain bit in cb_flags.
+	 */
+	struct mmal_msg_context **cb_ring;
+	unsigned int cb_head;	/* next slot to fill */
+	unsigned int cb_tail;	/* next slot to deliver */
+	unsigned long cb_flags;
+	struct work_struct cb_work;
 };
 
 struct vchiq_mmal_component {
@@ -152,6 +187,28 @@ int vchiq_mmal_port_parameter_get(struct vchiq_mmal_instance *instance,
 				  void *value,
 				  u32 *value_size);
 
+/* asynchronous parameter set/get
+ *
+ * Queue the messages and return without waiting for the VPU to reply.
+ * cb is called once every message has been answered, with the first
+ * error seen. It runs from the VCHIQ callback thread (or before the
+ * call returns) and must not sleep nor make synchronous vchiq calls.
+ * Values to set are copied before returning; the destination of a get
+ * must remain valid until cb runs. If an error is returned, cb is not
+ * called.
+ */
+int vchiq_mmal_port_parameter_set_async(struct vchiq_mmal_instance *instance,
+					struct vchiq_mmal_port *port,
+					const struct vchiq_mmal_param *params,
+					unsigned int num_params,
+					vchiq_mmal_param_cb cb, void *cb_ctx);
+
+int vchiq_mmal_port_parameter_get_async(struct vchiq_mmal_instance *instance,
+					struct vchiq_mmal_port *port,
+					u32 parameter, void *value,
+					u32 *value_size,
+					vchiq_mmal_param_cb cb, void *cb_ctx);
+
 int vchiq_mmal_port_set_format(struct vchiq_mmal_instance *instance,
 			       struct vchiq_mmal_port *port);
 
@@ -246,6 +246,11 @@ struct pl011_dmarx_data {
 	bool auto_poll_rate;
 	unsigned int poll_rate;
 	unsigned int poll_timeout;
+	/* cyclic mode: one ring the DMA keeps filling, read from ring_tail */
+	bool			cyclic;
+	char			*ring;
+	dma_addr_t		ring_dma;
+	unsigned int		ring_tail;
 };
 
 struct pl011_dmatx_data {
@@ -368,6 +373,7 @@ static int pl011_fifo_to_tty(struct uart_amba_port *uap)
 #ifdef CONFIG_DMA_ENGINE
 
 #define PL011_DMA_BUFFER_SIZE PAGE_SIZE
+#define PL011_DMA_RX_RING_SIZE (4 * PL011_DMA_BUFFER_SIZE)
 
 static int pl011_sgbuf_init(struct dma_chan *chan, struct pl011_sgbuf *sg,
 	enum dma_data_direction dir)
@@ -482,6 +488,18 @@ static void pl011_dma_probe(struct uart_amba_port *uap)
 					"RX DMA disabled - no residue processing\n");
 				return;
 			}
+
+			/*
+			 * Switching buffers needs the transfer paused to get
+			 * a stable residue. Without pause keep one cyclic
+			 * transfer running and only ever read its residue,
+			 * which then has to be exact to keep the ring and
+			 * the FIFO in order.
+			 */
+			uap->dmarx.cyclic = !caps.cmd_pause &&
+				caps.residue_granularity ==
+					DMA_RESIDUE_GRANULARITY_BURST &&
+				dma_has_cap(DMA_CYCLIC, chan->device->cap_mask);
 		}
 		dmaengine_slave_config(chan, &rx_conf);
 		uap->dmarx.chan = chan;
@@ -525,8 +543,14 @@ static void pl011_dma_probe(struct uart_amba_port *uap)
 					uap->dmarx.poll_timeout = 3000;
 			}
 		}
-		dev_info(uap->port.dev, "DMA channel RX %s\n",
-			 dma_chan_name(uap->dmarx.chan));
+		/* the ring is drained by period and timeout, never polled */
+		if (uap->dmarx.cyclic) {
+			uap->dmarx.auto_poll_rate = false;
+			uap->dmarx.poll_rate = 0;
+		}
+		dev_info(uap->port.dev, "DMA channel RX %s%s\n",
+			 dma_chan_name(uap->dmarx.chan),
+			 uap->dmarx.cyclic ? " (cyclic)" : "");
 	}
 }
 
@@ -827,6 +851,44 @@ __acquires(&uap->port.lock)
 }
 
 static void pl011_dma_rx_callback(void *data);
+static void pl011_dma_rx_period_callback(void *data);
+
+static int pl011_dma_rx_trigger_cyclic(struct uart_amba_port *uap)
+{
+	struct dma_chan *rxchan = uap->dmarx.chan;
+	struct pl011_dmarx_data *dmarx = &uap->dmarx;
+	struct dma_async_tx_descriptor *desc;
+
+	desc = dmaengine_prep_dma_cyclic(rxchan, dmarx->ring_dma,
+					 PL011_DMA_RX_RING_SIZE,
+					 PL011_DMA_BUFFER_SIZE,
+					 DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
+	if (!desc) {
+		uap->dmarx.running = false;
+		dmaengine_terminate_all(rxchan);
+		return -EBUSY;
+	}
+
+	desc->callback = pl011_dma_rx_period_callback;
+	desc->callback_param = uap;
+	dmarx->ring_tail = 0;
+	dmarx->cookie = dmaengine_submit(desc);
+	dma_async_issue_pending(rxchan);
+
+	uap->dmacr |= UART011_RXDMAE;
+	pl011_write(uap->dmacr, uap, REG_DMACR);
+	uap->dmarx.running = true;
+
+	/*
+	 * The DMA only reads the character, so the overrun flag would be
+	 * lost. Take the overrun interrupt instead to account for it.
+	 */
+	uap->im &= ~UART011_RXIM;
+	uap->im |= UART011_OEIM;
+	pl011_write(uap->im, uap, REG_IMSC);
+
+	return 0;
+}
 
 static int pl011_dma_rx_trigger_dma(struct uart_amba_port *uap)
 {
@@ -838,6 +900,9 @@ static int pl011_dma_rx_trigger_dma(struct uart_amba_port *uap)
 	if (!rxchan)
 		return -EIO;
 
+	if (dmarx->cyclic)
+		return pl011_dma_rx_trigger_cyclic(uap);
+
 	/* Start the RX DMA job */
 	sgbuf = uap->dmarx.use_buf_b ?
 		&uap->dmarx.sgbuf_b : &uap->dmarx.sgbuf_a;
@@ -950,6 +1015,101 @@ static void pl011_dma_rx_chars(struct uart_amba_port *uap,
 	spin_lock(&uap->port.lock);
 }
 
+/*
+ * Move everything the cyclic transfer has written since the last call into
+ * the tty. Characters the tty has no room for are dropped and counted as
+ * overruns, the ring has to keep moving. Called with the port lock held.
+ */
+static void pl011_dma_rx_ring_take(struct uart_amba_port *uap)
+{
+	struct tty_port *port = &uap->port.state->port;
+	struct pl011_dmarx_data *dmarx = &uap->dmarx;
+	struct dma_chan *rxchan = dmarx->chan;
+	struct dma_tx_state state;
+	unsigned int head, count, taken;
+
+	rxchan->device->device_tx_status(rxchan, dmarx->cookie, &state);
+	if (WARN_ON_ONCE(state.residue > PL011_DMA_RX_RING_SIZE))
+		return;
+	head = (PL011_DMA_RX_RING_SIZE - state.residue) %
+		PL011_DMA_RX_RING_SIZE;
+
+	while (dmarx->ring_tail != head) {
+		if (head > dmarx->ring_tail)
+			count = head - dmarx->ring_tail;
+		else
+			count = PL011_DMA_RX_RING_SIZE - dmarx->ring_tail;
+
+		taken = tty_insert_flip_string(port,
+					       dmarx->ring + dmarx->ring_tail,
+					       count);
+		uap->port.icount.rx += taken;
+		uap->port.icount.overrun += count - taken;
+
+		dmarx->ring_tail = (dmarx->ring_tail + count) %
+			PL011_DMA_RX_RING_SIZE;
+	}
+}
+
+static void pl011_dma_rx_period_callback(void *data)
+{
+	struct uart_amba_port *uap = data;
+
+	spin_lock_irq(&uap->port.lock);
+	if (uap->dmarx.running)
+		pl011_dma_rx_ring_take(uap);
+	spin_unlock_irq(&uap->port.lock);
+
+	tty_flip_buffer_push(&uap->port.state->port);
+}
+
+/*
+ * The receive timeout means the line went idle with a few characters
+ * still below the DMA burst level, and an overrun means the FIFO filled up
+ * behind the DMA. Hold off the DMA requests so that the ring and then the
+ * FIFO can be emptied without reordering anything, but leave the cyclic
+ * transfer itself running. An overrun is reported after both, which is
+ * where the lost character belongs.
+ */
+static void pl011_dma_rx_cyclic_irq(struct uart_amba_port *uap, bool overrun)
+{
+	struct dma_chan *rxchan = uap->dmarx.chan;
+	struct dma_tx_state state;
+	unsigned int residue, tries = 10;
+	u32 fifotaken;
+
+	uap->dmacr &= ~UART011_RXDMAE;
+	pl011_write(uap->dmacr, uap, REG_DMACR);
+
+	/*
+	 * A burst that was already requested still lands in the ring. Wait
+	 * for the residue to settle so it is taken before the FIFO is read.
+	 */
+	rxchan->device->device_tx_status(rxchan, uap->dmarx.cookie, &state);
+	do {
+		residue = state.residue;
+		rxchan->device->device_tx_status(rxchan, uap->dmarx.cookie,
+						 &state);
+	} while (state.residue != residue && --tries);
+
+	pl011_dma_rx_ring_take(uap);
+	fifotaken = pl011_fifo_to_tty(uap);
+
+	if (overrun) {
+		uap->port.icount.overrun++;
+		tty_insert_flip_char(&uap->port.state->port, 0, TTY_OVERRUN);
+	}
+
+	uap->dmacr |= UART011_RXDMAE;
+	pl011_write(uap->dmacr, uap, REG_DMACR);
+
+	uap->irq_locked = 0;
+	spin_unlock(&uap->port.lock);
+	dev_vdbg(uap->port.dev, "Took %d chars from the FIFO\n", fifotaken);
+	tty_flip_buffer_push(&uap->port.state->port);
+	spin_lock(&uap->port.lock);
+}
+
 static void pl011_dma_rx_irq(struct uart_amba_port *uap)
 {
 	struct pl011_dmarx_data *dmarx = &uap->dmarx;
@@ -960,6 +1120,11 @@ static void pl011_dma_rx_irq(struct uart_amba_port *uap)
 	struct dma_tx_state state;
 	enum dma_status dmastat;
 
+	if (dmarx->cyclic) {
+		pl011_dma_rx_cyclic_irq(uap, false);
+		return;
+	}
+
 	/*
 	 * Pause the transfer so we can trust the current counter,
 	 * do this before we pause the PL011 block, else we may
@@ -1137,6 +1302,22 @@ static void pl011_dma_startup(struct uart_amba_port *uap)
 	if (!uap->dmarx.chan)
 		goto skip_rx;
 
+	if (uap->dmarx.cyclic) {
+		struct device *dma_dev = uap->dmarx.chan->device->dev;
+
+		uap->dmarx.ring = dma_alloc_coherent(dma_dev,
+						     PL011_DMA_RX_RING_SIZE,
+						     &uap->dmarx.ring_dma,
+						     GFP_KERNEL);
+		if (!uap->dmarx.ring) {
+			dev_err(uap->port.dev, "failed to init DMA %s: %d\n",
+				"RX ring", -ENOMEM);
+			goto skip_rx;
+		}
+		uap->using_rx_dma = true;
+		goto skip_rx;
+	}
+
 	/* Allocate and map DMA RX buffers */
 	ret = pl011_sgbuf_init(uap->dmarx.chan, &uap->dmarx.sgbuf_a,
 			       DMA_FROM_DEVICE);
@@ -1214,6 +1395,16 @@ static void pl011_dma_shutdown(struct uart_amba_port *uap)
 		uap->using_tx_dma = false;
 	}
 
+	if (uap->using_rx_dma && uap->dmarx.cyclic) {
+		dmaengine_terminate_all(uap->dmarx.chan);
+		dmaengine_synchronize(uap->dmarx.chan);
+		uap->dmarx.running = false;
+		dma_free_coherent(uap->dmarx.chan->device->dev,
+				  PL011_DMA_RX_RING_SIZE, uap->dmarx.ring,
+				  uap->dmarx.ring_dma);
+		uap->using_rx_dma = false;
+	}
+
 	if (uap->using_rx_dma) {
 		dmaengine_terminate_all(uap->dmarx.chan);
 		/* Clean up the RX DMA */
@@ -1271,6 +1462,11 @@ static inline void pl011_dma_rx_irq(struct uart_amba_port *uap)
 {
 }
 
+static inline void pl011_dma_rx_cyclic_irq(struct uart_amba_port *uap,
+					   bool overrun)
+{
+}
+
 static inline void pl011_dma_rx_stop(struct uart_amba_port *uap)
 {
 }
@@ -1532,6 +1728,10 @@ static irqreturn_t pl011_int(int irq, void *dev_id)
 				else
 					pl011_rx_chars(uap);
 			}
+			/* only unmasked while cyclic RX DMA owns the FIFO */
+			if ((status & UART011_OEIS) &&
+			    pl011_dma_rx_running(uap))
+				pl011_dma_rx_cyclic_irq(uap, true);
 			if (status & (UART011_DSRMIS|UART011_DCDMIS|
 				      UART011_CTSMIS|UART011_RIMIS))
 				pl011_modem_status(uap);
@@ -926,6 +926,10 @@ struct dwc2_hregs_backup {
  *                      stored elsewhere since we need one per TT.
  * @periodic_qh_count:  Count of periodic QHs, if using several eps. Used for
  *                      SOF enable/disable.
+ * @next_periodic_frame: No QH in periodic_sched_inactive is due before this
+ *                      (micro)frame, lets the SOF handler skip the list walk.
+ *                      Only meaningful while @next_periodic_valid is set.
+ * @next_periodic_valid: @next_periodic_frame bounds periodic_sched_inactive.
  * @free_hc_list:       Free host channels in the controller. This is a list of
  *                      struct dwc2_host_chan items.
  * @periodic_channels:  Number of host channels assigned to periodic transfers.
@@ -1096,6 +1100,8 @@ struct dwc2_hsotg {
 	unsigned long hs_periodic_bitmap[
 		DIV_ROUND_UP(DWC2_HS_SCHEDULE_US, BITS_PER_LONG)];
 	u16 periodic_qh_count;
+	u16 next_periodic_frame;
+	bool next_periodic_valid;
 	bool bus_suspended;
 	bool new_connection;
 
@@ -1390,6 +1396,8 @@ static inline int dwc2_hsotg_tx_fifo_average_depth(struct dwc2_hsotg *hsotg)
 static inline void dwc2_gadget_init_lpm(struct dwc2_hsotg *hsotg) {}
 #endif
 
+struct seq_file;
+
 #if IS_ENABLED(CONFIG_USB_DWC2_HOST) || IS_ENABLED(CONFIG_USB_DWC2_DUAL_ROLE)
 int dwc2_hcd_get_frame_number(struct dwc2_hsotg *hsotg);
 int dwc2_hcd_get_future_frame_number(struct dwc2_hsotg *hsotg, int us);
@@ -1402,6 +1410,7 @@ int dwc2_restore_host_registers(struct dwc2_hsotg *hsotg);
 int dwc2_host_enter_hibernation(struct dwc2_hsotg *hsotg);
 int dwc2_host_exit_hibernation(struct dwc2_hsotg *hsotg,
 			       int rem_wakeup, int reset);
+void dwc2_hcd_dump_schedule(struct dwc2_hsotg *hsotg, struct seq_file *seq);
 #else
 static inline int dwc2_hcd_get_frame_number(struct dwc2_hsotg *hsotg)
 { return 0; }
@@ -1425,6 +1434,8 @@ static inline int dwc2_host_enter_hibernation(struct dwc2_hsotg *hsotg)
 static inline int dwc2_host_exit_hibernation(struct dwc2_hsotg *hsotg,
 					     int rem_wakeup, int reset)
 { return 0; }
+static inline void dwc2_hcd_dump_schedule(struct dwc2_hsotg *hsotg,
+					  struct seq_file *seq) {}
 
 #endif
 
@@ -321,6 +321,36 @@ static void dwc2_hsotg_create_debug(struct dwc2_hsotg *hsotg)
 static inline void dwc2_hsotg_create_debug(struct dwc2_hsotg *hsotg) {}
 #endif
 
+#if IS_ENABLED(CONFIG_USB_DWC2_HOST) || IS_ENABLED(CONFIG_USB_DWC2_DUAL_ROLE)
+/**
+ * schedule_show() - debugfs: show the periodic host schedule
+ * @seq: The seq_file to write to.
+ * @v: Unused parameter.
+ *
+ * Show the high speed microframe map and the reservations of every periodic
+ * QH the host currently has scheduled.
+ */
+static int schedule_show(struct seq_file *seq, void *v)
+{
+	struct dwc2_hsotg *hsotg = seq->private;
+
+	dwc2_hcd_dump_schedule(hsotg, seq);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(schedule);
+
+static void dwc2_hcd_create_debug(struct dwc2_hsotg *hsotg)
+{
+	if (hsotg->dr_mode == USB_DR_MODE_PERIPHERAL)
+		return;
+
+	debugfs_create_file("schedule", 0444, hsotg->debug_root, hsotg,
+			    &schedule_fops);
+}
+#else
+static inline void dwc2_hcd_create_debug(struct dwc2_hsotg *hsotg) {}
+#endif
+
 /* dwc2_hsotg_delete_debug is removed as cleanup in done in dwc2_debugfs_exit */
 
 #define dump_register(nm)	\
@@ -779,6 +809,9 @@ int dwc2_debugfs_init(struct dwc2_hsotg *hsotg)
 	/* Add gadget debugfs nodes */
 	dwc2_hsotg_create_debug(hsotg);
 
+	/* Add host debugfs nodes */
+	dwc2_hcd_create_debug(hsotg);
+
 	hsotg->regset = devm_kzalloc(hsotg->dev, sizeof(*hsotg->regset),
 								GFP_KERNEL);
 	if (!hsotg->regset) {
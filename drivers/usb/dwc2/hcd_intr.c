@@ -132,29 +132,16 @@ static void dwc2_hc_handle_tt_clear(struct dwc2_hsotg *hsotg,
 }
 
 /*
- * Handles the start-of-frame interrupt in host mode. Non-periodic
- * transactions may be queued to the DWC_otg controller for the current
- * (micro)frame. Periodic transactions may be queued to the controller
- * for the next (micro)frame.
+ * Moves the periodic QHs that are due onto the ready list and works out when
+ * the next one still on the inactive list falls due.
  */
-static void dwc2_sof_intr(struct dwc2_hsotg *hsotg)
+static void dwc2_sof_activate_periodic(struct dwc2_hsotg *hsotg)
 {
 	struct list_head *qh_entry;
 	struct dwc2_qh *qh;
-	enum dwc2_transaction_type tr_type;
-
-	/* Clear interrupt */
-	dwc2_writel(hsotg, GINTSTS_SOF, GINTSTS);
-
-#ifdef DEBUG_SOF
-	dev_vdbg(hsotg->dev, "--Start of Frame Interrupt--\n");
-#endif
-
-	hsotg->frame_number = dwc2_hcd_get_frame_number(hsotg);
-
-	dwc2_track_missed_sofs(hsotg);
+	bool valid = false;
+	u16 next = 0;
 
-	/* Determine whether any periodic QHs should be executed */
 	qh_entry = hsotg->periodic_sched_inactive.next;
 	while (qh_entry != &hsotg->periodic_sched_inactive) {
 		qh = list_entry(qh_entry, struct dwc2_qh, qh_list_entry);
@@ -171,8 +158,47 @@ static void dwc2_sof_intr(struct dwc2_hsotg *hsotg)
 			 */
 			list_move_tail(&qh->qh_list_entry,
 				       &hsotg->periodic_sched_ready);
+		} else if (!valid ||
+			   dwc2_frame_num_gt(next, qh->next_active_frame)) {
+			next = qh->next_active_frame;
+			valid = true;
 		}
 	}
+
+	hsotg->next_periodic_frame = next;
+	hsotg->next_periodic_valid = valid;
+}
+
+/*
+ * Handles the start-of-frame interrupt in host mode. Non-periodic
+ * transactions may be queued to the DWC_otg controller for the current
+ * (micro)frame. Periodic transactions may be queued to the controller
+ * for the next (micro)frame.
+ */
+static void dwc2_sof_intr(struct dwc2_hsotg *hsotg)
+{
+	enum dwc2_transaction_type tr_type;
+
+	/* Clear interrupt */
+	dwc2_writel(hsotg, GINTSTS_SOF, GINTSTS);
+
+#ifdef DEBUG_SOF
+	dev_vdbg(hsotg->dev, "--Start of Frame Interrupt--\n");
+#endif
+
+	hsotg->frame_number = dwc2_hcd_get_frame_number(hsotg);
+
+	dwc2_track_missed_sofs(hsotg);
+
+	/*
+	 * Determine whether any periodic QHs should be executed. With many
+	 * long-interval endpoints most SOFs have nothing due, so only walk
+	 * the inactive list once the earliest QH on it has come up.
+	 */
+	if (!hsotg->next_periodic_valid ||
+	    dwc2_frame_num_le(hsotg->next_periodic_frame, hsotg->frame_number))
+		dwc2_sof_activate_periodic(hsotg);
+
 	tr_type = dwc2_hcd_select_transactions(hsotg);
 	if (tr_type != DWC2_TRANSACTION_NONE)
 		dwc2_hcd_queue_transactions(hsotg, tr_type);
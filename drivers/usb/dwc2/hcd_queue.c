@@ -46,6 +46,7 @@
 #include <linux/interrupt.h>
 #include <linux/dma-mapping.h>
 #include <linux/io.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/usb.h>
 
@@ -388,7 +389,6 @@ static unsigned long *dwc2_get_ls_map(struct dwc2_hsotg *hsotg,
 	return map;
 }
 
-#ifdef DWC2_PRINT_SCHEDULE
 /*
  * cat_printf() - A printf() + strcat() helper
  *
@@ -488,6 +488,7 @@ static void pmap_print(unsigned long *map, int bits_per_period,
 	}
 }
 
+#ifdef DWC2_PRINT_SCHEDULE
 struct dwc2_qh_print_data {
 	struct dwc2_hsotg *hsotg;
 	struct dwc2_qh *qh;
@@ -566,6 +567,92 @@ static inline void dwc2_qh_schedule_print(struct dwc2_hsotg *hsotg,
 					  struct dwc2_qh *qh) {};
 #endif
 
+/**
+ * dwc2_seq_print() - Helper function for dwc2_hcd_dump_schedule()
+ *
+ * @str:  The string to print
+ * @data: The struct seq_file to print to
+ */
+static void dwc2_seq_print(const char *str, void *data)
+{
+	seq_printf(data, "  %s\n", str);
+}
+
+/**
+ * dwc2_hcd_dump_schedule() - Print the periodic schedule to a seq_file
+ *
+ * Prints the whole high speed map followed by every periodic QH with the
+ * list it is on and the time it has reserved on the high speed and low/full
+ * speed busses, so it's possible to see how split transactions behind a TT
+ * have been packed.
+ *
+ * @hsotg: The HCD state structure for the DWC OTG controller.
+ * @seq:   Where to print.
+ */
+void dwc2_hcd_dump_schedule(struct dwc2_hsotg *hsotg, struct seq_file *seq)
+{
+	static const char * const list_names[] = {
+		"inactive", "ready", "assigned", "queued",
+	};
+	struct list_head *lists[] = {
+		&hsotg->periodic_sched_inactive,
+		&hsotg->periodic_sched_ready,
+		&hsotg->periodic_sched_assigned,
+		&hsotg->periodic_sched_queued,
+	};
+	unsigned long flags;
+	struct dwc2_qh *qh;
+	int i, j;
+
+	spin_lock_irqsave(&hsotg->lock, flags);
+
+	seq_printf(seq, "frame %04x, %d periodic QHs, next due %04x%s\n",
+		   hsotg->frame_number, hsotg->periodic_qh_count,
+		   hsotg->next_periodic_frame,
+		   hsotg->next_periodic_valid ? "" : " (unknown)");
+
+	seq_puts(seq, "high speed map:\n");
+	pmap_print(hsotg->hs_periodic_bitmap, DWC2_HS_PERIODIC_US_PER_UFRAME,
+		   DWC2_HS_SCHEDULE_UFRAMES, "uFrame", "us",
+		   dwc2_seq_print, seq);
+
+	for (i = 0; i < ARRAY_SIZE(lists); i++) {
+		list_for_each_entry(qh, lists[i], qh_list_entry) {
+			seq_printf(seq,
+				   "QH=%p %s: %s %s speed %d, interval %d/%d, next %04x\n",
+				   qh, list_names[i],
+				   qh->ep_type == USB_ENDPOINT_XFER_ISOC ?
+				   "isoc" : "intr",
+				   qh->ep_is_in ? "in" : "out", qh->dev_speed,
+				   qh->host_interval, qh->device_interval,
+				   qh->next_active_frame);
+
+			for (j = 0; j < qh->num_hs_transfers; j++) {
+				struct dwc2_hs_transfer_time *trans_time =
+					qh->hs_transfers + j;
+
+				seq_printf(seq,
+					   "  HS #%d: %d us @ uFrame %d + %d us\n",
+					   j, trans_time->duration_us,
+					   trans_time->start_schedule_us /
+					   DWC2_HS_PERIODIC_US_PER_UFRAME,
+					   trans_time->start_schedule_us %
+					   DWC2_HS_PERIODIC_US_PER_UFRAME);
+			}
+
+			if (qh->schedule_low_speed)
+				seq_printf(seq,
+					   "  LS/FS: %d us @ %d us, map %p\n",
+					   qh->device_us,
+					   DWC2_US_PER_SLICE *
+					   qh->ls_start_schedule_slice,
+					   dwc2_get_ls_map(hsotg, qh));
+		}
+	}
+
+	spin_unlock_irqrestore(&hsotg->lock, flags);
+}
+
 /**
  * dwc2_ls_pmap_schedule() - Schedule a low speed QH
  *
@@ -1345,6 +1432,26 @@ static int dwc2_check_max_xfer_size(struct dwc2_hsotg *hsotg,
 	return status;
 }
 
+/**
+ * dwc2_note_periodic_inactive() - Account for a QH joining the inactive list
+ *
+ * Keeps hsotg->next_periodic_frame no later than the QH's next_active_frame
+ * so the SOF handler doesn't miss it.
+ *
+ * @hsotg: The HCD state structure for the DWC OTG controller
+ * @qh:    QH just placed on periodic_sched_inactive
+ */
+static void dwc2_note_periodic_inactive(struct dwc2_hsotg *hsotg,
+					struct dwc2_qh *qh)
+{
+	if (!hsotg->next_periodic_valid ||
+	    dwc2_frame_num_gt(hsotg->next_periodic_frame,
+			      qh->next_active_frame)) {
+		hsotg->next_periodic_frame = qh->next_active_frame;
+		hsotg->next_periodic_valid = true;
+	}
+}
+
 /**
  * dwc2_schedule_periodic() - Schedules an interrupt or isochronous transfer in
  * the periodic schedule
@@ -1399,10 +1506,12 @@ static int dwc2_schedule_periodic(struct dwc2_hsotg *hsotg, struct dwc2_qh *qh)
 	if (hsotg->params.dma_desc_enable)
 		/* Don't rely on SOF and start in ready schedule */
 		list_add_tail(&qh->qh_list_entry, &hsotg->periodic_sched_ready);
-	else
+	else {
 		/* Always start in inactive schedule */
 		list_add_tail(&qh->qh_list_entry,
 			      &hsotg->periodic_sched_inactive);
+		dwc2_note_periodic_inactive(hsotg, qh);
+	}
 
 	return 0;
 }
@@ -1793,6 +1902,8 @@ void dwc2_hcd_qh_unlink(struct dwc2_hsotg *hsotg, struct dwc2_qh *qh)
 
 	dwc2_deschedule_periodic(hsotg, qh);
 	hsotg->periodic_qh_count--;
+	if (!hsotg->periodic_qh_count)
+		hsotg->next_periodic_valid = false;
 	if (!hsotg->periodic_qh_count &&
 	    !hsotg->params.dma_desc_enable) {
 		intr_mask = dwc2_readl(hsotg, GINTMSK);
@@ -2024,12 +2135,14 @@ void dwc2_hcd_qh_deactivate(struct dwc2_hsotg *hsotg, struct dwc2_qh *qh,
 	 * Note: we purposely use the frame_number from the "hsotg" structure
 	 * since we know SOF interrupt will handle future frames.
 	 */
-	if (dwc2_frame_num_le(qh->next_active_frame, hsotg->frame_number))
+	if (dwc2_frame_num_le(qh->next_active_frame, hsotg->frame_number)) {
 		list_move_tail(&qh->qh_list_entry,
 			       &hsotg->periodic_sched_ready);
-	else
+	} else {
 		list_move_tail(&qh->qh_list_entry,
 			       &hsotg->periodic_sched_inactive);
+		dwc2_note_periodic_inactive(hsotg, qh);
+	}
 }
 
 /**
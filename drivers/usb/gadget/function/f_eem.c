@@ -19,6 +19,7 @@
 #include "u_eem.h"
 
 #define EEM_HLEN 2
+#define EEM_TX_MAX_FRAMES 10
 
 /*
  * This function is a "CDC Ethernet Emulation Model" (CDC EEM)
@@ -329,9 +330,8 @@ static void eem_cmd_complete(struct usb_ep *ep, struct usb_request *req)
 }
 
 /*
- * Add the EEM header and ethernet checksum.
- * We currently do not attempt to put multiple ethernet frames
- * into a single USB transfer
+ * Add the EEM header and ethernet checksum.  u_ether may then put
+ * several of these back to back into a single USB transfer.
  */
 static struct sk_buff *eem_wrap(struct gether *port, struct sk_buff *skb)
 {
@@ -640,6 +640,13 @@ static struct usb_function *eem_alloc(struct usb_function_instance *fi)
 	eem->port.unwrap = eem_unwrap;
 	eem->port.header_len = EEM_HLEN;
 
+	/* several EEM packets may share a transfer, as long as the host
+	 * never sees more than the one full-size frame it must accept
+	 */
+	eem->port.tx_max_frames = EEM_TX_MAX_FRAMES;
+	eem->port.tx_max_overhead = EEM_HLEN + ETH_FCS_LEN + EEM_HLEN;
+	eem->port.tx_max_xfer = ETH_FRAME_LEN + EEM_HLEN + ETH_FCS_LEN;
+
 	return &eem->port.func;
 }
 
@@ -15,10 +15,13 @@
 /* #define VERBOSE_DEBUG */
 
 #include <linux/blkdev.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
 #include <linux/pagemap.h>
 #include <linux/export.h>
 #include <linux/hid.h>
 #include <linux/module.h>
+#include <linux/reservation.h>
 #include <linux/sched/signal.h>
 #include <linux/uio.h>
 #include <asm/unaligned.h>
@@ -188,6 +191,10 @@ struct ffs_epfile {
 	struct ffs_buffer		*read_buffer;
 #define READ_BUFFER_DROP ((struct ffs_buffer *)ERR_PTR(-ESHUTDOWN))
 
+	/* dma-bufs attached with FUNCTIONFS_DMABUF_ATTACH */
+	struct mutex			dmabufs_mutex;
+	struct list_head		dmabufs;	/* P: dmabufs_mutex */
+
 	char				name[5];
 
 	unsigned char			in;	/* P: ffs->eps_lock */
@@ -214,7 +221,7 @@ struct ffs_io_data {
 	char *buf;
 
 	struct mm_struct *mm;
-	struct work_struct work;
+	struct llist_node node;
 
 	struct usb_ep *ep;
 	struct usb_request *req;
@@ -749,10 +756,9 @@ static ssize_t ffs_copy_to_iter(void *data, int data_len, struct iov_iter *iter)
 	return ret;
 }
 
-static void ffs_user_copy_worker(struct work_struct *work)
+/* Returns true if the ffs eventfd should be signalled for this request */
+static bool ffs_user_copy(struct ffs_io_data *io_data)
 {
-	struct ffs_io_data *io_data = container_of(work, struct ffs_io_data,
-						   work);
 	int ret = io_data->req->status ? io_data->req->status :
 					 io_data->req->actual;
 	bool kiocb_has_eventfd = io_data->kiocb->ki_flags & IOCB_EVENTFD;
@@ -769,15 +775,35 @@ static void ffs_user_copy_worker(struct work_struct *work)
 
 	io_data->kiocb->ki_complete(io_data->kiocb, ret, ret);
 
-	if (io_data->ffs->ffs_eventfd && !kiocb_has_eventfd)
-		eventfd_signal(io_data->ffs->ffs_eventfd, 1);
-
 	usb_ep_free_request(io_data->ep, io_data->req);
 
 	if (io_data->read)
 		kfree(io_data->to_free);
 	kfree(io_data->buf);
 	kfree(io_data);
+
+	return !kiocb_has_eventfd;
+}
+
+static void ffs_user_copy_worker(struct work_struct *work)
+{
+	struct ffs_data *ffs = container_of(work, struct ffs_data,
+					    io_done_work);
+	struct ffs_io_data *io_data, *next;
+	struct llist_node *done;
+	unsigned events = 0;
+
+	/*
+	 * Reap everything completed since the last run in one go, oldest
+	 * first, and wake the eventfd once for the whole batch.
+	 */
+	done = llist_reverse_order(llist_del_all(&ffs->io_done));
+	llist_for_each_entry_safe(io_data, next, done, node)
+		if (ffs_user_copy(io_data))
+			++events;
+
+	if (ffs->ffs_eventfd && events)
+		eventfd_signal(ffs->ffs_eventfd, events);
 }
 
 static void ffs_epfile_async_io_complete(struct usb_ep *_ep,
@@ -788,8 +814,8 @@ static void ffs_epfile_async_io_complete(struct usb_ep *_ep,
 
 	ENTER();
 
-	INIT_WORK(&io_data->work, ffs_user_copy_worker);
-	queue_work(ffs->io_completion_wq, &io_data->work);
+	if (llist_add(&io_data->node, &ffs->io_done))
+		queue_work(ffs->io_completion_wq, &ffs->io_done_work);
 }
 
 static void __ffs_epfile_read_buffer_free(struct ffs_epfile *epfile)
@@ -1181,13 +1207,358 @@ static ssize_t ffs_epfile_read_iter(struct kiocb *kiocb, struct iov_iter *to)
 	return res;
 }
 
+/* dma-buf zero-copy transfers *********************************************/
+
+struct ffs_dmabuf_priv {
+	struct list_head entry;
+	struct kref ref;
+	struct ffs_data *ffs;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+
+	/* fence timeline; seqno is P: epfile->mutex */
+	spinlock_t lock;
+	u64 context;
+	unsigned seqno;
+};
+
+struct ffs_dma_fence {
+	struct dma_fence base;
+	struct ffs_dmabuf_priv *priv;
+	struct work_struct work;
+};
+
+static void ffs_dmabuf_release(struct kref *ref)
+{
+	struct ffs_dmabuf_priv *priv = container_of(ref, struct ffs_dmabuf_priv,
+						    ref);
+	struct dma_buf_attachment *attach = priv->attach;
+	struct dma_buf *dmabuf = attach->dmabuf;
+
+	dma_buf_unmap_attachment(attach, priv->sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(dmabuf, attach);
+	dma_buf_put(dmabuf);
+	kfree(priv);
+}
+
+static void ffs_dmabuf_put(struct ffs_dmabuf_priv *priv)
+{
+	kref_put(&priv->ref, ffs_dmabuf_release);
+}
+
+/* Called with epfile->dmabufs_mutex held */
+static struct ffs_dmabuf_priv *
+ffs_dmabuf_find(struct ffs_epfile *epfile, struct dma_buf *dmabuf)
+{
+	struct ffs_dmabuf_priv *priv;
+
+	list_for_each_entry(priv, &epfile->dmabufs, entry)
+		if (priv->attach->dmabuf == dmabuf)
+			return priv;
+
+	return NULL;
+}
+
+static const char *ffs_dmabuf_get_driver_name(struct dma_fence *fence)
+{
+	return "functionfs";
+}
+
+static const char *ffs_dmabuf_get_timeline_name(struct dma_fence *fence)
+{
+	return "";
+}
+
+static const struct dma_fence_ops ffs_dmabuf_fence_ops = {
+	.get_driver_name	= ffs_dmabuf_get_driver_name,
+	.get_timeline_name	= ffs_dmabuf_get_timeline_name,
+};
+
+static void ffs_dmabuf_cleanup(struct work_struct *work)
+{
+	struct ffs_dma_fence *fence = container_of(work, struct ffs_dma_fence,
+						   work);
+
+	/* may unmap and detach, so not from the completion handler */
+	ffs_dmabuf_put(fence->priv);
+	dma_fence_put(&fence->base);
+}
+
+static void ffs_dmabuf_signal_done(struct ffs_dma_fence *fence, int ret)
+{
+	struct ffs_data *ffs = fence->priv->ffs;
+
+	if (ret < 0)
+		dma_fence_set_error(&fence->base, ret);
+	dma_fence_signal(&fence->base);
+
+	INIT_WORK(&fence->work, ffs_dmabuf_cleanup);
+	queue_work(ffs->io_completion_wq, &fence->work);
+}
+
+static void ffs_epfile_dmabuf_io_complete(struct usb_ep *ep,
+					  struct usb_request *req)
+{
+	ENTER();
+
+	ffs_dmabuf_signal_done(req->context, req->status);
+	usb_ep_free_request(ep, req);
+}
+
+static int ffs_dmabuf_attach(struct file *file, int fd)
+{
+	struct ffs_epfile *epfile = file->private_data;
+	struct usb_gadget *gadget = epfile->ffs->gadget;
+	struct dma_buf_attachment *attach;
+	struct ffs_dmabuf_priv *priv;
+	struct dma_buf *dmabuf;
+	int ret;
+
+	if (!gadget)
+		return -ENODEV;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	attach = dma_buf_attach(dmabuf, gadget->dev.parent);
+	if (IS_ERR(attach)) {
+		ret = PTR_ERR(attach);
+		goto err_dmabuf_put;
+	}
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (!priv) {
+		ret = -ENOMEM;
+		goto err_detach;
+	}
+
+	/*
+	 * Map once for as long as the buffer stays attached; which way
+	 * the data goes is only known per transfer.
+	 */
+	priv->sgt = dma_buf_map_attachment(attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(priv->sgt)) {
+		ret = PTR_ERR(priv->sgt);
+		goto err_free_priv;
+	}
+
+	/* without SG support the controller needs one contiguous range */
+	if (!gadget->sg_supported && priv->sgt->nents != 1) {
+		ret = -EINVAL;
+		goto err_unmap;
+	}
+
+	priv->ffs = epfile->ffs;
+	priv->attach = attach;
+	kref_init(&priv->ref);
+	spin_lock_init(&priv->lock);
+	priv->context = dma_fence_context_alloc(1);
+
+	mutex_lock(&epfile->dmabufs_mutex);
+	if (ffs_dmabuf_find(epfile, dmabuf)) {
+		mutex_unlock(&epfile->dmabufs_mutex);
+		ret = -EEXIST;
+		goto err_unmap;
+	}
+	list_add(&priv->entry, &epfile->dmabufs);
+	mutex_unlock(&epfile->dmabufs_mutex);
+
+	return 0;
+
+err_unmap:
+	dma_buf_unmap_attachment(attach, priv->sgt, DMA_BIDIRECTIONAL);
+err_free_priv:
+	kfree(priv);
+err_detach:
+	dma_buf_detach(dmabuf, attach);
+err_dmabuf_put:
+	dma_buf_put(dmabuf);
+	return ret;
+}
+
+static int ffs_dmabuf_detach(struct file *file, int fd)
+{
+	struct ffs_epfile *epfile = file->private_data;
+	struct ffs_dmabuf_priv *priv;
+	struct dma_buf *dmabuf;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	mutex_lock(&epfile->dmabufs_mutex);
+	priv = ffs_dmabuf_find(epfile, dmabuf);
+	if (priv)
+		list_del(&priv->entry);
+	mutex_unlock(&epfile->dmabufs_mutex);
+
+	dma_buf_put(dmabuf);
+	if (!priv)
+		return -ENOENT;
+
+	/* transfers still in flight hold their own references */
+	ffs_dmabuf_put(priv);
+	return 0;
+}
+
+/* Number of DMA segments needed to cover the first @length bytes */
+static unsigned ffs_dmabuf_nents(struct sg_table *sgt, u64 length)
+{
+	struct scatterlist *sg;
+	unsigned i;
+
+	for_each_sg(sgt->sgl, sg, sgt->nents, i) {
+		if (length <= sg_dma_len(sg))
+			return i + 1;
+		length -= sg_dma_len(sg);
+	}
+
+	return sgt->nents;
+}
+
+static int ffs_dmabuf_transfer(struct file *file, struct ffs_ep *ep,
+			       const struct usb_ffs_dmabuf_transfer_req *req)
+{
+	struct ffs_epfile *epfile = file->private_data;
+	struct usb_gadget *gadget = epfile->ffs->gadget;
+	struct reservation_object *resv;
+	struct ffs_dmabuf_priv *priv;
+	struct ffs_dma_fence *fence;
+	struct usb_request *usb_req;
+	struct dma_buf *dmabuf;
+	bool in;
+	int ret;
+
+	if (req->flags)
+		return -EINVAL;
+
+	dmabuf = dma_buf_get(req->fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	if (!req->length || req->length > dmabuf->size) {
+		ret = -EINVAL;
+		goto err_dmabuf_put;
+	}
+
+	mutex_lock(&epfile->dmabufs_mutex);
+	priv = ffs_dmabuf_find(epfile, dmabuf);
+	if (priv)
+		kref_get(&priv->ref);
+	mutex_unlock(&epfile->dmabufs_mutex);
+	if (!priv) {
+		ret = -ENOENT;
+		goto err_dmabuf_put;
+	}
+
+	/* serialises seqno, and transfers against ordinary I/O */
+	ret = ffs_mutex_lock(&epfile->mutex, file->f_flags & O_NONBLOCK);
+	if (unlikely(ret))
+		goto err_priv_put;
+
+	/* the buffer belongs to whoever's fences are still pending */
+	resv = dmabuf->resv;
+	if (!reservation_object_test_signaled_rcu(resv, true)) {
+		ret = -EBUSY;
+		goto err_mutex;
+	}
+
+	fence = kmalloc(sizeof(*fence), GFP_KERNEL);
+	if (!fence) {
+		ret = -ENOMEM;
+		goto err_mutex;
+	}
+	fence->priv = priv;
+
+	spin_lock_irq(&epfile->ffs->eps_lock);
+	/* In the meantime, endpoint got disabled or changed. */
+	if (epfile->ep != ep) {
+		spin_unlock_irq(&epfile->ffs->eps_lock);
+		ret = -ESHUTDOWN;
+		goto err_free_fence;
+	}
+	in = epfile->in;
+	usb_req = usb_ep_alloc_request(ep->ep, GFP_ATOMIC);
+	spin_unlock_irq(&epfile->ffs->eps_lock);
+	if (!usb_req) {
+		ret = -ENOMEM;
+		goto err_free_fence;
+	}
+
+	dma_fence_init(&fence->base, &ffs_dmabuf_fence_ops, &priv->lock,
+		       priv->context, ++priv->seqno);
+
+	/* the fence owns priv from here, and is dropped once signalled */
+	reservation_object_lock(resv, NULL);
+	if (in) {
+		ret = reservation_object_reserve_shared(resv);
+		if (!ret)
+			reservation_object_add_shared_fence(resv, &fence->base);
+	} else {
+		reservation_object_add_excl_fence(resv, &fence->base);
+	}
+	reservation_object_unlock(resv);
+	if (ret)
+		goto err_fence_done;
+
+	usb_req->length = req->length;
+	if (gadget->sg_supported) {
+		usb_req->sg = priv->sgt->sgl;
+		usb_req->num_sgs = ffs_dmabuf_nents(priv->sgt, req->length);
+	} else {
+		usb_req->dma = sg_dma_address(priv->sgt->sgl);
+	}
+	usb_req->sg_was_mapped = 1;
+	usb_req->context = fence;
+	usb_req->complete = ffs_epfile_dmabuf_io_complete;
+
+	spin_lock_irq(&epfile->ffs->eps_lock);
+	if (epfile->ep != ep)
+		ret = -ESHUTDOWN;
+	else
+		ret = usb_ep_queue(ep->ep, usb_req, GFP_ATOMIC);
+	spin_unlock_irq(&epfile->ffs->eps_lock);
+	if (ret)
+		goto err_fence_done;
+
+	mutex_unlock(&epfile->mutex);
+	dma_buf_put(dmabuf);
+	return 0;
+
+err_fence_done:
+	usb_ep_free_request(ep->ep, usb_req);
+	ffs_dmabuf_signal_done(fence, ret);
+	mutex_unlock(&epfile->mutex);
+	dma_buf_put(dmabuf);
+	return ret;
+
+err_free_fence:
+	kfree(fence);
+err_mutex:
+	mutex_unlock(&epfile->mutex);
+err_priv_put:
+	ffs_dmabuf_put(priv);
+err_dmabuf_put:
+	dma_buf_put(dmabuf);
+	return ret;
+}
+
 static int
 ffs_epfile_release(struct inode *inode, struct file *file)
 {
 	struct ffs_epfile *epfile = inode->i_private;
+	struct ffs_dmabuf_priv *priv, *tmp;
 
 	ENTER();
 
+	mutex_lock(&epfile->dmabufs_mutex);
+	list_for_each_entry_safe(priv, tmp, &epfile->dmabufs, entry) {
+		list_del(&priv->entry);
+		ffs_dmabuf_put(priv);
+	}
+	mutex_unlock(&epfile->dmabufs_mutex);
+
 	__ffs_epfile_read_buffer_free(epfile);
 	ffs_data_closed(epfile->ffs);
 
@@ -1206,6 +1577,21 @@ static long ffs_epfile_ioctl(struct file *file, unsigned code,
 	if (WARN_ON(epfile->ffs->state != FFS_ACTIVE))
 		return -ENODEV;
 
+	switch (code) {
+	case FUNCTIONFS_DMABUF_ATTACH:
+	case FUNCTIONFS_DMABUF_DETACH:
+	{
+		int fd;
+
+		if (copy_from_user(&fd, (void __user *)value, sizeof(fd)))
+			return -EFAULT;
+
+		if (code == FUNCTIONFS_DMABUF_ATTACH)
+			return ffs_dmabuf_attach(file, fd);
+		return ffs_dmabuf_detach(file, fd);
+	}
+	}
+
 	/* Wait for endpoint to be enabled */
 	ep = epfile->ep;
 	if (!ep) {
@@ -1218,6 +1604,15 @@ static long ffs_epfile_ioctl(struct file *file, unsigned code,
 			return -EINTR;
 	}
 
+	if (code == FUNCTIONFS_DMABUF_TRANSFER) {
+		struct usb_ffs_dmabuf_transfer_req req;
+
+		if (copy_from_user(&req, (void __user *)value, sizeof(req)))
+			return -EFAULT;
+
+		return ffs_dmabuf_transfer(file, ep, &req);
+	}
+
 	spin_lock_irq(&epfile->ffs->eps_lock);
 
 	/* In the meantime, endpoint got disabled or changed. */
@@ -1685,6 +2080,8 @@ static struct ffs_data *ffs_data_new(const char *dev_name)
 	init_waitqueue_head(&ffs->ev.waitq);
 	init_waitqueue_head(&ffs->wait);
 	init_completion(&ffs->ep0req_completion);
+	init_llist_head(&ffs->io_done);
+	INIT_WORK(&ffs->io_done_work, ffs_user_copy_worker);
 
 	/* XXX REVISIT need to update it in some places, or do we? */
 	ffs->ev.can_stall = 1;
@@ -1809,6 +2206,8 @@ static int ffs_epfiles_create(struct ffs_data *ffs)
 	for (i = 1; i <= count; ++i, ++epfile) {
 		epfile->ffs = ffs;
 		mutex_init(&epfile->mutex);
+		mutex_init(&epfile->dmabufs_mutex);
+		INIT_LIST_HEAD(&epfile->dmabufs);
 		if (ffs->user_flags & FUNCTIONFS_VIRTUAL_ADDR)
 			sprintf(epfile->name, "ep%02x", ffs->eps_addrmap[i]);
 		else
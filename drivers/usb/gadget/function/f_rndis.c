@@ -103,6 +103,12 @@ static unsigned int bitrate(struct usb_gadget *g)
 #define RNDIS_STATUS_INTERVAL_MS	32
 #define STATUS_BYTECOUNT		8	/* 8 bytes data */
 
+/* IN transfers may carry several packet messages, up to the host's
+ * MaxTransferSize; keep the aggregate within one 8k allocation.
+ */
+#define RNDIS_TX_MAX_FRAMES		10
+#define RNDIS_TX_MAX_XFER		SKB_WITH_OVERHEAD(8192)
+
 
 /* interface descriptor: */
 
@@ -456,6 +462,13 @@ static void rndis_command_complete(struct usb_ep *ep, struct usb_request *req)
 	if (status < 0)
 		pr_err("RNDIS command error %d, %d/%d\n",
 			status, req->actual, req->length);
+
+	/* nothing is aggregated until the host says how much it takes;
+	 * one byte stays free for the short-packet pad u_ether adds
+	 */
+	rndis->port.tx_max_xfer = min_t(u32, RNDIS_TX_MAX_XFER,
+			rndis->params->host_max_transfer ?
+			rndis->params->host_max_transfer - 1 : 0);
 //	spin_unlock(&dev->lock);
 }
 
@@ -574,6 +587,7 @@ static int rndis_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 
 		/* Avoid ZLPs; they can be troublesome. */
 		rndis->port.is_zlp_ok = false;
+		rndis->port.tx_max_xfer = 0;
 
 		/* RNDIS should be in the "RNDIS uninitialized" state,
 		 * either never activated or after rndis_uninit().
@@ -1003,6 +1017,8 @@ static struct usb_function *rndis_alloc(struct usb_function_instance *fi)
 
 	/* RNDIS has special (and complex) framing */
 	rndis->port.header_len = sizeof(struct rndis_packet_msg_type);
+	rndis->port.tx_max_frames = RNDIS_TX_MAX_FRAMES;
+	rndis->port.tx_max_overhead = sizeof(struct rndis_packet_msg_type);
 	rndis->port.wrap = rndis_add_header;
 	rndis->port.unwrap = rndis_rm_hdr;
 
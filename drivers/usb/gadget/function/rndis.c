@@ -566,6 +566,9 @@ static int rndis_init_response(struct rndis_params *params,
 		return -ENOMEM;
 	resp = (rndis_init_cmplt_type *)r->buf;
 
+	/* the most we may send the host in one transfer */
+	params->host_max_transfer = get_unaligned_le32(&buf->MaxTransferSize);
+
 	resp->MessageType = cpu_to_le32(RNDIS_MSG_INIT_C);
 	resp->MessageLength = cpu_to_le32(52);
 	resp->RequestID = buf->RequestID; /* Still LE in msg buffer */
@@ -768,6 +771,7 @@ void rndis_uninit(struct rndis_params *params)
 	if (!params)
 		return;
 	params->state = RNDIS_UNINITIALIZED;
+	params->host_max_transfer = 0;
 
 	/* drain the response queue */
 	while ((buf = rndis_get_next_response(params, &length)))
@@ -816,6 +820,7 @@ int rndis_msg_parser(struct rndis_params *params, u8 *buf)
 		pr_debug("%s: RNDIS_MSG_HALT\n",
 			__func__);
 		params->state = RNDIS_UNINITIALIZED;
+		params->host_max_transfer = 0;
 		if (params->dev) {
 			netif_carrier_off(params->dev);
 			netif_stop_queue(params->dev);
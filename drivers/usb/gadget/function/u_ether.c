@@ -61,8 +61,10 @@ struct eth_dev {
 	spinlock_t		req_lock;	/* guard {rx,tx}_reqs */
 	struct list_head	tx_reqs, rx_reqs;
 	atomic_t		tx_qlen;
+	struct sk_buff		*tx_agg;	/* frames held back, req_lock */
 
 	struct sk_buff_head	rx_frames;
+	struct napi_struct	napi;
 
 	unsigned		qmult;
 
@@ -89,6 +91,15 @@ struct eth_dev {
 
 #define DEFAULT_QLEN	2	/* double buffering by default */
 
+#define GETHER_NAPI_WEIGHT	64
+
+/* frames carried by a queued TX skb; more than one once aggregated */
+struct eth_tx_cb {
+	unsigned		frames;
+};
+
+#define ETH_TX_CB(skb)	((struct eth_tx_cb *)(skb)->cb)
+
 /* for dual-speed hardware, use deeper queues at high/super speed */
 static inline int qlen(struct usb_gadget *gadget, unsigned qmult)
 {
@@ -255,53 +266,51 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 	struct sk_buff	*skb = req->context, *skb2;
 	struct eth_dev	*dev = ep->driver_data;
 	int		status = req->status;
+	struct sk_buff_head frames;
+	unsigned long	flags;
 
 	switch (status) {
 
 	/* normal completion */
 	case 0:
 		skb_put(skb, req->actual);
+		skb_queue_head_init(&frames);
 
 		if (dev->unwrap) {
-			unsigned long	flags;
-
 			spin_lock_irqsave(&dev->lock, flags);
 			if (dev->port_usb) {
 				status = dev->unwrap(dev->port_usb,
 							skb,
-							&dev->rx_frames);
+							&frames);
 			} else {
 				dev_kfree_skb_any(skb);
 				status = -ENOTCONN;
 			}
 			spin_unlock_irqrestore(&dev->lock, flags);
 		} else {
-			skb_queue_tail(&dev->rx_frames, skb);
+			__skb_queue_tail(&frames, skb);
 		}
 		skb = NULL;
 
-		skb2 = skb_dequeue(&dev->rx_frames);
-		while (skb2) {
-			if (status < 0
-					|| ETH_HLEN > skb2->len
-					|| skb2->len > GETHER_MAX_ETH_FRAME_LEN) {
+		if (status < 0) {
+			while ((skb2 = __skb_dequeue(&frames))) {
 				dev->net->stats.rx_errors++;
 				dev->net->stats.rx_length_errors++;
 				DBG(dev, "rx length %d\n", skb2->len);
 				dev_kfree_skb_any(skb2);
-				goto next_frame;
 			}
-			skb2->protocol = eth_type_trans(skb2, dev->net);
-			dev->net->stats.rx_packets++;
-			dev->net->stats.rx_bytes += skb2->len;
+			break;
+		}
 
-			/* no buffer copies needed, unless hardware can't
-			 * use skb buffers.
-			 */
-			status = netif_rx(skb2);
-next_frame:
-			skb2 = skb_dequeue(&dev->rx_frames);
+		/* hand the frames to gether_poll(), which can feed GRO */
+		if (netif_running(dev->net)) {
+			spin_lock_irqsave(&dev->rx_frames.lock, flags);
+			skb_queue_splice_tail_init(&frames, &dev->rx_frames);
+			spin_unlock_irqrestore(&dev->rx_frames.lock, flags);
+			napi_schedule(&dev->napi);
 		}
+		while ((skb2 = __skb_dequeue(&frames)))
+			dev_kfree_skb_any(skb2);
 		break;
 
 	/* software-driven interface shutdown */
@@ -342,6 +351,41 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 		rx_submit(dev, req, GFP_ATOMIC);
 }
 
+static int gether_poll(struct napi_struct *napi, int budget)
+{
+	struct eth_dev	*dev = container_of(napi, struct eth_dev, napi);
+	struct sk_buff	*skb;
+	int		work_done = 0;
+
+	while (work_done < budget) {
+		skb = skb_dequeue(&dev->rx_frames);
+		if (!skb)
+			break;
+		work_done++;
+
+		if (ETH_HLEN > skb->len
+				|| skb->len > GETHER_MAX_ETH_FRAME_LEN) {
+			dev->net->stats.rx_errors++;
+			dev->net->stats.rx_length_errors++;
+			DBG(dev, "rx length %d\n", skb->len);
+			dev_kfree_skb_any(skb);
+			continue;
+		}
+		skb->protocol = eth_type_trans(skb, dev->net);
+		dev->net->stats.rx_packets++;
+		dev->net->stats.rx_bytes += skb->len;
+
+		napi_gro_receive(napi, skb);
+	}
+
+	if (work_done < budget && napi_complete_done(napi, work_done) &&
+	    !skb_queue_empty(&dev->rx_frames))
+		/* rx_complete() queued more after our last look */
+		napi_schedule(napi);
+
+	return work_done;
+}
+
 static int prealloc(struct list_head *list, struct usb_ep *ep, unsigned n)
 {
 	unsigned		i;
@@ -435,10 +479,191 @@ static void eth_work(struct work_struct *work)
 		DBG(dev, "work done, flags = 0x%lx\n", dev->todo);
 }
 
+static void tx_complete(struct usb_ep *ep, struct usb_request *req);
+
+static int eth_queue_tx(struct eth_dev *dev, struct usb_ep *in,
+			struct usb_request *req, struct sk_buff *skb)
+{
+	int	length = skb->len;
+	int	retval;
+
+	req->buf = skb->data;
+	req->context = skb;
+	req->complete = tx_complete;
+
+	/* NCM requires no zlp if transfer is dwNtbInMaxSize */
+	if (dev->port_usb &&
+	    dev->port_usb->is_fixed &&
+	    length == dev->port_usb->fixed_in_len &&
+	    (length % in->maxpacket) == 0)
+		req->zero = 0;
+	else
+		req->zero = 1;
+
+	/* use zlp framing on tx for strict CDC-Ether conformance,
+	 * though any robust network rx path ignores extra padding.
+	 * and some hardware doesn't like to write zlps.
+	 */
+	if (req->zero && !dev->zlp && (length % in->maxpacket) == 0)
+		length++;
+
+	req->length = length;
+
+	retval = usb_ep_queue(in, req, GFP_ATOMIC);
+	switch (retval) {
+	default:
+		DBG(dev, "tx queue err %d\n", retval);
+		break;
+	case 0:
+		netif_trans_update(dev->net);
+		atomic_inc(&dev->tx_qlen);
+	}
+	return retval;
+}
+
+static void eth_tx_agg_send(struct eth_dev *dev, struct usb_ep *in,
+			    struct usb_request *req, struct sk_buff *agg)
+{
+	unsigned long	flags;
+
+	if (!eth_queue_tx(dev, in, req, agg))
+		return;
+
+	dev->net->stats.tx_dropped += ETH_TX_CB(agg)->frames;
+	dev_kfree_skb_any(agg);
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	list_add(&req->list, &dev->tx_reqs);
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+}
+
+static void eth_tx_agg_discard(struct eth_dev *dev)
+{
+	struct sk_buff	*agg;
+	unsigned long	flags;
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	agg = dev->tx_agg;
+	dev->tx_agg = NULL;
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	if (agg) {
+		dev->net->stats.tx_dropped += ETH_TX_CB(agg)->frames;
+		dev_kfree_skb_any(agg);
+	}
+}
+
+/* Send the frames held back in dev->tx_agg if another @len bytes no
+ * longer fit behind them, so that frames still leave in order.
+ */
+static int eth_tx_agg_make_room(struct eth_dev *dev, struct usb_ep *in,
+				unsigned len)
+{
+	struct usb_request	*req;
+	struct sk_buff		*agg;
+	unsigned long		flags;
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	agg = dev->tx_agg;
+	if (!agg || skb_tailroom(agg) >= len) {
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return 0;
+	}
+	if (list_empty(&dev->tx_reqs)) {
+		netif_stop_queue(dev->net);
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		return -EBUSY;
+	}
+	req = list_first_entry(&dev->tx_reqs, struct usb_request, list);
+	list_del(&req->list);
+	dev->tx_agg = NULL;
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	eth_tx_agg_send(dev, in, req, agg);
+	return 0;
+}
+
+/*
+ * Pack wrapped frames back to back into one IN transfer, for framings
+ * which allow that.  A frame still goes out at once while the endpoint
+ * is idle; only while earlier transfers are in flight are frames held
+ * back in dev->tx_agg, to leave with the next completion or once the
+ * aggregate is full.  So an idle link sees no added latency, and a busy
+ * one (TCP ACKs, small UDP) costs far fewer requests and interrupts.
+ */
+static netdev_tx_t eth_xmit_agg(struct eth_dev *dev, struct sk_buff *skb,
+				struct usb_ep *in, unsigned len,
+				u32 max_frames, u32 max_xfer)
+{
+	struct usb_request	*req = NULL;
+	struct sk_buff		*agg;
+	unsigned long		flags;
+
+	if (eth_tx_agg_make_room(dev, in, len))
+		return NETDEV_TX_BUSY;
+
+	if (dev->wrap) {
+		spin_lock_irqsave(&dev->lock, flags);
+		if (dev->port_usb)
+			skb = dev->wrap(dev->port_usb, skb);
+		spin_unlock_irqrestore(&dev->lock, flags);
+		if (!skb)
+			goto drop;
+	}
+
+	spin_lock_irqsave(&dev->req_lock, flags);
+	agg = dev->tx_agg;
+	if (!agg) {
+		agg = alloc_skb(max_xfer, GFP_ATOMIC);
+		if (!agg) {
+			spin_unlock_irqrestore(&dev->req_lock, flags);
+			dev_kfree_skb_any(skb);
+			goto drop;
+		}
+		ETH_TX_CB(agg)->frames = 0;
+		dev->tx_agg = agg;
+	}
+
+	/* wrap() overran the tx_max_overhead its link promised */
+	if (WARN_ON_ONCE(skb_tailroom(agg) < skb->len)) {
+		spin_unlock_irqrestore(&dev->req_lock, flags);
+		dev_kfree_skb_any(skb);
+		goto drop;
+	}
+	skb_put_data(agg, skb->data, skb->len);
+	ETH_TX_CB(agg)->frames++;
+	dev_consume_skb_any(skb);
+
+	if (ETH_TX_CB(agg)->frames >= max_frames ||
+	    !atomic_read(&dev->tx_qlen)) {
+		if (!list_empty(&dev->tx_reqs)) {
+			req = list_first_entry(&dev->tx_reqs,
+					       struct usb_request, list);
+			list_del(&req->list);
+			dev->tx_agg = NULL;
+		} else {
+			/* full, and every request is in flight */
+			netif_stop_queue(dev->net);
+		}
+	}
+	spin_unlock_irqrestore(&dev->req_lock, flags);
+
+	if (req)
+		eth_tx_agg_send(dev, in, req, agg);
+	return NETDEV_TX_OK;
+
+drop:
+	dev->net->stats.tx_dropped++;
+	return NETDEV_TX_OK;
+}
+
 static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	struct sk_buff	*skb = req->context;
 	struct eth_dev	*dev = ep->driver_data;
+	struct sk_buff	*agg = NULL;
+
+	dev->net->stats.tx_packets += ETH_TX_CB(skb)->frames;
 
 	switch (req->status) {
 	default:
@@ -453,13 +678,25 @@ static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 		dev->net->stats.tx_bytes += skb->len;
 		dev_consume_skb_any(skb);
 	}
-	dev->net->stats.tx_packets++;
 
 	spin_lock(&dev->req_lock);
-	list_add(&req->list, &dev->tx_reqs);
+	/* frames held back while this transfer was in flight go next,
+	 * unless the endpoint is being shut down under us; tx_qlen drops
+	 * under the lock so eth_xmit_agg() never holds back frames that
+	 * no completion is left to send
+	 */
+	atomic_dec(&dev->tx_qlen);
+	if (req->status != -ECONNRESET && req->status != -ESHUTDOWN &&
+	    dev->tx_agg) {
+		agg = dev->tx_agg;
+		dev->tx_agg = NULL;
+	} else {
+		list_add(&req->list, &dev->tx_reqs);
+	}
 	spin_unlock(&dev->req_lock);
 
-	atomic_dec(&dev->tx_qlen);
+	if (agg)
+		eth_tx_agg_send(dev, ep, req, agg);
 	if (netif_carrier_ok(dev->net))
 		netif_wake_queue(dev->net);
 }
@@ -479,11 +716,15 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 	unsigned long		flags;
 	struct usb_ep		*in;
 	u16			cdc_filter;
+	u32			max_frames = 0, max_overhead = 0, max_xfer = 0;
 
 	spin_lock_irqsave(&dev->lock, flags);
 	if (dev->port_usb) {
 		in = dev->port_usb->in_ep;
 		cdc_filter = dev->port_usb->cdc_filter;
+		max_frames = dev->port_usb->tx_max_frames;
+		max_overhead = dev->port_usb->tx_max_overhead;
+		max_xfer = dev->port_usb->tx_max_xfer;
 	} else {
 		in = NULL;
 		cdc_filter = 0;
@@ -517,6 +758,17 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		/* ignores USB_CDC_PACKET_TYPE_DIRECTED */
 	}
 
+	if (skb && max_frames > 1) {
+		length = skb->len + max_overhead;
+		if (length <= max_xfer)
+			return eth_xmit_agg(dev, skb, in, length,
+					    max_frames, max_xfer);
+
+		/* too big to share a transfer; keep it behind the others */
+		if (eth_tx_agg_make_room(dev, in, UINT_MAX))
+			return NETDEV_TX_BUSY;
+	}
+
 	spin_lock_irqsave(&dev->req_lock, flags);
 	/*
 	 * this freelist can be empty if an interrupt triggered disconnect()
@@ -558,39 +810,8 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		}
 	}
 
-	length = skb->len;
-	req->buf = skb->data;
-	req->context = skb;
-	req->complete = tx_complete;
-
-	/* NCM requires no zlp if transfer is dwNtbInMaxSize */
-	if (dev->port_usb &&
-	    dev->port_usb->is_fixed &&
-	    length == dev->port_usb->fixed_in_len &&
-	    (length % in->maxpacket) == 0)
-		req->zero = 0;
-	else
-		req->zero = 1;
-
-	/* use zlp framing on tx for strict CDC-Ether conformance,
-	 * though any robust network rx path ignores extra padding.
-	 * and some hardware doesn't like to write zlps.
-	 */
-	if (req->zero && !dev->zlp && (length % in->maxpacket) == 0)
-		length++;
-
-	req->length = length;
-
-	retval = usb_ep_queue(in, req, GFP_ATOMIC);
-	switch (retval) {
-	default:
-		DBG(dev, "tx queue err %d\n", retval);
-		break;
-	case 0:
-		netif_trans_update(net);
-		atomic_inc(&dev->tx_qlen);
-	}
-
+	ETH_TX_CB(skb)->frames = 1;
+	retval = eth_queue_tx(dev, in, req, skb);
 	if (retval) {
 		dev_kfree_skb_any(skb);
 drop:
@@ -625,6 +846,7 @@ static int eth_open(struct net_device *net)
 	struct gether	*link;
 
 	DBG(dev, "%s\n", __func__);
+	napi_enable(&dev->napi);
 	if (netif_carrier_ok(dev->net))
 		eth_start(dev, GFP_KERNEL);
 
@@ -683,6 +905,10 @@ static int eth_stop(struct net_device *net)
 	}
 	spin_unlock_irqrestore(&dev->lock, flags);
 
+	napi_disable(&dev->napi);
+	skb_queue_purge(&dev->rx_frames);
+	eth_tx_agg_discard(dev);
+
 	return 0;
 }
 
@@ -764,6 +990,7 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
 	skb_queue_head_init(&dev->rx_frames);
+	netif_napi_add(net, &dev->napi, gether_poll, GETHER_NAPI_WEIGHT);
 
 	/* network device setup */
 	dev->net = net;
@@ -830,6 +1057,7 @@ struct net_device *gether_setup_name_default(const char *netname)
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
 	skb_queue_head_init(&dev->rx_frames);
+	netif_napi_add(net, &dev->napi, gether_poll, GETHER_NAPI_WEIGHT);
 
 	/* network device setup */
 	dev->net = net;
@@ -1153,6 +1381,7 @@ void gether_disconnect(struct gether *link)
 	}
 	spin_unlock(&dev->req_lock);
 	link->in_ep->desc = NULL;
+	eth_tx_agg_discard(dev);
 
 	usb_ep_disable(link->out_ep);
 	spin_lock(&dev->req_lock);
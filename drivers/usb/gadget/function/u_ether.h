@@ -16,7 +16,7 @@
 #include <linux/usb/cdc.h>
 #include <linux/netdevice.h>
 
-#define QMULT_DEFAULT 5
+#define QMULT_DEFAULT 10
 
 /*
  * dev_addr: initial value
@@ -70,6 +70,14 @@ struct gether {
 	u32				fixed_out_len;
 	u32				fixed_in_len;
 	bool				supports_multi_frame;
+	/* framings that allow several frames back to back in one IN
+	 * transfer (RNDIS, EEM) let u_ether pack up to tx_max_frames of
+	 * them, each grown by at most tx_max_overhead bytes of wrap(),
+	 * into transfers of at most tx_max_xfer bytes.
+	 */
+	u32				tx_max_frames;
+	u32				tx_max_overhead;
+	u32				tx_max_xfer;
 	struct sk_buff			*(*wrap)(struct gether *port,
 						struct sk_buff *skb);
 	int				(*unwrap)(struct gether *port,
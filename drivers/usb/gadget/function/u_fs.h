@@ -15,6 +15,7 @@
 
 #include <linux/usb/composite.h>
 #include <linux/list.h>
+#include <linux/llist.h>
 #include <linux/mutex.h>
 #include <linux/workqueue.h>
 #include <linux/refcount.h>
@@ -277,6 +278,9 @@ struct ffs_data {
 
 	struct eventfd_ctx *ffs_eventfd;
 	struct workqueue_struct *io_completion_wq;
+	/* finished AIO requests, reaped in batches by io_done_work */
+	struct llist_head io_done;
+	struct work_struct io_done_work;
 	bool no_disconnect;
 	struct work_struct reset_work;
 
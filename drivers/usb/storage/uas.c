@@ -9,6 +9,8 @@
  */
 
 #include <linux/blkdev.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/module.h>
@@ -31,6 +33,18 @@
 
 #define MAX_CMNDS 256
 
+/*
+ * Large enough for big sequential I/O in one command; sd still caps it
+ * by the MAXIMUM TRANSFER LENGTH from the device's Block Limits VPD page.
+ */
+#define UAS_MAX_SECTORS	2048
+
+struct uas_stream_stats {
+	u64 cmnds;
+	u64 bytes;
+	u64 errors;
+};
+
 struct uas_dev_info {
 	struct usb_interface *intf;
 	struct usb_device *udev;
@@ -46,6 +60,9 @@ struct uas_dev_info {
 	spinlock_t lock;
 	struct work_struct work;
 	struct work_struct scan_work;      /* for async scanning */
+	/* indexed by uas-tag - 1, i.e. by stream when use_streams */
+	struct uas_stream_stats stats[MAX_CMNDS];
+	struct dentry *debugfs;
 };
 
 enum {
@@ -94,6 +111,8 @@ static void uas_log_cmd_state(struct scsi_cmnd *cmnd, const char *prefix,
  */
 static struct workqueue_struct *workqueue;
 
+static struct dentry *uas_debug_root;
+
 static void uas_do_work(struct work_struct *work)
 {
 	struct uas_dev_info *devinfo =
@@ -243,6 +262,17 @@ static void uas_free_unsubmitted_urbs(struct scsi_cmnd *cmnd)
 		usb_free_urb(cmdinfo->data_out_urb);
 }
 
+static void uas_count_cmnd(struct uas_dev_info *devinfo,
+			   struct scsi_cmnd *cmnd, unsigned int uas_tag)
+{
+	struct uas_stream_stats *stats = &devinfo->stats[uas_tag - 1];
+
+	stats->cmnds++;
+	stats->bytes += scsi_bufflen(cmnd) - scsi_get_resid(cmnd);
+	if (cmnd->result)
+		stats->errors++;
+}
+
 static int uas_try_complete(struct scsi_cmnd *cmnd, const char *caller)
 {
 	struct uas_cmd_info *cmdinfo = (void *)&cmnd->SCp;
@@ -255,6 +285,7 @@ static int uas_try_complete(struct scsi_cmnd *cmnd, const char *caller)
 			      COMMAND_ABORTED))
 		return -EBUSY;
 	devinfo->cmnd[cmdinfo->uas_tag - 1] = NULL;
+	uas_count_cmnd(devinfo, cmnd, cmdinfo->uas_tag);
 	uas_free_unsubmitted_urbs(cmnd);
 	cmnd->scsi_done(cmnd);
 	return 0;
@@ -981,6 +1012,30 @@ static void uas_free_streams(struct uas_dev_info *devinfo)
 	usb_free_streams(devinfo->intf, eps, 3, GFP_NOIO);
 }
 
+/* Completed commands, bytes moved and errors per stream (uas-tag) */
+static int uas_streams_show(struct seq_file *s, void *unused)
+{
+	struct uas_dev_info *devinfo = s->private;
+	struct uas_stream_stats stats;
+	unsigned long flags;
+	int i;
+
+	seq_puts(s, "stream cmnds bytes errors\n");
+	for (i = 0; i < devinfo->qdepth; i++) {
+		spin_lock_irqsave(&devinfo->lock, flags);
+		stats = devinfo->stats[i];
+		spin_unlock_irqrestore(&devinfo->lock, flags);
+
+		if (!stats.cmnds)
+			continue;
+		seq_printf(s, "%d %llu %llu %llu\n", i + 1, stats.cmnds,
+			   stats.bytes, stats.errors);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(uas_streams);
+
 static int uas_probe(struct usb_interface *intf, const struct usb_device_id *id)
 {
 	int result = -ENOMEM;
@@ -1005,6 +1060,9 @@ static int uas_probe(struct usb_interface *intf, const struct usb_device_id *id)
 	shost->max_lun = 256;
 	shost->max_channel = 0;
 	shost->sg_tablesize = udev->bus->sg_tablesize;
+	/* without SG constraints (xHCI) don't split large I/O up front */
+	if (udev->bus->no_sg_constraint)
+		shost->max_sectors = UAS_MAX_SECTORS;
 
 	devinfo = (struct uas_dev_info *)shost->hostdata;
 	devinfo->intf = intf;
@@ -1034,6 +1092,10 @@ static int uas_probe(struct usb_interface *intf, const struct usb_device_id *id)
 	if (result)
 		goto free_streams;
 
+	devinfo->debugfs = debugfs_create_file(dev_name(&intf->dev), 0444,
+					       uas_debug_root, devinfo,
+					       &uas_streams_fops);
+
 	/* Submit the delayed_work for SCSI-device scanning */
 	schedule_work(&devinfo->scan_work);
 
@@ -1210,6 +1272,7 @@ static void uas_disconnect(struct usb_interface *intf)
 	 */
 	cancel_work_sync(&devinfo->scan_work);
 
+	debugfs_remove(devinfo->debugfs);
 	scsi_remove_host(shost);
 	uas_free_streams(devinfo);
 	scsi_host_put(shost);
@@ -1257,8 +1320,11 @@ static int __init uas_init(void)
 	if (!workqueue)
 		return -ENOMEM;
 
+	uas_debug_root = debugfs_create_dir("uas", usb_debug_root);
+
 	rv = usb_register(&uas_driver);
 	if (rv) {
+		debugfs_remove(uas_debug_root);
 		destroy_workqueue(workqueue);
 		return -ENOMEM;
 	}
@@ -1269,6 +1335,7 @@ static int __init uas_init(void)
 static void __exit uas_exit(void)
 {
 	usb_deregister(&uas_driver);
+	debugfs_remove(uas_debug_root);
 	destroy_workqueue(workqueue);
 }
 
@@ -123,6 +123,8 @@ struct vhost_net_virtqueue {
 	struct vhost_net_ubuf_ref *ubufs;
 	struct ptr_ring *rx_ring;
 	struct vhost_net_buf rxq;
+	/* Current busy-poll budget in us, at most busyloop_timeout */
+	u32 busyloop_window;
 };
 
 struct vhost_net {
@@ -304,6 +306,7 @@ static void vhost_net_vq_reset(struct vhost_net *n)
 		n->vqs[i].ubufs = NULL;
 		n->vqs[i].vhost_hlen = 0;
 		n->vqs[i].sock_hlen = 0;
+		n->vqs[i].busyloop_window = 0;
 		vhost_net_buf_init(&n->vqs[i].rxq);
 	}
 
@@ -406,6 +409,32 @@ static bool vhost_can_busy_poll(unsigned long endtime)
 		      !signal_pending(current));
 }
 
+/* Busy polling starts with the whole busyloop_timeout. Each poll that
+ * expires without finding work halves the window, down to 1/16 of the
+ * timeout, and each poll that finds work doubles it again. An idle queue
+ * then wastes little CPU while a busy one keeps the full budget.
+ */
+static u32 vhost_net_busy_window(struct vhost_net_virtqueue *nvq,
+				 u32 timeout)
+{
+	if (!nvq->busyloop_window || nvq->busyloop_window > timeout)
+		nvq->busyloop_window = timeout;
+
+	return nvq->busyloop_window;
+}
+
+static void vhost_net_busy_update(struct vhost_net_virtqueue *nvq,
+				  u32 timeout, bool found)
+{
+	if (found)
+		nvq->busyloop_window = min_t(u64,
+					     (u64)nvq->busyloop_window << 1,
+					     timeout);
+	else
+		nvq->busyloop_window = max3(nvq->busyloop_window >> 1,
+					    timeout >> 4, 1U);
+}
+
 static void vhost_net_disable_vq(struct vhost_net *n,
 				 struct vhost_virtqueue *vq)
 {
@@ -458,7 +487,8 @@ static int vhost_net_tx_get_vq_desc(struct vhost_net *net,
 		if (!vhost_sock_zcopy(vq->private_data))
 			vhost_net_signal_used(nvq);
 		preempt_disable();
-		endtime = busy_clock() + vq->busyloop_timeout;
+		endtime = busy_clock() +
+			  vhost_net_busy_window(nvq, vq->busyloop_timeout);
 		while (vhost_can_busy_poll(endtime)) {
 			if (vhost_has_work(vq->dev)) {
 				*busyloop_intr = true;
@@ -471,6 +501,9 @@ static int vhost_net_tx_get_vq_desc(struct vhost_net *net,
 		preempt_enable();
 		r = vhost_get_vq_desc(vq, vq->iov, ARRAY_SIZE(vq->iov),
 				      out_num, in_num, NULL, NULL);
+		if (!*busyloop_intr)
+			vhost_net_busy_update(nvq, vq->busyloop_timeout,
+					      r != vq->num);
 	}
 
 	return r;
@@ -762,6 +795,7 @@ static int vhost_net_rx_peek_head_len(struct vhost_net *net, struct sock *sk,
 	struct vhost_virtqueue *tvq = &tnvq->vq;
 	unsigned long uninitialized_var(endtime);
 	int len = peek_head_len(rnvq, sk);
+	bool found = false;
 
 	if (!len && tvq->busyloop_timeout) {
 		/* Flush batched heads first */
@@ -771,7 +805,8 @@ static int vhost_net_rx_peek_head_len(struct vhost_net *net, struct sock *sk,
 		vhost_disable_notify(&net->dev, tvq);
 
 		preempt_disable();
-		endtime = busy_clock() + tvq->busyloop_timeout;
+		endtime = busy_clock() +
+			  vhost_net_busy_window(rnvq, tvq->busyloop_timeout);
 
 		while (vhost_can_busy_poll(endtime)) {
 			if (vhost_has_work(&net->dev)) {
@@ -780,13 +815,19 @@ static int vhost_net_rx_peek_head_len(struct vhost_net *net, struct sock *sk,
 			}
 			if ((sk_has_rx_data(sk) &&
 			     !vhost_vq_avail_empty(&net->dev, rvq)) ||
-			    !vhost_vq_avail_empty(&net->dev, tvq))
+			    !vhost_vq_avail_empty(&net->dev, tvq)) {
+				found = true;
 				break;
+			}
 			cpu_relax();
 		}
 
 		preempt_enable();
 
+		if (!*busyloop_intr)
+			vhost_net_busy_update(rnvq, tvq->busyloop_timeout,
+					      found);
+
 		if (!vhost_vq_avail_empty(&net->dev, tvq)) {
 			vhost_poll_queue(&tvq->poll);
 		} else if (unlikely(vhost_enable_notify(&net->dev, tvq))) {
@@ -1098,6 +1139,7 @@ static int vhost_net_open(struct inode *inode, struct file *f)
 		n->vqs[i].vhost_hlen = 0;
 		n->vqs[i].sock_hlen = 0;
 		n->vqs[i].rx_ring = NULL;
+		n->vqs[i].busyloop_window = 0;
 		vhost_net_buf_init(&n->vqs[i].rxq);
 	}
 	vhost_dev_init(dev, vqs, VHOST_NET_VQ_MAX,
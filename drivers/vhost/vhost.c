@@ -308,6 +308,7 @@ static void vhost_vq_reset(struct vhost_dev *dev,
 	vq->used = NULL;
 	vq->last_avail_idx = 0;
 	vq->avail_idx = 0;
+	vq->avail_head_num = 0;
 	vq->last_used_idx = 0;
 	vq->signalled_used = 0;
 	vq->signalled_used_valid = false;
@@ -1447,6 +1448,7 @@ long vhost_vring_ioctl(struct vhost_dev *d, unsigned int ioctl, void __user *arg
 			break;
 		}
 		vq->num = s.num;
+		vq->avail_head_num = 0;
 		break;
 	case VHOST_SET_VRING_BASE:
 		/* Moving base with an active backend?
@@ -1466,6 +1468,7 @@ long vhost_vring_ioctl(struct vhost_dev *d, unsigned int ioctl, void __user *arg
 		vq->last_avail_idx = s.num;
 		/* Forget the cached index value. */
 		vq->avail_idx = vq->last_avail_idx;
+		vq->avail_head_num = 0;
 		break;
 	case VHOST_GET_VRING_BASE:
 		s.index = idx;
@@ -1526,6 +1529,7 @@ long vhost_vring_ioctl(struct vhost_dev *d, unsigned int ioctl, void __user *arg
 		vq->log_used = !!(a.flags & (0x1 << VHOST_VRING_F_LOG));
 		vq->desc = (void __user *)(unsigned long)a.desc_user_addr;
 		vq->avail = (void __user *)(unsigned long)a.avail_user_addr;
+		vq->avail_head_num = 0;
 		vq->log_addr = a.log_guest_addr;
 		vq->used = (void __user *)(unsigned long)a.used_user_addr;
 		break;
@@ -2092,6 +2096,41 @@ static int get_indirect(struct vhost_virtqueue *vq,
 	return 0;
 }
 
+/* Read the avail ring entry for @idx. Without an IOTLB the ring is plain
+ * user memory, so fetch up to VHOST_AVAIL_BATCH published entries with a
+ * single copy and serve the following calls from that cache.
+ */
+static int vhost_get_avail_head(struct vhost_virtqueue *vq, u16 idx,
+				__virtio16 *head)
+{
+	u16 off = idx - vq->avail_head_idx;
+	unsigned int start, n;
+
+	if (off < vq->avail_head_num) {
+		*head = vq->avail_heads[off];
+		return 0;
+	}
+
+	start = idx & (vq->num - 1);
+	if (vq->iotlb)
+		return vhost_get_avail(vq, *head, &vq->avail->ring[start]);
+
+	/* Only entries the guest has published, and no wrap around */
+	n = min_t(unsigned int, (u16)(vq->avail_idx - idx), VHOST_AVAIL_BATCH);
+	n = min_t(unsigned int, n, vq->num - start);
+
+	if (__copy_from_user(vq->avail_heads, &vq->avail->ring[start],
+			     n * sizeof(*vq->avail_heads))) {
+		vq->avail_head_num = 0;
+		return -EFAULT;
+	}
+
+	vq->avail_head_idx = idx;
+	vq->avail_head_num = n;
+	*head = vq->avail_heads[0];
+	return 0;
+}
+
 /* This looks in the virtqueue and for the first available buffer, and converts
  * it to an iovec for convenient access.  Since descriptors consist of some
  * number of output then some number of input descriptors, it's actually two
@@ -2143,8 +2182,7 @@ int vhost_get_vq_desc(struct vhost_virtqueue *vq,
 
 	/* Grab the next descriptor number they're advertising, and increment
 	 * the index we've seen. */
-	if (unlikely(vhost_get_avail(vq, ring_head,
-		     &vq->avail->ring[last_avail_idx & (vq->num - 1)]))) {
+	if (unlikely(vhost_get_avail_head(vq, last_avail_idx, &ring_head))) {
 		vq_err(vq, "Failed to read head: idx %d address %p\n",
 		       last_avail_idx,
 		       &vq->avail->ring[last_avail_idx % vq->num]);
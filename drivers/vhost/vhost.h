@@ -107,6 +107,12 @@ struct vhost_virtqueue {
 	/* Caches available index value from user. */
 	u16 avail_idx;
 
+	/* Avail ring entries read ahead, starting at avail_head_idx */
+#define VHOST_AVAIL_BATCH 32
+	u16 avail_head_idx;
+	u16 avail_head_num;
+	__virtio16 avail_heads[VHOST_AVAIL_BATCH];
+
 	/* Last index we used. */
 	u16 last_used_idx;
 
@@ -728,12 +728,6 @@ static int bcm2708_compat_ioctl(struct fb_info *info, unsigned int cmd,
 }
 #endif
 
-static void bcm2708_fb_fillrect(struct fb_info *info,
-				const struct fb_fillrect *rect)
-{
-	cfb_fillrect(info, rect);
-}
-
 /* A helper function for configuring dma control block */
 static void set_dma_cb(struct bcm2708_dma_cb *cb,
 		int        burst_size,
@@ -760,6 +754,31 @@ static void set_dma_cb(struct bcm2708_dma_cb *cb,
 	cb->pad[1] = 0;
 }
 
+/*
+ * Start the control block chain and wait for it to complete, busy-waiting
+ * for small jobs and sleeping until the DMA interrupt for larger ones.
+ * @last is the last control block of the chain. Called with dma_mutex held.
+ */
+static void bcm2708_fb_dma_run(struct bcm2708_fb_dev *fbdev,
+			       struct bcm2708_dma_cb *last, int pixels)
+{
+	if (pixels < dma_busy_wait_threshold) {
+		bcm_dma_start(fbdev->dma_chan_base, fbdev->cb_handle);
+		bcm_dma_wait_idle(fbdev->dma_chan_base);
+	} else {
+		void __iomem *local_dma_chan = fbdev->dma_chan_base;
+
+		last->info |= BCM2708_DMA_INT_EN;
+		bcm_dma_start(fbdev->dma_chan_base, fbdev->cb_handle);
+		while (bcm_dma_is_busy(local_dma_chan)) {
+			wait_event_interruptible(fbdev->dma_waitq,
+						 !bcm_dma_is_busy(local_dma_chan));
+		}
+		fbdev->dma_stats.dma_irqs++;
+	}
+	fbdev->dma_stats.dma_copies++;
+}
+
 static void bcm2708_fb_copyarea(struct fb_info *info,
 				const struct fb_copyarea *region)
 {
@@ -866,21 +885,71 @@ static void bcm2708_fb_copyarea(struct fb_info *info,
 	/* end of dma control blocks chain */
 	cb->next = 0;
 
-	if (pixels < dma_busy_wait_threshold) {
-		bcm_dma_start(fbdev->dma_chan_base, fbdev->cb_handle);
-		bcm_dma_wait_idle(fbdev->dma_chan_base);
-	} else {
-		void __iomem *local_dma_chan = fbdev->dma_chan_base;
+	bcm2708_fb_dma_run(fbdev, cb, pixels);
 
-		cb->info |= BCM2708_DMA_INT_EN;
-		bcm_dma_start(fbdev->dma_chan_base, fbdev->cb_handle);
-		while (bcm_dma_is_busy(local_dma_chan)) {
-			wait_event_interruptible(fbdev->dma_waitq,
-						 !bcm_dma_is_busy(local_dma_chan));
-		}
-		fbdev->dma_stats.dma_irqs++;
+	mutex_unlock(&fbdev->dma_mutex);
+}
+
+/*
+ * Fill a rectangle by pointing the DMA at a 16 byte copy of the colour
+ * with source increment disabled, so the engine keeps re-reading it.
+ * The pattern has to repeat within those 16 bytes, which rules out
+ * 24bpp.
+ */
+static void bcm2708_fb_fillrect(struct fb_info *info,
+				const struct fb_fillrect *rect)
+{
+	struct bcm2708_fb *fb = to_bcm2708(info);
+	struct bcm2708_fb_dev *fbdev = fb->fbdev;
+	struct bcm2708_dma_cb *cb = fbdev->cb_base;
+	int bytes_per_pixel = (info->var.bits_per_pixel + 7) >> 3;
+	int burst_size = (fbdev->dma_chan == 0) ? 8 : 2;
+	/* 16 bytes straight after the control block */
+	u32 *pattern = (u32 *)(cb + 1);
+	dma_addr_t pattern_handle = fbdev->cb_handle + sizeof(*cb);
+	u32 color;
+	int i;
+
+	if (rect->rop != ROP_COPY ||
+	    (bytes_per_pixel != 1 && bytes_per_pixel != 2 &&
+	     bytes_per_pixel != 4) ||
+	    rect->width == 0 || rect->height == 0 ||
+	    rect->dx >= info->var.xres_virtual ||
+	    rect->dy >= info->var.yres_virtual ||
+	    rect->width > info->var.xres_virtual - rect->dx ||
+	    rect->height > info->var.yres_virtual - rect->dy ||
+	    !mutex_trylock(&fbdev->dma_mutex)) {
+		cfb_fillrect(info, rect);
+		return;
 	}
-	fbdev->dma_stats.dma_copies++;
+
+	if (info->fix.visual == FB_VISUAL_TRUECOLOR ||
+	    info->fix.visual == FB_VISUAL_DIRECTCOLOR)
+		color = ((u32 *)info->pseudo_palette)[rect->color];
+	else
+		color = rect->color;
+
+	if (bytes_per_pixel == 1)
+		color = (color & 0xff) * 0x01010101;
+	else if (bytes_per_pixel == 2)
+		color = (color & 0xffff) * 0x00010001;
+
+	for (i = 0; i < 4; i++)
+		pattern[i] = color;
+
+	set_dma_cb(cb, burst_size,
+		   fb->fb_bus_address + rect->dy * fb->fb.fix.line_length +
+		   bytes_per_pixel * rect->dx,
+		   fb->fb.fix.line_length,
+		   pattern_handle, 0,
+		   rect->width * bytes_per_pixel,
+		   rect->height);
+	cb->info &= ~BCM2708_DMA_S_INC;
+	/* Don't let the source stride walk away from the pattern either */
+	cb->stride &= 0xffff0000;
+	cb->next = 0;
+
+	bcm2708_fb_dma_run(fbdev, cb, rect->width * rect->height);
 
 	mutex_unlock(&fbdev->dma_mutex);
 }
@@ -930,7 +999,8 @@ static int bcm2708_fb_register(struct bcm2708_fb *fb)
 	int ret;
 
 	fb->fb.fbops = &bcm2708_fb_ops;
-	fb->fb.flags = FBINFO_FLAG_DEFAULT | FBINFO_HWACCEL_COPYAREA;
+	fb->fb.flags = FBINFO_FLAG_DEFAULT | FBINFO_HWACCEL_COPYAREA |
+		       FBINFO_HWACCEL_FILLRECT;
 	fb->fb.pseudo_palette = fb->cmap;
 
 	strncpy(fb->fb.fix.id, bcm2708_name, sizeof(fb->fb.fix.id));
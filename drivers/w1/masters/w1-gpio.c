@@ -61,6 +61,48 @@ static u8 w1_gpio_read_bit(void *data)
 	return gpiod_get_value(pdata->gpiod) ? 1 : 0;
 }
 
+/*
+ * The recovery time after a slot has no upper bound, so sleep on an hrtimer
+ * instead of spinning. w1's disable_irqs parameter may have us called with
+ * interrupts off, in which case we have to spin.
+ */
+static void w1_gpio_recover(unsigned int us)
+{
+	if (irqs_disabled())
+		udelay(us);
+	else
+		usleep_range(us, us + 20);
+}
+
+static u8 w1_gpio_touch_bit(void *data, u8 bit)
+{
+	struct w1_gpio_platform_data *pdata = data;
+	unsigned long flags;
+	u8 result;
+
+	if (!bit) {
+		/* a write-0 must not stay low past 120us, so spin for it */
+		gpiod_set_value(pdata->gpiod, 0);
+		udelay(60);
+		gpiod_set_value(pdata->gpiod, 1);
+		w1_gpio_recover(10);
+		return 0;
+	}
+
+	/* write-1 / read cycle, sample timing is critical here */
+	local_irq_save(flags);
+	gpiod_set_value(pdata->gpiod, 0);
+	udelay(6);
+	gpiod_set_value(pdata->gpiod, 1);
+	udelay(9);
+	result = gpiod_get_value(pdata->gpiod) ? 1 : 0;
+	local_irq_restore(flags);
+
+	w1_gpio_recover(55);
+
+	return result;
+}
+
 #if defined(CONFIG_OF)
 static const struct of_device_id w1_gpio_dt_ids[] = {
 	{ .compatible = "w1-gpio" },
@@ -127,6 +169,7 @@ static int w1_gpio_probe(struct platform_device *pdev)
 	master->read_bit = w1_gpio_read_bit;
 	gpiod_direction_output(pdata->gpiod, 1);
 	master->write_bit = w1_gpio_write_bit;
+	master->touch_bit = w1_gpio_touch_bit;
 
 	/*
 	 * If we are using open drain emulation from the GPIO library,
@@ -23,6 +23,8 @@
 #include <linux/uio.h>
 
 #include <linux/sched/signal.h>
+#include <linux/sched/mm.h>
+#include <linux/cred.h>
 #include <linux/fs.h>
 #include <linux/file.h>
 #include <linux/mm.h>
@@ -142,6 +144,7 @@ struct kioctx {
 	struct {
 		spinlock_t	ctx_lock;
 		struct list_head active_reqs;	/* used for cancellation */
+		struct list_head hipri_reqs;	/* polled, on ki_list too */
 	} ____cacheline_aligned_in_smp;
 
 	struct {
@@ -215,6 +218,7 @@ struct aio_kiocb {
 static DEFINE_SPINLOCK(aio_nr_lock);
 unsigned long aio_nr;		/* current system wide number of aio requests */
 unsigned long aio_max_nr = 0x10000; /* system wide maximum number of aio requests */
+int aio_buffered_offload;	/* hand blocking buffered I/O to a worker */
 /*----end sysctl variables---*/
 
 static struct kmem_cache	*kiocb_cachep;
@@ -742,6 +746,7 @@ static struct kioctx *ioctx_alloc(unsigned nr_events)
 	init_waitqueue_head(&ctx->wait);
 
 	INIT_LIST_HEAD(&ctx->active_reqs);
+	INIT_LIST_HEAD(&ctx->hipri_reqs);
 
 	if (percpu_ref_init(&ctx->users, free_ioctx_users, 0, GFP_KERNEL))
 		goto err;
@@ -1258,6 +1263,70 @@ static bool aio_read_events(struct kioctx *ctx, long min_nr, long nr,
 	return ret < 0 || *i >= min_nr;
 }
 
+/*
+ * Poll the queue of the next outstanding RWF_HIPRI request once, rotating
+ * through them.  Returns false if there are none left.
+ */
+static bool aio_poll_hipri(struct kioctx *ctx)
+{
+	struct request_queue *q = NULL;
+	struct aio_kiocb *iocb;
+	blk_qc_t cookie;
+
+	spin_lock_irq(&ctx->ctx_lock);
+	if (list_empty(&ctx->hipri_reqs)) {
+		spin_unlock_irq(&ctx->ctx_lock);
+		return false;
+	}
+
+	iocb = list_first_entry(&ctx->hipri_reqs, struct aio_kiocb, ki_list);
+	list_move_tail(&iocb->ki_list, &ctx->hipri_reqs);
+
+	/* not set until the submitter is done issuing the bios */
+	cookie = READ_ONCE(iocb->rw.ki_cookie);
+	if (blk_qc_t_valid(cookie)) {
+		q = bdev_get_queue(I_BDEV(iocb->rw.ki_filp->f_mapping->host));
+		if (!blk_get_queue(q))
+			q = NULL;
+	}
+	spin_unlock_irq(&ctx->ctx_lock);
+
+	/* the request may complete and go away from here, q may not */
+	if (q) {
+		blk_poll(q, cookie);
+		blk_put_queue(q);
+	}
+	return true;
+}
+
+/*
+ * With RWF_HIPRI requests in flight, spin on their queues for completions
+ * instead of sleeping for the interrupt.  Returns true when done, false if
+ * the caller should wait on ctx->wait as usual.
+ */
+static bool aio_read_events_polled(struct kioctx *ctx, long min_nr, long nr,
+				   struct io_event __user *event, long *i,
+				   ktime_t until)
+{
+	ktime_t end = KTIME_MAX;
+
+	if (list_empty_careful(&ctx->hipri_reqs))
+		return false;
+
+	if (until != KTIME_MAX)
+		end = ktime_add_safe(ktime_get(), until);
+
+	for (;;) {
+		if (aio_read_events(ctx, min_nr, nr, event, i))
+			return true;
+		if (!aio_poll_hipri(ctx))
+			return false;
+		if (signal_pending(current) || ktime_after(ktime_get(), end))
+			return true;
+		cond_resched();
+	}
+}
+
 static long read_events(struct kioctx *ctx, long min_nr, long nr,
 			struct io_event __user *event,
 			ktime_t until)
@@ -1280,7 +1349,7 @@ static long read_events(struct kioctx *ctx, long min_nr, long nr,
 	 */
 	if (until == 0)
 		aio_read_events(ctx, min_nr, nr, event, &ret);
-	else
+	else if (!aio_read_events_polled(ctx, min_nr, nr, event, &ret, until))
 		wait_event_interruptible_hrtimeout(ctx->wait,
 				aio_read_events(ctx, min_nr, nr, event, &ret),
 				until);
@@ -1433,6 +1502,19 @@ static void aio_complete_rw(struct kiocb *kiocb, long res, long res2)
 	iocb_put(iocb);
 }
 
+static bool aio_rw_pollable(struct kiocb *req)
+{
+	struct file *file = req->ki_filp;
+	struct request_queue *q;
+
+	if (!(req->ki_flags & IOCB_HIPRI) || !(req->ki_flags & IOCB_DIRECT) ||
+	    !S_ISBLK(file_inode(file)->i_mode))
+		return false;
+
+	q = bdev_get_queue(I_BDEV(file->f_mapping->host));
+	return test_bit(QUEUE_FLAG_POLL, &q->queue_flags);
+}
+
 static int aio_prep_rw(struct kiocb *req, const struct iocb *iocb)
 {
 	int ret;
@@ -1464,10 +1546,30 @@ static int aio_prep_rw(struct kiocb *req, const struct iocb *iocb)
 	if (unlikely(ret))
 		return ret;
 
-	req->ki_flags &= ~IOCB_HIPRI; /* no one is going to poll for this I/O */
+	/* io_getevents() polls for direct I/O to block devices that can */
+	if (!aio_rw_pollable(req))
+		req->ki_flags &= ~IOCB_HIPRI;
+	req->ki_cookie = BLK_QC_T_NONE;
 	return 0;
 }
 
+/*
+ * Queue a request that kept IOCB_HIPRI for io_getevents() to poll.  Done
+ * right before issuing it, aio_complete_rw() takes it off again.
+ */
+static void aio_rw_hipri_add(struct kiocb *req)
+{
+	struct aio_kiocb *iocb = container_of(req, struct aio_kiocb, rw);
+	struct kioctx *ctx = iocb->ki_ctx;
+
+	if (!(req->ki_flags & IOCB_HIPRI))
+		return;
+
+	spin_lock_irq(&ctx->ctx_lock);
+	list_add_tail(&iocb->ki_list, &ctx->hipri_reqs);
+	spin_unlock_irq(&ctx->ctx_lock);
+}
+
 static int aio_setup_rw(int rw, const struct iocb *iocb, struct iovec **iovec,
 		bool vectored, bool compat, struct iov_iter *iter)
 {
@@ -1507,6 +1609,140 @@ static inline void aio_rw_done(struct kiocb *req, ssize_t ret)
 	}
 }
 
+/*
+ * State for a buffered read or write that io_submit() handed to a worker.
+ * The iterator still points at the submitter's memory, so the worker
+ * borrows its mm and credentials.
+ */
+struct aio_rw_work {
+	struct work_struct	work;
+	struct kiocb		*req;
+	struct mm_struct	*mm;
+	const struct cred	*cred;
+	ssize_t			done;	/* read with IOCB_NOWAIT */
+	struct iov_iter		iter;
+	struct iovec		*iovec;	/* from import_iovec(), or NULL */
+	struct iovec		fast_iov[UIO_FASTIOV];
+};
+
+static inline ssize_t aio_rw_add(ssize_t done, ssize_t ret)
+{
+	if (ret == -EIOCBQUEUED)
+		return ret;
+	if (ret >= 0)
+		return done + ret;
+	return done ? done : ret;
+}
+
+static void aio_rw_work_fn(struct work_struct *work)
+{
+	struct aio_rw_work *w = container_of(work, struct aio_rw_work, work);
+	struct kiocb *req = w->req;
+	const struct cred *old_cred;
+	ssize_t ret = -EFAULT;
+
+	if (mmget_not_zero(w->mm)) {
+		old_cred = override_creds(w->cred);
+		use_mm(w->mm);
+		if (req->ki_flags & IOCB_WRITE)
+			ret = call_write_iter(req->ki_filp, req, &w->iter);
+		else
+			ret = call_read_iter(req->ki_filp, req, &w->iter);
+		unuse_mm(w->mm);
+		revert_creds(old_cred);
+		mmput(w->mm);
+	}
+
+	aio_rw_done(req, aio_rw_add(w->done, ret));
+
+	mmdrop(w->mm);
+	put_cred(w->cred);
+	kfree(w->iovec);
+	kfree(w);
+}
+
+/*
+ * Only regular files are handed over: pipes, sockets and devices already
+ * have their own notion of blocking, and O_DIRECT or RWF_NOWAIT requests
+ * are issued inline as before.
+ */
+static bool aio_rw_should_offload(struct kiocb *req)
+{
+	return READ_ONCE(aio_buffered_offload) &&
+	       !(req->ki_flags & (IOCB_DIRECT | IOCB_NOWAIT)) &&
+	       S_ISREG(file_inode(req->ki_filp)->i_mode);
+}
+
+/*
+ * Queue the rest of @iter to a worker.  Takes over @iovec if it was
+ * allocated, otherwise copies the segments left in @iter.
+ */
+static int aio_rw_offload(struct kiocb *req, struct iov_iter *iter,
+			  struct iovec **iovec, ssize_t done)
+{
+	struct aio_rw_work *w;
+
+	w = kmalloc(sizeof(*w), GFP_KERNEL);
+	if (!w)
+		return -ENOMEM;
+
+	w->req = req;
+	w->done = done;
+	w->iter = *iter;
+	if (*iovec) {
+		w->iovec = *iovec;
+		*iovec = NULL;
+	} else {
+		if (WARN_ON_ONCE(iter->nr_segs > UIO_FASTIOV)) {
+			kfree(w);
+			return -EINVAL;
+		}
+		memcpy(w->fast_iov, iter->iov,
+		       iter->nr_segs * sizeof(struct iovec));
+		w->iter.iov = w->fast_iov;
+		w->iovec = NULL;
+	}
+
+	w->mm = current->mm;
+	mmgrab(w->mm);
+	w->cred = get_current_cred();
+
+	INIT_WORK(&w->work, aio_rw_work_fn);
+	queue_work(system_unbound_wq, &w->work);
+	return 0;
+}
+
+/*
+ * A buffered read is first tried with IOCB_NOWAIT, which is satisfied from
+ * the page cache without blocking; only what is left of it goes to the
+ * worker.
+ */
+static void aio_read_offload(struct kiocb *req, struct iov_iter *iter,
+			     struct iovec **iovec)
+{
+	struct file *file = req->ki_filp;
+	ssize_t ret = 0;
+
+	if (file->f_mode & FMODE_NOWAIT) {
+		req->ki_flags |= IOCB_NOWAIT;
+		ret = call_read_iter(file, req, iter);
+		req->ki_flags &= ~IOCB_NOWAIT;
+
+		if (ret == -EAGAIN) {
+			ret = 0;
+		} else if (ret <= 0 || !iov_iter_count(iter) ||
+			   req->ki_pos >= i_size_read(file_inode(file))) {
+			/* Done, failed or hit EOF */
+			aio_rw_done(req, ret);
+			return;
+		}
+	}
+
+	if (aio_rw_offload(req, iter, iovec, ret))
+		aio_rw_done(req, aio_rw_add(ret, call_read_iter(file, req,
+								 iter)));
+}
+
 static ssize_t aio_read(struct kiocb *req, const struct iocb *iocb,
 			bool vectored, bool compat)
 {
@@ -1529,8 +1765,13 @@ static ssize_t aio_read(struct kiocb *req, const struct iocb *iocb,
 	if (ret)
 		return ret;
 	ret = rw_verify_area(READ, file, &req->ki_pos, iov_iter_count(&iter));
-	if (!ret)
-		aio_rw_done(req, call_read_iter(file, req, &iter));
+	if (!ret) {
+		aio_rw_hipri_add(req);
+		if (aio_rw_should_offload(req))
+			aio_read_offload(req, &iter, &iovec);
+		else
+			aio_rw_done(req, call_read_iter(file, req, &iter));
+	}
 	kfree(iovec);
 	return ret;
 }
@@ -1570,7 +1811,17 @@ static ssize_t aio_write(struct kiocb *req, const struct iocb *iocb,
 			__sb_writers_release(file_inode(file)->i_sb, SB_FREEZE_WRITE);
 		}
 		req->ki_flags |= IOCB_WRITE;
-		aio_rw_done(req, call_write_iter(file, req, &iter));
+		aio_rw_hipri_add(req);
+		/*
+		 * Buffered writes can't be tried with IOCB_NOWAIT.  Writes
+		 * that would cross RLIMIT_FSIZE stay inline so that the
+		 * submitter gets the SIGXFSZ, not the worker.
+		 */
+		if (!aio_rw_should_offload(req) ||
+		    req->ki_pos + iov_iter_count(&iter) >
+				rlimit(RLIMIT_FSIZE) ||
+		    aio_rw_offload(req, &iter, &iovec, 0))
+			aio_rw_done(req, call_write_iter(file, req, &iter));
 	}
 	kfree(iovec);
 	return ret;
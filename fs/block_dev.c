@@ -411,8 +411,15 @@ __blkdev_direct_IO(struct kiocb *iocb, struct iov_iter *iter, int nr_pages)
 	}
 	blk_finish_plug(&plug);
 
-	if (!is_sync)
+	if (!is_sync) {
+		/*
+		 * Only aio sets IOCB_HIPRI on async requests, and it holds a
+		 * reference on the iocb until we return.
+		 */
+		if (iocb->ki_flags & IOCB_HIPRI)
+			WRITE_ONCE(iocb->ki_cookie, qc);
 		return -EIOCBQUEUED;
+	}
 
 	for (;;) {
 		set_current_state(TASK_UNINTERRUPTIBLE);
@@ -119,6 +119,7 @@ struct dentry_stat_t dentry_stat = {
 
 static DEFINE_PER_CPU(long, nr_dentry);
 static DEFINE_PER_CPU(long, nr_dentry_unused);
+static DEFINE_PER_CPU(long, nr_dentry_negative);
 
 #if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
 
@@ -152,11 +153,21 @@ static long get_nr_dentry_unused(void)
 	return sum < 0 ? 0 : sum;
 }
 
+static long get_nr_dentry_negative(void)
+{
+	int i;
+	long sum = 0;
+	for_each_possible_cpu(i)
+		sum += per_cpu(nr_dentry_negative, i);
+	return sum < 0 ? 0 : sum;
+}
+
 int proc_nr_dentry(struct ctl_table *table, int write, void __user *buffer,
 		   size_t *lenp, loff_t *ppos)
 {
 	dentry_stat.nr_dentry = get_nr_dentry();
 	dentry_stat.nr_unused = get_nr_dentry_unused();
+	dentry_stat.nr_negative = get_nr_dentry_negative();
 	return proc_doulongvec_minmax(table, write, buffer, lenp, ppos);
 }
 #endif
@@ -311,6 +322,33 @@ void release_dentry_name_snapshot(struct name_snapshot *name)
 }
 EXPORT_SYMBOL(release_dentry_name_snapshot);
 
+/*
+ * Unused negative dentries are counted both globally, for dentry-state, and
+ * per superblock.  Once a superblock holds more than
+ * sysctl_negative_dentry_limit of them, prune_negative_dentries() is kicked
+ * to trim its LRU back below the limit.  Zero means no limit.
+ */
+unsigned long sysctl_negative_dentry_limit __read_mostly;
+
+static void d_negative_inc(struct dentry *dentry)
+{
+	struct super_block *sb = dentry->d_sb;
+	unsigned long limit = READ_ONCE(sysctl_negative_dentry_limit);
+
+	this_cpu_inc(nr_dentry_negative);
+	percpu_counter_inc(&sb->s_nr_negative_dentry);
+	if (limit &&
+	    percpu_counter_read_positive(&sb->s_nr_negative_dentry) > limit &&
+	    !work_pending(&sb->s_negative_dentry_work))
+		queue_work(system_unbound_wq, &sb->s_negative_dentry_work);
+}
+
+static void d_negative_dec(struct dentry *dentry)
+{
+	this_cpu_dec(nr_dentry_negative);
+	percpu_counter_dec(&dentry->d_sb->s_nr_negative_dentry);
+}
+
 static inline void __d_set_inode_and_type(struct dentry *dentry,
 					  struct inode *inode,
 					  unsigned type_flags)
@@ -319,6 +357,9 @@ static inline void __d_set_inode_and_type(struct dentry *dentry,
 
 	dentry->d_inode = inode;
 	flags = READ_ONCE(dentry->d_flags);
+	if ((flags & DCACHE_LRU_LIST) && d_is_negative(dentry) &&
+	    (type_flags & DCACHE_ENTRY_TYPE) != DCACHE_MISS_TYPE)
+		d_negative_dec(dentry);
 	flags &= ~(DCACHE_ENTRY_TYPE | DCACHE_FALLTHRU);
 	flags |= type_flags;
 	WRITE_ONCE(dentry->d_flags, flags);
@@ -328,6 +369,8 @@ static inline void __d_clear_type_and_inode(struct dentry *dentry)
 {
 	unsigned flags = READ_ONCE(dentry->d_flags);
 
+	if ((flags & DCACHE_LRU_LIST) && !d_is_negative(dentry))
+		d_negative_inc(dentry);
 	flags &= ~(DCACHE_ENTRY_TYPE | DCACHE_FALLTHRU);
 	WRITE_ONCE(dentry->d_flags, flags);
 	dentry->d_inode = NULL;
@@ -383,7 +426,8 @@ static void dentry_unlink_inode(struct dentry * dentry)
  * on the shrink list (ie not on the superblock LRU list).
  *
  * The per-cpu "nr_dentry_unused" counters are updated with
- * the DCACHE_LRU_LIST bit.
+ * the DCACHE_LRU_LIST bit, and so are the negative dentry
+ * counters for dentries that have no inode.
  *
  * These helper functions make sure we always follow the
  * rules. d_lock must be held by the caller.
@@ -394,6 +438,8 @@ static void d_lru_add(struct dentry *dentry)
 	D_FLAG_VERIFY(dentry, 0);
 	dentry->d_flags |= DCACHE_LRU_LIST;
 	this_cpu_inc(nr_dentry_unused);
+	if (d_is_negative(dentry))
+		d_negative_inc(dentry);
 	WARN_ON_ONCE(!list_lru_add(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
 
@@ -402,6 +448,8 @@ static void d_lru_del(struct dentry *dentry)
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
+	if (d_is_negative(dentry))
+		d_negative_dec(dentry);
 	WARN_ON_ONCE(!list_lru_del(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
 
@@ -411,6 +459,8 @@ static void d_shrink_del(struct dentry *dentry)
 	list_del_init(&dentry->d_lru);
 	dentry->d_flags &= ~(DCACHE_SHRINK_LIST | DCACHE_LRU_LIST);
 	this_cpu_dec(nr_dentry_unused);
+	if (d_is_negative(dentry))
+		d_negative_dec(dentry);
 }
 
 static void d_shrink_add(struct dentry *dentry, struct list_head *list)
@@ -419,6 +469,8 @@ static void d_shrink_add(struct dentry *dentry, struct list_head *list)
 	list_add(&dentry->d_lru, list);
 	dentry->d_flags |= DCACHE_SHRINK_LIST | DCACHE_LRU_LIST;
 	this_cpu_inc(nr_dentry_unused);
+	if (d_is_negative(dentry))
+		d_negative_inc(dentry);
 }
 
 /*
@@ -432,6 +484,8 @@ static void d_lru_isolate(struct list_lru_one *lru, struct dentry *dentry)
 	D_FLAG_VERIFY(dentry, DCACHE_LRU_LIST);
 	dentry->d_flags &= ~DCACHE_LRU_LIST;
 	this_cpu_dec(nr_dentry_unused);
+	if (d_is_negative(dentry))
+		d_negative_dec(dentry);
 	list_lru_isolate(lru, &dentry->d_lru);
 }
 
@@ -1172,6 +1226,64 @@ long prune_dcache_sb(struct super_block *sb, struct shrink_control *sc)
 	return freed;
 }
 
+static enum lru_status dentry_negative_lru_isolate(struct list_head *item,
+		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
+{
+	struct dentry *dentry = container_of(item, struct dentry, d_lru);
+
+	/*
+	 * Unlocked peek; a dentry that turns positive under us is just
+	 * pruned like the shrinker would have done. Positive ones go to the
+	 * tail, so that the next batch starts past them rather than walking
+	 * them again.
+	 */
+	if (!d_is_negative(dentry))
+		return LRU_ROTATE;
+	return dentry_lru_isolate(item, lru, lru_lock, arg);
+}
+
+#define NEGATIVE_DENTRY_PRUNE_BATCH	1024UL
+
+/**
+ * prune_negative_dentries - trim a superblock's unused negative dentries
+ * @work: the superblock's s_negative_dentry_work
+ *
+ * Walks the dentry LRU once, freeing unused negative dentries in batches
+ * until the superblock is back at or below sysctl_negative_dentry_limit.
+ * Positive dentries are rotated past, so the batches together visit each
+ * entry at most once.
+ */
+void prune_negative_dentries(struct work_struct *work)
+{
+	struct super_block *sb = container_of(work, struct super_block,
+					      s_negative_dentry_work);
+	unsigned long nr_walk;
+
+	if (!down_read_trylock(&sb->s_umount))
+		return;
+	if (!sb->s_root || !(sb->s_flags & SB_BORN))
+		goto out;
+
+	nr_walk = list_lru_count(&sb->s_dentry_lru);
+	while (nr_walk) {
+		unsigned long limit = READ_ONCE(sysctl_negative_dentry_limit);
+		unsigned long batch = min(nr_walk, NEGATIVE_DENTRY_PRUNE_BATCH);
+		struct percpu_counter *nr = &sb->s_nr_negative_dentry;
+		LIST_HEAD(dispose);
+
+		if (!limit || percpu_counter_sum_positive(nr) <= limit)
+			break;
+
+		list_lru_walk(&sb->s_dentry_lru, dentry_negative_lru_isolate,
+			      &dispose, batch);
+		shrink_dentry_list(&dispose);
+		nr_walk -= batch;
+		cond_resched();
+	}
+out:
+	up_read(&sb->s_umount);
+}
+
 static enum lru_status dentry_lru_isolate_shrink(struct list_head *item,
 		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
 {
@@ -688,22 +688,36 @@ static void ext4_mb_mark_free_simple(struct super_block *sb,
 
 /*
  * Cache the order of the largest free extent we have available in this block
- * group.
+ * group, and keep the group on the matching s_mb_largest_free_orders list.
+ * Groups are only listed once initialized, so that picking one from a list
+ * never has to load its buddy. Called with the group locked.
  */
 static void
 mb_set_largest_free_order(struct super_block *sb, struct ext4_group_info *grp)
 {
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	int old = grp->bb_largest_free_order;
 	int i;
-	int bits;
-
-	grp->bb_largest_free_order = -1; /* uninit */
 
-	bits = sb->s_blocksize_bits + 1;
-	for (i = bits; i >= 0; i--) {
-		if (grp->bb_counters[i] > 0) {
-			grp->bb_largest_free_order = i;
+	for (i = MB_NUM_ORDERS(sb) - 1; i >= 0; i--) {
+		if (grp->bb_counters[i] > 0)
 			break;
-		}
+	}
+
+	if (i == old && !list_empty(&grp->bb_largest_free_order_node))
+		return;
+
+	if (old >= 0) {
+		write_lock(&sbi->s_mb_largest_free_orders_locks[old]);
+		list_del_init(&grp->bb_largest_free_order_node);
+		write_unlock(&sbi->s_mb_largest_free_orders_locks[old]);
+	}
+	grp->bb_largest_free_order = i;
+	if (i >= 0 && !EXT4_MB_GRP_NEED_INIT(grp)) {
+		write_lock(&sbi->s_mb_largest_free_orders_locks[i]);
+		list_add_tail(&grp->bb_largest_free_order_node,
+			      &sbi->s_mb_largest_free_orders[i]);
+		write_unlock(&sbi->s_mb_largest_free_orders_locks[i]);
 	}
 }
 
@@ -753,9 +767,10 @@ void ext4_mb_generate_buddy(struct super_block *sb,
 		ext4_mark_group_bitmap_corrupted(sb, group,
 					EXT4_GROUP_INFO_BBITMAP_CORRUPT);
 	}
-	mb_set_largest_free_order(sb, grp);
+	if (test_and_clear_bit(EXT4_GROUP_INFO_NEED_INIT_BIT, &(grp->bb_state)))
+		atomic_dec(&sbi->s_mb_uninit_groups);
 
-	clear_bit(EXT4_GROUP_INFO_NEED_INIT_BIT, &(grp->bb_state));
+	mb_set_largest_free_order(sb, grp);
 
 	period = get_cycles() - period;
 	spin_lock(&sbi->s_bal_lock);
@@ -2097,6 +2112,80 @@ static int ext4_mb_good_group(struct ext4_allocation_context *ac,
 	return 0;
 }
 
+/*
+ * Instead of walking all groups, cr 0 and cr 1 can take the next group from
+ * the lists of groups sorted by the order of their largest free extent: for
+ * cr 0 only groups with a free buddy of at least ac_2order can satisfy the
+ * request, for cr 1 we look for a free extent that covers the whole goal
+ * length. Groups whose buddy was never loaded are not on the lists yet.
+ *
+ * The group found is moved to the tail of its list, so that concurrent
+ * allocators spread over the qualifying groups instead of all starting on
+ * the first one.
+ */
+static bool ext4_mb_scan_by_order(struct ext4_allocation_context *ac, int cr)
+{
+	return EXT4_SB(ac->ac_sb)->s_mb_optimize_scan && cr < 2;
+}
+
+static bool ext4_mb_find_group_by_order(struct ext4_allocation_context *ac,
+					int cr, ext4_group_t ngroups,
+					ext4_group_t *group)
+{
+	struct super_block *sb = ac->ac_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	struct ext4_group_info *grp, *found = NULL;
+	struct list_head *list;
+	rwlock_t *lock;
+	int order;
+
+	if (cr == 0)
+		order = ac->ac_2order;
+	else
+		order = min_t(int, order_base_2(ac->ac_g_ex.fe_len),
+			      MB_NUM_ORDERS(sb) - 1);
+
+	for (; order < MB_NUM_ORDERS(sb); order++) {
+		list = &sbi->s_mb_largest_free_orders[order];
+		lock = &sbi->s_mb_largest_free_orders_locks[order];
+		if (list_empty(list))
+			continue;
+
+		read_lock(lock);
+		list_for_each_entry(grp, list, bb_largest_free_order_node) {
+			/*
+			 * ext4_mb_good_group() would load the buddy of a
+			 * group that needs init, and that sleeps. Listed
+			 * groups are initialized, but don't rely on it here.
+			 */
+			if (grp->bb_group < ngroups &&
+			    !EXT4_MB_GRP_NEED_INIT(grp) &&
+			    ext4_mb_good_group(ac, grp->bb_group, cr) > 0) {
+				found = grp;
+				break;
+			}
+			if (sbi->s_mb_stats)
+				atomic64_inc(&sbi->s_bal_cX_considered[cr]);
+		}
+		read_unlock(lock);
+		if (found)
+			break;
+	}
+
+	if (!found)
+		return false;
+
+	/* Unless it has moved to another order meanwhile, rotate it */
+	write_lock(lock);
+	if (found->bb_largest_free_order == order &&
+	    !list_empty(&found->bb_largest_free_order_node))
+		list_move_tail(&found->bb_largest_free_order_node, list);
+	write_unlock(lock);
+
+	*group = found->bb_group;
+	return true;
+}
+
 static noinline_for_stack int
 ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 {
@@ -2164,6 +2253,8 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 	 */
 repeat:
 	for (; cr < 4 && ac->ac_status == AC_STATUS_CONTINUE; cr++) {
+		bool by_order = ext4_mb_scan_by_order(ac, cr);
+
 		ac->ac_criteria = cr;
 		/*
 		 * searching for the right group start
@@ -2181,6 +2272,23 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 			if (group >= ngroups)
 				group = 0;
 
+			/*
+			 * Past the first few groups near the goal, jump to a
+			 * group that can satisfy this criterion. If there is
+			 * none, the pass is over unless some groups haven't
+			 * been initialized yet and so may still qualify.
+			 */
+			if (by_order && i >= MB_LINEAR_SCAN_GROUPS &&
+			    !ext4_mb_find_group_by_order(ac, cr, ngroups,
+							 &group)) {
+				if (!atomic_read(&sbi->s_mb_uninit_groups))
+					break;
+				by_order = false;
+			}
+
+			if (sbi->s_mb_stats)
+				atomic64_inc(&sbi->s_bal_cX_considered[cr]);
+
 			/* This now checks without needing the buddy page */
 			ret = ext4_mb_good_group(ac, group, cr);
 			if (ret <= 0) {
@@ -2223,6 +2331,13 @@ ext4_mb_regular_allocator(struct ext4_allocation_context *ac)
 			if (ac->ac_status != AC_STATUS_CONTINUE)
 				break;
 		}
+
+		if (sbi->s_mb_stats) {
+			if (ac->ac_status == AC_STATUS_CONTINUE)
+				atomic_inc(&sbi->s_bal_cX_failed[cr]);
+			else
+				atomic_inc(&sbi->s_bal_cX_hits[cr]);
+		}
 	}
 
 	if (ac->ac_b_ex.fe_len > 0 && ac->ac_status != AC_STATUS_FOUND &&
@@ -2341,6 +2456,52 @@ const struct seq_operations ext4_mb_seq_groups_ops = {
 	.show   = ext4_mb_seq_groups_show,
 };
 
+int ext4_seq_mb_stats_show(struct seq_file *seq, void *offset)
+{
+	struct super_block *sb = seq->private;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	int cr;
+
+	seq_puts(seq, "mballoc:\n");
+	if (!sbi->s_mb_stats) {
+		seq_puts(seq, "\tmb stats collection turned off.\n");
+		seq_puts(seq, "\tTo enable, please write \"1\" to sysfs file mb_stats.\n");
+		return 0;
+	}
+	seq_printf(seq, "\treqs: %u\n", atomic_read(&sbi->s_bal_reqs));
+	seq_printf(seq, "\tsuccess: %u\n", atomic_read(&sbi->s_bal_success));
+	seq_printf(seq, "\tblocks: %u\n", atomic_read(&sbi->s_bal_allocated));
+	seq_printf(seq, "\toptimize_scan: %u\n", sbi->s_mb_optimize_scan);
+	seq_printf(seq, "\tuninit_groups: %u\n",
+		   atomic_read(&sbi->s_mb_uninit_groups));
+
+	for (cr = 0; cr < EXT4_MB_NUM_CRS; cr++) {
+		seq_printf(seq, "\tcr%d_stats:\n", cr);
+		seq_printf(seq, "\t\thits: %u\n",
+			   atomic_read(&sbi->s_bal_cX_hits[cr]));
+		seq_printf(seq, "\t\tgroups_considered: %llu\n", (u64)
+			   atomic64_read(&sbi->s_bal_cX_considered[cr]));
+		seq_printf(seq, "\t\tuseless_loops: %u\n",
+			   atomic_read(&sbi->s_bal_cX_failed[cr]));
+	}
+
+	seq_printf(seq, "\textents_scanned: %u\n",
+		   atomic_read(&sbi->s_bal_ex_scanned));
+	seq_printf(seq, "\tgoal_hits: %u\n", atomic_read(&sbi->s_bal_goals));
+	seq_printf(seq, "\t2^n_hits: %u\n", atomic_read(&sbi->s_bal_2orders));
+	seq_printf(seq, "\tbreaks: %u\n", atomic_read(&sbi->s_bal_breaks));
+	seq_printf(seq, "\tlost: %u\n", atomic_read(&sbi->s_mb_lost_chunks));
+	seq_printf(seq, "\tbuddies_generated: %lu\n",
+		   sbi->s_mb_buddies_generated);
+	seq_printf(seq, "\tbuddies_time_used: %llu\n",
+		   sbi->s_mb_generation_time);
+	seq_printf(seq, "\tpreallocated: %u\n",
+		   atomic_read(&sbi->s_mb_preallocated));
+	seq_printf(seq, "\tdiscarded: %u\n",
+		   atomic_read(&sbi->s_mb_discarded));
+	return 0;
+}
+
 static struct kmem_cache *get_groupinfo_cache(int blocksize_bits)
 {
 	int cache_index = blocksize_bits - EXT4_MIN_BLOCK_LOG_SIZE;
@@ -2426,6 +2587,7 @@ int ext4_mb_add_groupinfo(struct super_block *sb, ext4_group_t group,
 	}
 	set_bit(EXT4_GROUP_INFO_NEED_INIT_BIT,
 		&(meta_group_info[i]->bb_state));
+	atomic_inc(&sbi->s_mb_uninit_groups);
 
 	/*
 	 * initialize bb_free to be able to skip
@@ -2441,9 +2603,11 @@ int ext4_mb_add_groupinfo(struct super_block *sb, ext4_group_t group,
 	}
 
 	INIT_LIST_HEAD(&meta_group_info[i]->bb_prealloc_list);
+	INIT_LIST_HEAD(&meta_group_info[i]->bb_largest_free_order_node);
 	init_rwsem(&meta_group_info[i]->alloc_sem);
 	meta_group_info[i]->bb_free_root = RB_ROOT;
 	meta_group_info[i]->bb_largest_free_order = -1;  /* uninit */
+	meta_group_info[i]->bb_group = group;
 
 #ifdef DOUBLE_CHECK
 	{
@@ -2624,6 +2788,22 @@ int ext4_mb_init(struct super_block *sb)
 		i++;
 	} while (i <= sb->s_blocksize_bits + 1);
 
+	sbi->s_mb_largest_free_orders =
+		kmalloc_array(MB_NUM_ORDERS(sb), sizeof(struct list_head),
+			      GFP_KERNEL);
+	sbi->s_mb_largest_free_orders_locks =
+		kmalloc_array(MB_NUM_ORDERS(sb), sizeof(rwlock_t), GFP_KERNEL);
+	if (!sbi->s_mb_largest_free_orders ||
+	    !sbi->s_mb_largest_free_orders_locks) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	for (i = 0; i < MB_NUM_ORDERS(sb); i++) {
+		INIT_LIST_HEAD(&sbi->s_mb_largest_free_orders[i]);
+		rwlock_init(&sbi->s_mb_largest_free_orders_locks[i]);
+	}
+	atomic_set(&sbi->s_mb_uninit_groups, 0);
+
 	spin_lock_init(&sbi->s_md_lock);
 	spin_lock_init(&sbi->s_bal_lock);
 	sbi->s_mb_free_pending = 0;
@@ -2634,6 +2814,7 @@ int ext4_mb_init(struct super_block *sb)
 	sbi->s_mb_stats = MB_DEFAULT_STATS;
 	sbi->s_mb_stream_request = MB_DEFAULT_STREAM_THRESHOLD;
 	sbi->s_mb_order2_reqs = MB_DEFAULT_ORDER2_REQS;
+	sbi->s_mb_optimize_scan = MB_DEFAULT_OPTIMIZE_SCAN;
 	/*
 	 * The default group preallocation is 512, which for 4k block
 	 * sizes translates to 2 megabytes.  However for bigalloc file
@@ -2686,6 +2867,10 @@ int ext4_mb_init(struct super_block *sb)
 	free_percpu(sbi->s_locality_groups);
 	sbi->s_locality_groups = NULL;
 out:
+	kfree(sbi->s_mb_largest_free_orders);
+	sbi->s_mb_largest_free_orders = NULL;
+	kfree(sbi->s_mb_largest_free_orders_locks);
+	sbi->s_mb_largest_free_orders_locks = NULL;
 	kfree(sbi->s_mb_offsets);
 	sbi->s_mb_offsets = NULL;
 	kfree(sbi->s_mb_maxs);
@@ -2741,6 +2926,8 @@ int ext4_mb_release(struct super_block *sb)
 		kvfree(group_info);
 		rcu_read_unlock();
 	}
+	kfree(sbi->s_mb_largest_free_orders);
+	kfree(sbi->s_mb_largest_free_orders_locks);
 	kfree(sbi->s_mb_offsets);
 	kfree(sbi->s_mb_maxs);
 	iput(sbi->s_buddy_cache);
@@ -72,6 +72,22 @@ do {									\
  */
 #define MB_DEFAULT_ORDER2_REQS		2
 
+/*
+ * number of buddy orders, order 0 is the block bitmap itself
+ */
+#define MB_NUM_ORDERS(sb)		((sb)->s_blocksize_bits + 2)
+
+/*
+ * pick groups for cr 0 and 1 from the largest free order lists
+ */
+#define MB_DEFAULT_OPTIMIZE_SCAN	1
+
+/*
+ * with mb_optimize_scan, this many groups from the goal are still
+ * scanned linearly before the lists are used, to keep locality
+ */
+#define MB_LINEAR_SCAN_GROUPS		4
+
 /*
  * default group prealloc size 512 blocks
  */
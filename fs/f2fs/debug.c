@@ -353,6 +353,11 @@ static int stat_show(struct seq_file *s, void *v)
 				si->skipped_atomic_files[BG_GC] +
 				si->skipped_atomic_files[FG_GC],
 				si->skipped_atomic_files[BG_GC]);
+		seq_puts(s, "GC time (ms): FG (BG)\n");
+		for (j = 0; j < F2FS_GC_TIME_BUCKETS; j++)
+			seq_printf(s, "  - >= %5lu : %u (%u)\n",
+				j ? 1UL << (j - 1) : 0UL,
+				si->gc_time[FG_GC][j], si->gc_time[BG_GC][j]);
 		seq_puts(s, "\nExtent Cache:\n");
 		seq_printf(s, "  - Hit Count: L1-1:%llu L1-2:%llu L2:%llu\n",
 				si->hit_largest, si->hit_cached,
@@ -1367,6 +1367,16 @@ static inline bool f2fs_time_over(struct f2fs_sb_info *sbi, int type)
 	return time_after(jiffies, sbi->last_time[type] + interval);
 }
 
+/* milliseconds until f2fs_time_over() becomes true */
+static inline unsigned int f2fs_time_to_wait(struct f2fs_sb_info *sbi,
+						int type)
+{
+	unsigned long interval = sbi->interval_time[type] * HZ;
+	long delta = (long)(sbi->last_time[type] + interval - jiffies);
+
+	return delta > 0 ? jiffies_to_msecs(delta) : 0;
+}
+
 static inline bool is_idle(struct f2fs_sb_info *sbi)
 {
 	struct block_device *bdev = sbi->sb->s_bdev;
@@ -1376,6 +1386,11 @@ static inline bool is_idle(struct f2fs_sb_info *sbi)
 	if (rl->count[BLK_RW_SYNC] || rl->count[BLK_RW_ASYNC])
 		return false;
 
+	/* blk-mq doesn't use root_rl, so also check our own writeback */
+	if (atomic_read(&sbi->nr_pages[F2FS_WB_CP_DATA]) ||
+	    atomic_read(&sbi->nr_pages[F2FS_WB_DATA]))
+		return false;
+
 	return f2fs_time_over(sbi, REQ_TIME);
 }
 
@@ -3101,6 +3116,8 @@ bool f2fs_space_for_roll_forward(struct f2fs_sb_info *sbi);
  * debug.c
  */
 #ifdef CONFIG_F2FS_STAT_FS
+#define F2FS_GC_TIME_BUCKETS	16
+
 struct f2fs_stat_info {
 	struct list_head stat_list;
 	struct f2fs_sb_info *sbi;
@@ -3142,6 +3159,9 @@ struct f2fs_stat_info {
 	unsigned int block_count[2];
 	unsigned int inplace_count;
 	unsigned long long base_mem, cache_mem, page_mem;
+
+	/* f2fs_gc() latency in ms, bucket n is [2^(n-1), 2^n), per gc_type */
+	unsigned int gc_time[2][F2FS_GC_TIME_BUCKETS];
 };
 
 static inline struct f2fs_stat_info *F2FS_STAT(struct f2fs_sb_info *sbi)
@@ -3233,6 +3253,15 @@ static inline struct f2fs_stat_info *F2FS_STAT(struct f2fs_sb_info *sbi)
 #define stat_inc_tot_blk_count(si, blks)				\
 	((si)->tot_blks += (blks))
 
+#define stat_update_gc_time(sbi, gc_type, ms)				\
+	do {								\
+		struct f2fs_stat_info *si = F2FS_STAT(sbi);		\
+		unsigned int _ms = (ms);				\
+		int bucket = _ms ? min_t(int, ilog2(_ms) + 1,		\
+					 F2FS_GC_TIME_BUCKETS - 1) : 0;	\
+		si->gc_time[gc_type][bucket]++;				\
+	} while (0)
+
 #define stat_inc_data_blk_count(sbi, blks, gc_type)			\
 	do {								\
 		struct f2fs_stat_info *si = F2FS_STAT(sbi);		\
@@ -3281,6 +3310,7 @@ void f2fs_destroy_root_stats(void);
 #define stat_inc_inplace_blocks(sbi)			do { } while (0)
 #define stat_inc_seg_count(sbi, type, gc_type)		do { } while (0)
 #define stat_inc_tot_blk_count(si, blks)		do { } while (0)
+#define stat_update_gc_time(sbi, gc_type, ms)		do { } while (0)
 #define stat_inc_data_blk_count(sbi, blks, gc_type)	do { } while (0)
 #define stat_inc_node_blk_count(sbi, blks, gc_type)	do { } while (0)
 
@@ -28,7 +28,7 @@ static int gc_thread_func(void *data)
 	struct f2fs_sb_info *sbi = data;
 	struct f2fs_gc_kthread *gc_th = sbi->gc_thread;
 	wait_queue_head_t *wq = &sbi->gc_thread->gc_wait_queue_head;
-	unsigned int wait_ms;
+	unsigned int wait_ms, busy_ms = 0;
 
 	wait_ms = gc_th->min_sleep_time;
 
@@ -37,7 +37,8 @@ static int gc_thread_func(void *data)
 		wait_event_interruptible_timeout(*wq,
 				kthread_should_stop() || freezing(current) ||
 				gc_th->gc_wake,
-				msecs_to_jiffies(wait_ms));
+				msecs_to_jiffies(busy_ms ? busy_ms : wait_ms));
+		busy_ms = 0;
 
 		/* give it a try one time */
 		if (gc_th->gc_wake)
@@ -85,6 +86,16 @@ static int gc_thread_func(void *data)
 
 		if (!is_idle(sbi)) {
 			increase_sleep_time(gc_th, &wait_ms);
+			/*
+			 * Rather than sleeping the whole backoff, look again
+			 * as soon as the device may have been idle long
+			 * enough, so gc runs in the idle windows between
+			 * bursts of requests. This only shortens the wait for
+			 * an idle device, rounds are still at least
+			 * min_sleep_time apart.
+			 */
+			busy_ms = clamp(f2fs_time_to_wait(sbi, REQ_TIME),
+					gc_th->urgent_sleep_time, wait_ms);
 			mutex_unlock(&sbi->gc_mutex);
 			goto next;
 		}
@@ -128,6 +139,7 @@ int f2fs_start_gc_thread(struct f2fs_sb_info *sbi)
 	gc_th->min_sleep_time = DEF_GC_THREAD_MIN_SLEEP_TIME;
 	gc_th->max_sleep_time = DEF_GC_THREAD_MAX_SLEEP_TIME;
 	gc_th->no_gc_sleep_time = DEF_GC_THREAD_NOGC_SLEEP_TIME;
+	gc_th->age_threshold = DEF_GC_THREAD_AGE_THRESHOLD;
 
 	gc_th->gc_wake= 0;
 
@@ -266,6 +278,29 @@ static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
 	return UINT_MAX - ((100 * (100 - u) * age) / (100 + u));
 }
 
+/*
+ * Background gc leaves sections alone that were modified less than
+ * age_threshold seconds ago: their blocks are still being overwritten or
+ * deleted, so migrating them now mostly costs extra writes.
+ */
+static bool sec_is_young(struct f2fs_sb_info *sbi, unsigned int segno)
+{
+	struct f2fs_gc_kthread *gc_th = sbi->gc_thread;
+	unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
+	unsigned int start = GET_SEG_FROM_SEC(sbi, secno);
+	unsigned long long mtime = 0;
+	unsigned int i;
+
+	if (!gc_th || !gc_th->age_threshold || sbi->gc_mode == GC_URGENT)
+		return false;
+
+	for (i = 0; i < sbi->segs_per_sec; i++)
+		mtime += get_seg_entry(sbi, start + i)->mtime;
+	mtime = div_u64(mtime, sbi->segs_per_sec);
+
+	return mtime + gc_th->age_threshold > get_mtime(sbi, true);
+}
+
 static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
 			unsigned int segno, struct victim_sel_policy *p)
 {
@@ -366,6 +401,9 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto next;
 		if (gc_type == BG_GC && test_bit(secno, dirty_i->victim_secmap))
 			goto next;
+		if (gc_type == BG_GC && p.alloc_mode == LFS &&
+					sec_is_young(sbi, segno))
+			goto next;
 
 		cost = get_gc_cost(sbi, segno, &p);
 
@@ -1143,6 +1181,7 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync,
 	unsigned long long last_skipped = sbi->skipped_atomic_files[FG_GC];
 	unsigned long long first_skipped;
 	unsigned int skipped_round = 0, round = 0;
+	ktime_t start_time = ktime_get();
 
 	trace_f2fs_gc_begin(sbi->sb, sync, background,
 				get_pages(sbi, F2FS_DIRTY_NODES),
@@ -1240,6 +1279,9 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync,
 				reserved_segments(sbi),
 				prefree_segments(sbi));
 
+	stat_update_gc_time(sbi, gc_type,
+			ktime_ms_delta(ktime_get(), start_time));
+
 	mutex_unlock(&sbi->gc_mutex);
 
 	put_gc_inode(&gc_list);
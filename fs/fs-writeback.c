@@ -1715,6 +1715,123 @@ static long __writeback_inodes_wb(struct bdi_writeback *wb,
 	return wrote;
 }
 
+/*
+ * A helper drains wb->b_io alongside the flusher.  I_SYNC already keeps
+ * two writers off the same inode, so all they share is wb->list_lock.
+ */
+struct wb_writeback_helper {
+	struct work_struct work;
+	struct bdi_writeback *wb;
+	struct wb_writeback_work wb_work;
+	atomic_t state;
+	refcount_t ref;			/* flusher and work item */
+	struct completion done;
+};
+
+enum {
+	WB_HELPER_QUEUED,
+	WB_HELPER_RUNNING,
+	WB_HELPER_CANCELLED,
+};
+
+static void wb_helper_put(struct wb_writeback_helper *h)
+{
+	if (refcount_dec_and_test(&h->ref))
+		kfree(h);
+}
+
+static void wb_helper_workfn(struct work_struct *work)
+{
+	struct wb_writeback_helper *h =
+		container_of(work, struct wb_writeback_helper, work);
+	struct bdi_writeback *wb = h->wb;
+	struct blk_plug plug;
+
+	/* the flusher may have finished the batch before we got to run */
+	if (atomic_cmpxchg(&h->state, WB_HELPER_QUEUED,
+			   WB_HELPER_RUNNING) == WB_HELPER_QUEUED) {
+		blk_start_plug(&plug);
+		spin_lock(&wb->list_lock);
+		__writeback_inodes_wb(wb, &h->wb_work);
+		spin_unlock(&wb->list_lock);
+		blk_finish_plug(&plug);
+		complete(&h->done);
+	}
+	wb_helper_put(h);
+}
+
+/*
+ * Share the batch queued on b_io between the flusher and up to
+ * bdi->writeback_workers - 1 helpers, splitting the page budget evenly.
+ * Helpers that have not started by the time the flusher is done with its
+ * share are cancelled rather than waited for, so this never depends on
+ * bdi_wq having a spare worker.  Called with wb->list_lock held, which is
+ * dropped while waiting for the helpers.
+ */
+static long wb_writeback_parallel(struct bdi_writeback *wb,
+				  struct wb_writeback_work *work)
+{
+	struct backing_dev_info *bdi = wb->bdi;
+	struct wb_writeback_helper *helpers[BDI_MAX_WRITEBACK_WORKERS];
+	unsigned int nr = READ_ONCE(bdi->writeback_workers);
+	long total = work->nr_pages;
+	long share, wrote, helped = 0;
+	unsigned int i, n = 0, runs = 0;
+
+	nr = min_t(unsigned int, nr, BDI_MAX_WRITEBACK_WORKERS);
+	if (nr <= 1 || list_is_singular(&wb->b_io))
+		return __writeback_inodes_wb(wb, work);
+
+	share = total == LONG_MAX ? LONG_MAX : DIV_ROUND_UP(total, nr);
+	for (i = 1; i < nr; i++) {
+		struct wb_writeback_helper *h;
+
+		h = kmalloc(sizeof(*h), GFP_NOWAIT | __GFP_NOWARN);
+		if (!h)
+			break;
+		INIT_WORK(&h->work, wb_helper_workfn);
+		h->wb = wb;
+		h->wb_work = *work;
+		h->wb_work.nr_pages = share;
+		h->wb_work.auto_free = 0;
+		h->wb_work.done = NULL;
+		INIT_LIST_HEAD(&h->wb_work.list);
+		atomic_set(&h->state, WB_HELPER_QUEUED);
+		refcount_set(&h->ref, 2);
+		init_completion(&h->done);
+		queue_work(bdi_wq, &h->work);
+		helpers[n++] = h;
+	}
+
+	work->nr_pages = share;
+	wrote = __writeback_inodes_wb(wb, work);
+	total -= share - work->nr_pages;
+	if (!n)
+		goto out;
+
+	spin_unlock(&wb->list_lock);
+	for (i = 0; i < n; i++) {
+		struct wb_writeback_helper *h = helpers[i];
+
+		if (atomic_cmpxchg(&h->state, WB_HELPER_QUEUED,
+				   WB_HELPER_CANCELLED) != WB_HELPER_QUEUED) {
+			wait_for_completion(&h->done);
+			helped += share - h->wb_work.nr_pages;
+			runs++;
+		}
+		wb_helper_put(h);
+	}
+	atomic_long_add(runs, &bdi->wb_helper_runs);
+	atomic_long_add(helped, &bdi->wb_helper_pages);
+	spin_lock(&wb->list_lock);
+
+	total -= helped;
+	wrote += helped;
+out:
+	work->nr_pages = total;
+	return wrote;
+}
+
 static long writeback_inodes_wb(struct bdi_writeback *wb, long nr_pages,
 				enum wb_reason reason)
 {
@@ -1808,6 +1925,8 @@ static long wb_writeback(struct bdi_writeback *wb,
 			queue_io(wb, work);
 		if (work->sb)
 			progress = writeback_sb_inodes(work->sb, wb, work);
+		else if (work->sync_mode == WB_SYNC_NONE)
+			progress = wb_writeback_parallel(wb, work);
 		else
 			progress = __writeback_inodes_wb(wb, work);
 		trace_writeback_written(wb, work);
@@ -21,6 +21,8 @@
 #include <linux/swap.h>
 #include <linux/splice.h>
 #include <linux/sched.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 
 MODULE_ALIAS_MISCDEV(FUSE_MINOR);
 MODULE_ALIAS("devname:fuse");
@@ -708,6 +710,8 @@ struct fuse_copy_state {
 	struct pipe_buffer *pipebufs;
 	struct pipe_buffer *currbuf;
 	struct pipe_inode_info *pipe;
+	void *ring_buf;
+	size_t ring_len;
 	unsigned long nr_segs;
 	struct page *pg;
 	unsigned len;
@@ -735,7 +739,8 @@ static void fuse_copy_finish(struct fuse_copy_state *cs)
 	} else if (cs->pg) {
 		if (cs->write) {
 			flush_dcache_page(cs->pg);
-			set_page_dirty_lock(cs->pg);
+			if (!cs->ring_buf)
+				set_page_dirty_lock(cs->pg);
 		}
 		put_page(cs->pg);
 	}
@@ -790,6 +795,17 @@ static int fuse_copy_fill(struct fuse_copy_state *cs)
 			cs->pipebufs++;
 			cs->nr_segs++;
 		}
+	} else if (cs->ring_buf) {
+		/* Ring slots never overlap, stay within this one */
+		if (!cs->ring_len)
+			return -EFAULT;
+
+		cs->pg = vmalloc_to_page(cs->ring_buf);
+		get_page(cs->pg);
+		cs->offset = offset_in_page(cs->ring_buf);
+		cs->len = min_t(size_t, PAGE_SIZE - cs->offset, cs->ring_len);
+		cs->ring_buf += cs->len;
+		cs->ring_len -= cs->len;
 	} else {
 		size_t off;
 		err = iov_iter_get_pages(cs->iter, &page, PAGE_SIZE, 1, &off);
@@ -1239,7 +1255,7 @@ __releases(fiq->lock)
  * request_end().  Otherwise add it to the processing list, and set
  * the 'sent' flag.
  */
-static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
+static ssize_t fuse_dev_do_read(struct fuse_dev *fud, bool nonblock,
 				struct fuse_copy_state *cs, size_t nbytes)
 {
 	ssize_t err;
@@ -1257,7 +1273,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 			break;
 		spin_unlock(&fiq->lock);
 
-		if (file->f_flags & O_NONBLOCK)
+		if (nonblock)
 			return -EAGAIN;
 		err = wait_event_interruptible_exclusive(fiq->waitq,
 				!fiq->connected || request_pending(fiq));
@@ -1373,7 +1389,8 @@ static ssize_t fuse_dev_read(struct kiocb *iocb, struct iov_iter *to)
 
 	fuse_copy_init(&cs, 1, to);
 
-	return fuse_dev_do_read(fud, file, &cs, iov_iter_count(to));
+	return fuse_dev_do_read(fud, file->f_flags & O_NONBLOCK, &cs,
+				iov_iter_count(to));
 }
 
 static ssize_t fuse_dev_splice_read(struct file *in, loff_t *ppos,
@@ -1397,7 +1414,7 @@ static ssize_t fuse_dev_splice_read(struct file *in, loff_t *ppos,
 	fuse_copy_init(&cs, 1, NULL);
 	cs.pipebufs = bufs;
 	cs.pipe = pipe;
-	ret = fuse_dev_do_read(fud, in, &cs, len);
+	ret = fuse_dev_do_read(fud, in->f_flags & O_NONBLOCK, &cs, len);
 	if (ret < 0)
 		goto out;
 
@@ -1691,7 +1708,7 @@ static int fuse_retrieve(struct fuse_conn *fc, struct inode *inode,
 		num = file_size - outarg->offset;
 
 	num_pages = (num + offset + PAGE_SIZE - 1) >> PAGE_SHIFT;
-	num_pages = min(num_pages, FUSE_MAX_PAGES_PER_REQ);
+	num_pages = min(num_pages, fc->max_pages);
 
 	req = fuse_get_req(fc, num_pages);
 	if (IS_ERR(req))
@@ -2236,11 +2253,215 @@ static int fuse_device_clone(struct fuse_conn *fc, struct file *new)
 	return 0;
 }
 
+#define FUSE_RING_MAX_SLOTS	256
+#define FUSE_RING_MAX_SLOT_SIZE	(1024 * 1024)
+
+void fuse_ring_free(struct fuse_ring *ring)
+{
+	if (ring) {
+		vfree(ring->buf);
+		kfree(ring);
+	}
+}
+
+static int fuse_ring_setup(struct fuse_dev *fud,
+			   struct fuse_ring_setup __user *argp)
+{
+	struct fuse_ring_setup setup;
+	struct fuse_ring *ring;
+	size_t slots_size;
+	int err;
+
+	if (copy_from_user(&setup, argp, sizeof(setup)))
+		return -EFAULT;
+
+	if (!is_power_of_2(setup.nr_slots) ||
+	    setup.nr_slots > FUSE_RING_MAX_SLOTS ||
+	    setup.slot_size < FUSE_MIN_READ_BUFFER ||
+	    setup.slot_size > FUSE_RING_MAX_SLOT_SIZE ||
+	    !PAGE_ALIGNED(setup.slot_size))
+		return -EINVAL;
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	mutex_init(&ring->lock);
+	ring->nr_slots = setup.nr_slots;
+	ring->slot_size = setup.slot_size;
+	slots_size = (size_t) setup.nr_slots * setup.slot_size;
+	ring->size = PAGE_SIZE + 2 * slots_size;
+
+	err = -ENOMEM;
+	ring->buf = vmalloc_user(ring->size);
+	if (!ring->buf)
+		goto err_free;
+
+	ring->hdr = ring->buf;
+	ring->req_slots = ring->buf + PAGE_SIZE;
+	ring->reply_slots = ring->req_slots + slots_size;
+
+	setup.req_offset = PAGE_SIZE;
+	setup.reply_offset = PAGE_SIZE + slots_size;
+	setup.size = ring->size;
+	err = -EFAULT;
+	if (copy_to_user(argp, &setup, sizeof(setup)))
+		goto err_free;
+
+	/* Pairs with READ_ONCE() in fuse_dev_mmap() and fuse_ring_enter() */
+	err = -EBUSY;
+	if (cmpxchg(&fud->ring, NULL, ring))
+		goto err_free;
+
+	return 0;
+
+ err_free:
+	fuse_ring_free(ring);
+	return err;
+}
+
+static void *fuse_ring_slot(struct fuse_ring *ring, void *slots, u32 index)
+{
+	index &= ring->nr_slots - 1;
+	return slots + (size_t) index * ring->slot_size;
+}
+
+/*
+ * Consume the replies posted by the server.  A malformed reply is skipped
+ * and its error returned, like a failing write() on the device would.
+ */
+static int fuse_ring_do_replies(struct fuse_dev *fud, struct fuse_ring *ring)
+{
+	struct fuse_ring_hdr *hdr = ring->hdr;
+	u32 head = ring->reply_head;
+	/* Order the slot reads after the server's update of reply_tail */
+	u32 tail = smp_load_acquire(&hdr->reply_tail);
+	struct fuse_copy_state cs;
+	ssize_t ret = 0;
+
+	/* The server can post at most one reply per slot */
+	if (tail - head > ring->nr_slots)
+		return -EINVAL;
+
+	while (head != tail && ret >= 0) {
+		void *slot = fuse_ring_slot(ring, ring->reply_slots, head);
+		size_t len = READ_ONCE(((struct fuse_out_header *) slot)->len);
+
+		fuse_copy_init(&cs, 0, NULL);
+		cs.ring_buf = slot;
+		cs.ring_len = ring->slot_size;
+		ret = fuse_dev_do_write(fud, &cs, min_t(size_t, len,
+							ring->slot_size));
+		head++;
+	}
+	ring->reply_head = head;
+	/* The server may reuse the slots once it sees the new reply_head */
+	smp_store_release(&hdr->reply_head, head);
+
+	return ret < 0 ? ret : 0;
+}
+
+/*
+ * Move pending requests into free request slots.  Only the first request
+ * may be waited for, the rest are taken as long as they are available.
+ */
+static int fuse_ring_do_requests(struct fuse_dev *fud, struct fuse_ring *ring,
+				 bool wait)
+{
+	struct fuse_ring_hdr *hdr = ring->hdr;
+	u32 tail = ring->req_tail;
+	u32 head = smp_load_acquire(&hdr->req_head);
+	struct fuse_copy_state cs;
+	ssize_t ret = 0;
+	int count = 0;
+
+	/* The server can only consume requests that were posted */
+	if (tail - head > ring->nr_slots)
+		return -EINVAL;
+
+	/*
+	 * Don't overwrite a slot before the server is done reading it.  A
+	 * req_head moved out of range meanwhile just stops the filling.
+	 */
+	while (tail - head < ring->nr_slots) {
+		void *slot = fuse_ring_slot(ring, ring->req_slots, tail);
+
+		fuse_copy_init(&cs, 1, NULL);
+		cs.ring_buf = slot;
+		cs.ring_len = ring->slot_size;
+		ret = fuse_dev_do_read(fud, !wait || count, &cs,
+				       ring->slot_size);
+		if (ret < 0)
+			break;
+		tail++;
+		count++;
+		ring->req_tail = tail;
+		/* Publish the slot contents before the new req_tail */
+		smp_store_release(&hdr->req_tail, tail);
+		head = smp_load_acquire(&hdr->req_head);
+	}
+
+	if (count || ret == -EAGAIN)
+		return count;
+	return ret;
+}
+
+static long fuse_ring_enter(struct fuse_dev *fud, u32 __user *argp)
+{
+	struct fuse_ring *ring = READ_ONCE(fud->ring);
+	u32 flags;
+	int err;
+
+	if (!ring)
+		return -EINVAL;
+
+	if (get_user(flags, argp))
+		return -EFAULT;
+
+	if (flags & ~FUSE_RING_ENTER_WAIT)
+		return -EINVAL;
+
+	mutex_lock(&ring->lock);
+	err = fuse_ring_do_replies(fud, ring);
+	if (!err)
+		err = fuse_ring_do_requests(fud, ring,
+					    flags & FUSE_RING_ENTER_WAIT);
+	mutex_unlock(&ring->lock);
+
+	return err;
+}
+
+static int fuse_dev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fuse_dev *fud = fuse_get_dev(file);
+	struct fuse_ring *ring;
+
+	if (!fud)
+		return -EPERM;
+
+	ring = READ_ONCE(fud->ring);
+	if (!ring)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, ring->buf, vma->vm_pgoff);
+}
+
 static long fuse_dev_ioctl(struct file *file, unsigned int cmd,
 			   unsigned long arg)
 {
 	int err = -ENOTTY;
 
+	if (cmd == FUSE_DEV_IOC_RING_SETUP || cmd == FUSE_DEV_IOC_RING_ENTER) {
+		struct fuse_dev *fud = fuse_get_dev(file);
+
+		if (!fud)
+			return -EPERM;
+
+		if (cmd == FUSE_DEV_IOC_RING_SETUP)
+			return fuse_ring_setup(fud, (void __user *) arg);
+		return fuse_ring_enter(fud, (u32 __user *) arg);
+	}
+
 	if (cmd == FUSE_DEV_IOC_CLONE) {
 		int oldfd;
 
@@ -2283,6 +2504,7 @@ const struct file_operations fuse_dev_operations = {
 	.poll		= fuse_dev_poll,
 	.release	= fuse_dev_release,
 	.fasync		= fuse_dev_fasync,
+	.mmap		= fuse_dev_mmap,
 	.unlocked_ioctl = fuse_dev_ioctl,
 	.compat_ioctl   = fuse_dev_ioctl,
 };
@@ -28,8 +28,11 @@
 #include <linux/refcount.h>
 #include <linux/user_namespace.h>
 
-/** Max number of pages that can be used in a single read request */
-#define FUSE_MAX_PAGES_PER_REQ 32
+/** Default max number of pages that can be used in a single read request */
+#define FUSE_DEFAULT_MAX_PAGES_PER_REQ 32
+
+/** Maximum of max_pages received in init_out */
+#define FUSE_MAX_MAX_PAGES 1024
 
 /** Bias for fi->writectr, meaning new writepages must not be sent */
 #define FUSE_NOWRITE INT_MIN
@@ -440,6 +443,41 @@ struct fuse_dev {
 
 	/** list entry on fc->devices */
 	struct list_head entry;
+
+	/** Shared request ring, if set up */
+	struct fuse_ring *ring;
+};
+
+/**
+ * Request and reply ring shared with the server
+ */
+struct fuse_ring {
+	/** Serializes FUSE_DEV_IOC_RING_ENTER */
+	struct mutex lock;
+
+	/** vmalloc_user() buffer mapped by the server */
+	void *buf;
+
+	/** Size of buf in bytes */
+	size_t size;
+
+	/** Ring indices at the start of buf */
+	struct fuse_ring_hdr *hdr;
+
+	/** Request and reply slot arrays */
+	void *req_slots;
+	void *reply_slots;
+
+	/** Number of slots in each array, a power of two */
+	unsigned int nr_slots;
+
+	/** Size of one slot, a multiple of PAGE_SIZE */
+	unsigned int slot_size;
+
+	/** Kernel copies of the indices only the kernel advances, the
+	    ones in hdr are written for the server and never read back */
+	u32 req_tail;
+	u32 reply_head;
 };
 
 /**
@@ -479,6 +517,9 @@ struct fuse_conn {
 	/** Maximum write size */
 	unsigned max_write;
 
+	/** Maximum number of pages that can be used in a single request */
+	unsigned int max_pages;
+
 	/** Input queue */
 	struct fuse_iqueue iq;
 
@@ -893,6 +934,7 @@ void fuse_conn_put(struct fuse_conn *fc);
 
 struct fuse_dev *fuse_dev_alloc(struct fuse_conn *fc);
 void fuse_dev_free(struct fuse_dev *fud);
+void fuse_ring_free(struct fuse_ring *ring);
 
 /**
  * Add connection to control filesystem
@@ -788,6 +788,12 @@ iomap_write_end(struct inode *inode, loff_t pos, unsigned len,
 	return ret;
 }
 
+/*
+ * The write actor faults in the source buffer and throttles on dirty pages
+ * once per batch of up to this many bytes rather than once per page.
+ */
+#define IOMAP_WRITE_BATCH	(16 * PAGE_SIZE)
+
 static loff_t
 iomap_write_actor(struct inode *inode, loff_t pos, loff_t length, void *data,
 		struct iomap *iomap)
@@ -798,74 +804,96 @@ iomap_write_actor(struct inode *inode, loff_t pos, loff_t length, void *data,
 	unsigned int flags = AOP_FLAG_NOFS;
 
 	do {
-		struct page *page;
-		unsigned long offset;	/* Offset into pagecache page */
-		unsigned long bytes;	/* Bytes to write to page */
-		size_t copied;		/* Bytes copied from user */
+		size_t batch;		/* Bytes faulted in ahead of the copy */
 
-		offset = offset_in_page(pos);
-		bytes = min_t(unsigned long, PAGE_SIZE - offset,
+		batch = min_t(size_t, IOMAP_WRITE_BATCH - offset_in_page(pos),
 						iov_iter_count(i));
-again:
-		if (bytes > length)
-			bytes = length;
+		if (batch > length)
+			batch = length;
 
 		/*
-		 * Bring in the user page that we will copy from _first_.
+		 * Bring in the user pages that we will copy from _first_.
 		 * Otherwise there's a nasty deadlock on copying from the
 		 * same page as we're writing to, without it being marked
 		 * up-to-date.
 		 *
 		 * Not only is this an optimisation, but it is also required
 		 * to check that the address is actually valid, when atomic
-		 * usercopies are used, below.
+		 * usercopies are used, below.  If part of the batch is not
+		 * valid, retry with just the first page so that a short
+		 * write is returned rather than -EFAULT.
 		 */
-		if (unlikely(iov_iter_fault_in_readable(i, bytes))) {
-			status = -EFAULT;
-			break;
+		if (unlikely(iov_iter_fault_in_readable(i, batch))) {
+			batch = min_t(size_t, batch,
+					PAGE_SIZE - offset_in_page(pos));
+			if (unlikely(iov_iter_fault_in_readable(i, batch))) {
+				status = -EFAULT;
+				break;
+			}
 		}
 
-		status = iomap_write_begin(inode, pos, bytes, flags, &page,
-				iomap);
-		if (unlikely(status))
-			break;
+		while (batch) {
+			struct page *page;
+			unsigned long offset;	/* Offset into pagecache page */
+			unsigned long bytes;	/* Bytes to write to page */
+			size_t copied;		/* Bytes copied from user */
 
-		if (mapping_writably_mapped(inode->i_mapping))
-			flush_dcache_page(page);
+			offset = offset_in_page(pos);
+			bytes = min_t(unsigned long, PAGE_SIZE - offset, batch);
 
-		copied = iov_iter_copy_from_user_atomic(page, i, offset, bytes);
+			status = iomap_write_begin(inode, pos, bytes, flags,
+					&page, iomap);
+			if (unlikely(status))
+				goto out;
 
-		flush_dcache_page(page);
+			if (mapping_writably_mapped(inode->i_mapping))
+				flush_dcache_page(page);
 
-		status = iomap_write_end(inode, pos, bytes, copied, page,
-				iomap);
-		if (unlikely(status < 0))
-			break;
-		copied = status;
+			copied = iov_iter_copy_from_user_atomic(page, i, offset,
+					bytes);
 
-		cond_resched();
+			flush_dcache_page(page);
 
-		iov_iter_advance(i, copied);
-		if (unlikely(copied == 0)) {
-			/*
-			 * If we were unable to copy any data at all, we must
-			 * fall back to a single segment length write.
-			 *
-			 * If we didn't fallback here, we could livelock
-			 * because not all segments in the iov can be copied at
-			 * once without a pagefault.
-			 */
-			bytes = min_t(unsigned long, PAGE_SIZE - offset,
+			status = iomap_write_end(inode, pos, bytes, copied,
+					page, iomap);
+			if (unlikely(status < 0))
+				goto out;
+			copied = status;
+
+			cond_resched();
+
+			iov_iter_advance(i, copied);
+			if (unlikely(copied == 0)) {
+				/*
+				 * If we were unable to copy any data at all, we
+				 * must fall back to a single segment length
+				 * write.
+				 *
+				 * If we didn't fallback here, we could livelock
+				 * because not all segments in the iov can be
+				 * copied at once without a pagefault.
+				 */
+				batch = min_t(unsigned long, PAGE_SIZE - offset,
 						iov_iter_single_seg_count(i));
-			goto again;
+				if (batch > length)
+					batch = length;
+				if (unlikely(iov_iter_fault_in_readable(i,
+								batch))) {
+					status = -EFAULT;
+					goto out;
+				}
+				continue;
+			}
+			pos += copied;
+			written += copied;
+			length -= copied;
+			batch -= copied;
 		}
-		pos += copied;
-		written += copied;
-		length -= copied;
 
 		balance_dirty_pages_ratelimited(inode->i_mapping);
 	} while (iov_iter_count(i) && length);
 
+out:
 	return written ? written : status;
 }
 
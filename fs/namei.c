@@ -40,6 +40,7 @@
 #include <linux/init_task.h>
 #include <linux/uaccess.h>
 #include <linux/build_bug.h>
+#include <linux/sysctl.h>
 
 #include "internal.h"
 #include "mount.h"
@@ -654,6 +655,40 @@ static bool legitimize_links(struct nameidata *nd)
  * to restart the path walk from the beginning in ref-walk mode.
  */
 
+/*
+ * Lookup statistics, reported through fs.lookup-state.  They show how often
+ * RCU-walk has to give way to ref-walk, which is where lookups get slow.
+ */
+enum lookup_stat_item {
+	LOOKUP_STAT_UNLAZY_CHILD,	/* left RCU-walk in mid-path */
+	LOOKUP_STAT_UNLAZY_FAILED,	/* could not legitimize the RCU-walk */
+	LOOKUP_STAT_RESTART,		/* -ECHILD, walk redone in ref-walk */
+	LOOKUP_STAT_REVAL,		/* -ESTALE, walk redone with REVAL */
+	NR_LOOKUP_STAT
+};
+
+static DEFINE_PER_CPU(unsigned long, lookup_stat[NR_LOOKUP_STAT]);
+
+#define lookup_stat_inc(item)	this_cpu_inc(lookup_stat[item])
+
+#if defined(CONFIG_SYSCTL) && defined(CONFIG_PROC_FS)
+int proc_lookup_state(struct ctl_table *table, int write,
+		      void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	unsigned long vals[NR_LOOKUP_STAT] = { 0 };
+	struct ctl_table t = *table;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu)
+		for (i = 0; i < NR_LOOKUP_STAT; i++)
+			vals[i] += per_cpu(lookup_stat[i], cpu);
+
+	t.data = vals;
+	t.maxlen = sizeof(vals);
+	return proc_doulongvec_minmax(&t, write, buffer, lenp, ppos);
+}
+#endif
+
 /**
  * unlazy_walk - try to switch to ref-walk mode.
  * @nd: nameidata pathwalk data
@@ -692,6 +727,7 @@ static int unlazy_walk(struct nameidata *nd)
 		nd->root.mnt = NULL;
 out:
 	rcu_read_unlock();
+	lookup_stat_inc(LOOKUP_STAT_UNLAZY_FAILED);
 	return -ECHILD;
 }
 
@@ -712,6 +748,7 @@ static int unlazy_child(struct nameidata *nd, struct dentry *dentry, unsigned se
 {
 	BUG_ON(!(nd->flags & LOOKUP_RCU));
 
+	lookup_stat_inc(LOOKUP_STAT_UNLAZY_CHILD);
 	nd->flags &= ~LOOKUP_RCU;
 	if (unlikely(!legitimize_links(nd)))
 		goto out2;
@@ -742,6 +779,7 @@ static int unlazy_child(struct nameidata *nd, struct dentry *dentry, unsigned se
 		if (unlikely(!legitimize_path(nd, &nd->root, nd->root_seq))) {
 			rcu_read_unlock();
 			dput(dentry);
+			lookup_stat_inc(LOOKUP_STAT_UNLAZY_FAILED);
 			return -ECHILD;
 		}
 	}
@@ -758,6 +796,7 @@ static int unlazy_child(struct nameidata *nd, struct dentry *dentry, unsigned se
 drop_root_mnt:
 	if (!(nd->flags & LOOKUP_ROOT))
 		nd->root.mnt = NULL;
+	lookup_stat_inc(LOOKUP_STAT_UNLAZY_FAILED);
 	return -ECHILD;
 }
 
@@ -2347,10 +2386,14 @@ static int filename_lookup(int dfd, struct filename *name, unsigned flags,
 	}
 	set_nameidata(&nd, dfd, name);
 	retval = path_lookupat(&nd, flags | LOOKUP_RCU, path);
-	if (unlikely(retval == -ECHILD))
+	if (unlikely(retval == -ECHILD)) {
+		lookup_stat_inc(LOOKUP_STAT_RESTART);
 		retval = path_lookupat(&nd, flags, path);
-	if (unlikely(retval == -ESTALE))
+	}
+	if (unlikely(retval == -ESTALE)) {
+		lookup_stat_inc(LOOKUP_STAT_REVAL);
 		retval = path_lookupat(&nd, flags | LOOKUP_REVAL, path);
+	}
 
 	if (likely(!retval))
 		audit_inode(name, path->dentry, flags & LOOKUP_PARENT);
@@ -2387,10 +2430,14 @@ static struct filename *filename_parentat(int dfd, struct filename *name,
 		return name;
 	set_nameidata(&nd, dfd, name);
 	retval = path_parentat(&nd, flags | LOOKUP_RCU, parent);
-	if (unlikely(retval == -ECHILD))
+	if (unlikely(retval == -ECHILD)) {
+		lookup_stat_inc(LOOKUP_STAT_RESTART);
 		retval = path_parentat(&nd, flags, parent);
-	if (unlikely(retval == -ESTALE))
+	}
+	if (unlikely(retval == -ESTALE)) {
+		lookup_stat_inc(LOOKUP_STAT_REVAL);
 		retval = path_parentat(&nd, flags | LOOKUP_REVAL, parent);
+	}
 	if (likely(!retval)) {
 		*last = nd.last;
 		*type = nd.last_type;
@@ -2716,10 +2763,14 @@ filename_mountpoint(int dfd, struct filename *name, struct path *path,
 		return PTR_ERR(name);
 	set_nameidata(&nd, dfd, name);
 	error = path_mountpoint(&nd, flags | LOOKUP_RCU, path);
-	if (unlikely(error == -ECHILD))
+	if (unlikely(error == -ECHILD)) {
+		lookup_stat_inc(LOOKUP_STAT_RESTART);
 		error = path_mountpoint(&nd, flags, path);
-	if (unlikely(error == -ESTALE))
+	}
+	if (unlikely(error == -ESTALE)) {
+		lookup_stat_inc(LOOKUP_STAT_REVAL);
 		error = path_mountpoint(&nd, flags | LOOKUP_REVAL, path);
+	}
 	if (likely(!error))
 		audit_inode(name, path->dentry, 0);
 	restore_nameidata();
@@ -3565,10 +3616,14 @@ struct file *do_filp_open(int dfd, struct filename *pathname,
 
 	set_nameidata(&nd, dfd, pathname);
 	filp = path_openat(&nd, op, flags | LOOKUP_RCU);
-	if (unlikely(filp == ERR_PTR(-ECHILD)))
+	if (unlikely(filp == ERR_PTR(-ECHILD))) {
+		lookup_stat_inc(LOOKUP_STAT_RESTART);
 		filp = path_openat(&nd, op, flags);
-	if (unlikely(filp == ERR_PTR(-ESTALE)))
+	}
+	if (unlikely(filp == ERR_PTR(-ESTALE))) {
+		lookup_stat_inc(LOOKUP_STAT_REVAL);
 		filp = path_openat(&nd, op, flags | LOOKUP_REVAL);
+	}
 	restore_nameidata();
 	return filp;
 }
@@ -3593,10 +3648,14 @@ struct file *do_file_open_root(struct dentry *dentry, struct vfsmount *mnt,
 
 	set_nameidata(&nd, -1, filename);
 	file = path_openat(&nd, op, flags | LOOKUP_RCU);
-	if (unlikely(file == ERR_PTR(-ECHILD)))
+	if (unlikely(file == ERR_PTR(-ECHILD))) {
+		lookup_stat_inc(LOOKUP_STAT_RESTART);
 		file = path_openat(&nd, op, flags);
-	if (unlikely(file == ERR_PTR(-ESTALE)))
+	}
+	if (unlikely(file == ERR_PTR(-ESTALE))) {
+		lookup_stat_inc(LOOKUP_STAT_REVAL);
 		file = path_openat(&nd, op, flags | LOOKUP_REVAL);
+	}
 	restore_nameidata();
 	putname(filename);
 	return file;
@@ -125,6 +125,8 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 	struct file *new_file;
 	loff_t old_pos = 0;
 	loff_t new_pos = 0;
+	loff_t data_pos = -1;
+	bool skip_hole = false;
 	int error = 0;
 
 	if (len == 0)
@@ -147,7 +149,10 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 	/* Couldn't clone, so now we try to copy the data */
 	error = 0;
 
-	/* FIXME: copy up sparse files efficiently */
+	/* Holes can be skipped if the lower fs can tell us where they are */
+	if ((old_file->f_mode & FMODE_LSEEK) && old_file->f_op->llseek)
+		skip_hole = true;
+
 	while (len) {
 		size_t this_len = OVL_COPY_UP_CHUNK_SIZE;
 		long bytes;
@@ -160,6 +165,27 @@ static int ovl_copy_up_data(struct path *old, struct path *new, loff_t len)
 			break;
 		}
 
+		/*
+		 * Don't fill holes of sparse lower files with zeroes, that
+		 * costs both copy up time and upper disk space.  Whenever we
+		 * have moved past the last data position found, ask for the
+		 * next one and jump over the hole in between.  The file size
+		 * is set by the caller, so a hole at the end is preserved
+		 * too.  Without SEEK_DATA support we copy everything.
+		 */
+		if (skip_hole && data_pos < old_pos) {
+			data_pos = vfs_llseek(old_file, old_pos, SEEK_DATA);
+			if (data_pos > old_pos) {
+				len -= min(len, data_pos - old_pos);
+				old_pos = new_pos = data_pos;
+				continue;
+			} else if (data_pos == -ENXIO) {
+				break;
+			} else if (data_pos < 0) {
+				skip_hole = false;
+			}
+		}
+
 		bytes = do_splice_direct(old_file, &old_pos,
 					 new_file, &new_pos,
 					 this_len, SPLICE_F_MOVE);
@@ -543,8 +569,12 @@ static int ovl_copy_up_inode(struct ovl_copy_up_ctx *c, struct dentry *temp)
 			return err;
 	}
 
+	/*
+	 * Metacopy files get no data at all, and data copy up leaves out
+	 * a trailing hole, so set the size of regular files explicitly.
+	 */
 	inode_lock(temp->d_inode);
-	if (c->metacopy)
+	if (S_ISREG(c->stat.mode))
 		err = ovl_set_size(temp, &c->stat);
 	if (!err)
 		err = ovl_set_attr(temp, &c->stat);
@@ -35,6 +35,14 @@
  */
 unsigned int pipe_max_size = 1048576;
 
+/*
+ * The size of a newly created pipe, including the internal pipe used by
+ * sendfile() and splice() between two files.  Can be set by root in
+ * /proc/sys/fs/pipe-default-size, it is capped by pipe-max-size for
+ * non-root users and by the per-user limits like F_SETPIPE_SZ.
+ */
+unsigned int pipe_default_size = PIPE_DEF_BUFFERS * PAGE_SIZE;
+
 /* Maximum allocatable pages per user. Hard limit is unset by default, soft
  * matches default values.
  */
@@ -639,7 +647,7 @@ static bool is_unprivileged_user(void)
 struct pipe_inode_info *alloc_pipe_info(void)
 {
 	struct pipe_inode_info *pipe;
-	unsigned long pipe_bufs = PIPE_DEF_BUFFERS;
+	unsigned long pipe_bufs = READ_ONCE(pipe_default_size) >> PAGE_SHIFT;
 	struct user_struct *user = get_current_user();
 	unsigned long user_bufs;
 	unsigned int max_size = READ_ONCE(pipe_max_size);
@@ -712,8 +712,14 @@ static int smaps_hugetlb_range(pte_t *pte, unsigned long hmask,
 }
 #endif /* HUGETLB_PAGE */
 
+/*
+ * Gather mem stats from @vma with the indicated beginning
+ * address @start, and keep them in @mss.
+ *
+ * Use vm_start of @vma as the beginning address if @start is 0.
+ */
 static void smap_gather_stats(struct vm_area_struct *vma,
-			     struct mem_size_stats *mss)
+			     struct mem_size_stats *mss, unsigned long start)
 {
 	struct mm_walk smaps_walk = {
 		.pmd_entry = smaps_pte_range,
@@ -739,7 +745,16 @@ static void smap_gather_stats(struct vm_area_struct *vma,
 		 * Unless we know that the shmem object (or the part mapped by
 		 * our VMA) has no swapped out pages at all.
 		 */
-		unsigned long shmem_swapped = shmem_swap_usage(vma);
+		unsigned long shmem_swapped;
+
+		/* Resuming in the middle: the head is already accounted */
+		if (start)
+			shmem_swapped = shmem_partial_swap_usage(
+					vma->vm_file->f_mapping,
+					linear_page_index(vma, start),
+					linear_page_index(vma, vma->vm_end));
+		else
+			shmem_swapped = shmem_swap_usage(vma);
 
 		if (!shmem_swapped || (vma->vm_flags & VM_SHARED) ||
 					!(vma->vm_flags & VM_WRITE)) {
@@ -751,7 +766,10 @@ static void smap_gather_stats(struct vm_area_struct *vma,
 	}
 #endif
 	/* mmap_sem is held in m_start */
-	walk_page_vma(vma, &smaps_walk);
+	if (!start)
+		walk_page_vma(vma, &smaps_walk);
+	else
+		walk_page_range(start, vma->vm_end, &smaps_walk);
 }
 
 #define SEQ_PUT_DEC(str, val) \
@@ -789,7 +807,7 @@ static int show_smap(struct seq_file *m, void *v)
 
 	memset(&mss, 0, sizeof(mss));
 
-	smap_gather_stats(vma, &mss);
+	smap_gather_stats(vma, &mss, 0);
 
 	show_map_vma(m, vma);
 
@@ -817,7 +835,7 @@ static int show_smaps_rollup(struct seq_file *m, void *v)
 	struct mem_size_stats mss;
 	struct mm_struct *mm;
 	struct vm_area_struct *vma;
-	unsigned long last_vma_end = 0;
+	unsigned long start, last_vma_end = 0;
 	int ret = 0;
 
 	priv->task = get_proc_task(priv->inode);
@@ -838,13 +856,43 @@ static int show_smaps_rollup(struct seq_file *m, void *v)
 
 	hold_task_mempolicy(priv);
 
-	for (vma = priv->mm->mmap; vma; vma = vma->vm_next) {
-		smap_gather_stats(vma, &mss);
+	vma = priv->mm->mmap;
+	start = vma ? vma->vm_start : 0;
+	while (vma) {
+		smap_gather_stats(vma, &mss, 0);
 		last_vma_end = vma->vm_end;
+		vma = vma->vm_next;
+
+		/*
+		 * A monitoring agent reading this for many processes must not
+		 * hold off mmap, munmap and friends for the whole walk: drop
+		 * mmap_sem whenever a writer is waiting and carry on from
+		 * where we stopped.
+		 */
+		if (vma && rwsem_is_contended(&mm->mmap_sem)) {
+			up_read(&mm->mmap_sem);
+			ret = down_read_killable(&mm->mmap_sem);
+			if (ret) {
+				release_task_mempolicy(priv);
+				goto out_put_mm;
+			}
+
+			/*
+			 * The vma we stopped at may have been unmapped, split
+			 * or merged meanwhile. Resume from the first vma that
+			 * ends above last_vma_end, walking only the part of it
+			 * that was not covered yet.
+			 */
+			vma = find_vma(mm, last_vma_end);
+			if (vma && vma->vm_start < last_vma_end) {
+				smap_gather_stats(vma, &mss, last_vma_end);
+				last_vma_end = vma->vm_end;
+				vma = vma->vm_next;
+			}
+		}
 	}
 
-	show_vma_header_prefix(m, priv->mm->mmap->vm_start,
-			       last_vma_end, 0, 0, 0, 0);
+	show_vma_header_prefix(m, start, last_vma_end, 0, 0, 0, 0);
 	seq_pad(m, ' ');
 	seq_puts(m, "[rollup]\n");
 
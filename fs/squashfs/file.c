@@ -46,6 +46,7 @@
 #include <linux/slab.h>
 #include <linux/string.h>
 #include <linux/pagemap.h>
+#include <linux/mm_inline.h>
 #include <linux/mutex.h>
 
 #include "squashfs_fs.h"
@@ -508,6 +509,51 @@ static int squashfs_readpage(struct file *file, struct page *page)
 }
 
 
+/*
+ * Pages of regular datablocks are handed to squashfs_readahead_block(),
+ * which decompresses whole blocks asynchronously.  Fragments, sparse and
+ * partially cached blocks go through squashfs_readpage().
+ */
+static void squashfs_readahead_page(struct file *file, struct page *page)
+{
+	struct inode *inode = page->mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int index = page->index >> (msblk->block_log - PAGE_SHIFT);
+	int file_end = i_size_read(inode) >> msblk->block_log;
+
+	if (index < file_end) {
+		u64 block = 0;
+		int bsize = read_blocklist(inode, index, &block);
+
+		if (bsize > 0 && !squashfs_readahead_block(page, block, bsize,
+							   msblk->block_size))
+			return;
+	}
+
+	squashfs_readpage(file, page);
+}
+
+static int squashfs_readpages(struct file *file, struct address_space *mapping,
+	struct list_head *pages, unsigned int nr_pages)
+{
+	gfp_t gfp = readahead_gfp_mask(mapping);
+	struct page *page;
+
+	while (!list_empty(pages)) {
+		page = lru_to_page(pages);
+		list_del(&page->lru);
+
+		/* Already added as part of an earlier block of this request */
+		if (!add_to_page_cache_lru(page, mapping, page->index, gfp))
+			squashfs_readahead_page(file, page);
+		put_page(page);
+	}
+
+	return 0;
+}
+
+
 const struct address_space_operations squashfs_aops = {
-	.readpage = squashfs_readpage
+	.readpage = squashfs_readpage,
+	.readpages = squashfs_readpages
 };
@@ -36,3 +36,10 @@ int squashfs_readpage_block(struct page *page, u64 block, int bsize, int expecte
 	squashfs_cache_put(buffer);
 	return res;
 }
+
+/* Without direct decompression, readahead goes page by page */
+int squashfs_readahead_block(struct page *page, u64 block, int bsize,
+	int expected)
+{
+	return -EOPNOTSUPP;
+}
@@ -13,6 +13,7 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -23,6 +24,62 @@
 static int squashfs_read_cache(struct page *target_page, u64 block, int bsize,
 	int pages, struct page **page, int bytes);
 
+/*
+ * Decompress a datablock into the locked page cache pages covering it, and
+ * mark them uptodate (or errored), unlock and release them.  Target_page,
+ * if any, is neither released nor, on error, marked by us.
+ */
+static int squashfs_read_direct(struct inode *inode, u64 block, int bsize,
+	int expected, struct page **page, int pages,
+	struct squashfs_page_actor *actor, struct page *target_page)
+{
+	int i, bytes, res;
+	void *pageaddr;
+
+	/* Decompress directly into the page cache buffers */
+	res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
+	if (res < 0)
+		goto mark_errored;
+
+	if (res != expected) {
+		res = -EIO;
+		goto mark_errored;
+	}
+
+	/* Last page may have trailing bytes not filled */
+	bytes = res % PAGE_SIZE;
+	if (bytes) {
+		pageaddr = kmap_atomic(page[pages - 1]);
+		memset(pageaddr + bytes, 0, PAGE_SIZE - bytes);
+		kunmap_atomic(pageaddr);
+	}
+
+	/* Mark pages as uptodate, unlock and release */
+	for (i = 0; i < pages; i++) {
+		flush_dcache_page(page[i]);
+		SetPageUptodate(page[i]);
+		unlock_page(page[i]);
+		if (page[i] != target_page)
+			put_page(page[i]);
+	}
+
+	return 0;
+
+mark_errored:
+	/* Decompression failed, mark pages as errored.  Target_page is
+	 * dealt with by the caller
+	 */
+	for (i = 0; i < pages; i++) {
+		if (page[i] == target_page)
+			continue;
+		flush_dcache_page(page[i]);
+		SetPageError(page[i]);
+		unlock_page(page[i]);
+		put_page(page[i]);
+	}
+	return res;
+}
+
 /* Read separately compressed datablock directly into page cache */
 int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 	int expected)
@@ -35,10 +92,9 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 	int mask = (1 << (msblk->block_log - PAGE_SHIFT)) - 1;
 	int start_index = target_page->index & ~mask;
 	int end_index = start_index | mask;
-	int i, n, pages, missing_pages, bytes, res = -ENOMEM;
+	int i, n, pages, missing_pages, res = -ENOMEM;
 	struct page **page;
 	struct squashfs_page_actor *actor;
-	void *pageaddr;
 
 	if (end_index > file_end)
 		end_index = file_end;
@@ -91,37 +147,9 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 		goto out;
 	}
 
-	/* Decompress directly into the page cache buffers */
-	res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
-	if (res < 0)
-		goto mark_errored;
-
-	if (res != expected) {
-		res = -EIO;
-		goto mark_errored;
-	}
-
-	/* Last page may have trailing bytes not filled */
-	bytes = res % PAGE_SIZE;
-	if (bytes) {
-		pageaddr = kmap_atomic(page[pages - 1]);
-		memset(pageaddr + bytes, 0, PAGE_SIZE - bytes);
-		kunmap_atomic(pageaddr);
-	}
-
-	/* Mark pages as uptodate, unlock and release */
-	for (i = 0; i < pages; i++) {
-		flush_dcache_page(page[i]);
-		SetPageUptodate(page[i]);
-		unlock_page(page[i]);
-		if (page[i] != target_page)
-			put_page(page[i]);
-	}
-
-	kfree(actor);
-	kfree(page);
-
-	return 0;
+	res = squashfs_read_direct(inode, block, bsize, expected, page, pages,
+				   actor, target_page);
+	goto out;
 
 mark_errored:
 	/* Decompression failed, mark pages as errored.  Target_page is
@@ -142,6 +170,107 @@ int squashfs_readpage_block(struct page *target_page, u64 block, int bsize,
 	return res;
 }
 
+struct squashfs_readahead_work {
+	struct work_struct work;
+	struct inode *inode;
+	u64 block;
+	int bsize;
+	int expected;
+	int pages;
+	struct page **page;
+	struct squashfs_page_actor *actor;
+};
+
+static void squashfs_readahead_work_fn(struct work_struct *work)
+{
+	struct squashfs_readahead_work *ra = container_of(work,
+		struct squashfs_readahead_work, work);
+
+	/* The locked pages pin the inode until squashfs_read_direct() ends */
+	squashfs_read_direct(ra->inode, ra->block, ra->bsize, ra->expected,
+			     ra->page, ra->pages, ra->actor, NULL);
+
+	kfree(ra->actor);
+	kfree(ra->page);
+	kfree(ra);
+}
+
+/*
+ * Readahead of a separately compressed datablock.  Grab all the pages
+ * covered by the block and decompress straight into them from an unbound
+ * workqueue, so the blocks of one readahead request are decompressed in
+ * parallel on several CPUs.  Returns 0 once the read is queued, the pages
+ * are then unlocked when it completes.  Otherwise nothing was done and the
+ * caller should read first_page through squashfs_readpage_block().
+ */
+int squashfs_readahead_block(struct page *first_page, u64 block, int bsize,
+	int expected)
+{
+	struct inode *inode = first_page->mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+
+	int file_end = (i_size_read(inode) - 1) >> PAGE_SHIFT;
+	int mask = (1 << (msblk->block_log - PAGE_SHIFT)) - 1;
+	int start_index = first_page->index & ~mask;
+	int end_index = start_index | mask;
+	struct squashfs_readahead_work *ra;
+	int i, n;
+
+	if (end_index > file_end)
+		end_index = file_end;
+
+	ra = kzalloc(sizeof(*ra), GFP_KERNEL);
+	if (ra == NULL)
+		return -ENOMEM;
+
+	ra->pages = end_index - start_index + 1;
+	ra->page = kmalloc_array(ra->pages, sizeof(void *), GFP_KERNEL);
+	if (ra->page == NULL)
+		goto out;
+
+	ra->actor = squashfs_page_actor_init_special(ra->page, ra->pages, 0);
+	if (ra->actor == NULL)
+		goto out;
+
+	for (i = 0, n = start_index; i < ra->pages; i++, n++) {
+		if (n == first_page->index) {
+			get_page(first_page);
+			ra->page[i] = first_page;
+			continue;
+		}
+
+		ra->page[i] = grab_cache_page_nowait(first_page->mapping, n);
+		if (ra->page[i] && PageUptodate(ra->page[i])) {
+			unlock_page(ra->page[i]);
+			put_page(ra->page[i]);
+			ra->page[i] = NULL;
+		}
+		if (ra->page[i] == NULL)
+			goto release;
+	}
+
+	ra->inode = inode;
+	ra->block = block;
+	ra->bsize = bsize;
+	ra->expected = expected;
+	INIT_WORK(&ra->work, squashfs_readahead_work_fn);
+	queue_work(system_unbound_wq, &ra->work);
+	return 0;
+
+release:
+	/* Leave the block to squashfs_readpage_block() and its fallbacks */
+	while (i--) {
+		if (ra->page[i] != first_page)
+			unlock_page(ra->page[i]);
+		put_page(ra->page[i]);
+	}
+out:
+	kfree(ra->actor);
+	kfree(ra->page);
+	kfree(ra);
+	return -EAGAIN;
+}
+
 
 static int squashfs_read_cache(struct page *target_page, u64 block, int bsize,
 	int pages, struct page **page, int bytes)
@@ -73,6 +73,7 @@ void squashfs_copy_cache(struct page *, struct squashfs_cache_entry *, int,
 
 /* file_xxx.c */
 extern int squashfs_readpage_block(struct page *, u64, int, int);
+extern int squashfs_readahead_block(struct page *, u64, int, int);
 
 /* id.c */
 extern int squashfs_get_id(struct super_block *, unsigned int, unsigned int *);
@@ -157,6 +157,7 @@ static void destroy_super_work(struct work_struct *work)
 							destroy_work);
 	int i;
 
+	percpu_counter_destroy(&s->s_nr_negative_dentry);
 	for (i = 0; i < SB_FREEZE_LEVELS; i++)
 		percpu_free_rwsem(&s->s_writers.rw_sem[i]);
 	kfree(s);
@@ -235,6 +236,9 @@ static struct super_block *alloc_super(struct file_system_type *type, int flags,
 			goto fail;
 	}
 	init_waitqueue_head(&s->s_writers.wait_unfrozen);
+	if (percpu_counter_init(&s->s_nr_negative_dentry, 0, GFP_KERNEL))
+		goto fail;
+	INIT_WORK(&s->s_negative_dentry_work, prune_negative_dentries);
 	s->s_bdi = &noop_backing_dev_info;
 	s->s_flags = flags;
 	if (s->s_user_ns != &init_user_ns)
@@ -327,6 +331,7 @@ void deactivate_locked_super(struct super_block *s)
 		cleancache_invalidate_fs(s);
 		unregister_shrinker(&s->s_shrink);
 		fs->kill_sb(s);
+		cancel_work_sync(&s->s_negative_dentry_work);
 
 		/*
 		 * Since list_lru_destroy() may sleep, we cannot call it from
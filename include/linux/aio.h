@@ -23,5 +23,6 @@ static inline void kiocb_set_cancel_fn(struct kiocb *req,
 /* for sysctl: */
 extern unsigned long aio_nr;
 extern unsigned long aio_max_nr;
+extern int aio_buffered_offload;
 
 #endif /* __LINUX__AIO_H */
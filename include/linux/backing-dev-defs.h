@@ -87,6 +87,9 @@ struct bdi_writeback_congested {
 #endif
 };
 
+/* upper bound for backing_dev_info->writeback_workers */
+#define BDI_MAX_WRITEBACK_WORKERS	16
+
 /*
  * Each wb (bdi_writeback) can perform writeback operations, is measured
  * and throttled, independently.  Without cgroup writeback, each bdi
@@ -127,6 +130,7 @@ struct bdi_writeback {
 	unsigned long written_stamp;	/* pages written at bw_time_stamp */
 	unsigned long write_bandwidth;	/* the estimated write bandwidth */
 	unsigned long avg_write_bandwidth; /* further smoothed write bw, > 0 */
+	unsigned long avg_write_latency; /* smoothed completion latency, ms */
 
 	/*
 	 * The base dirty throttle rate, re-calculated on every 200ms.
@@ -168,6 +172,9 @@ struct backing_dev_info {
 	struct list_head bdi_list;
 	unsigned long ra_pages;	/* max readahead in PAGE_SIZE units */
 	unsigned long io_pages;	/* max allowed IO size */
+	bool ra_adaptive;	/* scale per-file windows by hit rate */
+	atomic_long_t ra_hit_pages;	/* readahead pages used */
+	atomic_long_t ra_miss_pages;	/* readahead pages never read */
 	congested_fn *congested_fn; /* Function pointer if device is md/dm */
 	void *congested_data;	/* Pointer to aux data for congested func */
 
@@ -177,6 +184,10 @@ struct backing_dev_info {
 	unsigned int capabilities; /* Device capabilities */
 	unsigned int min_ratio;
 	unsigned int max_ratio, max_prop_frac;
+	unsigned int latency_target_ms;	/* 0: limits from bandwidth alone */
+	unsigned int writeback_workers;	/* concurrent flushers per wb */
+	atomic_long_t wb_helper_runs;	/* helper flusher passes */
+	atomic_long_t wb_helper_pages;	/* pages written by helpers */
 
 	/*
 	 * Sum of avg_write_bw of wbs with dirty inodes.  > 0 if there are
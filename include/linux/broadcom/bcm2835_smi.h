@@ -52,7 +52,11 @@
 #define BCM2835_SMI_IOC_GET_SETTINGS    _IO(BCM2835_SMI_IOC_MAGIC, 0)
 #define BCM2835_SMI_IOC_WRITE_SETTINGS  _IO(BCM2835_SMI_IOC_MAGIC, 1)
 #define BCM2835_SMI_IOC_ADDRESS	 _IO(BCM2835_SMI_IOC_MAGIC, 2)
-#define BCM2835_SMI_IOC_MAX	     2
+#define BCM2835_SMI_IOC_STREAM_SETUP \
+	_IOWR(BCM2835_SMI_IOC_MAGIC, 3, struct smi_stream_config)
+#define BCM2835_SMI_IOC_STREAM_START	_IO(BCM2835_SMI_IOC_MAGIC, 4)
+#define BCM2835_SMI_IOC_STREAM_STOP	_IO(BCM2835_SMI_IOC_MAGIC, 5)
+#define BCM2835_SMI_IOC_MAX	     5
 
 #define SMI_WIDTH_8BIT 0
 #define SMI_WIDTH_16BIT 1
@@ -99,6 +103,35 @@ struct smi_settings {
 	int dma_panic_write_thresh;
 };
 
+/* Streaming reads
+ *
+ * BCM2835_SMI_IOC_STREAM_SETUP allocates a ring of buffer_count buffers of
+ * buffer_size bytes (a multiple of the page size) and returns the mmap()
+ * offsets of a control page (struct smi_stream_ctrl) and of the ring.
+ * Once BCM2835_SMI_IOC_STREAM_START has been issued, cyclic DMA fills the
+ * buffers in order and bumps producer after each one, waking poll(). The
+ * application consumes buffer (consumer % buffer_count) and then bumps
+ * consumer. The DMA never waits for the application: when producer runs
+ * more than buffer_count ahead of consumer, data was overwritten and
+ * overruns is incremented. The stream belongs to the file that set it up
+ * and stops when that file is closed.
+ */
+#define SMI_STREAM_MAX_BUFFERS 64
+#define SMI_STREAM_MAX_SIZE (32 * 1024 * 1024)
+
+struct smi_stream_config {
+	uint32_t buffer_size;
+	uint32_t buffer_count;
+	uint32_t ctrl_offset;	/* returned */
+	uint32_t ring_offset;	/* returned */
+};
+
+struct smi_stream_ctrl {
+	uint32_t producer;	/* written by the kernel */
+	uint32_t consumer;	/* written by the application */
+	uint32_t overruns;
+};
+
 /****************************************************************************
 *
 *   Declare exported SMI functions
@@ -139,6 +172,14 @@ void bcm2835_smi_read_buf(
 void bcm2835_smi_set_address(struct bcm2835_smi_instance *inst,
 	unsigned int address);
 
+int bcm2835_smi_stream_start(struct bcm2835_smi_instance *inst,
+	dma_addr_t buf, size_t buf_len, size_t period_len,
+	void (*callback)(void *param, unsigned int periods), void *param);
+
+void bcm2835_smi_stream_stop(struct bcm2835_smi_instance *inst);
+
+struct device *bcm2835_smi_dma_dev(struct bcm2835_smi_instance *inst);
+
 ssize_t bcm2835_smi_user_dma(
 	struct bcm2835_smi_instance *inst,
 	enum dma_transfer_direction dma_dir,
@@ -35,6 +35,8 @@ enum vc_sm_cma_cmd_e {
 
 	VC_SM_CMA_CMD_CLEAN_INVALID2,
 
+	VC_SM_CMA_CMD_SYNC_DMABUFS,
+
 	VC_SM_CMA_CMD_LAST	/* Do not delete */
 };
 
@@ -98,6 +100,19 @@ struct vc_sm_cma_ioctl_clean_invalid2 {
 	} s[0];
 };
 
+/*
+ * Whole buffer cache maintenance on a list of dma-bufs, with cache_op one of
+ * VC_SM_CACHE_OP_*.
+ */
+struct vc_sm_cma_ioctl_sync_dmabufs {
+	__u32 op_count;
+	__u32 pad;
+	struct vc_sm_cma_ioctl_sync_dmabuf {
+		__s32 dmabuf_fd;
+		__u32 cache_op;
+	} s[0];
+};
+
 /* IOCTL numbers */
 #define VC_SM_CMA_IOCTL_MEM_ALLOC\
 	_IOR(VC_SM_CMA_MAGIC_TYPE, VC_SM_CMA_CMD_ALLOC,\
@@ -111,4 +126,8 @@ struct vc_sm_cma_ioctl_clean_invalid2 {
 	_IOR(VC_SM_CMA_MAGIC_TYPE, VC_SM_CMA_CMD_CLEAN_INVALID2,\
 	 struct vc_sm_cma_ioctl_clean_invalid2)
 
+#define VC_SM_CMA_IOCTL_MEM_SYNC_DMABUFS\
+	_IOR(VC_SM_CMA_MAGIC_TYPE, VC_SM_CMA_CMD_SYNC_DMABUFS,\
+	 struct vc_sm_cma_ioctl_sync_dmabufs)
+
 #endif /* __VC_SM_CMA_IOCTL_H */
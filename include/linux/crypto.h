@@ -452,6 +452,7 @@ struct compress_alg {
  * @cra_list: internally used
  * @cra_users: internally used
  * @cra_refcnt: internally used
+ * @cra_bench_ns: internally used
  * @cra_destroy: internally used
  *
  * The struct crypto_alg describes a generic Crypto API algorithm and is common
@@ -469,6 +470,7 @@ struct crypto_alg {
 
 	int cra_priority;
 	refcount_t cra_refcnt;
+	u32 cra_bench_ns;
 
 	char cra_name[CRYPTO_MAX_ALG_NAME];
 	char cra_driver_name[CRYPTO_MAX_ALG_NAME];
@@ -51,6 +51,18 @@ struct dma_buf_attachment;
  * @vunmap: [optional] unmaps a vmap from the buffer
  */
 struct dma_buf_ops {
+	/**
+	 * @cache_sgt_mapping:
+	 *
+	 * If true the framework keeps the first mapping made for each
+	 * attachment and hands it out again on later dma_buf_map_attachment()
+	 * calls, only unmapping it through @unmap_dma_buf at dma_buf_detach().
+	 * Suitable for exporters whose backing storage never moves once
+	 * attached, e.g. CMA, so importers mapping per frame don't pay for
+	 * IOMMU and cache maintenance every time.
+	 */
+	bool cache_sgt_mapping;
+
 	/**
 	 * @attach:
 	 *
@@ -267,6 +279,10 @@ struct dma_buf_ops {
  * @poll: for userspace poll support
  * @cb_excl: for userspace poll support
  * @cb_shared: for userspace poll support
+ * @map_count: dma_buf_map_attachment() calls, for debugfs
+ * @unmap_count: dma_buf_unmap_attachment() calls, for debugfs
+ * @exp_map_count: of those, the ones which reached the exporter
+ * @exp_unmap_count: exporter unmaps, including cached mappings at detach
  *
  * This represents a shared buffer, created by calling dma_buf_export(). The
  * userspace representation is a normal file descriptor, which can be created by
@@ -300,6 +316,9 @@ struct dma_buf {
 
 		__poll_t active;
 	} cb_excl, cb_shared;
+
+	atomic_long_t map_count, unmap_count;
+	atomic_long_t exp_map_count, exp_unmap_count;
 };
 
 /**
@@ -308,6 +327,8 @@ struct dma_buf {
  * @dev: device attached to the buffer.
  * @node: list of dma_buf_attachment.
  * @priv: exporter specific attachment data.
+ * @sgt: cached mapping, if the exporter sets &dma_buf_ops.cache_sgt_mapping.
+ * @dir: direction of the cached mapping.
  *
  * This structure holds the attachment information between the dma_buf buffer
  * and its user device(s). The list contains one attachment struct per device
@@ -323,6 +344,8 @@ struct dma_buf_attachment {
 	struct device *dev;
 	struct list_head node;
 	void *priv;
+	struct sg_table *sgt;
+	enum dma_data_direction dir;
 };
 
 /**
@@ -23,11 +23,29 @@ int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		unsigned long end, int advice, unsigned long *vm_flags);
 int __ksm_enter(struct mm_struct *mm);
 void __ksm_exit(struct mm_struct *mm);
+int ksm_enable_merge_any(struct mm_struct *mm);
+int ksm_disable_merge_any(struct mm_struct *mm);
+unsigned long __ksm_vma_flags(struct mm_struct *mm, const struct file *file,
+			      unsigned long vm_flags);
+
+/* New vmas of a process that opted in with PR_SET_MEMORY_MERGE */
+static inline unsigned long ksm_vma_flags(struct mm_struct *mm,
+					  const struct file *file,
+					  unsigned long vm_flags)
+{
+	if (test_bit(MMF_VM_MERGE_ANY, &mm->flags))
+		return __ksm_vma_flags(mm, file, vm_flags);
+	return vm_flags;
+}
 
 static inline int ksm_fork(struct mm_struct *mm, struct mm_struct *oldmm)
 {
-	if (test_bit(MMF_VM_MERGEABLE, &oldmm->flags))
+	if (test_bit(MMF_VM_MERGEABLE, &oldmm->flags)) {
+		/* dup_mm() copied the parent's counts */
+		mm->ksm_merging_pages = 0;
+		mm->ksm_rmap_items = 0;
 		return __ksm_enter(mm);
+	}
 	return 0;
 }
 
@@ -65,6 +83,13 @@ static inline void ksm_exit(struct mm_struct *mm)
 {
 }
 
+static inline unsigned long ksm_vma_flags(struct mm_struct *mm,
+					  const struct file *file,
+					  unsigned long vm_flags)
+{
+	return vm_flags;
+}
+
 #ifdef CONFIG_MMU
 static inline int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		unsigned long end, int advice, unsigned long *vm_flags)
@@ -215,6 +215,12 @@ struct mem_cgroup {
 	/* Range enforcement for interrupt charges */
 	struct work_struct high_work;
 
+	/* Background reclaim requested through memory.reclaim */
+	struct work_struct reclaim_work;
+	atomic_long_t reclaim_pending;
+	atomic_long_t reclaim_reclaimed;
+	atomic_long_t reclaim_thrashing;
+
 	unsigned long soft_limit;
 
 	/* vmpressure notifications */
@@ -320,6 +326,17 @@ struct mem_cgroup {
  * TODO: maybe necessary to use big numbers in big irons.
  */
 #define MEMCG_CHARGE_BATCH 32U
+/* upper bound for the root's memory.charge_batch */
+#define MEMCG_CHARGE_BATCH_MAX 512U
+
+/*
+ * Per-cpu stat and event deltas are folded into the shared counters once
+ * they grow past this, and by a periodic flush from memcontrol.c otherwise.
+ */
+#define MEMCG_STAT_BATCH (4 * MEMCG_CHARGE_BATCH)
+
+/* How far this cpu's unflushed deltas may be off, summed over all memcgs */
+DECLARE_PER_CPU(unsigned long, memcg_stat_error);
 
 extern struct mem_cgroup *root_mem_cgroup;
 
@@ -584,9 +601,11 @@ static inline void __mod_memcg_state(struct mem_cgroup *memcg,
 		return;
 
 	x = val + __this_cpu_read(memcg->stat_cpu->count[idx]);
-	if (unlikely(abs(x) > MEMCG_CHARGE_BATCH)) {
+	if (unlikely(abs(x) > MEMCG_STAT_BATCH)) {
 		atomic_long_add(x, &memcg->stat[idx]);
 		x = 0;
+	} else {
+		__this_cpu_add(memcg_stat_error, abs(val));
 	}
 	__this_cpu_write(memcg->stat_cpu->count[idx], x);
 }
@@ -670,9 +689,11 @@ static inline void __mod_lruvec_state(struct lruvec *lruvec,
 
 	/* Update lruvec */
 	x = val + __this_cpu_read(pn->lruvec_stat_cpu->count[idx]);
-	if (unlikely(abs(x) > MEMCG_CHARGE_BATCH)) {
+	if (unlikely(abs(x) > MEMCG_STAT_BATCH)) {
 		atomic_long_add(x, &pn->lruvec_stat[idx]);
 		x = 0;
+	} else {
+		__this_cpu_add(memcg_stat_error, abs(val));
 	}
 	__this_cpu_write(pn->lruvec_stat_cpu->count[idx], x);
 }
@@ -727,9 +748,11 @@ static inline void __count_memcg_events(struct mem_cgroup *memcg,
 		return;
 
 	x = count + __this_cpu_read(memcg->stat_cpu->events[idx]);
-	if (unlikely(x > MEMCG_CHARGE_BATCH)) {
+	if (unlikely(x > MEMCG_STAT_BATCH)) {
 		atomic_long_add(x, &memcg->events[idx]);
 		x = 0;
+	} else {
+		__this_cpu_add(memcg_stat_error, count);
 	}
 	__this_cpu_write(memcg->stat_cpu->events[idx], x);
 }
@@ -27,6 +27,7 @@ typedef int vm_fault_t;
 struct address_space;
 struct mem_cgroup;
 struct hmm;
+struct futex_private_hash;
 
 /*
  * Each physical page in the system has a struct page associated with
@@ -321,6 +322,7 @@ struct vm_area_struct {
 	void * vm_private_data;		/* was vm_pte (shared mem) */
 
 	atomic_long_t swap_readahead_info;
+	atomic_long_t fault_around_info;
 #ifndef CONFIG_MMU
 	struct vm_region *vm_region;	/* NOMMU mapping region */
 #endif
@@ -487,8 +489,18 @@ struct mm_struct {
 		bool tlb_flush_batched;
 #endif
 		struct uprobes_state uprobes_state;
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+		/* buckets for private futexes, see futex_mm_new_thread() */
+		struct futex_private_hash *futex_phash;
+#endif
 #ifdef CONFIG_HUGETLB_PAGE
 		atomic_long_t hugetlb_usage;
+#endif
+#ifdef CONFIG_KSM
+		/* pages of this mm that ksmd merged into a KSM page */
+		unsigned long ksm_merging_pages;
+		/* rmap_items ksmd keeps for this mm */
+		unsigned long ksm_rmap_items;
 #endif
 		struct work_struct async_put_work;
 
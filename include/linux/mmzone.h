@@ -36,6 +36,9 @@
  */
 #define PAGE_ALLOC_COSTLY_ORDER 3
 
+/* Highest order cached on the per-cpu page lists */
+#define PCP_HIGH_ORDER PAGE_ALLOC_COSTLY_ORDER
+
 enum migratetype {
 	MIGRATE_UNMOVABLE,
 	MIGRATE_MOVABLE,
@@ -64,6 +67,17 @@ enum migratetype {
 	MIGRATE_TYPES
 };
 
+/*
+ * Free CMA pages get a pcp list of their own, which only __GFP_CMA
+ * allocations take from, instead of mixing in with the movable list.
+ */
+#ifdef CONFIG_CMA
+#define PCP_CMA_LIST	MIGRATE_PCPTYPES
+#define NR_PCP_LISTS	(MIGRATE_PCPTYPES + 1)
+#else
+#define NR_PCP_LISTS	MIGRATE_PCPTYPES
+#endif
+
 /* In mm/page_alloc.c; keep in sync also with show_migration_types() there */
 extern char * const migratetype_names[MIGRATE_TYPES];
 
@@ -277,9 +291,27 @@ struct per_cpu_pages {
 	int batch;		/* chunk size for buddy add/remove */
 
 	/* Lists of pages, one per migrate type stored on the pcp-lists */
-	struct list_head lists[MIGRATE_PCPTYPES];
+	struct list_head lists[NR_PCP_LISTS];
+
+	/*
+	 * Blocks of orders 1 to PCP_HIGH_ORDER, so that frequent small
+	 * high-order users (network RX page frags, slab) can skip the zone
+	 * lock too. order_count[] is in blocks, not pages.
+	 */
+	int order_count[PCP_HIGH_ORDER];
+	struct list_head order_lists[PCP_HIGH_ORDER][MIGRATE_PCPTYPES];
 };
 
+/* Number of base pages held on all of the pcp lists */
+static inline int pcp_total_pages(struct per_cpu_pages *pcp)
+{
+	int order, pages = pcp->count;
+
+	for (order = 1; order <= PCP_HIGH_ORDER; order++)
+		pages += pcp->order_count[order - 1] << order;
+	return pages;
+}
+
 struct per_cpu_pageset {
 	struct per_cpu_pages pcp;
 #ifdef CONFIG_NUMA
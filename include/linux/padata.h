@@ -24,7 +24,6 @@
 #include <linux/workqueue.h>
 #include <linux/spinlock.h>
 #include <linux/list.h>
-#include <linux/timer.h>
 #include <linux/notifier.h>
 #include <linux/kobject.h>
 
@@ -42,6 +41,7 @@
  * @info: Used to pass information from the parallel to the serial function.
  * @parallel: Parallel execution function.
  * @serial: Serial complete function.
+ * @start_ns: Time the object was handed to padata_do_parallel.
  */
 struct padata_priv {
 	struct list_head	list;
@@ -51,6 +51,7 @@ struct padata_priv {
 	int			info;
 	void                    (*parallel)(struct padata_priv *padata);
 	void                    (*serial)(struct padata_priv *padata);
+	u64			start_ns;
 };
 
 /**
@@ -112,6 +113,19 @@ struct padata_cpumask {
 	cpumask_var_t	cbcpu;
 };
 
+/**
+ * struct padata_stats - Latency of objects through a padata instance.
+ *
+ * @count: Number of objects handed to their serial callback.
+ * @sum_ns: Total nanoseconds from padata_do_parallel to the serial callback.
+ * @max_ns: Longest such interval seen.
+ */
+struct padata_stats {
+	u64	count;
+	u64	sum_ns;
+	u64	max_ns;
+};
+
 /**
  * struct parallel_data - Internal control structure, covers everything
  * that depends on the cpumask in use.
@@ -125,7 +139,6 @@ struct padata_cpumask {
  * @cpumask: The cpumasks in use for parallel and serial workers.
  * @lock: Reorder lock.
  * @processed: Number of already processed objects.
- * @timer: Reorder timer.
  */
 struct parallel_data {
 	struct padata_instance		*pinst;
@@ -137,7 +150,6 @@ struct parallel_data {
 	struct padata_cpumask		cpumask;
 	spinlock_t                      lock ____cacheline_aligned;
 	unsigned int			processed;
-	struct timer_list		timer;
 };
 
 /**
@@ -152,6 +164,8 @@ struct parallel_data {
  *            or both cpumasks change.
  * @kobj: padata instance kernel object.
  * @lock: padata instance lock.
+ * @stats_lock: Protects @stats.
+ * @stats: Object latency, shown in sysfs.
  * @flags: padata flags.
  */
 struct padata_instance {
@@ -162,6 +176,8 @@ struct padata_instance {
 	struct blocking_notifier_head	 cpumask_change_notifier;
 	struct kobject                   kobj;
 	struct mutex			 lock;
+	spinlock_t			 stats_lock;
+	struct padata_stats		 stats;
 	u8				 flags;
 #define	PADATA_INIT	1
 #define	PADATA_RESET	2
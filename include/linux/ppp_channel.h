@@ -20,6 +20,7 @@
  */
 
 #include <linux/list.h>
+#include <linux/netdevice.h>
 #include <linux/skbuff.h>
 #include <linux/poll.h>
 #include <net/net_namespace.h>
@@ -32,6 +33,11 @@ struct ppp_channel_ops {
 	int	(*start_xmit)(struct ppp_channel *, struct sk_buff *);
 	/* Handle an ioctl call that has come in via /dev/ppp. */
 	int	(*ioctl)(struct ppp_channel *, unsigned int, unsigned long);
+	/* Describe the lower device and encapsulation of this channel,
+	   see ndo_fill_forward_path(). */
+	int	(*fill_forward_path)(struct net_device_path_ctx *,
+				     struct net_device_path *,
+				     const struct ppp_channel *);
 };
 
 struct ppp_channel {
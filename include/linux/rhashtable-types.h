@@ -79,6 +79,7 @@ struct rhashtable_params {
  * @mutex: Mutex to protect current/future table swapping
  * @lock: Spin lock to protect walker list
  * @nelems: Number of elements in table
+ * @nreserved: Elements announced by rhashtable_insert_batch() callers
  */
 struct rhashtable {
 	struct bucket_table __rcu	*tbl;
@@ -90,6 +91,7 @@ struct rhashtable {
 	struct mutex                    mutex;
 	spinlock_t			lock;
 	atomic_t			nelems;
+	atomic_t			nreserved;
 };
 
 /**
@@ -155,8 +155,9 @@ static inline unsigned int rht_head_hashfn(
 static inline bool rht_grow_above_75(const struct rhashtable *ht,
 				     const struct bucket_table *tbl)
 {
-	/* Expand table when exceeding 75% load */
-	return atomic_read(&ht->nelems) > (tbl->size / 4 * 3) &&
+	/* Expand table when exceeding 75% load, counting announced inserts */
+	return atomic_read(&ht->nelems) + atomic_read(&ht->nreserved) >
+	       (tbl->size / 4 * 3) &&
 	       (!ht->p.max_size || tbl->size < ht->p.max_size);
 }
 
@@ -169,7 +170,8 @@ static inline bool rht_shrink_below_30(const struct rhashtable *ht,
 				       const struct bucket_table *tbl)
 {
 	/* Shrink table beneath 30% load */
-	return atomic_read(&ht->nelems) < (tbl->size * 3 / 10) &&
+	return atomic_read(&ht->nelems) + atomic_read(&ht->nreserved) <
+	       (tbl->size * 3 / 10) &&
 	       tbl->size > ht->p.min_size;
 }
 
@@ -545,6 +547,37 @@ static inline void *rhashtable_lookup_fast(
 	return obj;
 }
 
+/**
+ * rhashtable_lookup_batch - search hash table for several keys
+ * @ht:		hash table
+ * @keys:	the keys to search for
+ * @objs:	found objects, or NULL for keys that are not present
+ * @n:		number of keys
+ * @params:	hash table parameters
+ *
+ * Looks up each key in one RCU read-side section.  As with
+ * rhashtable_lookup_fast() the objects are only guaranteed to stay
+ * around if the caller otherwise pins them.
+ *
+ * Returns the number of keys found.
+ */
+static inline unsigned int rhashtable_lookup_batch(
+	struct rhashtable *ht, const void * const *keys, void **objs,
+	unsigned int n, const struct rhashtable_params params)
+{
+	unsigned int i, found = 0;
+
+	rcu_read_lock();
+	for (i = 0; i < n; i++) {
+		objs[i] = rhashtable_lookup(ht, keys[i], params);
+		if (objs[i])
+			found++;
+	}
+	rcu_read_unlock();
+
+	return found;
+}
+
 /**
  * rhltable_lookup - search hash list table
  * @hlt:	hash table
@@ -702,6 +735,52 @@ static inline int rhashtable_insert_fast(
 	return ret == NULL ? 0 : -EEXIST;
 }
 
+/**
+ * rhashtable_insert_batch - insert several objects into hash table
+ * @ht:		hash table
+ * @objs:	pointers to the hash heads inside the objects
+ * @n:		number of objects
+ * @params:	hash table parameters
+ *
+ * Inserts each object as rhashtable_insert_fast() would, but announces
+ * the whole batch to the table first.  If the batch will take the table
+ * past 75% residency the deferred resize starts before the first insert.
+ * It is also sized for the batch, so the later inserts do not find the
+ * table full and have to allocate a bigger one from atomic context.
+ *
+ * It is safe to call this function from atomic context.
+ *
+ * Returns the number of objects inserted.  It is less than @n only if
+ * objs[ret] could not be inserted.  If that was the first object, the
+ * error instead.
+ */
+static inline int rhashtable_insert_batch(
+	struct rhashtable *ht, struct rhash_head **objs, unsigned int n,
+	const struct rhashtable_params params)
+{
+	struct bucket_table *tbl;
+	unsigned int i;
+	int err = 0;
+
+	atomic_add(n, &ht->nreserved);
+
+	rcu_read_lock();
+	tbl = rht_dereference_rcu(ht->tbl, ht);
+	if (rht_grow_above_75(ht, tbl))
+		schedule_work(&ht->run_work);
+	rcu_read_unlock();
+
+	for (i = 0; i < n; i++) {
+		err = rhashtable_insert_fast(ht, objs[i], params);
+		if (err)
+			break;
+	}
+
+	atomic_sub(n, &ht->nreserved);
+
+	return i ? i : err;
+}
+
 /**
  * rhltable_insert_key - insert object into hash list table
  * @hlt:	hash list table
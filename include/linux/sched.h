@@ -429,6 +429,7 @@ struct sched_statistics {
 	u64				nr_failed_migrations_affine;
 	u64				nr_failed_migrations_running;
 	u64				nr_failed_migrations_hot;
+	u64				nr_failed_migrations_group;
 	u64				nr_forced_migrations;
 
 	u64				nr_wakeups;
@@ -438,11 +439,30 @@ struct sched_statistics {
 	u64				nr_wakeups_remote;
 	u64				nr_wakeups_affine;
 	u64				nr_wakeups_affine_attempts;
+	u64				nr_wakeups_group_llc;
 	u64				nr_wakeups_passive;
 	u64				nr_wakeups_idle;
 #endif
 };
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+enum uclamp_id {
+	UCLAMP_MIN = 0,
+	UCLAMP_MAX,
+	UCLAMP_CNT
+};
+
+/*
+ * A utilization clamp value and the rq bucket it falls into; for a task,
+ * @active says it is refcounted in that bucket of its rq.
+ */
+struct uclamp_se {
+	unsigned int value		: SCHED_FIXEDPOINT_SHIFT + 1;
+	unsigned int bucket_id		: 3;
+	unsigned int active		: 1;
+};
+#endif
+
 struct sched_entity {
 	/* For load-balancing: */
 	struct load_weight		load;
@@ -458,6 +478,9 @@ struct sched_entity {
 
 	u64				nr_migrations;
 
+	/* MIN_LATENCY_NICE..MAX_LATENCY_NICE, see se_latency_offset() */
+	int				latency_nice;
+
 	struct sched_statistics		statistics;
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -544,12 +567,16 @@ struct sched_dl_entity {
 	 *
 	 * @dl_overrun tells if the task asked to be informed about runtime
 	 * overruns.
+	 *
+	 * @dl_server tells if this is not a task's entity but a cgroup's
+	 * deadline server, which runs the group's CFS tasks in its place.
 	 */
 	unsigned int			dl_throttled      : 1;
 	unsigned int			dl_boosted        : 1;
 	unsigned int			dl_yielded        : 1;
 	unsigned int			dl_non_contending : 1;
 	unsigned int			dl_overrun	  : 1;
+	unsigned int			dl_server	  : 1;
 
 	/*
 	 * Bandwidth enforcement timer. Each -deadline task has its
@@ -649,6 +676,11 @@ struct task_struct {
 #endif
 	struct sched_dl_entity		dl;
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	/* Clamp values the task is accounted with on its rq */
+	struct uclamp_se		uclamp[UCLAMP_CNT];
+#endif
+
 #ifdef CONFIG_PREEMPT_NOTIFIERS
 	/* List of struct preempt_notifier: */
 	struct hlist_head		preempt_notifiers;
@@ -72,9 +72,14 @@ static inline int get_dumpable(struct mm_struct *mm)
 #define MMF_DISABLE_THP		24	/* disable THP for all VMAs */
 #define MMF_OOM_VICTIM		25	/* mm is the oom victim */
 #define MMF_OOM_REAP_QUEUED	26	/* mm was queued for oom_reaper */
+#define MMF_THP_PRIORITY	27	/* khugepaged scans this mm first */
+#define MMF_VM_MERGE_ANY	28	/* KSM may merge any anonymous vma */
 #define MMF_DISABLE_THP_MASK	(1 << MMF_DISABLE_THP)
+#define MMF_THP_PRIORITY_MASK	(1 << MMF_THP_PRIORITY)
+#define MMF_VM_MERGE_ANY_MASK	(1 << MMF_VM_MERGE_ANY)
 
 #define MMF_INIT_MASK		(MMF_DUMPABLE_MASK | MMF_DUMP_FILTER_MASK |\
-				 MMF_DISABLE_THP_MASK)
+				 MMF_DISABLE_THP_MASK | MMF_THP_PRIORITY_MASK |\
+				 MMF_VM_MERGE_ANY_MASK)
 
 #endif /* _LINUX_SCHED_COREDUMP_H */
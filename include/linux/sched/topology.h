@@ -72,8 +72,20 @@ struct sched_domain_shared {
 	atomic_t	ref;
 	atomic_t	nr_busy_cpus;
 	int		has_idle_cores;
+
+	/*
+	 * CPUs of this LLC that went idle and have not had a busy tick
+	 * since; see update_idle_cpumask(). Always a superset of the idle
+	 * CPUs, so select_idle_cpu() only needs to look at these.
+	 */
+	unsigned long	idle_cpus_span[0];
 };
 
+static inline struct cpumask *sds_idle_cpus(struct sched_domain_shared *sds)
+{
+	return to_cpumask(sds->idle_cpus_span);
+}
+
 struct sched_domain {
 	/* These fields must be setup */
 	struct sched_domain *parent;	/* top domain must be null terminated */
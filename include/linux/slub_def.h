@@ -36,6 +36,7 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	ALLOC_BULK_PARTIAL,	/* Bulk alloc took a node partial freelist */
 	NR_SLUB_STAT_ITEMS };
 
 struct kmem_cache_cpu {
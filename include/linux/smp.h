@@ -101,6 +101,9 @@ int smp_call_function(smp_call_func_t func, void *info, int wait);
 void smp_call_function_many(const struct cpumask *mask,
 			    smp_call_func_t func, void *info, bool wait);
 
+void smp_call_batch_begin(void);
+void smp_call_batch_end(void);
+
 int smp_call_function_any(const struct cpumask *mask,
 			  smp_call_func_t func, void *info, int wait);
 
@@ -151,6 +154,8 @@ static inline void smp_send_reschedule(int cpu) { }
 #define smp_prepare_boot_cpu()			do {} while (0)
 #define smp_call_function_many(mask, func, info, wait) \
 			(up_smp_call_function(func, info))
+static inline void smp_call_batch_begin(void) { }
+static inline void smp_call_batch_end(void) { }
 static inline void call_function_init(void) { }
 
 static inline int
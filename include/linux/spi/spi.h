@@ -803,6 +803,8 @@ struct spi_transfer {
  * @spi: SPI device to which the transaction is queued
  * @is_dma_mapped: if true, the caller provided both dma and cpu virtual
  *	addresses for each transfer buffer
+ * @optimized: validated once by spi_optimize_message()
+ * @pre_mapped: transfer buffers were DMA mapped by spi_optimize_message()
  * @complete: called to report transaction completions
  * @context: the argument to complete() when it's called
  * @frame_length: the total number of bytes in the message
@@ -833,6 +835,8 @@ struct spi_message {
 	struct spi_device	*spi;
 
 	unsigned		is_dma_mapped:1;
+	unsigned		optimized:1;
+	unsigned		pre_mapped:1;
 
 	/* REVISIT:  we might want a flag affecting the behavior of the
 	 * last transfer ... allowing things like "read 16 bit length L"
@@ -938,6 +942,9 @@ extern int spi_setup(struct spi_device *spi);
 extern int spi_async(struct spi_device *spi, struct spi_message *message);
 extern int spi_async_locked(struct spi_device *spi,
 			    struct spi_message *message);
+extern int spi_optimize_message(struct spi_device *spi,
+				struct spi_message *msg);
+extern void spi_unoptimize_message(struct spi_message *msg);
 extern int spi_slave_abort(struct spi_device *spi);
 
 static inline size_t
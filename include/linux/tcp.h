@@ -305,6 +305,7 @@ struct tcp_sock {
 	u32	sacked_out;	/* SACK'd packets			*/
 
 	struct hrtimer	pacing_timer;
+	u64	pacing_expiry_ns; /* when pacing_timer was last due */
 	struct hrtimer	compressed_ack_timer;
 
 	/* from STCP, retrans queue hinting */
@@ -50,6 +50,11 @@ struct usb_ep;
  * @short_not_ok: When reading data, makes short packets be
  *     treated as errors (queue stops advancing till cleanup).
  * @dma_mapped: Indicates if request has been mapped to DMA (internal)
+ * @sg_was_mapped: Set if the caller already mapped the data for the
+ *	controller's DMA device (e.g. through a dma-buf attachment), so
+ *	@sg or @dma already hold bus addresses and usb_gadget_map_request()
+ *	leaves them alone.  @buf may then be NULL, so this is only usable
+ *	with controllers which do DMA.
  * @complete: Function called when request completes, so this request and
  *	its buffer may be re-used.  The function will always be called with
  *	interrupts disabled, and it must not sleep.
@@ -106,6 +111,7 @@ struct usb_request {
 	unsigned		zero:1;
 	unsigned		short_not_ok:1;
 	unsigned		dma_mapped:1;
+	unsigned		sg_was_mapped:1;
 
 	void			(*complete)(struct usb_ep *ep,
 					struct usb_request *req);
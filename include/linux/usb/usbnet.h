@@ -64,6 +64,8 @@ struct usbnet {
 	struct mutex		interrupt_mutex;
 	struct usb_anchor	deferred;
 	struct tasklet_struct	bh;
+	struct napi_struct	napi;
+	int			napi_work;
 
 	struct pcpu_sw_netstats __percpu *stats64;
 
@@ -122,6 +124,15 @@ struct driver_info {
 #define FLAG_RX_ASSEMBLE	0x4000	/* rx packets may span >1 frames */
 #define FLAG_NOARP		0x8000	/* device can't do ARP */
 
+/*
+ * Run the bottom half as NAPI rather than a tasklet and pass frames to
+ * GRO. RX URBs are then backed by whole pages so that rx_fixup can use
+ * usbnet_rx_frag() instead of cloning the URB buffer. Not for use with
+ * FLAG_AVOID_UNLINK_URBS, URBs completing after stop are only reaped
+ * once the interface is opened again.
+ */
+#define FLAG_NAPI		0x10000
+
 	/* init device ... can sleep, or cause probe() failure */
 	int	(*bind)(struct usbnet *, struct usb_interface *);
 
@@ -260,6 +271,7 @@ extern int usbnet_get_endpoints(struct usbnet *, struct usb_interface *);
 extern int usbnet_get_ethernet_addr(struct usbnet *, int);
 extern void usbnet_defer_kevent(struct usbnet *, int);
 extern void usbnet_skb_return(struct usbnet *, struct sk_buff *);
+extern struct sk_buff *usbnet_rx_frag(struct usbnet *, void *, unsigned int);
 extern void usbnet_unlink_rx_urbs(struct usbnet *);
 
 extern void usbnet_pause_rx(struct usbnet *);
@@ -32,6 +32,12 @@
  *		assumed that one source and one destination buffer are all
  *		that is required for the driver to perform one full transaction.
  *		This method may not sleep.
+ * @job_ready_batch: optional. Lets a context have more than one job in
+ *		flight. Called in place of @job_ready, including for a context
+ *		that already has @running jobs in the hardware. Should return 0
+ *		if another job for this context can't be started yet. Without
+ *		this callback a context only has one job in flight at a time.
+ *		This method may not sleep.
  * @job_abort:	optional. Informs the driver that it has to abort the currently
  *		running transaction as soon as possible (i.e. as soon as it can
  *		stop the device safely; e.g. in the next interrupt handler),
@@ -44,6 +50,7 @@
 struct v4l2_m2m_ops {
 	void (*device_run)(void *priv);
 	int (*job_ready)(void *priv);
+	int (*job_ready_batch)(void *priv, unsigned int running);
 	void (*job_abort)(void *priv);
 };
 
@@ -83,6 +90,7 @@ struct v4l2_m2m_queue_ctx {
  * @queue: List of memory to memory contexts
  * @job_flags: Job queue flags, used internally by v4l2-mem2mem.c:
  *		%TRANS_QUEUED, %TRANS_RUNNING and %TRANS_ABORT.
+ * @num_jobs: Number of jobs of this context currently in the hardware.
  * @finished: Wait queue used to signalize when a job queue finished.
  * @priv: Instance private data
  *
@@ -103,6 +111,7 @@ struct v4l2_m2m_ctx {
 	/* For device job queue */
 	struct list_head		queue;
 	unsigned long			job_flags;
+	unsigned int			num_jobs;
 	wait_queue_head_t		finished;
 
 	void				*priv;
@@ -124,6 +133,9 @@ struct v4l2_m2m_buffer {
  * running instance or NULL if no instance is running
  *
  * @m2m_dev: opaque pointer to the internal data to handle M2M context
+ *
+ * With more than one job in flight (see v4l2_m2m_set_max_inflight()) this
+ * is the instance that was started last.
  */
 void *v4l2_m2m_get_curr_priv(struct v4l2_m2m_dev *m2m_dev);
 
@@ -323,6 +335,21 @@ int v4l2_m2m_mmap(struct file *file, struct v4l2_m2m_ctx *m2m_ctx,
  */
 struct v4l2_m2m_dev *v4l2_m2m_init(const struct v4l2_m2m_ops *m2m_ops);
 
+/**
+ * v4l2_m2m_set_max_inflight() - set how many jobs may run at once
+ *
+ * @m2m_dev: opaque pointer to the internal data to handle M2M context
+ * @max_inflight: number of jobs, across all contexts, that may be inside
+ *	&v4l2_m2m_ops->device_run at the same time. The default is 1.
+ *
+ * Intended for hardware or firmware that queues jobs internally, so that
+ * it is never left idle waiting for v4l2_m2m_job_finish() to schedule the
+ * next one. v4l2_m2m_job_finish() must then be called once per job that
+ * &v4l2_m2m_ops->device_run was called for.
+ */
+void v4l2_m2m_set_max_inflight(struct v4l2_m2m_dev *m2m_dev,
+			       unsigned int max_inflight);
+
 #if defined(CONFIG_MEDIA_CONTROLLER)
 void v4l2_m2m_unregister_media_controller(struct v4l2_m2m_dev *m2m_dev);
 int v4l2_m2m_register_media_controller(struct v4l2_m2m_dev *m2m_dev,
@@ -291,6 +291,15 @@ struct vb2_buffer {
 	/* This counts the number of calls to vb2_buffer_done() */
 	u32		cnt_buf_done;
 #endif
+#ifdef CONFIG_VIDEOBUF2_LATENCY_HIST
+	/*
+	 * Times (ktime_get_ns()) at which the buffer was queued by
+	 * userspace, handed to the driver and marked done.
+	 */
+	u64		lat_qbuf_ns;
+	u64		lat_queue_ns;
+	u64		lat_done_ns;
+#endif
 };
 
 /**
@@ -573,6 +582,10 @@ struct vb2_queue {
 	u32				cnt_start_streaming;
 	u32				cnt_stop_streaming;
 #endif
+#ifdef CONFIG_VIDEOBUF2_LATENCY_HIST
+	/* per-queue latency histograms, see vb2-latency.c */
+	struct vb2_latency		*latency;
+#endif
 };
 
 /**
@@ -20,10 +20,16 @@ struct nf_flowtable_type {
 	struct module			*owner;
 };
 
+enum nf_flowtable_flags {
+	NF_FLOWTABLE_HW_OFFLOAD		= 0x1,	/* NFT_FLOWTABLE_HW_OFFLOAD */
+	NF_FLOWTABLE_COUNTER		= 0x2,	/* NFT_FLOWTABLE_COUNTER */
+};
+
 struct nf_flowtable {
 	struct list_head		list;
 	struct rhashtable		rhashtable;
 	const struct nf_flowtable_type	*type;
+	u32				flags;
 	struct delayed_work		gc_work;
 };
 
@@ -33,6 +39,11 @@ enum flow_offload_tuple_dir {
 	FLOW_OFFLOAD_DIR_MAX = IP_CT_DIR_MAX
 };
 
+enum flow_offload_xmit_type {
+	FLOW_OFFLOAD_XMIT_NEIGH		= 0,
+	FLOW_OFFLOAD_XMIT_DIRECT,
+};
+
 struct flow_offload_tuple {
 	union {
 		struct in_addr		src_v4;
@@ -51,13 +62,25 @@ struct flow_offload_tuple {
 
 	u8				l3proto;
 	u8				l4proto;
+	/* PPPoE session the packets arrive in, if any */
+	struct {
+		u16			id;
+		__be16			proto;
+	} encap;
+
+	/* All members above are keys for lookups, see flow_offload_hash(). */
 	u8				dir;
+	u8				xmit_type;
 
 	int				oifidx;
 
 	u16				mtu;
 
 	struct dst_entry		*dst_cache;
+
+	/* FLOW_OFFLOAD_XMIT_DIRECT only */
+	u8				h_source[ETH_ALEN];
+	u8				h_dest[ETH_ALEN];
 };
 
 struct flow_offload_tuple_rhash {
@@ -83,7 +106,20 @@ struct flow_offload {
 
 struct nf_flow_route {
 	struct {
-		struct dst_entry	*dst;
+		struct dst_entry		*dst;
+		struct {
+			u32			ifindex;
+			struct {
+				u16		id;
+				__be16		proto;
+			} encap;
+		} in;
+		struct {
+			u32			ifindex;
+			u8			h_source[ETH_ALEN];
+			u8			h_dest[ETH_ALEN];
+		} out;
+		enum flow_offload_xmit_type	xmit_type;
 	} tuple[FLOW_OFFLOAD_DIR_MAX];
 };
 
@@ -100,6 +136,9 @@ int nf_flow_table_iterate(struct nf_flowtable *flow_table,
 
 void nf_flow_table_cleanup(struct net *net, struct net_device *dev);
 
+void flow_offload_acct(struct flow_offload *flow,
+		       enum flow_offload_tuple_dir dir, unsigned int len);
+
 int nf_flow_table_init(struct nf_flowtable *flow_table);
 void nf_flow_table_free(struct nf_flowtable *flow_table);
 
@@ -69,6 +69,7 @@ extern struct nft_set_type nft_set_rhash_type;
 extern struct nft_set_type nft_set_hash_type;
 extern struct nft_set_type nft_set_hash_fast_type;
 extern struct nft_set_type nft_set_rbtree_type;
+extern struct nft_set_type nft_set_pipapo_type;
 extern struct nft_set_type nft_set_bitmap_type;
 
 struct nft_expr;
@@ -21,6 +21,11 @@ struct sock_reuseport {
 	unsigned int		synq_overflow_ts;
 	/* ID stays the same even after the size of socks[] grows. */
 	unsigned int		reuseport_id;
+	/* A member set SO_INCOMING_CPU: prefer the socket bound to the
+	 * receiving CPU when selecting by hash.  Not a bitfield, as
+	 * has_conns is set without reuseport_lock.
+	 */
+	unsigned int		incoming_cpu;
 	unsigned int		bind_inany:1;
 	unsigned int		has_conns:1;
 	struct bpf_prog __rcu	*prog;		/* optional BPF sock selector */
@@ -36,6 +41,7 @@ extern struct sock *reuseport_select_sock(struct sock *sk,
 					  struct sk_buff *skb,
 					  int hdr_len);
 extern int reuseport_attach_prog(struct sock *sk, struct bpf_prog *prog);
+extern void reuseport_update_incoming_cpu(struct sock *sk, int val);
 
 static inline bool reuseport_has_conns(struct sock *sk, bool set)
 {
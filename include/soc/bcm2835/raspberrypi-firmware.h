@@ -162,11 +162,34 @@ enum rpi_firmware_property_tag {
 
 #define GET_DISPLAY_SETTINGS_PAYLOAD_SIZE 64
 
+/*
+ * Called once the firmware has replied to an asynchronous property list,
+ * with the response copied back into the caller's buffer. Runs in process
+ * context and must not wait on another property call.
+ */
+typedef void (*rpi_firmware_callback_t)(void *context, int status);
+
+/* events for rpi_firmware_register_throttle_notifier() */
+enum rpi_firmware_throttle_event {
+	RPI_FIRMWARE_THROTTLE_CLEAR,
+	RPI_FIRMWARE_THROTTLE_WARNING,
+};
+
+struct notifier_block;
+
 #if IS_ENABLED(CONFIG_RASPBERRYPI_FIRMWARE)
 int rpi_firmware_property(struct rpi_firmware *fw,
 			  u32 tag, void *data, size_t len);
 int rpi_firmware_property_list(struct rpi_firmware *fw,
 			       void *data, size_t tag_size);
+int rpi_firmware_property_list_async(struct rpi_firmware *fw,
+				     void *data, size_t tag_size,
+				     rpi_firmware_callback_t callback,
+				     void *context);
+int rpi_firmware_register_throttle_notifier(struct rpi_firmware *fw,
+					    struct notifier_block *nb);
+int rpi_firmware_unregister_throttle_notifier(struct rpi_firmware *fw,
+					      struct notifier_block *nb);
 struct rpi_firmware *rpi_firmware_get(struct device_node *firmware_node);
 #else
 static inline int rpi_firmware_property(struct rpi_firmware *fw, u32 tag,
@@ -181,6 +204,28 @@ static inline int rpi_firmware_property_list(struct rpi_firmware *fw,
 	return -ENOSYS;
 }
 
+static inline int rpi_firmware_property_list_async(struct rpi_firmware *fw,
+						   void *data, size_t tag_size,
+						   rpi_firmware_callback_t callback,
+						   void *context)
+{
+	return -ENOSYS;
+}
+
+static inline int
+rpi_firmware_register_throttle_notifier(struct rpi_firmware *fw,
+					struct notifier_block *nb)
+{
+	return -ENOSYS;
+}
+
+static inline int
+rpi_firmware_unregister_throttle_notifier(struct rpi_firmware *fw,
+					  struct notifier_block *nb)
+{
+	return -ENOSYS;
+}
+
 static inline struct rpi_firmware *rpi_firmware_get(struct device_node *firmware_node)
 {
 	return NULL;
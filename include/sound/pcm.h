@@ -361,6 +361,9 @@ struct snd_pcm_runtime {
 	unsigned long hw_ptr_buffer_jiffies; /* buffer time in jiffies */
 	snd_pcm_sframes_t delay;	/* extra delay; typically FIFO size */
 	u64 hw_ptr_wrap;                /* offset for hw_ptr due to boundary wrap-around */
+	snd_pcm_uframes_t interp_pos;	/* last position from the driver */
+	snd_pcm_uframes_t interp_reported; /* last interpolated position */
+	ktime_t interp_tstamp;		/* time interp_pos was first seen */
 
 	/* -- HW params -- */
 	snd_pcm_access_t access;	/* access mode */
@@ -379,6 +382,7 @@ struct snd_pcm_runtime {
 	unsigned int rate_num;
 	unsigned int rate_den;
 	unsigned int no_period_wakeup: 1;
+	unsigned int hw_ptr_interpolate: 1; /* set by the driver in open */
 
 	/* -- SW params -- */
 	int tstamp_mode;		/* mmap timestamp is updated */
@@ -587,6 +587,56 @@ TRACE_EVENT(sched_wake_idle_without_ipi,
 
 	TP_printk("cpu=%d", __entry->cpu)
 );
+
+/*
+ * Tracepoint for an RT push request being passed to an overloaded CPU:
+ */
+TRACE_EVENT(sched_rt_push_ipi,
+
+	TP_PROTO(int src_cpu, int dst_cpu, int skipped),
+
+	TP_ARGS(src_cpu, dst_cpu, skipped),
+
+	TP_STRUCT__entry(
+		__field(	int,	src_cpu		)
+		__field(	int,	dst_cpu		)
+		__field(	int,	skipped		)
+	),
+
+	TP_fast_assign(
+		__entry->src_cpu	= src_cpu;
+		__entry->dst_cpu	= dst_cpu;
+		__entry->skipped	= skipped;
+	),
+
+	TP_printk("src_cpu=%d dst_cpu=%d skipped=%d",
+		  __entry->src_cpu, __entry->dst_cpu, __entry->skipped)
+);
+
+/*
+ * Tracepoint for a CPU lowering its priority and looking for RT tasks:
+ */
+TRACE_EVENT(sched_rt_pull,
+
+	TP_PROTO(int cpu, int nr_overloaded, bool ipi),
+
+	TP_ARGS(cpu, nr_overloaded, ipi),
+
+	TP_STRUCT__entry(
+		__field(	int,	cpu		)
+		__field(	int,	nr_overloaded	)
+		__field(	bool,	ipi		)
+	),
+
+	TP_fast_assign(
+		__entry->cpu		= cpu;
+		__entry->nr_overloaded	= nr_overloaded;
+		__entry->ipi		= ipi;
+	),
+
+	TP_printk("cpu=%d nr_overloaded=%d ipi=%d",
+		  __entry->cpu, __entry->nr_overloaded, __entry->ipi)
+);
 #endif /* _TRACE_SCHED_H */
 
 /* This part must be outside protection */
@@ -518,6 +518,8 @@ TRACE_EVENT(balance_dirty_pages,
 		__field(	 long,	pause)
 		__field(unsigned long,	period)
 		__field(	 long,	think)
+		__field(unsigned long,	latency)
+		__field(unsigned int,	latency_target)
 		__field(unsigned int,	cgroup_ino)
 	),
 
@@ -541,6 +543,8 @@ TRACE_EVENT(balance_dirty_pages,
 		__entry->period		= period * 1000 / HZ;
 		__entry->pause		= pause * 1000 / HZ;
 		__entry->paused		= (jiffies - start_time) * 1000 / HZ;
+		__entry->latency	= wb->avg_write_latency;
+		__entry->latency_target	= wb->bdi->latency_target_ms;
 		__entry->cgroup_ino	= __trace_wb_assign_cgroup(wb);
 	),
 
@@ -550,7 +554,8 @@ TRACE_EVENT(balance_dirty_pages,
 		  "bdi_setpoint=%lu bdi_dirty=%lu "
 		  "dirty_ratelimit=%lu task_ratelimit=%lu "
 		  "dirtied=%u dirtied_pause=%u "
-		  "paused=%lu pause=%ld period=%lu think=%ld cgroup_ino=%u",
+		  "paused=%lu pause=%ld period=%lu think=%ld "
+		  "latency=%lu latency_target=%u cgroup_ino=%u",
 		  __entry->bdi,
 		  __entry->limit,
 		  __entry->setpoint,
@@ -565,10 +570,59 @@ TRACE_EVENT(balance_dirty_pages,
 		  __entry->pause,	/* ms */
 		  __entry->period,	/* ms */
 		  __entry->think,	/* ms */
+		  __entry->latency,	/* ms */
+		  __entry->latency_target, /* ms */
 		  __entry->cgroup_ino
 	  )
 );
 
+/*
+ * wb_thresh was cut because writeback completion latency is over the bdi's
+ * latency target: bw_thresh is the share from bandwidth alone, thresh what
+ * the dirtiers are throttled against instead.
+ */
+TRACE_EVENT(wb_dirty_latency,
+
+	TP_PROTO(struct bdi_writeback *wb,
+		 unsigned long latency,
+		 unsigned int target,
+		 unsigned long bw_thresh,
+		 unsigned long thresh),
+
+	TP_ARGS(wb, latency, target, bw_thresh, thresh),
+
+	TP_STRUCT__entry(
+		__array(char,		bdi, 32)
+		__field(unsigned long,	latency)
+		__field(unsigned int,	target)
+		__field(unsigned long,	bw_thresh)
+		__field(unsigned long,	thresh)
+		__field(unsigned long,	avg_write_bw)
+		__field(unsigned int,	cgroup_ino)
+	),
+
+	TP_fast_assign(
+		strlcpy(__entry->bdi, dev_name(wb->bdi->dev), 32);
+		__entry->latency	= latency;
+		__entry->target		= target;
+		__entry->bw_thresh	= bw_thresh;
+		__entry->thresh		= thresh;
+		__entry->avg_write_bw	= KBps(wb->avg_write_bandwidth);
+		__entry->cgroup_ino	= __trace_wb_assign_cgroup(wb);
+	),
+
+	TP_printk("bdi %s: latency=%lu target=%u bw_thresh=%lu thresh=%lu "
+		  "awrite_bw=%lu cgroup_ino=%u",
+		  __entry->bdi,
+		  __entry->latency,	/* ms */
+		  __entry->target,	/* ms */
+		  __entry->bw_thresh,	/* pages */
+		  __entry->thresh,	/* pages */
+		  __entry->avg_write_bw,
+		  __entry->cgroup_ino
+	)
+);
+
 TRACE_EVENT(writeback_sb_inodes_requeue,
 
 	TP_PROTO(struct inode *inode),
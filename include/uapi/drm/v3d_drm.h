@@ -38,6 +38,7 @@ extern "C" {
 #define DRM_V3D_GET_BO_OFFSET                     0x05
 #define DRM_V3D_SUBMIT_TFU                        0x06
 #define DRM_V3D_SUBMIT_CSD                        0x07
+#define DRM_V3D_SET_PRIORITY                      0x08
 
 #define DRM_IOCTL_V3D_SUBMIT_CL           DRM_IOWR(DRM_COMMAND_BASE + DRM_V3D_SUBMIT_CL, struct drm_v3d_submit_cl)
 #define DRM_IOCTL_V3D_WAIT_BO             DRM_IOWR(DRM_COMMAND_BASE + DRM_V3D_WAIT_BO, struct drm_v3d_wait_bo)
@@ -47,6 +48,7 @@ extern "C" {
 #define DRM_IOCTL_V3D_GET_BO_OFFSET       DRM_IOWR(DRM_COMMAND_BASE + DRM_V3D_GET_BO_OFFSET, struct drm_v3d_get_bo_offset)
 #define DRM_IOCTL_V3D_SUBMIT_TFU          DRM_IOW(DRM_COMMAND_BASE + DRM_V3D_SUBMIT_TFU, struct drm_v3d_submit_tfu)
 #define DRM_IOCTL_V3D_SUBMIT_CSD          DRM_IOW(DRM_COMMAND_BASE + DRM_V3D_SUBMIT_CSD, struct drm_v3d_submit_csd)
+#define DRM_IOCTL_V3D_SET_PRIORITY        DRM_IOW(DRM_COMMAND_BASE + DRM_V3D_SET_PRIORITY, struct drm_v3d_set_priority)
 
 #define DRM_V3D_SUBMIT_CL_FLUSH_CACHE             0x01
 
@@ -177,6 +179,7 @@ enum drm_v3d_param {
 	DRM_V3D_PARAM_SUPPORTS_TFU,
 	DRM_V3D_PARAM_SUPPORTS_CSD,
 	DRM_V3D_PARAM_SUPPORTS_CACHE_FLUSH,
+	DRM_V3D_PARAM_SUPPORTS_PRIORITY,
 };
 
 struct drm_v3d_get_param {
@@ -242,6 +245,28 @@ struct drm_v3d_submit_csd {
 	__u32 out_sync;
 };
 
+enum drm_v3d_priority {
+	DRM_V3D_PRIORITY_LOW,
+	DRM_V3D_PRIORITY_NORMAL,
+	DRM_V3D_PRIORITY_HIGH,
+};
+
+/**
+ * struct drm_v3d_set_priority - ioctl argument for setting the scheduling
+ * priority of the jobs submitted on this fd.
+ *
+ * On each queue, jobs from higher priority fds are handed to the GPU
+ * before those of lower priority ones, though a job that is already
+ * running is never preempted.  The fd starts at DRM_V3D_PRIORITY_NORMAL,
+ * and raising it to DRM_V3D_PRIORITY_HIGH requires being DRM master or
+ * having CAP_SYS_NICE.
+ */
+struct drm_v3d_set_priority {
+	/* One of enum drm_v3d_priority. */
+	__u32 priority;
+	__u32 pad;
+};
+
 #if defined(__cplusplus)
 }
 #endif
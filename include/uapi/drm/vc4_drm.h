@@ -435,6 +435,25 @@ struct drm_vc4_perfmon_get_values {
 	__u64 values_ptr;
 };
 
+/*
+ * Record emitted by the system-wide perf counter sampler into the
+ * debugfs perfmon_sampler/samples<cpu> relay files.
+ *
+ * counters[] holds the number of events counted since the previous
+ * sample, in the order the events were written to
+ * perfmon_sampler/events. The seqnos allow matching samples with
+ * submitted jobs, and timestamp_ns is CLOCK_MONOTONIC like vblank
+ * event timestamps.
+ */
+struct drm_vc4_perfmon_sample {
+	__u64 timestamp_ns;
+	__u64 emit_seqno;
+	__u64 finished_seqno;
+	__u32 ncounters;
+	__u32 counters[DRM_VC4_MAX_PERF_COUNTERS];
+	__u32 pad;
+};
+
 #if defined(__cplusplus)
 }
 #endif
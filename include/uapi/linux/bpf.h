@@ -103,6 +103,12 @@ enum bpf_cmd {
 	BPF_BTF_LOAD,
 	BPF_BTF_GET_FD_BY_ID,
 	BPF_TASK_FD_QUERY,
+	/* 21 - 23 are taken upstream by BPF_MAP_LOOKUP_AND_DELETE_ELEM,
+	 * BPF_MAP_FREEZE and BPF_BTF_GET_NEXT_ID, which are not
+	 * implemented here.
+	 */
+	BPF_MAP_LOOKUP_BATCH = 24,
+	BPF_MAP_LOOKUP_AND_DELETE_BATCH,
 };
 
 enum bpf_map_type {
@@ -411,6 +417,23 @@ union bpf_attr {
 		__u64		probe_offset;	/* output: probe_offset */
 		__u64		probe_addr;	/* output: probe_addr */
 	} task_fd_query;
+
+	struct { /* struct used by BPF_MAP_*_BATCH commands */
+		__aligned_u64	in_batch;	/* start batch,
+						 * NULL to start from beginning
+						 */
+		__aligned_u64	out_batch;	/* output: next start batch */
+		__aligned_u64	keys;
+		__aligned_u64	values;
+		__u32		count;		/* input/output:
+						 * input: # of key/value
+						 * elements
+						 * output: # of filled elements
+						 */
+		__u32		map_fd;
+		__u64		elem_flags;
+		__u64		flags;
+	} batch;
 } __attribute__((aligned(8)));
 
 /* The description below is an attempt at providing documentation to eBPF
@@ -2493,6 +2516,31 @@ struct bpf_prog_info {
 	__u32 nr_jited_func_lens;
 	__aligned_u64 jited_ksyms;
 	__aligned_u64 jited_func_lens;
+	/* Upstream fields not implemented here, kept so that the fields
+	 * below have the same offsets as upstream.
+	 */
+	__u32 :32;		/* btf_id */
+	__u32 :32;		/* func_info_rec_size */
+	__u64 :64;		/* func_info */
+	__u32 :32;		/* nr_func_info */
+	__u32 :32;		/* nr_line_info */
+	__u64 :64;		/* line_info */
+	__u64 :64;		/* jited_line_info */
+	__u32 :32;		/* nr_jited_line_info */
+	__u32 :32;		/* line_info_rec_size */
+	__u32 :32;		/* jited_line_info_rec_size */
+	__u32 :32;		/* nr_prog_tags */
+	__u64 :64;		/* prog_tags */
+	__u64 :64;		/* run_time_ns */
+	__u64 :64;		/* run_cnt */
+	__u64 :64;		/* recursion_misses */
+	__u32 verified_insns;	/* insns processed by the verifier */
+	__u32 :32;		/* attach_btf_obj_id */
+	__u32 :32;		/* attach_btf_id */
+	__u32 verified_states;	/* states stored for pruning */
+	__u32 peak_states;	/* most states stored at any one time */
+	__u32 pruned_states;	/* paths cut short by an equivalent state */
+	__u64 verification_time; /* ns spent in the verifier */
 } __attribute__((aligned(8)));
 
 struct bpf_map_info {
@@ -116,6 +116,10 @@
  *
  *  7.27
  *  - add FUSE_ABORT_ERROR
+ *
+ *  7.28
+ *  - add FUSE_MAX_PAGES, add max_pages to init_out
+ *  - add FUSE_DEV_IOC_RING_SETUP and FUSE_DEV_IOC_RING_ENTER
  */
 
 #ifndef _LINUX_FUSE_H
@@ -151,7 +155,7 @@
 #define FUSE_KERNEL_VERSION 7
 
 /** Minor version number of this interface */
-#define FUSE_KERNEL_MINOR_VERSION 27
+#define FUSE_KERNEL_MINOR_VERSION 28
 
 /** The node ID of the root inode */
 #define FUSE_ROOT_ID 1
@@ -251,6 +255,7 @@ struct fuse_file_lock {
  * FUSE_HANDLE_KILLPRIV: fs handles killing suid/sgid/cap on write/chown/trunc
  * FUSE_POSIX_ACL: filesystem supports posix acls
  * FUSE_ABORT_ERROR: reading the device after abort returns ECONNABORTED
+ * FUSE_MAX_PAGES: init_out.max_pages contains the max number of req pages
  */
 #define FUSE_ASYNC_READ		(1 << 0)
 #define FUSE_POSIX_LOCKS	(1 << 1)
@@ -274,6 +279,7 @@ struct fuse_file_lock {
 #define FUSE_HANDLE_KILLPRIV	(1 << 19)
 #define FUSE_POSIX_ACL		(1 << 20)
 #define FUSE_ABORT_ERROR	(1 << 21)
+#define FUSE_MAX_PAGES		(1 << 22)
 
 /**
  * CUSE INIT request/reply flags
@@ -612,7 +618,9 @@ struct fuse_init_out {
 	uint16_t	congestion_threshold;
 	uint32_t	max_write;
 	uint32_t	time_gran;
-	uint32_t	unused[9];
+	uint16_t	max_pages;
+	uint16_t	padding;
+	uint32_t	unused[8];
 };
 
 #define CUSE_INIT_INFO_MAX 4096
@@ -782,6 +790,47 @@ struct fuse_notify_retrieve_in {
 
 /* Device ioctls: */
 #define FUSE_DEV_IOC_CLONE	_IOR(229, 0, uint32_t)
+#define FUSE_DEV_IOC_RING_SETUP	_IOWR(229, 1, struct fuse_ring_setup)
+#define FUSE_DEV_IOC_RING_ENTER	_IOW(229, 2, uint32_t)
+
+/*
+ * Shared request ring:
+ *
+ * FUSE_DEV_IOC_RING_SETUP allocates a buffer of 'size' bytes that the
+ * server maps with mmap() at offset zero.  It starts with a struct
+ * fuse_ring_hdr, followed by 'nr_slots' request slots at 'req_offset' and
+ * 'nr_slots' reply slots at 'reply_offset', each 'slot_size' bytes.
+ *
+ * The kernel fills request slots with the same data a read() on the device
+ * would return and advances req_tail; the server consumes them and
+ * advances req_head.  The server writes replies (or notifications) to
+ * reply slots in the format accepted by write() on the device and advances
+ * reply_tail; the kernel consumes them and advances reply_head.  The
+ * length of each slot's contents is given by its fuse_in_header or
+ * fuse_out_header.  Indices are free running and masked with nr_slots - 1.
+ *
+ * FUSE_DEV_IOC_RING_ENTER first consumes all posted replies, then fills as
+ * many free request slots as there are pending requests and returns the
+ * number of requests added.  With FUSE_RING_ENTER_WAIT it blocks until at
+ * least one request is available.  poll() on the device still reports
+ * pending requests.
+ */
+struct fuse_ring_setup {
+	uint32_t	nr_slots;
+	uint32_t	slot_size;
+	uint64_t	req_offset;
+	uint64_t	reply_offset;
+	uint64_t	size;
+};
+
+struct fuse_ring_hdr {
+	uint32_t	req_head;
+	uint32_t	req_tail;
+	uint32_t	reply_head;
+	uint32_t	reply_tail;
+};
+
+#define FUSE_RING_ENTER_WAIT	(1 << 0)
 
 struct fuse_lseek_in {
 	uint64_t	fh;
@@ -57,6 +57,7 @@ struct sockaddr_ll {
 #define PACKET_QDISC_BYPASS		20
 #define PACKET_ROLLOVER_STATS		21
 #define PACKET_FANOUT_DATA		22
+#define PACKET_TX_STATS			23
 
 #define PACKET_FANOUT_HASH		0
 #define PACKET_FANOUT_LB		1
@@ -87,6 +88,12 @@ struct tpacket_rollover_stats {
 	__aligned_u64	tp_failed;
 };
 
+struct tpacket_tx_stats {
+	__aligned_u64	tp_packets;	/* frames handed to the device */
+	__aligned_u64	tp_drops;	/* frames the qdisc or driver dropped */
+	__aligned_u64	tp_wrong_format;	/* malformed frames */
+};
+
 union tpacket_stats_u {
 	struct tpacket_stats stats1;
 	struct tpacket_stats_v3 stats3;
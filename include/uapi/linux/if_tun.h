@@ -65,6 +65,10 @@
 #define IFF_TAP		0x0002
 #define IFF_NAPI	0x0010
 #define IFF_NAPI_FRAGS	0x0020
+/* One packet per iovec in readv()/writev(). 0x0040 is IFF_NO_CARRIER
+ * upstream, keep clear of it.
+ */
+#define IFF_MULTI_FRAME	0x0080
 #define IFF_NO_PI	0x1000
 /* This flag has no real effect */
 #define IFF_ONE_QUEUE	0x2000
@@ -220,4 +220,12 @@ struct prctl_mm_map {
 # define PR_SPEC_DISABLE		(1UL << 2)
 # define PR_SPEC_FORCE_DISABLE		(1UL << 3)
 
+/* Have khugepaged scan this process ahead of the others */
+#define PR_SET_THP_PRIORITY		54
+#define PR_GET_THP_PRIORITY		55
+
+/* Let KSM merge all anonymous memory of this process */
+#define PR_SET_MEMORY_MERGE		56
+#define PR_GET_MEMORY_MERGE		57
+
 #endif /* _LINUX_PRCTL_H */
@@ -39,6 +39,10 @@
 /* TLS socket options */
 #define TLS_TX			1	/* Set transmit parameters */
 #define TLS_RX			2	/* Set receive parameters */
+/* 3 - 5 are TLS_TX_ZEROCOPY_RO, TLS_RX_EXPECT_NO_PAD and
+ * TLS_TX_MAX_PAYLOAD_LEN upstream.
+ */
+#define TLS_TX_STATS		6	/* Get transmit record statistics */
 
 /* Supported versions */
 #define TLS_VERSION_MINOR(ver)	((ver) & 0xFF)
@@ -75,4 +79,10 @@ struct tls12_crypto_info_aes_gcm_128 {
 	unsigned char rec_seq[TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE];
 };
 
+struct tls_tx_stats {
+	__u64 records;		/* records encrypted */
+	__u64 async_records;	/* records completed by an async cipher */
+	__u64 bytes;		/* plaintext bytes encrypted */
+};
+
 #endif /* _UAPI_LINUX_TLS_H */
@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef _UAPI_TRACE_PIPE_MMAP_H_
+#define _UAPI_TRACE_PIPE_MMAP_H_
+
+#include <linux/types.h>
+
+/**
+ * struct trace_pipe_meta - Ring-buffer meta-page description
+ * @meta_page_size:	Size of this meta-page.
+ * @meta_struct_len:	Size of this structure.
+ * @subbuf_size:	Size of each sub-buffer, header included.
+ * @nr_subbufs:		Number of sub-buffers in the mapping.
+ * @reader.lost_events:	Events lost before the current reader sub-buffer.
+ * @reader.id:		Sub-buffer the consumer should read from.
+ * @reader.read:	Offset into the sub-buffer data of the first event
+ *			handed out by the last TRACE_PIPE_IOCTL_GET_READER.
+ * @reader.commit:	Offset into the sub-buffer data just past the last
+ *			event handed out by that same ioctl.
+ * @entries:		Number of entries in the ring-buffer.
+ * @overrun:		Number of entries lost in the ring-buffer.
+ * @read:		Number of entries that have been read.
+ *
+ * The meta-page is the first page of the mapping; sub-buffer @id lives at
+ * offset (@id + 1) * @meta_page_size. Each sub-buffer has the same layout
+ * as the pages read from trace_pipe_raw. Events in [@reader.read,
+ * @reader.commit) are the consumer's until it asks for the next batch with
+ * TRACE_PIPE_IOCTL_GET_READER, which also accounts them as read.
+ */
+struct trace_pipe_meta {
+	__u32	meta_page_size;
+	__u32	meta_struct_len;
+
+	__u32	subbuf_size;
+	__u32	nr_subbufs;
+
+	struct {
+		__u64	lost_events;
+		__u32	id;
+		__u32	read;
+		__u32	commit;
+		__u32	__reserved;
+	} reader;
+
+	__u64	entries;
+	__u64	overrun;
+	__u64	read;
+};
+
+#define TRACE_PIPE_IOCTL_GET_READER		_IO('R', 0x21)
+
+#endif /* _UAPI_TRACE_PIPE_MMAP_H_ */
@@ -288,6 +288,33 @@ struct usb_functionfs_event {
 #define	FUNCTIONFS_ENDPOINT_DESC	_IOR('g', 130, \
 					     struct usb_endpoint_descriptor)
 
+/*
+ * Attach the dma-buf whose fd is passed to this endpoint, mapping it
+ * for the controller's DMA.  It stays attached until detached or the
+ * endpoint file is closed.
+ */
+#define	FUNCTIONFS_DMABUF_ATTACH	_IOW('g', 131, int)
+
+/* Detach the given dma-buf from this endpoint. */
+#define	FUNCTIONFS_DMABUF_DETACH	_IOW('g', 132, int)
+
+/*
+ * Queue a zero-copy transfer of the first @length bytes of an attached
+ * dma-buf, without waiting for it.  The transfer adds a fence to the
+ * dma-buf's reservation object, so completion is seen by polling the
+ * dma-buf fd; a failed transfer signals that fence with an error.
+ * Returns -EBUSY while an earlier transfer still owns the buffer.
+ * @flags must be zero.
+ */
+struct usb_ffs_dmabuf_transfer_req {
+	int fd;
+	__u32 flags;
+	__u64 length;
+} __attribute__((packed));
+
+#define	FUNCTIONFS_DMABUF_TRANSFER	_IOW('g', 133, \
+					     struct usb_ffs_dmabuf_transfer_req)
+
 
 
 #endif /* _UAPI__LINUX_FUNCTIONFS_H__ */
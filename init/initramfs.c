@@ -10,6 +10,7 @@
 #include <linux/syscalls.h>
 #include <linux/utime.h>
 #include <linux/file.h>
+#include <linux/async.h>
 
 static ssize_t __init xwrite(int fd, const char *p, size_t count)
 {
@@ -513,6 +514,14 @@ static int __init retain_initrd_param(char *str)
 }
 __setup("retain_initrd", retain_initrd_param);
 
+static bool initramfs_async __initdata = true;
+static int __init initramfs_async_setup(char *str)
+{
+	strtobool(str, &initramfs_async);
+	return 1;
+}
+__setup("initramfs_async=", initramfs_async_setup);
+
 extern char __initramfs_start[];
 extern unsigned long __initramfs_size;
 #include <linux/initrd.h>
@@ -599,7 +608,12 @@ static void __init clean_rootfs(void)
 }
 #endif
 
-static int __init populate_rootfs(void)
+static void __init initramfs_load_modules(void *unused, async_cookie_t cookie)
+{
+	load_default_modules();
+}
+
+static void __init do_populate_rootfs(void *unused, async_cookie_t cookie)
 {
 	/* Load the built in initramfs */
 	char *err = unpack_to_rootfs(__initramfs_start, __initramfs_size);
@@ -645,11 +659,52 @@ static int __init populate_rootfs(void)
 	free_initrd();
 	flush_delayed_fput();
 	/*
-	 * Try loading default modules from initramfs.  This gives
-	 * us a chance to load before device_initcalls.
+	 * The usermode helper behind request_module() waits for us, so the
+	 * default modules cannot be loaded from this context.
 	 */
-	load_default_modules();
+	if (initramfs_async)
+		async_schedule(initramfs_load_modules, NULL);
+}
 
+static ASYNC_DOMAIN_EXCLUSIVE(initramfs_domain);
+static async_cookie_t initramfs_cookie;
+
+/**
+ * wait_for_initramfs - wait for the initramfs to be unpacked
+ *
+ * The initramfs is unpacked in the background while the rest of the
+ * initcalls run.  Anything that looks for files in rootfs before init is
+ * started, such as the firmware loader or a usermode helper, has to call
+ * this first.
+ */
+void wait_for_initramfs(void)
+{
+	if (!initramfs_cookie) {
+		/*
+		 * Something before rootfs_initcall wants to look at rootfs.
+		 * Don't deadlock on it; let the lookup fail as it always did.
+		 */
+		pr_warn_once("%s() called before rootfs_initcalls\n",
+			     __func__);
+		return;
+	}
+	async_synchronize_cookie_domain(initramfs_cookie + 1,
+					&initramfs_domain);
+}
+EXPORT_SYMBOL_GPL(wait_for_initramfs);
+
+static int __init populate_rootfs(void)
+{
+	initramfs_cookie = async_schedule_domain(do_populate_rootfs, NULL,
+						 &initramfs_domain);
+	if (!initramfs_async) {
+		wait_for_initramfs();
+		/*
+		 * Try loading default modules from initramfs.  This gives
+		 * us a chance to load before device_initcalls.
+		 */
+		load_default_modules();
+	}
 	return 0;
 }
 rootfs_initcall(populate_rootfs);
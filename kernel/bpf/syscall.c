@@ -752,6 +752,46 @@ static int map_lookup_elem(union bpf_attr *attr)
 	return err;
 }
 
+#define BPF_MAP_BATCH_LAST_FIELD batch.flags
+
+static int bpf_map_do_batch(const union bpf_attr *attr,
+			    union bpf_attr __user *uattr,
+			    int cmd)
+{
+	struct bpf_map *map;
+	struct fd f;
+	int err;
+
+	if (CHECK_ATTR(BPF_MAP_BATCH))
+		return -EINVAL;
+
+	f = fdget(attr->batch.map_fd);
+	map = __bpf_map_get(f);
+	if (IS_ERR(map))
+		return PTR_ERR(map);
+
+	if (!(f.file->f_mode & FMODE_CAN_READ) ||
+	    (cmd == BPF_MAP_LOOKUP_AND_DELETE_BATCH &&
+	     !(f.file->f_mode & FMODE_CAN_WRITE))) {
+		err = -EPERM;
+		goto err_put;
+	}
+
+	err = -ENOTSUPP;
+	if (cmd == BPF_MAP_LOOKUP_BATCH) {
+		if (map->ops->map_lookup_batch)
+			err = map->ops->map_lookup_batch(map, attr, uattr);
+	} else {
+		if (map->ops->map_lookup_and_delete_batch)
+			err = map->ops->map_lookup_and_delete_batch(map, attr,
+								    uattr);
+	}
+
+err_put:
+	fdput(f);
+	return err;
+}
+
 static void maybe_wait_bpf_programs(struct bpf_map *map)
 {
 	/* Wait for any running BPF programs to complete so that
@@ -1979,6 +2019,11 @@ static int bpf_prog_get_info_by_fd(struct bpf_prog *prog,
 	info.created_by_uid = from_kuid_munged(current_user_ns(),
 					       prog->aux->user->uid);
 	info.gpl_compatible = prog->gpl_compatible;
+	info.verified_insns = prog->aux->verified_insns;
+	info.verified_states = prog->aux->verified_states;
+	info.peak_states = prog->aux->peak_states;
+	info.pruned_states = prog->aux->pruned_states;
+	info.verification_time = prog->aux->verification_time;
 
 	memcpy(info.tag, prog->tag, sizeof(prog->tag));
 	memcpy(info.name, prog->aux->name, sizeof(prog->aux->name));
@@ -2460,6 +2505,13 @@ SYSCALL_DEFINE3(bpf, int, cmd, union bpf_attr __user *, uattr, unsigned int, siz
 	case BPF_TASK_FD_QUERY:
 		err = bpf_task_fd_query(&attr, uattr);
 		break;
+	case BPF_MAP_LOOKUP_BATCH:
+		err = bpf_map_do_batch(&attr, uattr, BPF_MAP_LOOKUP_BATCH);
+		break;
+	case BPF_MAP_LOOKUP_AND_DELETE_BATCH:
+		err = bpf_map_do_batch(&attr, uattr,
+				       BPF_MAP_LOOKUP_AND_DELETE_BATCH);
+		break;
 	default:
 		err = -EINVAL;
 		break;
@@ -4965,11 +4965,12 @@ static int propagate_liveness(struct bpf_verifier_env *env,
 static int is_state_visited(struct bpf_verifier_env *env, int insn_idx)
 {
 	struct bpf_verifier_state_list *new_sl;
-	struct bpf_verifier_state_list *sl;
+	struct bpf_verifier_state_list *sl, **pprev;
 	struct bpf_verifier_state *cur = env->cur_state;
 	int i, j, err, states_cnt = 0;
 
-	sl = env->explored_states[insn_idx];
+	pprev = &env->explored_states[insn_idx];
+	sl = *pprev;
 	if (!sl)
 		/* this 'insn_idx' instruction wasn't marked, so we will not
 		 * be doing state search here
@@ -4978,6 +4979,8 @@ static int is_state_visited(struct bpf_verifier_env *env, int insn_idx)
 
 	while (sl != STATE_LIST_MARK) {
 		if (states_equal(env, &sl->state, cur)) {
+			sl->hit_cnt++;
+			env->pruned_states++;
 			/* reached equivalent register/stack state,
 			 * prune the search.
 			 * Registers read by the continuation are read by us.
@@ -4993,7 +4996,21 @@ static int is_state_visited(struct bpf_verifier_env *env, int insn_idx)
 				return err;
 			return 1;
 		}
-		sl = sl->next;
+		/* A state that keeps failing to match only makes every later
+		 * search at this insn slower, stop comparing against it.
+		 * It cannot be freed yet: states explored from it still point
+		 * at it through their parentage chain for liveness marks.
+		 */
+		if (++sl->miss_cnt > sl->hit_cnt * 3 + 3) {
+			*pprev = sl->next;
+			sl->next = env->free_list;
+			env->free_list = sl;
+			env->explored_states_cnt--;
+			sl = *pprev;
+			continue;
+		}
+		pprev = &sl->next;
+		sl = *pprev;
 		states_cnt++;
 	}
 
@@ -5020,6 +5037,10 @@ static int is_state_visited(struct bpf_verifier_env *env, int insn_idx)
 	}
 	new_sl->next = env->explored_states[insn_idx];
 	env->explored_states[insn_idx] = new_sl;
+	env->total_states++;
+	env->explored_states_cnt++;
+	if (env->explored_states_cnt > env->peak_states)
+		env->peak_states = env->explored_states_cnt;
 	/* connect new state to parentage chain */
 	cur->parent = &new_sl->state;
 	/* clear write marks in current state: the writes we did are not writes
@@ -5047,7 +5068,6 @@ static int do_check(struct bpf_verifier_env *env)
 	struct bpf_insn *insns = env->prog->insnsi;
 	struct bpf_reg_state *regs;
 	int insn_cnt = env->prog->len, i;
-	int insn_processed = 0;
 	bool do_print_state = false;
 
 	state = kzalloc(sizeof(struct bpf_verifier_state), GFP_KERNEL);
@@ -5080,10 +5100,10 @@ static int do_check(struct bpf_verifier_env *env)
 		insn = &insns[env->insn_idx];
 		class = BPF_CLASS(insn->code);
 
-		if (++insn_processed > BPF_COMPLEXITY_LIMIT_INSNS) {
+		if (++env->insn_processed > BPF_COMPLEXITY_LIMIT_INSNS) {
 			verbose(env,
 				"BPF program is too large. Processed %d insn\n",
-				insn_processed);
+				env->insn_processed);
 			return -E2BIG;
 		}
 
@@ -5371,8 +5391,10 @@ static int do_check(struct bpf_verifier_env *env)
 		env->insn_idx++;
 	}
 
-	verbose(env, "processed %d insns (limit %d), stack depth ",
-		insn_processed, BPF_COMPLEXITY_LIMIT_INSNS);
+	verbose(env, "processed %d insns (limit %d), ",
+		env->insn_processed, BPF_COMPLEXITY_LIMIT_INSNS);
+	verbose(env, "total_states %d peak_states %d pruned %d, stack depth ",
+		env->total_states, env->peak_states, env->pruned_states);
 	for (i = 0; i < env->subprog_cnt; i++) {
 		u32 depth = env->subprog_info[i].stack_depth;
 
@@ -6258,6 +6280,14 @@ static void free_states(struct bpf_verifier_env *env)
 	struct bpf_verifier_state_list *sl, *sln;
 	int i;
 
+	sl = env->free_list;
+	while (sl) {
+		sln = sl->next;
+		free_verifier_state(&sl->state, false);
+		kfree(sl);
+		sl = sln;
+	}
+
 	if (!env->explored_states)
 		return;
 
@@ -6276,8 +6306,21 @@ static void free_states(struct bpf_verifier_env *env)
 	kfree(env->explored_states);
 }
 
+static void bpf_verifier_record_stats(struct bpf_verifier_env *env,
+				      u64 start_time)
+{
+	struct bpf_prog_aux *aux = env->prog->aux;
+
+	aux->verification_time = ktime_get_ns() - start_time;
+	aux->verified_insns = env->insn_processed;
+	aux->verified_states = env->total_states;
+	aux->peak_states = env->peak_states;
+	aux->pruned_states = env->pruned_states;
+}
+
 int bpf_check(struct bpf_prog **prog, union bpf_attr *attr)
 {
+	u64 start_time = ktime_get_ns();
 	struct bpf_verifier_env *env;
 	struct bpf_verifier_log *log;
 	int ret = -EINVAL;
@@ -6408,6 +6451,7 @@ int bpf_check(struct bpf_prog **prog, union bpf_attr *attr)
 		 * them now. Otherwise free_used_maps() will release them.
 		 */
 		release_maps(env);
+	bpf_verifier_record_stats(env, start_time);
 	*prog = env->prog;
 err_unlock:
 	mutex_unlock(&bpf_verifier_lock);
@@ -636,6 +636,7 @@ void __mmdrop(struct mm_struct *mm)
 	destroy_context(mm);
 	hmm_mm_destroy(mm);
 	mmu_notifier_mm_destroy(mm);
+	futex_mm_free(mm);
 	check_mm(mm);
 	put_user_ns(mm->user_ns);
 	free_mm(mm);
@@ -964,6 +965,7 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 	mm->pmd_huge_pte = NULL;
 #endif
 	mm_init_uprobes_state(mm);
+	futex_mm_init(mm);
 
 	if (current->mm) {
 		mm->flags = current->mm->flags & MMF_INIT_MASK;
@@ -1335,6 +1337,8 @@ static int copy_mm(unsigned long clone_flags, struct task_struct *tsk)
 	vmacache_flush(tsk);
 
 	if (clone_flags & CLONE_VM) {
+		if (clone_flags & CLONE_THREAD)
+			futex_mm_new_thread(oldmm);
 		mmget(oldmm);
 		mm = oldmm;
 		goto good_mm;
@@ -280,6 +280,17 @@ static struct {
 #define futex_queues   (__futex_data.queues)
 #define futex_hashsize (__futex_data.hashsize)
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+/*
+ * Buckets for the private futexes of one mm, see futex_mm_new_thread().
+ * Private keys never match across mms, so they need not share a table.
+ */
+struct futex_private_hash {
+	unsigned long			hashmask;
+	struct futex_hash_bucket	queues[];
+};
+#endif
+
 
 /*
  * Fault injections for futexes.
@@ -386,21 +397,84 @@ static inline int hb_waiters_pending(struct futex_hash_bucket *hb)
 #endif
 }
 
+static void futex_hash_bucket_init(struct futex_hash_bucket *hb)
+{
+	atomic_set(&hb->waiters, 0);
+	plist_head_init(&hb->chain);
+	spin_lock_init(&hb->lock);
+}
+
 /**
  * hash_futex - Return the hash bucket in the global hash
  * @key:	Pointer to the futex key for which the hash is calculated
  *
  * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * corresponding hash bucket in the global hash, or in the private hash of
+ * the key's mm for a private futex of a process that has one.
  */
 static struct futex_hash_bucket *hash_futex(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))) {
+		struct futex_private_hash *fph = key->private.mm->futex_phash;
+
+		if (fph)
+			return &fph->queues[hash & fph->hashmask];
+	}
+#endif
+
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+void futex_mm_init(struct mm_struct *mm)
+{
+	mm->futex_phash = NULL;
+}
+
+/**
+ * futex_mm_new_thread - Give @mm a private futex hash before it goes threaded
+ * @mm:		mm of the current task, about to get another thread
+ *
+ * A futex must hash to the same bucket for as long as it has waiters, so
+ * the table of @mm can only be switched while no private futex of @mm is
+ * queued anywhere.  That holds while current is the only user of @mm: it
+ * is running through clone() and so is not waiting itself.  If allocation
+ * fails here the process keeps using the global hash, which is equally
+ * correct.
+ */
+void futex_mm_new_thread(struct mm_struct *mm)
+{
+	struct futex_private_hash *fph;
+	unsigned long hashsize;
+	unsigned long i;
+
+	if (mm->futex_phash || atomic_read(&mm->mm_users) != 1)
+		return;
+
+	hashsize = roundup_pow_of_two(max(16U, 4 * num_possible_cpus()));
+	fph = kvzalloc_node(struct_size(fph, queues, hashsize),
+			    GFP_KERNEL_ACCOUNT | __GFP_NOWARN, numa_node_id());
+	if (!fph)
+		return;
+
+	fph->hashmask = hashsize - 1;
+	for (i = 0; i < hashsize; i++)
+		futex_hash_bucket_init(&fph->queues[i]);
+
+	/* the new thread and everyone after it find it through clone() */
+	mm->futex_phash = fph;
+}
+
+void futex_mm_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+}
+#endif
+
 
 /**
  * match_futex - Check whether two futex keys are equal
@@ -3997,11 +4071,8 @@ static int __init futex_init(void)
 
 	futex_detect_cmpxchg();
 
-	for (i = 0; i < futex_hashsize; i++) {
-		atomic_set(&futex_queues[i].waiters, 0);
-		plist_head_init(&futex_queues[i].chain);
-		spin_lock_init(&futex_queues[i].lock);
-	}
+	for (i = 0; i < futex_hashsize; i++)
+		futex_hash_bucket_init(&futex_queues[i]);
 
 	return 0;
 }
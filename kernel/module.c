@@ -62,6 +62,7 @@
 #include <linux/jump_label.h>
 #include <linux/pfn.h>
 #include <linux/bsearch.h>
+#include <linux/hash.h>
 #include <linux/dynamic_debug.h>
 #include <linux/audit.h>
 #include <uapi/linux/module.h>
@@ -3882,13 +3883,127 @@ SYSCALL_DEFINE3(init_module, void __user *, umod,
 	return load_module(&info, uargs, 0);
 }
 
-SYSCALL_DEFINE3(finit_module, int, fd, const char __user *, uargs, int, flags)
+/*
+ * udev tends to ask for the same module from many threads at once.  Only
+ * the first finit_module() of a given file reads and loads it; the others
+ * wait for it and return its result instead of each reading, allocating and
+ * relocating their own copy only to fail with -EEXIST.
+ */
+struct module_load_wait {
+	const void *cookie;
+	struct hlist_node entry;
+	struct completion done;
+	int ret;
+};
+
+#define MODULE_LOAD_HASH_BITS	6
+static struct hlist_head module_load_hash[1 << MODULE_LOAD_HASH_BITS];
+static DEFINE_SPINLOCK(module_load_lock);
+
+/* Returns true if someone else is already loading @cookie */
+static bool module_load_begin(struct module_load_wait *w, const void *cookie)
+{
+	struct hlist_head *head;
+	struct module_load_wait *pos;
+	bool busy = false;
+
+	w->cookie = cookie;
+	w->ret = 0;
+	init_completion(&w->done);
+	head = &module_load_hash[hash_ptr(cookie, MODULE_LOAD_HASH_BITS)];
+
+	spin_lock(&module_load_lock);
+	hlist_for_each_entry(pos, head, entry) {
+		if (pos->cookie == cookie) {
+			busy = true;
+			break;
+		}
+	}
+	hlist_add_head(&w->entry, head);
+	spin_unlock(&module_load_lock);
+
+	return busy;
+}
+
+/* Hand @ret to everyone waiting on @w's cookie, including @w itself */
+static int module_load_end(struct module_load_wait *w, int ret)
+{
+	struct hlist_head *head;
+	struct module_load_wait *pos;
+	struct hlist_node *next;
+
+	head = &module_load_hash[hash_ptr(w->cookie, MODULE_LOAD_HASH_BITS)];
+
+	spin_lock(&module_load_lock);
+	hlist_for_each_entry_safe(pos, next, head, entry) {
+		if (pos->cookie != w->cookie)
+			continue;
+		hlist_del_init(&pos->entry);
+		pos->ret = ret;
+		complete(&pos->done);
+	}
+	spin_unlock(&module_load_lock);
+
+	return ret;
+}
+
+/*
+ * Wait for the load in progress for @w's cookie and return its result, or
+ * just drop out with @err if that is set.
+ */
+static int module_load_wait(struct module_load_wait *w, int err)
+{
+	if (!err) {
+		err = wait_for_completion_killable(&w->done);
+		if (!err)
+			return w->ret;
+	}
+
+	spin_lock(&module_load_lock);
+	if (!hlist_unhashed(&w->entry))
+		hlist_del(&w->entry);
+	spin_unlock(&module_load_lock);
+
+	return err;
+}
+
+/*
+ * A caller that shares another's load never reads the file itself, so make
+ * the checks kernel_read_file() would have made for it, LSM and IMA
+ * included.
+ */
+static int finit_module_may_read(struct file *file)
+{
+	if (!S_ISREG(file_inode(file)->i_mode))
+		return -EINVAL;
+	if (!(file->f_mode & FMODE_READ))
+		return -EBADF;
+	return security_kernel_read_file(file, READING_MODULE);
+}
+
+static int finit_module_file(struct file *file, const char __user *uargs,
+			     int flags)
 {
 	struct load_info info = { };
 	loff_t size;
 	void *hdr;
 	int err;
 
+	err = kernel_read_file(file, &hdr, &size, INT_MAX, READING_MODULE);
+	if (err)
+		return err;
+	info.hdr = hdr;
+	info.len = size;
+
+	return load_module(&info, uargs, flags);
+}
+
+SYSCALL_DEFINE3(finit_module, int, fd, const char __user *, uargs, int, flags)
+{
+	struct module_load_wait w;
+	struct fd f;
+	int err;
+
 	err = may_init_module();
 	if (err)
 		return err;
@@ -3899,14 +4014,19 @@ SYSCALL_DEFINE3(finit_module, int, fd, const char __user *, uargs, int, flags)
 		      |MODULE_INIT_IGNORE_VERMAGIC))
 		return -EINVAL;
 
-	err = kernel_read_file_from_fd(fd, &hdr, &size, INT_MAX,
-				       READING_MODULE);
-	if (err)
-		return err;
-	info.hdr = hdr;
-	info.len = size;
+	f = fdget(fd);
+	if (!f.file)
+		return -EBADF;
 
-	return load_module(&info, uargs, flags);
+	if (module_load_begin(&w, file_inode(f.file))) {
+		err = finit_module_may_read(f.file);
+		fdput(f);
+		return module_load_wait(&w, err);
+	}
+
+	err = module_load_end(&w, finit_module_file(f.file, uargs, flags));
+	fdput(f);
+	return err;
 }
 
 static inline int within(unsigned long addr, void *start, unsigned long size)
@@ -32,6 +32,7 @@
 #include <linux/sysfs.h>
 #include <linux/rcupdate.h>
 #include <linux/module.h>
+#include <linux/ktime.h>
 
 #define MAX_OBJ_NUM 1000
 
@@ -132,6 +133,7 @@ int padata_do_parallel(struct padata_instance *pinst,
 	atomic_inc(&pd->refcnt);
 	padata->pd = pd;
 	padata->cb_cpu = cb_cpu;
+	padata->start_ns = ktime_get_ns();
 
 	target_cpu = padata_cpu_hash(pd);
 	padata->cpu = target_cpu;
@@ -213,10 +215,11 @@ static struct padata_priv *padata_get_next(struct parallel_data *pd)
 
 static void padata_reorder(struct parallel_data *pd)
 {
-	int cb_cpu;
+	int cb_cpu, cpu;
 	struct padata_priv *padata;
 	struct padata_serial_queue *squeue;
 	struct padata_instance *pinst = pd->pinst;
+	struct padata_parallel_queue *next_queue;
 
 	/*
 	 * We need to ensure that only one cpu can work on dequeueing of
@@ -248,7 +251,6 @@ static void padata_reorder(struct parallel_data *pd)
 		 * so exit immediately.
 		 */
 		if (PTR_ERR(padata) == -ENODATA) {
-			del_timer(&pd->timer);
 			spin_unlock_bh(&pd->lock);
 			return;
 		}
@@ -267,21 +269,22 @@ static void padata_reorder(struct parallel_data *pd)
 
 	/*
 	 * The next object that needs serialization might have arrived to
-	 * the reorder queues in the meantime, we will be called again
-	 * from the timer function if no one else cares for it.
+	 * the reorder queues in the meantime.  Kick the reorder work on the
+	 * cpu it is queued on right away rather than leaving it to sit until
+	 * someone else happens to call padata_do_serial.
 	 *
-	 * Ensure reorder_objects is read after pd->lock is dropped so we see
-	 * an increment from another task in padata_do_serial.  Pairs with
+	 * Ensure the reorder queue is read after pd->lock is dropped so we see
+	 * new objects from another task in padata_do_serial.  Pairs with
 	 * smp_mb__after_atomic in padata_do_serial.
 	 */
 	smp_mb();
-	if (atomic_read(&pd->reorder_objects)
-			&& !(pinst->flags & PADATA_RESET))
-		mod_timer(&pd->timer, jiffies + HZ);
-	else
-		del_timer(&pd->timer);
 
-	return;
+	cpu = padata_index_to_cpu(pd, pd->processed %
+				  cpumask_weight(pd->cpumask.pcpu));
+	next_queue = per_cpu_ptr(pd->pqueue, cpu);
+	if (!list_empty(&next_queue->reorder.list) &&
+	    !(pinst->flags & PADATA_RESET))
+		queue_work_on(cpu, pinst->wq, &next_queue->reorder_work);
 }
 
 static void invoke_padata_reorder(struct work_struct *work)
@@ -296,57 +299,26 @@ static void invoke_padata_reorder(struct work_struct *work)
 	local_bh_enable();
 }
 
-static void padata_reorder_timer(struct timer_list *t)
-{
-	struct parallel_data *pd = from_timer(pd, t, timer);
-	unsigned int weight;
-	int target_cpu, cpu;
-
-	cpu = get_cpu();
-
-	/* We don't lock pd here to not interfere with parallel processing
-	 * padata_reorder() calls on other CPUs. We just need any CPU out of
-	 * the cpumask.pcpu set. It would be nice if it's the right one but
-	 * it doesn't matter if we're off to the next one by using an outdated
-	 * pd->processed value.
-	 */
-	weight = cpumask_weight(pd->cpumask.pcpu);
-	target_cpu = padata_index_to_cpu(pd, pd->processed % weight);
-
-	/* ensure to call the reorder callback on the correct CPU */
-	if (cpu != target_cpu) {
-		struct padata_parallel_queue *pqueue;
-		struct padata_instance *pinst;
-
-		/* The timer function is serialized wrt itself -- no locking
-		 * needed.
-		 */
-		pinst = pd->pinst;
-		pqueue = per_cpu_ptr(pd->pqueue, target_cpu);
-		queue_work_on(target_cpu, pinst->wq, &pqueue->reorder_work);
-	} else {
-		padata_reorder(pd);
-	}
-
-	put_cpu();
-}
-
 static void padata_serial_worker(struct work_struct *serial_work)
 {
 	struct padata_serial_queue *squeue;
 	struct parallel_data *pd;
+	struct padata_instance *pinst;
 	LIST_HEAD(local_list);
+	u64 now, delta, sum_ns = 0, max_ns = 0;
 	int cnt;
 
 	local_bh_disable();
 	squeue = container_of(serial_work, struct padata_serial_queue, work);
 	pd = squeue->pd;
+	pinst = pd->pinst;
 
 	spin_lock(&squeue->serial.lock);
 	list_replace_init(&squeue->serial.list, &local_list);
 	spin_unlock(&squeue->serial.lock);
 
 	cnt = 0;
+	now = ktime_get_ns();
 
 	while (!list_empty(&local_list)) {
 		struct padata_priv *padata;
@@ -356,9 +328,23 @@ static void padata_serial_worker(struct work_struct *serial_work)
 
 		list_del_init(&padata->list);
 
+		delta = now - padata->start_ns;
+		sum_ns += delta;
+		if (delta > max_ns)
+			max_ns = delta;
+
 		padata->serial(padata);
 		cnt++;
 	}
+
+	if (cnt) {
+		spin_lock(&pinst->stats_lock);
+		pinst->stats.count += cnt;
+		pinst->stats.sum_ns += sum_ns;
+		if (max_ns > pinst->stats.max_ns)
+			pinst->stats.max_ns = max_ns;
+		spin_unlock(&pinst->stats_lock);
+	}
 	local_bh_enable();
 
 	if (atomic_sub_and_test(cnt, &pd->refcnt))
@@ -506,7 +492,6 @@ static struct parallel_data *padata_alloc_pd(struct padata_instance *pinst,
 
 	padata_init_pqueues(pd);
 	padata_init_squeues(pd);
-	timer_setup(&pd->timer, padata_reorder_timer, 0);
 	atomic_set(&pd->seq_nr, -1);
 	atomic_set(&pd->reorder_objects, 0);
 	atomic_set(&pd->refcnt, 1);
@@ -935,17 +920,36 @@ static ssize_t store_cpumask(struct padata_instance *pinst,
 	static struct padata_sysfs_entry _name##_attr = \
 		__ATTR(_name, 0400, _show_name, NULL)
 
+static ssize_t show_latency(struct padata_instance *pinst,
+			    struct attribute *attr, char *buf)
+{
+	struct padata_stats stats;
+
+	spin_lock_bh(&pinst->stats_lock);
+	stats = pinst->stats;
+	spin_unlock_bh(&pinst->stats_lock);
+
+	return snprintf(buf, PAGE_SIZE, "%llu %llu %llu\n", stats.count,
+			stats.count ? div64_u64(stats.sum_ns, stats.count) : 0,
+			stats.max_ns);
+}
+
 PADATA_ATTR_RW(serial_cpumask, show_cpumask, store_cpumask);
 PADATA_ATTR_RW(parallel_cpumask, show_cpumask, store_cpumask);
+PADATA_ATTR_RO(latency, show_latency);
 
 /*
  * Padata sysfs provides the following objects:
  * serial_cpumask   [RW] - cpumask for serial workers
  * parallel_cpumask [RW] - cpumask for parallel workers
+ * latency          [RO] - objects serialized, average and maximum
+ *                         nanoseconds from padata_do_parallel to the
+ *                         serial callback
  */
 static struct attribute *padata_default_attrs[] = {
 	&serial_cpumask_attr.attr,
 	&parallel_cpumask_attr.attr,
+	&latency_attr.attr,
 	NULL,
 };
 
@@ -1037,6 +1041,7 @@ static struct padata_instance *padata_alloc(struct workqueue_struct *wq,
 	BLOCKING_INIT_NOTIFIER_HEAD(&pinst->cpumask_change_notifier);
 	kobject_init(&pinst->kobj, &padata_attr_type);
 	mutex_init(&pinst->lock);
+	spin_lock_init(&pinst->stats_lock);
 
 #ifdef CONFIG_HOTPLUG_CPU
 	cpuhp_state_add_instance_nocalls_cpuslocked(hp_online, &pinst->node);
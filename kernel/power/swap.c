@@ -27,6 +27,7 @@
 #include <linux/pm.h>
 #include <linux/slab.h>
 #include <linux/lzo.h>
+#include <linux/lz4.h>
 #include <linux/vmalloc.h>
 #include <linux/cpumask.h>
 #include <linux/atomic.h>
@@ -517,6 +518,13 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 			             LZO_HEADER, PAGE_SIZE)
 #define LZO_CMP_SIZE	(LZO_CMP_PAGES * PAGE_SIZE)
 
+/*
+ * LZ4 output always fits the LZO worst case above. The workspace has to fit
+ * whichever compressor the image is written with.
+ */
+#define CMP_WRK_SIZE	(LZ4_MEM_COMPRESS > LZO1X_1_MEM_COMPRESS ? \
+			 LZ4_MEM_COMPRESS : LZO1X_1_MEM_COMPRESS)
+
 /* Maximum number of threads for compression/decompression. */
 #define LZO_THREADS	3
 
@@ -615,7 +623,7 @@ static int crc32_threadfn(void *data)
 	return 0;
 }
 /**
- * Structure used for LZO data compression.
+ * Structure used for LZO or LZ4 data compression.
  */
 struct cmp_data {
 	struct task_struct *thr;                  /* thread */
@@ -624,11 +632,12 @@ struct cmp_data {
 	int ret;                                  /* return code */
 	wait_queue_head_t go;                     /* start compression */
 	wait_queue_head_t done;                   /* compression done */
+	bool lz4;                                 /* LZ4 instead of LZO */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
-	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* compression workspace */
+	unsigned char wrk[CMP_WRK_SIZE];          /* compression workspace */
 };
 
 /**
@@ -650,9 +659,18 @@ static int lzo_compress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->ret = lzo1x_1_compress(d->unc, d->unc_len,
-		                          d->cmp + LZO_HEADER, &d->cmp_len,
-		                          d->wrk);
+		if (d->lz4) {
+			int len = LZ4_compress_default(d->unc,
+					d->cmp + LZO_HEADER, d->unc_len,
+					LZO_CMP_SIZE - LZO_HEADER, d->wrk);
+
+			d->cmp_len = len > 0 ? len : 0;
+			d->ret = len > 0 ? 0 : -1;
+		} else {
+			d->ret = lzo1x_1_compress(d->unc, d->unc_len,
+						  d->cmp + LZO_HEADER,
+						  &d->cmp_len, d->wrk);
+		}
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -660,14 +678,15 @@ static int lzo_compress_threadfn(void *data)
 }
 
 /**
- * save_image_lzo - Save the suspend image data compressed with LZO.
+ * save_image_lzo - Save the suspend image data compressed with LZO or LZ4.
  * @handle: Swap map handle to use for saving the image.
  * @snapshot: Image to read data from.
  * @nr_to_write: Number of pages to save.
+ * @lz4: Compress with LZ4 rather than LZO.
  */
 static int save_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_write)
+                          unsigned int nr_to_write, bool lz4)
 {
 	unsigned int m;
 	int ret = 0;
@@ -681,6 +700,7 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	unsigned char *page = NULL;
 	struct cmp_data *data = NULL;
 	struct crc_data *crc = NULL;
+	struct blk_plug plug;
 
 	hib_init_batch(&hb);
 
@@ -704,8 +724,10 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct cmp_data, go));
+		data[thr].lz4 = lz4;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -832,6 +854,11 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			 * any garbage at the end will be discarded when we
 			 * read it.
 			 */
+			/*
+			 * Plug so that the compressed block goes out as a few
+			 * large requests instead of one per page.
+			 */
+			blk_start_plug(&plug);
 			for (off = 0;
 			     off < LZO_HEADER + data[thr].cmp_len;
 			     off += PAGE_SIZE) {
@@ -839,8 +866,11 @@ static int save_image_lzo(struct swap_map_handle *handle,
 
 				ret = swap_write_page(handle, page, &hb);
 				if (ret)
-					goto out_finish;
+					break;
 			}
+			blk_finish_plug(&plug);
+			if (ret)
+				goto out_finish;
 		}
 
 		wait_event(crc->done, atomic_read(&crc->stop));
@@ -934,7 +964,8 @@ int swsusp_write(unsigned int flags)
 	if (!error) {
 		error = (flags & SF_NOCOMPRESS_MODE) ?
 			save_image(&handle, &snapshot, pages - 1) :
-			save_image_lzo(&handle, &snapshot, pages - 1);
+			save_image_lzo(&handle, &snapshot, pages - 1,
+				       flags & SF_LZ4_MODE);
 	}
 out_finish:
 	error = swap_writer_finish(&handle, flags, error);
@@ -1101,7 +1132,7 @@ static int load_image(struct swap_map_handle *handle,
 }
 
 /**
- * Structure used for LZO data decompression.
+ * Structure used for LZO or LZ4 data decompression.
  */
 struct dec_data {
 	struct task_struct *thr;                  /* thread */
@@ -1110,6 +1141,7 @@ struct dec_data {
 	int ret;                                  /* return code */
 	wait_queue_head_t go;                     /* start decompression */
 	wait_queue_head_t done;                   /* decompression done */
+	bool lz4;                                 /* LZ4 instead of LZO */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
@@ -1135,9 +1167,19 @@ static int lzo_decompress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->unc_len = LZO_UNC_SIZE;
-		d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER, d->cmp_len,
-		                               d->unc, &d->unc_len);
+		if (d->lz4) {
+			int len = LZ4_decompress_safe(d->cmp + LZO_HEADER,
+						      d->unc, d->cmp_len,
+						      LZO_UNC_SIZE);
+
+			d->unc_len = len > 0 ? len : 0;
+			d->ret = len > 0 ? 0 : -1;
+		} else {
+			d->unc_len = LZO_UNC_SIZE;
+			d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER,
+						       d->cmp_len, d->unc,
+						       &d->unc_len);
+		}
 		if (clean_pages_on_decompress)
 			flush_icache_range((unsigned long)d->unc,
 					   (unsigned long)d->unc + d->unc_len);
@@ -1149,14 +1191,16 @@ static int lzo_decompress_threadfn(void *data)
 }
 
 /**
- * load_image_lzo - Load compressed image data and decompress them with LZO.
+ * load_image_lzo - Load compressed image data and decompress them with LZO
+ * or LZ4.
  * @handle: Swap map handle to use for loading data.
  * @snapshot: Image to copy uncompressed data into.
  * @nr_to_read: Number of pages to load.
+ * @lz4: The image was compressed with LZ4 rather than LZO.
  */
 static int load_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_read)
+                          unsigned int nr_to_read, bool lz4)
 {
 	unsigned int m;
 	int ret = 0;
@@ -1173,6 +1217,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	unsigned char **page = NULL;
 	struct dec_data *data = NULL;
 	struct crc_data *crc = NULL;
+	struct blk_plug plug;
 
 	hib_init_batch(&hb);
 
@@ -1196,8 +1241,10 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct dec_data, go));
+		data[thr].lz4 = lz4;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -1292,6 +1339,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		goto out_finish;
 
 	for(;;) {
+		/* Let the read-ahead go out as a few large requests */
+		blk_start_plug(&plug);
 		for (i = 0; !eof && i < want; i++) {
 			ret = swap_read_page(handle, page[ring], &hb);
 			if (ret) {
@@ -1301,6 +1350,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 				 */
 				if (handle->cur &&
 				    handle->cur->entries[handle->k]) {
+					blk_finish_plug(&plug);
 					goto out_finish;
 				} else {
 					eof = 1;
@@ -1310,6 +1360,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			if (++ring >= ring_size)
 				ring = 0;
 		}
+		blk_finish_plug(&plug);
 		asked += i;
 		want -= i;
 
@@ -1494,7 +1545,8 @@ int swsusp_read(unsigned int *flags_p)
 	if (!error) {
 		error = (*flags_p & SF_NOCOMPRESS_MODE) ?
 			load_image(&handle, &snapshot, header->pages - 1) :
-			load_image_lzo(&handle, &snapshot, header->pages - 1);
+			load_image_lzo(&handle, &snapshot, header->pages - 1,
+				       *flags_p & SF_LZ4_MODE);
 	}
 	swap_reader_finish(&handle);
 end:
@@ -41,6 +41,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
 #include <linux/sched/clock.h>
@@ -1896,6 +1897,63 @@ int vprintk_store(int facility, int level,
 			  dict, dictlen, text, text_len);
 }
 
+/*
+ * With printk.console_kthread=1 the consoles are written from a dedicated
+ * kthread rather than from whoever called printk(), so that a slow serial
+ * console does not stall the caller. Output is still flushed directly
+ * while the kthread is not running yet, during an oops or panic, and once
+ * the system is going down.
+ */
+static bool printk_console_kthread;
+module_param_named(console_kthread, printk_console_kthread, bool, S_IRUGO);
+MODULE_PARM_DESC(console_kthread, "flush consoles from a kthread");
+
+static struct task_struct *printk_kthread;
+static bool printk_kthread_pending;
+
+static bool printk_offload_console(void)
+{
+	return printk_kthread && !oops_in_progress &&
+		system_state == SYSTEM_RUNNING &&
+		atomic_read(&panic_cpu) == PANIC_CPU_INVALID;
+}
+
+static int printk_kthread_func(void *data)
+{
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!READ_ONCE(printk_kthread_pending))
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		WRITE_ONCE(printk_kthread_pending, false);
+		console_lock();
+		console_unlock();
+	}
+
+	return 0;
+}
+
+static void printk_kthread_wake(void)
+{
+	WRITE_ONCE(printk_kthread_pending, true);
+	wake_up_process(printk_kthread);
+}
+
+static void __init printk_kthread_start(void)
+{
+	struct task_struct *kt;
+
+	if (!printk_console_kthread)
+		return;
+
+	kt = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(kt))
+		pr_err("printk: unable to start console kthread\n");
+	else
+		printk_kthread = kt;
+}
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const char *dict, size_t dictlen,
 			    const char *fmt, va_list args)
@@ -1920,6 +1978,15 @@ asmlinkage int vprintk_emit(int facility, int level,
 	pending_output = (curr_log_seq != log_next_seq);
 	logbuf_unlock_irqrestore(flags);
 
+	/*
+	 * Leave the consoles to the kthread. The wakeup goes through the
+	 * irq_work, as printk() may be called with scheduler locks held.
+	 */
+	if (!in_sched && pending_output && printk_offload_console()) {
+		defer_console_output();
+		in_sched = true;
+	}
+
 	/* If called from the scheduler, we can not call up(). */
 	if (!in_sched && pending_output) {
 		/*
@@ -2046,6 +2113,7 @@ static void call_console_drivers(const char *ext_text, size_t ext_len,
 static size_t msg_print_text(const struct printk_log *msg,
 			     bool syslog, char *buf, size_t size) { return 0; }
 static bool suppress_message_printing(int level) { return false; }
+static void __init printk_kthread_start(void) { }
 
 #endif /* CONFIG_PRINTK */
 
@@ -2879,6 +2947,8 @@ static int __init printk_late_init(void)
 	ret = cpuhp_setup_state_nocalls(CPUHP_AP_ONLINE_DYN, "printk:online",
 					console_cpu_notify, NULL);
 	WARN_ON(ret < 0);
+
+	printk_kthread_start();
 	return 0;
 }
 late_initcall(printk_late_init);
@@ -2897,8 +2967,10 @@ static void wake_up_klogd_work_func(struct irq_work *irq_work)
 	int pending = __this_cpu_xchg(printk_pending, 0);
 
 	if (pending & PRINTK_PENDING_OUTPUT) {
+		if (printk_offload_console())
+			printk_kthread_wake();
 		/* If trylock fails, someone else is doing the printing */
-		if (console_trylock())
+		else if (console_trylock())
 			console_unlock();
 	}
 
@@ -717,6 +717,132 @@ static void set_load_weight(struct task_struct *p, bool update_load)
 	}
 }
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+/*
+ * Utilization clamping: each runnable task is refcounted in a bucket of
+ * its rq by the clamp values of its task group, and the rq's clamp is the
+ * largest value of any non-empty bucket. Tasks pick up a change of their
+ * group's values the next time they are enqueued.
+ */
+static DEFINE_MUTEX(uclamp_mutex);
+
+static inline unsigned int uclamp_bucket_id(unsigned int clamp_value)
+{
+	return min_t(unsigned int, clamp_value / UCLAMP_BUCKET_DELTA,
+		     UCLAMP_BUCKETS - 1);
+}
+
+static inline unsigned int uclamp_none(enum uclamp_id clamp_id)
+{
+	return clamp_id == UCLAMP_MIN ? 0 : SCHED_CAPACITY_SCALE;
+}
+
+static inline void uclamp_se_set(struct uclamp_se *uc_se, unsigned int value)
+{
+	uc_se->value = value;
+	uc_se->bucket_id = uclamp_bucket_id(value);
+}
+
+static void uclamp_rq_update(struct rq *rq, enum uclamp_id clamp_id)
+{
+	struct uclamp_rq *uc_rq = &rq->uclamp[clamp_id];
+	int i;
+
+	for (i = UCLAMP_BUCKETS - 1; i >= 0; i--) {
+		if (uc_rq->bucket[i].tasks) {
+			WRITE_ONCE(uc_rq->value, uc_rq->bucket[i].value);
+			return;
+		}
+	}
+
+	/*
+	 * Idle: drop the boost, but keep the cap of the last task so its
+	 * blocked utilization does not raise the frequency meanwhile.
+	 */
+	if (clamp_id == UCLAMP_MIN)
+		WRITE_ONCE(uc_rq->value, 0);
+}
+
+static void uclamp_rq_inc(struct rq *rq, struct task_struct *p)
+{
+	struct uclamp_se *tg_uclamp = task_group(p)->uclamp;
+	enum uclamp_id clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		struct uclamp_se *uc_se = &p->uclamp[clamp_id];
+		struct uclamp_bucket *bucket;
+
+		uclamp_se_set(uc_se, tg_uclamp[clamp_id].value);
+		uc_se->active = 1;
+
+		bucket = &rq->uclamp[clamp_id].bucket[uc_se->bucket_id];
+		bucket->tasks++;
+		if (bucket->tasks == 1 || uc_se->value > bucket->value)
+			bucket->value = uc_se->value;
+
+		uclamp_rq_update(rq, clamp_id);
+	}
+}
+
+static void uclamp_rq_dec(struct rq *rq, struct task_struct *p)
+{
+	enum uclamp_id clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		struct uclamp_se *uc_se = &p->uclamp[clamp_id];
+		struct uclamp_bucket *bucket;
+
+		if (!uc_se->active)
+			continue;
+
+		bucket = &rq->uclamp[clamp_id].bucket[uc_se->bucket_id];
+		if (!WARN_ON_ONCE(!bucket->tasks))
+			bucket->tasks--;
+		uc_se->active = 0;
+
+		uclamp_rq_update(rq, clamp_id);
+	}
+}
+
+static void __init init_uclamp(void)
+{
+	enum uclamp_id clamp_id;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct rq *rq = cpu_rq(cpu);
+
+		memset(rq->uclamp, 0, sizeof(rq->uclamp));
+		rq->uclamp[UCLAMP_MAX].value = SCHED_CAPACITY_SCALE;
+	}
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		uclamp_se_set(&root_task_group.uclamp_req[clamp_id],
+			      uclamp_none(clamp_id));
+		root_task_group.uclamp[clamp_id] =
+			root_task_group.uclamp_req[clamp_id];
+	}
+}
+
+static void alloc_uclamp_sched_group(struct task_group *tg,
+				     struct task_group *parent)
+{
+	enum uclamp_id clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		uclamp_se_set(&tg->uclamp_req[clamp_id],
+			      uclamp_none(clamp_id));
+		tg->uclamp[clamp_id] = parent->uclamp[clamp_id];
+	}
+}
+#else
+static inline void uclamp_rq_inc(struct rq *rq, struct task_struct *p) { }
+static inline void uclamp_rq_dec(struct rq *rq, struct task_struct *p) { }
+static inline void init_uclamp(void) { }
+static inline void alloc_uclamp_sched_group(struct task_group *tg,
+					    struct task_group *parent) { }
+#endif /* CONFIG_UCLAMP_TASK_GROUP */
+
 static inline void enqueue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	if (!(flags & ENQUEUE_NOCLOCK))
@@ -725,6 +851,7 @@ static inline void enqueue_task(struct rq *rq, struct task_struct *p, int flags)
 	if (!(flags & ENQUEUE_RESTORE))
 		sched_info_queued(rq, p);
 
+	uclamp_rq_inc(rq, p);
 	p->sched_class->enqueue_task(rq, p, flags);
 }
 
@@ -736,6 +863,7 @@ static inline void dequeue_task(struct rq *rq, struct task_struct *p, int flags)
 	if (!(flags & DEQUEUE_SAVE))
 		sched_info_dequeued(rq, p);
 
+	uclamp_rq_dec(rq, p);
 	p->sched_class->dequeue_task(rq, p, flags);
 }
 
@@ -2147,6 +2275,10 @@ static void __sched_fork(unsigned long clone_flags, struct task_struct *p)
 	p->se.nr_migrations		= 0;
 	p->se.vruntime			= 0;
 	INIT_LIST_HEAD(&p->se.group_node);
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	p->uclamp[UCLAMP_MIN].active	= 0;
+	p->uclamp[UCLAMP_MAX].active	= 0;
+#endif
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	p->se.cfs_rq			= NULL;
@@ -2320,6 +2452,7 @@ int sched_fork(unsigned long clone_flags, struct task_struct *p)
 
 		p->prio = p->normal_prio = __normal_prio(p);
 		set_load_weight(p, false);
+		p->se.latency_nice = 0;
 
 		/*
 		 * We don't need the reset flag anymore after the fork. It has
@@ -3058,6 +3191,7 @@ void scheduler_tick(void)
 
 #ifdef CONFIG_SMP
 	rq->idle_balance = idle_cpu(cpu);
+	update_idle_cpumask(rq, rq->idle_balance);
 	trigger_load_balance(rq);
 #endif
 }
@@ -3353,10 +3487,14 @@ pick_next_task(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 	 * call that function directly, but only if the @prev task wasn't of a
 	 * higher scheduling class, because otherwise those loose the
 	 * opportunity to pull in more work from other CPUs.
+	 *
+	 * A group's deadline server is queued on the dl_rq without counting
+	 * in nr_running, so the dl_rq must be empty too.
 	 */
 	if (likely((prev->sched_class == &idle_sched_class ||
 		    prev->sched_class == &fair_sched_class) &&
-		   rq->nr_running == rq->cfs.h_nr_running)) {
+		   rq->nr_running == rq->cfs.h_nr_running &&
+		   !rq->dl.dl_nr_running)) {
 
 		p = fair_sched_class.pick_next_task(rq, prev, rf);
 		if (unlikely(p == RETRY_TASK))
@@ -4197,6 +4335,11 @@ static int __sched_setscheduler(struct task_struct *p,
 	    (rt_policy(policy) != (attr->sched_priority != 0)))
 		return -EINVAL;
 
+	if ((attr->sched_flags & SCHED_FLAG_LATENCY_NICE) &&
+	    (attr->sched_latency_nice < MIN_LATENCY_NICE ||
+	     attr->sched_latency_nice > MAX_LATENCY_NICE))
+		return -EINVAL;
+
 	/*
 	 * Allow unprivileged RT tasks to decrease priority:
 	 */
@@ -4207,6 +4350,11 @@ static int __sched_setscheduler(struct task_struct *p,
 				return -EPERM;
 		}
 
+		/* Can't ask for lower wakeup latency: */
+		if ((attr->sched_flags & SCHED_FLAG_LATENCY_NICE) &&
+		    attr->sched_latency_nice < p->se.latency_nice)
+			return -EPERM;
+
 		if (rt_policy(policy)) {
 			unsigned long rlim_rtprio =
 					task_rlimit(p, RLIMIT_RTPRIO);
@@ -4288,6 +4436,8 @@ static int __sched_setscheduler(struct task_struct *p,
 			goto change;
 
 		p->sched_reset_on_fork = reset_on_fork;
+		if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE)
+			p->se.latency_nice = attr->sched_latency_nice;
 		task_rq_unlock(rq, p, &rf);
 		return 0;
 	}
@@ -4367,6 +4517,9 @@ static int __sched_setscheduler(struct task_struct *p,
 
 	prev_class = p->sched_class;
 	__setscheduler(rq, p, attr, pi);
+	/* Only ever compared, so no need to be dequeued for it */
+	if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE)
+		p->se.latency_nice = attr->sched_latency_nice;
 
 	if (queued) {
 		/*
@@ -4763,6 +4916,10 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 	else
 		attr.sched_nice = task_nice(p);
 
+	/* Callers with an older struct sched_attr do not know about it */
+	if (size >= SCHED_ATTR_SIZE_VER1)
+		attr.sched_latency_nice = p->se.latency_nice;
+
 	rcu_read_unlock();
 
 	retval = sched_read_attr(uattr, &attr, size);
@@ -6092,6 +6249,8 @@ void __init sched_init(void)
 		atomic_set(&rq->nr_iowait, 0);
 	}
 
+	init_uclamp();
+
 	set_load_weight(&init_task, false);
 
 	/*
@@ -6309,6 +6468,8 @@ struct task_group *sched_create_group(struct task_group *parent)
 	if (!alloc_rt_sched_group(tg, parent))
 		goto err;
 
+	alloc_uclamp_sched_group(tg, parent);
+
 	return tg;
 
 err:
@@ -6440,6 +6601,10 @@ cpu_cgroup_css_alloc(struct cgroup_subsys_state *parent_css)
 	return &tg->css;
 }
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+static void cpu_util_update_eff(struct cgroup_subsys_state *css);
+#endif
+
 /* Expose task group only after completing cgroup initialization */
 static int cpu_cgroup_css_online(struct cgroup_subsys_state *css)
 {
@@ -6448,6 +6613,18 @@ static int cpu_cgroup_css_online(struct cgroup_subsys_state *css)
 
 	if (parent)
 		sched_online_group(tg, parent);
+
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	/*
+	 * The clamps copied from the parent at allocation may have changed
+	 * since, and the group wasn't visible to the update walk until now.
+	 */
+	mutex_lock(&uclamp_mutex);
+	rcu_read_lock();
+	cpu_util_update_eff(css);
+	rcu_read_unlock();
+	mutex_unlock(&uclamp_mutex);
+#endif
 	return 0;
 }
 
@@ -6455,6 +6632,11 @@ static void cpu_cgroup_css_released(struct cgroup_subsys_state *css)
 {
 	struct task_group *tg = css_tg(css);
 
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	/* Hand the group's reservation back to the root domains */
+	if (tg->dl_server_runtime)
+		sched_group_set_dl_server(tg, 0, sched_group_dl_period(tg));
+#endif
 	sched_offline_group(tg);
 }
 
@@ -6542,6 +6724,59 @@ static u64 cpu_shares_read_u64(struct cgroup_subsys_state *css,
 	return (u64) scale_load_down(tg->shares);
 }
 
+static s64 cpu_latency_nice_read_s64(struct cgroup_subsys_state *css,
+				     struct cftype *cft)
+{
+	return css_tg(css)->latency_nice;
+}
+
+static int cpu_latency_nice_write_s64(struct cgroup_subsys_state *css,
+				      struct cftype *cft, s64 val)
+{
+	return sched_group_set_latency_nice(css_tg(css), val);
+}
+
+#ifdef CONFIG_SMP
+static int cpu_llc_affinity_write_u64(struct cgroup_subsys_state *css,
+				      struct cftype *cftype, u64 val)
+{
+	struct task_group *tg = css_tg(css);
+
+	if (val > 1)
+		return -EINVAL;
+
+	WRITE_ONCE(tg->preferred_llc_votes, 0);
+	WRITE_ONCE(tg->llc_affinity, val);
+	return 0;
+}
+
+static u64 cpu_llc_affinity_read_u64(struct cgroup_subsys_state *css,
+				     struct cftype *cft)
+{
+	return READ_ONCE(css_tg(css)->llc_affinity);
+}
+
+#ifdef CONFIG_SCHEDSTATS
+static int cpu_llc_locality_show(struct seq_file *sf, void *v)
+{
+	struct task_group *tg = css_tg(seq_css(sf));
+	u64 local = 0, remote = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		local += tg->cfs_rq[cpu]->llc_local_ticks;
+		remote += tg->cfs_rq[cpu]->llc_remote_ticks;
+	}
+
+	seq_printf(sf, "preferred_llc %d\n", READ_ONCE(tg->preferred_llc));
+	seq_printf(sf, "local_ticks %llu\n", local);
+	seq_printf(sf, "remote_ticks %llu\n", remote);
+
+	return 0;
+}
+#endif
+#endif /* CONFIG_SMP */
+
 #ifdef CONFIG_CFS_BANDWIDTH
 static DEFINE_MUTEX(cfs_constraints_mutex);
 
@@ -6834,6 +7069,107 @@ static u64 cpu_rt_period_read_uint(struct cgroup_subsys_state *css,
 }
 #endif /* CONFIG_RT_GROUP_SCHED */
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+/*
+ * A group's effective clamps are its requested ones restricted by its
+ * parent's effective clamps, with the minimum never above the maximum.
+ */
+static void cpu_util_update_eff(struct cgroup_subsys_state *css)
+{
+	struct cgroup_subsys_state *top_css = css;
+	unsigned int eff[UCLAMP_CNT];
+	enum uclamp_id clamp_id;
+	struct task_group *tg;
+
+	css_for_each_descendant_pre(css, top_css) {
+		tg = css_tg(css);
+
+		for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+			eff[clamp_id] = tg->uclamp_req[clamp_id].value;
+			if (tg->parent)
+				eff[clamp_id] = min(eff[clamp_id],
+					tg->parent->uclamp[clamp_id].value);
+		}
+		eff[UCLAMP_MIN] = min(eff[UCLAMP_MIN], eff[UCLAMP_MAX]);
+
+		for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++)
+			uclamp_se_set(&tg->uclamp[clamp_id], eff[clamp_id]);
+	}
+}
+
+static int cpu_util_write(struct cgroup_subsys_state *css,
+			  enum uclamp_id clamp_id, u64 val)
+{
+	if (val > SCHED_CAPACITY_SCALE)
+		return -ERANGE;
+
+	mutex_lock(&uclamp_mutex);
+	rcu_read_lock();
+	uclamp_se_set(&css_tg(css)->uclamp_req[clamp_id], val);
+	cpu_util_update_eff(css);
+	rcu_read_unlock();
+	mutex_unlock(&uclamp_mutex);
+
+	return 0;
+}
+
+static int cpu_util_min_write_u64(struct cgroup_subsys_state *css,
+				  struct cftype *cft, u64 val)
+{
+	return cpu_util_write(css, UCLAMP_MIN, val);
+}
+
+static u64 cpu_util_min_read_u64(struct cgroup_subsys_state *css,
+				 struct cftype *cft)
+{
+	return css_tg(css)->uclamp_req[UCLAMP_MIN].value;
+}
+
+static int cpu_util_max_write_u64(struct cgroup_subsys_state *css,
+				  struct cftype *cft, u64 val)
+{
+	return cpu_util_write(css, UCLAMP_MAX, val);
+}
+
+static u64 cpu_util_max_read_u64(struct cgroup_subsys_state *css,
+				 struct cftype *cft)
+{
+	return css_tg(css)->uclamp_req[UCLAMP_MAX].value;
+}
+#endif /* CONFIG_UCLAMP_TASK_GROUP */
+
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+static int cpu_dl_runtime_write_u64(struct cgroup_subsys_state *css,
+				    struct cftype *cft, u64 runtime_us)
+{
+	struct task_group *tg = css_tg(css);
+
+	return sched_group_set_dl_server(tg, runtime_us,
+					 sched_group_dl_period(tg));
+}
+
+static u64 cpu_dl_runtime_read_u64(struct cgroup_subsys_state *css,
+				   struct cftype *cft)
+{
+	return sched_group_dl_runtime(css_tg(css));
+}
+
+static int cpu_dl_period_write_u64(struct cgroup_subsys_state *css,
+				   struct cftype *cft, u64 period_us)
+{
+	struct task_group *tg = css_tg(css);
+
+	return sched_group_set_dl_server(tg, sched_group_dl_runtime(tg),
+					 period_us);
+}
+
+static u64 cpu_dl_period_read_u64(struct cgroup_subsys_state *css,
+				  struct cftype *cft)
+{
+	return sched_group_dl_period(css_tg(css));
+}
+#endif /* CONFIG_FAIR_GROUP_DL_SERVER */
+
 static struct cftype cpu_legacy_files[] = {
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
@@ -6841,6 +7177,27 @@ static struct cftype cpu_legacy_files[] = {
 		.read_u64 = cpu_shares_read_u64,
 		.write_u64 = cpu_shares_write_u64,
 	},
+	{
+		.name = "latency_nice",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_s64 = cpu_latency_nice_read_s64,
+		.write_s64 = cpu_latency_nice_write_s64,
+	},
+#ifdef CONFIG_SMP
+	{
+		.name = "llc_affinity",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_llc_affinity_read_u64,
+		.write_u64 = cpu_llc_affinity_write_u64,
+	},
+#ifdef CONFIG_SCHEDSTATS
+	{
+		.name = "llc_locality",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_llc_locality_show,
+	},
+#endif
+#endif
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -6869,6 +7226,34 @@ static struct cftype cpu_legacy_files[] = {
 		.read_u64 = cpu_rt_period_read_uint,
 		.write_u64 = cpu_rt_period_write_uint,
 	},
+#endif
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	{
+		.name = "util.min",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_util_min_read_u64,
+		.write_u64 = cpu_util_min_write_u64,
+	},
+	{
+		.name = "util.max",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_util_max_read_u64,
+		.write_u64 = cpu_util_max_write_u64,
+	},
+#endif
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	{
+		.name = "dl_runtime_us",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_dl_runtime_read_u64,
+		.write_u64 = cpu_dl_runtime_write_u64,
+	},
+	{
+		.name = "dl_period_us",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_dl_period_read_u64,
+		.write_u64 = cpu_dl_period_write_u64,
+	},
 #endif
 	{ }	/* Terminate */
 };
@@ -7028,6 +7413,27 @@ static struct cftype cpu_files[] = {
 		.read_s64 = cpu_weight_nice_read_s64,
 		.write_s64 = cpu_weight_nice_write_s64,
 	},
+	{
+		.name = "latency.nice",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_s64 = cpu_latency_nice_read_s64,
+		.write_s64 = cpu_latency_nice_write_s64,
+	},
+#ifdef CONFIG_SMP
+	{
+		.name = "llc_affinity",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_llc_affinity_read_u64,
+		.write_u64 = cpu_llc_affinity_write_u64,
+	},
+#ifdef CONFIG_SCHEDSTATS
+	{
+		.name = "llc_locality",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_llc_locality_show,
+	},
+#endif
+#endif
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -7036,6 +7442,34 @@ static struct cftype cpu_files[] = {
 		.seq_show = cpu_max_show,
 		.write = cpu_max_write,
 	},
+#endif
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	{
+		.name = "util.min",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_util_min_read_u64,
+		.write_u64 = cpu_util_min_write_u64,
+	},
+	{
+		.name = "util.max",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_util_max_read_u64,
+		.write_u64 = cpu_util_max_write_u64,
+	},
+#endif
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	{
+		.name = "dl_runtime_us",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_dl_runtime_read_u64,
+		.write_u64 = cpu_dl_runtime_write_u64,
+	},
+	{
+		.name = "dl_period_us",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_dl_period_read_u64,
+		.write_u64 = cpu_dl_period_write_u64,
+	},
 #endif
 	{ }	/* terminate */
 };
@@ -233,6 +233,9 @@ static unsigned long sugov_get_util(struct sugov_cpu *sg_cpu)
 	util = cpu_util_cfs(rq);
 	util += cpu_util_rt(rq);
 
+	/* Boost or cap as requested by the groups of the runnable tasks */
+	util = uclamp_rq_util(rq, util);
+
 	/*
 	 * We do not make cpu_util_dl() a permanent part of this sum because we
 	 * want to use cpu_bw_dl() later on, but we need to check if the
@@ -389,6 +392,8 @@ static unsigned long sugov_iowait_apply(struct sugov_cpu *sg_cpu, u64 time,
 	 * into the same scale so we can compare.
 	 */
 	boost = (sg_cpu->iowait_boost * max) >> SCHED_CAPACITY_SHIFT;
+	/* A capped group does not get boosted past its cap by IO either */
+	boost = uclamp_rq_util(cpu_rq(sg_cpu->cpu), boost);
 	return max(boost, util);
 }
 
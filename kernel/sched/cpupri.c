@@ -122,6 +122,32 @@ int cpupri_find(struct cpupri *cp, struct task_struct *p,
 	return 0;
 }
 
+/**
+ * cpupri_has_lower - check for any CPU running below a priority
+ * @cp: The cpupri context
+ * @prio: The task->prio to compare against
+ *
+ * Like cpupri_find() but without looking at any task's affinity, so it can
+ * be used on a remote runqueue without holding its lock.  The answer is as
+ * racy as cpupri_find()'s and must only be used as a hint.
+ *
+ * Return: (int)bool - a CPU running at a lower priority than @prio exists
+ */
+int cpupri_has_lower(struct cpupri *cp, int prio)
+{
+	int task_pri = convert_prio(prio);
+	int idx;
+
+	BUG_ON(task_pri >= CPUPRI_NR_PRIORITIES);
+
+	for (idx = 0; idx < task_pri; idx++) {
+		if (atomic_read(&cp->pri_to_cpu[idx].count))
+			return 1;
+	}
+
+	return 0;
+}
+
 /**
  * cpupri_set - update the CPU priority setting
  * @cp: The cpupri context
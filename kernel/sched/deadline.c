@@ -30,10 +30,23 @@ static inline struct rq *rq_of_dl_rq(struct dl_rq *dl_rq)
 	return container_of(dl_rq, struct rq, dl);
 }
 
+static inline bool dl_server(struct sched_dl_entity *dl_se)
+{
+	return dl_se->dl_server;
+}
+
 static inline struct dl_rq *dl_rq_of_se(struct sched_dl_entity *dl_se)
 {
-	struct task_struct *p = dl_task_of(dl_se);
-	struct rq *rq = task_rq(p);
+	struct task_struct *p;
+	struct rq *rq;
+
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	if (dl_server(dl_se))
+		return &container_of(dl_se, struct cfs_rq, dl_server)->rq->dl;
+#endif
+
+	p = dl_task_of(dl_se);
+	rq = task_rq(p);
 
 	return &rq->dl;
 }
@@ -917,11 +930,11 @@ static inline u64 dl_next_period(struct sched_dl_entity *dl_se)
  * actually started or not (i.e., the replenishment instant is in
  * the future or in the past).
  */
-static int start_dl_timer(struct task_struct *p)
+static int __start_dl_timer(struct sched_dl_entity *dl_se,
+			    struct task_struct *p)
 {
-	struct sched_dl_entity *dl_se = &p->dl;
 	struct hrtimer *timer = &dl_se->dl_timer;
-	struct rq *rq = task_rq(p);
+	struct rq *rq = rq_of_dl_rq(dl_rq_of_se(dl_se));
 	ktime_t now, act;
 	s64 delta;
 
@@ -953,15 +966,24 @@ static int start_dl_timer(struct task_struct *p)
 	 * harmless because we're holding task_rq()->lock, therefore the timer
 	 * expiring after we've done the check will wait on its task_rq_lock()
 	 * and observe our state.
+	 *
+	 * A server (!p) lives as long as its task group, which cancels the
+	 * timer before it is freed.
 	 */
 	if (!hrtimer_is_queued(timer)) {
-		get_task_struct(p);
+		if (p)
+			get_task_struct(p);
 		hrtimer_start(timer, act, HRTIMER_MODE_ABS);
 	}
 
 	return 1;
 }
 
+static int start_dl_timer(struct task_struct *p)
+{
+	return __start_dl_timer(&p->dl, p);
+}
+
 /*
  * This is the bandwidth enforcement timer callback. If here, we know
  * a task is not on its dl_rq, since the fact that the timer was running
@@ -1371,32 +1393,37 @@ static inline void dec_dl_deadline(struct dl_rq *dl_rq, u64 deadline) {}
 
 #endif /* CONFIG_SMP */
 
+/*
+ * A server counts in dl_nr_running, so that it gets picked, but not in
+ * rq->nr_running: the tasks it runs are already accounted by their class.
+ */
 static inline
 void inc_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	int prio = dl_task_of(dl_se)->prio;
 	u64 deadline = dl_se->deadline;
 
-	WARN_ON(!dl_prio(prio));
+	WARN_ON(!dl_server(dl_se) && !dl_prio(dl_task_of(dl_se)->prio));
 	dl_rq->dl_nr_running++;
-	add_nr_running(rq_of_dl_rq(dl_rq), 1);
+	if (!dl_server(dl_se))
+		add_nr_running(rq_of_dl_rq(dl_rq), 1);
 
 	inc_dl_deadline(dl_rq, deadline);
-	inc_dl_migration(dl_se, dl_rq);
+	if (!dl_server(dl_se))
+		inc_dl_migration(dl_se, dl_rq);
 }
 
 static inline
 void dec_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	int prio = dl_task_of(dl_se)->prio;
-
-	WARN_ON(!dl_prio(prio));
+	WARN_ON(!dl_server(dl_se) && !dl_prio(dl_task_of(dl_se)->prio));
 	WARN_ON(!dl_rq->dl_nr_running);
 	dl_rq->dl_nr_running--;
-	sub_nr_running(rq_of_dl_rq(dl_rq), 1);
+	if (!dl_server(dl_se))
+		sub_nr_running(rq_of_dl_rq(dl_rq), 1);
 
 	dec_dl_deadline(dl_rq, dl_se->deadline);
-	dec_dl_migration(dl_se, dl_rq);
+	if (!dl_server(dl_se))
+		dec_dl_migration(dl_se, dl_rq);
 }
 
 static void __enqueue_dl_entity(struct sched_dl_entity *dl_se)
@@ -1738,6 +1765,151 @@ static struct sched_dl_entity *pick_next_dl_entity(struct rq *rq,
 	return rb_entry(left, struct sched_dl_entity, rb_node);
 }
 
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+/*
+ * Deadline servers for CPU cgroups.
+ *
+ * A group with a dl_server_runtime has a deadline entity on each CPU,
+ * embedded in its cfs_rq. While the group has runnable tasks there, the
+ * entity is queued on the dl_rq as a task's would be, and when EDF picks
+ * it, it runs the group's next CFS task in its place. The time that task
+ * runs is charged back to the server from the fair class's update_curr().
+ * A server that runs out of runtime is throttled until its next period,
+ * leaving the group's tasks to compete under the normal CFS rules.
+ *
+ * Servers are kept out of the GRUB active/inactive utilization: what they
+ * run is CFS work, which schedutil already sees through the CFS signals.
+ */
+static void dl_server_throttle(struct rq *rq, struct sched_dl_entity *dl_se)
+{
+	dl_se->dl_throttled = 1;
+	__dequeue_dl_entity(dl_se);
+	if (unlikely(!__start_dl_timer(dl_se, NULL))) {
+		replenish_dl_entity(dl_se, dl_se);
+		__enqueue_dl_entity(dl_se);
+	}
+
+	resched_curr(rq);
+}
+
+void dl_server_start(struct sched_dl_entity *dl_se)
+{
+	struct rq *rq = rq_of_dl_rq(dl_rq_of_se(dl_se));
+
+	/* A throttled server is requeued by its timer */
+	if (on_dl_rq(dl_se) || dl_se->dl_throttled)
+		return;
+
+	update_dl_entity(dl_se, dl_se);
+	__enqueue_dl_entity(dl_se);
+
+	if (!dl_task(rq->curr) || dl_entity_preempt(dl_se, &rq->curr->dl))
+		resched_curr(rq);
+}
+
+void dl_server_stop(struct sched_dl_entity *dl_se)
+{
+	__dequeue_dl_entity(dl_se);
+}
+
+/*
+ * Charge the server that picked the running CFS task. Like a task's
+ * runtime, it is scaled to the CPU's current frequency and capacity.
+ */
+void dl_server_update(struct sched_dl_entity *dl_se, u64 delta_exec)
+{
+	struct rq *rq = rq_of_dl_rq(dl_rq_of_se(dl_se));
+	unsigned long scale_freq = arch_scale_freq_capacity(cpu_of(rq));
+	unsigned long scale_cpu = arch_scale_cpu_capacity(NULL, cpu_of(rq));
+	u64 scaled_delta_exec;
+
+	if (!on_dl_rq(dl_se))
+		return;
+
+	scaled_delta_exec = cap_scale(delta_exec, scale_freq);
+	scaled_delta_exec = cap_scale(scaled_delta_exec, scale_cpu);
+	dl_se->runtime -= scaled_delta_exec;
+
+	if (dl_runtime_exceeded(dl_se))
+		dl_server_throttle(rq, dl_se);
+}
+
+/*
+ * Once put_prev_task() has run there is no going back, so before that
+ * charge prev, and yield every server at the front of the dl_rq whose
+ * group has nothing it may run, e.g. because it is CFS-bandwidth
+ * throttled: their runtime is forfeited until the next period.
+ */
+static void dl_server_prepare_pick(struct rq *rq, struct task_struct *prev)
+{
+	struct sched_dl_entity *dl_se;
+
+	if (!rq->dl.dl_nr_running)
+		return;
+
+	if (prev->sched_class == &fair_sched_class)
+		dl_server_update_prev(prev);
+
+	while ((dl_se = pick_next_dl_entity(rq, &rq->dl)) &&
+	       dl_server(dl_se) && !dl_server_has_tasks(dl_se)) {
+		dl_se->dl_yielded = 1;
+		dl_server_throttle(rq, dl_se);
+	}
+}
+
+static inline void set_rq_dl_server(struct rq *rq,
+				    struct sched_dl_entity *dl_se)
+{
+	rq->dl_server = dl_se;
+}
+
+static enum hrtimer_restart dl_server_timer(struct hrtimer *timer)
+{
+	struct sched_dl_entity *dl_se = container_of(timer,
+						     struct sched_dl_entity,
+						     dl_timer);
+	struct rq *rq = rq_of_dl_rq(dl_rq_of_se(dl_se));
+	struct rq_flags rf;
+
+	rq_lock(rq, &rf);
+
+	/* Spurious, or the server was reconfigured or turned off */
+	if (!dl_se->dl_throttled || !dl_se->dl_runtime)
+		goto unlock;
+
+	sched_clock_tick();
+	update_rq_clock(rq);
+
+	replenish_dl_entity(dl_se, dl_se);
+
+	/* An idle group is requeued, under the CBS rules, by its next task */
+	if (!dl_server_has_tasks(dl_se))
+		goto unlock;
+
+	__enqueue_dl_entity(dl_se);
+	if (!dl_task(rq->curr) || dl_entity_preempt(dl_se, &rq->curr->dl))
+		resched_curr(rq);
+
+unlock:
+	rq_unlock(rq, &rf);
+
+	return HRTIMER_NORESTART;
+}
+
+void init_dl_server(struct sched_dl_entity *dl_se)
+{
+	RB_CLEAR_NODE(&dl_se->rb_node);
+	dl_se->dl_server = 1;
+	hrtimer_init(&dl_se->dl_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dl_se->dl_timer.function = dl_server_timer;
+}
+#else
+static inline void dl_server_prepare_pick(struct rq *rq,
+					  struct task_struct *prev) { }
+static inline void set_rq_dl_server(struct rq *rq,
+				    struct sched_dl_entity *dl_se) { }
+#endif /* CONFIG_FAIR_GROUP_DL_SERVER */
+
 static struct task_struct *
 pick_next_task_dl(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 {
@@ -1773,6 +1945,8 @@ pick_next_task_dl(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 	if (prev->sched_class == &dl_sched_class)
 		update_curr_dl(rq);
 
+	dl_server_prepare_pick(rq, prev);
+
 	if (unlikely(!dl_rq->dl_nr_running))
 		return NULL;
 
@@ -1781,6 +1955,15 @@ pick_next_task_dl(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 	dl_se = pick_next_dl_entity(rq, dl_rq);
 	BUG_ON(!dl_se);
 
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	if (dl_server(dl_se)) {
+		p = dl_server_pick(dl_se);
+		set_rq_dl_server(rq, dl_se);
+		return p;
+	}
+#endif
+	set_rq_dl_server(rq, NULL);
+
 	p = dl_task_of(dl_se);
 	p->se.exec_start = rq_clock_task(rq);
 
@@ -2599,6 +2782,141 @@ int sched_dl_overflow(struct task_struct *p, int policy,
 	return err;
 }
 
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+static DEFINE_MUTEX(dl_server_mutex);
+
+/*
+ * A group's reservation is @bw on every online CPU, so the root domain of
+ * each of them is charged @bw once per CPU, as if one SCHED_DEADLINE task
+ * with that bandwidth ran on each. As with tasks, a rebuild of the root
+ * domains does not carry it over.
+ */
+static int dl_server_admit(u64 old_bw, u64 new_bw)
+{
+	struct dl_bw *dl_b;
+	unsigned long flags;
+	int cpu, cpus, ret = 0;
+
+	for_each_online_cpu(cpu) {
+		rcu_read_lock_sched();
+		dl_b = dl_bw_of(cpu);
+		cpus = dl_bw_cpus(cpu);
+
+		raw_spin_lock_irqsave(&dl_b->lock, flags);
+		if (new_bw > old_bw &&
+		    __dl_overflow(dl_b, cpus, old_bw * cpus, new_bw * cpus))
+			ret = -EBUSY;
+		raw_spin_unlock_irqrestore(&dl_b->lock, flags);
+
+		rcu_read_unlock_sched();
+
+		if (ret)
+			return ret;
+	}
+
+	for_each_online_cpu(cpu) {
+		rcu_read_lock_sched();
+		dl_b = dl_bw_of(cpu);
+		cpus = dl_bw_cpus(cpu);
+
+		raw_spin_lock_irqsave(&dl_b->lock, flags);
+		__dl_sub(dl_b, old_bw, cpus);
+		__dl_add(dl_b, new_bw, cpus);
+		raw_spin_unlock_irqrestore(&dl_b->lock, flags);
+
+		rcu_read_unlock_sched();
+	}
+
+	return 0;
+}
+
+int sched_group_set_dl_server(struct task_group *tg,
+			      u64 runtime_us, u64 period_us)
+{
+	u64 runtime, period, old_bw, new_bw;
+	int cpu, ret = 0;
+
+	/* The root group's tasks are what the servers take time from */
+	if (tg == &root_task_group)
+		return -EINVAL;
+
+	if (runtime_us > U64_MAX / NSEC_PER_USEC ||
+	    period_us > U64_MAX / NSEC_PER_USEC)
+		return -EINVAL;
+
+	runtime = runtime_us * NSEC_PER_USEC;
+	period = period_us * NSEC_PER_USEC;
+
+	/* The same limits __checkparam_dl() puts on a task's parameters */
+	if (period < (1ULL << DL_SCALE) || period & (1ULL << 63))
+		return -EINVAL;
+	if (runtime && (runtime < (1ULL << DL_SCALE) || runtime > period))
+		return -EINVAL;
+
+	mutex_lock(&dl_server_mutex);
+	cpus_read_lock();
+
+	old_bw = tg->dl_server_runtime ?
+		 to_ratio(tg->dl_server_period, tg->dl_server_runtime) : 0;
+	new_bw = runtime ? to_ratio(period, runtime) : 0;
+
+	ret = dl_server_admit(old_bw, new_bw);
+	if (ret)
+		goto unlock;
+
+	tg->dl_server_runtime = runtime;
+	tg->dl_server_period = period;
+
+	for_each_possible_cpu(cpu) {
+		struct cfs_rq *cfs_rq = tg->cfs_rq[cpu];
+		struct sched_dl_entity *dl_se = &cfs_rq->dl_server;
+		struct rq *rq = cpu_rq(cpu);
+		struct rq_flags rf;
+
+		rq_lock_irq(rq, &rf);
+		update_rq_clock(rq);
+
+		/*
+		 * Restart from a fresh instance. A replenishment timer that
+		 * cannot be cancelled here sees !dl_throttled and does nothing.
+		 */
+		dl_server_stop(dl_se);
+		hrtimer_try_to_cancel(&dl_se->dl_timer);
+		dl_se->dl_throttled = 0;
+		dl_se->dl_yielded = 0;
+
+		dl_se->dl_runtime = runtime;
+		dl_se->dl_deadline = period;
+		dl_se->dl_period = period;
+		dl_se->dl_bw = new_bw;
+		dl_se->dl_density = new_bw;
+		dl_se->runtime = 0;
+		dl_se->deadline = 0;
+
+		if (runtime && dl_server_has_tasks(dl_se))
+			dl_server_start(dl_se);
+
+		rq_unlock_irq(rq, &rf);
+	}
+
+unlock:
+	cpus_read_unlock();
+	mutex_unlock(&dl_server_mutex);
+
+	return ret;
+}
+
+u64 sched_group_dl_runtime(struct task_group *tg)
+{
+	return div_u64(tg->dl_server_runtime, NSEC_PER_USEC);
+}
+
+u64 sched_group_dl_period(struct task_group *tg)
+{
+	return div_u64(tg->dl_server_period, NSEC_PER_USEC);
+}
+#endif /* CONFIG_FAIR_GROUP_DL_SERVER */
+
 /*
  * This function initializes the sched_dl_entity of a newly becoming
  * SCHED_DEADLINE task.
@@ -824,6 +824,23 @@ static void update_tg_load_avg(struct cfs_rq *cfs_rq, int force)
 }
 #endif /* CONFIG_SMP */
 
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+/* Charge the deadline server, if any, that picked the running task */
+static inline void update_curr_dl_server(struct rq *rq, u64 delta_exec)
+{
+	if (rq->dl_server)
+		dl_server_update(rq->dl_server, delta_exec);
+}
+
+static inline void clear_rq_dl_server(struct rq *rq)
+{
+	rq->dl_server = NULL;
+}
+#else
+static inline void update_curr_dl_server(struct rq *rq, u64 delta_exec) { }
+static inline void clear_rq_dl_server(struct rq *rq) { }
+#endif
+
 /*
  * Update the current task's runtime statistics.
  */
@@ -857,6 +874,7 @@ static void update_curr(struct cfs_rq *cfs_rq)
 		trace_sched_stat_runtime(curtask, delta_exec, curr->vruntime);
 		cgroup_account_cputime(curtask, delta_exec);
 		account_group_exec_runtime(curtask, delta_exec);
+		update_curr_dl_server(rq_of(cfs_rq), delta_exec);
 	}
 
 	account_cfs_rq_runtime(cfs_rq, delta_exec);
@@ -3854,6 +3872,17 @@ static void check_spread(struct cfs_rq *cfs_rq, struct sched_entity *se)
 #endif
 }
 
+/*
+ * latency_nice maps linearly onto [-sysctl_sched_latency,
+ * sysctl_sched_latency): negative for entities that want to run soon
+ * after waking up, positive for those that would rather run longer.
+ */
+static inline long se_latency_offset(struct sched_entity *se)
+{
+	return (long)se->latency_nice *
+	       (long)(sysctl_sched_latency / (LATENCY_NICE_WIDTH / 2));
+}
+
 static void
 place_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int initial)
 {
@@ -3870,7 +3899,7 @@ place_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int initial)
 
 	/* sleeps up to a single latency don't count. */
 	if (!initial) {
-		unsigned long thresh = sysctl_sched_latency;
+		long thresh = sysctl_sched_latency;
 
 		/*
 		 * Halve their sleep time's effect, to allow
@@ -3879,6 +3908,13 @@ place_entity(struct cfs_rq *cfs_rq, struct sched_entity *se, int initial)
 		if (sched_feat(GENTLE_FAIR_SLEEPERS))
 			thresh >>= 1;
 
+		/*
+		 * Latency sensitive entities get more of their sleep credit
+		 * back, up to a whole latency period, batch ones less.
+		 */
+		thresh = clamp_t(long, thresh - se_latency_offset(se), 0,
+				 sysctl_sched_latency);
+
 		vruntime -= thresh;
 	}
 
@@ -4102,6 +4138,9 @@ check_preempt_tick(struct cfs_rq *cfs_rq, struct sched_entity *curr)
 	s64 delta;
 
 	ideal_runtime = sched_slice(cfs_rq, curr);
+	/* Batch entities run longer slices before tick preemption */
+	if (curr->latency_nice > 0)
+		ideal_runtime += se_latency_offset(curr);
 	delta_exec = curr->sum_exec_runtime - curr->prev_sum_exec_runtime;
 	if (delta_exec > ideal_runtime) {
 		resched_curr(rq_of(cfs_rq));
@@ -4285,6 +4324,89 @@ entity_tick(struct cfs_rq *cfs_rq, struct sched_entity *curr, int queued)
 		check_preempt_tick(cfs_rq, curr);
 }
 
+/**************************************************
+ * Deadline servers of task groups, see kernel/sched/deadline.c:
+ */
+
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+bool dl_server_has_tasks(struct sched_dl_entity *dl_se)
+{
+	struct cfs_rq *cfs_rq = container_of(dl_se, struct cfs_rq, dl_server);
+
+	return cfs_rq->h_nr_running && !throttled_hierarchy(cfs_rq);
+}
+
+/*
+ * Start the servers of the groups from @cfs_rq up that have got runnable
+ * tasks on this CPU, and stop those that have none left.
+ */
+static void update_dl_servers(struct cfs_rq *cfs_rq)
+{
+	int cpu = cpu_of(rq_of(cfs_rq));
+	struct task_group *tg;
+
+	for (tg = cfs_rq->tg; tg; tg = tg->parent) {
+		struct sched_dl_entity *dl_se = &tg->cfs_rq[cpu]->dl_server;
+
+		if (!dl_se->dl_runtime)
+			continue;
+
+		if (dl_server_has_tasks(dl_se))
+			dl_server_start(dl_se);
+		else if (!tg->cfs_rq[cpu]->h_nr_running)
+			dl_server_stop(dl_se);
+	}
+}
+
+/*
+ * Charge prev and do any throttling that comes with it now, as
+ * pick_next_task_fair() would, so that the deadline class sees which
+ * groups can still run before it commits to a pick.
+ */
+void dl_server_update_prev(struct task_struct *prev)
+{
+	struct sched_entity *se = &prev->se;
+
+	for_each_sched_entity(se) {
+		struct cfs_rq *cfs_rq = cfs_rq_of(se);
+
+		if (se->on_rq)
+			update_curr(cfs_rq);
+		check_cfs_rq_runtime(cfs_rq);
+	}
+}
+
+/*
+ * Pick the task a server runs, after prev has been put: the group's entity
+ * and its ancestors become current, then the pick goes down the group's
+ * own hierarchy as it would from the root.
+ */
+struct task_struct *dl_server_pick(struct sched_dl_entity *dl_se)
+{
+	struct cfs_rq *cfs_rq = container_of(dl_se, struct cfs_rq, dl_server);
+	struct rq *rq = rq_of(cfs_rq);
+	struct sched_entity *se = cfs_rq->tg->se[cpu_of(rq)];
+	struct task_struct *p;
+
+	for_each_sched_entity(se)
+		set_next_entity(cfs_rq_of(se), se);
+
+	do {
+		se = pick_next_entity(cfs_rq, NULL);
+		set_next_entity(cfs_rq, se);
+		cfs_rq = group_cfs_rq(se);
+	} while (cfs_rq);
+
+	p = task_of(se);
+#ifdef CONFIG_SMP
+	list_move(&p->se.group_node, &rq->cfs_tasks);
+#endif
+
+	return p;
+}
+#else
+static inline void update_dl_servers(struct cfs_rq *cfs_rq) { }
+#endif /* CONFIG_FAIR_GROUP_DL_SERVER */
 
 /**************************************************
  * CFS bandwidth control machinery
@@ -4540,6 +4662,7 @@ void unthrottle_cfs_rq(struct cfs_rq *cfs_rq)
 {
 	struct rq *rq = rq_of(cfs_rq);
 	struct cfs_bandwidth *cfs_b = tg_cfs_bandwidth(cfs_rq->tg);
+	struct cfs_rq *unthrottled = cfs_rq;
 	struct sched_entity *se;
 	int enqueue = 1;
 	long task_delta;
@@ -4580,6 +4703,8 @@ void unthrottle_cfs_rq(struct cfs_rq *cfs_rq)
 	if (!se)
 		add_nr_running(rq, task_delta);
 
+	update_dl_servers(unthrottled);
+
 	/* Determine whether we need to wake up potentially idle CPU: */
 	if (rq->curr == rq->idle && rq->cfs.nr_running)
 		resched_curr(rq);
@@ -5220,6 +5345,8 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 
 	assert_list_leaf_cfs_rq(rq);
 
+	update_dl_servers(cfs_rq_of(&p->se));
+
 	hrtick_update(rq);
 }
 
@@ -5279,10 +5406,98 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	if (!se)
 		sub_nr_running(rq, 1);
 
+	update_dl_servers(cfs_rq_of(&p->se));
+
 	util_est_dequeue(&rq->cfs, p, task_sleep);
 	hrtick_update(rq);
 }
 
+#if defined(CONFIG_FAIR_GROUP_SCHED) && defined(CONFIG_SMP)
+/* Ticks a group's preferred LLC can bank against ticks spent elsewhere */
+#define LLC_AFFINITY_VOTES_MAX	16
+
+/*
+ * Track the LLC a group with llc_affinity runs on most with a majority
+ * vote over the ticks of its tasks. Updates from different CPUs may race;
+ * that only makes the vote a little noisier.
+ */
+static void task_tick_group_llc(struct rq *rq, struct task_struct *curr)
+{
+	struct task_group *tg = task_group(curr);
+	int llc = per_cpu(sd_llc_id, cpu_of(rq));
+	int votes;
+
+	if (!READ_ONCE(tg->llc_affinity))
+		return;
+
+	votes = READ_ONCE(tg->preferred_llc_votes);
+	if (llc == READ_ONCE(tg->preferred_llc)) {
+		if (votes < LLC_AFFINITY_VOTES_MAX)
+			WRITE_ONCE(tg->preferred_llc_votes, votes + 1);
+		schedstat_inc(tg->cfs_rq[cpu_of(rq)]->llc_local_ticks);
+		return;
+	}
+
+	if (votes <= 1) {
+		WRITE_ONCE(tg->preferred_llc, llc);
+		WRITE_ONCE(tg->preferred_llc_votes, 1);
+	} else {
+		WRITE_ONCE(tg->preferred_llc_votes, votes - 1);
+	}
+	schedstat_inc(tg->cfs_rq[cpu_of(rq)]->llc_remote_ticks);
+}
+
+/*
+ * Does the LLC of @cpu have an idle CPU @p may run on? Looks at the idle
+ * cpumask only, which is a superset of the idle CPUs.
+ */
+static bool llc_has_idle_cpu(struct task_struct *p, int cpu)
+{
+	struct sched_domain_shared *sds;
+
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	return sds && cpumask_intersects(sds_idle_cpus(sds), &p->cpus_allowed);
+}
+
+/*
+ * For a wakeup between LLCs, pick whichever of @this_cpu and @prev_cpu
+ * sits in the group's preferred LLC, as long as that LLC has room.
+ * Returns nr_cpumask_bits when the group has no say.
+ */
+static int wake_affine_group_llc(struct task_struct *p, int this_cpu,
+				 int prev_cpu)
+{
+	struct task_group *tg = task_group(p);
+	int llc, this_llc, prev_llc;
+
+	if (!READ_ONCE(tg->llc_affinity))
+		return nr_cpumask_bits;
+
+	this_llc = per_cpu(sd_llc_id, this_cpu);
+	prev_llc = per_cpu(sd_llc_id, prev_cpu);
+	if (this_llc == prev_llc)
+		return nr_cpumask_bits;
+
+	llc = READ_ONCE(tg->preferred_llc);
+	if (prev_llc == llc && llc_has_idle_cpu(p, prev_cpu))
+		return prev_cpu;
+	if (this_llc == llc && llc_has_idle_cpu(p, this_cpu))
+		return this_cpu;
+
+	return nr_cpumask_bits;
+}
+#else
+static inline void task_tick_group_llc(struct rq *rq, struct task_struct *curr)
+{
+}
+
+static inline int wake_affine_group_llc(struct task_struct *p, int this_cpu,
+					int prev_cpu)
+{
+	return nr_cpumask_bits;
+}
+#endif
+
 #ifdef CONFIG_SMP
 
 /* Working cpumask for: load_balance, load_balance_newidle. */
@@ -5747,6 +5962,12 @@ static int wake_affine(struct sched_domain *sd, struct task_struct *p,
 {
 	int target = nr_cpumask_bits;
 
+	target = wake_affine_group_llc(p, this_cpu, prev_cpu);
+	if (target != nr_cpumask_bits) {
+		schedstat_inc(p->se.statistics.nr_wakeups_group_llc);
+		return target;
+	}
+
 	if (sched_feat(WA_IDLE))
 		target = wake_affine_idle(this_cpu, prev_cpu, sync);
 
@@ -6021,6 +6242,28 @@ static inline int find_idlest_cpu(struct sched_domain *sd, struct task_struct *p
 	return new_cpu;
 }
 
+/*
+ * Keep sd_llc_shared's idle cpumask a superset of the idle CPUs: a CPU
+ * sets its bit when it enters idle and clears it from its own tick once it
+ * is busy, so each bit is only ever written by the CPU it describes and a
+ * stale bit costs a wakeup no more than one available_idle_cpu() test.
+ */
+void update_idle_cpumask(struct rq *rq, bool idle)
+{
+	struct sched_domain_shared *sds;
+	int cpu = cpu_of(rq);
+
+	rcu_read_lock();
+	sds = rcu_dereference(per_cpu(sd_llc_shared, cpu));
+	if (sds && cpumask_test_cpu(cpu, sds_idle_cpus(sds)) != idle) {
+		if (idle)
+			cpumask_set_cpu(cpu, sds_idle_cpus(sds));
+		else
+			cpumask_clear_cpu(cpu, sds_idle_cpus(sds));
+	}
+	rcu_read_unlock();
+}
+
 #ifdef CONFIG_SCHED_SMT
 DEFINE_STATIC_KEY_FALSE(sched_smt_present);
 EXPORT_SYMBOL_GPL(sched_smt_present);
@@ -6155,6 +6398,7 @@ static inline int select_idle_smt(struct task_struct *p, struct sched_domain *sd
 static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int target)
 {
 	struct sched_domain *this_sd;
+	const struct cpumask *cpus;
 	u64 avg_cost, avg_idle;
 	u64 time, cost;
 	s64 delta;
@@ -6182,12 +6426,17 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int t
 			nr = 4;
 	}
 
+	cpus = sched_domain_span(sd);
+	if (sched_feat(SIS_IDLE_MASK) && sd->shared)
+		cpus = sds_idle_cpus(sd->shared);
+
 	time = local_clock();
 
-	for_each_cpu_wrap(cpu, sched_domain_span(sd), target) {
+	for_each_cpu_wrap(cpu, cpus, target) {
 		if (!--nr)
 			return -1;
-		if (!cpumask_test_cpu(cpu, &p->cpus_allowed))
+		if (!cpumask_test_cpu(cpu, &p->cpus_allowed) ||
+		    !cpumask_test_cpu(cpu, sched_domain_span(sd)))
 			continue;
 		if (available_idle_cpu(cpu))
 			break;
@@ -6594,6 +6843,17 @@ wakeup_preempt_entity(struct sched_entity *curr, struct sched_entity *se)
 {
 	s64 gran, vdiff = curr->vruntime - se->vruntime;
 
+	/*
+	 * Shift the comparison by the entities' latency_nice difference,
+	 * so a latency sensitive se preempts a batch curr well before it
+	 * would on vruntime alone, and the reverse takes longer.
+	 */
+	if (curr->latency_nice != se->latency_nice)
+		vdiff += clamp_t(long, se_latency_offset(curr) -
+				       se_latency_offset(se),
+				 -(long)sysctl_sched_latency,
+				 sysctl_sched_latency);
+
 	if (vdiff <= 0)
 		return -1;
 
@@ -6822,6 +7082,8 @@ pick_next_task_fair(struct rq *rq, struct task_struct *prev, struct rq_flags *rf
 	p = task_of(se);
 
 done: __maybe_unused;
+	clear_rq_dl_server(rq);
+
 #ifdef CONFIG_SMP
 	/*
 	 * Move the next running task to the front of
@@ -7168,13 +7430,49 @@ static inline int migrate_degrades_locality(struct task_struct *p,
 }
 #endif
 
+#ifdef CONFIG_FAIR_GROUP_SCHED
+/*
+ * Returns 1, if task migration takes it out of its group's preferred LLC
+ * Returns 0, if task migration brings it into the preferred LLC.
+ * Returns -1, if task migration is not affected by group locality.
+ */
+static int migrate_degrades_group_locality(struct task_struct *p,
+					   struct lb_env *env)
+{
+	struct task_group *tg = task_group(p);
+	int llc, src_llc, dst_llc;
+
+	if (!READ_ONCE(tg->llc_affinity))
+		return -1;
+
+	src_llc = per_cpu(sd_llc_id, env->src_cpu);
+	dst_llc = per_cpu(sd_llc_id, env->dst_cpu);
+	if (src_llc == dst_llc)
+		return -1;
+
+	llc = READ_ONCE(tg->preferred_llc);
+	if (src_llc == llc)
+		return 1;
+	if (dst_llc == llc)
+		return 0;
+
+	return -1;
+}
+#else
+static inline int migrate_degrades_group_locality(struct task_struct *p,
+						  struct lb_env *env)
+{
+	return -1;
+}
+#endif
+
 /*
  * can_migrate_task - may task p from runqueue rq be migrated to this_cpu?
  */
 static
 int can_migrate_task(struct task_struct *p, struct lb_env *env)
 {
-	int tsk_cache_hot;
+	int tsk_cache_hot, group_hot = -1;
 
 	lockdep_assert_held(&env->src_rq->lock);
 
@@ -7228,11 +7526,15 @@ int can_migrate_task(struct task_struct *p, struct lb_env *env)
 
 	/*
 	 * Aggressive migration if:
-	 * 1) destination numa is preferred
+	 * 1) destination numa or the group's preferred LLC is preferred
 	 * 2) task is cache cold, or
 	 * 3) too many balance attempts have failed.
 	 */
 	tsk_cache_hot = migrate_degrades_locality(p, env);
+	if (tsk_cache_hot == -1) {
+		group_hot = migrate_degrades_group_locality(p, env);
+		tsk_cache_hot = group_hot;
+	}
 	if (tsk_cache_hot == -1)
 		tsk_cache_hot = task_hot(p, env);
 
@@ -7245,7 +7547,10 @@ int can_migrate_task(struct task_struct *p, struct lb_env *env)
 		return 1;
 	}
 
-	schedstat_inc(p->se.statistics.nr_failed_migrations_hot);
+	if (group_hot == 1)
+		schedstat_inc(p->se.statistics.nr_failed_migrations_group);
+	else
+		schedstat_inc(p->se.statistics.nr_failed_migrations_hot);
 	return 0;
 }
 
@@ -9793,6 +10098,8 @@ static void task_tick_fair(struct rq *rq, struct task_struct *curr, int queued)
 
 	if (static_branch_unlikely(&sched_numa_balancing))
 		task_tick_numa(rq, curr);
+
+	task_tick_group_llc(rq, curr);
 }
 
 /*
@@ -9995,6 +10302,9 @@ static void set_curr_task_fair(struct rq *rq)
 {
 	struct sched_entity *se = &rq->curr->se;
 
+	/* Not picked, so not run on behalf of a server either */
+	clear_rq_dl_server(rq);
+
 	for_each_sched_entity(se) {
 		struct cfs_rq *cfs_rq = cfs_rq_of(se);
 
@@ -10057,6 +10367,10 @@ void free_fair_sched_group(struct task_group *tg)
 	destroy_cfs_bandwidth(tg_cfs_bandwidth(tg));
 
 	for_each_possible_cpu(i) {
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+		if (tg->cfs_rq && tg->cfs_rq[i])
+			hrtimer_cancel(&tg->cfs_rq[i]->dl_server.dl_timer);
+#endif
 		if (tg->cfs_rq)
 			kfree(tg->cfs_rq[i]);
 		if (tg->se)
@@ -10081,6 +10395,9 @@ int alloc_fair_sched_group(struct task_group *tg, struct task_group *parent)
 		goto err;
 
 	tg->shares = NICE_0_LOAD;
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	tg->dl_server_period = 100 * NSEC_PER_MSEC;
+#endif
 
 	init_cfs_bandwidth(tg_cfs_bandwidth(tg));
 
@@ -10160,6 +10477,9 @@ void init_tg_cfs_entry(struct task_group *tg, struct cfs_rq *cfs_rq,
 	cfs_rq->tg = tg;
 	cfs_rq->rq = rq;
 	init_cfs_rq_runtime(cfs_rq);
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	init_dl_server(&cfs_rq->dl_server);
+#endif
 
 	tg->cfs_rq[cpu] = cfs_rq;
 	tg->se[cpu] = se;
@@ -10179,6 +10499,7 @@ void init_tg_cfs_entry(struct task_group *tg, struct cfs_rq *cfs_rq,
 	se->my_q = cfs_rq;
 	/* guarantee group entities always have weight */
 	update_load_set(&se->load, NICE_0_LOAD);
+	se->latency_nice = tg->latency_nice;
 	se->parent = parent;
 }
 
@@ -10220,6 +10541,30 @@ int sched_group_set_shares(struct task_group *tg, unsigned long shares)
 	mutex_unlock(&shares_mutex);
 	return 0;
 }
+
+int sched_group_set_latency_nice(struct task_group *tg, long latency)
+{
+	int i;
+
+	/* The root group has no entities to carry it */
+	if (!tg->se[0])
+		return -EINVAL;
+
+	if (latency < MIN_LATENCY_NICE || latency > MAX_LATENCY_NICE)
+		return -ERANGE;
+
+	/*
+	 * latency_nice is only ever compared, so the entities can pick up
+	 * the new value without being requeued.
+	 */
+	mutex_lock(&shares_mutex);
+	tg->latency_nice = latency;
+	for_each_possible_cpu(i)
+		WRITE_ONCE(tg->se[i]->latency_nice, latency);
+	mutex_unlock(&shares_mutex);
+
+	return 0;
+}
 #else /* CONFIG_FAIR_GROUP_SCHED */
 
 void free_fair_sched_group(struct task_group *tg) { }
@@ -57,6 +57,8 @@ SCHED_FEAT(TTWU_QUEUE, true)
  */
 SCHED_FEAT(SIS_AVG_CPU, false)
 SCHED_FEAT(SIS_PROP, true)
+/* Only scan the CPUs in the LLC's idle cpumask */
+SCHED_FEAT(SIS_IDLE_MASK, true)
 
 /*
  * Issue a WARN when we do multiple update_rq_clock() calls
@@ -76,6 +78,12 @@ SCHED_FEAT(WARN_DOUBLE_CLOCK, false)
  * it should go may be a better scenario.
  */
 SCHED_FEAT(RT_PUSH_IPI, true)
+
+/*
+ * Let the RT_PUSH_IPI chain skip overloaded CPUs whose waiting task has
+ * no lower priority CPU to be pushed to.
+ */
+SCHED_FEAT(RT_PUSH_IPI_FILTER, true)
 #endif
 
 SCHED_FEAT(RT_RUNTIME_SHARE, true)
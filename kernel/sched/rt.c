@@ -7,6 +7,8 @@
 
 #include "pelt.h"
 
+#include <trace/events/sched.h>
+
 int sched_rr_timeslice = RR_TIMESLICE;
 int sysctl_sched_rr_timeslice = (MSEC_PER_SEC / HZ) * RR_TIMESLICE;
 
@@ -1887,6 +1889,16 @@ static void push_rt_tasks(struct rq *rq)
 
 #ifdef HAVE_RT_PUSH_IPI
 
+/* Could @cpu's next RT task run anywhere else in @rd? */
+static bool rto_cpu_can_push(struct root_domain *rd, int cpu)
+{
+	if (!sched_feat(RT_PUSH_IPI_FILTER))
+		return true;
+
+	return cpupri_has_lower(&rd->cpupri,
+				READ_ONCE(cpu_rq(cpu)->rt.highest_prio.next));
+}
+
 /*
  * When a high priority task schedules out from a CPU and a lower priority
  * task is scheduled in, a check is made to see if there's any RT tasks
@@ -1927,8 +1939,17 @@ static void push_rt_tasks(struct rq *rq)
  * priority task, even if the iterator is in the middle of a scan. Incrementing
  * the rt_loop_next will cause the iterator to perform another scan.
  *
+ * An overloaded CPU whose next RT task could not run anywhere else in the
+ * root domain, because every other CPU is already running something of at
+ * least that priority, is skipped rather than interrupted: its push would
+ * find no lowest_rq and do nothing.  On a box with many CPUs each busy with
+ * RT work that is most of the rto_mask, and skipping it keeps the chain from
+ * hopping across every one of them each time one CPU lowers its priority.
+ * The check is racy, but a CPU that drops its priority after the check does
+ * its own pull, and one whose next task rises in priority pushes it itself.
+ *
  */
-static int rto_next_cpu(struct root_domain *rd)
+static int rto_next_cpu(struct root_domain *rd, int *skipped)
 {
 	int next;
 	int cpu;
@@ -1953,8 +1974,13 @@ static int rto_next_cpu(struct root_domain *rd)
 
 		rd->rto_cpu = cpu;
 
-		if (cpu < nr_cpu_ids)
+		if (cpu < nr_cpu_ids) {
+			if (!rto_cpu_can_push(rd, cpu)) {
+				(*skipped)++;
+				continue;
+			}
 			return cpu;
+		}
 
 		rd->rto_cpu = -1;
 
@@ -1987,6 +2013,7 @@ static inline void rto_start_unlock(atomic_t *v)
 
 static void tell_cpu_to_push(struct rq *rq)
 {
+	int skipped = 0;
 	int cpu = -1;
 
 	/* Keep the loop going if the IPI is currently active */
@@ -2005,7 +2032,7 @@ static void tell_cpu_to_push(struct rq *rq)
 	 * Otherwise it is finishing up and an ipi needs to be sent.
 	 */
 	if (rq->rd->rto_cpu < 0)
-		cpu = rto_next_cpu(rq->rd);
+		cpu = rto_next_cpu(rq->rd, &skipped);
 
 	raw_spin_unlock(&rq->rd->rto_lock);
 
@@ -2014,6 +2041,7 @@ static void tell_cpu_to_push(struct rq *rq)
 	if (cpu >= 0) {
 		/* Make sure the rd does not get freed while pushing */
 		sched_get_rd(rq->rd);
+		trace_sched_rt_push_ipi(rq->cpu, cpu, skipped);
 		irq_work_queue_on(&rq->rd->rto_push_work, cpu);
 	}
 }
@@ -2023,6 +2051,7 @@ void rto_push_irq_work_func(struct irq_work *work)
 {
 	struct root_domain *rd =
 		container_of(work, struct root_domain, rto_push_work);
+	int skipped = 0;
 	struct rq *rq;
 	int cpu;
 
@@ -2041,7 +2070,7 @@ void rto_push_irq_work_func(struct irq_work *work)
 	raw_spin_lock(&rd->rto_lock);
 
 	/* Pass the IPI to the next rt overloaded queue */
-	cpu = rto_next_cpu(rd);
+	cpu = rto_next_cpu(rd, &skipped);
 
 	raw_spin_unlock(&rd->rto_lock);
 
@@ -2051,6 +2080,7 @@ void rto_push_irq_work_func(struct irq_work *work)
 	}
 
 	/* Try the next RT overloaded CPU */
+	trace_sched_rt_push_ipi(rq->cpu, cpu, skipped);
 	irq_work_queue_on(&rd->rto_push_work, cpu);
 }
 #endif /* HAVE_RT_PUSH_IPI */
@@ -2079,11 +2109,14 @@ static void pull_rt_task(struct rq *this_rq)
 
 #ifdef HAVE_RT_PUSH_IPI
 	if (sched_feat(RT_PUSH_IPI)) {
+		trace_sched_rt_pull(this_cpu, rt_overload_count, true);
 		tell_cpu_to_push(this_rq);
 		return;
 	}
 #endif
 
+	trace_sched_rt_pull(this_cpu, rt_overload_count, false);
+
 	for_each_cpu(cpu, this_rq->rd->rto_mask) {
 		if (this_cpu == cpu)
 			continue;
@@ -366,6 +366,7 @@ struct task_group {
 	/* runqueue "owned" by this group on each CPU */
 	struct cfs_rq		**cfs_rq;
 	unsigned long		shares;
+	int			latency_nice;
 
 #ifdef	CONFIG_SMP
 	/*
@@ -374,6 +375,15 @@ struct task_group {
 	 * will also be accessed at each tick.
 	 */
 	atomic_long_t		load_avg ____cacheline_aligned;
+
+	/*
+	 * LLC affinity: when set, wakeups and load balancing try to keep
+	 * the group's tasks in preferred_llc, the sd_llc_id they have been
+	 * running on most, while it has idle capacity.
+	 */
+	int			llc_affinity;
+	int			preferred_llc;
+	int			preferred_llc_votes;
 #endif
 #endif
 
@@ -396,6 +406,19 @@ struct task_group {
 #endif
 
 	struct cfs_bandwidth	cfs_bandwidth;
+
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	/* reservation of each CPU's deadline server, in ns; 0 runtime is off */
+	u64			dl_server_runtime;
+	u64			dl_server_period;
+#endif
+
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	/* Clamp values requested via cgroup */
+	struct uclamp_se	uclamp_req[UCLAMP_CNT];
+	/* Effective clamp values, restricted by the parent's */
+	struct uclamp_se	uclamp[UCLAMP_CNT];
+#endif
 };
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -465,6 +488,14 @@ extern void sched_move_task(struct task_struct *tsk);
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
 extern int sched_group_set_shares(struct task_group *tg, unsigned long shares);
+extern int sched_group_set_latency_nice(struct task_group *tg, long latency);
+
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+extern int sched_group_set_dl_server(struct task_group *tg,
+				     u64 runtime_us, u64 period_us);
+extern u64 sched_group_dl_runtime(struct task_group *tg);
+extern u64 sched_group_dl_period(struct task_group *tg);
+#endif
 
 #ifdef CONFIG_SMP
 extern void set_task_rq_fair(struct sched_entity *se,
@@ -557,6 +588,12 @@ struct cfs_rq {
 	struct list_head	leaf_cfs_rq_list;
 	struct task_group	*tg;	/* group that "owns" this runqueue */
 
+#if defined(CONFIG_SMP) && defined(CONFIG_SCHEDSTATS)
+	/* ticks of tg's tasks on this CPU inside/outside tg->preferred_llc */
+	u64			llc_local_ticks;
+	u64			llc_remote_ticks;
+#endif
+
 #ifdef CONFIG_CFS_BANDWIDTH
 	int			runtime_enabled;
 	s64			runtime_remaining;
@@ -568,6 +605,11 @@ struct cfs_rq {
 	int			throttle_count;
 	struct list_head	throttled_list;
 #endif /* CONFIG_CFS_BANDWIDTH */
+
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	/* runs tg's tasks on this CPU within tg's deadline reservation */
+	struct sched_dl_entity	dl_server;
+#endif
 #endif /* CONFIG_FAIR_GROUP_SCHED */
 };
 
@@ -769,6 +811,31 @@ extern void rto_push_irq_work_func(struct irq_work *work);
 #endif
 #endif /* CONFIG_SMP */
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+#define UCLAMP_BUCKETS		5
+#define UCLAMP_BUCKET_DELTA	DIV_ROUND_CLOSEST(SCHED_CAPACITY_SCALE, \
+						  UCLAMP_BUCKETS)
+
+/*
+ * Runnable tasks refcounted by clamp value range. @value is the largest
+ * clamp seen in the bucket since it last went empty, which may overboost
+ * (or undercap) a little but spares a search on every dequeue.
+ */
+struct uclamp_bucket {
+	unsigned long value : (SCHED_CAPACITY_SHIFT + 1);
+	unsigned long tasks : BITS_PER_LONG - (SCHED_CAPACITY_SHIFT + 1);
+};
+
+/*
+ * Max aggregation of the clamps of the runnable tasks: @value is read by
+ * schedutil without the rq lock.
+ */
+struct uclamp_rq {
+	unsigned int value;
+	struct uclamp_bucket bucket[UCLAMP_BUCKETS];
+};
+#endif
+
 /*
  * This is the main, per-CPU runqueue data structure.
  *
@@ -807,10 +874,20 @@ struct rq {
 	unsigned long		nr_load_updates;
 	u64			nr_switches;
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+	/* Utilization clamp values based on CPU's RUNNABLE tasks */
+	struct uclamp_rq	uclamp[UCLAMP_CNT] ____cacheline_aligned;
+#endif
+
 	struct cfs_rq		cfs;
 	struct rt_rq		rt;
 	struct dl_rq		dl;
 
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+	/* the deadline server that picked the running CFS task, if any */
+	struct sched_dl_entity	*dl_server;
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	/* list of leaf cfs_rq on this CPU: */
 	struct list_head	leaf_cfs_rq_list;
@@ -944,6 +1021,12 @@ static inline void update_idle_core(struct rq *rq)
 static inline void update_idle_core(struct rq *rq) { }
 #endif
 
+#ifdef CONFIG_SMP
+extern void update_idle_cpumask(struct rq *rq, bool idle);
+#else
+static inline void update_idle_cpumask(struct rq *rq, bool idle) { }
+#endif
+
 DECLARE_PER_CPU_SHARED_ALIGNED(struct rq, runqueues);
 
 #define cpu_rq(cpu)		(&per_cpu(runqueues, (cpu)))
@@ -1648,6 +1731,18 @@ extern void init_dl_task_timer(struct sched_dl_entity *dl_se);
 extern void init_dl_inactive_task_timer(struct sched_dl_entity *dl_se);
 extern void init_dl_rq_bw_ratio(struct dl_rq *dl_rq);
 
+#ifdef CONFIG_FAIR_GROUP_DL_SERVER
+extern void init_dl_server(struct sched_dl_entity *dl_se);
+extern void dl_server_start(struct sched_dl_entity *dl_se);
+extern void dl_server_stop(struct sched_dl_entity *dl_se);
+extern void dl_server_update(struct sched_dl_entity *dl_se, u64 delta_exec);
+
+/* implemented by the fair class, which owns the tasks a server runs */
+extern bool dl_server_has_tasks(struct sched_dl_entity *dl_se);
+extern void dl_server_update_prev(struct task_struct *prev);
+extern struct task_struct *dl_server_pick(struct sched_dl_entity *dl_se);
+#endif
+
 #define BW_SHIFT		20
 #define BW_UNIT			(1 << BW_SHIFT)
 #define RATIO_SHIFT		8
@@ -2214,6 +2309,26 @@ static inline unsigned long cpu_util_rt(struct rq *rq)
 {
 	return READ_ONCE(rq->avg_rt.util_avg);
 }
+
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+/* Clamp @util to the range requested by the groups runnable on @rq */
+static inline unsigned long uclamp_rq_util(struct rq *rq, unsigned long util)
+{
+	unsigned long min_util = READ_ONCE(rq->uclamp[UCLAMP_MIN].value);
+	unsigned long max_util = READ_ONCE(rq->uclamp[UCLAMP_MAX].value);
+
+	/* A boost from one group beats a cap from another */
+	if (unlikely(min_util >= max_util))
+		return min_util;
+
+	return clamp(util, min_util, max_util);
+}
+#else
+static inline unsigned long uclamp_rq_util(struct rq *rq, unsigned long util)
+{
+	return util;
+}
+#endif
 #endif
 
 #ifdef CONFIG_HAVE_SCHED_AVG_IRQ
@@ -1192,6 +1192,8 @@ sd_init(struct sched_domain_topology_level *tl,
 		sd->shared = *per_cpu_ptr(sdd->sds, sd_id);
 		atomic_inc(&sd->shared->ref);
 		atomic_set(&sd->shared->nr_busy_cpus, sd_weight);
+		/* Start from the whole span, busy CPUs drop out on a tick */
+		cpumask_copy(sds_idle_cpus(sd->shared), sched_domain_span(sd));
 	}
 
 	sd->private = sdd;
@@ -1534,8 +1536,9 @@ static int __sdt_alloc(const struct cpumask *cpu_map)
 
 			*per_cpu_ptr(sdd->sd, j) = sd;
 
-			sds = kzalloc_node(sizeof(struct sched_domain_shared),
-					GFP_KERNEL, cpu_to_node(j));
+			sds = kzalloc_node(sizeof(struct sched_domain_shared) +
+					   cpumask_size(), GFP_KERNEL,
+					   cpu_to_node(j));
 			if (!sds)
 				return -ENOMEM;
 
@@ -31,6 +31,8 @@ struct call_function_data {
 	call_single_data_t	__percpu *csd;
 	cpumask_var_t		cpumask;
 	cpumask_var_t		cpumask_ipi;
+	cpumask_var_t		cpumask_batch;	/* IPIs held back by a batch */
+	unsigned int		batch_depth;
 };
 
 static DEFINE_PER_CPU_SHARED_ALIGNED(struct call_function_data, cfd_data);
@@ -51,10 +53,17 @@ int smpcfd_prepare_cpu(unsigned int cpu)
 		free_cpumask_var(cfd->cpumask);
 		return -ENOMEM;
 	}
+	if (!zalloc_cpumask_var_node(&cfd->cpumask_batch, GFP_KERNEL,
+				     cpu_to_node(cpu))) {
+		free_cpumask_var(cfd->cpumask);
+		free_cpumask_var(cfd->cpumask_ipi);
+		return -ENOMEM;
+	}
 	cfd->csd = alloc_percpu(call_single_data_t);
 	if (!cfd->csd) {
 		free_cpumask_var(cfd->cpumask);
 		free_cpumask_var(cfd->cpumask_ipi);
+		free_cpumask_var(cfd->cpumask_batch);
 		return -ENOMEM;
 	}
 
@@ -67,6 +76,7 @@ int smpcfd_dead_cpu(unsigned int cpu)
 
 	free_cpumask_var(cfd->cpumask);
 	free_cpumask_var(cfd->cpumask_ipi);
+	free_cpumask_var(cfd->cpumask_batch);
 	free_percpu(cfd->csd);
 	return 0;
 }
@@ -133,13 +143,87 @@ static __always_inline void csd_unlock(call_single_data_t *csd)
 
 static DEFINE_PER_CPU_SHARED_ALIGNED(call_single_data_t, csd_data);
 
+/*
+ * Hold back the IPI to @cpu if this CPU is inside smp_call_batch_begin(),
+ * smp_call_batch_end() sends it together with the others.  Interrupts on
+ * this CPU may add to the batch as well, hence the atomic bitop.
+ */
+static bool call_batch_defer(int cpu)
+{
+	struct call_function_data *cfd = this_cpu_ptr(&cfd_data);
+
+	if (!cfd->batch_depth)
+		return false;
+
+	cpumask_set_cpu(cpu, cfd->cpumask_batch);
+	return true;
+}
+
+static void call_batch_send(struct call_function_data *cfd)
+{
+	unsigned long flags;
+
+	local_irq_save(flags);
+	if (!cpumask_empty(cfd->cpumask_batch)) {
+		arch_send_call_function_ipi_mask(cfd->cpumask_batch);
+		cpumask_clear(cfd->cpumask_batch);
+	}
+	local_irq_restore(flags);
+}
+
+/*
+ * A call that is about to wait must not depend on an IPI still held back
+ * by our own batch: its csd may sit behind a batched one on the target's
+ * queue, in which case llist_add() leaves the kick to the batch.
+ */
+static void call_batch_flush(void)
+{
+	struct call_function_data *cfd = this_cpu_ptr(&cfd_data);
+
+	if (cfd->batch_depth)
+		call_batch_send(cfd);
+}
+
+/**
+ * smp_call_batch_begin - start coalescing cross-call IPIs from this CPU
+ *
+ * Until the matching smp_call_batch_end(), smp_call_function_single_async()
+ * only queues its csd and records the destination; smp_call_batch_end()
+ * then kicks all of them with a single arch_send_call_function_ipi_mask().
+ * Calls that wait for completion are not held back and flush the batch.
+ *
+ * Disables preemption until smp_call_batch_end().  Batches nest.  Keep
+ * them short, other CPUs queueing to the same destinations may rely on
+ * the IPI being held back.
+ */
+void smp_call_batch_begin(void)
+{
+	preempt_disable();
+	this_cpu_ptr(&cfd_data)->batch_depth++;
+}
+EXPORT_SYMBOL_GPL(smp_call_batch_begin);
+
+/**
+ * smp_call_batch_end - send the IPIs held back since smp_call_batch_begin()
+ */
+void smp_call_batch_end(void)
+{
+	struct call_function_data *cfd = this_cpu_ptr(&cfd_data);
+
+	if (!WARN_ON_ONCE(!cfd->batch_depth) && !--cfd->batch_depth)
+		call_batch_send(cfd);
+	preempt_enable();
+}
+EXPORT_SYMBOL_GPL(smp_call_batch_end);
+
 /*
  * Insert a previously allocated call_single_data_t element
  * for execution on the given CPU. data must already have
- * ->func, ->info, and ->flags set.
+ * ->func, ->info, and ->flags set.  With @defer, the IPI may be held back
+ * by a batch on this CPU.
  */
 static int generic_exec_single(int cpu, call_single_data_t *csd,
-			       smp_call_func_t func, void *info)
+			       smp_call_func_t func, void *info, bool defer)
 {
 	if (cpu == smp_processor_id()) {
 		unsigned long flags;
@@ -175,7 +259,8 @@ static int generic_exec_single(int cpu, call_single_data_t *csd,
 	 * locking and barrier primitives. Generic code isn't really
 	 * equipped to do the right thing...
 	 */
-	if (llist_add(&csd->llist, &per_cpu(call_single_queue, cpu)))
+	if (llist_add(&csd->llist, &per_cpu(call_single_queue, cpu)) &&
+	    !(defer && call_batch_defer(cpu)))
 		arch_send_call_function_single_ipi(cpu);
 
 	return 0;
@@ -294,9 +379,11 @@ int smp_call_function_single(int cpu, smp_call_func_t func, void *info,
 	if (!wait) {
 		csd = this_cpu_ptr(&csd_data);
 		csd_lock(csd);
+	} else {
+		call_batch_flush();
 	}
 
-	err = generic_exec_single(cpu, csd, func, info);
+	err = generic_exec_single(cpu, csd, func, info, false);
 
 	if (wait)
 		csd_lock_wait(csd);
@@ -336,7 +423,7 @@ int smp_call_function_single_async(int cpu, call_single_data_t *csd)
 	csd->flags = CSD_FLAG_LOCK;
 	smp_wmb();
 
-	err = generic_exec_single(cpu, csd, csd->func, csd->info);
+	err = generic_exec_single(cpu, csd, csd->func, csd->info, true);
 	preempt_enable();
 
 	return err;
@@ -444,6 +531,9 @@ void smp_call_function_many(const struct cpumask *mask,
 	if (unlikely(!cpumask_weight(cfd->cpumask)))
 		return;
 
+	if (wait)
+		call_batch_flush();
+
 	cpumask_clear(cfd->cpumask_ipi);
 	for_each_cpu(cpu, cfd->cpumask) {
 		call_single_data_t *csd = per_cpu_ptr(cfd->csd, cpu);
@@ -7,6 +7,7 @@
 #include <linux/trace_events.h>
 #include <linux/ring_buffer.h>
 #include <linux/trace_clock.h>
+#include <linux/trace_pipe_mmap.h>
 #include <linux/sched/clock.h>
 #include <linux/trace_seq.h>
 #include <linux/spinlock.h>
@@ -18,6 +19,7 @@
 #include <linux/percpu.h>
 #include <linux/mutex.h>
 #include <linux/delay.h>
+#include <linux/highmem.h>
 #include <linux/slab.h>
 #include <linux/init.h>
 #include <linux/hash.h>
@@ -330,6 +332,7 @@ struct buffer_page {
 	unsigned	 read;		/* index for next read */
 	local_t		 entries;	/* entries on this page */
 	unsigned long	 real_end;	/* real end of data */
+	unsigned	 id;		/* sub-buffer id when mapped */
 	struct buffer_data_page *page;	/* Actual data page */
 };
 
@@ -498,6 +501,12 @@ struct ring_buffer_per_cpu {
 	struct completion		update_done;
 
 	struct rb_irq_work		irq_work;
+
+	/* user space mapping, see ring_buffer_map() */
+	struct mutex			mapping_lock;
+	unsigned int			mapped;
+	struct trace_pipe_meta		*meta_page;
+	struct buffer_data_page		**subbuf_ids;
 };
 
 struct ring_buffer {
@@ -1280,6 +1289,7 @@ rb_allocate_cpu_buffer(struct ring_buffer *buffer, long nr_pages, int cpu)
 	init_irq_work(&cpu_buffer->irq_work.work, rb_wake_up_waiters);
 	init_waitqueue_head(&cpu_buffer->irq_work.waiters);
 	init_waitqueue_head(&cpu_buffer->irq_work.full_waiters);
+	mutex_init(&cpu_buffer->mapping_lock);
 
 	bpage = kzalloc_node(ALIGN(sizeof(*bpage), cache_line_size()),
 			    GFP_KERNEL, cpu_to_node(cpu));
@@ -1724,6 +1734,15 @@ int ring_buffer_resize(struct ring_buffer *buffer, unsigned long size,
 	/* prevent another thread from changing buffer sizes */
 	mutex_lock(&buffer->mutex);
 
+	/* user space holds on to the sub-buffer ids of a mapped buffer */
+	for_each_buffer_cpu(buffer, cpu) {
+		if ((cpu_id == RING_BUFFER_ALL_CPUS || cpu == cpu_id) &&
+		    buffer->buffers[cpu]->mapped) {
+			mutex_unlock(&buffer->mutex);
+			return -EBUSY;
+		}
+	}
+
 	if (cpu_id == RING_BUFFER_ALL_CPUS) {
 		/* calculate the pages to update */
 		for_each_buffer_cpu(buffer, cpu) {
@@ -4482,6 +4501,11 @@ int ring_buffer_swap_cpu(struct ring_buffer *buffer_a,
 	if (cpu_buffer_a->nr_pages != cpu_buffer_b->nr_pages)
 		goto out;
 
+	ret = -EBUSY;
+
+	if (cpu_buffer_a->mapped || cpu_buffer_b->mapped)
+		goto out;
+
 	ret = -EAGAIN;
 
 	if (atomic_read(&buffer_a->record_disabled))
@@ -4701,12 +4725,14 @@ int ring_buffer_read_page(struct ring_buffer *buffer,
 	/*
 	 * If this page has been partially read or
 	 * if len is not big enough to read the rest of the page or
-	 * a writer is still on the page, then
+	 * a writer is still on the page, or
+	 * the pages are mapped into user space, then
 	 * we must copy the data from the page to the buffer.
 	 * Otherwise, we can simply swap the page with the one passed in.
 	 */
 	if (read || (len < (commit - read)) ||
-	    cpu_buffer->reader_page == cpu_buffer->commit_page) {
+	    cpu_buffer->reader_page == cpu_buffer->commit_page ||
+	    cpu_buffer->mapped) {
 		struct buffer_data_page *rpage = cpu_buffer->reader_page->page;
 		unsigned int rpos = read;
 		unsigned int pos = 0;
@@ -4815,6 +4841,226 @@ int ring_buffer_read_page(struct ring_buffer *buffer,
 }
 EXPORT_SYMBOL_GPL(ring_buffer_read_page);
 
+static void rb_update_meta_page(struct ring_buffer_per_cpu *cpu_buffer,
+				unsigned int read)
+{
+	struct trace_pipe_meta *meta = cpu_buffer->meta_page;
+	struct buffer_page *reader = cpu_buffer->reader_page;
+
+	WRITE_ONCE(meta->reader.lost_events, cpu_buffer->lost_events);
+	WRITE_ONCE(meta->reader.id, reader->id);
+	WRITE_ONCE(meta->reader.read, read);
+	WRITE_ONCE(meta->reader.commit, reader->read);
+	WRITE_ONCE(meta->entries, local_read(&cpu_buffer->entries));
+	WRITE_ONCE(meta->overrun, local_read(&cpu_buffer->overrun));
+	WRITE_ONCE(meta->read, cpu_buffer->read);
+}
+
+/**
+ * ring_buffer_map - prepare a per CPU buffer to be mapped into user space
+ * @buffer: the buffer to map
+ * @cpu: the CPU buffer to map
+ *
+ * Numbers the reader page and the ring pages so that they can be handed
+ * out through ring_buffer_map_page(), and sets up the meta page that
+ * describes them. Every call takes a reference that has to be dropped with
+ * ring_buffer_unmap(). While mapped the buffer can not be resized or
+ * swapped, and ring_buffer_read_page() copies rather than swaps pages.
+ *
+ * Returns 0 on success or a negative error.
+ */
+int ring_buffer_map(struct ring_buffer *buffer, int cpu)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+	struct buffer_data_page **subbuf_ids;
+	struct trace_pipe_meta *meta;
+	struct list_head *head, *list;
+	struct buffer_page *bpage;
+	unsigned int id;
+	int ret = 0;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return -EINVAL;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	/* buffer->mutex keeps ring_buffer_resize() out */
+	mutex_lock(&buffer->mutex);
+	mutex_lock(&cpu_buffer->mapping_lock);
+
+	if (cpu_buffer->mapped) {
+		cpu_buffer->mapped++;
+		goto out;
+	}
+
+	meta = (void *)get_zeroed_page(GFP_KERNEL);
+	subbuf_ids = kcalloc(cpu_buffer->nr_pages + 1, sizeof(*subbuf_ids),
+			     GFP_KERNEL);
+	if (!meta || !subbuf_ids) {
+		free_page((unsigned long)meta);
+		kfree(subbuf_ids);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	meta->meta_page_size = PAGE_SIZE;
+	meta->meta_struct_len = sizeof(*meta);
+	meta->subbuf_size = PAGE_SIZE;
+	meta->nr_subbufs = cpu_buffer->nr_pages + 1;
+
+	raw_spin_lock_irq(&cpu_buffer->reader_lock);
+
+	cpu_buffer->reader_page->id = 0;
+	subbuf_ids[0] = cpu_buffer->reader_page->page;
+
+	id = 1;
+	head = rb_list_head(cpu_buffer->pages);
+	list = head;
+	do {
+		bpage = list_entry(list, struct buffer_page, list);
+		bpage->id = id;
+		subbuf_ids[id++] = bpage->page;
+		list = rb_list_head(list->next);
+	} while (list != head && id <= cpu_buffer->nr_pages);
+
+	cpu_buffer->meta_page = meta;
+	cpu_buffer->subbuf_ids = subbuf_ids;
+	cpu_buffer->mapped = 1;
+	rb_update_meta_page(cpu_buffer, cpu_buffer->reader_page->read);
+
+	raw_spin_unlock_irq(&cpu_buffer->reader_lock);
+
+ out:
+	mutex_unlock(&cpu_buffer->mapping_lock);
+	mutex_unlock(&buffer->mutex);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(ring_buffer_map);
+
+/**
+ * ring_buffer_unmap - drop a reference taken by ring_buffer_map()
+ * @buffer: the mapped buffer
+ * @cpu: the mapped CPU buffer
+ */
+void ring_buffer_unmap(struct ring_buffer *buffer, int cpu)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	mutex_lock(&cpu_buffer->mapping_lock);
+
+	if (WARN_ON(!cpu_buffer->mapped))
+		goto out;
+
+	if (--cpu_buffer->mapped)
+		goto out;
+
+	free_page((unsigned long)cpu_buffer->meta_page);
+	kfree(cpu_buffer->subbuf_ids);
+	cpu_buffer->meta_page = NULL;
+	cpu_buffer->subbuf_ids = NULL;
+
+ out:
+	mutex_unlock(&cpu_buffer->mapping_lock);
+}
+EXPORT_SYMBOL_GPL(ring_buffer_unmap);
+
+/**
+ * ring_buffer_map_page - page backing an offset of a mapped buffer
+ * @buffer: the mapped buffer
+ * @cpu: the mapped CPU buffer
+ * @pgoff: page offset into the mapping
+ *
+ * Page 0 is the meta page, page n + 1 holds sub-buffer n. The caller must
+ * hold a reference from ring_buffer_map().
+ *
+ * Returns the page, or NULL if @pgoff is outside the mapping.
+ */
+struct page *ring_buffer_map_page(struct ring_buffer *buffer, int cpu,
+				  unsigned long pgoff)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return NULL;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	if (WARN_ON_ONCE(!cpu_buffer->mapped))
+		return NULL;
+
+	if (!pgoff)
+		return virt_to_page(cpu_buffer->meta_page);
+
+	if (pgoff > cpu_buffer->nr_pages + 1)
+		return NULL;
+
+	return virt_to_page(cpu_buffer->subbuf_ids[pgoff - 1]);
+}
+EXPORT_SYMBOL_GPL(ring_buffer_map_page);
+
+/**
+ * ring_buffer_map_get_reader - hand the next events to a mapped reader
+ * @buffer: the mapped buffer
+ * @cpu: the mapped CPU buffer
+ *
+ * Accounts the events handed out by the previous call as read and hands
+ * out everything committed since, on the reader page. Once the reader page
+ * has been handed out in full, it is swapped for the next page of the
+ * ring first. The meta page says which sub-buffer and which part of it
+ * were handed out.
+ *
+ * Returns 0 on success, or -ENODEV if the buffer is not mapped.
+ */
+int ring_buffer_map_get_reader(struct ring_buffer *buffer, int cpu)
+{
+	struct ring_buffer_per_cpu *cpu_buffer;
+	struct buffer_page *reader;
+	unsigned long flags;
+	unsigned int read;
+	int ret = 0;
+
+	if (!cpumask_test_cpu(cpu, buffer->cpumask))
+		return -EINVAL;
+
+	cpu_buffer = buffer->buffers[cpu];
+
+	mutex_lock(&cpu_buffer->mapping_lock);
+
+	if (!cpu_buffer->mapped) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	raw_spin_lock_irqsave(&cpu_buffer->reader_lock, flags);
+
+	/* swaps in the next page if the reader page has been consumed */
+	reader = rb_get_reader_page(cpu_buffer);
+	if (!reader)
+		reader = cpu_buffer->reader_page;
+
+	read = reader->read;
+	while (reader->read < rb_page_size(reader))
+		rb_advance_reader(cpu_buffer);
+
+	rb_update_meta_page(cpu_buffer, read);
+	cpu_buffer->lost_events = 0;
+
+	raw_spin_unlock_irqrestore(&cpu_buffer->reader_lock, flags);
+
+	/* some architectures do not keep user and kernel mappings coherent */
+	flush_dcache_page(virt_to_page(reader->page));
+
+ out:
+	mutex_unlock(&cpu_buffer->mapping_lock);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(ring_buffer_map_get_reader);
+
 /*
  * We only allocate new buffers, never free them if the CPU goes down.
  * If we were to free the buffer, then the user would lose any trace that was in
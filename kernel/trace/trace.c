@@ -42,6 +42,7 @@
 #include <linux/nmi.h>
 #include <linux/fs.h>
 #include <linux/trace.h>
+#include <linux/trace_pipe_mmap.h>
 #include <linux/sched/clock.h>
 #include <linux/sched/rt.h>
 
@@ -959,6 +960,10 @@ int tracing_alloc_snapshot_instance(struct trace_array *tr)
 
 	if (!tr->allocated_snapshot) {
 
+		/* a swap would pull the pages out from under user space */
+		if (atomic_read(&tr->mapped))
+			return -EBUSY;
+
 		/* allocate spare buffer */
 		ret = resize_buffer_duplicate_size(&tr->max_buffer,
 				   &tr->trace_buffer, RING_BUFFER_ALL_CPUS);
@@ -6990,12 +6995,115 @@ tracing_buffers_splice_read(struct file *file, loff_t *ppos,
 	return ret;
 }
 
+static long tracing_buffers_ioctl(struct file *file, unsigned int cmd,
+				  unsigned long arg)
+{
+	struct ftrace_buffer_info *info = file->private_data;
+	struct trace_iterator *iter = &info->iter;
+	int ret;
+
+	if (cmd != TRACE_PIPE_IOCTL_GET_READER)
+		return -ENOTTY;
+
+	trace_access_lock(iter->cpu_file);
+	ret = ring_buffer_map_get_reader(iter->trace_buffer->buffer,
+					 iter->cpu_file);
+	trace_access_unlock(iter->cpu_file);
+
+	return ret;
+}
+
+static void tracing_buffers_mmap_open(struct vm_area_struct *vma)
+{
+	struct ftrace_buffer_info *info = vma->vm_file->private_data;
+	struct trace_iterator *iter = &info->iter;
+
+	/* split or moved vma, the buffer is mapped already and can't fail */
+	WARN_ON(ring_buffer_map(iter->trace_buffer->buffer, iter->cpu_file));
+#ifdef CONFIG_TRACER_MAX_TRACE
+	atomic_inc(&iter->tr->mapped);
+#endif
+}
+
+static void tracing_buffers_mmap_close(struct vm_area_struct *vma)
+{
+	struct ftrace_buffer_info *info = vma->vm_file->private_data;
+	struct trace_iterator *iter = &info->iter;
+
+	ring_buffer_unmap(iter->trace_buffer->buffer, iter->cpu_file);
+#ifdef CONFIG_TRACER_MAX_TRACE
+	atomic_dec(&iter->tr->mapped);
+#endif
+}
+
+static vm_fault_t tracing_buffers_mmap_fault(struct vm_fault *vmf)
+{
+	struct ftrace_buffer_info *info = vmf->vma->vm_file->private_data;
+	struct trace_iterator *iter = &info->iter;
+	struct page *page;
+
+	page = ring_buffer_map_page(iter->trace_buffer->buffer,
+				    iter->cpu_file, vmf->pgoff);
+	if (!page)
+		return VM_FAULT_SIGBUS;
+
+	get_page(page);
+	vmf->page = page;
+	return 0;
+}
+
+static const struct vm_operations_struct tracing_buffers_vmops = {
+	.open		= tracing_buffers_mmap_open,
+	.close		= tracing_buffers_mmap_close,
+	.fault		= tracing_buffers_mmap_fault,
+};
+
+/*
+ * Map the meta page and all sub-buffers of one CPU's ring buffer read-only.
+ * Pages are faulted in on first access; TRACE_PIPE_IOCTL_GET_READER then
+ * hands out events without copying them. See <uapi/linux/trace_pipe_mmap.h>.
+ */
+static int tracing_buffers_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct ftrace_buffer_info *info = filp->private_data;
+	struct trace_iterator *iter = &info->iter;
+	int ret;
+
+	if (iter->cpu_file == RING_BUFFER_ALL_CPUS)
+		return -EINVAL;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+#ifdef CONFIG_TRACER_MAX_TRACE
+	/* update_max_tr() swaps the whole buffer with the snapshot one */
+	if (iter->tr->allocated_snapshot)
+		return -EBUSY;
+#endif
+
+	ret = ring_buffer_map(iter->trace_buffer->buffer, iter->cpu_file);
+	if (ret)
+		return ret;
+#ifdef CONFIG_TRACER_MAX_TRACE
+	atomic_inc(&iter->tr->mapped);
+#endif
+
+	vma->vm_flags |= VM_DONTCOPY | VM_DONTEXPAND | VM_DONTDUMP;
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_ops = &tracing_buffers_vmops;
+
+	return 0;
+}
+
 static const struct file_operations tracing_buffers_fops = {
 	.open		= tracing_buffers_open,
 	.read		= tracing_buffers_read,
 	.poll		= tracing_buffers_poll,
 	.release	= tracing_buffers_release,
 	.splice_read	= tracing_buffers_splice_read,
+	.unlocked_ioctl	= tracing_buffers_ioctl,
+	.compat_ioctl	= tracing_buffers_ioctl,
+	.mmap		= tracing_buffers_mmap,
 	.llseek		= no_llseek,
 };
 
@@ -48,7 +48,10 @@
 #include <linux/moduleparam.h>
 #include <linux/uaccess.h>
 #include <linux/sched/isolation.h>
+#include <linux/sched/topology.h>
 #include <linux/nmi.h>
+#include <linux/log2.h>
+#include <linux/ktime.h>
 
 #include "workqueue_internal.h"
 
@@ -258,6 +261,9 @@ struct workqueue_struct {
 #ifdef CONFIG_SYSFS
 	struct wq_device	*wq_dev;	/* I: for sysfs interface */
 #endif
+#ifdef CONFIG_WQ_LATENCY_STATS
+	struct wq_latency __percpu *latency; /* I: set by sysfs registration */
+#endif
 #ifdef CONFIG_LOCKDEP
 	struct lockdep_map	lockdep_map;
 #endif
@@ -276,6 +282,32 @@ struct workqueue_struct {
 	struct pool_workqueue __rcu *numa_pwq_tbl[]; /* PWR: unbound pwqs indexed by node */
 };
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+/*
+ * Bucket 0 holds intervals under 1us, bucket n holds [2^(n-1), 2^n) us and
+ * the last bucket everything from about one second upwards.
+ */
+#define WQ_LAT_BUCKETS		22
+
+enum wq_latency_interval {
+	WQ_LAT_QUEUE,		/* queueing to start of execution */
+	WQ_LAT_EXEC,		/* execution of the work function */
+	WQ_LAT_NUM
+};
+
+struct wq_latency_hist {
+	u64			count;
+	u64			sum_ns;
+	u64			max_ns;
+	u32			buckets[WQ_LAT_BUCKETS];
+};
+
+/* per-cpu and only updated under the local pool->lock with IRQs off */
+struct wq_latency {
+	struct wq_latency_hist	hist[WQ_LAT_NUM];
+};
+#endif
+
 static struct kmem_cache *pwq_cache;
 
 static cpumask_var_t *wq_numa_possible_cpumask;
@@ -821,6 +853,24 @@ static struct worker *first_idle_worker(struct worker_pool *pool)
 	return list_first_entry(&pool->idle_list, struct worker, entry);
 }
 
+/*
+ * Make the idle worker of @pool that last ran in @cpu's LLC the next one
+ * wake_up_worker() picks.  Unbound pools span a whole node, but the
+ * scheduler wakes a task close to where it last ran, so this keeps work
+ * queued for @cpu near the caches it has warmed up.
+ */
+static void prefer_idle_worker_near(struct worker_pool *pool, int cpu)
+{
+	struct worker *worker;
+
+	list_for_each_entry(worker, &pool->idle_list, entry) {
+		if (cpus_share_cache(task_cpu(worker->task), cpu)) {
+			list_move(&worker->entry, &pool->idle_list);
+			return;
+		}
+	}
+}
+
 /**
  * wake_up_worker - wake up an idle worker
  * @pool: worker pool to wake worker from
@@ -1277,6 +1327,67 @@ static int try_to_grab_pending(struct work_struct *work, bool is_dwork,
 	return -EAGAIN;
 }
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+static void wq_latency_stamp(struct work_struct *work)
+{
+	work->queued_ns = ktime_get_ns();
+}
+
+static void wq_latency_record(struct workqueue_struct *wq,
+			      enum wq_latency_interval interval, u64 delta)
+{
+	struct wq_latency *lat = READ_ONCE(wq->latency);
+	struct wq_latency_hist *hist;
+	u64 us = div_u64(delta, NSEC_PER_USEC);
+
+	if (!lat)
+		return;
+
+	hist = &this_cpu_ptr(lat)->hist[interval];
+	hist->count++;
+	hist->sum_ns += delta;
+	if (delta > hist->max_ns)
+		hist->max_ns = delta;
+	hist->buckets[us ? min_t(unsigned int, ilog2(us) + 1,
+				 WQ_LAT_BUCKETS - 1) : 0]++;
+}
+
+/* account the queueing delay of @work, returns 0 if @pwq keeps no stats */
+static u64 wq_latency_start(struct pool_workqueue *pwq,
+			    struct work_struct *work)
+{
+	u64 now;
+
+	if (!READ_ONCE(pwq->wq->latency))
+		return 0;
+
+	now = ktime_get_ns();
+	wq_latency_record(pwq->wq, WQ_LAT_QUEUE, now - work->queued_ns);
+	return now;
+}
+
+static u64 wq_latency_elapsed(u64 start_ns)
+{
+	return start_ns ? ktime_get_ns() - start_ns : 0;
+}
+
+static void wq_latency_finish(struct pool_workqueue *pwq, u64 exec_ns)
+{
+	if (exec_ns)
+		wq_latency_record(pwq->wq, WQ_LAT_EXEC, exec_ns);
+}
+#else
+static inline void wq_latency_stamp(struct work_struct *work) { }
+static inline u64 wq_latency_start(struct pool_workqueue *pwq,
+				   struct work_struct *work)
+{
+	return 0;
+}
+static inline u64 wq_latency_elapsed(u64 start_ns) { return 0; }
+static inline void wq_latency_finish(struct pool_workqueue *pwq,
+				     u64 exec_ns) { }
+#endif
+
 /**
  * insert_work - insert a work into a pool
  * @pwq: pwq @work belongs to
@@ -1299,6 +1410,7 @@ static void insert_work(struct pool_workqueue *pwq, struct work_struct *work,
 	set_work_pwq(work, pwq, extra_flags);
 	list_add_tail(&work->entry, head);
 	get_pwq(pwq);
+	wq_latency_stamp(work);
 
 	/*
 	 * Ensure either wq_worker_sleeping() sees the above
@@ -1460,6 +1572,9 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
 		worklist = &pwq->delayed_works;
 	}
 
+	if ((wq->flags & WQ_UNBOUND) && req_cpu != WORK_CPU_UNBOUND)
+		prefer_idle_worker_near(pwq->pool, req_cpu);
+
 	insert_work(pwq, work, worklist, work_flags);
 
 	spin_unlock(&pwq->pool->lock);
@@ -1474,6 +1589,11 @@ static void __queue_work(int cpu, struct workqueue_struct *wq,
  * We queue the work to a specific CPU, the caller must ensure it
  * can't go away.
  *
+ * For an unbound @wq, @cpu is a placement hint rather than a binding:
+ * @work goes to the pool of @cpu's node and is handed to an idle worker
+ * that last ran in @cpu's LLC if there is one, so that it executes close
+ * to data @cpu has just touched.
+ *
  * Return: %false if @work was already on a queue, %true otherwise.
  */
 bool queue_work_on(int cpu, struct workqueue_struct *wq,
@@ -2054,6 +2174,7 @@ __acquires(&pool->lock)
 	bool cpu_intensive = pwq->wq->flags & WQ_CPU_INTENSIVE;
 	int work_color;
 	struct worker *collision;
+	u64 start_ns, exec_ns;
 #ifdef CONFIG_LOCKDEP
 	/*
 	 * It is permissible to free the struct work_struct from
@@ -2097,6 +2218,7 @@ __acquires(&pool->lock)
 	strscpy(worker->desc, pwq->wq->name, WORKER_DESC_LEN);
 
 	list_del_init(&work->entry);
+	start_ns = wq_latency_start(pwq, work);
 
 	/*
 	 * CPU intensive works don't participate in concurrency management.
@@ -2153,6 +2275,7 @@ __acquires(&pool->lock)
 	lockdep_invariant_state(true);
 	trace_workqueue_execute_start(work);
 	worker->current_func(work);
+	exec_ns = wq_latency_elapsed(start_ns);
 	/*
 	 * While we must be careful to not use "work" after this, the trace
 	 * point will only record its address.
@@ -2182,6 +2305,8 @@ __acquires(&pool->lock)
 
 	spin_lock_irq(&pool->lock);
 
+	wq_latency_finish(pwq, exec_ns);
+
 	/* clear cpu intensive status */
 	if (unlikely(cpu_intensive))
 		worker_clr_flags(worker, WORKER_CPU_INTENSIVE);
@@ -3335,6 +3460,9 @@ static void rcu_free_wq(struct rcu_head *rcu)
 	else
 		free_workqueue_attrs(wq->unbound_attrs);
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+	free_percpu(wq->latency);
+#endif
 	kfree(wq->rescuer);
 	kfree(wq);
 }
@@ -5152,6 +5280,11 @@ int workqueue_set_unbound_cpumask(cpumask_var_t cpumask)
  *  per_cpu	RO bool	: whether the workqueue is per-cpu or unbound
  *  max_active	RW int	: maximum number of in-flight work items
  *
+ * With CONFIG_WQ_LATENCY_STATS they also have these, writing clears them.
+ *
+ *  queue_latency RW	: histogram of queueing to start of execution
+ *  exec_time	RW	: histogram of work function execution time
+ *
  * Unbound workqueues have the following extra attributes.
  *
  *  pool_ids	RO int	: the associated pool IDs for each node
@@ -5203,9 +5336,96 @@ static ssize_t max_active_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(max_active);
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+static ssize_t wq_latency_show(struct workqueue_struct *wq,
+			       enum wq_latency_interval interval, char *buf)
+{
+	struct wq_latency_hist sum = { };
+	int cpu, i, written;
+
+	if (!wq->latency)
+		return -ENODEV;
+
+	for_each_possible_cpu(cpu) {
+		struct wq_latency_hist *hist =
+			&per_cpu_ptr(wq->latency, cpu)->hist[interval];
+
+		sum.count += hist->count;
+		sum.sum_ns += hist->sum_ns;
+		sum.max_ns = max(sum.max_ns, hist->max_ns);
+		for (i = 0; i < WQ_LAT_BUCKETS; i++)
+			sum.buckets[i] += hist->buckets[i];
+	}
+
+	written = scnprintf(buf, PAGE_SIZE, "count %llu", sum.count);
+	if (sum.count)
+		written += scnprintf(buf + written, PAGE_SIZE - written,
+				     ", avg %llu us, max %llu us",
+				     div64_u64(sum.sum_ns,
+					       sum.count * NSEC_PER_USEC),
+				     div_u64(sum.max_ns, NSEC_PER_USEC));
+	written += scnprintf(buf + written, PAGE_SIZE - written, "\n");
+
+	for (i = 0; i < WQ_LAT_BUCKETS; i++)
+		written += scnprintf(buf + written, PAGE_SIZE - written,
+				     "  >= %8lu us: %u\n",
+				     i ? 1UL << (i - 1) : 0UL, sum.buckets[i]);
+
+	return written;
+}
+
+/* any write clears the histograms, updates racing with it may survive */
+static ssize_t wq_latency_reset(struct workqueue_struct *wq,
+				enum wq_latency_interval interval, size_t count)
+{
+	int cpu;
+
+	if (!wq->latency)
+		return -ENODEV;
+
+	for_each_possible_cpu(cpu)
+		memset(&per_cpu_ptr(wq->latency, cpu)->hist[interval], 0,
+		       sizeof(struct wq_latency_hist));
+
+	return count;
+}
+
+static ssize_t queue_latency_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	return wq_latency_show(dev_to_wq(dev), WQ_LAT_QUEUE, buf);
+}
+
+static ssize_t queue_latency_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	return wq_latency_reset(dev_to_wq(dev), WQ_LAT_QUEUE, count);
+}
+static DEVICE_ATTR_RW(queue_latency);
+
+static ssize_t exec_time_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	return wq_latency_show(dev_to_wq(dev), WQ_LAT_EXEC, buf);
+}
+
+static ssize_t exec_time_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	return wq_latency_reset(dev_to_wq(dev), WQ_LAT_EXEC, count);
+}
+static DEVICE_ATTR_RW(exec_time);
+#endif
+
 static struct attribute *wq_sysfs_attrs[] = {
 	&dev_attr_per_cpu.attr,
 	&dev_attr_max_active.attr,
+#ifdef CONFIG_WQ_LATENCY_STATS
+	&dev_attr_queue_latency.attr,
+	&dev_attr_exec_time.attr,
+#endif
 	NULL,
 };
 ATTRIBUTE_GROUPS(wq_sysfs);
@@ -5457,6 +5677,17 @@ int workqueue_sysfs_register(struct workqueue_struct *wq)
 	if (!wq_dev)
 		return -ENOMEM;
 
+#ifdef CONFIG_WQ_LATENCY_STATS
+	/*
+	 * Freed with @wq as work items may still be recording into it.
+	 * Publish it only once zeroed, wq_latency_record() may run as soon
+	 * as the pointer is visible.
+	 */
+	if (!wq->latency)
+		smp_store_release(&wq->latency,
+				  alloc_percpu(struct wq_latency));
+#endif
+
 	wq_dev->wq = wq;
 	wq_dev->dev.bus = &wq_subsys;
 	wq_dev->dev.release = wq_device_release;
@@ -1199,6 +1199,58 @@ static ssize_t pipe_get_pages(struct iov_iter *i,
 	return __pipe_get_pages(i, min(maxsize, capacity), pages, idx, start);
 }
 
+/*
+ * Pin user pages for as many iovec segments as line up into one run of
+ * whole pages: every segment after the first must start on a page boundary
+ * and every segment before the last must end on one.  Page aligned
+ * O_DIRECT writev()/readv() then fills a bio with a single
+ * get_user_pages_fast() call per segment instead of one trip through
+ * iov_iter_get_pages() each.
+ */
+static ssize_t iovec_get_pages(struct iov_iter *i,
+		   struct page **pages, size_t maxsize, unsigned maxpages,
+		   size_t *start)
+{
+	const struct iovec *iov = i->iov;
+	size_t skip = i->iov_offset;
+	int write = (i->type & WRITE) != WRITE;
+	ssize_t total = 0;
+
+	for (; maxsize && maxpages; iov++, skip = 0) {
+		unsigned long addr = (unsigned long)iov->iov_base + skip;
+		size_t offset = addr & (PAGE_SIZE - 1);
+		size_t len = min(iov->iov_len - skip, maxsize);
+		int n, res;
+
+		if (!len)
+			continue;
+		if (total && offset)
+			break;
+		if (!total)
+			*start = offset;
+
+		len += offset;
+		if (len > maxpages * PAGE_SIZE)
+			len = maxpages * PAGE_SIZE;
+		n = DIV_ROUND_UP(len, PAGE_SIZE);
+		res = get_user_pages_fast(addr - offset, n, write, pages);
+		if (unlikely(res < 0))
+			return total ? total : res;
+
+		if (res < n)
+			return total + res * PAGE_SIZE - offset;
+		total += len - offset;
+		if (len & (PAGE_SIZE - 1))
+			break;
+
+		pages += n;
+		maxpages -= n;
+		maxsize -= len - offset;
+	}
+
+	return total;
+}
+
 ssize_t iov_iter_get_pages(struct iov_iter *i,
 		   struct page **pages, size_t maxsize, unsigned maxpages,
 		   size_t *start)
@@ -1208,6 +1260,8 @@ ssize_t iov_iter_get_pages(struct iov_iter *i,
 
 	if (unlikely(i->type & ITER_PIPE))
 		return pipe_get_pages(i, pages, maxsize, maxpages, start);
+	if (!(i->type & (ITER_BVEC | ITER_KVEC)))
+		return iovec_get_pages(i, pages, maxsize, maxpages, start);
 	iterate_all_kinds(i, maxsize, v, ({
 		unsigned long addr = (unsigned long)v.iov_base;
 		size_t len = v.iov_len + (*start = addr & (PAGE_SIZE - 1));
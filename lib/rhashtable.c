@@ -397,6 +397,24 @@ static int rhashtable_shrink(struct rhashtable *ht)
 	return rhashtable_rehash_alloc(ht, old_tbl, size);
 }
 
+/*
+ * Normally a doubling, but a big rhashtable_insert_batch() may need more
+ * than that to stay below 75% once all of it is in.
+ */
+static unsigned int rht_grow_size(struct rhashtable *ht,
+				  struct bucket_table *tbl)
+{
+	unsigned int want = atomic_read(&ht->nelems) +
+			    atomic_read(&ht->nreserved);
+	unsigned int size = tbl->size * 2;
+
+	while (want > size / 4 * 3 && size < (1U << 31) &&
+	       (!ht->p.max_size || size < ht->p.max_size))
+		size *= 2;
+
+	return size;
+}
+
 static void rht_deferred_worker(struct work_struct *work)
 {
 	struct rhashtable *ht;
@@ -410,7 +428,7 @@ static void rht_deferred_worker(struct work_struct *work)
 	tbl = rhashtable_last_table(ht, tbl);
 
 	if (rht_grow_above_75(ht, tbl))
-		err = rhashtable_rehash_alloc(ht, tbl, tbl->size * 2);
+		err = rhashtable_rehash_alloc(ht, tbl, rht_grow_size(ht, tbl));
 	else if (ht->p.automatic_shrinking && rht_shrink_below_30(ht, tbl))
 		err = rhashtable_shrink(ht);
 	else if (tbl->nest)
@@ -6659,6 +6659,39 @@ static void release_filter(struct bpf_prog *fp, int which)
 	}
 }
 
+/*
+ * Load a copy of an already JIT'ed program's eBPF instructions with the JIT
+ * turned off, so that both can be timed against the same test data.
+ */
+static struct bpf_prog *generate_interp(const struct bpf_prog *jited)
+{
+	struct bpf_prog *fp;
+	int err;
+
+	/* A classic JIT leaves the classic instructions behind, not eBPF */
+	if (IS_ENABLED(CONFIG_HAVE_CBPF_JIT))
+		return NULL;
+
+	fp = bpf_prog_alloc(bpf_prog_size(jited->len), 0);
+	if (fp == NULL)
+		return NULL;
+
+	fp->len = jited->len;
+	fp->type = BPF_PROG_TYPE_SOCKET_FILTER;
+	memcpy(fp->insnsi, jited->insnsi, fp->len * sizeof(struct bpf_insn));
+	fp->aux->stack_depth = jited->aux->stack_depth;
+	fp->jit_requested = 0;
+
+	/* Fails under CONFIG_BPF_JIT_ALWAYS_ON, there is no interpreter */
+	fp = bpf_prog_select_runtime(fp, &err);
+	if (err) {
+		bpf_prog_free(fp);
+		return NULL;
+	}
+
+	return fp;
+}
+
 static int __run_one(const struct bpf_prog *fp, const void *data,
 		     int runs, u64 *duration)
 {
@@ -6721,6 +6754,9 @@ module_param(test_id, int, 0);
 static int test_range[2] = { 0, ARRAY_SIZE(tests) - 1 };
 module_param_array(test_range, int, NULL, 0);
 
+static bool bench_interp;
+module_param(bench_interp, bool, 0);
+
 static __init int find_test_index(const char *test_name)
 {
 	int i;
@@ -6922,6 +6958,15 @@ static __init int test_bpf(void)
 			jit_cnt++;
 
 		err = run_one(fp, &tests[i]);
+		if (!err && bench_interp && fp->jited) {
+			struct bpf_prog *interp = generate_interp(fp);
+
+			if (interp) {
+				pr_cont("interp: ");
+				err = run_one(interp, &tests[i]);
+				bpf_prog_free(interp);
+			}
+		}
 		release_filter(fp, i);
 
 		if (err) {
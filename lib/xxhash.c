@@ -46,6 +46,15 @@
 #include <linux/string.h>
 #include <linux/xxhash.h>
 
+#if IS_ENABLED(CONFIG_XXHASH_NEON)
+#include <linux/jump_label.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+#include "xxhash_neon.h"
+#endif
+
 /*-*************************************
  * Macros
  **************************************/
@@ -99,6 +108,50 @@ static uint32_t xxh32_round(uint32_t seed, const uint32_t input)
 	return seed;
 }
 
+#if IS_ENABLED(CONFIG_XXHASH_NEON)
+/*
+ * Below this much input the cost of kernel_neon_begin() eats the gain. Only
+ * enabled once xxh32_neon_init() has checked the NEON loop gives the same
+ * digests and is actually the faster one on this cpu.
+ */
+#define XXH32_NEON_MIN_LEN 256
+
+static DEFINE_STATIC_KEY_FALSE(xxh32_use_neon);
+#endif
+
+/* Run the four accumulators over the 16-byte stripes in [p, limit] */
+static const uint8_t *xxh32_generic_stripes(uint32_t v[4], const uint8_t *p,
+					    const uint8_t *const limit)
+{
+	do {
+		v[0] = xxh32_round(v[0], get_unaligned_le32(p));
+		p += 4;
+		v[1] = xxh32_round(v[1], get_unaligned_le32(p));
+		p += 4;
+		v[2] = xxh32_round(v[2], get_unaligned_le32(p));
+		p += 4;
+		v[3] = xxh32_round(v[3], get_unaligned_le32(p));
+		p += 4;
+	} while (p <= limit);
+
+	return p;
+}
+
+static const uint8_t *xxh32_stripes(uint32_t v[4], const uint8_t *p,
+				    const uint8_t *const limit)
+{
+#if IS_ENABLED(CONFIG_XXHASH_NEON)
+	if (static_branch_likely(&xxh32_use_neon) &&
+	    limit - p >= XXH32_NEON_MIN_LEN && may_use_simd()) {
+		kernel_neon_begin();
+		p = xxh32_neon_stripes(v, p, limit);
+		kernel_neon_end();
+		return p;
+	}
+#endif
+	return xxh32_generic_stripes(v, p, limit);
+}
+
 uint32_t xxh32(const void *input, const size_t len, const uint32_t seed)
 {
 	const uint8_t *p = (const uint8_t *)input;
@@ -106,25 +159,17 @@ uint32_t xxh32(const void *input, const size_t len, const uint32_t seed)
 	uint32_t h32;
 
 	if (len >= 16) {
-		const uint8_t *const limit = b_end - 16;
-		uint32_t v1 = seed + PRIME32_1 + PRIME32_2;
-		uint32_t v2 = seed + PRIME32_2;
-		uint32_t v3 = seed + 0;
-		uint32_t v4 = seed - PRIME32_1;
+		uint32_t v[4] = {
+			seed + PRIME32_1 + PRIME32_2,
+			seed + PRIME32_2,
+			seed + 0,
+			seed - PRIME32_1,
+		};
 
-		do {
-			v1 = xxh32_round(v1, get_unaligned_le32(p));
-			p += 4;
-			v2 = xxh32_round(v2, get_unaligned_le32(p));
-			p += 4;
-			v3 = xxh32_round(v3, get_unaligned_le32(p));
-			p += 4;
-			v4 = xxh32_round(v4, get_unaligned_le32(p));
-			p += 4;
-		} while (p <= limit);
+		p = xxh32_stripes(v, p, b_end - 16);
 
-		h32 = xxh_rotl32(v1, 1) + xxh_rotl32(v2, 7) +
-			xxh_rotl32(v3, 12) + xxh_rotl32(v4, 18);
+		h32 = xxh_rotl32(v[0], 1) + xxh_rotl32(v[1], 7) +
+			xxh_rotl32(v[2], 12) + xxh_rotl32(v[3], 18);
 	} else {
 		h32 = seed + PRIME32_5;
 	}
@@ -304,27 +349,14 @@ int xxh32_update(struct xxh32_state *state, const void *input, const size_t len)
 	}
 
 	if (p <= b_end - 16) {
-		const uint8_t *const limit = b_end - 16;
-		uint32_t v1 = state->v1;
-		uint32_t v2 = state->v2;
-		uint32_t v3 = state->v3;
-		uint32_t v4 = state->v4;
+		uint32_t v[4] = { state->v1, state->v2, state->v3, state->v4 };
 
-		do {
-			v1 = xxh32_round(v1, get_unaligned_le32(p));
-			p += 4;
-			v2 = xxh32_round(v2, get_unaligned_le32(p));
-			p += 4;
-			v3 = xxh32_round(v3, get_unaligned_le32(p));
-			p += 4;
-			v4 = xxh32_round(v4, get_unaligned_le32(p));
-			p += 4;
-		} while (p <= limit);
+		p = xxh32_stripes(v, p, b_end - 16);
 
-		state->v1 = v1;
-		state->v2 = v2;
-		state->v3 = v3;
-		state->v4 = v4;
+		state->v1 = v[0];
+		state->v2 = v[1];
+		state->v3 = v[2];
+		state->v4 = v[3];
 	}
 
 	if (p < b_end) {
@@ -496,5 +528,87 @@ uint64_t xxh64_digest(const struct xxh64_state *state)
 }
 EXPORT_SYMBOL(xxh64_digest);
 
+#if IS_ENABLED(CONFIG_XXHASH_NEON)
+static u64 __init xxh32_bench(const u8 *buf, bool neon)
+{
+	u32 v[4] = { 0, 0, 0, 0 };
+	u64 start = ktime_get_ns();
+	int i;
+
+	for (i = 0; i < 64; i++) {
+		if (neon) {
+			kernel_neon_begin();
+			xxh32_neon_stripes(v, buf, buf + PAGE_SIZE - 16);
+			kernel_neon_end();
+		} else {
+			xxh32_generic_stripes(v, buf, buf + PAGE_SIZE - 16);
+		}
+	}
+	return ktime_get_ns() - start;
+}
+
+/* Both stripe loops must agree for every alignment and stripe count */
+static bool __init xxh32_neon_selftest(const u8 *buf)
+{
+	u32 want[4], got[4];
+	const u8 *want_end, *got_end;
+	int off, len;
+
+	for (off = 0; off < 4; off++) {
+		for (len = 16; len <= 512; len += 16 + off) {
+			want[0] = got[0] = PRIME32_1;
+			want[1] = got[1] = PRIME32_2;
+			want[2] = got[2] = off;
+			want[3] = got[3] = -PRIME32_1;
+
+			want_end = xxh32_generic_stripes(want, buf + off,
+							 buf + off + len - 16);
+			kernel_neon_begin();
+			got_end = xxh32_neon_stripes(got, buf + off,
+						     buf + off + len - 16);
+			kernel_neon_end();
+
+			if (got_end != want_end ||
+			    memcmp(got, want, sizeof(got)))
+				return false;
+		}
+	}
+	return true;
+}
+
+static int __init xxh32_neon_init(void)
+{
+	u64 generic_ns, neon_ns;
+	u8 *buf;
+	int i;
+
+	if (!cpu_has_neon())
+		return 0;
+
+	buf = kmalloc(PAGE_SIZE + 4, GFP_KERNEL);
+	if (!buf)
+		return 0;
+	for (i = 0; i < PAGE_SIZE + 4; i++)
+		buf[i] = (i * PRIME32_1) >> 24;
+
+	if (!xxh32_neon_selftest(buf)) {
+		pr_warn("xxhash: NEON xxh32 gives wrong digests, not used\n");
+		goto out;
+	}
+
+	generic_ns = xxh32_bench(buf, false);
+	neon_ns = xxh32_bench(buf, true);
+	if (neon_ns < generic_ns)
+		static_branch_enable(&xxh32_use_neon);
+
+	pr_info("xxhash: xxh32 generic %llu ns, neon %llu ns per 256KiB, using %s\n",
+		generic_ns, neon_ns, neon_ns < generic_ns ? "neon" : "generic");
+out:
+	kfree(buf);
+	return 0;
+}
+module_init(xxh32_neon_init);
+#endif
+
 MODULE_LICENSE("Dual BSD/GPL");
 MODULE_DESCRIPTION("xxHash");
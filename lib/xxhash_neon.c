@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * NEON version of the xxh32() stripe loop
+ *
+ * The four xxh32 accumulators never mix until the final digest, so they
+ * are kept in the four lanes of one quad register and each 16 byte stripe
+ * is a single load, multiply-accumulate, rotate and multiply.
+ *
+ * Must be called between kernel_neon_begin() and kernel_neon_end(). Only
+ * built little endian, where a stripe loaded as four u32 lanes already
+ * holds the little endian words xxh32 is defined on.
+ *
+ * Like the NEON code in lib/raid6 this is built freestanding and must not
+ * include kernel headers: <linux/types.h> and the compiler's <stdint.h>
+ * disagree on uint64_t on arm64. It is linked into libxxhash with xxhash.c,
+ * which carries the module information.
+ */
+
+#include <arm_neon.h>
+
+#include "xxhash_neon.h"
+
+#define PRIME32_1	2654435761U
+#define PRIME32_2	2246822519U
+
+const uint8_t *xxh32_neon_stripes(uint32_t v[4], const uint8_t *p,
+				  const uint8_t *limit)
+{
+	uint32x4_t acc = vld1q_u32(v);
+
+	do {
+		uint32x4_t in = vreinterpretq_u32_u8(vld1q_u8(p));
+
+		acc = vmlaq_n_u32(acc, in, PRIME32_2);
+		acc = vsriq_n_u32(vshlq_n_u32(acc, 13), acc, 19);
+		acc = vmulq_n_u32(acc, PRIME32_1);
+		p += 16;
+	} while (p <= limit);
+
+	vst1q_u32(v, acc);
+	return p;
+}
@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LIB_XXHASH_NEON_H
+#define _LIB_XXHASH_NEON_H
+
+/*
+ * Shared with the freestanding xxhash_neon.c, so no kernel headers here:
+ * the includer provides uint8_t and uint32_t.
+ */
+const uint8_t *xxh32_neon_stripes(uint32_t v[4], const uint8_t *p,
+				  const uint8_t *limit);
+
+#endif /* _LIB_XXHASH_NEON_H */
@@ -210,6 +210,84 @@ static ssize_t max_ratio_store(struct device *dev,
 }
 BDI_SHOW(max_ratio, bdi->max_ratio)
 
+static ssize_t latency_target_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int target;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &target);
+	if (ret < 0)
+		return ret;
+
+	WRITE_ONCE(bdi->latency_target_ms, target);
+
+	return count;
+}
+BDI_SHOW(latency_target_ms, bdi->latency_target_ms)
+
+static ssize_t read_ahead_adaptive_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	bool adaptive;
+	ssize_t ret;
+
+	ret = kstrtobool(buf, &adaptive);
+	if (ret < 0)
+		return ret;
+
+	WRITE_ONCE(bdi->ra_adaptive, adaptive);
+
+	return count;
+}
+BDI_SHOW(read_ahead_adaptive, bdi->ra_adaptive)
+
+static ssize_t read_ahead_stats_show(struct device *dev,
+				     struct device_attribute *attr,
+				     char *page)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return snprintf(page, PAGE_SIZE-1, "hit_kb %lu\nmiss_kb %lu\n",
+			K(atomic_long_read(&bdi->ra_hit_pages)),
+			K(atomic_long_read(&bdi->ra_miss_pages)));
+}
+static DEVICE_ATTR_RO(read_ahead_stats);
+
+static ssize_t writeback_workers_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int workers;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &workers);
+	if (ret < 0)
+		return ret;
+
+	if (!workers || workers > BDI_MAX_WRITEBACK_WORKERS)
+		return -EINVAL;
+
+	WRITE_ONCE(bdi->writeback_workers, workers);
+
+	return count;
+}
+BDI_SHOW(writeback_workers, bdi->writeback_workers)
+
+static ssize_t writeback_stats_show(struct device *dev,
+				    struct device_attribute *attr,
+				    char *page)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return snprintf(page, PAGE_SIZE-1, "helper_runs %lu\nhelper_kb %lu\n",
+			atomic_long_read(&bdi->wb_helper_runs),
+			K(atomic_long_read(&bdi->wb_helper_pages)));
+}
+static DEVICE_ATTR_RO(writeback_stats);
+
 static ssize_t stable_pages_required_show(struct device *dev,
 					  struct device_attribute *attr,
 					  char *page)
@@ -223,8 +301,13 @@ static DEVICE_ATTR_RO(stable_pages_required);
 
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
+	&dev_attr_read_ahead_adaptive.attr,
+	&dev_attr_read_ahead_stats.attr,
 	&dev_attr_min_ratio.attr,
 	&dev_attr_max_ratio.attr,
+	&dev_attr_latency_target_ms.attr,
+	&dev_attr_writeback_workers.attr,
+	&dev_attr_writeback_stats.attr,
 	&dev_attr_stable_pages_required.attr,
 	NULL,
 };
@@ -312,6 +395,7 @@ static int wb_init(struct bdi_writeback *wb, struct backing_dev_info *bdi,
 	wb->dirty_ratelimit = INIT_BW;
 	wb->write_bandwidth = INIT_BW;
 	wb->avg_write_bandwidth = INIT_BW;
+	wb->avg_write_latency = 0;
 
 	spin_lock_init(&wb->work_lock);
 	INIT_LIST_HEAD(&wb->work_list);
@@ -846,6 +930,9 @@ static int bdi_init(struct backing_dev_info *bdi)
 	bdi->min_ratio = 0;
 	bdi->max_ratio = 100;
 	bdi->max_prop_frac = FPROP_FRAC_BASE;
+	bdi->latency_target_ms = 0;
+	bdi->ra_adaptive = true;
+	bdi->writeback_workers = 1;
 	INIT_LIST_HEAD(&bdi->bdi_list);
 	INIT_LIST_HEAD(&bdi->wb_list);
 	init_waitqueue_head(&bdi->wb_waitq);
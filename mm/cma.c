@@ -36,6 +36,7 @@
 #include <linux/highmem.h>
 #include <linux/io.h>
 #include <linux/kmemleak.h>
+#include <linux/ktime.h>
 #include <trace/events/cma.h>
 
 #include "cma.h"
@@ -137,6 +138,7 @@ static int __init cma_activate_area(struct cma *cma)
 #ifdef CONFIG_CMA_DEBUGFS
 	INIT_HLIST_HEAD(&cma->mem_head);
 	spin_lock_init(&cma->mem_head_lock);
+	spin_lock_init(&cma->stats_lock);
 #endif
 
 	return 0;
@@ -428,7 +430,9 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
 	unsigned long start = 0;
 	unsigned long bitmap_maxno, bitmap_no, bitmap_count;
 	struct page *page = NULL;
+	unsigned int busy = 0;
 	int ret = -ENOMEM;
+	u64 start_ns;
 
 	if (!cma || !cma->count)
 		return NULL;
@@ -447,6 +451,7 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
 	if (bitmap_count > bitmap_maxno)
 		return NULL;
 
+	start_ns = ktime_get_ns();
 	for (;;) {
 		mutex_lock(&cma->lock);
 		bitmap_no = bitmap_find_next_zero_area_off(cma->bitmap,
@@ -478,6 +483,7 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
 		if (ret != -EBUSY)
 			break;
 
+		busy++;
 		pr_debug("%s(): memory range at %p is busy, retrying\n",
 			 __func__, pfn_to_page(pfn));
 		/* try again with a bit different memory target */
@@ -485,6 +491,7 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align,
 	}
 
 	trace_cma_alloc(pfn, page, count, align);
+	cma_debug_account_alloc(cma, ktime_get_ns() - start_ns, busy, ret);
 
 	if (ret && !no_warn) {
 		pr_err("%s: alloc failed, req-size: %zu pages, ret: %d\n",
@@ -2,6 +2,30 @@
 #ifndef __MM_CMA_H__
 #define __MM_CMA_H__
 
+/*
+ * cma_alloc() latency: bucket 0 is under 1ms, bucket n is [2^(n-1), 2^n)
+ * ms and the last bucket everything from about two seconds up.
+ */
+#define CMA_LAT_BUCKETS		12
+/* busy ranges skipped before success: 0, 1, 2-3, 4-7, 8-15, 16+ */
+#define CMA_BUSY_BUCKETS	6
+
+enum cma_alloc_result {
+	CMA_ALLOC_OK,
+	CMA_ALLOC_BUSY,		/* every candidate range failed to migrate */
+	CMA_ALLOC_NOMEM,
+	CMA_ALLOC_INTR,
+	CMA_ALLOC_OTHER,
+	CMA_ALLOC_NR_RESULTS
+};
+
+struct cma_alloc_stats {
+	unsigned long latency[CMA_LAT_BUCKETS];
+	unsigned long busy[CMA_BUSY_BUCKETS];
+	unsigned long result[CMA_ALLOC_NR_RESULTS];
+	u64 max_ns;
+};
+
 struct cma {
 	unsigned long   base_pfn;
 	unsigned long   count;
@@ -11,6 +35,8 @@ struct cma {
 #ifdef CONFIG_CMA_DEBUGFS
 	struct hlist_head mem_head;
 	spinlock_t mem_head_lock;
+	spinlock_t stats_lock;
+	struct cma_alloc_stats stats;
 #endif
 	const char *name;
 };
@@ -23,4 +49,14 @@ static inline unsigned long cma_bitmap_maxno(struct cma *cma)
 	return cma->count >> cma->order_per_bit;
 }
 
+#ifdef CONFIG_CMA_DEBUGFS
+void cma_debug_account_alloc(struct cma *cma, u64 ns, unsigned int busy,
+			     int ret);
+#else
+static inline void cma_debug_account_alloc(struct cma *cma, u64 ns,
+					   unsigned int busy, int ret)
+{
+}
+#endif
+
 #endif
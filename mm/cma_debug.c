@@ -12,6 +12,8 @@
 #include <linux/kernel.h>
 #include <linux/slab.h>
 #include <linux/mm_types.h>
+#include <linux/log2.h>
+#include <linux/seq_file.h>
 
 #include "cma.h"
 
@@ -70,6 +72,109 @@ static int cma_maxchunk_get(void *data, u64 *val)
 }
 DEFINE_SIMPLE_ATTRIBUTE(cma_maxchunk_fops, cma_maxchunk_get, NULL, "%llu\n");
 
+void cma_debug_account_alloc(struct cma *cma, u64 ns, unsigned int busy,
+			     int ret)
+{
+	struct cma_alloc_stats *stats = &cma->stats;
+	u64 ms = div_u64(ns, NSEC_PER_MSEC);
+	unsigned int lat, result;
+
+	lat = ms ? min_t(unsigned int, ilog2(ms) + 1, CMA_LAT_BUCKETS - 1) : 0;
+	busy = busy ? min_t(unsigned int, ilog2(busy) + 1,
+			    CMA_BUSY_BUCKETS - 1) : 0;
+
+	switch (ret) {
+	case 0:
+		result = CMA_ALLOC_OK;
+		break;
+	case -EBUSY:
+		result = CMA_ALLOC_BUSY;
+		break;
+	case -ENOMEM:
+		result = CMA_ALLOC_NOMEM;
+		break;
+	case -EINTR:
+		result = CMA_ALLOC_INTR;
+		break;
+	default:
+		result = CMA_ALLOC_OTHER;
+		break;
+	}
+
+	spin_lock(&cma->stats_lock);
+	stats->latency[lat]++;
+	stats->busy[busy]++;
+	stats->result[result]++;
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+	spin_unlock(&cma->stats_lock);
+}
+
+static const char * const cma_alloc_result_names[CMA_ALLOC_NR_RESULTS] = {
+	[CMA_ALLOC_OK]		= "ok",
+	[CMA_ALLOC_BUSY]	= "busy",
+	[CMA_ALLOC_NOMEM]	= "nomem",
+	[CMA_ALLOC_INTR]	= "intr",
+	[CMA_ALLOC_OTHER]	= "other",
+};
+
+static int cma_alloc_stats_show(struct seq_file *m, void *v)
+{
+	struct cma *cma = m->private;
+	struct cma_alloc_stats stats;
+	int i;
+
+	spin_lock(&cma->stats_lock);
+	stats = cma->stats;
+	spin_unlock(&cma->stats_lock);
+
+	seq_puts(m, "result:");
+	for (i = 0; i < CMA_ALLOC_NR_RESULTS; i++)
+		seq_printf(m, " %s %lu", cma_alloc_result_names[i],
+			   stats.result[i]);
+	seq_printf(m, "\nmax latency: %llu us\n",
+		   div_u64(stats.max_ns, NSEC_PER_USEC));
+
+	seq_puts(m, "latency:\n");
+	for (i = 0; i < CMA_LAT_BUCKETS; i++)
+		seq_printf(m, "  >= %5lu ms: %lu\n",
+			   i ? 1UL << (i - 1) : 0UL, stats.latency[i]);
+
+	seq_puts(m, "busy ranges:\n");
+	for (i = 0; i < CMA_BUSY_BUCKETS; i++)
+		seq_printf(m, "  >= %5lu: %lu\n",
+			   i ? 1UL << (i - 1) : 0UL, stats.busy[i]);
+
+	return 0;
+}
+
+static int cma_alloc_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cma_alloc_stats_show, inode->i_private);
+}
+
+static ssize_t cma_alloc_stats_reset(struct file *file,
+				     const char __user *buf,
+				     size_t count, loff_t *ppos)
+{
+	struct cma *cma = ((struct seq_file *)file->private_data)->private;
+
+	spin_lock(&cma->stats_lock);
+	memset(&cma->stats, 0, sizeof(cma->stats));
+	spin_unlock(&cma->stats_lock);
+
+	return count;
+}
+
+/* reading shows the histograms, any write clears them */
+static const struct file_operations cma_alloc_stats_fops = {
+	.open = cma_alloc_stats_open,
+	.read = seq_read,
+	.write = cma_alloc_stats_reset,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void cma_add_to_cma_mem_list(struct cma *cma, struct cma_mem *mem)
 {
 	spin_lock(&cma->mem_head_lock);
@@ -181,6 +286,8 @@ static void cma_debugfs_add_one(struct cma *cma, int idx)
 			    &cma->order_per_bit, &cma_debugfs_fops);
 	debugfs_create_file("used", 0444, tmp, cma, &cma_used_fops);
 	debugfs_create_file("maxchunk", 0444, tmp, cma, &cma_maxchunk_fops);
+	debugfs_create_file("alloc_stats", 0644, tmp, cma,
+			    &cma_alloc_stats_fops);
 
 	u32s = DIV_ROUND_UP(cma_bitmap_maxno(cma), BITS_PER_BYTE * sizeof(u32));
 	debugfs_create_u32_array("bitmap", 0444, tmp, (u32 *)cma->bitmap, u32s);
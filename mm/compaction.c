@@ -22,6 +22,7 @@
 #include <linux/kthread.h>
 #include <linux/freezer.h>
 #include <linux/page_owner.h>
+#include <linux/hugetlb.h>
 #include "internal.h"
 
 #ifdef CONFIG_COMPACTION
@@ -1309,6 +1310,76 @@ static inline bool is_via_compact_memory(int order)
 	return order == -1;
 }
 
+/*
+ * Proactive compaction keeps the free memory of each node in blocks of this
+ * order, the size THP and most hugetlb users want.
+ */
+#if defined CONFIG_TRANSPARENT_HUGEPAGE
+#define COMPACTION_HPAGE_ORDER	HPAGE_PMD_ORDER
+#elif defined CONFIG_HUGETLBFS
+#define COMPACTION_HPAGE_ORDER	HUGETLB_PAGE_ORDER
+#else
+#define COMPACTION_HPAGE_ORDER	(PMD_SHIFT - PAGE_SHIFT)
+#endif
+
+/* How often kcompactd rechecks the fragmentation score of its node */
+#define HPAGE_FRAG_CHECK_INTERVAL_MSEC	500
+
+/*
+ * vm.compaction_proactiveness: 0 disables proactive compaction, higher
+ * values lower the fragmentation score kcompactd aims for.
+ */
+int sysctl_compaction_proactiveness = 20;
+
+/*
+ * The fragmentation score of a zone is extfrag_for_order() weighted by
+ * the zone's share of the node, so that a small, badly fragmented zone
+ * does not keep kcompactd busy. A node's score is the sum over its zones.
+ */
+static unsigned int fragmentation_score_zone(struct zone *zone)
+{
+	unsigned long score;
+
+	score = zone->present_pages *
+			extfrag_for_order(zone, COMPACTION_HPAGE_ORDER);
+	return div64_ul(score, zone->zone_pgdat->node_present_pages + 1);
+}
+
+static unsigned int fragmentation_score_node(pg_data_t *pgdat)
+{
+	unsigned int score = 0;
+	int zoneid;
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		struct zone *zone = &pgdat->node_zones[zoneid];
+
+		score += fragmentation_score_zone(zone);
+	}
+
+	return score;
+}
+
+/*
+ * kcompactd starts once a node's score goes above the high mark and stops
+ * once it is back under the low one.
+ */
+static unsigned int fragmentation_score_wmark(bool low)
+{
+	unsigned int wmark_low;
+
+	wmark_low = max(100U - sysctl_compaction_proactiveness, 5U);
+	return low ? wmark_low : min(wmark_low + 10, 100U);
+}
+
+static bool should_proactive_compact_node(pg_data_t *pgdat)
+{
+	if (!sysctl_compaction_proactiveness)
+		return false;
+
+	return fragmentation_score_node(pgdat) >
+		fragmentation_score_wmark(false);
+}
+
 static enum compact_result __compact_finished(struct zone *zone,
 						struct compact_control *cc)
 {
@@ -1338,6 +1409,13 @@ static enum compact_result __compact_finished(struct zone *zone,
 			return COMPACT_PARTIAL_SKIPPED;
 	}
 
+	if (cc->proactive_compaction) {
+		if (fragmentation_score_zone(zone) >
+		    fragmentation_score_wmark(true))
+			return COMPACT_CONTINUE;
+		return COMPACT_SUCCESS;
+	}
+
 	if (is_via_compact_memory(cc->order))
 		return COMPACT_CONTINUE;
 
@@ -1816,6 +1894,46 @@ enum compact_result try_to_compact_pages(gfp_t gfp_mask, unsigned int order,
 }
 
 
+/*
+ * Compact all zones of a node until its fragmentation score is back under
+ * the low mark. Unlike compact_node() this runs from kcompactd, so it uses
+ * MIGRATE_SYNC_LIGHT and keeps the kcompactd statistics.
+ */
+static void proactive_compact_node(pg_data_t *pgdat)
+{
+	int zoneid;
+	struct zone *zone;
+	struct compact_control cc = {
+		.order = -1,
+		.mode = MIGRATE_SYNC_LIGHT,
+		.ignore_skip_hint = true,
+		.whole_zone = true,
+		.gfp_mask = GFP_KERNEL,
+		.proactive_compaction = true,
+	};
+
+	for (zoneid = 0; zoneid < MAX_NR_ZONES; zoneid++) {
+		zone = &pgdat->node_zones[zoneid];
+		if (!populated_zone(zone))
+			continue;
+
+		if (kthread_should_stop())
+			return;
+
+		cc.zone = zone;
+
+		compact_zone(zone, &cc);
+
+		count_compact_events(KCOMPACTD_MIGRATE_SCANNED,
+				     cc.total_migrate_scanned);
+		count_compact_events(KCOMPACTD_FREE_SCANNED,
+				     cc.total_free_scanned);
+
+		VM_BUG_ON(!list_empty(&cc.freepages));
+		VM_BUG_ON(!list_empty(&cc.migratepages));
+	}
+}
+
 /* Compact all zones within a node */
 static void compact_node(int nid)
 {
@@ -2047,6 +2165,8 @@ static int kcompactd(void *p)
 {
 	pg_data_t *pgdat = (pg_data_t*)p;
 	struct task_struct *tsk = current;
+	long default_timeout = msecs_to_jiffies(HPAGE_FRAG_CHECK_INTERVAL_MSEC);
+	long timeout = default_timeout;
 
 	const struct cpumask *cpumask = cpumask_of_node(pgdat->node_id);
 
@@ -2059,11 +2179,30 @@ static int kcompactd(void *p)
 	pgdat->kcompactd_classzone_idx = pgdat->nr_zones - 1;
 
 	while (!kthread_should_stop()) {
+		unsigned int prev_score, score;
+
 		trace_mm_compaction_kcompactd_sleep(pgdat->node_id);
-		wait_event_freezable(pgdat->kcompactd_wait,
-				kcompactd_work_requested(pgdat));
+		if (wait_event_freezable_timeout(pgdat->kcompactd_wait,
+				kcompactd_work_requested(pgdat), timeout)) {
+			kcompactd_do_work(pgdat);
+			timeout = default_timeout;
+			continue;
+		}
+
+		/* Timed out: time for a proactive check of the node */
+		timeout = default_timeout;
+		if (!should_proactive_compact_node(pgdat))
+			continue;
 
-		kcompactd_do_work(pgdat);
+		prev_score = fragmentation_score_node(pgdat);
+		proactive_compact_node(pgdat);
+		score = fragmentation_score_node(pgdat);
+		/*
+		 * Back off like deferred compaction does if that made no
+		 * progress, most likely the free memory is pinned or unmovable.
+		 */
+		if (unlikely(score >= prev_score))
+			timeout = default_timeout << COMPACT_MAX_DEFER_SHIFT;
 	}
 
 	return 0;
@@ -956,6 +956,8 @@ struct page *__page_cache_alloc(gfp_t gfp)
 	int n;
 	struct page *page;
 
+	/* cma_alloc() can simply drop clean page cache to get the space back */
+	gfp |= __GFP_CMA;
 	if (cpuset_do_page_mem_spread()) {
 		unsigned int cpuset_mems_cookie;
 		do {
@@ -2058,6 +2060,54 @@ static void shrink_readahead_size_eio(struct file *filp,
 	ra->ra_pages /= 4;
 }
 
+/*
+ * A run of consecutive page cache pages gathered by a single tree walk for
+ * generic_file_buffered_read(). pages[idx..nr) are still referenced and
+ * cover the file from start + idx onwards.
+ */
+struct filemap_read_batch {
+	pgoff_t start;
+	unsigned int idx;
+	unsigned int nr;
+	struct page *pages[PAGEVEC_SIZE];
+};
+
+static void filemap_read_batch_release(struct filemap_read_batch *fb)
+{
+	while (fb->idx < fb->nr)
+		put_page(fb->pages[fb->idx++]);
+}
+
+/*
+ * Look up the page at @index, handing over the batch's reference if it is
+ * already gathered, and otherwise refilling the batch with the contiguous
+ * run of cached pages starting at @index (up to @last_index).
+ */
+static struct page *filemap_read_batch_get(struct address_space *mapping,
+					   struct filemap_read_batch *fb,
+					   pgoff_t index, pgoff_t last_index)
+{
+	if (index < fb->start + fb->idx || index >= fb->start + fb->nr) {
+		filemap_read_batch_release(fb);
+		if (last_index - index < 2)
+			return find_get_page(mapping, index);
+
+		fb->start = index;
+		fb->idx = 0;
+		fb->nr = find_get_pages_contig(mapping, index,
+				min_t(pgoff_t, last_index - index,
+				      PAGEVEC_SIZE), fb->pages);
+		if (!fb->nr)
+			return NULL;
+	}
+
+	/* drop anything skipped over, e.g. by a partial copy */
+	while (fb->start + fb->idx < index)
+		put_page(fb->pages[fb->idx++]);
+
+	return fb->pages[fb->idx++];
+}
+
 /**
  * generic_file_buffered_read - generic file read routine
  * @iocb:	the iocb to read
@@ -2083,6 +2133,7 @@ static ssize_t generic_file_buffered_read(struct kiocb *iocb,
 	pgoff_t prev_index;
 	unsigned long offset;      /* offset into pagecache page */
 	unsigned int prev_offset;
+	struct filemap_read_batch fb = { .idx = 0, .nr = 0 };
 	int error = 0;
 
 	if (unlikely(*ppos >= inode->i_sb->s_maxbytes))
@@ -2108,14 +2159,15 @@ static ssize_t generic_file_buffered_read(struct kiocb *iocb,
 			goto out;
 		}
 
-		page = find_get_page(mapping, index);
+		page = filemap_read_batch_get(mapping, &fb, index, last_index);
 		if (!page) {
 			if (iocb->ki_flags & IOCB_NOWAIT)
 				goto would_block;
 			page_cache_sync_readahead(mapping,
 					ra, filp,
 					index, last_index - index);
-			page = find_get_page(mapping, index);
+			page = filemap_read_batch_get(mapping, &fb, index,
+						      last_index);
 			if (unlikely(page == NULL))
 				goto no_cached_page;
 		}
@@ -2314,6 +2366,7 @@ static ssize_t generic_file_buffered_read(struct kiocb *iocb,
 would_block:
 	error = -EAGAIN;
 out:
+	filemap_read_batch_release(&fb);
 	ra->prev_pos = prev_index;
 	ra->prev_pos <<= PAGE_SHIFT;
 	ra->prev_pos |= prev_offset;
@@ -63,6 +63,14 @@ static unsigned int khugepaged_alloc_sleep_millisecs __read_mostly = 60000;
 static unsigned long khugepaged_sleep_expire;
 static DEFINE_SPINLOCK(khugepaged_mm_lock);
 static DECLARE_WAIT_QUEUE_HEAD(khugepaged_wait);
+/* jiffies at the start of the current pass over khugepaged_scan.mm_head */
+static unsigned long khugepaged_scan_start;
+static unsigned int khugepaged_full_scan_msecs;
+/* collapse latency, both from khugepaged and from MADV_COLLAPSE */
+static DEFINE_SPINLOCK(khugepaged_stats_lock);
+static u64 khugepaged_collapse_count;
+static u64 khugepaged_collapse_ns;
+static u64 khugepaged_collapse_max_ns;
 /*
  * default collapse hugepages if there is at least one pte mapped like
  * it would have happened if the vma was large enough during page
@@ -206,6 +214,47 @@ static ssize_t full_scans_show(struct kobject *kobj,
 static struct kobj_attribute full_scans_attr =
 	__ATTR_RO(full_scans);
 
+static ssize_t full_scan_latency_ms_show(struct kobject *kobj,
+					 struct kobj_attribute *attr,
+					 char *buf)
+{
+	return sprintf(buf, "%u\n", READ_ONCE(khugepaged_full_scan_msecs));
+}
+static struct kobj_attribute full_scan_latency_ms_attr =
+	__ATTR_RO(full_scan_latency_ms);
+
+static ssize_t collapse_latency_avg_us_show(struct kobject *kobj,
+					    struct kobj_attribute *attr,
+					    char *buf)
+{
+	u64 count, ns;
+
+	spin_lock(&khugepaged_stats_lock);
+	count = khugepaged_collapse_count;
+	ns = khugepaged_collapse_ns;
+	spin_unlock(&khugepaged_stats_lock);
+
+	return sprintf(buf, "%llu\n",
+		       count ? div64_u64(ns, count * NSEC_PER_USEC) : 0);
+}
+static struct kobj_attribute collapse_latency_avg_us_attr =
+	__ATTR_RO(collapse_latency_avg_us);
+
+static ssize_t collapse_latency_max_us_show(struct kobject *kobj,
+					    struct kobj_attribute *attr,
+					    char *buf)
+{
+	u64 ns;
+
+	spin_lock(&khugepaged_stats_lock);
+	ns = khugepaged_collapse_max_ns;
+	spin_unlock(&khugepaged_stats_lock);
+
+	return sprintf(buf, "%llu\n", div_u64(ns, NSEC_PER_USEC));
+}
+static struct kobj_attribute collapse_latency_max_us_attr =
+	__ATTR_RO(collapse_latency_max_us);
+
 static ssize_t khugepaged_defrag_show(struct kobject *kobj,
 				      struct kobj_attribute *attr, char *buf)
 {
@@ -289,6 +338,9 @@ static struct attribute *khugepaged_attr[] = {
 	&pages_to_scan_attr.attr,
 	&pages_collapsed_attr.attr,
 	&full_scans_attr.attr,
+	&full_scan_latency_ms_attr.attr,
+	&collapse_latency_avg_us_attr.attr,
+	&collapse_latency_max_us_attr.attr,
 	&scan_sleep_millisecs_attr.attr,
 	&alloc_sleep_millisecs_attr.attr,
 	&khugepaged_max_ptes_swap_attr.attr,
@@ -417,6 +469,36 @@ static bool hugepage_vma_check(struct vm_area_struct *vma,
 	return !(vm_flags & VM_NO_KHUGEPAGED);
 }
 
+/*
+ * Processes that asked for PR_SET_THP_PRIORITY are kept at the head of
+ * khugepaged_scan.mm_head so that every pass visits them before the rest.
+ * Called with khugepaged_mm_lock held.
+ */
+static void khugepaged_add_mm_slot(struct mm_slot *mm_slot)
+{
+	if (test_bit(MMF_THP_PRIORITY, &mm_slot->mm->flags))
+		list_add(&mm_slot->mm_node, &khugepaged_scan.mm_head);
+	else
+		list_add_tail(&mm_slot->mm_node, &khugepaged_scan.mm_head);
+}
+
+/*
+ * Reposition @mm on the scan list after MMF_THP_PRIORITY changed. The slot
+ * currently under the cursor is left alone, it is finished first anyway.
+ */
+void khugepaged_update_priority(struct mm_struct *mm)
+{
+	struct mm_slot *mm_slot;
+
+	spin_lock(&khugepaged_mm_lock);
+	mm_slot = get_mm_slot(mm);
+	if (mm_slot && khugepaged_scan.mm_slot != mm_slot) {
+		list_del(&mm_slot->mm_node);
+		khugepaged_add_mm_slot(mm_slot);
+	}
+	spin_unlock(&khugepaged_mm_lock);
+}
+
 int __khugepaged_enter(struct mm_struct *mm)
 {
 	struct mm_slot *mm_slot;
@@ -437,10 +519,10 @@ int __khugepaged_enter(struct mm_struct *mm)
 	insert_to_mm_slots_hash(mm, mm_slot);
 	/*
 	 * Insert just behind the scanning cursor, to let the area settle
-	 * down a little.
+	 * down a little, unless the process asked to be scanned first.
 	 */
 	wakeup = list_empty(&khugepaged_scan.mm_head);
-	list_add_tail(&mm_slot->mm_node, &khugepaged_scan.mm_head);
+	khugepaged_add_mm_slot(mm_slot);
 	spin_unlock(&khugepaged_mm_lock);
 
 	mmgrab(mm);
@@ -692,7 +774,7 @@ static void khugepaged_alloc_sleep(void)
 
 static int khugepaged_node_load[MAX_NUMNODES];
 
-static bool khugepaged_scan_abort(int nid)
+static bool khugepaged_scan_abort(int nid, int *node_load)
 {
 	int i;
 
@@ -704,11 +786,11 @@ static bool khugepaged_scan_abort(int nid)
 		return false;
 
 	/* If there is a count for this node already, it must be acceptable */
-	if (khugepaged_node_load[nid])
+	if (node_load[nid])
 		return false;
 
 	for (i = 0; i < MAX_NUMNODES; i++) {
-		if (!khugepaged_node_load[i])
+		if (!node_load[i])
 			continue;
 		if (node_distance(nid, i) > RECLAIM_DISTANCE)
 			return true;
@@ -723,15 +805,15 @@ static inline gfp_t alloc_hugepage_khugepaged_gfpmask(void)
 }
 
 #ifdef CONFIG_NUMA
-static int khugepaged_find_target_node(void)
+static int khugepaged_find_target_node(int *node_load)
 {
 	static int last_khugepaged_target_node = NUMA_NO_NODE;
 	int nid, target_node = 0, max_value = 0;
 
 	/* find first node with max normal pages hit */
 	for (nid = 0; nid < MAX_NUMNODES; nid++)
-		if (khugepaged_node_load[nid] > max_value) {
-			max_value = khugepaged_node_load[nid];
+		if (node_load[nid] > max_value) {
+			max_value = node_load[nid];
 			target_node = nid;
 		}
 
@@ -739,7 +821,7 @@ static int khugepaged_find_target_node(void)
 	if (target_node <= last_khugepaged_target_node)
 		for (nid = last_khugepaged_target_node + 1; nid < MAX_NUMNODES;
 				nid++)
-			if (max_value == khugepaged_node_load[nid]) {
+			if (max_value == node_load[nid]) {
 				target_node = nid;
 				break;
 			}
@@ -782,7 +864,7 @@ khugepaged_alloc_page(struct page **hpage, gfp_t gfp, int node)
 	return *hpage;
 }
 #else
-static int khugepaged_find_target_node(void)
+static int khugepaged_find_target_node(int *node_load)
 {
 	return 0;
 }
@@ -1099,10 +1181,26 @@ static void collapse_huge_page(struct mm_struct *mm,
 	goto out_up_write;
 }
 
+static void khugepaged_account_collapse(u64 start)
+{
+	u64 delta = ktime_get_ns() - start;
+
+	spin_lock(&khugepaged_stats_lock);
+	khugepaged_collapse_count++;
+	khugepaged_collapse_ns += delta;
+	if (delta > khugepaged_collapse_max_ns)
+		khugepaged_collapse_max_ns = delta;
+	spin_unlock(&khugepaged_stats_lock);
+}
+
+/*
+ * @node_load is khugepaged_node_load[] for khugepaged itself and a private
+ * array for MADV_COLLAPSE, which can run concurrently with it.
+ */
 static int khugepaged_scan_pmd(struct mm_struct *mm,
 			       struct vm_area_struct *vma,
 			       unsigned long address,
-			       struct page **hpage)
+			       struct page **hpage, int *node_load)
 {
 	pmd_t *pmd;
 	pte_t *pte, *_pte;
@@ -1121,7 +1219,7 @@ static int khugepaged_scan_pmd(struct mm_struct *mm,
 		goto out;
 	}
 
-	memset(khugepaged_node_load, 0, sizeof(khugepaged_node_load));
+	memset(node_load, 0, sizeof(*node_load) * MAX_NUMNODES);
 	pte = pte_offset_map_lock(mm, pmd, address, &ptl);
 	for (_address = address, _pte = pte; _pte < pte+HPAGE_PMD_NR;
 	     _pte++, _address += PAGE_SIZE) {
@@ -1169,11 +1267,11 @@ static int khugepaged_scan_pmd(struct mm_struct *mm,
 		 * hit record.
 		 */
 		node = page_to_nid(page);
-		if (khugepaged_scan_abort(node)) {
+		if (khugepaged_scan_abort(node, node_load)) {
 			result = SCAN_SCAN_ABORT;
 			goto out_unmap;
 		}
-		khugepaged_node_load[node]++;
+		node_load[node]++;
 		if (!PageLRU(page)) {
 			result = SCAN_PAGE_LRU;
 			goto out_unmap;
@@ -1214,9 +1312,12 @@ static int khugepaged_scan_pmd(struct mm_struct *mm,
 out_unmap:
 	pte_unmap_unlock(pte, ptl);
 	if (ret) {
-		node = khugepaged_find_target_node();
+		u64 start = ktime_get_ns();
+
+		node = khugepaged_find_target_node(node_load);
 		/* collapse_huge_page will return with the mmap_sem released */
 		collapse_huge_page(mm, address, hpage, node, referenced);
+		khugepaged_account_collapse(start);
 	}
 out:
 	trace_mm_khugepaged_scan_pmd(mm, page, writable, referenced,
@@ -1224,6 +1325,95 @@ static int khugepaged_scan_pmd(struct mm_struct *mm,
 	return ret;
 }
 
+static bool khugepaged_pmd_mapped(struct mm_struct *mm, unsigned long address)
+{
+	pgd_t *pgd;
+	p4d_t *p4d;
+	pud_t *pud;
+	pmd_t *pmd;
+
+	pgd = pgd_offset(mm, address);
+	if (!pgd_present(*pgd))
+		return false;
+	p4d = p4d_offset(pgd, address);
+	if (!p4d_present(*p4d))
+		return false;
+	pud = pud_offset(p4d, address);
+	if (!pud_present(*pud))
+		return false;
+	pmd = pmd_offset(pud, address);
+	return pmd_trans_huge(READ_ONCE(*pmd));
+}
+
+/*
+ * MADV_COLLAPSE: collapse the anonymous memory in [start, end) into huge
+ * pages now rather than waiting for khugepaged to get there. The same
+ * max_ptes_none/max_ptes_swap limits apply. Called with mmap_sem held for
+ * read, which collapse_huge_page() drops; *prev is cleared when it was.
+ */
+int khugepaged_madvise_collapse(struct vm_area_struct *vma,
+				struct vm_area_struct **prev,
+				unsigned long start, unsigned long end)
+{
+	struct mm_struct *mm = vma->vm_mm;
+	struct page *hpage = NULL;
+	unsigned long address, hstart, hend;
+	int *node_load, failed = 0, ret = 0;
+	bool wait = false;
+
+	*prev = vma;
+	if (!hugepage_vma_check(vma, vma->vm_flags) || shmem_file(vma->vm_file))
+		return -EINVAL;
+
+	hstart = (start + ~HPAGE_PMD_MASK) & HPAGE_PMD_MASK;
+	hend = end & HPAGE_PMD_MASK;
+	if (hstart >= hend)
+		return 0;
+
+	node_load = kcalloc(MAX_NUMNODES, sizeof(*node_load), GFP_KERNEL);
+	if (!node_load)
+		return -ENOMEM;
+
+	for (address = hstart; address < hend; address += HPAGE_PMD_SIZE) {
+		cond_resched();
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			break;
+		}
+		if (khugepaged_pmd_mapped(mm, address))
+			continue;
+		if (!khugepaged_prealloc_page(&hpage, &wait)) {
+			ret = -ENOMEM;
+			break;
+		}
+		if (!khugepaged_scan_pmd(mm, vma, address, &hpage, node_load)) {
+			failed++;
+			continue;
+		}
+
+		/* collapse_huge_page() consumes hpage only on success */
+		if (hpage)
+			failed++;
+		*prev = NULL;
+		down_read(&mm->mmap_sem);
+		vma = find_vma(mm, address);
+		if (!vma || vma->vm_start > address ||
+		    !hugepage_vma_check(vma, vma->vm_flags)) {
+			ret = -ENOMEM;
+			break;
+		}
+		hend = min(hend, vma->vm_end & HPAGE_PMD_MASK);
+	}
+
+	if (!IS_ERR_OR_NULL(hpage))
+		put_page(hpage);
+	kfree(node_load);
+
+	if (!ret && failed)
+		ret = -EAGAIN;
+	return ret;
+}
+
 static void collect_mm_slot(struct mm_slot *mm_slot)
 {
 	struct mm_struct *mm = mm_slot->mm;
@@ -1623,7 +1813,7 @@ static void khugepaged_scan_shmem(struct mm_struct *mm,
 		}
 
 		node = page_to_nid(page);
-		if (khugepaged_scan_abort(node)) {
+		if (khugepaged_scan_abort(node, khugepaged_node_load)) {
 			result = SCAN_SCAN_ABORT;
 			break;
 		}
@@ -1658,7 +1848,8 @@ static void khugepaged_scan_shmem(struct mm_struct *mm,
 		if (present < HPAGE_PMD_NR - khugepaged_max_ptes_none) {
 			result = SCAN_EXCEED_NONE_PTE;
 		} else {
-			node = khugepaged_find_target_node();
+			node = khugepaged_find_target_node(
+					khugepaged_node_load);
 			collapse_shmem(mm, mapping, start, hpage, node);
 		}
 	}
@@ -1694,6 +1885,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages,
 				     struct mm_slot, mm_node);
 		khugepaged_scan.address = 0;
 		khugepaged_scan.mm_slot = mm_slot;
+		khugepaged_scan_start = jiffies;
 	}
 	spin_unlock(&khugepaged_mm_lock);
 
@@ -1756,7 +1948,7 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages,
 			} else {
 				ret = khugepaged_scan_pmd(mm, vma,
 						khugepaged_scan.address,
-						hpage);
+						hpage, khugepaged_node_load);
 			}
 			/* move to next address */
 			khugepaged_scan.address += HPAGE_PMD_SIZE;
@@ -1792,6 +1984,9 @@ static unsigned int khugepaged_scan_mm_slot(unsigned int pages,
 		} else {
 			khugepaged_scan.mm_slot = NULL;
 			khugepaged_full_scans++;
+			WRITE_ONCE(khugepaged_full_scan_msecs,
+				   jiffies_to_msecs(jiffies -
+						    khugepaged_scan_start));
 		}
 
 		collect_mm_slot(mm_slot);
@@ -273,6 +273,23 @@ static unsigned int ksm_thread_pages_to_scan = 100;
 /* Milliseconds ksmd should sleep between batches */
 static unsigned int ksm_thread_sleep_millisecs = 20;
 
+/*
+ * With the advisor on, ksmd sets pages_to_scan itself after every full scan
+ * from the share of scanned pages that it managed to merge: doubled while
+ * at least KSM_ADVISOR_YIELD_HIGH per mille merge, halved below
+ * KSM_ADVISOR_YIELD_LOW, always within the advisor's min and max.
+ */
+#define KSM_ADVISOR_YIELD_HIGH	10
+#define KSM_ADVISOR_YIELD_LOW	1
+static bool ksm_advisor;
+static unsigned int ksm_advisor_min_pages_to_scan = 100;
+static unsigned int ksm_advisor_max_pages_to_scan = 10000;
+static unsigned long ksm_advisor_yield;
+
+/* Pages scanned and merged so far in the current full scan */
+static unsigned long ksm_scan_pages_scanned;
+static unsigned long ksm_scan_pages_merged;
+
 /* Checksum of an empty (zeroed) page */
 static unsigned int zero_checksum __read_mostly;
 
@@ -388,6 +405,7 @@ static inline struct rmap_item *alloc_rmap_item(void)
 static inline void free_rmap_item(struct rmap_item *rmap_item)
 {
 	ksm_rmap_items--;
+	rmap_item->mm->ksm_rmap_items--;
 	rmap_item->mm = NULL;	/* debug safety */
 	kmem_cache_free(rmap_item_cache, rmap_item);
 }
@@ -640,6 +658,7 @@ static void remove_node_from_stable_tree(struct stable_node *stable_node)
 			ksm_pages_sharing--;
 		else
 			ksm_pages_shared--;
+		rmap_item->mm->ksm_merging_pages--;
 		VM_BUG_ON(stable_node->rmap_hlist_len <= 0);
 		stable_node->rmap_hlist_len--;
 		put_anon_vma(rmap_item->anon_vma);
@@ -774,6 +793,7 @@ static void remove_rmap_item_from_tree(struct rmap_item *rmap_item)
 			ksm_pages_sharing--;
 		else
 			ksm_pages_shared--;
+		rmap_item->mm->ksm_merging_pages--;
 		VM_BUG_ON(stable_node->rmap_hlist_len <= 0);
 		stable_node->rmap_hlist_len--;
 
@@ -2018,6 +2038,8 @@ static void stable_tree_append(struct rmap_item *rmap_item,
 		ksm_pages_sharing++;
 	else
 		ksm_pages_shared++;
+	rmap_item->mm->ksm_merging_pages++;
+	ksm_scan_pages_merged++;
 }
 
 /*
@@ -2208,6 +2230,7 @@ static struct rmap_item *get_next_rmap_item(struct mm_slot *mm_slot,
 	if (rmap_item) {
 		/* It has already been zeroed */
 		rmap_item->mm = mm_slot->mm;
+		rmap_item->mm->ksm_rmap_items++;
 		rmap_item->address = addr;
 		rmap_item->rmap_list = *rmap_list;
 		*rmap_list = rmap_item;
@@ -2215,6 +2238,28 @@ static struct rmap_item *get_next_rmap_item(struct mm_slot *mm_slot,
 	return rmap_item;
 }
 
+static void ksm_advisor_tune(void)
+{
+	unsigned long scanned = ksm_scan_pages_scanned;
+	unsigned long merged = ksm_scan_pages_merged;
+	unsigned long pages = ksm_thread_pages_to_scan;
+
+	ksm_scan_pages_scanned = 0;
+	ksm_scan_pages_merged = 0;
+	if (!ksm_advisor || !scanned)
+		return;
+
+	ksm_advisor_yield = merged * 1000 / scanned;
+	if (ksm_advisor_yield >= KSM_ADVISOR_YIELD_HIGH)
+		pages *= 2;
+	else if (ksm_advisor_yield < KSM_ADVISOR_YIELD_LOW)
+		pages /= 2;
+
+	ksm_thread_pages_to_scan = clamp_t(unsigned long, pages,
+					   ksm_advisor_min_pages_to_scan,
+					   ksm_advisor_max_pages_to_scan);
+}
+
 static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 {
 	struct mm_struct *mm;
@@ -2370,6 +2415,7 @@ static struct rmap_item *scan_get_next_rmap_item(struct page **page)
 		goto next_mm;
 
 	ksm_scan.seqnr++;
+	ksm_advisor_tune();
 	return NULL;
 }
 
@@ -2387,6 +2433,7 @@ static void ksm_do_scan(unsigned int scan_npages)
 		rmap_item = scan_get_next_rmap_item(&page);
 		if (!rmap_item)
 			return;
+		ksm_scan_pages_scanned++;
 		cmp_and_merge_page(page, rmap_item);
 		put_page(page);
 	}
@@ -2422,6 +2469,37 @@ static int ksm_scan_thread(void *nothing)
 	return 0;
 }
 
+static bool ksm_compatible(const struct file *file, unsigned long vm_flags)
+{
+	/*
+	 * Be somewhat over-protective for now!
+	 */
+	if (vm_flags & (VM_MERGEABLE | VM_SHARED  | VM_MAYSHARE   |
+			VM_PFNMAP    | VM_IO      | VM_DONTEXPAND |
+			VM_HUGETLB | VM_MIXEDMAP))
+		return false;
+
+	if (file && IS_DAX(file->f_mapping->host))
+		return false;
+
+#ifdef VM_SAO
+	if (vm_flags & VM_SAO)
+		return false;
+#endif
+#ifdef VM_SPARC_ADI
+	if (vm_flags & VM_SPARC_ADI)
+		return false;
+#endif
+
+	return true;
+}
+
+static bool vma_ksm_compatible(struct vm_area_struct *vma,
+			       unsigned long vm_flags)
+{
+	return ksm_compatible(vma->vm_file, vm_flags);
+}
+
 int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 		unsigned long end, int advice, unsigned long *vm_flags)
 {
@@ -2430,26 +2508,9 @@ int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 
 	switch (advice) {
 	case MADV_MERGEABLE:
-		/*
-		 * Be somewhat over-protective for now!
-		 */
-		if (*vm_flags & (VM_MERGEABLE | VM_SHARED  | VM_MAYSHARE   |
-				 VM_PFNMAP    | VM_IO      | VM_DONTEXPAND |
-				 VM_HUGETLB | VM_MIXEDMAP))
+		if (!vma_ksm_compatible(vma, *vm_flags))
 			return 0;		/* just ignore the advice */
 
-		if (vma_is_dax(vma))
-			return 0;
-
-#ifdef VM_SAO
-		if (*vm_flags & VM_SAO)
-			return 0;
-#endif
-#ifdef VM_SPARC_ADI
-		if (*vm_flags & VM_SPARC_ADI)
-			return 0;
-#endif
-
 		if (!test_bit(MMF_VM_MERGEABLE, &mm->flags)) {
 			err = __ksm_enter(mm);
 			if (err)
@@ -2476,6 +2537,79 @@ int ksm_madvise(struct vm_area_struct *vma, unsigned long start,
 	return 0;
 }
 
+/*
+ * Called with mmap_sem held for writing, with the flags of a vma about to
+ * be created by a process that set PR_SET_MEMORY_MERGE. mmap() and brk()
+ * apply this before vma_merge(), so the new range still merges with its
+ * mergeable neighbours. Best effort: if the mm cannot be registered the
+ * vma is simply left out.
+ */
+unsigned long __ksm_vma_flags(struct mm_struct *mm, const struct file *file,
+			      unsigned long vm_flags)
+{
+	if (!ksm_compatible(file, vm_flags))
+		return vm_flags;
+
+	if (!test_bit(MMF_VM_MERGEABLE, &mm->flags) && __ksm_enter(mm))
+		return vm_flags;
+
+	return vm_flags | VM_MERGEABLE;
+}
+
+/*
+ * PR_SET_MEMORY_MERGE: MADV_MERGEABLE on every existing vma of @mm and on
+ * all those created later. Called with mmap_sem held for writing.
+ */
+int ksm_enable_merge_any(struct mm_struct *mm)
+{
+	struct vm_area_struct *vma;
+	int err;
+
+	if (test_bit(MMF_VM_MERGE_ANY, &mm->flags))
+		return 0;
+
+	if (!test_bit(MMF_VM_MERGEABLE, &mm->flags)) {
+		err = __ksm_enter(mm);
+		if (err)
+			return err;
+	}
+
+	set_bit(MMF_VM_MERGE_ANY, &mm->flags);
+	for (vma = mm->mmap; vma; vma = vma->vm_next)
+		if (vma_ksm_compatible(vma, vma->vm_flags))
+			vma->vm_flags |= VM_MERGEABLE;
+
+	return 0;
+}
+
+/*
+ * Undo PR_SET_MEMORY_MERGE, which like MADV_UNMERGEABLE also breaks up the
+ * pages already merged. Called with mmap_sem held for writing.
+ */
+int ksm_disable_merge_any(struct mm_struct *mm)
+{
+	struct vm_area_struct *vma;
+	int err;
+
+	if (!test_bit(MMF_VM_MERGE_ANY, &mm->flags))
+		return 0;
+
+	for (vma = mm->mmap; vma; vma = vma->vm_next) {
+		if (!(vma->vm_flags & VM_MERGEABLE))
+			continue;
+		if (vma->anon_vma) {
+			err = unmerge_ksm_pages(vma, vma->vm_start,
+						vma->vm_end);
+			if (err)
+				return err;
+		}
+		vma->vm_flags &= ~VM_MERGEABLE;
+	}
+
+	clear_bit(MMF_VM_MERGE_ANY, &mm->flags);
+	return 0;
+}
+
 int __ksm_enter(struct mm_struct *mm)
 {
 	struct mm_slot *mm_slot;
@@ -3114,6 +3248,82 @@ static ssize_t full_scans_show(struct kobject *kobj,
 }
 KSM_ATTR_RO(full_scans);
 
+static ssize_t advisor_mode_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, ksm_advisor ? "none [yield]\n" : "[none] yield\n");
+}
+
+static ssize_t advisor_mode_store(struct kobject *kobj,
+				  struct kobj_attribute *attr,
+				  const char *buf, size_t count)
+{
+	if (sysfs_streq(buf, "yield"))
+		ksm_advisor = true;
+	else if (sysfs_streq(buf, "none"))
+		ksm_advisor = false;
+	else
+		return -EINVAL;
+
+	return count;
+}
+KSM_ATTR(advisor_mode);
+
+static ssize_t advisor_min_pages_to_scan_show(struct kobject *kobj,
+					      struct kobj_attribute *attr,
+					      char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_advisor_min_pages_to_scan);
+}
+
+static ssize_t advisor_min_pages_to_scan_store(struct kobject *kobj,
+					       struct kobj_attribute *attr,
+					       const char *buf, size_t count)
+{
+	unsigned int nr_pages;
+	int err;
+
+	err = kstrtouint(buf, 10, &nr_pages);
+	if (err || !nr_pages || nr_pages > ksm_advisor_max_pages_to_scan)
+		return -EINVAL;
+
+	ksm_advisor_min_pages_to_scan = nr_pages;
+
+	return count;
+}
+KSM_ATTR(advisor_min_pages_to_scan);
+
+static ssize_t advisor_max_pages_to_scan_show(struct kobject *kobj,
+					      struct kobj_attribute *attr,
+					      char *buf)
+{
+	return sprintf(buf, "%u\n", ksm_advisor_max_pages_to_scan);
+}
+
+static ssize_t advisor_max_pages_to_scan_store(struct kobject *kobj,
+					       struct kobj_attribute *attr,
+					       const char *buf, size_t count)
+{
+	unsigned int nr_pages;
+	int err;
+
+	err = kstrtouint(buf, 10, &nr_pages);
+	if (err || nr_pages < ksm_advisor_min_pages_to_scan)
+		return -EINVAL;
+
+	ksm_advisor_max_pages_to_scan = nr_pages;
+
+	return count;
+}
+KSM_ATTR(advisor_max_pages_to_scan);
+
+static ssize_t advisor_yield_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", ksm_advisor_yield);
+}
+KSM_ATTR_RO(advisor_yield);
+
 static struct attribute *ksm_attrs[] = {
 	&sleep_millisecs_attr.attr,
 	&pages_to_scan_attr.attr,
@@ -3123,6 +3333,10 @@ static struct attribute *ksm_attrs[] = {
 	&pages_unshared_attr.attr,
 	&pages_volatile_attr.attr,
 	&full_scans_attr.attr,
+	&advisor_mode_attr.attr,
+	&advisor_min_pages_to_scan_attr.attr,
+	&advisor_max_pages_to_scan_attr.attr,
+	&advisor_yield_attr.attr,
 #ifdef CONFIG_NUMA
 	&merge_across_nodes_attr.attr,
 #endif
@@ -1973,6 +1973,13 @@ struct memcg_stock_pcp {
 #define FLUSHING_CACHED_CHARGE	0
 };
 static DEFINE_PER_CPU(struct memcg_stock_pcp, memcg_stock);
+
+/*
+ * Pages charged ahead into a cpu's stock, set through the root's
+ * memory.charge_batch: larger batches take the shared page counters less
+ * often, at the cost of more charge parked on each cpu.
+ */
+static unsigned int memcg_charge_batch __read_mostly = MEMCG_CHARGE_BATCH;
 static DEFINE_MUTEX(percpu_charge_mutex);
 
 /**
@@ -1992,7 +1999,7 @@ static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	unsigned long flags;
 	bool ret = false;
 
-	if (nr_pages > MEMCG_CHARGE_BATCH)
+	if (nr_pages > READ_ONCE(memcg_charge_batch))
 		return ret;
 
 	local_irq_save(flags);
@@ -2061,7 +2068,7 @@ static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 	}
 	stock->nr_pages += nr_pages;
 
-	if (stock->nr_pages > MEMCG_CHARGE_BATCH)
+	if (stock->nr_pages > READ_ONCE(memcg_charge_batch))
 		drain_stock(stock);
 
 	local_irq_restore(flags);
@@ -2108,13 +2115,16 @@ static void drain_all_stock(struct mem_cgroup *root_memcg)
 	mutex_unlock(&percpu_charge_mutex);
 }
 
-static int memcg_hotplug_cpu_dead(unsigned int cpu)
+/*
+ * Fold this cpu's stat and event deltas into the shared counters of every
+ * memcg.
+ */
+static void memcg_flush_local_stats(void)
 {
-	struct memcg_stock_pcp *stock;
 	struct mem_cgroup *memcg;
 
-	stock = &per_cpu(memcg_stock, cpu);
-	drain_stock(stock);
+	/* whatever changes during the walk is counted afresh */
+	this_cpu_write(memcg_stat_error, 0);
 
 	for_each_mem_cgroup(memcg) {
 		int i;
@@ -2148,7 +2158,55 @@ static int memcg_hotplug_cpu_dead(unsigned int cpu)
 				atomic_long_add(x, &memcg->events[i]);
 		}
 	}
+}
+
+/*
+ * With MEMCG_STAT_BATCH deltas a cpu that stops touching a memcg can sit on
+ * a sizeable part of its stats; flush them every so often, per cpu as the
+ * deltas are only ever written locally. Only cpus whose unflushed deltas
+ * add up to more than MEMCG_STAT_FLUSH_ERROR are flushed, so idle cpus are
+ * left alone and nobody walks every memcg for a handful of pages.
+ */
+#define MEMCG_STAT_FLUSH_INTERVAL	(2 * HZ)
+#define MEMCG_STAT_FLUSH_ERROR		MEMCG_STAT_BATCH
+
+DEFINE_PER_CPU(unsigned long, memcg_stat_error);
+EXPORT_PER_CPU_SYMBOL(memcg_stat_error);
+
+static DEFINE_PER_CPU(struct work_struct, memcg_stat_flush_work);
+
+static void memcg_stat_flush_local(struct work_struct *work)
+{
+	memcg_flush_local_stats();
+}
+
+static void memcg_stat_flush_shepherd(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(memcg_stat_shepherd, memcg_stat_flush_shepherd);
+
+static void memcg_stat_flush_shepherd(struct work_struct *work)
+{
+	int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu)
+		if (READ_ONCE(per_cpu(memcg_stat_error, cpu)) >
+		    MEMCG_STAT_FLUSH_ERROR)
+			queue_work_on(cpu, mm_percpu_wq,
+				      &per_cpu(memcg_stat_flush_work, cpu));
+	put_online_cpus();
+
+	schedule_delayed_work(&memcg_stat_shepherd,
+		round_jiffies_relative(MEMCG_STAT_FLUSH_INTERVAL));
+}
 
+static int memcg_hotplug_cpu_dead(unsigned int cpu)
+{
+	struct memcg_stock_pcp *stock;
+
+	stock = &per_cpu(memcg_stock, cpu);
+	drain_stock(stock);
+
+	memcg_flush_local_stats();
 	return 0;
 }
 
@@ -2172,6 +2230,62 @@ static void high_work_func(struct work_struct *work)
 	reclaim_high(memcg, MEMCG_CHARGE_BATCH, GFP_KERNEL);
 }
 
+/* Pages reclaimed between two checks of the refault rate */
+#define MEMCG_RECLAIM_BATCH	(SWAP_CLUSTER_MAX * 4)
+
+static unsigned long memcg_workingset_activations(struct mem_cgroup *memcg)
+{
+	struct mem_cgroup *iter;
+	unsigned long activations = 0;
+
+	for_each_mem_cgroup_tree(iter, memcg)
+		activations += memcg_page_state(iter, WORKINGSET_ACTIVATE);
+
+	return activations;
+}
+
+/*
+ * Works through the amount queued by memory.reclaim in batches. Refaults
+ * that workingset detection activates straight away are pages the subtree
+ * still uses, so once they add up to half of what has been reclaimed the
+ * rest of the request is dropped instead of pushing into thrashing.
+ *
+ * The request is taken over as a whole, so that anything queued while we
+ * run is left for the next run rather than dropped along with ours.
+ */
+static void reclaim_work_func(struct work_struct *work)
+{
+	struct mem_cgroup *memcg;
+	unsigned int nr_retries = MEM_CGROUP_RECLAIM_RETRIES;
+	unsigned long activations, reclaimed = 0;
+	long pending;
+
+	memcg = container_of(work, struct mem_cgroup, reclaim_work);
+	pending = atomic_long_xchg(&memcg->reclaim_pending, 0);
+	activations = memcg_workingset_activations(memcg);
+
+	while (pending > 0) {
+		unsigned long nr_pages;
+
+		nr_pages = try_to_free_mem_cgroup_pages(memcg,
+				min_t(long, pending, MEMCG_RECLAIM_BATCH),
+				GFP_KERNEL, true);
+		if (!nr_pages && !nr_retries--)
+			break;
+
+		reclaimed += nr_pages;
+		pending -= nr_pages;
+		atomic_long_add(nr_pages, &memcg->reclaim_reclaimed);
+
+		if (memcg_workingset_activations(memcg) - activations >
+		    reclaimed / 2) {
+			atomic_long_inc(&memcg->reclaim_thrashing);
+			break;
+		}
+		cond_resched();
+	}
+}
+
 /*
  * Scheduled by try_charge() to be executed from the userland return path
  * and reclaims memory over the high limit.
@@ -2193,7 +2307,7 @@ void mem_cgroup_handle_over_high(void)
 static int try_charge(struct mem_cgroup *memcg, gfp_t gfp_mask,
 		      unsigned int nr_pages)
 {
-	unsigned int batch = max(MEMCG_CHARGE_BATCH, nr_pages);
+	unsigned int batch = max(READ_ONCE(memcg_charge_batch), nr_pages);
 	int nr_retries = MEM_CGROUP_RECLAIM_RETRIES;
 	struct mem_cgroup *mem_over_limit;
 	struct page_counter *counter;
@@ -2982,6 +3096,22 @@ static ssize_t mem_cgroup_force_empty_write(struct kernfs_open_file *of,
 	return mem_cgroup_force_empty(memcg) ?: nbytes;
 }
 
+static u64 mem_cgroup_charge_batch_read(struct cgroup_subsys_state *css,
+					struct cftype *cft)
+{
+	return READ_ONCE(memcg_charge_batch);
+}
+
+static int mem_cgroup_charge_batch_write(struct cgroup_subsys_state *css,
+					 struct cftype *cft, u64 val)
+{
+	if (!val || val > MEMCG_CHARGE_BATCH_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(memcg_charge_batch, val);
+	return 0;
+}
+
 static u64 mem_cgroup_hierarchy_read(struct cgroup_subsys_state *css,
 				     struct cftype *cft)
 {
@@ -4294,6 +4424,12 @@ static struct cftype mem_cgroup_legacy_files[] = {
 		.read_u64 = mem_cgroup_swappiness_read,
 		.write_u64 = mem_cgroup_swappiness_write,
 	},
+	{
+		.name = "charge_batch",
+		.flags = CFTYPE_ONLY_ON_ROOT,
+		.read_u64 = mem_cgroup_charge_batch_read,
+		.write_u64 = mem_cgroup_charge_batch_write,
+	},
 	{
 		.name = "move_charge_at_immigrate",
 		.read_u64 = mem_cgroup_move_charge_read,
@@ -4536,6 +4672,7 @@ static struct mem_cgroup *mem_cgroup_alloc(void)
 		goto fail;
 
 	INIT_WORK(&memcg->high_work, high_work_func);
+	INIT_WORK(&memcg->reclaim_work, reclaim_work_func);
 	memcg->last_scanned_node = MAX_NUMNODES;
 	INIT_LIST_HEAD(&memcg->oom_notify);
 	mutex_init(&memcg->thresholds_lock);
@@ -4682,6 +4819,7 @@ static void mem_cgroup_css_free(struct cgroup_subsys_state *css)
 
 	vmpressure_cleanup(&memcg->vmpressure);
 	cancel_work_sync(&memcg->high_work);
+	cancel_work_sync(&memcg->reclaim_work);
 	mem_cgroup_remove_from_trees(memcg);
 	memcg_free_shrinker_maps(memcg);
 	memcg_free_kmem(memcg);
@@ -5607,6 +5745,51 @@ static ssize_t memory_max_write(struct kernfs_open_file *of,
 	return nbytes;
 }
 
+static int memory_reclaim_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(seq_css(m));
+	long pending = atomic_long_read(&memcg->reclaim_pending);
+	long reclaimed = atomic_long_read(&memcg->reclaim_reclaimed);
+
+	seq_printf(m, "pending %llu\n", (u64)max(pending, 0L) * PAGE_SIZE);
+	seq_printf(m, "reclaimed %llu\n", (u64)reclaimed * PAGE_SIZE);
+	seq_printf(m, "thrashing %lu\n",
+		   atomic_long_read(&memcg->reclaim_thrashing));
+
+	return 0;
+}
+
+/*
+ * Queue the given number of bytes for reclaim from the subtree and return
+ * without waiting for it, so it can be done ahead of demand, off the
+ * latency-critical path. "0" drops whatever the worker hasn't taken yet.
+ */
+static ssize_t memory_reclaim_write(struct kernfs_open_file *of,
+				    char *buf, size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	unsigned long nr_pages;
+	char *end;
+	u64 bytes;
+
+	buf = strstrip(buf);
+	bytes = memparse(buf, &end);
+	if (end == buf || *end != '\0')
+		return -EINVAL;
+
+	nr_pages = min(bytes / PAGE_SIZE, (u64)PAGE_COUNTER_MAX);
+	if (!nr_pages) {
+		atomic_long_set(&memcg->reclaim_pending, 0);
+		return nbytes;
+	}
+
+	drain_all_stock(memcg);
+	atomic_long_add(nr_pages, &memcg->reclaim_pending);
+	queue_work(system_unbound_wq, &memcg->reclaim_work);
+
+	return nbytes;
+}
+
 static int memory_events_show(struct seq_file *m, void *v)
 {
 	struct mem_cgroup *memcg = mem_cgroup_from_css(seq_css(m));
@@ -5734,6 +5917,12 @@ static ssize_t memory_oom_group_write(struct kernfs_open_file *of,
 }
 
 static struct cftype memory_files[] = {
+	{
+		.name = "charge_batch",
+		.flags = CFTYPE_ONLY_ON_ROOT,
+		.read_u64 = mem_cgroup_charge_batch_read,
+		.write_u64 = mem_cgroup_charge_batch_write,
+	},
 	{
 		.name = "current",
 		.flags = CFTYPE_NOT_ON_ROOT,
@@ -5780,6 +5969,12 @@ static struct cftype memory_files[] = {
 		.seq_show = memory_oom_group_show,
 		.write = memory_oom_group_write,
 	},
+	{
+		.name = "reclaim",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = memory_reclaim_show,
+		.write = memory_reclaim_write,
+	},
 	{ }	/* terminate */
 };
 
@@ -6431,9 +6626,15 @@ static int __init mem_cgroup_init(void)
 	cpuhp_setup_state_nocalls(CPUHP_MM_MEMCQ_DEAD, "mm/memctrl:dead", NULL,
 				  memcg_hotplug_cpu_dead);
 
-	for_each_possible_cpu(cpu)
+	for_each_possible_cpu(cpu) {
 		INIT_WORK(&per_cpu_ptr(&memcg_stock, cpu)->work,
 			  drain_local_stock);
+		INIT_WORK(per_cpu_ptr(&memcg_stat_flush_work, cpu),
+			  memcg_stat_flush_local);
+	}
+	if (!mem_cgroup_disabled())
+		schedule_delayed_work(&memcg_stat_shepherd,
+			round_jiffies_relative(MEMCG_STAT_FLUSH_INTERVAL));
 
 	for_each_node(node) {
 		struct mem_cgroup_tree_per_node *rtpn;
@@ -3582,6 +3582,59 @@ static int __init fault_around_debugfs(void)
 late_initcall(fault_around_debugfs);
 #endif
 
+/*
+ * vma->fault_around_info packs the address just past the last fault-around
+ * window with the order of that window, in the bits below PAGE_SHIFT.
+ * Zero means the vma has not faulted yet.
+ */
+#define FAULT_AROUND_ORDER(v)		((v) & ~PAGE_MASK)
+#define FAULT_AROUND_ADDR(v)		((v) & PAGE_MASK)
+#define FAULT_AROUND_VAL(addr, order)	(((addr) & PAGE_MASK) | (order))
+
+/*
+ * The number of pages do_fault_around() should try to map for this fault.
+ *
+ * MADV_RANDOM turns fault-around off for the vma and MADV_SEQUENTIAL maps
+ * up to a whole page table.  Otherwise the window starts at
+ * fault_around_bytes and adapts to the vma's access pattern: it doubles
+ * whenever a fault lands just past the previous window, as a sequential
+ * scan does, and halves on any other fault, so random access through an
+ * mmap'd file soon stops mapping pages it never touches.
+ */
+static unsigned long fault_around_pages(struct vm_fault *vmf)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	unsigned long nr_pages = READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
+	unsigned long info, next, size;
+	unsigned int order;
+
+	if (nr_pages <= 1 || (vma->vm_flags & VM_RAND_READ))
+		return 1;
+	if (vma->vm_flags & VM_SEQ_READ)
+		return PTRS_PER_PTE;
+
+	info = atomic_long_read(&vma->fault_around_info);
+	if (!info) {
+		order = ilog2(nr_pages);
+	} else {
+		order = FAULT_AROUND_ORDER(info);
+		next = FAULT_AROUND_ADDR(info);
+		if (vmf->address >= next &&
+		    vmf->address - next < (PAGE_SIZE << order)) {
+			if ((1UL << order) < PTRS_PER_PTE)
+				order++;
+		} else if (order) {
+			order--;
+		}
+	}
+
+	size = PAGE_SIZE << order;
+	atomic_long_set(&vma->fault_around_info,
+			FAULT_AROUND_VAL((vmf->address & ~(size - 1)) + size,
+					 order));
+	return 1UL << order;
+}
+
 /*
  * do_fault_around() tries to map few pages around the fault address. The hope
  * is that the pages will be needed soon and this will lower the number of
@@ -3597,24 +3650,22 @@ late_initcall(fault_around_debugfs);
  * This function doesn't cross the VMA boundaries, in order to call map_pages()
  * only once.
  *
- * fault_around_bytes defines how many bytes we'll try to map.
- * do_fault_around() expects it to be set to a power of two less than or equal
+ * @nr_pages, from fault_around_pages(), defines how many pages we'll try to
+ * map.  do_fault_around() expects it to be a power of two less than or equal
  * to PTRS_PER_PTE.
  *
  * The virtual address of the area that we map is naturally aligned to
- * fault_around_bytes rounded down to the machine page size
- * (and therefore to page order).  This way it's easier to guarantee
- * that we don't cross page table boundaries.
+ * @nr_pages pages (and therefore to page order).  This way it's easier to
+ * guarantee that we don't cross page table boundaries.
  */
-static vm_fault_t do_fault_around(struct vm_fault *vmf)
+static vm_fault_t do_fault_around(struct vm_fault *vmf, unsigned long nr_pages)
 {
-	unsigned long address = vmf->address, nr_pages, mask;
+	unsigned long address = vmf->address, mask;
 	pgoff_t start_pgoff = vmf->pgoff;
 	pgoff_t end_pgoff;
 	int off;
 	vm_fault_t ret = 0;
 
-	nr_pages = READ_ONCE(fault_around_bytes) >> PAGE_SHIFT;
 	mask = ~(nr_pages * PAGE_SIZE - 1) & PAGE_MASK;
 
 	vmf->address = max(address & mask, vmf->vma->vm_start);
@@ -3672,10 +3723,14 @@ static vm_fault_t do_read_fault(struct vm_fault *vmf)
 	 * if page by the offset is not ready to be mapped (cold cache or
 	 * something).
 	 */
-	if (vma->vm_ops->map_pages && fault_around_bytes >> PAGE_SHIFT > 1) {
-		ret = do_fault_around(vmf);
-		if (ret)
-			return ret;
+	if (vma->vm_ops->map_pages) {
+		unsigned long nr_pages = fault_around_pages(vmf);
+
+		if (nr_pages > 1) {
+			ret = do_fault_around(vmf, nr_pages);
+			if (ret)
+				return ret;
+		}
 	}
 
 	ret = __do_fault(vmf);
@@ -2441,7 +2441,15 @@ int mpol_misplaced(struct page *page, struct vm_area_struct *vma, unsigned long
 	if (pol->flags & MPOL_F_MORON) {
 		polnid = thisnid;
 
-		if (!should_numa_migrate_memory(current, page, curnid, thiscpu))
+		/*
+		 * A page that was demoted to a slower node and is being
+		 * referenced again is promoted straight away rather than
+		 * waiting for the two-pass cpupid filter.
+		 */
+		if (!(numa_demotion_enabled &&
+		      node_is_demotion_target(curnid) &&
+		      !node_is_demotion_target(polnid)) &&
+		    !should_numa_migrate_memory(current, page, curnid, thiscpu))
 			goto out;
 	}
 
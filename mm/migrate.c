@@ -40,6 +40,7 @@
 #include <linux/gfp.h>
 #include <linux/pfn_t.h>
 #include <linux/memremap.h>
+#include <linux/memory.h>
 #include <linux/userfaultfd_k.h>
 #include <linux/balloon_compaction.h>
 #include <linux/mmu_notifier.h>
@@ -1997,8 +1998,11 @@ int migrate_misplaced_page(struct page *page, struct vm_area_struct *vma,
 			putback_lru_page(page);
 		}
 		isolated = 0;
-	} else
+	} else {
 		count_vm_numa_event(NUMA_PAGE_MIGRATE);
+		if (node_is_demotion_target(page_to_nid(page)))
+			count_vm_numa_event(PGPROMOTE_SUCCESS);
+	}
 	BUG_ON(!list_empty(&migratepages));
 	return isolated;
 
@@ -2126,6 +2130,8 @@ int migrate_misplaced_transhuge_page(struct mm_struct *mm,
 
 	count_vm_events(PGMIGRATE_SUCCESS, HPAGE_PMD_NR);
 	count_vm_numa_events(NUMA_PAGE_MIGRATE, HPAGE_PMD_NR);
+	if (node_is_demotion_target(page_to_nid(page)))
+		count_vm_numa_events(PGPROMOTE_SUCCESS, HPAGE_PMD_NR);
 
 	mod_node_page_state(page_pgdat(page),
 			NR_ISOLATED_ANON + page_lru,
@@ -3011,3 +3017,148 @@ int migrate_vma(const struct migrate_vma_ops *ops,
 }
 EXPORT_SYMBOL(migrate_vma);
 #endif /* defined(MIGRATE_VMA_HELPER) */
+
+#ifdef CONFIG_NUMA
+/*
+ * Nodes with memory but no CPUs (persistent memory, memory behind a CXL
+ * or similar interconnect) are treated as a slower tier. When enabled,
+ * reclaim on a node with CPUs migrates cold pages to the nearest such
+ * node instead of evicting them (see shrink_page_list()), and NUMA hinting
+ * faults promote the pages that turn hot again (see mpol_misplaced()).
+ */
+bool numa_demotion_enabled __read_mostly;
+
+static int node_demotion[MAX_NUMNODES] __read_mostly = {
+	[0 ... MAX_NUMNODES - 1] = NUMA_NO_NODE
+};
+static nodemask_t demotion_targets __read_mostly;
+static DEFINE_MUTEX(demotion_mutex);
+
+/*
+ * Return the node cold pages on @node should be demoted to, or
+ * NUMA_NO_NODE. The result may be stale against a concurrent memory
+ * hotplug event, so callers allocate with __GFP_THISNODE and cope with
+ * failure.
+ */
+int next_demotion_node(int node)
+{
+	int target = READ_ONCE(node_demotion[node]);
+
+	if (target != NUMA_NO_NODE && !node_state(target, N_MEMORY))
+		return NUMA_NO_NODE;
+	return target;
+}
+
+bool node_is_demotion_target(int node)
+{
+	return node_isset(node, demotion_targets);
+}
+
+static void set_demotion_targets(void)
+{
+	nodemask_t targets = NODE_MASK_NONE;
+	int node, target, best;
+
+	mutex_lock(&demotion_mutex);
+	for_each_node(node) {
+		best = NUMA_NO_NODE;
+		if (node_state(node, N_MEMORY) && node_state(node, N_CPU)) {
+			for_each_node_state(target, N_MEMORY) {
+				if (node_state(target, N_CPU))
+					continue;
+				if (best == NUMA_NO_NODE ||
+				    node_distance(node, target) <
+				    node_distance(node, best))
+					best = target;
+			}
+		}
+		if (best != NUMA_NO_NODE)
+			node_set(best, targets);
+		WRITE_ONCE(node_demotion[node], best);
+	}
+	demotion_targets = targets;
+	mutex_unlock(&demotion_mutex);
+}
+
+#ifdef CONFIG_MEMORY_HOTPLUG
+static int demotion_memory_callback(struct notifier_block *self,
+				    unsigned long action, void *arg)
+{
+	switch (action) {
+	case MEM_ONLINE:
+	case MEM_OFFLINE:
+		set_demotion_targets();
+		break;
+	}
+	return notifier_from_errno(0);
+}
+#endif
+
+#ifdef CONFIG_SYSFS
+static ssize_t demotion_enabled_show(struct kobject *kobj,
+				     struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%s\n",
+		       numa_demotion_enabled ? "true" : "false");
+}
+
+static ssize_t demotion_enabled_store(struct kobject *kobj,
+				      struct kobj_attribute *attr,
+				      const char *buf, size_t count)
+{
+	bool enabled;
+	int err;
+
+	err = kstrtobool(buf, &enabled);
+	if (err)
+		return err;
+
+	WRITE_ONCE(numa_demotion_enabled, enabled);
+	return count;
+}
+
+static struct kobj_attribute numa_demotion_enabled_attr =
+	__ATTR(demotion_enabled, 0644, demotion_enabled_show,
+	       demotion_enabled_store);
+
+static struct attribute *numa_attrs[] = {
+	&numa_demotion_enabled_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group numa_attr_group = {
+	.attrs = numa_attrs,
+};
+
+static int __init numa_init_sysfs(void)
+{
+	struct kobject *numa_kobj;
+	int err;
+
+	numa_kobj = kobject_create_and_add("numa", mm_kobj);
+	if (!numa_kobj) {
+		pr_err("failed to create numa kobject\n");
+		return -ENOMEM;
+	}
+	err = sysfs_create_group(numa_kobj, &numa_attr_group);
+	if (err) {
+		pr_err("failed to register numa group\n");
+		kobject_put(numa_kobj);
+	}
+	return err;
+}
+#else
+static inline int numa_init_sysfs(void)
+{
+	return 0;
+}
+#endif /* CONFIG_SYSFS */
+
+static int __init demotion_init(void)
+{
+	set_demotion_targets();
+	hotplug_memory_notifier(demotion_memory_callback, 100);
+	return numa_init_sysfs();
+}
+subsys_initcall(demotion_init);
+#endif /* CONFIG_NUMA */
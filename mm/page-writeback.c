@@ -1086,7 +1086,24 @@ static void wb_update_write_bandwidth(struct bdi_writeback *wb,
 	const unsigned long period = roundup_pow_of_two(3 * HZ);
 	unsigned long avg = wb->avg_write_bandwidth;
 	unsigned long old = wb->write_bandwidth;
+	unsigned long completed = written - min(written, wb->written_stamp);
 	u64 bw;
+	u64 lat;
+
+	/*
+	 * Completion latency of a page queued for writeback now, by Little's
+	 * law: the pages still under writeback over the rate at which this
+	 * interval actually completed them.  An interval in which the device
+	 * completed nothing counts as a stall of the whole interval per page.
+	 * It is followed up quickly and let down slowly, so that one quiet
+	 * interval on bursty flash does not lift the dirty limit again.
+	 */
+	lat = (u64)wb_stat(wb, WB_WRITEBACK) * jiffies_to_msecs(elapsed);
+	do_div(lat, max(completed, 1UL));
+	if (lat > wb->avg_write_latency)
+		wb->avg_write_latency += (lat - wb->avg_write_latency) >> 1;
+	else
+		wb->avg_write_latency -= (wb->avg_write_latency - lat) >> 3;
 
 	/*
 	 * bw = written * HZ / elapsed
@@ -1098,7 +1115,7 @@ static void wb_update_write_bandwidth(struct bdi_writeback *wb,
 	 * @written may have decreased due to account_page_redirty().
 	 * Avoid underflowing @bw calculation.
 	 */
-	bw = written - min(written, wb->written_stamp);
+	bw = completed;
 	bw *= HZ;
 	if (unlikely(elapsed > period)) {
 		do_div(bw, elapsed);
@@ -1509,6 +1526,33 @@ static long wb_min_pause(struct bdi_writeback *wb,
 	return pages >= DIRTY_POLL_THRESH ? 1 + t / 2 : t;
 }
 
+/*
+ * With a latency target set on the bdi, scale wb_thresh down by how far the
+ * measured writeback completion latency overshoots it.  Bandwidth alone
+ * swings too much on flash with bursty write latency: the wb ends up with
+ * more dirty pages than it can clean in time and its dirtiers stall for
+ * seconds at a time.  Keeping wb_dirty lower spreads that throttling out
+ * over shorter pauses.  It never goes below what the wb cleans within the
+ * target at its average bandwidth.
+ */
+static void wb_latency_limit(struct dirty_throttle_control *dtc)
+{
+	struct bdi_writeback *wb = dtc->wb;
+	unsigned int target = READ_ONCE(wb->bdi->latency_target_ms);
+	unsigned long latency = wb->avg_write_latency;
+	unsigned long thresh = dtc->wb_thresh;
+	unsigned long floor;
+
+	if (!target || latency <= target)
+		return;
+
+	floor = div_u64((u64)wb->avg_write_bandwidth * target, MSEC_PER_SEC);
+	dtc->wb_thresh = max_t(unsigned long,
+			       div_u64((u64)thresh * target, latency),
+			       min(floor, thresh));
+	trace_wb_dirty_latency(wb, latency, target, thresh, dtc->wb_thresh);
+}
+
 static inline void wb_dirty_limits(struct dirty_throttle_control *dtc)
 {
 	struct bdi_writeback *wb = dtc->wb;
@@ -1528,6 +1572,7 @@ static inline void wb_dirty_limits(struct dirty_throttle_control *dtc)
 	 *   at some rate <= (write_bw / 2) for bringing down wb_dirty.
 	 */
 	dtc->wb_thresh = __wb_calc_thresh(dtc);
+	wb_latency_limit(dtc);
 	dtc->wb_bg_thresh = dtc->thresh ?
 		div_u64((u64)dtc->wb_thresh * dtc->bg_thresh, dtc->thresh) : 0;
 
@@ -1127,13 +1127,13 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 		 */
 		do {
 			batch_free++;
-			if (++migratetype == MIGRATE_PCPTYPES)
+			if (++migratetype == NR_PCP_LISTS)
 				migratetype = 0;
 			list = &pcp->lists[migratetype];
 		} while (list_empty(list));
 
 		/* This is the only non-empty list. Free them all. */
-		if (batch_free == MIGRATE_PCPTYPES)
+		if (batch_free == NR_PCP_LISTS)
 			batch_free = count;
 
 		do {
@@ -1182,6 +1182,56 @@ static void free_pcppages_bulk(struct zone *zone, int count,
 	spin_unlock(&zone->lock);
 }
 
+/* Blocks of @order moved between the pcp lists and the buddy lists at once */
+static inline int pcp_order_batch(struct per_cpu_pages *pcp,
+				  unsigned int order)
+{
+	return max(READ_ONCE(pcp->batch) >> order, 1);
+}
+
+/*
+ * Frees count blocks of the given order from the high-order PCP lists,
+ * oldest first, under a single hold of the zone lock.
+ */
+static void free_pcppages_high_order(struct zone *zone, int count,
+				     struct per_cpu_pages *pcp,
+				     unsigned int order)
+{
+	struct list_head *lists = pcp->order_lists[order - 1];
+	bool isolated_pageblocks;
+	int migratetype;
+
+	spin_lock(&zone->lock);
+	isolated_pageblocks = has_isolate_pageblock(zone);
+
+	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++) {
+		struct list_head *list = &lists[migratetype];
+
+		while (count && !list_empty(list)) {
+			struct page *page;
+			int mt;
+
+			page = list_last_entry(list, struct page, lru);
+			list_del(&page->lru);
+			pcp->order_count[order - 1]--;
+			count--;
+
+			if (bulkfree_pcp_prepare(page))
+				continue;
+
+			mt = get_pcppage_migratetype(page);
+			/* Pageblock could have been isolated meanwhile */
+			if (unlikely(isolated_pageblocks))
+				mt = get_pageblock_migratetype(page);
+
+			__free_one_page(page, page_to_pfn(page), zone, order,
+					mt);
+			trace_mm_page_pcpu_drain(page, order, mt);
+		}
+	}
+	spin_unlock(&zone->lock);
+}
+
 static void free_one_page(struct zone *zone,
 				struct page *page, unsigned long pfn,
 				unsigned int order,
@@ -1888,40 +1938,41 @@ static inline bool free_pages_prezeroed(void)
 		page_poisoning_enabled();
 }
 
+static bool check_new_pages(struct page *page, unsigned int order)
+{
+	int i;
+	for (i = 0; i < (1 << order); i++) {
+		struct page *p = page + i;
+
+		if (unlikely(check_new_page(p)))
+			return true;
+	}
+
+	return false;
+}
+
+/* High-order pcp blocks are checked page by page, like the buddy path */
 #ifdef CONFIG_DEBUG_VM
-static bool check_pcp_refill(struct page *page)
+static bool check_pcp_refill(struct page *page, unsigned int order)
 {
 	return false;
 }
 
-static bool check_new_pcp(struct page *page)
+static bool check_new_pcp(struct page *page, unsigned int order)
 {
-	return check_new_page(page);
+	return check_new_pages(page, order);
 }
 #else
-static bool check_pcp_refill(struct page *page)
+static bool check_pcp_refill(struct page *page, unsigned int order)
 {
-	return check_new_page(page);
+	return check_new_pages(page, order);
 }
-static bool check_new_pcp(struct page *page)
+static bool check_new_pcp(struct page *page, unsigned int order)
 {
 	return false;
 }
 #endif /* CONFIG_DEBUG_VM */
 
-static bool check_new_pages(struct page *page, unsigned int order)
-{
-	int i;
-	for (i = 0; i < (1 << order); i++) {
-		struct page *p = page + i;
-
-		if (unlikely(check_new_page(p)))
-			return true;
-	}
-
-	return false;
-}
-
 inline void post_alloc_hook(struct page *page, unsigned int order,
 				gfp_t gfp_flags)
 {
@@ -2475,7 +2526,8 @@ __rmqueue(struct zone *zone, unsigned int order, int migratetype)
 		if (migratetype == MIGRATE_MOVABLE)
 			page = __rmqueue_cma_fallback(zone, order);
 
-		if (!page && __rmqueue_fallback(zone, order, migratetype))
+		if (!page && !is_migrate_cma(migratetype) &&
+		    __rmqueue_fallback(zone, order, migratetype))
 			goto retry;
 	}
 
@@ -2500,7 +2552,7 @@ static int rmqueue_bulk(struct zone *zone, unsigned int order,
 		if (unlikely(page == NULL))
 			break;
 
-		if (unlikely(check_pcp_refill(page)))
+		if (unlikely(check_pcp_refill(page, order)))
 			continue;
 
 		/*
@@ -2566,6 +2618,7 @@ static void drain_pages_zone(unsigned int cpu, struct zone *zone)
 	unsigned long flags;
 	struct per_cpu_pageset *pset;
 	struct per_cpu_pages *pcp;
+	unsigned int order;
 
 	local_irq_save(flags);
 	pset = per_cpu_ptr(zone->pageset, cpu);
@@ -2573,6 +2626,12 @@ static void drain_pages_zone(unsigned int cpu, struct zone *zone)
 	pcp = &pset->pcp;
 	if (pcp->count)
 		free_pcppages_bulk(zone, pcp->count, pcp);
+	for (order = 1; order <= PCP_HIGH_ORDER; order++) {
+		if (pcp->order_count[order - 1])
+			free_pcppages_high_order(zone,
+					pcp->order_count[order - 1],
+					pcp, order);
+	}
 	local_irq_restore(flags);
 }
 
@@ -2670,12 +2729,12 @@ void drain_all_pages(struct zone *zone)
 
 		if (zone) {
 			pcp = per_cpu_ptr(zone->pageset, cpu);
-			if (pcp->pcp.count)
+			if (pcp_total_pages(&pcp->pcp))
 				has_pcps = true;
 		} else {
 			for_each_populated_zone(z) {
 				pcp = per_cpu_ptr(z->pageset, cpu);
-				if (pcp->pcp.count) {
+				if (pcp_total_pages(&pcp->pcp)) {
 					has_pcps = true;
 					break;
 				}
@@ -2770,28 +2829,32 @@ static void free_unref_page_commit(struct page *page, unsigned long pfn)
 {
 	struct zone *zone = page_zone(page);
 	struct per_cpu_pages *pcp;
-	int migratetype;
+	int migratetype, pindex;
 
 	migratetype = get_pcppage_migratetype(page);
 	__count_vm_event(PGFREE);
 
 	/*
-	 * We only track unmovable, reclaimable and movable on pcp lists.
+	 * We only track unmovable, reclaimable, movable and CMA on pcp lists.
 	 * Free ISOLATE pages back to the allocator because they are being
 	 * offlined but treat HIGHATOMIC as movable pages so we can get those
 	 * areas back if necessary. Otherwise, we may have to free
 	 * excessively into the page allocator
 	 */
-	if (migratetype >= MIGRATE_PCPTYPES) {
-		if (unlikely(is_migrate_isolate(migratetype))) {
-			free_one_page(zone, page, pfn, 0, migratetype);
-			return;
-		}
-		migratetype = MIGRATE_MOVABLE;
+	pindex = MIGRATE_MOVABLE;
+	if (migratetype < MIGRATE_PCPTYPES) {
+		pindex = migratetype;
+#ifdef CONFIG_CMA
+	} else if (is_migrate_cma(migratetype)) {
+		pindex = PCP_CMA_LIST;
+#endif
+	} else if (unlikely(is_migrate_isolate(migratetype))) {
+		free_one_page(zone, page, pfn, 0, migratetype);
+		return;
 	}
 
 	pcp = &this_cpu_ptr(zone->pageset)->pcp;
-	list_add(&page->lru, &pcp->lists[migratetype]);
+	list_add(&page->lru, &pcp->lists[pindex]);
 	pcp->count++;
 	if (pcp->count >= pcp->high) {
 		unsigned long batch = READ_ONCE(pcp->batch);
@@ -2799,6 +2862,45 @@ static void free_unref_page_commit(struct page *page, unsigned long pfn)
 	}
 }
 
+/*
+ * Free a page of order 1 to PCP_HIGH_ORDER to the high-order pcp lists
+ */
+static void free_unref_page_order(struct page *page, unsigned int order)
+{
+	unsigned long flags;
+	unsigned long pfn = page_to_pfn(page);
+	struct zone *zone = page_zone(page);
+	struct per_cpu_pages *pcp;
+	int migratetype, batch;
+
+	if (!free_pages_prepare(page, order, true))
+		return;
+
+	migratetype = get_pfnblock_migratetype(page, pfn);
+	local_irq_save(flags);
+	__count_vm_events(PGFREE, 1 << order);
+
+	/*
+	 * Only the pcp migratetypes have high-order lists. CMA, HIGHATOMIC
+	 * and ISOLATE blocks go back to the buddy allocator under their own
+	 * type, so that they are neither handed out as movable nor lost to
+	 * their reserve.
+	 */
+	if (migratetype >= MIGRATE_PCPTYPES) {
+		free_one_page(zone, page, pfn, order, migratetype);
+		goto out;
+	}
+	set_pcppage_migratetype(page, migratetype);
+
+	pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	list_add(&page->lru, &pcp->order_lists[order - 1][migratetype]);
+	batch = pcp_order_batch(pcp, order);
+	if (++pcp->order_count[order - 1] >= 2 * batch)
+		free_pcppages_high_order(zone, batch, pcp, order);
+out:
+	local_irq_restore(flags);
+}
+
 /*
  * Free a 0-order page
  */
@@ -2969,8 +3071,44 @@ static struct page *__rmqueue_pcplist(struct zone *zone, int migratetype,
 		page = list_first_entry(list, struct page, lru);
 		list_del(&page->lru);
 		pcp->count--;
-	} while (check_new_pcp(page));
+	} while (check_new_pcp(page, 0));
+
+	return page;
+}
+
+/* Remove a high-order block from the per-cpu lists, refilling in batches */
+static struct page *rmqueue_pcplist_order(struct zone *preferred_zone,
+			struct zone *zone, unsigned int order,
+			int migratetype)
+{
+	struct per_cpu_pages *pcp;
+	struct list_head *list;
+	struct page *page;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	list = &pcp->order_lists[order - 1][migratetype];
+	do {
+		if (list_empty(list)) {
+			pcp->order_count[order - 1] += rmqueue_bulk(zone,
+					order, pcp_order_batch(pcp, order),
+					list, migratetype);
+			if (unlikely(list_empty(list))) {
+				page = NULL;
+				goto out;
+			}
+		}
+
+		page = list_first_entry(list, struct page, lru);
+		list_del(&page->lru);
+		pcp->order_count[order - 1]--;
+	} while (check_new_pcp(page, order));
 
+	__count_zid_vm_events(PGALLOC, page_zonenum(page), 1 << order);
+	zone_statistics(preferred_zone, zone);
+out:
+	local_irq_restore(flags);
 	return page;
 }
 
@@ -2981,13 +3119,26 @@ static struct page *rmqueue_pcplist(struct zone *preferred_zone,
 {
 	struct per_cpu_pages *pcp;
 	struct list_head *list;
-	struct page *page;
+	struct page *page = NULL;
 	unsigned long flags;
 
 	local_irq_save(flags);
 	pcp = &this_cpu_ptr(zone->pageset)->pcp;
-	list = &pcp->lists[migratetype];
-	page = __rmqueue_pcplist(zone,  migratetype, pcp, list);
+#ifdef CONFIG_CMA
+	/*
+	 * Page cache that can simply be dropped again takes free CMA pages
+	 * first, which leaves fewer anonymous pages for cma_alloc() to
+	 * migrate out of the area.
+	 */
+	if ((gfp_flags & __GFP_CMA) && migratetype == MIGRATE_MOVABLE) {
+		list = &pcp->lists[PCP_CMA_LIST];
+		page = __rmqueue_pcplist(zone, MIGRATE_CMA, pcp, list);
+	}
+#endif
+	if (!page) {
+		list = &pcp->lists[migratetype];
+		page = __rmqueue_pcplist(zone,  migratetype, pcp, list);
+	}
 	if (page) {
 		__count_zid_vm_events(PGALLOC, page_zonenum(page), 1 << order);
 		zone_statistics(preferred_zone, zone);
@@ -2997,7 +3148,8 @@ static struct page *rmqueue_pcplist(struct zone *preferred_zone,
 }
 
 /*
- * Allocate a page from the given zone. Use pcplists for order-0 allocations.
+ * Allocate a page from the given zone. Use pcplists for order-0 and small
+ * high-order allocations.
  */
 static inline
 struct page *rmqueue(struct zone *preferred_zone,
@@ -3007,6 +3159,7 @@ struct page *rmqueue(struct zone *preferred_zone,
 {
 	unsigned long flags;
 	struct page *page;
+	bool cma;
 
 	if (likely(order == 0)) {
 		page = rmqueue_pcplist(preferred_zone, zone, order,
@@ -3014,6 +3167,20 @@ struct page *rmqueue(struct zone *preferred_zone,
 		goto out;
 	}
 
+	/*
+	 * The buddy path below still gets to try the highatomic reserve.
+	 * CMA blocks have no high-order pcp lists, so __GFP_CMA goes
+	 * straight to the buddy CMA free lists as well.
+	 */
+	cma = IS_ENABLED(CONFIG_CMA) && (gfp_flags & __GFP_CMA) &&
+	      migratetype == MIGRATE_MOVABLE;
+	if (order <= PCP_HIGH_ORDER && !cma) {
+		page = rmqueue_pcplist_order(preferred_zone, zone, order,
+				migratetype);
+		if (page)
+			goto out;
+	}
+
 	/*
 	 * We most definitely don't want callers attempting to
 	 * allocate greater than order-1 page units with __GFP_NOFAIL.
@@ -3028,6 +3195,8 @@ struct page *rmqueue(struct zone *preferred_zone,
 			if (page)
 				trace_mm_page_alloc_zone_locked(page, order, migratetype);
 		}
+		if (!page && cma)
+			page = __rmqueue_cma_fallback(zone, order);
 		if (!page)
 			page = __rmqueue(zone, order, migratetype);
 	} while (page && check_new_pages(page, order));
@@ -4455,6 +4624,8 @@ static inline void free_the_page(struct page *page, unsigned int order)
 {
 	if (order == 0)		/* Via pcp? */
 		free_unref_page(page);
+	else if (order <= PCP_HIGH_ORDER)
+		free_unref_page_order(page, order);
 	else
 		__free_pages_ok(page, order);
 }
@@ -4886,7 +5057,8 @@ void show_free_areas(unsigned int filter, nodemask_t *nodemask)
 			continue;
 
 		for_each_online_cpu(cpu)
-			free_pcp += per_cpu_ptr(zone->pageset, cpu)->pcp.count;
+			free_pcp += pcp_total_pages(
+					&per_cpu_ptr(zone->pageset, cpu)->pcp);
 	}
 
 	printk("active_anon:%lu inactive_anon:%lu isolated_anon:%lu\n"
@@ -4972,7 +5144,8 @@ void show_free_areas(unsigned int filter, nodemask_t *nodemask)
 
 		free_pcp = 0;
 		for_each_online_cpu(cpu)
-			free_pcp += per_cpu_ptr(zone->pageset, cpu)->pcp.count;
+			free_pcp += pcp_total_pages(
+					&per_cpu_ptr(zone->pageset, cpu)->pcp);
 
 		show_node(zone);
 		printk(KERN_CONT
@@ -5665,14 +5838,18 @@ static void pageset_set_batch(struct per_cpu_pageset *p, unsigned long batch)
 static void pageset_init(struct per_cpu_pageset *p)
 {
 	struct per_cpu_pages *pcp;
-	int migratetype;
+	int migratetype, order;
 
 	memset(p, 0, sizeof(*p));
 
 	pcp = &p->pcp;
 	pcp->count = 0;
-	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
+	for (migratetype = 0; migratetype < NR_PCP_LISTS; migratetype++)
 		INIT_LIST_HEAD(&pcp->lists[migratetype]);
+	for (order = 0; order < PCP_HIGH_ORDER; order++)
+		for (migratetype = 0; migratetype < MIGRATE_PCPTYPES;
+		     migratetype++)
+			INIT_LIST_HEAD(&pcp->order_lists[order][migratetype]);
 }
 
 static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
@@ -37,13 +37,13 @@
  * percpu variables from kernel modules.  Finally, the dynamic section
  * takes care of normal allocations.
  *
- * The allocator organizes chunks into lists according to free size and
- * tries to allocate from the fullest chunk first.  Each chunk is managed
- * by a bitmap with metadata blocks.  The allocation map is updated on
- * every allocation and free to reflect the current state while the boundary
- * map is only updated on allocation.  Each metadata block contains
- * information to help mitigate the need to iterate over large portions
- * of the bitmap.  The reverse mapping from page to chunk is stored in
+ * The allocator organizes chunks into lists according to the largest free
+ * contiguous area and tries to allocate from the fullest chunk first.  Each
+ * chunk is managed by a bitmap with metadata blocks.  The allocation map is
+ * updated on every allocation and free to reflect the current state while
+ * the boundary map is only updated on allocation.  Each metadata block
+ * contains information to help mitigate the need to iterate over large
+ * portions of the bitmap.  The reverse mapping from page to chunk is stored in
  * the page's index.  Lastly, units are lazily backed and grow in unison.
  *
  * There is a unique conversion that goes on here between bytes and bits.
@@ -229,12 +229,20 @@ static int pcpu_size_to_slot(int size)
 	return __pcpu_size_to_slot(size);
 }
 
+/*
+ * Chunks are slotted by their contig hint rather than by free_bytes: a chunk
+ * whose free space is scattered in pieces too small for the request then
+ * sits below the request's slot, and pcpu_alloc() never has to visit it
+ * under pcpu_lock only to fail the contig check in pcpu_find_block_fit().
+ */
 static int pcpu_chunk_slot(const struct pcpu_chunk *chunk)
 {
+	int contig_bytes = chunk->contig_bits * PCPU_MIN_ALLOC_SIZE;
+
 	if (chunk->free_bytes < PCPU_MIN_ALLOC_SIZE || chunk->contig_bits == 0)
 		return 0;
 
-	return pcpu_size_to_slot(chunk->free_bytes);
+	return pcpu_size_to_slot(contig_bytes);
 }
 
 /* set the pointer to a chunk in a page struct */
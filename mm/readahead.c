@@ -285,6 +285,78 @@ static unsigned long get_next_ra_size(struct file_ra_state *ra,
 	return min(newsize, max);
 }
 
+/*
+ * Hit-rate feedback. Each time a readahead window is replaced, its pages
+ * are counted as used if the stream carried on into the next window, or
+ * split at the last read position if the reader went elsewhere. Once a
+ * file has seen RA_FEEDBACK_PERIOD such pages its maximum window is halved
+ * when more than a quarter were wasted and doubled when under one in
+ * sixteen were, between RA_MIN_PAGES and four times the device default
+ * (or its optimal I/O size, if larger). The history then decays by half.
+ * Wasteful files also pipeline less: the async trigger moves to the
+ * middle of the window rather than its start.
+ */
+#define RA_FEEDBACK_PERIOD	256
+#define RA_MIN_PAGES		4UL
+
+static void ra_feedback(struct backing_dev_info *bdi,
+			struct file_ra_state *ra,
+			unsigned long used, unsigned long wasted)
+{
+	unsigned long total, floor, ceiling;
+
+	atomic_long_add(used, &bdi->ra_hit_pages);
+	atomic_long_add(wasted, &bdi->ra_miss_pages);
+
+	ra->hit_pages += used;
+	ra->miss_pages += wasted;
+	total = ra->hit_pages + ra->miss_pages;
+	if (total < RA_FEEDBACK_PERIOD)
+		return;
+
+	if (READ_ONCE(bdi->ra_adaptive) && bdi->ra_pages) {
+		floor = min(bdi->ra_pages, RA_MIN_PAGES);
+		ceiling = max(bdi->ra_pages * 4, bdi->io_pages);
+
+		if (ra->miss_pages * 4 > total)
+			ra->ra_pages = max(ra->ra_pages / 2, floor);
+		else if (ra->miss_pages * 16 < total)
+			ra->ra_pages = min(ra->ra_pages * 2, ceiling);
+	}
+
+	ra->hit_pages /= 2;
+	ra->miss_pages /= 2;
+}
+
+/* The previous window was abandoned, count what was read of it */
+static void ra_feedback_abandon(struct backing_dev_info *bdi,
+				struct file_ra_state *ra)
+{
+	unsigned long used = 0;
+	pgoff_t last;
+
+	if (!ra->size)
+		return;
+
+	if (ra->prev_pos >= 0) {
+		last = (unsigned long long)ra->prev_pos >> PAGE_SHIFT;
+		if (last >= ra->start)
+			used = min_t(unsigned long, last - ra->start + 1,
+				     ra->size);
+	}
+
+	ra_feedback(bdi, ra, used, ra->size - used);
+}
+
+static unsigned int ra_async_size(struct file_ra_state *ra)
+{
+	unsigned int total = ra->hit_pages + ra->miss_pages;
+
+	if (ra->size > 1 && ra->miss_pages * 4 > total)
+		return ra->size / 2;
+	return ra->size;
+}
+
 /*
  * On-demand readahead design.
  *
@@ -362,6 +434,8 @@ static int try_context_readahead(struct address_space *mapping,
 	if (size <= req_size)
 		return 0;
 
+	ra_feedback_abandon(inode_to_bdi(mapping->host), ra);
+
 	/*
 	 * starts from beginning of file:
 	 * it is a strong indication of long-run stream (or whole-file-read)
@@ -409,9 +483,10 @@ ondemand_readahead(struct address_space *mapping,
 	 */
 	if ((offset == (ra->start + ra->size - ra->async_size) ||
 	     offset == (ra->start + ra->size))) {
+		ra_feedback(bdi, ra, ra->size, 0);
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max_pages);
-		ra->async_size = ra->size;
+		ra->async_size = ra_async_size(ra);
 		goto readit;
 	}
 
@@ -468,6 +543,7 @@ ondemand_readahead(struct address_space *mapping,
 	return __do_page_cache_readahead(mapping, filp, offset, req_size, 0);
 
 initial_readahead:
+	ra_feedback_abandon(bdi, ra);
 	ra->start = offset;
 	ra->size = get_init_ra_size(req_size, max_pages);
 	ra->async_size = ra->size > req_size ? ra->size - req_size : ra->size;
@@ -3090,6 +3090,65 @@ void kmem_cache_free_bulk(struct kmem_cache *s, size_t size, void **p)
 }
 EXPORT_SYMBOL(kmem_cache_free_bulk);
 
+/*
+ * Bulk refill straight from the node partial lists: detach as much of each
+ * partial slab's freelist as the caller still needs with one cmpxchg per
+ * slab, all under a single hold of list_lock, rather than freezing one slab
+ * per ___slab_alloc() call. The slabs stay unfrozen. One that is emptied of
+ * free objects leaves the partial list like any other full slab and comes
+ * back through __slab_free().
+ *
+ * Must be called with interrupts disabled.
+ */
+static int bulk_alloc_from_partial(struct kmem_cache *s, gfp_t flags,
+				   size_t size, void **p)
+{
+	struct kmem_cache_node *n = get_node(s, numa_mem_id());
+	struct page *page, *page2;
+	int allocated = 0;
+
+	if (!n || !READ_ONCE(n->nr_partial))
+		return 0;
+
+	spin_lock(&n->list_lock);
+	list_for_each_entry_safe(page, page2, &n->partial, lru) {
+		void *freelist, *object;
+		unsigned long counters;
+		struct page new;
+		int taken;
+
+		if (!pfmemalloc_match(page, flags))
+			continue;
+
+		do {
+			freelist = page->freelist;
+			counters = page->counters;
+			new.counters = counters;
+
+			object = freelist;
+			for (taken = 0; object && allocated + taken < size;
+			     taken++) {
+				p[allocated + taken] = object;
+				object = get_freepointer(s, object);
+			}
+			new.inuse += taken;
+		} while (!__cmpxchg_double_slab(s, page,
+				freelist, counters,
+				object, new.counters,
+				"bulk_alloc_from_partial"));
+
+		allocated += taken;
+		stat(s, ALLOC_BULK_PARTIAL);
+		if (!object)
+			remove_partial(n, page);
+		if (allocated == size)
+			break;
+	}
+	spin_unlock(&n->list_lock);
+
+	return allocated;
+}
+
 /* Note that interrupts must be enabled when calling this function. */
 int kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
 			  void **p)
@@ -3122,6 +3181,22 @@ int kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
 			 */
 			c->tid = next_tid(c->tid);
 
+			/*
+			 * Several objects still to go and no cpu partial slab
+			 * to move to: take them from the node partial list
+			 * in one go.
+			 */
+			if (size - i > 1 && !kmem_cache_debug(s) &&
+			    !slub_percpu_partial(c)) {
+				int got = bulk_alloc_from_partial(s, flags,
+							size - i, p + i);
+
+				if (got) {
+					i += got - 1;
+					continue;
+				}
+			}
+
 			/*
 			 * Invoking slow path likely have side-effect
 			 * of re-populating per CPU c->freelist
@@ -5398,6 +5473,7 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(ALLOC_BULK_PARTIAL, alloc_bulk_partial);
 #endif
 
 static struct attribute *slab_attrs[] = {
@@ -5464,6 +5540,7 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&alloc_bulk_partial_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
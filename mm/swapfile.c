@@ -690,6 +690,74 @@ static void swap_range_free(struct swap_info_struct *si, unsigned long offset,
 	}
 }
 
+/*
+ * Memory-backed swap such as zram has no seek cost, so there is nothing to
+ * gain from placing slots carefully under si->lock. Claim free slots from
+ * this CPU's current cluster under the cluster lock alone, and only retake
+ * si->lock to account for them. New clusters are still handed out by the
+ * locked SSD path: a cluster that is still free is left to it, so that the
+ * free cluster list is never touched here.
+ *
+ * Called with si->lock held and SWP_SCANNING raised; returns with si->lock
+ * held.
+ */
+static int scan_swap_map_slots_nolock(struct swap_info_struct *si,
+				      unsigned char usage, int nr,
+				      swp_entry_t slots[])
+{
+	struct percpu_cluster *cluster;
+	struct swap_cluster_info *ci;
+	unsigned long offset, max;
+	int n_ret = 0;
+	int i;
+
+	spin_unlock(&si->lock);
+
+	cluster = get_cpu_ptr(si->percpu_cluster);
+	if (cluster_is_null(&cluster->index))
+		goto out;
+
+	offset = cluster->next;
+	max = min_t(unsigned long, si->max,
+		    (cluster_next(&cluster->index) + 1) * SWAPFILE_CLUSTER);
+	if (offset >= max)
+		goto out;
+
+	ci = lock_cluster(si, offset);
+	if (cluster_is_free(ci)) {
+		unlock_cluster(ci);
+		goto out;
+	}
+	for (; offset < max && n_ret < nr; offset++) {
+		if (si->swap_map[offset])
+			continue;
+		VM_BUG_ON(cluster_count(ci) >= SWAPFILE_CLUSTER);
+		si->swap_map[offset] = usage;
+		cluster_set_count(ci, cluster_count(ci) + 1);
+		slots[n_ret++] = swp_entry(si->type, offset);
+	}
+	unlock_cluster(ci);
+	cluster->next = offset;
+out:
+	put_cpu_ptr(si->percpu_cluster);
+
+	spin_lock(&si->lock);
+	for (i = 0; i < n_ret; i++) {
+		offset = swp_offset(slots[i]);
+		/* swapoff started meanwhile: give the slots back */
+		if (!(si->flags & SWP_WRITEOK)) {
+			ci = lock_cluster(si, offset);
+			si->swap_map[offset] = 0;
+			dec_cluster_info_page(si, si->cluster_info, offset);
+			unlock_cluster(ci);
+			continue;
+		}
+		swap_range_alloc(si, offset, 1);
+	}
+
+	return (si->flags & SWP_WRITEOK) ? n_ret : 0;
+}
+
 static int scan_swap_map_slots(struct swap_info_struct *si,
 			       unsigned char usage, int nr,
 			       swp_entry_t slots[])
@@ -718,6 +786,14 @@ static int scan_swap_map_slots(struct swap_info_struct *si,
 	si->flags += SWP_SCANNING;
 	scan_base = offset = si->cluster_next;
 
+	/* memory-backed swap: try this CPU's cluster without si->lock */
+	if (si->cluster_info && (si->flags & SWP_SYNCHRONOUS_IO) &&
+	    (si->flags & SWP_WRITEOK)) {
+		n_ret = scan_swap_map_slots_nolock(si, usage, nr, slots);
+		if (n_ret)
+			goto done;
+	}
+
 	/* SSD algorithm */
 	if (si->cluster_info) {
 		if (scan_swap_map_try_ssd_cluster(si, &offset, &scan_base))
@@ -326,6 +326,7 @@ EXPORT_SYMBOL(vmalloc_to_pfn);
 
 #define VM_LAZY_FREE	0x02
 #define VM_VM_AREA	0x04
+#define VM_CACHED	0x08
 
 static DEFINE_SPINLOCK(vmap_area_lock);
 /* Export for kexec only */
@@ -341,6 +342,27 @@ static unsigned long cached_align;
 
 static unsigned long vmap_area_pcpu_hole;
 
+/*
+ * Per-cpu caches of purged vmap areas.  Once a purge has flushed the TLB for
+ * a lazily freed area its range can be handed straight out again, so small
+ * areas are parked here, still in the busy tree, rather than erased from it:
+ * alloc_vmap_area() then takes one of the right size without vmap_area_lock
+ * or a walk of the tree.  The purge spreads them over the online cpus, and a
+ * forced purge, when vmalloc space runs short, gives them all back.
+ */
+#define VMAP_CACHE_CLASSES	8	/* areas of 1 to 8 pages, with guard */
+#define VMAP_CACHE_DEPTH	16	/* areas per size class and cpu */
+
+struct vmap_area_cache {
+	spinlock_t lock;
+	unsigned int nr[VMAP_CACHE_CLASSES];
+	struct llist_head list[VMAP_CACHE_CLASSES];
+};
+
+static DEFINE_PER_CPU(struct vmap_area_cache, vmap_area_cache);
+/* next cpu to cache a purged area on, protected by vmap_area_lock */
+static unsigned int vmap_cache_cpu;
+
 static struct vmap_area *__find_vmap_area(unsigned long addr)
 {
 	struct rb_node *n = vmap_area_root.rb_node;
@@ -396,6 +418,68 @@ static void purge_vmap_area_lazy(void);
 
 static BLOCKING_NOTIFIER_HEAD(vmap_notify_list);
 
+static struct vmap_area *vmap_cache_get(unsigned long size,
+					unsigned long align,
+					unsigned long vstart,
+					unsigned long vend)
+{
+	unsigned long nr = size >> PAGE_SHIFT;
+	struct vmap_area_cache *vc;
+	struct llist_node *node;
+	struct vmap_area *va = NULL;
+
+	if (nr > VMAP_CACHE_CLASSES)
+		return NULL;
+
+	vc = get_cpu_ptr(&vmap_area_cache);
+	spin_lock(&vc->lock);
+	node = llist_del_first(&vc->list[nr - 1]);
+	if (node) {
+		va = llist_entry(node, struct vmap_area, purge_list);
+		if (va->va_start >= vstart && va->va_end <= vend &&
+		    IS_ALIGNED(va->va_start, align)) {
+			vc->nr[nr - 1]--;
+			va->flags = 0;
+		} else {
+			llist_add(node, &vc->list[nr - 1]);
+			va = NULL;
+		}
+	}
+	spin_unlock(&vc->lock);
+	put_cpu_ptr(&vmap_area_cache);
+
+	return va;
+}
+
+/* Called with vmap_area_lock held, after the TLB flush for @va */
+static bool vmap_cache_put(struct vmap_area *va)
+{
+	unsigned long nr = (va->va_end - va->va_start) >> PAGE_SHIFT;
+	struct vmap_area_cache *vc;
+	unsigned int cpu;
+	bool cached = false;
+
+	if (nr > VMAP_CACHE_CLASSES)
+		return false;
+
+	cpu = cpumask_next(vmap_cache_cpu, cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		cpu = cpumask_first(cpu_online_mask);
+	vmap_cache_cpu = cpu;
+
+	vc = per_cpu_ptr(&vmap_area_cache, cpu);
+	spin_lock(&vc->lock);
+	if (vc->nr[nr - 1] < VMAP_CACHE_DEPTH) {
+		va->flags = VM_CACHED;
+		llist_add(&va->purge_list, &vc->list[nr - 1]);
+		vc->nr[nr - 1]++;
+		cached = true;
+	}
+	spin_unlock(&vc->lock);
+
+	return cached;
+}
+
 /*
  * Allocate a region of KVA of the specified size and alignment, within the
  * vstart and vend.
@@ -417,6 +501,10 @@ static struct vmap_area *alloc_vmap_area(unsigned long size,
 
 	might_sleep();
 
+	va = vmap_cache_get(size, align, vstart, vend);
+	if (va)
+		return va;
+
 	va = kmalloc_node(sizeof(struct vmap_area),
 			gfp_mask & GFP_RECLAIM_MASK, node);
 	if (unlikely(!va))
@@ -655,9 +743,37 @@ void set_iounmap_nonlazy(void)
 }
 
 /*
- * Purges all lazily-freed vmap areas.
+ * Give every cached area back to the tree, for when vmalloc space runs short.
+ */
+static void vmap_cache_drain(void)
+{
+	struct vmap_area *va, *n_va;
+	struct llist_node *valist;
+	int cpu, i;
+
+	spin_lock(&vmap_area_lock);
+	for_each_possible_cpu(cpu) {
+		struct vmap_area_cache *vc = per_cpu_ptr(&vmap_area_cache, cpu);
+
+		for (i = 0; i < VMAP_CACHE_CLASSES; i++) {
+			spin_lock(&vc->lock);
+			valist = llist_del_all(&vc->list[i]);
+			vc->nr[i] = 0;
+			spin_unlock(&vc->lock);
+
+			llist_for_each_entry_safe(va, n_va, valist, purge_list)
+				__free_vmap_area(va);
+		}
+	}
+	spin_unlock(&vmap_area_lock);
+}
+
+/*
+ * Purges all lazily-freed vmap areas, with a single TLB flush over the range
+ * they span.  Small ones go to the per-cpu caches if @cache is set.
  */
-static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end)
+static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end,
+				   bool cache)
 {
 	struct llist_node *valist;
 	struct vmap_area *va;
@@ -684,7 +800,8 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end)
 	llist_for_each_entry_safe(va, n_va, valist, purge_list) {
 		int nr = (va->va_end - va->va_start) >> PAGE_SHIFT;
 
-		__free_vmap_area(va);
+		if (!cache || !vmap_cache_put(va))
+			__free_vmap_area(va);
 		atomic_sub(nr, &vmap_lazy_nr);
 		cond_resched_lock(&vmap_area_lock);
 	}
@@ -699,19 +816,21 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end)
 static void try_purge_vmap_area_lazy(void)
 {
 	if (mutex_trylock(&vmap_purge_lock)) {
-		__purge_vmap_area_lazy(ULONG_MAX, 0);
+		__purge_vmap_area_lazy(ULONG_MAX, 0, true);
 		mutex_unlock(&vmap_purge_lock);
 	}
 }
 
 /*
- * Kick off a purge of the outstanding lazy areas.
+ * Kick off a purge of the outstanding lazy areas, and empty the per-cpu
+ * caches: this is for when an allocation could not find room.
  */
 static void purge_vmap_area_lazy(void)
 {
 	mutex_lock(&vmap_purge_lock);
 	purge_fragmented_blocks_allcpus();
-	__purge_vmap_area_lazy(ULONG_MAX, 0);
+	vmap_cache_drain();
+	__purge_vmap_area_lazy(ULONG_MAX, 0, false);
 	mutex_unlock(&vmap_purge_lock);
 }
 
@@ -1110,7 +1229,7 @@ void vm_unmap_aliases(void)
 
 	mutex_lock(&vmap_purge_lock);
 	purge_fragmented_blocks_allcpus();
-	if (!__purge_vmap_area_lazy(start, end) && flush)
+	if (!__purge_vmap_area_lazy(start, end, true) && flush)
 		flush_tlb_kernel_range(start, end);
 	mutex_unlock(&vmap_purge_lock);
 }
@@ -1252,6 +1371,8 @@ void __init vmalloc_init(void)
 	for_each_possible_cpu(i) {
 		struct vmap_block_queue *vbq;
 		struct vfree_deferred *p;
+		struct vmap_area_cache *vc;
+		int j;
 
 		vbq = &per_cpu(vmap_block_queue, i);
 		spin_lock_init(&vbq->lock);
@@ -1259,6 +1380,10 @@ void __init vmalloc_init(void)
 		p = &per_cpu(vfree_deferred, i);
 		init_llist_head(&p->list);
 		INIT_WORK(&p->wq, free_work);
+		vc = &per_cpu(vmap_area_cache, i);
+		spin_lock_init(&vc->lock);
+		for (j = 0; j < VMAP_CACHE_CLASSES; j++)
+			init_llist_head(&vc->list[j]);
 	}
 
 	/* Import existing vmlist entries. */
@@ -2716,7 +2841,9 @@ static int s_show(struct seq_file *m, void *p)
 		seq_printf(m, "0x%pK-0x%pK %7ld %s\n",
 			(void *)va->va_start, (void *)va->va_end,
 			va->va_end - va->va_start,
-			va->flags & VM_LAZY_FREE ? "unpurged vm_area" : "vm_map_ram");
+			va->flags & VM_LAZY_FREE ? "unpurged vm_area" :
+			va->flags & VM_CACHED ? "cached vm_area" :
+			"vm_map_ram");
 
 		return 0;
 	}
@@ -96,6 +96,9 @@ struct scan_control {
 
 	unsigned int hibernation_mode:1;
 
+	/* Reclaim must not migrate pages to a slower node */
+	unsigned int no_demotion:1;
+
 	/* One of the zones is ready for compaction */
 	unsigned int compaction_ready:1;
 
@@ -311,6 +314,20 @@ static inline bool memcg_congested(struct pglist_data *pgdat,
 }
 #endif
 
+/*
+ * Can pages reclaimed from @nid be demoted to a slower node instead?
+ * Demotion carries the memcg charge along, so it does nothing for
+ * limit reclaim.
+ */
+static bool can_demote(int nid, struct scan_control *sc)
+{
+	if (!numa_demotion_enabled)
+		return false;
+	if (sc->no_demotion || !global_reclaim(sc))
+		return false;
+	return next_demotion_node(nid) != NUMA_NO_NODE;
+}
+
 /*
  * This misses isolated pages which are not accounted for to save counters.
  * As the data only determines if reclaim or compaction continues, it is
@@ -1087,6 +1104,67 @@ static void page_check_dirty_writeback(struct page *page,
 		mapping->a_ops->is_dirty_writeback(page, dirty, writeback);
 }
 
+static struct page *alloc_demote_page(struct page *page, unsigned long node)
+{
+	/*
+	 * Demotion is only worth it if the target has free memory at
+	 * hand: do not reclaim there on behalf of this node.
+	 */
+	return __alloc_pages_node(node, (GFP_HIGHUSER_MOVABLE &
+					 ~__GFP_RECLAIM) | __GFP_THISNODE |
+					__GFP_NOWARN | __GFP_NOMEMALLOC |
+					GFP_NOWAIT, 0);
+}
+
+/*
+ * Migrate the pages on @demote_pages to the demotion target of @pgdat.
+ * Pages that could not be migrated are left on the list.
+ */
+static unsigned int demote_page_list(struct list_head *demote_pages,
+				     struct pglist_data *pgdat)
+{
+	int target_nid = next_demotion_node(pgdat->node_id);
+	unsigned int nr_pages = 0, nr_remaining = 0, nr_demoted;
+	struct page *page;
+	int err;
+
+	if (list_empty(demote_pages) || target_nid == NUMA_NO_NODE)
+		return 0;
+
+	/*
+	 * The pages are accounted as isolated by our caller, and
+	 * migrate_pages() drops that for each page it consumes. Account
+	 * them once more so the caller's count still balances.
+	 */
+	list_for_each_entry(page, demote_pages, lru) {
+		mod_node_page_state(pgdat, NR_ISOLATED_ANON +
+				    page_is_file_cache(page), 1);
+		nr_pages++;
+	}
+
+	err = migrate_pages(demote_pages, alloc_demote_page, NULL, target_nid,
+			    MIGRATE_ASYNC, MR_DEMOTION);
+
+	list_for_each_entry(page, demote_pages, lru) {
+		mod_node_page_state(pgdat, NR_ISOLATED_ANON +
+				    page_is_file_cache(page), -1);
+		nr_remaining++;
+	}
+
+	/*
+	 * Pages that failed for good are already back on the LRU and are
+	 * counted in @err, as are those still on the list. -ENOMEM stops
+	 * migration early and does not report the earlier failures.
+	 */
+	nr_demoted = err < 0 ? nr_pages - nr_remaining : nr_pages - err;
+	if (current_is_kswapd())
+		count_vm_events(PGDEMOTE_KSWAPD, nr_demoted);
+	else
+		count_vm_events(PGDEMOTE_DIRECT, nr_demoted);
+
+	return nr_demoted;
+}
+
 /*
  * shrink_page_list() returns the number of reclaimed pages
  */
@@ -1099,6 +1177,7 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 {
 	LIST_HEAD(ret_pages);
 	LIST_HEAD(free_pages);
+	LIST_HEAD(demote_pages);
 	int pgactivate = 0;
 	unsigned nr_unqueued_dirty = 0;
 	unsigned nr_dirty = 0;
@@ -1108,9 +1187,12 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 	unsigned nr_immediate = 0;
 	unsigned nr_ref_keep = 0;
 	unsigned nr_unmap_fail = 0;
+	bool do_demote_pass;
 
 	cond_resched();
+	do_demote_pass = can_demote(pgdat->node_id, sc);
 
+retry:
 	while (!list_empty(page_list)) {
 		struct address_space *mapping;
 		struct page *page;
@@ -1261,6 +1343,18 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 			; /* try to reclaim the page below */
 		}
 
+		/*
+		 * Before reclaiming the page, try to move its contents to
+		 * a slower node. THPs are left to the normal path, which
+		 * can split them, and lazyfree pages are simply freed.
+		 */
+		if (do_demote_pass && !PageTransHuge(page) &&
+		    !(PageAnon(page) && !PageSwapBacked(page))) {
+			list_add(&page->lru, &demote_pages);
+			unlock_page(page);
+			continue;
+		}
+
 		/*
 		 * Anonymous process memory has backing store?
 		 * Try to allocate it some swap space here.
@@ -1483,6 +1577,14 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 		VM_BUG_ON_PAGE(PageLRU(page) || PageUnevictable(page), page);
 	}
 
+	nr_reclaimed += demote_page_list(&demote_pages, pgdat);
+	/* Pages that could not be demoted go through normal reclaim */
+	if (!list_empty(&demote_pages)) {
+		list_splice_init(&demote_pages, page_list);
+		do_demote_pass = false;
+		goto retry;
+	}
+
 	mem_cgroup_uncharge_list(&free_pages);
 	try_to_unmap_flush();
 	free_unref_page_list(&free_pages);
@@ -1510,6 +1612,7 @@ unsigned long reclaim_clean_pages_from_list(struct zone *zone,
 		.gfp_mask = GFP_KERNEL,
 		.priority = DEF_PRIORITY,
 		.may_unmap = 1,
+		.no_demotion = 1,
 	};
 	unsigned long ret;
 	struct page *page, *next;
@@ -2211,7 +2314,8 @@ static bool inactive_list_is_low(struct lruvec *lruvec, bool file,
 	 * If we don't have swap space, anonymous page deactivation
 	 * is pointless.
 	 */
-	if (!file && !total_swap_pages)
+	if (!file && !total_swap_pages &&
+	    !can_demote(pgdat->node_id, sc))
 		return false;
 
 	inactive = lruvec_lru_size(lruvec, inactive_lru, sc->reclaim_idx);
@@ -2286,7 +2390,8 @@ static void get_scan_count(struct lruvec *lruvec, struct mem_cgroup *memcg,
 	enum lru_list lru;
 
 	/* If we have no swap space, do not bother scanning anon pages. */
-	if (!sc->may_swap || mem_cgroup_get_nr_swap_pages(memcg) <= 0) {
+	if (!sc->may_swap || (mem_cgroup_get_nr_swap_pages(memcg) <= 0 &&
+			      !can_demote(pgdat->node_id, sc))) {
 		scan_balance = SCAN_FILE;
 		goto out;
 	}
@@ -3336,7 +3441,7 @@ static void age_active_anon(struct pglist_data *pgdat,
 {
 	struct mem_cgroup *memcg;
 
-	if (!total_swap_pages)
+	if (!total_swap_pages && !can_demote(pgdat->node_id, sc))
 		return;
 
 	memcg = mem_cgroup_iter(NULL, NULL, NULL);
@@ -41,6 +41,7 @@
 #include <linux/swapops.h>
 #include <linux/writeback.h>
 #include <linux/pagemap.h>
+#include <linux/blkdev.h>
 
 /*********************************
 * statistics
@@ -123,6 +124,10 @@ static bool zswap_same_filled_pages_enabled = true;
 module_param_named(same_filled_pages_enabled, zswap_same_filled_pages_enabled,
 		   bool, 0644);
 
+/* The number of pool pages to evict each time the pool fills up */
+static unsigned int zswap_writeback_batch = 16;
+module_param_named(writeback_batch, zswap_writeback_batch, uint, 0644);
+
 /*********************************
 * data structures
 **********************************/
@@ -952,20 +957,32 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	return ret;
 }
 
+/*
+ * Evict a batch of the least recently used pool pages rather than one, so
+ * the pool does not refill and stall the next store straight away. The
+ * writeback bios are plugged, which lets the block layer sort them into
+ * swap slot order and merge neighbouring slots before they are issued.
+ */
 static int zswap_shrink(void)
 {
 	struct zswap_pool *pool;
+	struct blk_plug plug;
+	unsigned int reclaimed = 0;
 	int ret;
 
 	pool = zswap_pool_last_get();
 	if (!pool)
 		return -ENOENT;
 
-	ret = zpool_shrink(pool->zpool, 1, NULL);
+	blk_start_plug(&plug);
+	ret = zpool_shrink(pool->zpool, max(zswap_writeback_batch, 1U),
+			   &reclaimed);
+	blk_finish_plug(&plug);
 
 	zswap_pool_put(pool);
 
-	return ret;
+	/* a partial batch still made room */
+	return reclaimed ? 0 : ret;
 }
 
 static int zswap_is_page_same_filled(void *ptr, unsigned long *value)
@@ -1003,6 +1020,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	int ret;
 	unsigned int hlen, dlen = PAGE_SIZE;
 	unsigned long handle, value;
+	bool same_filled = false;
 	char *buf;
 	u8 *src, *dst;
 	struct zswap_header zhdr = { .swpentry = swp_entry(type, offset) };
@@ -1018,8 +1036,18 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 		goto reject;
 	}
 
+	/*
+	 * Same-value filled pages take no pool space, so check for them
+	 * first and keep accepting them while the pool is full.
+	 */
+	if (zswap_same_filled_pages_enabled) {
+		src = kmap_atomic(page);
+		same_filled = zswap_is_page_same_filled(src, &value);
+		kunmap_atomic(src);
+	}
+
 	/* reclaim space if needed */
-	if (zswap_is_full()) {
+	if (!same_filled && zswap_is_full()) {
 		zswap_pool_limit_hit++;
 		if (zswap_shrink()) {
 			zswap_reject_reclaim_fail++;
@@ -1045,17 +1073,12 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 		goto reject;
 	}
 
-	if (zswap_same_filled_pages_enabled) {
-		src = kmap_atomic(page);
-		if (zswap_is_page_same_filled(src, &value)) {
-			kunmap_atomic(src);
-			entry->offset = offset;
-			entry->length = 0;
-			entry->value = value;
-			atomic_inc(&zswap_same_filled_pages);
-			goto insert_entry;
-		}
-		kunmap_atomic(src);
+	if (same_filled) {
+		entry->offset = offset;
+		entry->length = 0;
+		entry->value = value;
+		atomic_inc(&zswap_same_filled_pages);
+		goto insert_entry;
 	}
 
 	/* if entry is successfully added, it keeps the reference */
@@ -253,6 +253,30 @@ struct sk_buff *__alloc_skb(unsigned int size, gfp_t gfp_mask,
 }
 EXPORT_SYMBOL(__alloc_skb);
 
+static void __build_skb_around(struct sk_buff *skb, void *data,
+			       unsigned int frag_size)
+{
+	struct skb_shared_info *shinfo;
+	unsigned int size = frag_size ? : ksize(data);
+
+	size -= SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	memset(skb, 0, offsetof(struct sk_buff, tail));
+	skb->truesize = SKB_TRUESIZE(size);
+	refcount_set(&skb->users, 1);
+	skb->head = data;
+	skb->data = data;
+	skb_reset_tail_pointer(skb);
+	skb->end = skb->tail + size;
+	skb->mac_header = (typeof(skb->mac_header))~0U;
+	skb->transport_header = (typeof(skb->transport_header))~0U;
+
+	/* make sure we initialize shinfo sequentially */
+	shinfo = skb_shinfo(skb);
+	memset(shinfo, 0, offsetof(struct skb_shared_info, dataref));
+	atomic_set(&shinfo->dataref, 1);
+}
+
 /**
  * __build_skb - build a network buffer
  * @data: data buffer provided by caller
@@ -274,30 +298,13 @@ EXPORT_SYMBOL(__alloc_skb);
  */
 struct sk_buff *__build_skb(void *data, unsigned int frag_size)
 {
-	struct skb_shared_info *shinfo;
 	struct sk_buff *skb;
-	unsigned int size = frag_size ? : ksize(data);
 
 	skb = kmem_cache_alloc(skbuff_head_cache, GFP_ATOMIC);
 	if (!skb)
 		return NULL;
 
-	size -= SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
-
-	memset(skb, 0, offsetof(struct sk_buff, tail));
-	skb->truesize = SKB_TRUESIZE(size);
-	refcount_set(&skb->users, 1);
-	skb->head = data;
-	skb->data = data;
-	skb_reset_tail_pointer(skb);
-	skb->end = skb->tail + size;
-	skb->mac_header = (typeof(skb->mac_header))~0U;
-	skb->transport_header = (typeof(skb->transport_header))~0U;
-
-	/* make sure we initialize shinfo sequentially */
-	shinfo = skb_shinfo(skb);
-	memset(shinfo, 0, offsetof(struct skb_shared_info, dataref));
-	atomic_set(&shinfo->dataref, 1);
+	__build_skb_around(skb, data, frag_size);
 
 	return skb;
 }
@@ -321,6 +328,8 @@ struct sk_buff *build_skb(void *data, unsigned int frag_size)
 EXPORT_SYMBOL(build_skb);
 
 #define NAPI_SKB_CACHE_SIZE	64
+#define NAPI_SKB_CACHE_BULK	16
+#define NAPI_SKB_CACHE_HALF	(NAPI_SKB_CACHE_SIZE / 2)
 
 struct napi_alloc_cache {
 	struct page_frag_cache page;
@@ -331,6 +340,31 @@ struct napi_alloc_cache {
 static DEFINE_PER_CPU(struct page_frag_cache, netdev_alloc_cache);
 static DEFINE_PER_CPU(struct napi_alloc_cache, napi_alloc_cache);
 
+/* The napi cache is only touched from softirq context, so any softirq on
+ * this cpu may use it, but not a hard irq that interrupted one.
+ */
+static inline bool napi_skb_cache_usable(void)
+{
+	return in_serving_softirq() && !in_irq();
+}
+
+/* Take an skb head from the per-cpu cache, refilling it in bulk */
+static struct sk_buff *napi_skb_cache_get(void)
+{
+	struct napi_alloc_cache *nc = this_cpu_ptr(&napi_alloc_cache);
+
+	if (unlikely(!nc->skb_count)) {
+		nc->skb_count = kmem_cache_alloc_bulk(skbuff_head_cache,
+						      GFP_ATOMIC,
+						      NAPI_SKB_CACHE_BULK,
+						      nc->skb_cache);
+		if (unlikely(!nc->skb_count))
+			return NULL;
+	}
+
+	return nc->skb_cache[--nc->skb_count];
+}
+
 static void *__netdev_alloc_frag(unsigned int fragsz, gfp_t gfp_mask)
 {
 	struct page_frag_cache *nc;
@@ -412,6 +446,25 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
 	if (sk_memalloc_socks())
 		gfp_mask |= __GFP_MEMALLOC;
 
+	/* tasklets and USB completions get the napi caches too */
+	if (napi_skb_cache_usable()) {
+		struct napi_alloc_cache *napi_nc;
+
+		napi_nc = this_cpu_ptr(&napi_alloc_cache);
+		data = page_frag_alloc(&napi_nc->page, len, gfp_mask);
+		if (unlikely(!data))
+			return NULL;
+		pfmemalloc = napi_nc->page.pfmemalloc;
+
+		skb = napi_skb_cache_get();
+		if (unlikely(!skb)) {
+			skb_free_frag(data);
+			return NULL;
+		}
+		__build_skb_around(skb, data, len);
+		goto skb_frag;
+	}
+
 	local_irq_save(flags);
 
 	nc = this_cpu_ptr(&netdev_alloc_cache);
@@ -429,6 +482,7 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
 		return NULL;
 	}
 
+skb_frag:
 	/* use OR instead of assignment to avoid clearing of bits in mask */
 	if (pfmemalloc)
 		skb->pfmemalloc = 1;
@@ -483,11 +537,12 @@ struct sk_buff *__napi_alloc_skb(struct napi_struct *napi, unsigned int len,
 	if (unlikely(!data))
 		return NULL;
 
-	skb = __build_skb(data, len);
+	skb = napi_skb_cache_get();
 	if (unlikely(!skb)) {
 		skb_free_frag(data);
 		return NULL;
 	}
+	__build_skb_around(skb, data, len);
 
 	/* use OR instead of assignment to avoid clearing of bits in mask */
 	if (nc->page.pfmemalloc)
@@ -688,24 +743,6 @@ void skb_tx_error(struct sk_buff *skb)
 }
 EXPORT_SYMBOL(skb_tx_error);
 
-/**
- *	consume_skb - free an skbuff
- *	@skb: buffer to free
- *
- *	Drop a ref to the buffer and free it if the usage count has hit zero
- *	Functions identically to kfree_skb, but kfree_skb assumes that the frame
- *	is being dropped after a failure and notes that
- */
-void consume_skb(struct sk_buff *skb)
-{
-	if (!skb_unref(skb))
-		return;
-
-	trace_consume_skb(skb);
-	__kfree_skb(skb);
-}
-EXPORT_SYMBOL(consume_skb);
-
 /**
  *	consume_stateless_skb - free an skbuff, assuming it is stateless
  *	@skb: buffer to free
@@ -724,11 +761,12 @@ void __kfree_skb_flush(void)
 {
 	struct napi_alloc_cache *nc = this_cpu_ptr(&napi_alloc_cache);
 
-	/* flush skb_cache if containing objects */
-	if (nc->skb_count) {
-		kmem_cache_free_bulk(skbuff_head_cache, nc->skb_count,
-				     nc->skb_cache);
-		nc->skb_count = 0;
+	/* keep up to half the cache for napi_skb_cache_get() */
+	if (nc->skb_count > NAPI_SKB_CACHE_HALF) {
+		kmem_cache_free_bulk(skbuff_head_cache,
+				     nc->skb_count - NAPI_SKB_CACHE_HALF,
+				     nc->skb_cache + NAPI_SKB_CACHE_HALF);
+		nc->skb_count = NAPI_SKB_CACHE_HALF;
 	}
 }
 
@@ -747,11 +785,11 @@ static inline void _kfree_skb_defer(struct sk_buff *skb)
 	prefetchw(skb);
 #endif
 
-	/* flush skb_cache if it is filled */
+	/* flush the upper half of skb_cache if it is filled */
 	if (unlikely(nc->skb_count == NAPI_SKB_CACHE_SIZE)) {
-		kmem_cache_free_bulk(skbuff_head_cache, NAPI_SKB_CACHE_SIZE,
-				     nc->skb_cache);
-		nc->skb_count = 0;
+		kmem_cache_free_bulk(skbuff_head_cache, NAPI_SKB_CACHE_HALF,
+				     nc->skb_cache + NAPI_SKB_CACHE_HALF);
+		nc->skb_count = NAPI_SKB_CACHE_HALF;
 	}
 }
 void __kfree_skb_defer(struct sk_buff *skb)
@@ -759,6 +797,32 @@ void __kfree_skb_defer(struct sk_buff *skb)
 	_kfree_skb_defer(skb);
 }
 
+/**
+ *	consume_skb - free an skbuff
+ *	@skb: buffer to free
+ *
+ *	Drop a ref to the buffer and free it if the usage count has hit zero
+ *	Functions identically to kfree_skb, but kfree_skb assumes that the frame
+ *	is being dropped after a failure and notes that
+ *
+ *	From softirq context the head goes back to the per-cpu napi cache,
+ *	so TX completions done in tasklets are batched like NAPI ones.
+ */
+void consume_skb(struct sk_buff *skb)
+{
+	if (!skb_unref(skb))
+		return;
+
+	trace_consume_skb(skb);
+	if (napi_skb_cache_usable() &&
+	    skb->fclone == SKB_FCLONE_UNAVAILABLE) {
+		_kfree_skb_defer(skb);
+		return;
+	}
+	__kfree_skb(skb);
+}
+EXPORT_SYMBOL(consume_skb);
+
 void napi_consume_skb(struct sk_buff *skb, int budget)
 {
 	if (unlikely(!skb))
@@ -1067,7 +1131,9 @@ void sock_zerocopy_callback(struct ubuf_info *uarg, bool success)
 	q = &sk->sk_error_queue;
 	spin_lock_irqsave(&q->lock, flags);
 	tail = skb_peek_tail(q);
+	/* only merge ranges that agree on whether they were copied */
 	if (!tail || SKB_EXT_ERR(tail)->ee.ee_origin != SO_EE_ORIGIN_ZEROCOPY ||
+	    SKB_EXT_ERR(tail)->ee.ee_code != serr->ee.ee_code ||
 	    !skb_zerocopy_notify_extend(tail, lo, len)) {
 		__skb_queue_tail(q, skb);
 		skb = NULL;
@@ -1106,9 +1172,6 @@ void sock_zerocopy_put_abort(struct ubuf_info *uarg)
 }
 EXPORT_SYMBOL_GPL(sock_zerocopy_put_abort);
 
-extern int __zerocopy_sg_from_iter(struct sock *sk, struct sk_buff *skb,
-				   struct iov_iter *from, size_t length);
-
 int skb_zerocopy_iter_stream(struct sock *sk, struct sk_buff *skb,
 			     struct msghdr *msg, int len,
 			     struct ubuf_info *uarg)
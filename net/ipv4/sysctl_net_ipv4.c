@@ -1165,6 +1165,14 @@ static struct ctl_table ipv4_net_table[] = {
 		.extra1		= &zero,
 		.extra2		= &one,
 	},
+	{
+		.procname	= "tcp_zerocopy_min_size",
+		.data		= &init_net.ipv4.sysctl_tcp_zerocopy_min_size,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+	},
 	{
 		.procname	= "tcp_invalid_ratelimit",
 		.data		= &init_net.ipv4.sysctl_tcp_invalid_ratelimit,
@@ -1190,6 +1198,14 @@ static struct ctl_table ipv4_net_table[] = {
 		.extra1		= &zero,
 		.extra2		= &thousand,
 	},
+	{
+		.procname	= "tcp_pacing_slack_ns",
+		.data		= &init_net.ipv4.sysctl_tcp_pacing_slack_ns,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+	},
 	{
 		.procname	= "tcp_wmem",
 		.data		= &init_net.ipv4.sysctl_tcp_wmem,
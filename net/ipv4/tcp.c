@@ -1207,14 +1207,25 @@ int tcp_sendmsg_locked(struct sock *sk, struct msghdr *msg, size_t size)
 			goto out_err;
 		}
 
+		/* Pinning pages and taking the completion costs more than
+		 * copying a small send.  Copy those, the notification then
+		 * carries SO_EE_CODE_ZEROCOPY_COPIED as it does without SG.
+		 */
+		zc = sk->sk_route_caps & NETIF_F_SG &&
+		     size >= sock_net(sk)->ipv4.sysctl_tcp_zerocopy_min_size;
+
+		/* COPIED is tracked per ubuf_info, so a copied send must not
+		 * extend the ubuf_info of one that was not, nor vice versa.
+		 */
 		skb = tcp_write_queue_tail(sk);
-		uarg = sock_zerocopy_realloc(sk, size, skb_zcopy(skb));
+		uarg = skb_zcopy(skb);
+		if (uarg && uarg->zerocopy != zc)
+			uarg = NULL;
+		uarg = sock_zerocopy_realloc(sk, size, uarg);
 		if (!uarg) {
 			err = -ENOBUFS;
 			goto out_err;
 		}
-
-		zc = sk->sk_route_caps & NETIF_F_SG;
 		if (!zc)
 			uarg->zerocopy = 0;
 	}
@@ -1753,6 +1764,55 @@ int tcp_mmap(struct file *file, struct socket *sock,
 }
 EXPORT_SYMBOL(tcp_mmap);
 
+/* Copy what could not be mapped into the caller's copybuf: the rest of an
+ * skb whose payload is not page aligned, or a sub-page tail of the queue.
+ * Returns the number of bytes copied; copybuf_len reports that or an error.
+ */
+static int tcp_zerocopy_copy_tail(struct sock *sk,
+				  struct tcp_zerocopy_receive *zc)
+{
+	struct tcp_sock *tp = tcp_sk(sk);
+	u32 seq = tp->copied_seq, offset;
+	int copylen, copied = 0, err;
+	struct iov_iter iter;
+	struct sk_buff *skb;
+	struct iovec iov;
+
+	if (zc->copybuf_len <= 0)
+		return 0;
+
+	copylen = zc->recv_skip_hint;
+	if (!copylen) {
+		copylen = tcp_inq(sk);
+		if (copylen >= PAGE_SIZE)
+			copylen = 0;
+	}
+	copylen = min(copylen, zc->copybuf_len);
+
+	err = import_single_range(READ, u64_to_user_ptr(zc->copybuf_address),
+				  copylen, &iov, &iter);
+	while (!err && copied < copylen) {
+		u32 used;
+
+		skb = tcp_recv_skb(sk, seq, &offset);
+		if (!skb || offset >= skb->len)
+			break;
+		used = min_t(u32, skb->len - offset, copylen - copied);
+		err = skb_copy_datagram_iter(skb, offset, &iter, used);
+		if (err)
+			break;
+		seq += used;
+		copied += used;
+	}
+
+	if (copied) {
+		tp->copied_seq = seq;
+		zc->recv_skip_hint -= min_t(u32, copied, zc->recv_skip_hint);
+	}
+	zc->copybuf_len = copied ? copied : err;
+	return copied;
+}
+
 static int tcp_zerocopy_receive(struct sock *sk,
 				struct tcp_zerocopy_receive *zc)
 {
@@ -1762,6 +1822,8 @@ static int tcp_zerocopy_receive(struct sock *sk,
 	struct vm_area_struct *vma;
 	struct sk_buff *skb = NULL;
 	struct tcp_sock *tp;
+	bool zapped = false;
+	int copied = 0;
 	int ret;
 
 	if (address & (PAGE_SIZE - 1) || address != zc->address)
@@ -1785,8 +1847,6 @@ static int tcp_zerocopy_receive(struct sock *sk,
 	zc->length = min_t(u32, zc->length, tcp_inq(sk));
 	zc->length &= ~(PAGE_SIZE - 1);
 
-	zap_page_range(vma, address, zc->length);
-
 	zc->recv_skip_hint = 0;
 	ret = 0;
 	while (length + PAGE_SIZE <= zc->length) {
@@ -1814,6 +1874,17 @@ static int tcp_zerocopy_receive(struct sock *sk,
 			break;
 		ret = vm_insert_page(vma, address + length,
 				     skb_frag_page(frags));
+		if (ret == -EBUSY && !zapped) {
+			/* Pages from an earlier call are still mapped.  Zap
+			 * the rest of the range in one go, rather than up
+			 * front on every call whether it was needed or not.
+			 */
+			zap_page_range(vma, address + length,
+				       zc->length - length);
+			zapped = true;
+			ret = vm_insert_page(vma, address + length,
+					     skb_frag_page(frags));
+		}
 		if (ret)
 			break;
 		length += PAGE_SIZE;
@@ -1825,19 +1896,24 @@ static int tcp_zerocopy_receive(struct sock *sk,
 	up_read(&current->mm->mmap_sem);
 	if (length) {
 		tp->copied_seq = seq;
+		if (length == zc->length)
+			zc->recv_skip_hint = 0;
+	}
+	if (!ret)
+		copied = tcp_zerocopy_copy_tail(sk, zc);
+	if (length || copied) {
 		tcp_rcv_space_adjust(sk);
 
 		/* Clean up data we have read: This will do ACK frames. */
-		tcp_recv_skb(sk, seq, &offset);
-		tcp_cleanup_rbuf(sk, length);
+		tcp_recv_skb(sk, tp->copied_seq, &offset);
+		tcp_cleanup_rbuf(sk, length + copied);
 		ret = 0;
-		if (length == zc->length)
-			zc->recv_skip_hint = 0;
 	} else {
 		if (!zc->recv_skip_hint && sock_flag(sk, SOCK_DONE))
 			ret = -EIO;
 	}
 	zc->length = length;
+	zc->inq = tcp_inq(sk);
 	return ret;
 }
 #endif
@@ -3573,13 +3649,23 @@ static int do_tcp_getsockopt(struct sock *sk, int level,
 
 		if (get_user(len, optlen))
 			return -EFAULT;
-		if (len != sizeof(zc))
+		/* callers built against the shorter versions of the struct */
+		if (len != sizeof(zc) &&
+		    len != offsetofend(struct tcp_zerocopy_receive, err) &&
+		    len != offsetofend(struct tcp_zerocopy_receive, inq) &&
+		    len != offsetofend(struct tcp_zerocopy_receive,
+				       recv_skip_hint))
 			return -EINVAL;
+		memset(&zc, 0, sizeof(zc));
 		if (copy_from_user(&zc, optval, len))
 			return -EFAULT;
+		if (zc.flags)
+			return -EINVAL;
 		lock_sock(sk);
 		err = tcp_zerocopy_receive(sk, &zc);
 		release_sock(sk);
+		if (!err && len >= offsetofend(struct tcp_zerocopy_receive, err))
+			zc.err = sock_error(sk);
 		if (!err && copy_to_user(optval, &zc, len))
 			err = -EFAULT;
 		return err;
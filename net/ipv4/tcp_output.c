@@ -964,9 +964,16 @@ enum hrtimer_restart tcp_pace_kick(struct hrtimer *timer)
 	return HRTIMER_NORESTART;
 }
 
+/* With tcp_pacing_slack_ns set, the pacing timer may fire up to that late
+ * so that expiries of many flows can be handled in one go.  The next
+ * departure is then taken from when the timer was due rather than from
+ * now, so that the lateness does not eat into the pacing rate.
+ */
 static void tcp_internal_pacing(struct sock *sk, const struct sk_buff *skb)
 {
-	u64 len_ns;
+	struct tcp_sock *tp = tcp_sk(sk);
+	u64 len_ns, now, next;
+	u32 slack;
 	u32 rate;
 
 	if (!tcp_needs_internal_pacing(sk))
@@ -977,9 +984,20 @@ static void tcp_internal_pacing(struct sock *sk, const struct sk_buff *skb)
 
 	len_ns = (u64)skb->len * NSEC_PER_SEC;
 	do_div(len_ns, rate);
-	hrtimer_start(&tcp_sk(sk)->pacing_timer,
-		      ktime_add_ns(ktime_get(), len_ns),
-		      HRTIMER_MODE_ABS_PINNED_SOFT);
+
+	slack = sock_net(sk)->ipv4.sysctl_tcp_pacing_slack_ns;
+	now = ktime_get_ns();
+	next = tp->pacing_expiry_ns;
+	/* idle, or later than the slack allows: start afresh from now */
+	if ((s64)(now - next) > slack)
+		next = now;
+	next += len_ns;
+	tp->pacing_expiry_ns = next;
+	if ((s64)(next - now) <= 0)
+		return;
+
+	hrtimer_start_range_ns(&tp->pacing_timer, ns_to_ktime(next), slack,
+			       HRTIMER_MODE_ABS_PINNED_SOFT);
 	sock_hold(sk);
 }
 
@@ -192,6 +192,64 @@ static ssize_t sta_aqm_read(struct file *file, char __user *userbuf,
 }
 STA_OPS(aqm);
 
+static ssize_t sta_airtime_read(struct file *file, char __user *userbuf,
+				size_t count, loff_t *ppos)
+{
+	static const char * const ac_names[IEEE80211_NUM_ACS] = {
+		"VO", "VI", "BE", "BK"
+	};
+	struct sta_info *sta = file->private_data;
+	char buf[80 + IEEE80211_NUM_ACS * 80], *p = buf;
+	int ac;
+
+	p += scnprintf(p, sizeof(buf) + buf - p,
+		       "AC tx-airtime-us pending-us limit-low-us limit-high-us\n");
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++)
+		p += scnprintf(p, sizeof(buf) + buf - p,
+			       "%s %llu %d %u %u\n", ac_names[ac],
+			       sta->airtime[ac].tx_airtime,
+			       atomic_read(&sta->airtime[ac].aql_tx_pending),
+			       sta->airtime[ac].aql_limit_low,
+			       sta->airtime[ac].aql_limit_high);
+
+	return simple_read_from_buffer(userbuf, count, ppos, buf, p - buf);
+}
+
+/*
+ * Writing "<ac> <low> <high>" sets the station's airtime queue limits for
+ * that AC, anything else clears the airtime counters.
+ */
+static ssize_t sta_airtime_write(struct file *file, const char __user *userbuf,
+				 size_t count, loff_t *ppos)
+{
+	struct sta_info *sta = file->private_data;
+	u32 ac, q_limit_low, q_limit_high;
+	char buf[64];
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+
+	if (copy_from_user(buf, userbuf, count))
+		return -EFAULT;
+
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%u %u %u", &ac, &q_limit_low, &q_limit_high) == 3) {
+		if (ac >= IEEE80211_NUM_ACS || q_limit_low > q_limit_high)
+			return -EINVAL;
+
+		sta->airtime[ac].aql_limit_low = q_limit_low;
+		sta->airtime[ac].aql_limit_high = q_limit_high;
+		return count;
+	}
+
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++)
+		sta->airtime[ac].tx_airtime = 0;
+
+	return count;
+}
+STA_OPS_RW(airtime);
+
 static ssize_t sta_agg_status_read(struct file *file, char __user *userbuf,
 					size_t count, loff_t *ppos)
 {
@@ -546,6 +604,10 @@ void ieee80211_sta_debugfs_add(struct sta_info *sta)
 	if (local->ops->wake_tx_queue)
 		DEBUGFS_ADD(aqm);
 
+	if (local->ops->wake_tx_queue &&
+	    ieee80211_hw_check(&local->hw, SUPPORTS_AQL))
+		DEBUGFS_ADD(airtime);
+
 	if (sizeof(sta->driver_buffered_tids) == sizeof(u32))
 		debugfs_create_x32("driver_buffered_tids", 0400,
 				   sta->debugfs_dir,
@@ -828,6 +828,8 @@ enum txq_info_flags {
  *	a fq_flow which is already owned by a different tin
  * @def_cvars: codel vars for @def_flow
  * @frags: used to keep fragments created after dequeue
+ * @aql_list: entry on &ieee80211_local.aql_wait_list while the station's
+ *	airtime queue limit holds the queue back
  */
 struct txq_info {
 	struct fq_tin tin;
@@ -836,6 +838,7 @@ struct txq_info {
 	struct codel_stats cstats;
 	struct sk_buff_head frags;
 	unsigned long flags;
+	struct list_head aql_list;
 
 	/* keep last! */
 	struct ieee80211_txq txq;
@@ -1126,6 +1129,17 @@ struct ieee80211_local {
 	struct codel_vars *cvars;
 	struct codel_params cparams;
 
+	/* airtime queue limits, see ieee80211_txq_airtime_check() */
+	u32 aql_txq_limit_low[IEEE80211_NUM_ACS];
+	u32 aql_txq_limit_high[IEEE80211_NUM_ACS];
+	u32 aql_threshold;
+	atomic_t aql_total_pending_airtime;
+	/* txqs held back by their airtime queue limit, woken by the
+	 * tx_pending_tasklet once enough airtime has completed
+	 */
+	spinlock_t aql_lock;
+	struct list_head aql_wait_list;
+
 	const struct ieee80211_ops *ops;
 
 	/*
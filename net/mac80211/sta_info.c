@@ -381,6 +381,12 @@ struct sta_info *sta_info_alloc(struct ieee80211_sub_if_data *sdata,
 	if (sta_prepare_rate_control(local, sta, gfp))
 		goto free_txq;
 
+	for (i = 0; i < IEEE80211_NUM_ACS; i++) {
+		sta->airtime[i].aql_limit_low = local->aql_txq_limit_low[i];
+		sta->airtime[i].aql_limit_high = local->aql_txq_limit_high[i];
+		atomic_set(&sta->airtime[i].aql_tx_pending, 0);
+	}
+
 	for (i = 0; i < IEEE80211_NUM_ACS; i++) {
 		skb_queue_head_init(&sta->ps_tx_buf[i]);
 		skb_queue_head_init(&sta->tx_filtered[i]);
@@ -2387,6 +2393,59 @@ static void sta_update_codel_params(struct sta_info *sta, u32 thr)
 	}
 }
 
+/**
+ * ieee80211_sta_update_pending_airtime - account for queued airtime
+ *
+ * @local: the local structure
+ * @sta: the station the frame was sent to, or %NULL if it is gone by now
+ * @ac: the access category of the frame
+ * @tx_airtime: estimated airtime of the frame, in usec
+ * @tx_completed: %false when the frame is handed to the driver, %true when
+ *	its TX status is reported or it is dropped
+ */
+void ieee80211_sta_update_pending_airtime(struct ieee80211_local *local,
+					  struct sta_info *sta, u8 ac,
+					  u16 tx_airtime, bool tx_completed)
+{
+	int tx_pending;
+
+	if (!tx_completed) {
+		if (sta)
+			atomic_add(tx_airtime,
+				   &sta->airtime[ac].aql_tx_pending);
+		atomic_add(tx_airtime, &local->aql_total_pending_airtime);
+		return;
+	}
+
+	if (sta) {
+		struct airtime_info *air_info = &sta->airtime[ac];
+
+		tx_pending = atomic_sub_return(tx_airtime,
+					       &air_info->aql_tx_pending);
+		if (tx_pending < 0)
+			atomic_cmpxchg(&air_info->aql_tx_pending,
+				       tx_pending, 0);
+		air_info->tx_airtime += tx_airtime;
+	}
+
+	tx_pending = atomic_sub_return(tx_airtime,
+				       &local->aql_total_pending_airtime);
+	if (WARN_ONCE(tx_pending < 0,
+		      "Device %s AC %d pending airtime underflow: %d, %u",
+		      wiphy_name(local->hw.wiphy), ac, tx_pending,
+		      tx_airtime))
+		atomic_cmpxchg(&local->aql_total_pending_airtime,
+			       tx_pending, 0);
+
+	/* Pairs with the barrier in ieee80211_txq_airtime_check(): either
+	 * a txq that has just been held back is seen on the list here, or
+	 * the reduced pending airtime is seen there.
+	 */
+	smp_mb();
+	if (!list_empty(&local->aql_wait_list))
+		tasklet_schedule(&local->tx_pending_tasklet);
+}
+
 void ieee80211_sta_set_expected_throughput(struct ieee80211_sta *pubsta,
 					   u32 thr)
 {
@@ -419,6 +419,33 @@ struct ieee80211_sta_rx_stats {
  */
 #define STA_SLOW_THRESHOLD 6000 /* 6 Mbps */
 
+/*
+ * Default airtime queue limits (in usec) per station and AC. A station may
+ * keep up to the low limit of estimated airtime queued in the hardware, and
+ * up to the high limit as long as the device as a whole stays below
+ * IEEE80211_AQL_THRESHOLD.
+ */
+#define IEEE80211_DEFAULT_AQL_TXQ_LIMIT_L	5000
+#define IEEE80211_DEFAULT_AQL_TXQ_LIMIT_H	12000
+#define IEEE80211_AQL_THRESHOLD			24000
+
+/**
+ * struct airtime_info - per-AC airtime accounting of a station
+ *
+ * @tx_airtime: estimated airtime of the frames completed so far, in usec
+ * @aql_tx_pending: estimated airtime of the frames handed to the driver
+ *	and not yet completed, in usec
+ * @aql_limit_low: airtime queue limit that always applies, in usec
+ * @aql_limit_high: airtime queue limit while the device is below its
+ *	threshold, in usec
+ */
+struct airtime_info {
+	u64 tx_airtime;
+	atomic_t aql_tx_pending;
+	u32 aql_limit_low;
+	u32 aql_limit_high;
+};
+
 /**
  * struct sta_info - STA information
  *
@@ -482,6 +509,7 @@ struct ieee80211_sta_rx_stats {
  * @pcpu_rx_stats: per-CPU RX statistics, assigned only if the driver needs
  *	this (by advertising the USES_RSS hw flag)
  * @status_stats: TX status statistics
+ * @airtime: per-AC airtime accounting for the airtime queue limits
  */
 struct sta_info {
 	/* General information, mostly static */
@@ -561,6 +589,8 @@ struct sta_info {
 		struct ieee80211_tx_rate last_rate;
 		u64 msdu[IEEE80211_NUM_TIDS + 1];
 	} tx_stats;
+
+	struct airtime_info airtime[IEEE80211_NUM_ACS];
 	u16 tid_seq[IEEE80211_QOS_CTL_TID_MASK + 1];
 
 	/*
@@ -749,6 +779,10 @@ void sta_set_sinfo(struct sta_info *sta, struct station_info *sinfo,
 
 u32 sta_get_expected_throughput(struct sta_info *sta);
 
+void ieee80211_sta_update_pending_airtime(struct ieee80211_local *local,
+					  struct sta_info *sta, u8 ac,
+					  u16 tx_airtime, bool tx_completed);
+
 void ieee80211_sta_expire(struct ieee80211_sub_if_data *sdata,
 			  unsigned long exp_time);
 u8 sta_info_tx_streams(struct sta_info *sta);
@@ -1441,6 +1441,7 @@ void ieee80211_txq_init(struct ieee80211_sub_if_data *sdata,
 	codel_vars_init(&txqi->def_cvars);
 	codel_stats_init(&txqi->cstats);
 	__skb_queue_head_init(&txqi->frags);
+	INIT_LIST_HEAD(&txqi->aql_list);
 
 	txqi->txq.vif = &sdata->vif;
 
@@ -1464,6 +1465,10 @@ void ieee80211_txq_purge(struct ieee80211_local *local,
 
 	fq_tin_reset(fq, tin, fq_skb_free_func);
 	ieee80211_purge_tx_queue(&local->hw, &txqi->frags);
+
+	spin_lock_bh(&local->aql_lock);
+	list_del_init(&txqi->aql_list);
+	spin_unlock_bh(&local->aql_lock);
 }
 
 void ieee80211_txq_set_params(struct ieee80211_local *local)
@@ -2684,7 +2689,7 @@ static struct sk_buff *ieee80211_build_hdr(struct ieee80211_sub_if_data *sdata,
 
 			spin_lock_irqsave(&local->ack_status_lock, flags);
 			id = idr_alloc(&local->ack_status_frames, ack_skb,
-				       1, 0x10000, GFP_ATOMIC);
+				       1, 0x2000, GFP_ATOMIC);
 			spin_unlock_irqrestore(&local->ack_status_lock, flags);
 
 			if (id >= 0) {
@@ -3475,6 +3480,91 @@ static bool ieee80211_xmit_fast(struct ieee80211_sub_if_data *sdata,
 	return true;
 }
 
+/*
+ * Estimate the airtime a frame of @len bytes takes to reach @sta, from the
+ * throughput rate control expects or, failing that, the last TX rate.
+ */
+static u32 ieee80211_calc_expected_tx_airtime(struct sta_info *sta, int len)
+{
+	struct rate_info rinfo = {};
+	u32 rate;
+
+	/* in units of 100 Kbps, round up in case we get rate < 100Kbps */
+	rate = DIV_ROUND_UP(sta_get_expected_throughput(sta), 100);
+	if (!rate && sta->tx_stats.last_rate.idx >= 0) {
+		sta_set_rate_info_tx(sta, &sta->tx_stats.last_rate, &rinfo);
+		rate = cfg80211_calculate_bitrate(&rinfo);
+	}
+	if (!rate)
+		return 0;
+
+	return DIV_ROUND_UP(len * 8 * 10, rate);
+}
+
+static bool ieee80211_txq_airtime_ok(struct ieee80211_local *local,
+				     struct sta_info *sta, u8 ac)
+{
+	u32 pending = max(atomic_read(&sta->airtime[ac].aql_tx_pending), 0);
+
+	if (pending < sta->airtime[ac].aql_limit_low)
+		return true;
+
+	return pending < sta->airtime[ac].aql_limit_high &&
+	       atomic_read(&local->aql_total_pending_airtime) <
+	       local->aql_threshold;
+}
+
+/*
+ * Check whether the station behind @txqi may have another frame handed to
+ * the driver. If not, the txq is put on the wait list and the driver gets
+ * a wake_tx_queue() call for it once enough of the queued airtime has been
+ * reported back.
+ */
+static bool ieee80211_txq_airtime_check(struct ieee80211_local *local,
+					struct txq_info *txqi)
+{
+	struct sta_info *sta = container_of(txqi->txq.sta,
+					    struct sta_info, sta);
+
+	if (ieee80211_txq_airtime_ok(local, sta, txqi->txq.ac))
+		return true;
+
+	spin_lock_bh(&local->aql_lock);
+	if (list_empty(&txqi->aql_list))
+		list_add_tail(&txqi->aql_list, &local->aql_wait_list);
+	spin_unlock_bh(&local->aql_lock);
+
+	/* Pairs with the barrier in ieee80211_sta_update_pending_airtime() */
+	smp_mb();
+	if (ieee80211_txq_airtime_ok(local, sta, txqi->txq.ac))
+		tasklet_schedule(&local->tx_pending_tasklet);
+
+	return false;
+}
+
+/* Called from the tx_pending_tasklet under RCU */
+static void ieee80211_aql_wake_txqs(struct ieee80211_local *local)
+{
+	struct txq_info *txqi;
+
+	spin_lock_bh(&local->aql_lock);
+restart:
+	list_for_each_entry(txqi, &local->aql_wait_list, aql_list) {
+		struct sta_info *sta = container_of(txqi->txq.sta,
+						    struct sta_info, sta);
+
+		if (!ieee80211_txq_airtime_ok(local, sta, txqi->txq.ac))
+			continue;
+
+		list_del_init(&txqi->aql_list);
+		spin_unlock_bh(&local->aql_lock);
+		drv_wake_tx_queue(local, txqi);
+		spin_lock_bh(&local->aql_lock);
+		goto restart;
+	}
+	spin_unlock_bh(&local->aql_lock);
+}
+
 struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 				     struct ieee80211_txq *txq)
 {
@@ -3488,6 +3578,10 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 	struct ieee80211_tx_data tx;
 	ieee80211_tx_result r;
 	struct ieee80211_vif *vif;
+	bool aql = txq->sta && ieee80211_hw_check(hw, SUPPORTS_AQL);
+
+	if (aql && !ieee80211_txq_airtime_check(local, txqi))
+		return NULL;
 
 	spin_lock_bh(&fq->lock);
 
@@ -3609,6 +3703,18 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 out:
 	spin_unlock_bh(&fq->lock);
 
+	if (skb && aql) {
+		struct sta_info *sta = container_of(txq->sta, struct sta_info,
+						    sta);
+		u16 airtime;
+
+		airtime = ieee80211_calc_expected_tx_airtime(sta, skb->len);
+		airtime = ieee80211_info_set_tx_time_est(IEEE80211_SKB_CB(skb),
+							 airtime);
+		ieee80211_sta_update_pending_airtime(local, sta, txq->ac,
+						     airtime, false);
+	}
+
 	return skb;
 }
 EXPORT_SYMBOL(ieee80211_tx_dequeue);
@@ -3975,6 +4081,8 @@ void ieee80211_tx_pending(unsigned long data)
 	}
 	spin_unlock_irqrestore(&local->queue_stop_reason_lock, flags);
 
+	ieee80211_aql_wake_txqs(local);
+
 	rcu_read_unlock();
 }
 
@@ -10,6 +10,7 @@
 #include <net/netfilter/nf_flow_table.h>
 #include <net/netfilter/nf_conntrack.h>
 #include <net/netfilter/nf_conntrack_core.h>
+#include <net/netfilter/nf_conntrack_acct.h>
 #include <net/netfilter/nf_conntrack_tuple.h>
 
 struct flow_offload_entry {
@@ -28,7 +29,6 @@ flow_offload_fill_dir(struct flow_offload *flow, struct nf_conn *ct,
 {
 	struct flow_offload_tuple *ft = &flow->tuplehash[dir].tuple;
 	struct nf_conntrack_tuple *ctt = &ct->tuplehash[dir].tuple;
-	struct dst_entry *other_dst = route->tuple[!dir].dst;
 	struct dst_entry *dst = route->tuple[dir].dst;
 
 	ft->dir = dir;
@@ -51,8 +51,21 @@ flow_offload_fill_dir(struct flow_offload *flow, struct nf_conn *ct,
 	ft->src_port = ctt->src.u.tcp.port;
 	ft->dst_port = ctt->dst.u.tcp.port;
 
-	ft->iifidx = other_dst->dev->ifindex;
-	ft->oifidx = dst->dev->ifindex;
+	ft->iifidx = route->tuple[dir].in.ifindex;
+	ft->encap.id = route->tuple[dir].in.encap.id;
+	ft->encap.proto = route->tuple[dir].in.encap.proto;
+
+	ft->xmit_type = route->tuple[dir].xmit_type;
+	switch (ft->xmit_type) {
+	case FLOW_OFFLOAD_XMIT_DIRECT:
+		ft->oifidx = route->tuple[dir].out.ifindex;
+		memcpy(ft->h_source, route->tuple[dir].out.h_source, ETH_ALEN);
+		memcpy(ft->h_dest, route->tuple[dir].out.h_dest, ETH_ALEN);
+		break;
+	case FLOW_OFFLOAD_XMIT_NEIGH:
+		ft->oifidx = dst->dev->ifindex;
+		break;
+	}
 	ft->dst_cache = dst;
 }
 
@@ -238,6 +251,23 @@ void flow_offload_teardown(struct flow_offload *flow)
 }
 EXPORT_SYMBOL_GPL(flow_offload_teardown);
 
+void flow_offload_acct(struct flow_offload *flow,
+		       enum flow_offload_tuple_dir dir, unsigned int len)
+{
+	struct flow_offload_entry *e;
+	struct nf_conn_acct *acct;
+
+	e = container_of(flow, struct flow_offload_entry, flow);
+	acct = nf_conn_acct_find(e->ct);
+	if (acct) {
+		struct nf_conn_counter *counter = acct->counter;
+
+		atomic64_inc(&counter[dir].packets);
+		atomic64_add(len, &counter[dir].bytes);
+	}
+}
+EXPORT_SYMBOL_GPL(flow_offload_acct);
+
 struct flow_offload_tuple_rhash *
 flow_offload_lookup(struct nf_flowtable *flow_table,
 		    struct flow_offload_tuple *tuple)
@@ -501,7 +531,9 @@ static void nf_flow_table_do_cleanup(struct flow_offload *flow, void *data)
 	}
 	if (net_eq(nf_ct_net(e->ct), dev_net(dev)) &&
 	    (flow->tuplehash[0].tuple.iifidx == dev->ifindex ||
-	     flow->tuplehash[1].tuple.iifidx == dev->ifindex))
+	     flow->tuplehash[1].tuple.iifidx == dev->ifindex ||
+	     flow->tuplehash[0].tuple.oifidx == dev->ifindex ||
+	     flow->tuplehash[1].tuple.oifidx == dev->ifindex))
 		flow_offload_dead(flow);
 }
 
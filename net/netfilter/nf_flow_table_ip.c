@@ -6,6 +6,8 @@
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include <linux/netdevice.h>
+#include <linux/if_pppox.h>
+#include <linux/ppp_defs.h>
 #include <net/ip.h>
 #include <net/ipv6.h>
 #include <net/ip6_route.h>
@@ -15,6 +17,125 @@
 #include <linux/tcp.h>
 #include <linux/udp.h>
 
+/* Check that @skb carries @proto, either directly or inside a PPPoE
+ * session, and set @offset to the start of the inner header.
+ */
+static bool nf_flow_skb_encap_protocol(struct sk_buff *skb, __be16 proto,
+				       u32 *offset)
+{
+	struct pppoe_hdr *ph;
+	__be16 inner;
+
+	if (skb->protocol == proto)
+		return true;
+
+	if (skb->protocol != htons(ETH_P_PPP_SES) ||
+	    !pskb_may_pull(skb, PPPOE_SES_HLEN))
+		return false;
+
+	ph = (struct pppoe_hdr *)skb_network_header(skb);
+	if (ph->ver != 1 || ph->type != 1 || ph->code)
+		return false;
+
+	inner = *(__be16 *)(ph + 1);
+	switch (inner) {
+	case htons(PPP_IP):
+		if (proto != htons(ETH_P_IP))
+			return false;
+		break;
+	case htons(PPP_IPV6):
+		if (proto != htons(ETH_P_IPV6))
+			return false;
+		break;
+	default:
+		return false;
+	}
+
+	*offset = PPPOE_SES_HLEN;
+	return true;
+}
+
+static void nf_flow_tuple_encap(struct sk_buff *skb,
+				struct flow_offload_tuple *tuple)
+{
+	struct pppoe_hdr *ph;
+
+	if (skb->protocol != htons(ETH_P_PPP_SES))
+		return;
+
+	ph = (struct pppoe_hdr *)skb_network_header(skb);
+	tuple->encap.id = ntohs(ph->sid);
+	tuple->encap.proto = skb->protocol;
+}
+
+static void nf_flow_encap_pop(struct sk_buff *skb, __be16 proto)
+{
+	if (skb->protocol != htons(ETH_P_PPP_SES))
+		return;
+
+	skb_pull_rcsum(skb, PPPOE_SES_HLEN);
+	skb_reset_network_header(skb);
+	skb->protocol = proto;
+}
+
+static bool nf_flow_pppoe_egress(const struct flow_offload *flow,
+				 enum flow_offload_tuple_dir dir)
+{
+	const struct flow_offload_tuple *tuple = &flow->tuplehash[dir].tuple;
+
+	/* a flow leaves through the session its reply arrives in */
+	return tuple->xmit_type == FLOW_OFFLOAD_XMIT_DIRECT &&
+	       flow->tuplehash[!dir].tuple.encap.proto == htons(ETH_P_PPP_SES);
+}
+
+static void nf_flow_pppoe_push(struct sk_buff *skb, u16 id)
+{
+	struct pppoe_hdr *ph;
+	__be16 proto;
+
+	proto = skb->protocol == htons(ETH_P_IP) ? htons(PPP_IP) :
+						   htons(PPP_IPV6);
+	__skb_push(skb, PPPOE_SES_HLEN);
+	skb_reset_network_header(skb);
+
+	ph = (struct pppoe_hdr *)skb->data;
+	ph->ver = 1;
+	ph->type = 1;
+	ph->code = 0;
+	ph->sid = htons(id);
+	ph->length = htons(skb->len - sizeof(*ph));
+	*(__be16 *)(ph + 1) = proto;
+	skb->protocol = htons(ETH_P_PPP_SES);
+}
+
+/* Bypass the upper devices (bridge, ppp) and send straight to the lower
+ * device that dev_fill_forward_path() found when the flow was set up.
+ */
+static unsigned int nf_flow_xmit_direct(struct sk_buff *skb,
+					struct net_device *outdev,
+					const struct flow_offload *flow,
+					enum flow_offload_tuple_dir dir)
+{
+	const struct flow_offload_tuple *tuple = &flow->tuplehash[dir].tuple;
+	bool pppoe = nf_flow_pppoe_egress(flow, dir);
+
+	if (skb_cow_head(skb, LL_RESERVED_SPACE(outdev) +
+			      (pppoe ? PPPOE_SES_HLEN : 0)))
+		return NF_DROP;
+
+	if (pppoe)
+		nf_flow_pppoe_push(skb, flow->tuplehash[!dir].tuple.encap.id);
+
+	skb->dev = outdev;
+	if (dev_hard_header(skb, outdev, ntohs(skb->protocol), tuple->h_dest,
+			    tuple->h_source, skb->len) < 0)
+		return NF_DROP;
+
+	dev_queue_xmit(skb);
+
+	return NF_STOLEN;
+}
+
 static int nf_flow_state_check(struct flow_offload *flow, int proto,
 			       struct sk_buff *skb, unsigned int thoff)
 {
@@ -161,16 +282,16 @@ static bool ip_has_options(unsigned int thoff)
 }
 
 static int nf_flow_tuple_ip(struct sk_buff *skb, const struct net_device *dev,
-			    struct flow_offload_tuple *tuple)
+			    struct flow_offload_tuple *tuple, u32 offset)
 {
 	struct flow_ports *ports;
 	unsigned int thoff;
 	struct iphdr *iph;
 
-	if (!pskb_may_pull(skb, sizeof(*iph)))
+	if (!pskb_may_pull(skb, offset + sizeof(*iph)))
 		return -1;
 
-	iph = ip_hdr(skb);
+	iph = (struct iphdr *)(skb_network_header(skb) + offset);
 	thoff = iph->ihl * 4;
 
 	if (ip_is_fragment(iph) ||
@@ -184,11 +305,11 @@ static int nf_flow_tuple_ip(struct sk_buff *skb, const struct net_device *dev,
 	if (iph->ttl <= 1)
 		return -1;
 
-	thoff = iph->ihl * 4;
+	thoff = iph->ihl * 4 + offset;
 	if (!pskb_may_pull(skb, thoff + sizeof(*ports)))
 		return -1;
 
-	iph = ip_hdr(skb);
+	iph = (struct iphdr *)(skb_network_header(skb) + offset);
 	ports = (struct flow_ports *)(skb_network_header(skb) + thoff);
 
 	tuple->src_v4.s_addr	= iph->saddr;
@@ -198,6 +319,7 @@ static int nf_flow_tuple_ip(struct sk_buff *skb, const struct net_device *dev,
 	tuple->l3proto		= AF_INET;
 	tuple->l4proto		= iph->protocol;
 	tuple->iifidx		= dev->ifindex;
+	nf_flow_tuple_encap(skb, tuple);
 
 	return 0;
 }
@@ -228,11 +350,12 @@ nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
 	unsigned int thoff;
 	struct iphdr *iph;
 	__be32 nexthop;
+	u32 offset = 0;
 
-	if (skb->protocol != htons(ETH_P_IP))
+	if (!nf_flow_skb_encap_protocol(skb, htons(ETH_P_IP), &offset))
 		return NF_ACCEPT;
 
-	if (nf_flow_tuple_ip(skb, state->in, &tuple) < 0)
+	if (nf_flow_tuple_ip(skb, state->in, &tuple, offset) < 0)
 		return NF_ACCEPT;
 
 	tuplehash = flow_offload_lookup(flow_table, &tuple);
@@ -247,16 +370,24 @@ nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
 	flow = container_of(tuplehash, struct flow_offload, tuplehash[dir]);
 	rt = (struct rtable *)flow->tuplehash[dir].tuple.dst_cache;
 
-	if (unlikely(nf_flow_exceeds_mtu(skb, flow->tuplehash[dir].tuple.mtu)))
+	if (unlikely(nf_flow_exceeds_mtu(skb, flow->tuplehash[dir].tuple.mtu +
+					      offset)))
 		return NF_ACCEPT;
 
-	if (skb_try_make_writable(skb, sizeof(*iph)))
-		return NF_DROP;
+	/* lower devices do not segment PPPoE, leave it to the ppp device */
+	if (skb_is_gso(skb) && nf_flow_pppoe_egress(flow, dir))
+		return NF_ACCEPT;
 
-	thoff = ip_hdr(skb)->ihl * 4;
-	if (nf_flow_state_check(flow, ip_hdr(skb)->protocol, skb, thoff))
+	iph = (struct iphdr *)(skb_network_header(skb) + offset);
+	thoff = iph->ihl * 4;
+	if (nf_flow_state_check(flow, iph->protocol, skb, thoff + offset))
 		return NF_ACCEPT;
 
+	nf_flow_encap_pop(skb, htons(ETH_P_IP));
+
+	if (skb_try_make_writable(skb, sizeof(*iph)))
+		return NF_DROP;
+
 	if (flow->flags & (FLOW_OFFLOAD_SNAT | FLOW_OFFLOAD_DNAT) &&
 	    nf_flow_nat_ip(flow, skb, thoff, dir) < 0)
 		return NF_DROP;
@@ -264,6 +395,11 @@ nf_flow_offload_ip_hook(void *priv, struct sk_buff *skb,
 	flow->timeout = (u32)jiffies + NF_FLOW_TIMEOUT;
 	iph = ip_hdr(skb);
 	ip_decrease_ttl(iph);
+	if (flow_table->flags & NF_FLOWTABLE_COUNTER)
+		flow_offload_acct(flow, dir, skb->len);
+
+	if (flow->tuplehash[dir].tuple.xmit_type == FLOW_OFFLOAD_XMIT_DIRECT)
+		return nf_flow_xmit_direct(skb, outdev, flow, dir);
 
 	skb->dev = outdev;
 	nexthop = rt_nexthop(rt, flow->tuplehash[!dir].tuple.src_v4.s_addr);
@@ -400,16 +536,16 @@ static int nf_flow_nat_ipv6(const struct flow_offload *flow,
 }
 
 static int nf_flow_tuple_ipv6(struct sk_buff *skb, const struct net_device *dev,
-			      struct flow_offload_tuple *tuple)
+			      struct flow_offload_tuple *tuple, u32 offset)
 {
 	struct flow_ports *ports;
 	struct ipv6hdr *ip6h;
 	unsigned int thoff;
 
-	if (!pskb_may_pull(skb, sizeof(*ip6h)))
+	if (!pskb_may_pull(skb, offset + sizeof(*ip6h)))
 		return -1;
 
-	ip6h = ipv6_hdr(skb);
+	ip6h = (struct ipv6hdr *)(skb_network_header(skb) + offset);
 
 	if (ip6h->nexthdr != IPPROTO_TCP &&
 	    ip6h->nexthdr != IPPROTO_UDP)
@@ -418,11 +554,11 @@ static int nf_flow_tuple_ipv6(struct sk_buff *skb, const struct net_device *dev,
 	if (ip6h->hop_limit <= 1)
 		return -1;
 
-	thoff = sizeof(*ip6h);
+	thoff = sizeof(*ip6h) + offset;
 	if (!pskb_may_pull(skb, thoff + sizeof(*ports)))
 		return -1;
 
-	ip6h = ipv6_hdr(skb);
+	ip6h = (struct ipv6hdr *)(skb_network_header(skb) + offset);
 	ports = (struct flow_ports *)(skb_network_header(skb) + thoff);
 
 	tuple->src_v6		= ip6h->saddr;
@@ -432,6 +568,7 @@ static int nf_flow_tuple_ipv6(struct sk_buff *skb, const struct net_device *dev,
 	tuple->l3proto		= AF_INET6;
 	tuple->l4proto		= ip6h->nexthdr;
 	tuple->iifidx		= dev->ifindex;
+	nf_flow_tuple_encap(skb, tuple);
 
 	return 0;
 }
@@ -449,11 +586,12 @@ nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
 	struct in6_addr *nexthop;
 	struct ipv6hdr *ip6h;
 	struct rt6_info *rt;
+	u32 offset = 0;
 
-	if (skb->protocol != htons(ETH_P_IPV6))
+	if (!nf_flow_skb_encap_protocol(skb, htons(ETH_P_IPV6), &offset))
 		return NF_ACCEPT;
 
-	if (nf_flow_tuple_ipv6(skb, state->in, &tuple) < 0)
+	if (nf_flow_tuple_ipv6(skb, state->in, &tuple, offset) < 0)
 		return NF_ACCEPT;
 
 	tuplehash = flow_offload_lookup(flow_table, &tuple);
@@ -468,13 +606,20 @@ nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
 	flow = container_of(tuplehash, struct flow_offload, tuplehash[dir]);
 	rt = (struct rt6_info *)flow->tuplehash[dir].tuple.dst_cache;
 
-	if (unlikely(nf_flow_exceeds_mtu(skb, flow->tuplehash[dir].tuple.mtu)))
+	if (unlikely(nf_flow_exceeds_mtu(skb, flow->tuplehash[dir].tuple.mtu +
+					      offset)))
 		return NF_ACCEPT;
 
-	if (nf_flow_state_check(flow, ipv6_hdr(skb)->nexthdr, skb,
-				sizeof(*ip6h)))
+	if (skb_is_gso(skb) && nf_flow_pppoe_egress(flow, dir))
 		return NF_ACCEPT;
 
+	ip6h = (struct ipv6hdr *)(skb_network_header(skb) + offset);
+	if (nf_flow_state_check(flow, ip6h->nexthdr, skb,
+				sizeof(*ip6h) + offset))
+		return NF_ACCEPT;
+
+	nf_flow_encap_pop(skb, htons(ETH_P_IPV6));
+
 	if (skb_try_make_writable(skb, sizeof(*ip6h)))
 		return NF_DROP;
 
@@ -485,6 +630,11 @@ nf_flow_offload_ipv6_hook(void *priv, struct sk_buff *skb,
 	flow->timeout = (u32)jiffies + NF_FLOW_TIMEOUT;
 	ip6h = ipv6_hdr(skb);
 	ip6h->hop_limit--;
+	if (flow_table->flags & NF_FLOWTABLE_COUNTER)
+		flow_offload_acct(flow, dir, skb->len);
+
+	if (flow->tuplehash[dir].tuple.xmit_type == FLOW_OFFLOAD_XMIT_DIRECT)
+		return nf_flow_xmit_direct(skb, outdev, flow, dir);
 
 	skb->dev = outdev;
 	nexthop = rt6_nexthop(rt, &flow->tuplehash[!dir].tuple.src_v6);
@@ -0,0 +1,1340 @@
+// SPDX-License-Identifier: GPL-2.0
+
+/* PIPAPO: PIle PAcket POlicies: set for arbitrary concatenations of ranges
+ *
+ * Matching happens field by field, and each field is split in 4-bit groups.
+ * For each group, a lookup table holds one bucket per possible group value,
+ * and each bucket is a bitmap of the rules matching that value. For instance,
+ * rule 0 for 192.168.1.0/24 sets bit 0 in bucket 0xc of group 0, bucket 0x0
+ * of group 1, and so on up to group 5, then in all the buckets of the last
+ * two groups, as the mask spans them entirely.
+ *
+ * A packet field is looked up by selecting, for each group, the bucket
+ * matching the packet bits and ANDing all the selected buckets together: the
+ * bits left set are the rules matching the whole field. Ranges are expanded
+ * into netmasks, and netmasks translate to groups where all the buckets
+ * match, so a single range can take up to 2 * n - 2 rules for an n-bit
+ * field.
+ *
+ * Each rule in a field then maps, through a mapping table, to the range of
+ * rules it corresponds to in the next field, and the resulting bitmap is the
+ * starting point for the next field instead of an all-ones one. Rules in the
+ * last field map to the element itself.
+ *
+ * The cost of a lookup is then one AND of a bitmap per 4-bit group of packet
+ * data, and doesn't depend on the way ranges overlap, only on the number of
+ * rules rounded up to machine words.
+ *
+ * The lookup path only deals with a copy of the matching data that is never
+ * modified: insertions and deletions act on a clone, which is swapped in on
+ * commit, and the old copy is freed after an RCU grace period.
+ */
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/bitmap.h>
+#include <linux/bottom_half.h>
+#include <linux/netlink.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter/nf_tables.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <net/netfilter/nf_tables.h>
+
+/* Number of bits to be grouped together in lookup tables */
+#define NFT_PIPAPO_GROUP_BITS		4
+#define NFT_PIPAPO_GROUPS_PER_BYTE	(BITS_PER_BYTE / NFT_PIPAPO_GROUP_BITS)
+
+/* Number of buckets, given by 2 ^ n, with n grouped bits */
+#define NFT_PIPAPO_BUCKETS		(1 << NFT_PIPAPO_GROUP_BITS)
+
+#define NFT_PIPAPO_MIN_FIELDS		2
+#define NFT_PIPAPO_MAX_FIELDS		NFT_REG32_COUNT
+
+/* Largest supported field size, also the size of keys used for expansion */
+#define NFT_PIPAPO_MAX_BYTES		(sizeof(struct in6_addr))
+
+/* Rule indices are returned as int by pipapo_refill() */
+#define NFT_PIPAPO_RULES_MAX		INT_MAX
+
+/* Fields are stored in the key at 32-bit register boundaries */
+#define NFT_PIPAPO_FIELD_SIZE(f)					\
+	(round_up((f)->groups / NFT_PIPAPO_GROUPS_PER_BYTE, sizeof(u32)))
+
+#define nft_pipapo_for_each_field(field, index, match)		\
+	for ((field) = (match)->f, (index) = 0;			\
+	     (index) < (match)->field_count;			\
+	     (index)++, (field)++)
+
+/**
+ * union nft_pipapo_map_bucket - Bucket of mapping table
+ * @to:		First rule number (in next field) this rule maps to
+ * @n:		Number of rules (in next field) this rule maps to
+ * @e:		If there's no next field, pointer to element this rule maps to
+ */
+union nft_pipapo_map_bucket {
+	struct {
+		u32 to;
+		u32 n;
+	};
+	struct nft_pipapo_elem *e;
+};
+
+/**
+ * struct nft_pipapo_field - Lookup, mapping tables and related data for a field
+ * @groups:	Amount of 4-bit groups
+ * @rules:	Number of inserted rules
+ * @bsize:	Size of each bucket in lookup table, in longs
+ * @lt:		Lookup table: 'groups' rows of NFT_PIPAPO_BUCKETS buckets
+ * @mt:		Mapping table: one bucket per rule
+ */
+struct nft_pipapo_field {
+	int groups;
+	unsigned long rules;
+	size_t bsize;
+	unsigned long *lt;
+	union nft_pipapo_map_bucket *mt;
+};
+
+/**
+ * struct nft_pipapo_match - Data used for lookup and matching
+ * @field_count:	Amount of fields in set
+ * @scratch:		Preallocated per-CPU maps for partial matching results
+ * @bsize_max:		Maximum lookup table bucket size of all fields, in longs
+ * @rcu:		Matching data is swapped on commits
+ * @f:			Fields, with lookup and mapping tables
+ */
+struct nft_pipapo_match {
+	int field_count;
+	unsigned long * __percpu *scratch;
+	size_t bsize_max;
+	struct rcu_head rcu;
+	struct nft_pipapo_field f[0];
+};
+
+/**
+ * struct nft_pipapo - Representation of a set
+ * @match:	Currently in-use matching data
+ * @clone:	Copy where pending insertions and deletions are kept
+ * @dirty:	Working copy has pending insertions or deletions
+ */
+struct nft_pipapo {
+	struct nft_pipapo_match __rcu *match;
+	struct nft_pipapo_match *clone;
+	bool dirty;
+};
+
+/**
+ * struct nft_pipapo_elem - API-facing representation of single set element
+ * @ext:	nftables API extensions
+ */
+struct nft_pipapo_elem {
+	struct nft_set_ext ext;
+};
+
+/* Value of 4-bit group @group in @data, most significant group first */
+static u8 pipapo_group_value(const u8 *data, int group)
+{
+	u8 v = data[group / NFT_PIPAPO_GROUPS_PER_BYTE];
+
+	return group % NFT_PIPAPO_GROUPS_PER_BYTE ? v & 0x0f : v >> 4;
+}
+
+/**
+ * pipapo_and_field_buckets() - AND buckets selected by packet data into @dst
+ * @f:		Field, with lookup table and group count
+ * @dst:	Result map, initialised with matches from the previous field
+ * @data:	Packet data for this field
+ *
+ * This is the hot path of lookups: a plain word-at-a-time AND of one bucket
+ * per group, stopping early once no rules are left.
+ *
+ * Return: false if no rules match the field, true otherwise.
+ */
+static bool pipapo_and_field_buckets(const struct nft_pipapo_field *f,
+				     unsigned long *dst, const u8 *data)
+{
+	const unsigned long *lt = f->lt, *b;
+	unsigned long any;
+	size_t k;
+	int group;
+
+	for (group = 0; group < f->groups; group++) {
+		b = lt + pipapo_group_value(data, group) * f->bsize;
+
+		for (k = 0, any = 0; k < f->bsize; k++) {
+			dst[k] &= b[k];
+			any |= dst[k];
+		}
+
+		if (!any)
+			return false;
+
+		lt += f->bsize * NFT_PIPAPO_BUCKETS;
+	}
+
+	return true;
+}
+
+/**
+ * pipapo_refill() - For each set bit, set bits from selected mapping table item
+ * @map:	Bitmap to be scanned for set bits, all zeroes on return
+ * @len:	Length of bitmap in longs
+ * @rules:	Number of rules in field
+ * @dst:	Destination bitmap
+ * @mt:		Mapping table containing bit set specifiers
+ * @match_only:	Find a single bit and return, don't fill
+ *
+ * With @match_only, the bit found is cleared from @map, so that a further
+ * call returns the next matching rule.
+ *
+ * Return: -1 on no match, rule index of match if @match_only, 0 otherwise.
+ */
+static int pipapo_refill(unsigned long *map, size_t len, unsigned long rules,
+			 unsigned long *dst,
+			 const union nft_pipapo_map_bucket *mt,
+			 bool match_only)
+{
+	unsigned long bitset;
+	int ret = -1;
+	size_t k;
+
+	for (k = 0; k < len; k++) {
+		bitset = map[k];
+		while (bitset) {
+			unsigned long i = k * BITS_PER_LONG + __ffs(bitset);
+
+			if (unlikely(i >= rules)) {
+				map[k] = 0;
+				return -1;
+			}
+
+			if (match_only) {
+				__clear_bit(i, map);
+				return i;
+			}
+
+			ret = 0;
+
+			bitmap_set(dst, mt[i].to, mt[i].n);
+
+			bitset &= bitset - 1;
+		}
+		map[k] = 0;
+	}
+
+	return ret;
+}
+
+static bool pipapo_elem_equal(const struct nft_set *set,
+			      const struct nft_pipapo_elem *e,
+			      const u8 *start, const u8 *end)
+{
+	const struct nft_data *key_end;
+
+	if (memcmp(nft_set_ext_key(&e->ext), start, set->klen))
+		return false;
+
+	if (nft_set_ext_exists(&e->ext, NFT_SET_EXT_KEY_END))
+		key_end = nft_set_ext_key_end(&e->ext);
+	else
+		key_end = nft_set_ext_key(&e->ext);
+
+	return !memcmp(key_end, end, set->klen);
+}
+
+/**
+ * pipapo_find() - Find the first element matching packet or key data
+ * @set:	nftables API set representation
+ * @m:		Matching data
+ * @res_map:	Zeroed map of at least m->bsize_max longs
+ * @fill_map:	Zeroed map of at least m->bsize_max longs
+ * @data:	Key data to be matched against existing elements
+ * @end:	If not NULL, only match the element with @data, @end as bounds
+ * @genmask:	nftables API generation mask, zero for any generation
+ *
+ * Return: pointer to the element, NULL if none matches.
+ */
+static struct nft_pipapo_elem *pipapo_find(const struct nft_set *set,
+					   const struct nft_pipapo_match *m,
+					   unsigned long *res_map,
+					   unsigned long *fill_map,
+					   const u8 *data, const u8 *end,
+					   u8 genmask)
+{
+	const struct nft_pipapo_field *f;
+	const u8 *start = data;
+	int i;
+
+	memset(res_map, 0xff, m->f[0].bsize * sizeof(*res_map));
+
+	nft_pipapo_for_each_field(f, i, m) {
+		bool last = i == m->field_count - 1;
+		struct nft_pipapo_elem *e;
+		int b;
+
+		if (!pipapo_and_field_buckets(f, res_map, data))
+			return NULL;
+
+		/* Now res_map contains the matching bitmap for this field, fill
+		 * fill_map with the rules it maps to in the next field, unless
+		 * this is the last field: then pick the first matching element.
+		 */
+next_match:
+		b = pipapo_refill(res_map, f->bsize, f->rules, fill_map, f->mt,
+				  last);
+		if (b < 0)
+			return NULL;
+
+		if (last) {
+			e = f->mt[b].e;
+			if (!nft_set_elem_active(&e->ext, genmask) ||
+			    (end && !pipapo_elem_equal(set, e, start, end)))
+				goto next_match;
+
+			return e;
+		}
+
+		/* res_map is all zeroes after refill, and becomes fill_map
+		 * for the next field.
+		 */
+		swap(res_map, fill_map);
+		data += NFT_PIPAPO_FIELD_SIZE(f);
+	}
+
+	return NULL;
+}
+
+/**
+ * nft_pipapo_lookup() - Lookup function
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @key:	nftables API element representation containing key data
+ * @ext:	nftables API extension pointer, filled with matching reference
+ *
+ * Matching data is only read here, partial results go to per-CPU scratch
+ * maps: bottom halves are disabled so that lookups from process context
+ * can't be interrupted by a lookup on the same CPU.
+ *
+ * Return: true on match, false otherwise.
+ */
+static bool nft_pipapo_lookup(const struct net *net, const struct nft_set *set,
+			      const u32 *key, const struct nft_set_ext **ext)
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_elem *e = NULL;
+	struct nft_pipapo_match *m;
+	unsigned long *scratch;
+
+	local_bh_disable();
+
+	m = rcu_dereference(priv->match);
+	if (unlikely(!m))
+		goto out;
+
+	scratch = *raw_cpu_ptr(m->scratch);
+	if (unlikely(!scratch))
+		goto out;
+
+	memset(scratch, 0, m->bsize_max * 2 * sizeof(*scratch));
+
+	e = pipapo_find(set, m, scratch, scratch + m->bsize_max,
+			(const u8 *)key, NULL, nft_genmask_cur(net));
+	if (e)
+		*ext = &e->ext;
+out:
+	local_bh_enable();
+
+	return e != NULL;
+}
+
+/**
+ * pipapo_get() - Get matching element reference given key data
+ * @set:	nftables API set representation
+ * @m:		Matching data, usually the working copy
+ * @data:	Key data to be matched against existing elements
+ * @end:	If not NULL, look for an exact match of @data, @end bounds
+ * @genmask:	nftables API generation mask, zero for any generation
+ *
+ * This is a copy of the lookup path for the control plane, with maps
+ * allocated on the spot instead of per-CPU scratch maps.
+ *
+ * Return: pointer to &struct nft_pipapo_elem on match, error pointer otherwise.
+ */
+static struct nft_pipapo_elem *pipapo_get(const struct nft_set *set,
+					  const struct nft_pipapo_match *m,
+					  const u8 *data, const u8 *end,
+					  u8 genmask)
+{
+	struct nft_pipapo_elem *e;
+	unsigned long *maps;
+
+	maps = kcalloc(m->bsize_max * 2, sizeof(*maps), GFP_KERNEL);
+	if (!maps)
+		return ERR_PTR(-ENOMEM);
+
+	e = pipapo_find(set, m, maps, maps + m->bsize_max, data, end, genmask);
+	kfree(maps);
+
+	return e ? e : ERR_PTR(-ENOENT);
+}
+
+/**
+ * nft_pipapo_get() - Get matching element reference given key data
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @elem:	nftables API element representation containing key data
+ * @flags:	Unused
+ *
+ * Return: the first element containing the key, error pointer otherwise.
+ */
+static void *nft_pipapo_get(const struct net *net, const struct nft_set *set,
+			    const struct nft_set_elem *elem, unsigned int flags)
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+
+	return pipapo_get(set, priv->clone, (const u8 *)elem->key.val.data,
+			  NULL, nft_genmask_cur(net));
+}
+
+/**
+ * pipapo_resize() - Resize lookup or mapping table, or both
+ * @f:		Field containing lookup and mapping tables
+ * @old_rules:	Previous amount of rules in field
+ * @rules:	New amount of rules
+ *
+ * Increase, also in place, or decrease the size of lookup tables and mapping
+ * tables to fit @rules. The rule count of @f is left untouched: callers
+ * reserve space before adding rules, so that insertion can't fail halfway.
+ *
+ * Return: 0 on success, -ENOMEM on allocation failure.
+ */
+static int pipapo_resize(struct nft_pipapo_field *f, unsigned long old_rules,
+			 unsigned long rules)
+{
+	unsigned long *new_lt = NULL, *new_p, *old_lt = f->lt, *old_p;
+	union nft_pipapo_map_bucket *new_mt, *old_mt = f->mt;
+	size_t new_bucket_size, copy;
+	int group, bucket;
+
+	new_bucket_size = DIV_ROUND_UP(rules, BITS_PER_LONG);
+
+	if (new_bucket_size == f->bsize)
+		goto mt;
+
+	copy = min(new_bucket_size, f->bsize);
+
+	new_lt = kvzalloc(f->groups * NFT_PIPAPO_BUCKETS * new_bucket_size *
+			  sizeof(*new_lt), GFP_KERNEL);
+	if (!new_lt)
+		return -ENOMEM;
+
+	new_p = new_lt;
+	old_p = old_lt;
+	for (group = 0; group < f->groups; group++) {
+		for (bucket = 0; bucket < NFT_PIPAPO_BUCKETS; bucket++) {
+			memcpy(new_p, old_p, copy * sizeof(*new_p));
+			new_p += new_bucket_size;
+			old_p += f->bsize;
+		}
+	}
+
+mt:
+	new_mt = kvmalloc_array(rules, sizeof(*new_mt), GFP_KERNEL);
+	if (!new_mt) {
+		kvfree(new_lt);
+		return -ENOMEM;
+	}
+
+	memcpy(new_mt, f->mt, min(old_rules, rules) * sizeof(*new_mt));
+	if (rules > old_rules) {
+		memset(new_mt + old_rules, 0,
+		       (rules - old_rules) * sizeof(*new_mt));
+	}
+
+	if (new_lt) {
+		f->bsize = new_bucket_size;
+		f->lt = new_lt;
+		kvfree(old_lt);
+	}
+
+	f->mt = new_mt;
+	kvfree(old_mt);
+
+	return 0;
+}
+
+/**
+ * pipapo_bucket_set() - Set rule bit in bucket given group and group value
+ * @f:		Field containing lookup table
+ * @rule:	Rule index
+ * @group:	Group index
+ * @v:		Value of bit group
+ */
+static void pipapo_bucket_set(struct nft_pipapo_field *f, int rule, int group,
+			      int v)
+{
+	unsigned long *pos;
+
+	pos = f->lt + f->bsize * NFT_PIPAPO_BUCKETS * group;
+	pos += f->bsize * v;
+
+	__set_bit(rule, pos);
+}
+
+/**
+ * pipapo_insert() - Insert new rule in field given input key and mask length
+ * @f:		Field containing lookup table
+ * @k:		Input key for classification, without nftables padding
+ * @mask_bits:	Length of mask; matches field length for non-ranged entry
+ *
+ * Space for the new rule must have been reserved with pipapo_resize().
+ */
+static void pipapo_insert(struct nft_pipapo_field *f, const u8 *k,
+			  int mask_bits)
+{
+	int rule = f->rules++, group, i, v;
+	u8 mask;
+
+	for (group = 0; group < f->groups; group++) {
+		v = pipapo_group_value(k, group);
+
+		if (mask_bits >= (group + 1) * NFT_PIPAPO_GROUP_BITS) {
+			/* Not masked */
+			pipapo_bucket_set(f, rule, group, v);
+		} else if (mask_bits <= group * NFT_PIPAPO_GROUP_BITS) {
+			/* Completely masked */
+			for (i = 0; i < NFT_PIPAPO_BUCKETS; i++)
+				pipapo_bucket_set(f, rule, group, i);
+		} else {
+			/* The mask limit falls on this group */
+			mask = GENMASK(NFT_PIPAPO_GROUP_BITS - 1, 0);
+			mask >>= mask_bits - group * NFT_PIPAPO_GROUP_BITS;
+			for (i = 0; i < NFT_PIPAPO_BUCKETS; i++) {
+				if ((i & ~mask) == (v & ~mask))
+					pipapo_bucket_set(f, rule, group, i);
+			}
+		}
+	}
+}
+
+/* Keys are handled as big-endian byte strings of @bytes length: @step counts
+ * bits from the least significant one.
+ */
+static bool pipapo_test_bit(const u8 *x, int bytes, int step)
+{
+	return x[bytes - 1 - step / BITS_PER_BYTE] & BIT(step % BITS_PER_BYTE);
+}
+
+/* Set the @bits least significant bits of @x */
+static void pipapo_fill_low(u8 *x, int bytes, int bits)
+{
+	int i;
+
+	for (i = bytes - 1; bits >= BITS_PER_BYTE; i--, bits -= BITS_PER_BYTE)
+		x[i] = 0xff;
+
+	if (bits)
+		x[i] |= GENMASK(bits - 1, 0);
+}
+
+static void pipapo_increment(u8 *x, int bytes)
+{
+	int i;
+
+	for (i = bytes - 1; i >= 0; i--) {
+		if (++x[i])
+			break;
+	}
+}
+
+/**
+ * pipapo_expand() - Expand to composing netmasks, insert into lookup table
+ * @f:		Field containing lookup table, NULL to count netmasks only
+ * @start:	Start of range
+ * @end:	End of range
+ * @len:	Length of value in bits
+ *
+ * Expand range to composing netmasks and insert corresponding rule entries
+ * in the lookup table: at each step, take the widest block aligned on the
+ * current base and not past @end, then move past it.
+ *
+ * Return: number of inserted rules.
+ */
+static int pipapo_expand(struct nft_pipapo_field *f,
+			 const u8 *start, const u8 *end, int len)
+{
+	int step, masks = 0, bytes = len / BITS_PER_BYTE;
+	u8 base[NFT_PIPAPO_MAX_BYTES], tmp[NFT_PIPAPO_MAX_BYTES];
+
+	memcpy(base, start, bytes);
+	for (;;) {
+		for (step = 0; step < len; step++) {
+			if (pipapo_test_bit(base, bytes, step))
+				break;
+
+			memcpy(tmp, base, bytes);
+			pipapo_fill_low(tmp, bytes, step + 1);
+			if (memcmp(tmp, end, bytes) > 0)
+				break;
+		}
+
+		if (f)
+			pipapo_insert(f, base, len - step);
+		masks++;
+
+		pipapo_fill_low(base, bytes, step);
+		if (!memcmp(base, end, bytes))
+			break;
+
+		pipapo_increment(base, bytes);
+	}
+
+	return masks;
+}
+
+/**
+ * pipapo_map() - Insert rules in mapping tables, mapping them between fields
+ * @m:		Matching data, including mapping table
+ * @map:	Table of rule maps: array of first rule and amount of rules
+ *		in next field a given rule maps to, for each field
+ * @e:		For last field, nft_set_ext pointer matching rules map to
+ */
+static void pipapo_map(struct nft_pipapo_match *m,
+		       union nft_pipapo_map_bucket map[NFT_PIPAPO_MAX_FIELDS],
+		       struct nft_pipapo_elem *e)
+{
+	struct nft_pipapo_field *f;
+	int i, j;
+
+	for (i = 0, f = m->f; i < m->field_count - 1; i++, f++) {
+		for (j = 0; j < map[i].n; j++) {
+			f->mt[map[i].to + j].to = map[i + 1].to;
+			f->mt[map[i].to + j].n = map[i + 1].n;
+		}
+	}
+
+	/* Last field: map to ext instead of mapping to next field */
+	for (j = 0; j < map[i].n; j++)
+		f->mt[map[i].to + j].e = e;
+}
+
+/**
+ * pipapo_realloc_scratch() - Reallocate scratch maps for partial match results
+ * @m:		Matching data
+ * @bsize_max:	Maximum bucket size, in longs, scratch maps need to fit
+ *
+ * Only called on the working copy, which is not used by lookups yet.
+ *
+ * Return: 0 on success, -ENOMEM on failure.
+ */
+static int pipapo_realloc_scratch(struct nft_pipapo_match *m,
+				  size_t bsize_max)
+{
+	int i;
+
+	for_each_possible_cpu(i) {
+		unsigned long *scratch;
+
+		scratch = kzalloc_node(bsize_max * sizeof(*scratch) * 2,
+				       GFP_KERNEL, cpu_to_node(i));
+		if (!scratch)
+			return -ENOMEM;
+
+		kfree(*per_cpu_ptr(m->scratch, i));
+		*per_cpu_ptr(m->scratch, i) = scratch;
+	}
+
+	return 0;
+}
+
+/**
+ * nft_pipapo_insert() - Validate and insert ranged elements
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @elem:	nftables API element representation containing key data
+ * @ext2:	Filled with pointer to &struct nft_set_ext in inserted element
+ *
+ * Space for all the rules needed by the element is reserved first, so that
+ * a failure doesn't leave rules without a mapping in the working copy.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+static int nft_pipapo_insert(const struct net *net, const struct nft_set *set,
+			     const struct nft_set_elem *elem,
+			     struct nft_set_ext **ext2)
+{
+	const struct nft_set_ext *ext = nft_set_elem_ext(set, elem->priv);
+	union nft_pipapo_map_bucket rulemap[NFT_PIPAPO_MAX_FIELDS];
+	unsigned long new_rules[NFT_PIPAPO_MAX_FIELDS];
+	struct nft_pipapo_elem *e = elem->priv, *dup;
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_match *m = priv->clone;
+	u8 genmask = nft_genmask_next(net);
+	const u8 *start, *end, *start_p, *end_p;
+	struct nft_pipapo_field *f;
+	size_t bsize_max;
+	int i, err;
+
+	if (nft_set_ext_exists(ext, NFT_SET_EXT_FLAGS) &&
+	    *nft_set_ext_flags(ext) & NFT_SET_ELEM_INTERVAL_END)
+		return -EOPNOTSUPP;
+
+	start = (const u8 *)nft_set_ext_key(ext)->data;
+	if (nft_set_ext_exists(ext, NFT_SET_EXT_KEY_END))
+		end = (const u8 *)nft_set_ext_key_end(ext)->data;
+	else
+		end = start;
+
+	dup = pipapo_get(set, m, start, end, genmask);
+	if (!IS_ERR(dup)) {
+		*ext2 = &dup->ext;
+		return -EEXIST;
+	}
+
+	/* Look for partially overlapping entries */
+	if (PTR_ERR(dup) == -ENOENT)
+		dup = pipapo_get(set, m, start, NULL, genmask);
+	if (PTR_ERR(dup) == -ENOENT)
+		dup = pipapo_get(set, m, end, NULL, genmask);
+
+	if (PTR_ERR(dup) != -ENOENT) {
+		if (IS_ERR(dup))
+			return PTR_ERR(dup);
+		*ext2 = &dup->ext;
+		return -ENOTEMPTY;
+	}
+
+	/* Validate, and count rules needed by each field */
+	bsize_max = m->bsize_max;
+	start_p = start;
+	end_p = end;
+	nft_pipapo_for_each_field(f, i, m) {
+		int len = f->groups * NFT_PIPAPO_GROUP_BITS;
+
+		if (memcmp(start_p, end_p, len / BITS_PER_BYTE) > 0)
+			return -EINVAL;
+
+		new_rules[i] = f->rules + pipapo_expand(NULL, start_p, end_p,
+							len);
+		if (new_rules[i] > NFT_PIPAPO_RULES_MAX)
+			return -ENOSPC;
+
+		bsize_max = max_t(size_t, bsize_max,
+				  DIV_ROUND_UP(new_rules[i], BITS_PER_LONG));
+
+		start_p += NFT_PIPAPO_FIELD_SIZE(f);
+		end_p += NFT_PIPAPO_FIELD_SIZE(f);
+	}
+
+	if (bsize_max > m->bsize_max) {
+		err = pipapo_realloc_scratch(m, bsize_max);
+		if (err)
+			return err;
+
+		m->bsize_max = bsize_max;
+	}
+
+	nft_pipapo_for_each_field(f, i, m) {
+		err = pipapo_resize(f, f->rules, new_rules[i]);
+		if (err)
+			return err;
+	}
+
+	/* Insert */
+	priv->dirty = true;
+
+	nft_pipapo_for_each_field(f, i, m) {
+		rulemap[i].to = f->rules;
+		rulemap[i].n = pipapo_expand(f, start, end,
+					     f->groups * NFT_PIPAPO_GROUP_BITS);
+
+		start += NFT_PIPAPO_FIELD_SIZE(f);
+		end += NFT_PIPAPO_FIELD_SIZE(f);
+	}
+
+	pipapo_map(m, rulemap, e);
+
+	return 0;
+}
+
+/**
+ * pipapo_free_scratch() - Free per-CPU scratch maps and their pointers
+ * @m:		Matching data
+ */
+static void pipapo_free_scratch(const struct nft_pipapo_match *m)
+{
+	int i;
+
+	for_each_possible_cpu(i)
+		kfree(*per_cpu_ptr(m->scratch, i));
+
+	free_percpu(m->scratch);
+}
+
+/**
+ * pipapo_free_match() - Free matching data, with lookup and mapping tables
+ * @m:		Matching data
+ */
+static void pipapo_free_match(struct nft_pipapo_match *m)
+{
+	struct nft_pipapo_field *f;
+	int i;
+
+	nft_pipapo_for_each_field(f, i, m) {
+		kvfree(f->lt);
+		kvfree(f->mt);
+	}
+
+	pipapo_free_scratch(m);
+	kfree(m);
+}
+
+/**
+ * pipapo_clone() - Clone matching data to create new working copy
+ * @old:	Existing matching data
+ *
+ * Return: copy of matching data passed as 'old', error pointer on failure
+ */
+static struct nft_pipapo_match *pipapo_clone(struct nft_pipapo_match *old)
+{
+	struct nft_pipapo_field *dst, *src;
+	struct nft_pipapo_match *new;
+	int i;
+
+	new = kmalloc(sizeof(*new) + sizeof(*dst) * old->field_count,
+		      GFP_KERNEL);
+	if (!new)
+		return ERR_PTR(-ENOMEM);
+
+	new->field_count = old->field_count;
+	new->bsize_max = old->bsize_max;
+
+	new->scratch = alloc_percpu(*new->scratch);
+	if (!new->scratch)
+		goto out_scratch;
+
+	if (pipapo_realloc_scratch(new, old->bsize_max))
+		goto out_scratch_realloc;
+
+	src = old->f;
+	dst = new->f;
+
+	for (i = 0; i < old->field_count; i++) {
+		size_t lt_size = src->groups * NFT_PIPAPO_BUCKETS * src->bsize;
+
+		memcpy(dst, src, offsetof(struct nft_pipapo_field, lt));
+
+		dst->lt = kvmalloc_array(lt_size, sizeof(*dst->lt), GFP_KERNEL);
+		if (!dst->lt)
+			goto out_lt;
+
+		memcpy(dst->lt, src->lt, lt_size * sizeof(*dst->lt));
+
+		dst->mt = kvmalloc_array(src->rules, sizeof(*src->mt),
+					 GFP_KERNEL);
+		if (!dst->mt)
+			goto out_mt;
+
+		memcpy(dst->mt, src->mt, src->rules * sizeof(*src->mt));
+		src++;
+		dst++;
+	}
+
+	return new;
+
+out_mt:
+	kvfree(dst->lt);
+out_lt:
+	for (dst--; i > 0; i--) {
+		kvfree(dst->mt);
+		kvfree(dst->lt);
+		dst--;
+	}
+out_scratch_realloc:
+	pipapo_free_scratch(new);
+	kfree(new);
+
+	return ERR_PTR(-ENOMEM);
+
+out_scratch:
+	kfree(new);
+
+	return ERR_PTR(-ENOMEM);
+}
+
+static void pipapo_reclaim_match(struct rcu_head *rcu)
+{
+	struct nft_pipapo_match *m;
+
+	m = container_of(rcu, struct nft_pipapo_match, rcu);
+	pipapo_free_match(m);
+}
+
+/**
+ * pipapo_commit() - Replace lookup data with current working copy
+ * @set:	nftables API set representation
+ *
+ * There's no commit step in the set API: this is called on activation and
+ * removal of elements, and only does something the first time after the
+ * working copy was changed. If a new working copy can't be allocated, the
+ * current one is kept and published on the next commit.
+ */
+static void pipapo_commit(const struct nft_set *set)
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_match *new_clone, *old;
+
+	if (!priv->dirty)
+		return;
+
+	new_clone = pipapo_clone(priv->clone);
+	if (IS_ERR(new_clone))
+		return;
+
+	priv->dirty = false;
+
+	old = rcu_access_pointer(priv->match);
+	rcu_assign_pointer(priv->match, priv->clone);
+	if (old)
+		call_rcu(&old->rcu, pipapo_reclaim_match);
+
+	priv->clone = new_clone;
+}
+
+/**
+ * nft_pipapo_activate() - Mark element reference as active given key, commit
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @elem:	nftables API element representation containing key data
+ */
+static void nft_pipapo_activate(const struct net *net,
+				const struct nft_set *set,
+				const struct nft_set_elem *elem)
+{
+	struct nft_pipapo_elem *e = elem->priv;
+
+	nft_set_elem_change_active(net, set, &e->ext);
+	nft_set_elem_clear_busy(&e->ext);
+
+	pipapo_commit(set);
+}
+
+/**
+ * nft_pipapo_deactivate() - Find and deactivate the element with given bounds
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @elem:	nftables API element representation containing key data
+ *
+ * Return: deactivated element if found, NULL otherwise.
+ */
+static void *nft_pipapo_deactivate(const struct net *net,
+				   const struct nft_set *set,
+				   const struct nft_set_elem *elem)
+{
+	const struct nft_set_ext *ext = nft_set_elem_ext(set, elem->priv);
+	struct nft_pipapo *priv = nft_set_priv(set);
+	const u8 *start, *end;
+	struct nft_pipapo_elem *e;
+
+	start = (const u8 *)nft_set_ext_key(ext)->data;
+	if (nft_set_ext_exists(ext, NFT_SET_EXT_KEY_END))
+		end = (const u8 *)nft_set_ext_key_end(ext)->data;
+	else
+		end = start;
+
+	e = pipapo_get(set, priv->clone, start, end, nft_genmask_next(net));
+	if (IS_ERR(e))
+		return NULL;
+
+	nft_set_elem_change_active(net, set, &e->ext);
+
+	return e;
+}
+
+/**
+ * nft_pipapo_flush() - Make element inactive in the next generation
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @elem:	Element found by the walk over the working copy
+ *
+ * Return: true, elements are always found by the walk that calls this.
+ */
+static bool nft_pipapo_flush(const struct net *net, const struct nft_set *set,
+			     void *elem)
+{
+	struct nft_pipapo_elem *e = elem;
+
+	nft_set_elem_change_active(net, set, &e->ext);
+
+	return true;
+}
+
+/**
+ * pipapo_find_rules() - Find the range of rules in a field with given mapping
+ * @f:		Field to scan
+ * @last:	Last field: compare element pointers instead of rule ranges
+ * @key:	Mapping to look for
+ * @range:	Filled with the first rule and the number of rules found
+ *
+ * Rules for a given element are contiguous in each field, as they are
+ * inserted together and dropped together.
+ *
+ * Return: true if rules were found, false otherwise.
+ */
+static bool pipapo_find_rules(const struct nft_pipapo_field *f, bool last,
+			      const union nft_pipapo_map_bucket *key,
+			      union nft_pipapo_map_bucket *range)
+{
+	unsigned long r, first = f->rules;
+
+	for (r = 0; r < f->rules; r++) {
+		const union nft_pipapo_map_bucket *b = &f->mt[r];
+		bool match;
+
+		if (last)
+			match = b->e == key->e;
+		else
+			match = b->to == key->to && b->n == key->n;
+
+		if (match && first == f->rules)
+			first = r;
+		else if (!match && first != f->rules)
+			break;
+	}
+
+	if (first == f->rules)
+		return false;
+
+	range->to = first;
+	range->n = r - first;
+
+	return true;
+}
+
+/* Remove @cut bits at @first from bitmap @map of @nbits bits, shifting down
+ * the following ones.
+ */
+static void pipapo_bitmap_cut(unsigned long *map, unsigned long first,
+			      unsigned long cut, unsigned long nbits)
+{
+	unsigned long i;
+
+	for (i = first; i + cut < nbits; i++) {
+		if (test_bit(i + cut, map))
+			__set_bit(i, map);
+		else
+			__clear_bit(i, map);
+	}
+
+	bitmap_clear(map, nbits - cut, cut);
+}
+
+/**
+ * pipapo_drop() - Delete entry from lookup and mapping tables, given rule map
+ * @m:		Matching data
+ * @rulemap:	Table of rule maps, arrays of first rule and amount of rules
+ *		in a field for the entry to be dropped
+ *
+ * Rules following the dropped ones are shifted down in lookup and mapping
+ * tables, and mappings into them from the previous field are adjusted.
+ */
+static void pipapo_drop(struct nft_pipapo_match *m,
+			union nft_pipapo_map_bucket rulemap[])
+{
+	struct nft_pipapo_field *f;
+	int i;
+
+	nft_pipapo_for_each_field(f, i, m) {
+		unsigned long *lt = f->lt, j;
+		int b;
+
+		for (b = 0; b < f->groups * NFT_PIPAPO_BUCKETS; b++) {
+			pipapo_bitmap_cut(lt, rulemap[i].to, rulemap[i].n,
+					  f->rules);
+			lt += f->bsize;
+		}
+
+		memmove(f->mt + rulemap[i].to,
+			f->mt + rulemap[i].to + rulemap[i].n,
+			(f->rules - rulemap[i].to - rulemap[i].n) *
+			sizeof(*f->mt));
+
+		f->rules -= rulemap[i].n;
+
+		if (i < m->field_count - 1) {
+			for (j = 0; j < f->rules; j++) {
+				if (f->mt[j].to > rulemap[i + 1].to)
+					f->mt[j].to -= rulemap[i + 1].n;
+			}
+		}
+
+		/* Shrinking is best effort, larger tables are still valid */
+		if (DIV_ROUND_UP(f->rules, BITS_PER_LONG) < f->bsize)
+			pipapo_resize(f, f->rules, f->rules);
+	}
+}
+
+/**
+ * nft_pipapo_remove() - Remove element given key, commit
+ * @net:	Network namespace
+ * @set:	nftables API set representation
+ * @elem:	nftables API element representation containing key data
+ *
+ * The rules of the element are found from the last field, where they map to
+ * the element itself, back to the first one, through mapping tables.
+ */
+static void nft_pipapo_remove(const struct net *net, const struct nft_set *set,
+			      const struct nft_set_elem *elem)
+{
+	union nft_pipapo_map_bucket rulemap[NFT_PIPAPO_MAX_FIELDS];
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_match *m = priv->clone;
+	union nft_pipapo_map_bucket key;
+	int i = m->field_count - 1;
+
+	key.e = elem->priv;
+	if (!pipapo_find_rules(&m->f[i], true, &key, &rulemap[i]))
+		return;
+
+	for (i--; i >= 0; i--) {
+		if (WARN_ON_ONCE(!pipapo_find_rules(&m->f[i], false,
+						    &rulemap[i + 1],
+						    &rulemap[i])))
+			return;
+	}
+
+	pipapo_drop(m, rulemap);
+	priv->dirty = true;
+
+	pipapo_commit(set);
+}
+
+static void pipapo_walk(const struct nft_ctx *ctx, struct nft_set *set,
+			const struct nft_pipapo_match *m,
+			struct nft_set_iter *iter)
+{
+	const struct nft_pipapo_field *f = &m->f[m->field_count - 1];
+	unsigned long r;
+
+	for (r = 0; r < f->rules; r++) {
+		struct nft_pipapo_elem *e;
+		struct nft_set_elem elem;
+
+		/* One element can take several rules in the last field */
+		if (r < f->rules - 1 && f->mt[r + 1].e == f->mt[r].e)
+			continue;
+
+		if (iter->count < iter->skip)
+			goto cont;
+
+		e = f->mt[r].e;
+		if (!nft_set_elem_active(&e->ext, iter->genmask))
+			goto cont;
+
+		elem.priv = e;
+
+		iter->err = iter->fn(ctx, set, iter, &elem);
+		if (iter->err < 0)
+			return;
+
+cont:
+		iter->count++;
+	}
+}
+
+/**
+ * nft_pipapo_walk() - Walk over elements
+ * @ctx:	nftables API context
+ * @set:	nftables API set representation
+ * @iter:	Iterator
+ *
+ * Dumps of the current generation walk over the matching data lookups use,
+ * under RCU. Anything else is done with the nftables mutex held, and has to
+ * see the working copy, including pending changes.
+ */
+static void nft_pipapo_walk(const struct nft_ctx *ctx, struct nft_set *set,
+			    struct nft_set_iter *iter)
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+
+	if (iter->genmask == nft_genmask_cur(ctx->net)) {
+		rcu_read_lock();
+		pipapo_walk(ctx, set, rcu_dereference(priv->match), iter);
+		rcu_read_unlock();
+	} else {
+		pipapo_walk(ctx, set, priv->clone, iter);
+	}
+}
+
+/**
+ * nft_pipapo_privsize() - Return the size of private data for the set
+ * @nla:	netlink attributes, ignored as size doesn't depend on them
+ * @desc:	Set description, ignored as size doesn't depend on it
+ *
+ * Return: size of private data for this set implementation, in bytes
+ */
+static u64 nft_pipapo_privsize(const struct nlattr * const nla[],
+			       const struct nft_set_desc *desc)
+{
+	return sizeof(struct nft_pipapo);
+}
+
+/**
+ * nft_pipapo_estimate() - Set size, space and lookup complexity
+ * @desc:	Set description, element count and field description used
+ * @features:	Flags: NFT_SET_INTERVAL needs to be there
+ * @est:	Storage for estimation data
+ *
+ * The worst case for a range of n bits is 2 * n - 2 rules, each taking a bit
+ * in each bucket of each group and a mapping table entry.
+ *
+ * Return: true if set description is compatible, false otherwise
+ */
+static bool nft_pipapo_estimate(const struct nft_set_desc *desc, u32 features,
+				struct nft_set_estimate *est)
+{
+	u64 entry_size = 0;
+	int i;
+
+	if (!(features & NFT_SET_INTERVAL) ||
+	    desc->field_count < NFT_PIPAPO_MIN_FIELDS ||
+	    desc->field_count > NFT_PIPAPO_MAX_FIELDS)
+		return false;
+
+	for (i = 0; i < desc->field_count; i++) {
+		unsigned int bits = desc->field_len[i] * BITS_PER_BYTE;
+		unsigned int groups = bits / NFT_PIPAPO_GROUP_BITS;
+
+		if (desc->field_len[i] > NFT_PIPAPO_MAX_BYTES)
+			return false;
+
+		entry_size += (bits * 2) *
+			      (groups * NFT_PIPAPO_BUCKETS / BITS_PER_BYTE +
+			       sizeof(union nft_pipapo_map_bucket));
+	}
+
+	est->size = sizeof(struct nft_pipapo) +
+		    2 * (sizeof(struct nft_pipapo_match) +
+			 desc->field_count * sizeof(struct nft_pipapo_field)) +
+		    desc->size * entry_size;
+	est->lookup = NFT_SET_CLASS_O_LOG_N;
+	est->space = NFT_SET_CLASS_O_N;
+
+	return true;
+}
+
+/**
+ * nft_pipapo_init() - Initialise data for a set instance
+ * @set:	nftables API set representation
+ * @desc:	Set description
+ * @nla:	netlink attributes
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+static int nft_pipapo_init(const struct nft_set *set,
+			   const struct nft_set_desc *desc,
+			   const struct nlattr * const nla[])
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_match *m;
+	struct nft_pipapo_field *f;
+	int err, i;
+
+	if (desc->field_count > NFT_PIPAPO_MAX_FIELDS)
+		return -EINVAL;
+
+	m = kmalloc(sizeof(*m) + desc->field_count * sizeof(*f), GFP_KERNEL);
+	if (!m)
+		return -ENOMEM;
+
+	m->field_count = desc->field_count;
+	m->bsize_max = 0;
+
+	m->scratch = alloc_percpu(unsigned long *);
+	if (!m->scratch) {
+		err = -ENOMEM;
+		goto out_scratch;
+	}
+
+	nft_pipapo_for_each_field(f, i, m) {
+		f->groups = desc->field_len[i] * NFT_PIPAPO_GROUPS_PER_BYTE;
+		f->bsize = 0;
+		f->rules = 0;
+		f->lt = NULL;
+		f->mt = NULL;
+	}
+
+	/* Create an initial clone of matching data for next insertion */
+	priv->clone = pipapo_clone(m);
+	if (IS_ERR(priv->clone)) {
+		err = PTR_ERR(priv->clone);
+		goto out_free;
+	}
+
+	priv->dirty = false;
+
+	rcu_assign_pointer(priv->match, m);
+
+	return 0;
+
+out_free:
+	free_percpu(m->scratch);
+out_scratch:
+	kfree(m);
+
+	return err;
+}
+
+/**
+ * nft_pipapo_destroy() - Free private data for set and all committed elements
+ * @set:	nftables API set representation
+ *
+ * The working copy holds all the elements, including the ones lookups don't
+ * see yet.
+ */
+static void nft_pipapo_destroy(const struct nft_set *set)
+{
+	struct nft_pipapo *priv = nft_set_priv(set);
+	struct nft_pipapo_match *m = priv->clone;
+	struct nft_pipapo_field *f;
+	unsigned long r;
+
+	rcu_barrier();
+
+	f = &m->f[m->field_count - 1];
+	for (r = 0; r < f->rules; r++) {
+		if (r < f->rules - 1 && f->mt[r + 1].e == f->mt[r].e)
+			continue;
+
+		nft_set_elem_destroy(set, f->mt[r].e, true);
+	}
+
+	pipapo_free_match(m);
+	priv->clone = NULL;
+
+	m = rcu_dereference_protected(priv->match, true);
+	pipapo_free_match(m);
+	RCU_INIT_POINTER(priv->match, NULL);
+}
+
+struct nft_set_type nft_set_pipapo_type __read_mostly = {
+	.owner		= THIS_MODULE,
+	.features	= NFT_SET_INTERVAL | NFT_SET_MAP | NFT_SET_OBJECT,
+	.ops		= {
+		.lookup		= nft_pipapo_lookup,
+		.insert		= nft_pipapo_insert,
+		.activate	= nft_pipapo_activate,
+		.deactivate	= nft_pipapo_deactivate,
+		.flush		= nft_pipapo_flush,
+		.remove		= nft_pipapo_remove,
+		.walk		= nft_pipapo_walk,
+		.get		= nft_pipapo_get,
+		.privsize	= nft_pipapo_privsize,
+		.estimate	= nft_pipapo_estimate,
+		.init		= nft_pipapo_init,
+		.destroy	= nft_pipapo_destroy,
+		.elemsize	= offsetof(struct nft_pipapo_elem, ext),
+	},
+};
@@ -2745,6 +2745,7 @@ static int tpacket_snd(struct packet_sock *po, struct msghdr *msg)
 
 		if (unlikely(tp_len < 0)) {
 tpacket_error:
+			po->tx_stats.tp_wrong_format++;
 			if (po->tp_loss) {
 				__packet_set_status(po, ph,
 						TP_STATUS_AVAILABLE);
@@ -2772,6 +2773,11 @@ static int tpacket_snd(struct packet_sock *po, struct msghdr *msg)
 
 		status = TP_STATUS_SEND_REQUEST;
 		err = po->xmit(skb);
+		/* NET_XMIT_CN: the frame went out, the qdisc is congested */
+		if (unlikely(err < 0 || net_xmit_errno(err)))
+			po->tx_stats.tp_drops++;
+		else
+			po->tx_stats.tp_packets++;
 		if (unlikely(err > 0)) {
 			err = net_xmit_errno(err);
 			if (err && __packet_get_status(po, ph) ==
@@ -3912,6 +3918,7 @@ static int packet_getsockopt(struct socket *sock, int level, int optname,
 	void *data = &val;
 	union tpacket_stats_u st;
 	struct tpacket_rollover_stats rstats;
+	struct tpacket_tx_stats tstats;
 
 	if (level != SOL_PACKET)
 		return -ENOPROTOOPT;
@@ -3998,6 +4005,14 @@ static int packet_getsockopt(struct socket *sock, int level, int optname,
 		data = &rstats;
 		lv = sizeof(rstats);
 		break;
+	case PACKET_TX_STATS:
+		mutex_lock(&po->pg_vec_lock);
+		tstats = po->tx_stats;
+		memset(&po->tx_stats, 0, sizeof(po->tx_stats));
+		mutex_unlock(&po->pg_vec_lock);
+		data = &tstats;
+		lv = sizeof(tstats);
+		break;
 	case PACKET_TX_HAS_OFF:
 		val = po->tp_tx_has_off;
 		break;
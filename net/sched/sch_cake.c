@@ -80,6 +80,12 @@
 #define CAKE_FLOW_MASK 63
 #define CAKE_FLOW_NAT_FLAG 64
 
+/* How far in the past the shared shaper clock may be when a packet is
+ * charged, to make up for late dequeues without allowing large bursts
+ * after idle periods.
+ */
+#define CAKE_SHARED_CATCHUP_NS (100 * NSEC_PER_USEC)
+
 /* struct cobalt_params - contains codel and blue parameters
  * @interval:	codel initial drop rate
  * @target:     maximum persistent sojourn time & blue update rate
@@ -197,6 +203,28 @@ struct cake_tin_data {
 	u32	way_collisions;
 }; /* number of tins is small, so size of this struct doesn't matter much */
 
+/* struct cake_shared_shaper - global shaper shared by instances on a device
+ * @list:		entry in cake_shared_list
+ * @dev:		device the sharing instances are attached to
+ * @refcnt:		number of instances using this shaper
+ * @time_next_packet:	shared clock, in ns, advanced locklessly
+ *
+ * Instances of cake on one device, typically one per TX queue below mq,
+ * can share the global shaper. Each keeps its own flow queueing and shaper,
+ * and all of them also charge packets to the shared clock, so that the
+ * configured rate applies to the device as a whole while dequeues from
+ * different queues only contend on one atomic variable.
+ */
+struct cake_shared_shaper {
+	struct list_head	list;
+	const struct net_device	*dev;
+	refcount_t		refcnt;
+	atomic64_t		time_next_packet;
+};
+
+static LIST_HEAD(cake_shared_list);
+static DEFINE_SPINLOCK(cake_shared_lock);
+
 struct cake_sched_data {
 	struct tcf_proto __rcu *filter_list; /* optional external classifier */
 	struct tcf_block *block;
@@ -215,6 +243,7 @@ struct cake_sched_data {
 	u16		rate_shft;
 	ktime_t		time_next_packet;
 	ktime_t		failsafe_next_packet;
+	struct cake_shared_shaper *shared;
 	u64		rate_ns;
 	u64		rate_bps;
 	u16		rate_flags;
@@ -1418,6 +1447,57 @@ static void cake_heapify_up(struct cake_sched_data *q, u16 i)
 	}
 }
 
+static struct cake_shared_shaper *cake_shared_get(const struct net_device *dev)
+{
+	struct cake_shared_shaper *s, *new;
+
+	new = kzalloc(sizeof(*new), GFP_KERNEL);
+	if (!new)
+		return NULL;
+
+	spin_lock(&cake_shared_lock);
+	list_for_each_entry(s, &cake_shared_list, list) {
+		if (s->dev == dev) {
+			refcount_inc(&s->refcnt);
+			spin_unlock(&cake_shared_lock);
+			kfree(new);
+			return s;
+		}
+	}
+
+	new->dev = dev;
+	refcount_set(&new->refcnt, 1);
+	atomic64_set(&new->time_next_packet, ktime_get_ns());
+	list_add(&new->list, &cake_shared_list);
+	spin_unlock(&cake_shared_lock);
+
+	return new;
+}
+
+static void cake_shared_put(struct cake_shared_shaper *s)
+{
+	spin_lock(&cake_shared_lock);
+	if (refcount_dec_and_test(&s->refcnt)) {
+		list_del(&s->list);
+		kfree(s);
+	}
+	spin_unlock(&cake_shared_lock);
+}
+
+static void cake_shared_charge(struct cake_shared_shaper *s, ktime_t now,
+			       u64 dur)
+{
+	s64 floor = ktime_to_ns(now) - CAKE_SHARED_CATCHUP_NS;
+	s64 cur, old;
+
+	cur = atomic64_read(&s->time_next_packet);
+	do {
+		old = cur;
+		cur = atomic64_cmpxchg(&s->time_next_packet, old,
+				       max(old, floor) + dur);
+	} while (cur != old);
+}
+
 static int cake_advance_shaper(struct cake_sched_data *q,
 			       struct cake_tin_data *b,
 			       struct sk_buff *skb,
@@ -1443,6 +1523,8 @@ static int cake_advance_shaper(struct cake_sched_data *q,
 
 		q->time_next_packet = ktime_add_ns(q->time_next_packet,
 						   global_dur);
+		if (q->shared)
+			cake_shared_charge(q->shared, now, global_dur);
 		if (!drop)
 			q->failsafe_next_packet = \
 				ktime_add_ns(q->failsafe_next_packet,
@@ -1888,6 +1970,17 @@ static struct sk_buff *cake_dequeue(struct Qdisc *sch)
 		return NULL;
 	}
 
+	/* shaper shared with the other instances on this device */
+	if (q->shared && q->rate_ns) {
+		s64 next = atomic64_read(&q->shared->time_next_packet);
+
+		if (next > ktime_to_ns(now)) {
+			sch->qstats.overlimits++;
+			qdisc_watchdog_schedule_ns(&q->watchdog, next);
+			return NULL;
+		}
+	}
+
 	/* Choose a class to work on. */
 	if (!q->rate_ns) {
 		/* In unlimited mode, can't rely on shaper timings, just balance
@@ -2143,6 +2236,7 @@ static const struct nla_policy cake_policy[TCA_CAKE_MAX + 1] = {
 	[TCA_CAKE_MPU]		 = { .type = NLA_U32 },
 	[TCA_CAKE_INGRESS]	 = { .type = NLA_U32 },
 	[TCA_CAKE_ACK_FILTER]	 = { .type = NLA_U32 },
+	[TCA_CAKE_SHARED]	 = { .type = NLA_U32 },
 };
 
 static void cake_set_rate(struct cake_tin_data *b, u64 rate, u32 mtu,
@@ -2479,6 +2573,34 @@ static void cake_reconfigure(struct Qdisc *sch)
 				  q->buffer_config_limit));
 }
 
+static int cake_set_shared(struct Qdisc *sch, bool enable)
+{
+	struct cake_sched_data *q = qdisc_priv(sch);
+	struct cake_shared_shaper *s = NULL, *old;
+
+	if (enable == !!q->shared)
+		return 0;
+
+	if (enable) {
+		s = cake_shared_get(qdisc_dev(sch));
+		if (!s)
+			return -ENOMEM;
+	}
+
+	/* dequeue runs under the qdisc lock, and the last reference to the
+	 * old shaper may be gone once it is released
+	 */
+	sch_tree_lock(sch);
+	old = q->shared;
+	q->shared = s;
+	sch_tree_unlock(sch);
+
+	if (old)
+		cake_shared_put(old);
+
+	return 0;
+}
+
 static int cake_change(struct Qdisc *sch, struct nlattr *opt,
 		       struct netlink_ext_ack *extack)
 {
@@ -2493,6 +2615,12 @@ static int cake_change(struct Qdisc *sch, struct nlattr *opt,
 	if (err < 0)
 		return err;
 
+	if (tb[TCA_CAKE_SHARED]) {
+		err = cake_set_shared(sch, !!nla_get_u32(tb[TCA_CAKE_SHARED]));
+		if (err)
+			return err;
+	}
+
 	if (tb[TCA_CAKE_NAT]) {
 #if IS_ENABLED(CONFIG_NF_CONNTRACK)
 		q->flow_mode &= ~CAKE_FLOW_NAT_FLAG;
@@ -2605,6 +2733,11 @@ static void cake_destroy(struct Qdisc *sch)
 	qdisc_watchdog_cancel(&q->watchdog);
 	tcf_block_put(q->block);
 	kvfree(q->tins);
+
+	if (q->shared) {
+		cake_shared_put(q->shared);
+		q->shared = NULL;
+	}
 }
 
 static int cake_init(struct Qdisc *sch, struct nlattr *opt,
@@ -2748,6 +2881,9 @@ static int cake_dump(struct Qdisc *sch, struct sk_buff *skb)
 			!!(q->rate_flags & CAKE_FLAG_SPLIT_GSO)))
 		goto nla_put_failure;
 
+	if (nla_put_u32(skb, TCA_CAKE_SHARED, !!q->shared))
+		goto nla_put_failure;
+
 	return nla_nest_end(skb, opts);
 
 nla_put_failure:
@@ -193,15 +193,12 @@ int tls_proccess_cmsg(struct sock *sk, struct msghdr *msg,
 	return rc;
 }
 
-int tls_push_pending_closed_record(struct sock *sk, struct tls_context *ctx,
-				   int flags, long *timeo)
+int tls_push_partial_record(struct sock *sk, struct tls_context *ctx,
+			    int flags)
 {
 	struct scatterlist *sg;
 	u16 offset;
 
-	if (!tls_is_partially_sent_record(ctx))
-		return ctx->push_pending_record(sk, flags);
-
 	sg = ctx->partially_sent_record;
 	offset = ctx->partially_sent_offset;
 
@@ -209,6 +206,15 @@ int tls_push_pending_closed_record(struct sock *sk, struct tls_context *ctx,
 	return tls_push_sg(sk, ctx, sg, offset, flags);
 }
 
+int tls_push_pending_closed_record(struct sock *sk, struct tls_context *ctx,
+				   int flags, long *timeo)
+{
+	if (!tls_is_partially_sent_record(ctx))
+		return ctx->push_pending_record(sk, flags);
+
+	return tls_push_partial_record(sk, ctx, flags);
+}
+
 static void tls_write_space(struct sock *sk)
 {
 	struct tls_context *ctx = tls_get_ctx(sk);
@@ -222,7 +228,10 @@ static void tls_write_space(struct sock *sk)
 		return;
 	}
 
-	if (!sk->sk_write_pending && tls_is_pending_closed_record(ctx)) {
+	if (ctx->tx_conf == TLS_SW) {
+		tls_sw_write_space(sk, ctx);
+	} else if (!sk->sk_write_pending &&
+		   tls_is_pending_closed_record(ctx)) {
 		gfp_t sk_allocation = sk->sk_allocation;
 		int rc;
 		long timeo = 0;
@@ -270,7 +279,8 @@ static void tls_sk_proto_close(struct sock *sk, long timeout)
 	if (!tls_complete_pending_work(sk, ctx, 0, &timeo))
 		tls_handle_open_record(sk, 0);
 
-	if (ctx->partially_sent_record) {
+	/* The software path releases its own queued records */
+	if (ctx->tx_conf != TLS_SW && ctx->partially_sent_record) {
 		struct scatterlist *sg = ctx->partially_sent_record;
 
 		while (1) {
@@ -385,6 +395,35 @@ static int do_tls_getsockopt_tx(struct sock *sk, char __user *optval,
 	return rc;
 }
 
+static int do_tls_getsockopt_tx_stats(struct sock *sk, char __user *optval,
+				      int __user *optlen)
+{
+	struct tls_context *ctx = tls_get_ctx(sk);
+	struct tls_tx_stats stats;
+	int len;
+
+	if (get_user(len, optlen))
+		return -EFAULT;
+
+	if (!optval || len < sizeof(stats))
+		return -EINVAL;
+
+	lock_sock(sk);
+	if (ctx->tx_conf != TLS_SW) {
+		release_sock(sk);
+		return -EINVAL;
+	}
+	stats = tls_sw_ctx_tx(ctx)->stats;
+	release_sock(sk);
+
+	if (put_user(sizeof(stats), optlen))
+		return -EFAULT;
+	if (copy_to_user(optval, &stats, sizeof(stats)))
+		return -EFAULT;
+
+	return 0;
+}
+
 static int do_tls_getsockopt(struct sock *sk, int optname,
 			     char __user *optval, int __user *optlen)
 {
@@ -394,6 +433,9 @@ static int do_tls_getsockopt(struct sock *sk, int optname,
 	case TLS_TX:
 		rc = do_tls_getsockopt_tx(sk, optval, optlen);
 		break;
+	case TLS_TX_STATS:
+		rc = do_tls_getsockopt_tx_stats(sk, optval, optlen);
+		break;
 	default:
 		rc = -ENOPROTOOPT;
 		break;
@@ -493,6 +493,8 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge(&sk->sk_receive_queue);
+	/* MSG_ZEROCOPY completions nobody read */
+	skb_queue_purge(&sk->sk_error_queue);
 
 	WARN_ON(refcount_read(&sk->sk_wmem_alloc));
 	WARN_ON(!sk_unhashed(sk));
@@ -1853,6 +1855,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 {
 	struct sock *sk = sock->sk;
 	struct sock *other = NULL;
+	struct ubuf_info *uarg = NULL;
 	int err, size;
 	struct sk_buff *skb;
 	int sent = 0;
@@ -1882,22 +1885,39 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (sk->sk_shutdown & SEND_SHUTDOWN)
 		goto pipe_err;
 
+	if ((msg->msg_flags & MSG_ZEROCOPY) && sock_flag(sk, SOCK_ZEROCOPY) &&
+	    len) {
+		uarg = sock_zerocopy_alloc(sk, len);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	while (sent < len) {
 		size = len - sent;
 
 		/* Keep two messages in the pipe so it schedules better */
 		size = min_t(int, size, (sk->sk_sndbuf >> 1) - 64);
 
-		/* allow fallback to order-0 allocations */
-		size = min_t(int, size, SKB_MAX_HEAD(0) + UNIX_SKB_FRAGS_SZ);
+		if (uarg) {
+			/* The sender's pages become the frags */
+			data_len = 0;
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+					msg->msg_flags & MSG_DONTWAIT, &err, 0);
+		} else {
+			/* allow fallback to order-0 allocations */
+			size = min_t(int, size,
+				     SKB_MAX_HEAD(0) + UNIX_SKB_FRAGS_SZ);
 
-		data_len = max_t(int, 0, size - SKB_MAX_HEAD(0));
+			data_len = max_t(int, 0, size - SKB_MAX_HEAD(0));
 
-		data_len = min_t(size_t, size, PAGE_ALIGN(data_len));
+			data_len = min_t(size_t, size, PAGE_ALIGN(data_len));
 
-		skb = sock_alloc_send_pskb(sk, size - data_len, data_len,
-					   msg->msg_flags & MSG_DONTWAIT, &err,
-					   get_order(UNIX_SKB_FRAGS_SZ));
+			skb = sock_alloc_send_pskb(sk, size - data_len,
+					data_len, msg->msg_flags & MSG_DONTWAIT,
+					&err, get_order(UNIX_SKB_FRAGS_SZ));
+		}
 		if (!skb)
 			goto out_err;
 
@@ -1909,13 +1929,29 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		}
 		fds_sent = true;
 
-		skb_put(skb, size - data_len);
-		skb->data_len = data_len;
-		skb->len = size;
-		err = skb_copy_datagram_from_iter(skb, 0, &msg->msg_iter, size);
-		if (err) {
-			kfree_skb(skb);
-			goto out_err;
+		if (uarg) {
+			err = __zerocopy_sg_from_iter(NULL, skb, &msg->msg_iter,
+						      size);
+			/* out of frags, the rest goes in the next skb */
+			if (err == -EMSGSIZE && skb->len)
+				err = 0;
+			if (err) {
+				kfree_skb(skb);
+				goto out_err;
+			}
+			size = skb->len;
+			skb_zcopy_set(skb, uarg);
+		} else {
+			skb_put(skb, size - data_len);
+			skb->data_len = data_len;
+			skb->len = size;
+			err = skb_copy_datagram_from_iter(skb, 0,
+							  &msg->msg_iter,
+							  size);
+			if (err) {
+				kfree_skb(skb);
+				goto out_err;
+			}
 		}
 
 		unix_state_lock(other);
@@ -1931,6 +1967,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		sent += size;
 	}
 
+	sock_zerocopy_put(uarg);
 	scm_destroy(&scm);
 
 	return sent;
@@ -1943,6 +1980,10 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		send_sig(SIGPIPE, current, 0);
 	err = -EPIPE;
 out_err:
+	if (sent)
+		sock_zerocopy_put(uarg);
+	else
+		sock_zerocopy_put_abort(uarg);
 	scm_destroy(&scm);
 	return sent ? : err;
 }
@@ -2484,6 +2525,11 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 		.flags = flags
 	};
 
+	/* MSG_ZEROCOPY completions */
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sock->sk, msg, size, SOL_SOCKET,
+					  SO_ZEROCOPY);
+
 	return unix_stream_read_generic(&state, true);
 }
 
@@ -2491,6 +2537,15 @@ static int unix_stream_splice_actor(struct sk_buff *skb,
 				    int skip, int chunk,
 				    struct unix_stream_read_state *state)
 {
+	int err;
+
+	/* The sender gets its zerocopy pages back once the skb is
+	 * consumed, so the pipe has to take copies instead.
+	 */
+	err = skb_orphan_frags_rx(skb, GFP_KERNEL);
+	if (err)
+		return err;
+
 	return skb_splice_bits(skb, state->socket->sk,
 			       UNIXCB(skb).consumed + skip,
 			       state->pipe, chunk, state->splice_flags);
@@ -2674,7 +2729,7 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 	mask = 0;
 
 	/* exceptional events? */
-	if (sk->sk_err)
+	if (sk->sk_err || !skb_queue_empty_lockless(&sk->sk_error_queue))
 		mask |= EPOLLERR;
 	if (sk->sk_shutdown == SHUTDOWN_MASK)
 		mask |= EPOLLHUP;
@@ -22,6 +22,8 @@
 #include <linux/init.h>
 #include <linux/skbuff.h>
 #include <linux/percpu.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
 #include <linux/list.h>
 #include <net/sock.h>
 #include <linux/un.h>
@@ -34,9 +36,10 @@
 #include "avc_ss.h"
 #include "classmap.h"
 
-#define AVC_CACHE_SLOTS			512
-#define AVC_DEF_CACHE_THRESHOLD		512
+#define AVC_DEF_CACHE_SLOTS		512
+#define AVC_MAX_CACHE_SLOTS		65536
 #define AVC_CACHE_RECLAIM		16
+#define AVC_FRONT_SLOTS			64
 
 #ifdef CONFIG_SECURITY_SELINUX_AVC_STATS
 #define avc_cache_stats_incr(field)	this_cpu_inc(avc_cache_stats.field)
@@ -69,13 +72,35 @@ struct avc_xperms_node {
 };
 
 struct avc_cache {
-	struct hlist_head	slots[AVC_CACHE_SLOTS]; /* head for avc_node->list */
-	spinlock_t		slots_lock[AVC_CACHE_SLOTS]; /* lock for writes */
+	struct hlist_head	*slots; /* head for avc_node->list */
+	spinlock_t		*slots_lock; /* lock for writes */
 	atomic_t		lru_hint;	/* LRU hint for reclaim scan */
 	atomic_t		active_nodes;
+	atomic_t		front_gen;	/* see avc_front_invalidate() */
 	u32			latest_notif;	/* latest revocation notification */
 };
 
+/*
+ * Per-cpu front cache of recently used decisions.  It is only used from
+ * task context, so disabling preemption is all it takes to keep an entry
+ * consistent.  Entries are tagged with avc_cache.front_gen and only
+ * trusted while it is unchanged.  An empty entry has tclass 0, which no
+ * class uses.
+ */
+struct avc_front_entry {
+	u32			ssid;
+	u32			tsid;
+	u16			tclass;
+	int			gen;
+	struct av_decision	avd;
+};
+
+struct avc_front_cache {
+	struct avc_front_entry	entries[AVC_FRONT_SLOTS];
+};
+
+static DEFINE_PER_CPU(struct avc_front_cache, avc_front_cache);
+
 struct avc_callback_node {
 	int (*callback) (u32 event);
 	u32 events;
@@ -93,17 +118,42 @@ struct selinux_avc {
 
 static struct selinux_avc selinux_avc;
 
+static unsigned int avc_cache_slots __ro_after_init = AVC_DEF_CACHE_SLOTS;
+
+static int __init avc_cache_slots_setup(char *str)
+{
+	unsigned long slots;
+
+	if (!kstrtoul(str, 0, &slots))
+		avc_cache_slots = roundup_pow_of_two(clamp_t(unsigned long,
+				slots, AVC_CACHE_RECLAIM, AVC_MAX_CACHE_SLOTS));
+	return 1;
+}
+__setup("selinux_avc_slots=", avc_cache_slots_setup);
+
 void selinux_avc_init(struct selinux_avc **avc)
 {
 	int i;
 
-	selinux_avc.avc_cache_threshold = AVC_DEF_CACHE_THRESHOLD;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	selinux_avc.avc_cache.slots = kvcalloc(avc_cache_slots,
+					       sizeof(struct hlist_head),
+					       GFP_KERNEL);
+	selinux_avc.avc_cache.slots_lock = kvcalloc(avc_cache_slots,
+						    sizeof(spinlock_t),
+						    GFP_KERNEL);
+	if (!selinux_avc.avc_cache.slots || !selinux_avc.avc_cache.slots_lock)
+		panic("SELinux: cannot allocate %u AVC slots\n",
+		      avc_cache_slots);
+
+	/* Bigger tables get a proportionally bigger default working set */
+	selinux_avc.avc_cache_threshold = avc_cache_slots;
+	for (i = 0; i < avc_cache_slots; i++) {
 		INIT_HLIST_HEAD(&selinux_avc.avc_cache.slots[i]);
 		spin_lock_init(&selinux_avc.avc_cache.slots_lock[i]);
 	}
 	atomic_set(&selinux_avc.avc_cache.active_nodes, 0);
 	atomic_set(&selinux_avc.avc_cache.lru_hint, 0);
+	atomic_set(&selinux_avc.avc_cache.front_gen, 0);
 	*avc = &selinux_avc;
 }
 
@@ -126,7 +176,12 @@ static struct kmem_cache *avc_xperms_cachep;
 
 static inline int avc_hash(u32 ssid, u32 tsid, u16 tclass)
 {
-	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_CACHE_SLOTS - 1);
+	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (avc_cache_slots - 1);
+}
+
+static inline int avc_front_hash(u32 ssid, u32 tsid, u16 tclass)
+{
+	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_FRONT_SLOTS - 1);
 }
 
 /**
@@ -229,7 +284,7 @@ int avc_get_hash_stats(struct selinux_avc *avc, char *page)
 
 	slots_used = 0;
 	max_chain_len = 0;
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < avc_cache_slots; i++) {
 		head = &avc->avc_cache.slots[i];
 		if (!hlist_empty(head)) {
 			slots_used++;
@@ -246,7 +301,7 @@ int avc_get_hash_stats(struct selinux_avc *avc, char *page)
 	return scnprintf(page, PAGE_SIZE, "entries: %d\nbuckets used: %d/%d\n"
 			 "longest chain: %d\n",
 			 atomic_read(&avc->avc_cache.active_nodes),
-			 slots_used, AVC_CACHE_SLOTS, max_chain_len);
+			 slots_used, avc_cache_slots, max_chain_len);
 }
 
 /*
@@ -522,12 +577,25 @@ static void avc_node_kill(struct selinux_avc *avc, struct avc_node *node)
 	atomic_dec(&avc->avc_cache.active_nodes);
 }
 
+/*
+ * Called after a decision that may sit in a front cache was replaced or
+ * removed.  A reader that samples front_gen after this cannot have seen
+ * the old decision, see avc_has_perm_noaudit().
+ */
+static void avc_front_invalidate(struct selinux_avc *avc)
+{
+	/* order the node update before the new generation */
+	smp_mb__before_atomic();
+	atomic_inc(&avc->avc_cache.front_gen);
+}
+
 static void avc_node_replace(struct selinux_avc *avc,
 			     struct avc_node *new, struct avc_node *old)
 {
 	hlist_replace_rcu(&old->list, &new->list);
 	call_rcu(&old->rhead, avc_node_free);
 	atomic_dec(&avc->avc_cache.active_nodes);
+	avc_front_invalidate(avc);
 }
 
 static inline int avc_reclaim_node(struct selinux_avc *avc)
@@ -538,9 +606,9 @@ static inline int avc_reclaim_node(struct selinux_avc *avc)
 	struct hlist_head *head;
 	spinlock_t *lock;
 
-	for (try = 0, ecx = 0; try < AVC_CACHE_SLOTS; try++) {
+	for (try = 0, ecx = 0; try < avc_cache_slots; try++) {
 		hvalue = atomic_inc_return(&avc->avc_cache.lru_hint) &
-			(AVC_CACHE_SLOTS - 1);
+			(avc_cache_slots - 1);
 		head = &avc->avc_cache.slots[hvalue];
 		lock = &avc->avc_cache.slots_lock[hvalue];
 
@@ -640,6 +708,49 @@ static struct avc_node *avc_lookup(struct selinux_avc *avc,
 	return NULL;
 }
 
+static bool avc_front_lookup(struct selinux_avc *avc, u32 ssid, u32 tsid,
+			     u16 tclass, struct av_decision *avd)
+{
+	struct avc_front_entry *e;
+	bool hit;
+
+	if (!in_task())
+		return false;
+
+	e = &get_cpu_var(avc_front_cache).entries[avc_front_hash(ssid, tsid,
+								 tclass)];
+	hit = e->ssid == ssid && e->tsid == tsid && e->tclass == tclass &&
+	      e->gen == atomic_read(&avc->avc_cache.front_gen);
+	if (hit)
+		memcpy(avd, &e->avd, sizeof(*avd));
+	put_cpu_var(avc_front_cache);
+
+	if (hit) {
+		avc_cache_stats_incr(lookups);
+		avc_cache_stats_incr(front_hits);
+	}
+	return hit;
+}
+
+/* @gen must have been sampled before the lookup that produced @avd */
+static void avc_front_fill(int gen, u32 ssid, u32 tsid, u16 tclass,
+			   const struct av_decision *avd)
+{
+	struct avc_front_entry *e;
+
+	if (!in_task())
+		return;
+
+	e = &get_cpu_var(avc_front_cache).entries[avc_front_hash(ssid, tsid,
+								 tclass)];
+	e->ssid = ssid;
+	e->tsid = tsid;
+	e->tclass = tclass;
+	e->gen = gen;
+	memcpy(&e->avd, avd, sizeof(*avd));
+	put_cpu_var(avc_front_cache);
+}
+
 static int avc_latest_notif_update(struct selinux_avc *avc,
 				   int seqno, int is_insert)
 {
@@ -945,7 +1056,7 @@ static void avc_flush(struct selinux_avc *avc)
 	unsigned long flag;
 	int i;
 
-	for (i = 0; i < AVC_CACHE_SLOTS; i++) {
+	for (i = 0; i < avc_cache_slots; i++) {
 		head = &avc->avc_cache.slots[i];
 		lock = &avc->avc_cache.slots_lock[i];
 
@@ -960,6 +1071,7 @@ static void avc_flush(struct selinux_avc *avc)
 		rcu_read_unlock();
 		spin_unlock_irqrestore(lock, flag);
 	}
+	avc_front_invalidate(avc);
 }
 
 /**
@@ -1138,19 +1250,29 @@ inline int avc_has_perm_noaudit(struct selinux_state *state,
 {
 	struct avc_node *node;
 	struct avc_xperms_node xp_node;
-	int rc = 0;
+	int rc = 0, gen;
 	u32 denied;
 
 	BUG_ON(!requested);
 
 	rcu_read_lock();
 
+	if (avc_front_lookup(state->avc, ssid, tsid, tclass, avd))
+		goto check;
+
+	gen = atomic_read(&state->avc->avc_cache.front_gen);
+	/* sample gen before the node, pairs with avc_front_invalidate() */
+	smp_rmb();
+
 	node = avc_lookup(state->avc, ssid, tsid, tclass);
-	if (unlikely(!node))
+	if (unlikely(!node)) {
 		node = avc_compute_av(state, ssid, tsid, tclass, avd, &xp_node);
-	else
+	} else {
 		memcpy(avd, &node->ae.avd, sizeof(*avd));
+		avc_front_fill(gen, ssid, tsid, tclass, avd);
+	}
 
+check:
 	denied = requested & ~(avd->allowed);
 	if (unlikely(denied))
 		rc = avc_denied(state, ssid, tsid, tclass, requested, 0, 0,
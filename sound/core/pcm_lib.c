@@ -259,6 +259,51 @@ static void update_audio_tstamp(struct snd_pcm_substream *substream,
 	runtime->driver_tstamp = driver_tstamp;
 }
 
+/*
+ * Playback drivers setting runtime->hw_ptr_interpolate report a position
+ * that only moves in coarse steps, typically once per period, and have
+ * already fetched the data up to the next step. Between steps advance the
+ * position at the nominal rate from the time of the last step, up to just
+ * short of one period, and hold it rather than step back when the device
+ * runs slower than the estimate.
+ */
+static snd_pcm_uframes_t snd_pcm_interpolate_pos(struct snd_pcm_substream *substream,
+						 snd_pcm_uframes_t pos)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_uframes_t est, ahead;
+	ktime_t now;
+	u64 frames;
+
+	if (runtime->status->state != SNDRV_PCM_STATE_RUNNING) {
+		runtime->interp_tstamp = 0;
+		return pos;
+	}
+
+	now = ktime_get();
+	if (!runtime->interp_tstamp) {
+		runtime->interp_pos = pos;
+		runtime->interp_reported = pos;
+		runtime->interp_tstamp = now;
+	} else if (pos != runtime->interp_pos) {
+		runtime->interp_pos = pos;
+		runtime->interp_tstamp = now;
+	}
+
+	frames = div_u64(ktime_to_ns(ktime_sub(now, runtime->interp_tstamp)) *
+			 runtime->rate, NSEC_PER_SEC);
+	frames = min_t(u64, frames, runtime->period_size - 1);
+	est = (pos + frames) % runtime->buffer_size;
+
+	ahead = (est + runtime->buffer_size - runtime->interp_reported) %
+		runtime->buffer_size;
+	if (ahead > runtime->buffer_size / 2)
+		est = runtime->interp_reported;
+	runtime->interp_reported = est;
+
+	return est;
+}
+
 static int snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
 				  unsigned int in_interrupt)
 {
@@ -312,6 +357,9 @@ static int snd_pcm_update_hw_ptr0(struct snd_pcm_substream *substream,
 		}
 		pos = 0;
 	}
+	if (runtime->hw_ptr_interpolate &&
+	    substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
+		pos = snd_pcm_interpolate_pos(substream, pos);
 	pos -= pos % runtime->min_align;
 	trace_hwptr(substream, pos, in_interrupt);
 	hw_base = runtime->hw_ptr_base;
@@ -1228,6 +1228,7 @@ static void snd_pcm_post_start(struct snd_pcm_substream *substream, int state)
 	runtime->hw_ptr_jiffies = jiffies;
 	runtime->hw_ptr_buffer_jiffies = (runtime->buffer_size * HZ) / 
 							    runtime->rate;
+	runtime->interp_tstamp = 0;
 	runtime->status->state = state;
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK &&
 	    runtime->silence_size > 0)
@@ -269,12 +269,18 @@ static int bcm2835_i2s_set_dai_tdm_slot(struct snd_soc_dai *dai,
 		tx_mask &= GENMASK(slots - 1, 0);
 
 		/*
-		 * The driver is limited to 2-channel setups.
+		 * The PCM block only has two channel position registers
+		 * per direction (CH1 and CH2), so at most 2 slots of a
+		 * TDM frame can be transferred whatever the frame length.
 		 * Check that exactly 2 bits are set in the masks.
 		 */
 		if (hweight_long((unsigned long) rx_mask) != 2
-		    || hweight_long((unsigned long) tx_mask) != 2)
+		    || hweight_long((unsigned long) tx_mask) != 2) {
+			dev_err(dev->dev,
+				"only 2 of %d TDM slots can be used (rx 0x%x tx 0x%x)\n",
+				slots, rx_mask, tx_mask);
 			return -EINVAL;
+		}
 
 		if (slots * width > BCM2835_I2S_MAX_FRAME_LENGTH)
 			return -EINVAL;
@@ -268,6 +268,18 @@ static void print_prog_json(struct bpf_prog_info *info, int fd)
 		jsonw_bool_field(json_wtr, "jited", false);
 	}
 
+	if (info->verified_insns) {
+		jsonw_uint_field(json_wtr, "verified_insns",
+				 info->verified_insns);
+		jsonw_uint_field(json_wtr, "verified_states",
+				 info->verified_states);
+		jsonw_uint_field(json_wtr, "peak_states", info->peak_states);
+		jsonw_uint_field(json_wtr, "pruned_states",
+				 info->pruned_states);
+		jsonw_uint_field(json_wtr, "verification_time_ns",
+				 info->verification_time);
+	}
+
 	memlock = get_fdinfo(fd, "memlock");
 	if (memlock)
 		jsonw_int_field(json_wtr, "bytes_memlock", atoi(memlock));
@@ -334,6 +346,12 @@ static void print_prog_plain(struct bpf_prog_info *info, int fd)
 	if (info->nr_map_ids)
 		show_prog_maps(fd, info->nr_map_ids);
 
+	if (info->verified_insns)
+		printf("\n\tverified %u insns  states %u peak %u pruned %u  %lluns",
+		       info->verified_insns, info->verified_states,
+		       info->peak_states, info->pruned_states,
+		       info->verification_time);
+
 	if (!hash_empty(prog_table.table)) {
 		struct pinned_obj *obj;
 
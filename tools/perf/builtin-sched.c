@@ -217,6 +217,7 @@ struct perf_sched {
 	struct list_head sort_list, cmp_pid;
 	bool force;
 	bool skip_merge;
+	unsigned int nr_threads;
 	struct perf_sched_map map;
 
 	/* options for timehist command */
@@ -1796,6 +1797,8 @@ static int perf_sched__read_events(struct perf_sched *sched)
 		return -1;
 	}
 
+	session->nr_threads = sched->nr_threads;
+
 	symbol__init(&session->header.env);
 
 	if (perf_session__set_tracepoints_handlers(session, handlers))
@@ -2988,6 +2991,7 @@ static int perf_sched__timehist(struct perf_sched *sched)
 	if (session == NULL)
 		return -ENOMEM;
 
+	session->nr_threads = sched->nr_threads;
 	evlist = session->evlist;
 
 	symbol__init(&session->header.env);
@@ -3367,6 +3371,8 @@ int cmd_sched(int argc, const char **argv)
 	OPT_BOOLEAN('D', "dump-raw-trace", &dump_trace,
 		    "dump raw trace in ASCII"),
 	OPT_BOOLEAN('f', "force", &sched.force, "don't complain, do it"),
+	OPT_UINTEGER(0, "threads", &sched.nr_threads,
+		     "number of threads used to sort and decode events"),
 	OPT_END()
 	};
 	const struct option latency_options[] = {
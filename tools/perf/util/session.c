@@ -9,6 +9,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <pthread.h>
 
 #include "evlist.h"
 #include "evsel.h"
@@ -30,6 +31,11 @@ static int perf_session__deliver_event(struct perf_session *session,
 				       union perf_event *event,
 				       struct perf_tool *tool,
 				       u64 file_offset);
+static int __perf_session__deliver_event(struct perf_session *session,
+					 union perf_event *event,
+					 struct perf_sample *sample,
+					 struct perf_tool *tool,
+					 u64 file_offset);
 
 static int perf_session__open(struct perf_session *session)
 {
@@ -820,6 +826,438 @@ static perf_event__swap_op perf_event__swap_ops[] = {
 	[PERF_RECORD_HEADER_MAX]	  = NULL,
 };
 
+/*
+ * Parallel ordered delivery.
+ *
+ * When the whole data section sits in a single mapping, queued events can
+ * be referenced in place, and the costly parts of putting them in time
+ * order can be shared between threads:
+ *
+ *  - the events read since the last flush are cut into one contiguous
+ *    stream per thread. perf record writes the mmap ring buffers one CPU
+ *    at a time, so these streams are runs of per-CPU data, and each thread
+ *    sorts its own;
+ *
+ *  - the main thread merges the sorted streams with whatever was left
+ *    above the previous flush limit. Ties are broken on the file offset,
+ *    which keeps file order just like ordered_events does;
+ *
+ *  - the part of the merged queue below the flush limit is decoded by the
+ *    threads in chunks, and the main thread delivers each chunk in order.
+ *
+ * Delivery itself stays single threaded and in global time order, so the
+ * tools and the machine/thread state see exactly the sequence they would
+ * see with ordered_events.
+ */
+#define PARALLEL_EVENTS_MAX_THREADS	64
+#define PARALLEL_EVENTS_CHUNK		16384
+#define PARALLEL_EVENTS_MIN_STREAM	4096
+
+struct parallel_event {
+	u64			timestamp;
+	u64			file_offset;
+	union perf_event	*event;
+};
+
+struct parallel_events {
+	struct parallel_event	*queue;		/* read since the last flush */
+	size_t			nr_queue;
+	size_t			alloc_queue;
+	struct parallel_event	*pending;	/* sorted, above the last limit */
+	size_t			nr_pending;
+	size_t			alloc_pending;
+	struct parallel_event	*merged;
+	size_t			alloc_merged;
+	struct perf_sample	*samples;
+	int			*errs;
+	u64			last_flush;
+	u64			next_flush;
+	u64			max_timestamp;
+};
+
+struct parallel_work {
+	pthread_t		thread;
+	bool			started;
+	struct perf_evlist	*evlist;
+	struct parallel_event	*events;
+	struct perf_sample	*samples;
+	int			*errs;
+	size_t			nr;
+	void			(*fn)(struct parallel_work *work);
+};
+
+struct parallel_stream {
+	struct parallel_event	*cur;
+	struct parallel_event	*end;
+};
+
+static int parallel_event__cmp(const void *a, const void *b)
+{
+	const struct parallel_event *ea = a, *eb = b;
+
+	if (ea->timestamp != eb->timestamp)
+		return ea->timestamp < eb->timestamp ? -1 : 1;
+	if (ea->file_offset != eb->file_offset)
+		return ea->file_offset < eb->file_offset ? -1 : 1;
+	return 0;
+}
+
+static int parallel_events__grow(struct parallel_event **array,
+				 size_t *alloc, size_t nr)
+{
+	struct parallel_event *new;
+	size_t size = *alloc ?: PARALLEL_EVENTS_CHUNK;
+
+	if (nr <= *alloc)
+		return 0;
+
+	while (size < nr)
+		size *= 2;
+
+	new = realloc(*array, size * sizeof(*new));
+	if (!new)
+		return -ENOMEM;
+
+	*array = new;
+	*alloc = size;
+	return 0;
+}
+
+static void perf_session__parallel_init(struct perf_session *session)
+{
+	struct perf_tool *tool = session->tool;
+	struct parallel_events *pe;
+
+	/*
+	 * Events are only referenced in place while they sit in a single
+	 * mapping, and a tool that handles rounds itself expects to find
+	 * them in session->ordered_events.
+	 */
+	if (session->nr_threads < 2 || !session->one_mmap ||
+	    !tool->ordered_events ||
+	    tool->finished_round != process_finished_round)
+		return;
+
+	pe = zalloc(sizeof(*pe));
+	if (!pe)
+		return;
+
+	pe->samples = calloc(PARALLEL_EVENTS_CHUNK, sizeof(*pe->samples));
+	pe->errs = calloc(PARALLEL_EVENTS_CHUNK, sizeof(*pe->errs));
+	if (!pe->samples || !pe->errs) {
+		free(pe->samples);
+		free(pe->errs);
+		free(pe);
+		return;
+	}
+
+	session->parallel = pe;
+}
+
+static void perf_session__parallel_exit(struct perf_session *session)
+{
+	struct parallel_events *pe = session->parallel;
+
+	if (!pe)
+		return;
+
+	free(pe->queue);
+	free(pe->pending);
+	free(pe->merged);
+	free(pe->samples);
+	free(pe->errs);
+	zfree(&session->parallel);
+}
+
+static int perf_session__queue_parallel(struct perf_session *session,
+					union perf_event *event,
+					u64 timestamp, u64 file_offset)
+{
+	struct parallel_events *pe = session->parallel;
+	struct parallel_event *pevent;
+
+	if (!timestamp || timestamp == ~0ULL)
+		return -ETIME;
+
+	if (timestamp < pe->last_flush)
+		session->ordered_events.nr_unordered_events++;
+
+	if (parallel_events__grow(&pe->queue, &pe->alloc_queue,
+				  pe->nr_queue + 1))
+		return -ENOMEM;
+
+	pevent = &pe->queue[pe->nr_queue++];
+	pevent->timestamp   = timestamp;
+	pevent->file_offset = file_offset;
+	pevent->event	    = event;
+
+	if (timestamp > pe->max_timestamp)
+		pe->max_timestamp = timestamp;
+
+	return 0;
+}
+
+static void parallel_work__sort(struct parallel_work *work)
+{
+	qsort(work->events, work->nr, sizeof(*work->events),
+	      parallel_event__cmp);
+}
+
+static void parallel_work__parse(struct parallel_work *work)
+{
+	size_t i;
+
+	for (i = 0; i < work->nr; i++)
+		work->errs[i] = perf_evlist__parse_sample(work->evlist,
+							  work->events[i].event,
+							  &work->samples[i]);
+}
+
+static void *parallel_work__thread(void *arg)
+{
+	struct parallel_work *work = arg;
+
+	work->fn(work);
+	return NULL;
+}
+
+/*
+ * Cut @nr events into contiguous ranges of at least
+ * PARALLEL_EVENTS_MIN_STREAM events, one per thread, and run @fn on each.
+ * The first range is handled by the calling thread, and a range whose
+ * thread cannot be created is handled inline as well.
+ */
+static unsigned int perf_session__run_parallel(struct perf_session *session,
+					       struct parallel_work *works,
+					       struct parallel_event *events,
+					       size_t nr,
+					       void (*fn)(struct parallel_work *))
+{
+	struct parallel_events *pe = session->parallel;
+	unsigned int i, nr_works;
+	size_t start = 0;
+
+	if (!nr)
+		return 0;
+
+	nr_works = DIV_ROUND_UP(nr, PARALLEL_EVENTS_MIN_STREAM);
+	nr_works = min(nr_works, session->nr_threads);
+	nr_works = min(nr_works, (unsigned int)PARALLEL_EVENTS_MAX_THREADS);
+
+	for (i = 0; i < nr_works; i++) {
+		struct parallel_work *work = &works[i];
+		size_t end = nr * (i + 1) / nr_works;
+
+		work->started = false;
+		work->evlist  = session->evlist;
+		work->events  = events + start;
+		work->samples = pe->samples + start;
+		work->errs    = pe->errs + start;
+		work->nr      = end - start;
+		work->fn      = fn;
+		start = end;
+	}
+
+	for (i = 1; i < nr_works; i++) {
+		if (!pthread_create(&works[i].thread, NULL,
+				    parallel_work__thread, &works[i]))
+			works[i].started = true;
+		else
+			fn(&works[i]);
+	}
+
+	fn(&works[0]);
+
+	for (i = 1; i < nr_works; i++) {
+		if (works[i].started)
+			pthread_join(works[i].thread, NULL);
+	}
+
+	return nr_works;
+}
+
+static void parallel_stream__sift(struct parallel_stream *heap,
+				  unsigned int nr, unsigned int i)
+{
+	for (;;) {
+		unsigned int l = 2 * i + 1, r = l + 1, min = i;
+		struct parallel_stream tmp;
+
+		if (l < nr && parallel_event__cmp(heap[l].cur, heap[min].cur) < 0)
+			min = l;
+		if (r < nr && parallel_event__cmp(heap[r].cur, heap[min].cur) < 0)
+			min = r;
+		if (min == i)
+			return;
+
+		tmp = heap[i];
+		heap[i] = heap[min];
+		heap[min] = tmp;
+		i = min;
+	}
+}
+
+static void parallel_stream__merge(struct parallel_stream *heap,
+				   unsigned int nr,
+				   struct parallel_event *out)
+{
+	unsigned int i;
+
+	for (i = nr / 2; i-- > 0; )
+		parallel_stream__sift(heap, nr, i);
+
+	while (nr) {
+		*out++ = *heap[0].cur++;
+		if (heap[0].cur == heap[0].end)
+			heap[0] = heap[--nr];
+		parallel_stream__sift(heap, nr, 0);
+	}
+}
+
+static int perf_session__deliver_parallel(struct perf_session *session,
+					  struct parallel_event *events,
+					  size_t nr, struct ui_progress *prog)
+{
+	struct parallel_events *pe = session->parallel;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < nr; i++) {
+		if (session_done())
+			return 0;
+
+		ret = pe->errs[i];
+		if (ret) {
+			pr_err("Can't parse sample, err = %d\n", ret);
+			return ret;
+		}
+
+		ret = __perf_session__deliver_event(session, events[i].event,
+						    &pe->samples[i],
+						    session->tool,
+						    events[i].file_offset);
+		if (ret)
+			return ret;
+
+		pe->last_flush = events[i].timestamp;
+
+		if (prog)
+			ui_progress__update(prog, 1);
+	}
+
+	return 0;
+}
+
+/*
+ * Deliver, in time order, every queued event whose timestamp is not above
+ * @limit, and keep the rest sorted for the next flush.
+ */
+static int perf_session__flush_parallel(struct perf_session *session,
+					u64 limit)
+{
+	struct parallel_events *pe = session->parallel;
+	struct parallel_work works[PARALLEL_EVENTS_MAX_THREADS];
+	struct parallel_stream heap[PARALLEL_EVENTS_MAX_THREADS + 1];
+	bool show_progress = limit == ULLONG_MAX;
+	struct parallel_event *tmp;
+	size_t alloc;
+	unsigned int i, nr_works, nr_heap = 0;
+	size_t nr, ready, done;
+	struct ui_progress prog;
+	int ret = 0;
+
+	nr = pe->nr_pending + pe->nr_queue;
+	if (!nr)
+		return 0;
+
+	if (parallel_events__grow(&pe->merged, &pe->alloc_merged, nr))
+		return -ENOMEM;
+
+	nr_works = perf_session__run_parallel(session, works, pe->queue,
+					      pe->nr_queue,
+					      parallel_work__sort);
+
+	if (pe->nr_pending) {
+		heap[nr_heap].cur = pe->pending;
+		heap[nr_heap].end = pe->pending + pe->nr_pending;
+		nr_heap++;
+	}
+	for (i = 0; i < nr_works; i++) {
+		heap[nr_heap].cur = works[i].events;
+		heap[nr_heap].end = works[i].events + works[i].nr;
+		nr_heap++;
+	}
+
+	parallel_stream__merge(heap, nr_heap, pe->merged);
+	pe->nr_queue = 0;
+
+	/* first event above the limit */
+	for (ready = 0, done = nr; ready < done; ) {
+		size_t mid = ready + (done - ready) / 2;
+
+		if (pe->merged[mid].timestamp <= limit)
+			ready = mid + 1;
+		else
+			done = mid;
+	}
+
+	if (show_progress)
+		ui_progress__init(&prog, ready, "Processing time ordered events...");
+
+	for (done = 0; done < ready; done += PARALLEL_EVENTS_CHUNK) {
+		size_t chunk = min(ready - done, (size_t)PARALLEL_EVENTS_CHUNK);
+
+		perf_session__run_parallel(session, works, pe->merged + done,
+					   chunk, parallel_work__parse);
+
+		ret = perf_session__deliver_parallel(session, pe->merged + done,
+						     chunk,
+						     show_progress ? &prog : NULL);
+		if (ret || session_done())
+			break;
+	}
+
+	if (show_progress)
+		ui_progress__finish();
+
+	if (ret)
+		return ret;
+
+	/* interrupted: drop the rest, as ordered_events does */
+	if (session_done()) {
+		pe->nr_pending = 0;
+		return 0;
+	}
+
+	nr -= ready;
+	memmove(pe->merged, pe->merged + ready, nr * sizeof(*pe->merged));
+
+	tmp = pe->pending;
+	pe->pending = pe->merged;
+	pe->merged = tmp;
+	alloc = pe->alloc_pending;
+	pe->alloc_pending = pe->alloc_merged;
+	pe->alloc_merged = alloc;
+	pe->nr_pending = nr;
+
+	return 0;
+}
+
+static int perf_session__flush_parallel_round(struct perf_session *session)
+{
+	struct parallel_events *pe = session->parallel;
+	int ret;
+
+	if (!pe->nr_pending && !pe->nr_queue)
+		return 0;
+
+	ret = perf_session__flush_parallel(session, pe->next_flush);
+	if (!ret)
+		pe->next_flush = pe->max_timestamp;
+
+	return ret;
+}
+
 /*
  * When perf record finishes a pass on every buffers, it records this pseudo
  * event.
@@ -863,14 +1301,21 @@ static int process_finished_round(struct perf_tool *tool __maybe_unused,
 				  union perf_event *event __maybe_unused,
 				  struct ordered_events *oe)
 {
+	struct perf_session *session = container_of(oe, struct perf_session,
+						    ordered_events);
+
 	if (dump_trace)
 		fprintf(stdout, "\n");
+	if (session->parallel)
+		return perf_session__flush_parallel_round(session);
 	return ordered_events__flush(oe, OE_FLUSH__ROUND);
 }
 
 int perf_session__queue_event(struct perf_session *s, union perf_event *event,
 			      u64 timestamp, u64 file_offset)
 {
+	if (s->parallel)
+		return perf_session__queue_parallel(s, event, timestamp, file_offset);
 	return ordered_events__queue(&s->ordered_events, event, timestamp, file_offset);
 }
 
@@ -1325,6 +1770,24 @@ static int machines__deliver_event(struct machines *machines,
 	}
 }
 
+static int __perf_session__deliver_event(struct perf_session *session,
+					 union perf_event *event,
+					 struct perf_sample *sample,
+					 struct perf_tool *tool,
+					 u64 file_offset)
+{
+	int ret;
+
+	ret = auxtrace__process_event(session, event, sample, tool);
+	if (ret < 0)
+		return ret;
+	if (ret > 0)
+		return 0;
+
+	return machines__deliver_event(&session->machines, session->evlist,
+				       event, sample, tool, file_offset);
+}
+
 static int perf_session__deliver_event(struct perf_session *session,
 				       union perf_event *event,
 				       struct perf_tool *tool,
@@ -1339,14 +1802,8 @@ static int perf_session__deliver_event(struct perf_session *session,
 		return ret;
 	}
 
-	ret = auxtrace__process_event(session, event, &sample, tool);
-	if (ret < 0)
-		return ret;
-	if (ret > 0)
-		return 0;
-
-	return machines__deliver_event(&session->machines, session->evlist,
-				       event, &sample, tool, file_offset);
+	return __perf_session__deliver_event(session, event, &sample, tool,
+					     file_offset);
 }
 
 static s64 perf_session__process_user_event(struct perf_session *session,
@@ -1879,12 +2336,20 @@ static int __perf_session__process_events(struct perf_session *session,
 		err = -errno;
 		goto out_err;
 	}
+	/*
+	 * Events are consumed front to back: ask for aggressive readahead
+	 * and for the pages behind us to be the first to go under memory
+	 * pressure, instead of faulting a large perf.data in page by page.
+	 */
+	madvise(buf, mmap_size, MADV_SEQUENTIAL);
 	mmaps[map_idx] = buf;
 	map_idx = (map_idx + 1) & (ARRAY_SIZE(mmaps) - 1);
 	file_pos = file_offset + head;
 	if (session->one_mmap) {
 		session->one_mmap_addr = buf;
 		session->one_mmap_offset = file_offset;
+		if (!session->parallel)
+			perf_session__parallel_init(session);
 	}
 
 more:
@@ -1928,7 +2393,10 @@ static int __perf_session__process_events(struct perf_session *session,
 
 out:
 	/* do the final flush for ordered samples */
-	err = ordered_events__flush(oe, OE_FLUSH__FINAL);
+	if (session->parallel)
+		err = perf_session__flush_parallel(session, ULLONG_MAX);
+	else
+		err = ordered_events__flush(oe, OE_FLUSH__FINAL);
 	if (err)
 		goto out_err;
 	err = auxtrace__flush_events(session, tool);
@@ -1944,6 +2412,7 @@ static int __perf_session__process_events(struct perf_session *session,
 	 * reusable.
 	 */
 	ordered_events__reinit(&session->ordered_events);
+	perf_session__parallel_exit(session);
 	auxtrace__free_events(session);
 	session->one_mmap = false;
 	return err;
@@ -18,6 +18,7 @@ struct thread;
 
 struct auxtrace;
 struct itrace_synth_opts;
+struct parallel_events;
 
 struct perf_session {
 	struct perf_header	header;
@@ -33,6 +34,8 @@ struct perf_session {
 	void			*one_mmap_addr;
 	u64			one_mmap_offset;
 	struct ordered_events	ordered_events;
+	struct parallel_events	*parallel;
+	unsigned int		nr_threads;
 	struct perf_data	*data;
 	struct perf_tool	*tool;
 };